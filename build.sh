@@ -8,6 +8,7 @@ BUILD_DIR="build"
 STD="-std=c11"
 WARNINGS="-Werror -Wall -Wextra -Wconversion -Wshadow -pedantic"
 CONFIG="-g -O1 -fsanitize=undefined"
+BENCH_CONFIG="-O2 -DNDEBUG"
 
 INCLUDES="\
     -Iinclude\
@@ -32,6 +33,11 @@ gcc ${SRC_DIR}/src/harmony_test.c \
     -o ${BUILD_DIR}/harmony_test \
     ${STD} ${WARNINGS} ${CONFIG} ${INCLUDES} ${LIBS}
 
+echo harmony_bench.c
+gcc ${SRC_DIR}/src/harmony_bench.c \
+    -o ${BUILD_DIR}/harmony_bench \
+    ${STD} ${WARNINGS} ${BENCH_CONFIG} ${INCLUDES} ${LIBS}
+
 END_TIME=$(date +%s.%N)
 printf "Build complete: %.6f seconds\n" "$(echo "$END_TIME - $START_TIME" | bc)"
 
@@ -56,6 +56,28 @@ typedef double f64;
 typedef size_t usize;
 typedef intptr_t isize;
 
+#if !defined(HARMONY_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64))
+
+/**
+ * Defined when the fixed-size math is implemented with SSE intrinsics
+ *
+ * Selected at compile time, define HARMONY_NO_SIMD to use the scalar code
+ */
+#define HARMONY_SIMD_SSE
+
+#include <immintrin.h>
+
+#ifdef __AVX2__
+
+/**
+ * Defined when the fixed-size math also uses AVX2 intrinsics
+ */
+#define HARMONY_SIMD_AVX2
+
+#endif // __AVX2__
+
+#endif // !defined(HARMONY_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64))
+
 #ifdef NDEBUG
 
 /**
@@ -283,6 +305,86 @@ inline usize harmony_align(usize value, usize alignment) {
     return (value + alignment - 1) & ~(alignment - 1);
 }
 
+#ifndef HARMONY_MAX_THREADS
+
+/**
+ * The maximum number of threads harmony_parallel_for() will split work across
+ */
+#define HARMONY_MAX_THREADS 64u
+
+#endif // HARMONY_MAX_THREADS
+
+/**
+ * A function processing the range [begin, end) of a parallel loop
+ */
+typedef void (*HarmonyParallelFn)(void *data, usize begin, usize end);
+
+/**
+ * The range of a parallel loop given to a single thread
+ */
+typedef struct HarmonyParallelRange {
+    HarmonyParallelFn fn;
+    void *data;
+    usize begin;
+    usize end;
+} HarmonyParallelRange;
+
+static inline int harmony_parallel_thread(void *range) {
+    HarmonyParallelRange *r = range;
+    r->fn(r->data, r->begin, r->end);
+    return 0;
+}
+
+/**
+ * Splits a loop into even contiguous ranges run on separate threads
+ *
+ * The first range runs on the calling thread, and the call returns after all
+ * ranges have finished; if a thread cannot be created its range is run on the
+ * calling thread instead
+ *
+ * Parameters
+ * - thread_count The number of threads to use, clamped to HARMONY_MAX_THREADS
+ * - count The number of iterations in the loop
+ * - fn The function to run each range with, must not be NULL
+ * - data Data passed to each call of fn
+ */
+static inline void harmony_parallel_for(u32 thread_count, usize count, HarmonyParallelFn fn, void *data) {
+    harmony_assert(fn != NULL);
+    if (count == 0)
+        return;
+
+    thread_count = harmony_clamp(thread_count, 1u, HARMONY_MAX_THREADS);
+    if (thread_count > count)
+        thread_count = (u32)count;
+    if (thread_count == 1) {
+        fn(data, 0, count);
+        return;
+    }
+
+    HarmonyParallelRange ranges[HARMONY_MAX_THREADS];
+    thrd_t threads[HARMONY_MAX_THREADS];
+    bool started[HARMONY_MAX_THREADS];
+    for (u32 i = 0; i < thread_count; ++i) {
+        ranges[i] = (HarmonyParallelRange){
+            .fn = fn,
+            .data = data,
+            .begin = count * i / thread_count,
+            .end = count * (i + 1) / thread_count,
+        };
+    }
+
+    for (u32 i = 1; i < thread_count; ++i) {
+        started[i] = thrd_create(&threads[i], harmony_parallel_thread, &ranges[i]) == thrd_success;
+        if (!started[i])
+            harmony_parallel_thread(&ranges[i]);
+    }
+    harmony_parallel_thread(&ranges[0]);
+    for (u32 i = 1; i < thread_count; ++i) {
+        if (started[i])
+            thrd_join(threads[i], NULL);
+    }
+}
+
 /**
  * A 2D vector
  */
@@ -325,6 +427,16 @@ typedef struct Mat4 {
     Vec4 x, y, z, w;
 } Mat4;
 
+/**
+ * A 3D affine transform, stored as a 3x4 matrix
+ *
+ * x, y, and z are the columns of the linear part, and w is the translation,
+ * matching the layout of the first three rows of a Mat4
+ */
+typedef struct Affine3 {
+    Vec3 x, y, z, w;
+} Affine3;
+
 /**
  * A complex number
  */
@@ -341,6 +453,73 @@ typedef struct Quat {
     f32 r, i, j, k;
 } Quat;
 
+#ifdef HARMONY_SIMD_SSE
+
+/**
+ * Loads a 4D vector into an SSE register
+ */
+static inline __m128 harmony_m128_load(const void *vec) {
+    return _mm_loadu_ps((const f32 *)vec);
+}
+
+/**
+ * Stores an SSE register into a 4D vector
+ */
+static inline Vec4 harmony_m128_to_vec4(__m128 vec) {
+    Vec4 result;
+    _mm_storeu_ps(&result.x, vec);
+    return result;
+}
+
+/**
+ * Computes a + b * c, fused if FMA is available
+ */
+static inline __m128 harmony_m128_madd(__m128 a, __m128 b, __m128 c) {
+#ifdef __FMA__
+    return _mm_fmadd_ps(b, c, a);
+#else
+    return _mm_add_ps(a, _mm_mul_ps(b, c));
+#endif
+}
+
+/**
+ * Computes the dot product of two 4D vectors, broadcast to every lane
+ */
+static inline __m128 harmony_m128_dot4(__m128 lhs, __m128 rhs) {
+    __m128 prod = _mm_mul_ps(lhs, rhs);
+    __m128 sum = _mm_add_ps(prod, _mm_shuffle_ps(prod, prod, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_add_ps(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 0, 3, 2)));
+}
+
+/**
+ * Multiplies a 4x4 matrix, given as four columns, and a 4D vector
+ */
+static inline __m128 harmony_m128_mvmul4(__m128 c0, __m128 c1, __m128 c2, __m128 c3, __m128 vec) {
+    __m128 result = _mm_mul_ps(c0, _mm_shuffle_ps(vec, vec, _MM_SHUFFLE(0, 0, 0, 0)));
+    result = harmony_m128_madd(result, c1, _mm_shuffle_ps(vec, vec, _MM_SHUFFLE(1, 1, 1, 1)));
+    result = harmony_m128_madd(result, c2, _mm_shuffle_ps(vec, vec, _MM_SHUFFLE(2, 2, 2, 2)));
+    return harmony_m128_madd(result, c3, _mm_shuffle_ps(vec, vec, _MM_SHUFFLE(3, 3, 3, 3)));
+}
+
+/**
+ * Multiplies two quaternions stored as r, i, j, k
+ */
+static inline __m128 harmony_m128_qmul(__m128 lhs, __m128 rhs) {
+    __m128 result = _mm_mul_ps(_mm_shuffle_ps(lhs, lhs, _MM_SHUFFLE(0, 0, 0, 0)), rhs);
+    result = _mm_add_ps(result, _mm_xor_ps(_mm_setr_ps(-0.0f, 0.0f, -0.0f, 0.0f), _mm_mul_ps(
+        _mm_shuffle_ps(lhs, lhs, _MM_SHUFFLE(1, 1, 1, 1)),
+        _mm_shuffle_ps(rhs, rhs, _MM_SHUFFLE(2, 3, 0, 1)))));
+    result = _mm_add_ps(result, _mm_xor_ps(_mm_setr_ps(-0.0f, 0.0f, 0.0f, -0.0f), _mm_mul_ps(
+        _mm_shuffle_ps(lhs, lhs, _MM_SHUFFLE(2, 2, 2, 2)),
+        _mm_shuffle_ps(rhs, rhs, _MM_SHUFFLE(1, 0, 3, 2)))));
+    result = _mm_add_ps(result, _mm_xor_ps(_mm_setr_ps(-0.0f, -0.0f, 0.0f, 0.0f), _mm_mul_ps(
+        _mm_shuffle_ps(lhs, lhs, _MM_SHUFFLE(3, 3, 3, 3)),
+        _mm_shuffle_ps(rhs, rhs, _MM_SHUFFLE(0, 1, 2, 3)))));
+    return result;
+}
+
+#endif // HARMONY_SIMD_SSE
+
 /**
  * Creates a 2D vector with the given scalar
  *
@@ -571,8 +750,12 @@ inline Vec3 vadd3(Vec3 lhs, Vec3 rhs){
  * Returns
  * - The added vector
  */
-inline Vec4 vadd4(Vec4 lhs, Vec4 rhs){
+static inline Vec4 vadd4(Vec4 lhs, Vec4 rhs){
+#ifdef HARMONY_SIMD_SSE
+    return harmony_m128_to_vec4(_mm_add_ps(harmony_m128_load(&lhs), harmony_m128_load(&rhs)));
+#else // HARMONY_SIMD_SSE
     return (Vec4){lhs.x + rhs.x, lhs.y + rhs.y, lhs.z + rhs.z, lhs.w + rhs.w};
+#endif // HARMONY_SIMD_SSE
 }
 
 /**
@@ -629,8 +812,12 @@ inline Vec3 vsub3(Vec3 lhs, Vec3 rhs){
  * Returns
  * - The subtracted vector
  */
-inline Vec4 vsub4(Vec4 lhs, Vec4 rhs){
+static inline Vec4 vsub4(Vec4 lhs, Vec4 rhs){
+#ifdef HARMONY_SIMD_SSE
+    return harmony_m128_to_vec4(_mm_sub_ps(harmony_m128_load(&lhs), harmony_m128_load(&rhs)));
+#else // HARMONY_SIMD_SSE
     return (Vec4){lhs.x - rhs.x, lhs.y - rhs.y, lhs.z - rhs.z, lhs.w - rhs.w};
+#endif // HARMONY_SIMD_SSE
 }
 
 /**
@@ -687,8 +874,12 @@ inline Vec3 vmul3(Vec3 lhs, Vec3 rhs){
  * Returns
  * - The multiplied vector
  */
-inline Vec4 vmul4(Vec4 lhs, Vec4 rhs){
+static inline Vec4 vmul4(Vec4 lhs, Vec4 rhs){
+#ifdef HARMONY_SIMD_SSE
+    return harmony_m128_to_vec4(_mm_mul_ps(harmony_m128_load(&lhs), harmony_m128_load(&rhs)));
+#else // HARMONY_SIMD_SSE
     return (Vec4){lhs.x * rhs.x, lhs.y * rhs.y, lhs.z * rhs.z, lhs.w * rhs.w};
+#endif // HARMONY_SIMD_SSE
 }
 
 /**
@@ -744,8 +935,12 @@ inline Vec3 svmul3(f32 scalar, Vec3 vec) {
  * Returns
  * - The multiplied vector
  */
-inline Vec4 svmul4(f32 scalar, Vec4 vec) {
+static inline Vec4 svmul4(f32 scalar, Vec4 vec) {
+#ifdef HARMONY_SIMD_SSE
+    return harmony_m128_to_vec4(_mm_mul_ps(_mm_set1_ps(scalar), harmony_m128_load(&vec)));
+#else // HARMONY_SIMD_SSE
     return (Vec4){scalar * vec.x, scalar * vec.y, scalar * vec.z, scalar * vec.w};
+#endif // HARMONY_SIMD_SSE
 }
 
 /**
@@ -802,8 +997,12 @@ inline Vec3 vdiv3(Vec3 lhs, Vec3 rhs){
  * Returns
  * - The divided vector
  */
-inline Vec4 vdiv4(Vec4 lhs, Vec4 rhs){
+static inline Vec4 vdiv4(Vec4 lhs, Vec4 rhs){
+#ifdef HARMONY_SIMD_SSE
+    return harmony_m128_to_vec4(_mm_div_ps(harmony_m128_load(&lhs), harmony_m128_load(&rhs)));
+#else // HARMONY_SIMD_SSE
     return (Vec4){lhs.x / rhs.x, lhs.y / rhs.y, lhs.z / rhs.z, lhs.w / rhs.w};
+#endif // HARMONY_SIMD_SSE
 }
 
 /**
@@ -859,8 +1058,12 @@ inline Vec3 svdiv3(f32 scalar, Vec3 vec) {
  * Returns
  * - The divided vector
  */
-inline Vec4 svdiv4(f32 scalar, Vec4 vec) {
+static inline Vec4 svdiv4(f32 scalar, Vec4 vec) {
+#ifdef HARMONY_SIMD_SSE
+    return harmony_m128_to_vec4(_mm_div_ps(_mm_set1_ps(scalar), harmony_m128_load(&vec)));
+#else // HARMONY_SIMD_SSE
     return (Vec4){scalar / vec.x, scalar / vec.y, scalar / vec.z, scalar / vec.w};
+#endif // HARMONY_SIMD_SSE
 }
 
 /**
@@ -918,8 +1121,12 @@ inline float vdot3(Vec3 lhs, Vec3 rhs){
  * Returns
  * - The dot product
  */
-inline float vdot4(Vec4 lhs, Vec4 rhs){
+static inline float vdot4(Vec4 lhs, Vec4 rhs){
+#ifdef HARMONY_SIMD_SSE
+    return _mm_cvtss_f32(harmony_m128_dot4(harmony_m128_load(&lhs), harmony_m128_load(&rhs)));
+#else // HARMONY_SIMD_SSE
     return lhs.x * rhs.x + lhs.y * rhs.y + lhs.z * rhs.z + lhs.w * rhs.w;
+#endif // HARMONY_SIMD_SSE
 }
 
 /**
@@ -970,8 +1177,13 @@ inline float vlen3(Vec3 vec){
  * Returns
  * - The length of the vector
  */
-inline float vlen4(Vec4 vec){
+static inline float vlen4(Vec4 vec){
+#ifdef HARMONY_SIMD_SSE
+    __m128 v = harmony_m128_load(&vec);
+    return _mm_cvtss_f32(_mm_sqrt_ss(harmony_m128_dot4(v, v)));
+#else // HARMONY_SIMD_SSE
     return sqrtf(vdot4(vec, vec));
+#endif // HARMONY_SIMD_SSE
 }
 
 /**
@@ -1028,9 +1240,14 @@ inline Vec3 vnorm3(Vec3 vec){
  * Returns
  * - The normalized vector
  */
-inline Vec4 vnorm4(Vec4 vec){
+static inline Vec4 vnorm4(Vec4 vec){
+#ifdef HARMONY_SIMD_SSE
+    __m128 v = harmony_m128_load(&vec);
+    return harmony_m128_to_vec4(_mm_div_ps(v, _mm_sqrt_ps(harmony_m128_dot4(v, v))));
+#else // HARMONY_SIMD_SSE
     f32 len = vlen4(vec);
     return (Vec4){vec.x / len, vec.y / len, vec.z / len, vec.w / len};
+#endif // HARMONY_SIMD_SSE
 }
 
 /**
@@ -1199,19 +1416,124 @@ inline Mat4 msub4(Mat4 lhs, Mat4 rhs){
     return result;
 }
 
+/**
+ * The number of shared-dimension elements mmul() processes per cache block
+ */
+#define HARMONY_MMUL_BLOCK_K 128
+
+/**
+ * The number of destination rows mmul() processes per cache block
+ */
+#define HARMONY_MMUL_BLOCK_M 128
+
+/**
+ * Accumulates a block of a column-major matrix product into dst
+ *
+ * Computes dst[rows x cols] += lhs[rows x depth] * rhs[depth x cols], where
+ * each matrix is given with the distance between its columns
+ */
+static inline void harmony_mmul_block_scalar(
+    u32 rows, u32 cols, u32 depth,
+    f32 *dst, u32 dst_stride,
+    const f32 *lhs, u32 lhs_stride,
+    const f32 *rhs, u32 rhs_stride
+) {
+    for (u32 j = 0; j < cols; ++j) {
+        for (u32 i = 0; i < rows; ++i) {
+            f32 sum = 0.0f;
+            for (u32 k = 0; k < depth; ++k) {
+                sum += lhs[k * lhs_stride + i] * rhs[j * rhs_stride + k];
+            }
+            dst[j * dst_stride + i] += sum;
+        }
+    }
+}
+
+/**
+ * Accumulates an 8x4 block of a column-major matrix product in registers
+ *
+ * Computes dst[8 x 4] += lhs[8 x depth] * rhs[depth x 4]
+ */
+static inline void harmony_mmul_block_8x4(
+    u32 depth,
+    f32 *dst, u32 dst_stride,
+    const f32 *lhs, u32 lhs_stride,
+    const f32 *rhs, u32 rhs_stride
+) {
+#if defined(HARMONY_SIMD_AVX2)
+    __m256 acc[4] = {_mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps()};
+    for (u32 k = 0; k < depth; ++k) {
+        __m256 col = _mm256_loadu_ps(lhs + k * lhs_stride);
+        for (u32 j = 0; j < 4; ++j) {
+            __m256 scalar = _mm256_broadcast_ss(rhs + j * rhs_stride + k);
+#ifdef __FMA__
+            acc[j] = _mm256_fmadd_ps(col, scalar, acc[j]);
+#else // __FMA__
+            acc[j] = _mm256_add_ps(acc[j], _mm256_mul_ps(col, scalar));
+#endif // __FMA__
+        }
+    }
+    for (u32 j = 0; j < 4; ++j) {
+        f32 *out = dst + j * dst_stride;
+        _mm256_storeu_ps(out, _mm256_add_ps(_mm256_loadu_ps(out), acc[j]));
+    }
+#elif defined(HARMONY_SIMD_SSE)
+    __m128 acc[4][2];
+    for (u32 j = 0; j < 4; ++j) {
+        acc[j][0] = _mm_setzero_ps();
+        acc[j][1] = _mm_setzero_ps();
+    }
+    for (u32 k = 0; k < depth; ++k) {
+        __m128 col0 = _mm_loadu_ps(lhs + k * lhs_stride);
+        __m128 col1 = _mm_loadu_ps(lhs + k * lhs_stride + 4);
+        for (u32 j = 0; j < 4; ++j) {
+            __m128 scalar = _mm_set1_ps(rhs[j * rhs_stride + k]);
+            acc[j][0] = harmony_m128_madd(acc[j][0], col0, scalar);
+            acc[j][1] = harmony_m128_madd(acc[j][1], col1, scalar);
+        }
+    }
+    for (u32 j = 0; j < 4; ++j) {
+        f32 *out = dst + j * dst_stride;
+        _mm_storeu_ps(out, _mm_add_ps(_mm_loadu_ps(out), acc[j][0]));
+        _mm_storeu_ps(out + 4, _mm_add_ps(_mm_loadu_ps(out + 4), acc[j][1]));
+    }
+#else // HARMONY_SIMD_SSE
+    f32 acc[4][8] = {0};
+    for (u32 k = 0; k < depth; ++k) {
+        const f32 *col = lhs + k * lhs_stride;
+        for (u32 j = 0; j < 4; ++j) {
+            f32 scalar = rhs[j * rhs_stride + k];
+            for (u32 i = 0; i < 8; ++i) {
+                acc[j][i] += col[i] * scalar;
+            }
+        }
+    }
+    for (u32 j = 0; j < 4; ++j) {
+        for (u32 i = 0; i < 8; ++i) {
+            dst[j * dst_stride + i] += acc[j][i];
+        }
+    }
+#endif // HARMONY_SIMD_SSE
+}
+
 /**
  * Multiplies two arbitrary size matrices
  *
+ * Matrices are column-major, so lhs is wl columns of hl elements, rhs is wr
+ * columns of hr elements, and dst is wr columns of hl elements
+ *
+ * The product is cache blocked, and computed in 8x4 register tiles
+ *
  * Parameters
- * - dst The destination matrix
+ * - dst The destination matrix, must not overlap lhs or rhs
  * - wl The width of the left-hand side matrix
  * - hl The height of the left-hand side matrix
  * - lhs The left-hand side matrix
  * - wr The width of the right-hand side matrix
- * - hr The height of the right-hand side matrix
+ * - hr The height of the right-hand side matrix, must equal wl
  * - rhs The right-hand side matrix
  */
-inline void mmul(f32* dst, u32 wl, u32 hl, f32* lhs, u32 wr, u32 hr, f32* rhs) {
+static inline void mmul(f32* dst, u32 wl, u32 hl, f32* lhs, u32 wr, u32 hr, f32* rhs) {
     harmony_assert(wl > 0);
     harmony_assert(hl > 0);
     harmony_assert(wr > 0);
@@ -1220,17 +1542,88 @@ inline void mmul(f32* dst, u32 wl, u32 hl, f32* lhs, u32 wr, u32 hr, f32* rhs) {
     harmony_assert(dst != NULL);
     harmony_assert(lhs != NULL);
     harmony_assert(rhs != NULL);
-    (void)hr;
-    for (u32 i = 0; i < wl; ++i) {
-        for (u32 j = 0; j < wr; ++j) {
-            dst[i * wl + j] = 0.0f;
-            for (u32 k = 0; k < hl; ++k) {
-                dst[i * wl + j] += lhs[k * wl + j] * rhs[i * wr + k];
+    memset(dst, 0, (usize)wr * hl * sizeof(*dst));
+    for (u32 kb = 0; kb < wl; kb += HARMONY_MMUL_BLOCK_K) {
+        u32 depth = harmony_min(HARMONY_MMUL_BLOCK_K, wl - kb);
+        for (u32 ib = 0; ib < hl; ib += HARMONY_MMUL_BLOCK_M) {
+            u32 rows = harmony_min(HARMONY_MMUL_BLOCK_M, hl - ib);
+            u32 tiled_rows = rows - rows % 8;
+            u32 j = 0;
+            for (; j + 4 <= wr; j += 4) {
+                for (u32 i = ib; i < ib + tiled_rows; i += 8) {
+                    harmony_mmul_block_8x4(depth,
+                        dst + j * hl + i, hl,
+                        lhs + kb * hl + i, hl,
+                        rhs + j * hr + kb, hr);
+                }
+                harmony_mmul_block_scalar(rows - tiled_rows, 4, depth,
+                    dst + j * hl + ib + tiled_rows, hl,
+                    lhs + kb * hl + ib + tiled_rows, hl,
+                    rhs + j * hr + kb, hr);
             }
+            harmony_mmul_block_scalar(rows, wr - j, depth,
+                dst + j * hl + ib, hl,
+                lhs + kb * hl + ib, hl,
+                rhs + j * hr + kb, hr);
         }
     }
 }
 
+/**
+ * The number of multiply-adds above which mmul_parallel() uses threads
+ */
+#define HARMONY_MMUL_PARALLEL_THRESHOLD (128 * 128 * 128)
+
+/**
+ * The arguments to a parallel matrix multiply
+ */
+typedef struct HarmonyMmulArgs {
+    f32 *dst;
+    u32 wl;
+    u32 hl;
+    f32 *lhs;
+    u32 wr;
+    u32 hr;
+    f32 *rhs;
+} HarmonyMmulArgs;
+
+static inline void harmony_mmul_columns(void *data, usize begin, usize end) {
+    HarmonyMmulArgs *args = data;
+    usize first = begin * 4;
+    usize last = harmony_min(end * 4, args->wr);
+    mmul(args->dst + first * args->hl, args->wl, args->hl, args->lhs,
+         (u32)(last - first), args->hr, args->rhs + first * args->hr);
+}
+
+/**
+ * Multiplies two arbitrary size matrices, split across threads
+ *
+ * Each thread computes a contiguous range of the destination's columns, only
+ * if the product is larger than HARMONY_MMUL_PARALLEL_THRESHOLD, otherwise
+ * runs mmul() on the calling thread
+ *
+ * Parameters
+ * - thread_count The number of threads to use
+ * - dst The destination matrix, must not overlap lhs or rhs
+ * - wl The width of the left-hand side matrix
+ * - hl The height of the left-hand side matrix
+ * - lhs The left-hand side matrix
+ * - wr The width of the right-hand side matrix
+ * - hr The height of the right-hand side matrix, must equal wl
+ * - rhs The right-hand side matrix
+ */
+static inline void mmul_parallel(u32 thread_count, f32* dst, u32 wl, u32 hl, f32* lhs, u32 wr, u32 hr, f32* rhs) {
+    harmony_assert(hr == wl);
+    if ((u64)wl * hl * wr < HARMONY_MMUL_PARALLEL_THRESHOLD || thread_count <= 1) {
+        mmul(dst, wl, hl, lhs, wr, hr, rhs);
+        return;
+    }
+
+    // split on 4 column boundaries to keep every thread on the 8x4 tiles
+    HarmonyMmulArgs args = {dst, wl, hl, lhs, wr, hr, rhs};
+    harmony_parallel_for(thread_count, (wr + 3) / 4, harmony_mmul_columns, &args);
+}
+
 /**
  * Multiplies two 2x2 matrices
  *
@@ -1240,7 +1633,7 @@ inline void mmul(f32* dst, u32 wl, u32 hl, f32* lhs, u32 wr, u32 hr, f32* rhs) {
  * Returns
  * - The multiplied matrix
  */
-inline Mat2 mmul2(Mat2 lhs, Mat2 rhs){
+static inline Mat2 mmul2(Mat2 lhs, Mat2 rhs){
     Mat2 result;
     mmul((f32*)&result, 2, 2, (f32*)&lhs, 2, 2, (f32*)&rhs);
     return result;
@@ -1255,7 +1648,7 @@ inline Mat2 mmul2(Mat2 lhs, Mat2 rhs){
  * Returns
  * - The multiplied matrix
  */
-inline Mat3 mmul3(Mat3 lhs, Mat3 rhs){
+static inline Mat3 mmul3(Mat3 lhs, Mat3 rhs){
     Mat3 result;
     mmul((f32*)&result, 3, 3, (f32*)&lhs, 3, 3, (f32*)&rhs);
     return result;
@@ -1270,32 +1663,80 @@ inline Mat3 mmul3(Mat3 lhs, Mat3 rhs){
  * Returns
  * - The multiplied matrix
  */
-inline Mat4 mmul4(Mat4 lhs, Mat4 rhs){
+static inline Mat4 mmul4(Mat4 lhs, Mat4 rhs){
     Mat4 result;
-    mmul((f32*)&result, 4, 4, (f32*)&lhs, 4, 4, (f32*)&rhs);
+#if defined(HARMONY_SIMD_AVX2)
+    __m256 c0 = _mm256_broadcast_ps((const __m128 *)&lhs.x);
+    __m256 c1 = _mm256_broadcast_ps((const __m128 *)&lhs.y);
+    __m256 c2 = _mm256_broadcast_ps((const __m128 *)&lhs.z);
+    __m256 c3 = _mm256_broadcast_ps((const __m128 *)&lhs.w);
+    for (u32 i = 0; i < 4; i += 2) {
+        __m256 cols = _mm256_loadu_ps((f32 *)&rhs + i * 4);
+        __m256 sum = _mm256_mul_ps(c0, _mm256_permute_ps(cols, _MM_SHUFFLE(0, 0, 0, 0)));
+#ifdef __FMA__
+        sum = _mm256_fmadd_ps(c1, _mm256_permute_ps(cols, _MM_SHUFFLE(1, 1, 1, 1)), sum);
+        sum = _mm256_fmadd_ps(c2, _mm256_permute_ps(cols, _MM_SHUFFLE(2, 2, 2, 2)), sum);
+        sum = _mm256_fmadd_ps(c3, _mm256_permute_ps(cols, _MM_SHUFFLE(3, 3, 3, 3)), sum);
+#else // __FMA__
+        sum = _mm256_add_ps(sum, _mm256_mul_ps(c1, _mm256_permute_ps(cols, _MM_SHUFFLE(1, 1, 1, 1))));
+        sum = _mm256_add_ps(sum, _mm256_mul_ps(c2, _mm256_permute_ps(cols, _MM_SHUFFLE(2, 2, 2, 2))));
+        sum = _mm256_add_ps(sum, _mm256_mul_ps(c3, _mm256_permute_ps(cols, _MM_SHUFFLE(3, 3, 3, 3))));
+#endif // __FMA__
+        _mm256_storeu_ps((f32 *)&result + i * 4, sum);
+    }
+#elif defined(HARMONY_SIMD_SSE)
+    __m128 c0 = harmony_m128_load(&lhs.x);
+    __m128 c1 = harmony_m128_load(&lhs.y);
+    __m128 c2 = harmony_m128_load(&lhs.z);
+    __m128 c3 = harmony_m128_load(&lhs.w);
+    result.x = harmony_m128_to_vec4(harmony_m128_mvmul4(c0, c1, c2, c3, harmony_m128_load(&rhs.x)));
+    result.y = harmony_m128_to_vec4(harmony_m128_mvmul4(c0, c1, c2, c3, harmony_m128_load(&rhs.y)));
+    result.z = harmony_m128_to_vec4(harmony_m128_mvmul4(c0, c1, c2, c3, harmony_m128_load(&rhs.z)));
+    result.w = harmony_m128_to_vec4(harmony_m128_mvmul4(c0, c1, c2, c3, harmony_m128_load(&rhs.w)));
+#else // HARMONY_SIMD_SSE
+    const Vec4 *rhs_cols[4] = {&rhs.x, &rhs.y, &rhs.z, &rhs.w};
+    Vec4 *dst_cols[4] = {&result.x, &result.y, &result.z, &result.w};
+    for (u32 i = 0; i < 4; ++i) {
+        Vec4 col = svmul4(rhs_cols[i]->x, lhs.x);
+        col = vadd4(col, svmul4(rhs_cols[i]->y, lhs.y));
+        col = vadd4(col, svmul4(rhs_cols[i]->z, lhs.z));
+        *dst_cols[i] = vadd4(col, svmul4(rhs_cols[i]->w, lhs.w));
+    }
+#endif // HARMONY_SIMD_SSE
     return result;
 }
 
 /**
  * Multiplies a matrix and a vector
  *
+ * The matrix is column-major, so each column is scaled by one element of the
+ * vector and accumulated into dst, which keeps memory access contiguous
+ *
  * Parameters
- * - dst The destination vector
+ * - dst The destination vector, must not overlap mat or vec
  * - width The width of the matrix
  * - height The height of the matrix
  * - mat The matrix to multiply with
  * - vec The vector to multiply with
  */
-inline void mvmul(u32 width, u32 height, f32* dst, f32* mat, f32* vec) {
+static inline void mvmul(u32 width, u32 height, f32* dst, f32* mat, f32* vec) {
     harmony_assert(width > 0);
     harmony_assert(height > 0);
     harmony_assert(dst != NULL);
     harmony_assert(mat != NULL);
     harmony_assert(vec != NULL);
-    for (u32 i = 0; i < height; ++i) {
-        dst[i] = 0.0f;
-        for (u32 j = 0; j < width; ++j) {
-            dst[i] += mat[j * width + i] * vec[j];
+    memset(dst, 0, height * sizeof(*dst));
+    for (u32 j = 0; j < width; ++j) {
+        const f32 *col = mat + (usize)j * height;
+        u32 i = 0;
+#ifdef HARMONY_SIMD_SSE
+        __m128 scalar = _mm_set1_ps(vec[j]);
+        for (; i + 4 <= height; i += 4) {
+            _mm_storeu_ps(dst + i, harmony_m128_madd(_mm_loadu_ps(dst + i), _mm_loadu_ps(col + i), scalar));
+        }
+#endif // HARMONY_SIMD_SSE
+        for (; i < height; ++i) {
+            dst[i] += col[i] * vec[j];
         }
     }
 }
@@ -1309,7 +1750,7 @@ inline void mvmul(u32 width, u32 height, f32* dst, f32* mat, f32* vec) {
  * Returns
  * - The multiplied vector
  */
-inline Vec2 mvmul2(Mat2 lhs, Vec2 rhs) {
+static inline Vec2 mvmul2(Mat2 lhs, Vec2 rhs) {
     Vec2 result;
     mvmul(2, 2, (f32*)&result, (f32*)&lhs, (f32*)&rhs);
     return result;
@@ -1324,7 +1765,7 @@ inline Vec2 mvmul2(Mat2 lhs, Vec2 rhs) {
  * Returns
  * - The multiplied vector
  */
-inline Vec3 mvmul3(Mat3 lhs, Vec3 rhs) {
+static inline Vec3 mvmul3(Mat3 lhs, Vec3 rhs) {
     Vec3 result;
     mvmul(3, 3, (f32*)&result, (f32*)&lhs, (f32*)&rhs);
     return result;
@@ -1339,10 +1780,22 @@ inline Vec3 mvmul3(Mat3 lhs, Vec3 rhs) {
  * Returns
  * - The multiplied vector
  */
-inline Vec4 mvmul4(Mat4 lhs, Vec4 rhs) {
-    Vec4 result;
-    mvmul(4, 4, (f32*)&result, (f32*)&lhs, (f32*)&rhs);
-    return result;
+static inline Vec4 mvmul4(Mat4 lhs, Vec4 rhs) {
+#ifdef HARMONY_SIMD_SSE
+    return harmony_m128_to_vec4(harmony_m128_mvmul4(
+        harmony_m128_load(&lhs.x),
+        harmony_m128_load(&lhs.y),
+        harmony_m128_load(&lhs.z),
+        harmony_m128_load(&lhs.w),
+        harmony_m128_load(&rhs)));
+#else // HARMONY_SIMD_SSE
+    return (Vec4){
+        lhs.x.x * rhs.x + lhs.y.x * rhs.y + lhs.z.x * rhs.z + lhs.w.x * rhs.w,
+        lhs.x.y * rhs.x + lhs.y.y * rhs.y + lhs.z.y * rhs.z + lhs.w.y * rhs.w,
+        lhs.x.z * rhs.x + lhs.y.z * rhs.y + lhs.z.z * rhs.z + lhs.w.z * rhs.w,
+        lhs.x.w * rhs.x + lhs.y.w * rhs.y + lhs.z.w * rhs.z + lhs.w.w * rhs.w,
+    };
+#endif // HARMONY_SIMD_SSE
 }
 
 /**
@@ -1419,13 +1872,19 @@ inline Quat qsub(Quat lhs, Quat rhs){
  * Returns
  * - The multiplied quaternion
  */
-inline Quat qmul(Quat lhs, Quat rhs){
+static inline Quat qmul(Quat lhs, Quat rhs){
+#ifdef HARMONY_SIMD_SSE
+    Quat result;
+    _mm_storeu_ps(&result.r, harmony_m128_qmul(harmony_m128_load(&lhs), harmony_m128_load(&rhs)));
+    return result;
+#else // HARMONY_SIMD_SSE
     return (Quat){
         lhs.r * rhs.r - lhs.i * rhs.i - lhs.j * rhs.j - lhs.k * rhs.k,
         lhs.r * rhs.i + lhs.i * rhs.r + lhs.j * rhs.k - lhs.k * rhs.j,
         lhs.r * rhs.j - lhs.i * rhs.k + lhs.j * rhs.r + lhs.k * rhs.i,
         lhs.r * rhs.k + lhs.i * rhs.j - lhs.j * rhs.i + lhs.k * rhs.r,
     };
+#endif // HARMONY_SIMD_SSE
 }
 
 /**
@@ -1469,9 +1928,18 @@ inline Quat axis_angle(Vec3 axis, f32 angle) {
  * Returns
  * - The rotated vector
  */
-inline Vec3 rotate_vec3(Quat lhs, Vec3 rhs) {
+static inline Vec3 rotate_vec3(Quat lhs, Vec3 rhs) {
+#ifdef HARMONY_SIMD_SSE
+    __m128 q = harmony_m128_load(&lhs);
+    __m128 conj = _mm_xor_ps(q, _mm_setr_ps(0.0f, -0.0f, -0.0f, -0.0f));
+    __m128 rotated = harmony_m128_qmul(q, harmony_m128_qmul(_mm_setr_ps(0.0f, rhs.x, rhs.y, rhs.z), conj));
+    f32 result[4];
+    _mm_storeu_ps(result, rotated);
+    return (Vec3){result[1], result[2], result[3]};
+#else // HARMONY_SIMD_SSE
     Quat q = qmul(lhs, qmul((Quat){0.0f, rhs.x, rhs.y, rhs.z}, qconj(lhs)));
     return (Vec3){q.i, q.j, q.k};
+#endif // HARMONY_SIMD_SSE
 }
 
 /**
@@ -1483,7 +1951,7 @@ inline Vec3 rotate_vec3(Quat lhs, Vec3 rhs) {
  * Returns
  * - The rotated matrix
  */
-inline Mat3 rotate_mat3(Quat lhs, Mat3 rhs) {
+static inline Mat3 rotate_mat3(Quat lhs, Mat3 rhs) {
     return (Mat3){
         rotate_vec3(lhs, rhs.x),
         rotate_vec3(lhs, rhs.y),
@@ -1491,4 +1959,872 @@ inline Mat3 rotate_mat3(Quat lhs, Mat3 rhs) {
     };
 }
 
+/**
+ * Creates a 3D affine transform with the given scalar
+ *
+ * Stores the scalar in the diagonal of the linear part, with no translation
+ *
+ * Parameters
+ * - scalar The scalar to create the transform with
+ * Returns
+ * - The created transform
+ */
+static inline Affine3 saffine3(f32 scalar) {
+    return (Affine3){
+        {scalar, 0.0f, 0.0f},
+        {0.0f, scalar, 0.0f},
+        {0.0f, 0.0f, scalar},
+        {0.0f, 0.0f, 0.0f},
+    };
+}
+
+/**
+ * Converts a 3D affine transform to a 4x4 matrix
+ *
+ * Parameters
+ * - lhs The transform to convert
+ * Returns
+ * - The converted matrix
+ */
+static inline Mat4 affine3to4(Affine3 lhs) {
+    return (Mat4){
+        {lhs.x.x, lhs.x.y, lhs.x.z, 0.0f},
+        {lhs.y.x, lhs.y.y, lhs.y.z, 0.0f},
+        {lhs.z.x, lhs.z.y, lhs.z.z, 0.0f},
+        {lhs.w.x, lhs.w.y, lhs.w.z, 1.0f},
+    };
+}
+
+/**
+ * Converts a 4x4 matrix to a 3D affine transform, dropping the last row
+ *
+ * Parameters
+ * - lhs The matrix to convert, whose last row must be 0, 0, 0, 1
+ * Returns
+ * - The converted transform
+ */
+static inline Affine3 mat4toaffine3(Mat4 lhs) {
+    return (Affine3){
+        {lhs.x.x, lhs.x.y, lhs.x.z},
+        {lhs.y.x, lhs.y.y, lhs.y.z},
+        {lhs.z.x, lhs.z.y, lhs.z.z},
+        {lhs.w.x, lhs.w.y, lhs.w.z},
+    };
+}
+
+/**
+ * Transforms a direction by a 3D affine transform, ignoring the translation
+ *
+ * Parameters
+ * - lhs The transform to apply
+ * - rhs The direction to transform
+ * Returns
+ * - The transformed direction
+ */
+static inline Vec3 atransform_dir(Affine3 lhs, Vec3 rhs) {
+    return (Vec3){
+        lhs.x.x * rhs.x + lhs.y.x * rhs.y + lhs.z.x * rhs.z,
+        lhs.x.y * rhs.x + lhs.y.y * rhs.y + lhs.z.y * rhs.z,
+        lhs.x.z * rhs.x + lhs.y.z * rhs.y + lhs.z.z * rhs.z,
+    };
+}
+
+/**
+ * Transforms a point by a 3D affine transform
+ *
+ * Parameters
+ * - lhs The transform to apply
+ * - rhs The point to transform
+ * Returns
+ * - The transformed point
+ */
+static inline Vec3 atransform_point(Affine3 lhs, Vec3 rhs) {
+    return vadd3(atransform_dir(lhs, rhs), lhs.w);
+}
+
+/**
+ * Composes two 3D affine transforms, equivalent to multiplying their matrices
+ *
+ * Parameters
+ * - lhs The transform applied second
+ * - rhs The transform applied first
+ * Returns
+ * - The composed transform
+ */
+static inline Affine3 acompose(Affine3 lhs, Affine3 rhs) {
+    return (Affine3){
+        atransform_dir(lhs, rhs.x),
+        atransform_dir(lhs, rhs.y),
+        atransform_dir(lhs, rhs.z),
+        atransform_point(lhs, rhs.w),
+    };
+}
+
+/**
+ * Inverts a rigid 3D affine transform
+ *
+ * Transposes the linear part instead of inverting it, so is only correct for
+ * transforms made of a rotation and translation
+ *
+ * Parameters
+ * - lhs The transform to invert, must not contain scale or shear
+ * Returns
+ * - The inverted transform
+ */
+static inline Affine3 ainverse_rigid(Affine3 lhs) {
+    Affine3 result = {
+        {lhs.x.x, lhs.y.x, lhs.z.x},
+        {lhs.x.y, lhs.y.y, lhs.z.y},
+        {lhs.x.z, lhs.y.z, lhs.z.z},
+        {0.0f, 0.0f, 0.0f},
+    };
+    result.w = svmul3(-1.0f, atransform_dir(result, lhs.w));
+    return result;
+}
+
+/**
+ * Inverts a 3D affine transform
+ *
+ * Parameters
+ * - lhs The transform to invert, must have a non-zero determinant
+ * Returns
+ * - The inverted transform
+ */
+static inline Affine3 ainverse(Affine3 lhs) {
+    Vec3 yz = vcross3(lhs.y, lhs.z);
+    Vec3 zx = vcross3(lhs.z, lhs.x);
+    Vec3 xy = vcross3(lhs.x, lhs.y);
+    f32 det = vdot3(lhs.x, yz);
+    harmony_assert(det != 0.0f);
+    f32 inv_det = 1.0f / det;
+
+    // the rows of the inverse are the cross products divided by the determinant
+    Affine3 result = {
+        {yz.x * inv_det, zx.x * inv_det, xy.x * inv_det},
+        {yz.y * inv_det, zx.y * inv_det, xy.y * inv_det},
+        {yz.z * inv_det, zx.z * inv_det, xy.z * inv_det},
+        {0.0f, 0.0f, 0.0f},
+    };
+    result.w = svmul3(-1.0f, atransform_dir(result, lhs.w));
+    return result;
+}
+
+/**
+ * 8 floats processed together in one SIMD register
+ */
+typedef struct F32x8 {
+    f32 v[8];
+} F32x8;
+
+/**
+ * 8 3D vectors, stored as structure of arrays
+ */
+typedef struct Vec3x8 {
+    F32x8 x, y, z;
+} Vec3x8;
+
+/**
+ * 8 4D vectors, stored as structure of arrays
+ */
+typedef struct Vec4x8 {
+    F32x8 x, y, z, w;
+} Vec4x8;
+
+/**
+ * 8 4x4 matrices, stored as structure of arrays
+ */
+typedef struct Mat4x8 {
+    Vec4x8 x, y, z, w;
+} Mat4x8;
+
+/**
+ * 8 quaternions, stored as structure of arrays
+ */
+typedef struct Quatx8 {
+    F32x8 r, i, j, k;
+} Quatx8;
+
+#if defined(HARMONY_SIMD_AVX2)
+
+#define HARMONY_F32X8_OP(lhs, rhs, avx_op, sse_op, scalar_op) \
+    F32x8 result; \
+    _mm256_storeu_ps(result.v, avx_op(_mm256_loadu_ps(lhs.v), _mm256_loadu_ps(rhs.v))); \
+    return result;
+
+#elif defined(HARMONY_SIMD_SSE)
+
+#define HARMONY_F32X8_OP(lhs, rhs, avx_op, sse_op, scalar_op) \
+    F32x8 result; \
+    _mm_storeu_ps(result.v, sse_op(_mm_loadu_ps(lhs.v), _mm_loadu_ps(rhs.v))); \
+    _mm_storeu_ps(result.v + 4, sse_op(_mm_loadu_ps(lhs.v + 4), _mm_loadu_ps(rhs.v + 4))); \
+    return result;
+
+#else // HARMONY_SIMD_SSE
+
+#define HARMONY_F32X8_OP(lhs, rhs, avx_op, sse_op, scalar_op) \
+    F32x8 result; \
+    for (u32 harmony_lane = 0; harmony_lane < 8; ++harmony_lane) \
+        result.v[harmony_lane] = lhs.v[harmony_lane] scalar_op rhs.v[harmony_lane]; \
+    return result;
+
+#endif // HARMONY_SIMD_SSE
+
+/**
+ * Creates 8 lanes with the given scalar
+ *
+ * Parameters
+ * - scalar The scalar to fill every lane with
+ * Returns
+ * - The created lanes
+ */
+static inline F32x8 sf32x8(f32 scalar) {
+    return (F32x8){{scalar, scalar, scalar, scalar, scalar, scalar, scalar, scalar}};
+}
+
+/**
+ * Adds 8 lanes pairwise
+ *
+ * Parameters
+ * - lhs The left-hand side lanes
+ * - rhs The right-hand side lanes
+ * Returns
+ * - The added lanes
+ */
+static inline F32x8 fadd8(F32x8 lhs, F32x8 rhs) {
+    HARMONY_F32X8_OP(lhs, rhs, _mm256_add_ps, _mm_add_ps, +)
+}
+
+/**
+ * Subtracts 8 lanes pairwise
+ *
+ * Parameters
+ * - lhs The left-hand side lanes
+ * - rhs The right-hand side lanes
+ * Returns
+ * - The subtracted lanes
+ */
+static inline F32x8 fsub8(F32x8 lhs, F32x8 rhs) {
+    HARMONY_F32X8_OP(lhs, rhs, _mm256_sub_ps, _mm_sub_ps, -)
+}
+
+/**
+ * Multiplies 8 lanes pairwise
+ *
+ * Parameters
+ * - lhs The left-hand side lanes
+ * - rhs The right-hand side lanes
+ * Returns
+ * - The multiplied lanes
+ */
+static inline F32x8 fmul8(F32x8 lhs, F32x8 rhs) {
+    HARMONY_F32X8_OP(lhs, rhs, _mm256_mul_ps, _mm_mul_ps, *)
+}
+
+/**
+ * Divides 8 lanes pairwise
+ *
+ * Parameters
+ * - lhs The left-hand side lanes
+ * - rhs The right-hand side lanes
+ * Returns
+ * - The divided lanes
+ */
+static inline F32x8 fdiv8(F32x8 lhs, F32x8 rhs) {
+    HARMONY_F32X8_OP(lhs, rhs, _mm256_div_ps, _mm_div_ps, /)
+}
+
+/**
+ * Computes the square root of 8 lanes
+ *
+ * Parameters
+ * - lanes The lanes to take the square root of
+ * Returns
+ * - The square roots
+ */
+static inline F32x8 fsqrt8(F32x8 lanes) {
+    F32x8 result;
+#if defined(HARMONY_SIMD_AVX2)
+    _mm256_storeu_ps(result.v, _mm256_sqrt_ps(_mm256_loadu_ps(lanes.v)));
+#elif defined(HARMONY_SIMD_SSE)
+    _mm_storeu_ps(result.v, _mm_sqrt_ps(_mm_loadu_ps(lanes.v)));
+    _mm_storeu_ps(result.v + 4, _mm_sqrt_ps(_mm_loadu_ps(lanes.v + 4)));
+#else // HARMONY_SIMD_SSE
+    for (u32 i = 0; i < 8; ++i)
+        result.v[i] = sqrtf(lanes.v[i]);
+#endif // HARMONY_SIMD_SSE
+    return result;
+}
+
+/**
+ * Computes lhs + a * b over 8 lanes, fused if FMA is available
+ *
+ * Parameters
+ * - lhs The lanes to add to
+ * - a The first lanes to multiply
+ * - b The second lanes to multiply
+ * Returns
+ * - The computed lanes
+ */
+static inline F32x8 fmadd8(F32x8 lhs, F32x8 a, F32x8 b) {
+#if defined(HARMONY_SIMD_AVX2) && defined(__FMA__)
+    F32x8 result;
+    _mm256_storeu_ps(result.v, _mm256_fmadd_ps(_mm256_loadu_ps(a.v), _mm256_loadu_ps(b.v), _mm256_loadu_ps(lhs.v)));
+    return result;
+#else // defined(HARMONY_SIMD_AVX2) && defined(__FMA__)
+    return fadd8(lhs, fmul8(a, b));
+#endif // defined(HARMONY_SIMD_AVX2) && defined(__FMA__)
+}
+
+/**
+ * Adds two sets of 8 3D vectors
+ *
+ * Parameters
+ * - lhs The left-hand side vectors
+ * - rhs The right-hand side vectors
+ * Returns
+ * - The added vectors
+ */
+static inline Vec3x8 vadd3x8(Vec3x8 lhs, Vec3x8 rhs) {
+    return (Vec3x8){fadd8(lhs.x, rhs.x), fadd8(lhs.y, rhs.y), fadd8(lhs.z, rhs.z)};
+}
+
+/**
+ * Adds two sets of 8 4D vectors
+ *
+ * Parameters
+ * - lhs The left-hand side vectors
+ * - rhs The right-hand side vectors
+ * Returns
+ * - The added vectors
+ */
+static inline Vec4x8 vadd4x8(Vec4x8 lhs, Vec4x8 rhs) {
+    return (Vec4x8){fadd8(lhs.x, rhs.x), fadd8(lhs.y, rhs.y), fadd8(lhs.z, rhs.z), fadd8(lhs.w, rhs.w)};
+}
+
+/**
+ * Subtracts two sets of 8 3D vectors
+ *
+ * Parameters
+ * - lhs The left-hand side vectors
+ * - rhs The right-hand side vectors
+ * Returns
+ * - The subtracted vectors
+ */
+static inline Vec3x8 vsub3x8(Vec3x8 lhs, Vec3x8 rhs) {
+    return (Vec3x8){fsub8(lhs.x, rhs.x), fsub8(lhs.y, rhs.y), fsub8(lhs.z, rhs.z)};
+}
+
+/**
+ * Subtracts two sets of 8 4D vectors
+ *
+ * Parameters
+ * - lhs The left-hand side vectors
+ * - rhs The right-hand side vectors
+ * Returns
+ * - The subtracted vectors
+ */
+static inline Vec4x8 vsub4x8(Vec4x8 lhs, Vec4x8 rhs) {
+    return (Vec4x8){fsub8(lhs.x, rhs.x), fsub8(lhs.y, rhs.y), fsub8(lhs.z, rhs.z), fsub8(lhs.w, rhs.w)};
+}
+
+/**
+ * Multiplies pairwise two sets of 8 3D vectors
+ *
+ * Parameters
+ * - lhs The left-hand side vectors
+ * - rhs The right-hand side vectors
+ * Returns
+ * - The multiplied vectors
+ */
+static inline Vec3x8 vmul3x8(Vec3x8 lhs, Vec3x8 rhs) {
+    return (Vec3x8){fmul8(lhs.x, rhs.x), fmul8(lhs.y, rhs.y), fmul8(lhs.z, rhs.z)};
+}
+
+/**
+ * Multiplies pairwise two sets of 8 4D vectors
+ *
+ * Parameters
+ * - lhs The left-hand side vectors
+ * - rhs The right-hand side vectors
+ * Returns
+ * - The multiplied vectors
+ */
+static inline Vec4x8 vmul4x8(Vec4x8 lhs, Vec4x8 rhs) {
+    return (Vec4x8){fmul8(lhs.x, rhs.x), fmul8(lhs.y, rhs.y), fmul8(lhs.z, rhs.z), fmul8(lhs.w, rhs.w)};
+}
+
+/**
+ * Multiplies 8 scalars and 8 3D vectors
+ *
+ * Parameters
+ * - scalar The scalars to multiply with
+ * - vec The vectors to multiply with
+ * Returns
+ * - The multiplied vectors
+ */
+static inline Vec3x8 svmul3x8(F32x8 scalar, Vec3x8 vec) {
+    return (Vec3x8){fmul8(scalar, vec.x), fmul8(scalar, vec.y), fmul8(scalar, vec.z)};
+}
+
+/**
+ * Multiplies 8 scalars and 8 4D vectors
+ *
+ * Parameters
+ * - scalar The scalars to multiply with
+ * - vec The vectors to multiply with
+ * Returns
+ * - The multiplied vectors
+ */
+static inline Vec4x8 svmul4x8(F32x8 scalar, Vec4x8 vec) {
+    return (Vec4x8){fmul8(scalar, vec.x), fmul8(scalar, vec.y), fmul8(scalar, vec.z), fmul8(scalar, vec.w)};
+}
+
+/**
+ * Computes the dot products of two sets of 8 3D vectors
+ *
+ * Parameters
+ * - lhs The left-hand side vectors
+ * - rhs The right-hand side vectors
+ * Returns
+ * - The dot products
+ */
+static inline F32x8 vdot3x8(Vec3x8 lhs, Vec3x8 rhs) {
+    return fmadd8(fmadd8(fmul8(lhs.x, rhs.x), lhs.y, rhs.y), lhs.z, rhs.z);
+}
+
+/**
+ * Computes the dot products of two sets of 8 4D vectors
+ *
+ * Parameters
+ * - lhs The left-hand side vectors
+ * - rhs The right-hand side vectors
+ * Returns
+ * - The dot products
+ */
+static inline F32x8 vdot4x8(Vec4x8 lhs, Vec4x8 rhs) {
+    return fmadd8(fmadd8(fmadd8(fmul8(lhs.x, rhs.x), lhs.y, rhs.y), lhs.z, rhs.z), lhs.w, rhs.w);
+}
+
+/**
+ * Computes the lengths of 8 3D vectors
+ *
+ * Parameters
+ * - vec The vectors to compute the lengths of
+ * Returns
+ * - The lengths of the vectors
+ */
+static inline F32x8 vlen3x8(Vec3x8 vec) {
+    return fsqrt8(vdot3x8(vec, vec));
+}
+
+/**
+ * Computes the lengths of 8 4D vectors
+ *
+ * Parameters
+ * - vec The vectors to compute the lengths of
+ * Returns
+ * - The lengths of the vectors
+ */
+static inline F32x8 vlen4x8(Vec4x8 vec) {
+    return fsqrt8(vdot4x8(vec, vec));
+}
+
+/**
+ * Normalizes 8 3D vectors
+ *
+ * Parameters
+ * - vec The vectors to normalize
+ * Returns
+ * - The normalized vectors
+ */
+static inline Vec3x8 vnorm3x8(Vec3x8 vec) {
+    F32x8 len = vlen3x8(vec);
+    return (Vec3x8){fdiv8(vec.x, len), fdiv8(vec.y, len), fdiv8(vec.z, len)};
+}
+
+/**
+ * Normalizes 8 4D vectors
+ *
+ * Parameters
+ * - vec The vectors to normalize
+ * Returns
+ * - The normalized vectors
+ */
+static inline Vec4x8 vnorm4x8(Vec4x8 vec) {
+    F32x8 len = vlen4x8(vec);
+    return (Vec4x8){fdiv8(vec.x, len), fdiv8(vec.y, len), fdiv8(vec.z, len), fdiv8(vec.w, len)};
+}
+
+/**
+ * Computes the cross products of two sets of 8 3D vectors
+ *
+ * Parameters
+ * - lhs The left-hand side vectors
+ * - rhs The right-hand side vectors
+ * Returns
+ * - The cross products
+ */
+static inline Vec3x8 vcross3x8(Vec3x8 lhs, Vec3x8 rhs) {
+    return (Vec3x8){
+        fsub8(fmul8(lhs.y, rhs.z), fmul8(lhs.z, rhs.y)),
+        fsub8(fmul8(lhs.z, rhs.x), fmul8(lhs.x, rhs.z)),
+        fsub8(fmul8(lhs.x, rhs.y), fmul8(lhs.y, rhs.x)),
+    };
+}
+
+/**
+ * Multiplies 8 4x4 matrices and 8 4D vectors
+ *
+ * Parameters
+ * - lhs The matrices to multiply with
+ * - rhs The vectors to multiply with
+ * Returns
+ * - The multiplied vectors
+ */
+static inline Vec4x8 mvmul4x8(Mat4x8 lhs, Vec4x8 rhs) {
+    return (Vec4x8){
+        fmadd8(fmadd8(fmadd8(fmul8(lhs.x.x, rhs.x), lhs.y.x, rhs.y), lhs.z.x, rhs.z), lhs.w.x, rhs.w),
+        fmadd8(fmadd8(fmadd8(fmul8(lhs.x.y, rhs.x), lhs.y.y, rhs.y), lhs.z.y, rhs.z), lhs.w.y, rhs.w),
+        fmadd8(fmadd8(fmadd8(fmul8(lhs.x.z, rhs.x), lhs.y.z, rhs.y), lhs.z.z, rhs.z), lhs.w.z, rhs.w),
+        fmadd8(fmadd8(fmadd8(fmul8(lhs.x.w, rhs.x), lhs.y.w, rhs.y), lhs.z.w, rhs.z), lhs.w.w, rhs.w),
+    };
+}
+
+/**
+ * Multiplies two sets of 8 4x4 matrices
+ *
+ * Parameters
+ * - lhs The left-hand side matrices
+ * - rhs The right-hand side matrices
+ * Returns
+ * - The multiplied matrices
+ */
+static inline Mat4x8 mmul4x8(Mat4x8 lhs, Mat4x8 rhs) {
+    return (Mat4x8){
+        mvmul4x8(lhs, rhs.x),
+        mvmul4x8(lhs, rhs.y),
+        mvmul4x8(lhs, rhs.z),
+        mvmul4x8(lhs, rhs.w),
+    };
+}
+
+/**
+ * Multiplies two sets of 8 quaternions
+ *
+ * Parameters
+ * - lhs The left-hand side quaternions
+ * - rhs The right-hand side quaternions
+ * Returns
+ * - The multiplied quaternions
+ */
+static inline Quatx8 qmulx8(Quatx8 lhs, Quatx8 rhs) {
+    return (Quatx8){
+        fsub8(fsub8(fsub8(fmul8(lhs.r, rhs.r), fmul8(lhs.i, rhs.i)), fmul8(lhs.j, rhs.j)), fmul8(lhs.k, rhs.k)),
+        fsub8(fmadd8(fmadd8(fmul8(lhs.r, rhs.i), lhs.i, rhs.r), lhs.j, rhs.k), fmul8(lhs.k, rhs.j)),
+        fmadd8(fmadd8(fsub8(fmul8(lhs.r, rhs.j), fmul8(lhs.i, rhs.k)), lhs.j, rhs.r), lhs.k, rhs.i),
+        fmadd8(fsub8(fmadd8(fmul8(lhs.r, rhs.k), lhs.i, rhs.j), fmul8(lhs.j, rhs.i)), lhs.k, rhs.r),
+    };
+}
+
+/**
+ * Computes the conjugates of 8 quaternions
+ *
+ * Parameters
+ * - quat The quaternions to compute the conjugates of
+ * Returns
+ * - The conjugates of the quaternions
+ */
+static inline Quatx8 qconjx8(Quatx8 quat) {
+    F32x8 zero = sf32x8(0.0f);
+    return (Quatx8){quat.r, fsub8(zero, quat.i), fsub8(zero, quat.j), fsub8(zero, quat.k)};
+}
+
+/**
+ * Rotates 8 3D vectors using 8 quaternions
+ *
+ * Uses the expanded form v + 2r(u x v) + 2u x (u x v), where u is the vector
+ * part of the quaternion, equal to q v q* for unit quaternions
+ *
+ * Parameters
+ * - lhs The quaternions to rotate with, must be normalized
+ * - rhs The vectors to rotate
+ * Returns
+ * - The rotated vectors
+ */
+static inline Vec3x8 rotate_vec3x8(Quatx8 lhs, Vec3x8 rhs) {
+    Vec3x8 u = {lhs.i, lhs.j, lhs.k};
+    Vec3x8 t = vcross3x8(u, rhs);
+    t = (Vec3x8){fadd8(t.x, t.x), fadd8(t.y, t.y), fadd8(t.z, t.z)};
+    return vadd3x8(vadd3x8(rhs, svmul3x8(lhs.r, t)), vcross3x8(u, t));
+}
+
+/**
+ * Loads 8 consecutive 3D vectors into structure of arrays form
+ *
+ * Parameters
+ * - src The vectors to load, must not be NULL
+ * Returns
+ * - The loaded vectors
+ */
+static inline Vec3x8 gather_vec3x8(const Vec3 *src) {
+    harmony_assert(src != NULL);
+    Vec3x8 result;
+    for (u32 i = 0; i < 8; ++i) {
+        result.x.v[i] = src[i].x;
+        result.y.v[i] = src[i].y;
+        result.z.v[i] = src[i].z;
+    }
+    return result;
+}
+
+/**
+ * Loads 8 3D vectors at the given indices into structure of arrays form
+ *
+ * Parameters
+ * - src The array of vectors to load from, must not be NULL
+ * - indices The 8 indices to load, must not be NULL
+ * Returns
+ * - The loaded vectors
+ */
+static inline Vec3x8 gather_indexed_vec3x8(const Vec3 *src, const u32 *indices) {
+    harmony_assert(src != NULL);
+    harmony_assert(indices != NULL);
+    Vec3x8 result;
+    for (u32 i = 0; i < 8; ++i) {
+        result.x.v[i] = src[indices[i]].x;
+        result.y.v[i] = src[indices[i]].y;
+        result.z.v[i] = src[indices[i]].z;
+    }
+    return result;
+}
+
+/**
+ * Stores 8 3D vectors from structure of arrays form into consecutive vectors
+ *
+ * Parameters
+ * - dst The array to store 8 vectors in, must not be NULL
+ * - vec The vectors to store
+ */
+static inline void scatter_vec3x8(Vec3 *dst, Vec3x8 vec) {
+    harmony_assert(dst != NULL);
+    for (u32 i = 0; i < 8; ++i) {
+        dst[i] = (Vec3){vec.x.v[i], vec.y.v[i], vec.z.v[i]};
+    }
+}
+
+/**
+ * Stores 8 3D vectors from structure of arrays form at the given indices
+ *
+ * Parameters
+ * - dst The array of vectors to store into, must not be NULL
+ * - indices The 8 indices to store to, must not be NULL
+ * - vec The vectors to store
+ */
+static inline void scatter_indexed_vec3x8(Vec3 *dst, const u32 *indices, Vec3x8 vec) {
+    harmony_assert(dst != NULL);
+    harmony_assert(indices != NULL);
+    for (u32 i = 0; i < 8; ++i) {
+        dst[indices[i]] = (Vec3){vec.x.v[i], vec.y.v[i], vec.z.v[i]};
+    }
+}
+
+/**
+ * Loads 8 consecutive 4D vectors into structure of arrays form
+ *
+ * Parameters
+ * - src The vectors to load, must not be NULL
+ * Returns
+ * - The loaded vectors
+ */
+static inline Vec4x8 gather_vec4x8(const Vec4 *src) {
+    harmony_assert(src != NULL);
+    Vec4x8 result;
+#ifdef HARMONY_SIMD_SSE
+    for (u32 i = 0; i < 8; i += 4) {
+        __m128 x = _mm_loadu_ps(&src[i].x);
+        __m128 y = _mm_loadu_ps(&src[i + 1].x);
+        __m128 z = _mm_loadu_ps(&src[i + 2].x);
+        __m128 w = _mm_loadu_ps(&src[i + 3].x);
+        _MM_TRANSPOSE4_PS(x, y, z, w);
+        _mm_storeu_ps(result.x.v + i, x);
+        _mm_storeu_ps(result.y.v + i, y);
+        _mm_storeu_ps(result.z.v + i, z);
+        _mm_storeu_ps(result.w.v + i, w);
+    }
+#else // HARMONY_SIMD_SSE
+    for (u32 i = 0; i < 8; ++i) {
+        result.x.v[i] = src[i].x;
+        result.y.v[i] = src[i].y;
+        result.z.v[i] = src[i].z;
+        result.w.v[i] = src[i].w;
+    }
+#endif // HARMONY_SIMD_SSE
+    return result;
+}
+
+/**
+ * Loads 8 4D vectors at the given indices into structure of arrays form
+ *
+ * Parameters
+ * - src The array of vectors to load from, must not be NULL
+ * - indices The 8 indices to load, must not be NULL
+ * Returns
+ * - The loaded vectors
+ */
+static inline Vec4x8 gather_indexed_vec4x8(const Vec4 *src, const u32 *indices) {
+    harmony_assert(src != NULL);
+    harmony_assert(indices != NULL);
+    Vec4x8 result;
+    for (u32 i = 0; i < 8; ++i) {
+        result.x.v[i] = src[indices[i]].x;
+        result.y.v[i] = src[indices[i]].y;
+        result.z.v[i] = src[indices[i]].z;
+        result.w.v[i] = src[indices[i]].w;
+    }
+    return result;
+}
+
+/**
+ * Stores 8 4D vectors from structure of arrays form into consecutive vectors
+ *
+ * Parameters
+ * - dst The array to store 8 vectors in, must not be NULL
+ * - vec The vectors to store
+ */
+static inline void scatter_vec4x8(Vec4 *dst, Vec4x8 vec) {
+    harmony_assert(dst != NULL);
+#ifdef HARMONY_SIMD_SSE
+    for (u32 i = 0; i < 8; i += 4) {
+        __m128 x = _mm_loadu_ps(vec.x.v + i);
+        __m128 y = _mm_loadu_ps(vec.y.v + i);
+        __m128 z = _mm_loadu_ps(vec.z.v + i);
+        __m128 w = _mm_loadu_ps(vec.w.v + i);
+        _MM_TRANSPOSE4_PS(x, y, z, w);
+        _mm_storeu_ps(&dst[i].x, x);
+        _mm_storeu_ps(&dst[i + 1].x, y);
+        _mm_storeu_ps(&dst[i + 2].x, z);
+        _mm_storeu_ps(&dst[i + 3].x, w);
+    }
+#else // HARMONY_SIMD_SSE
+    for (u32 i = 0; i < 8; ++i) {
+        dst[i] = (Vec4){vec.x.v[i], vec.y.v[i], vec.z.v[i], vec.w.v[i]};
+    }
+#endif // HARMONY_SIMD_SSE
+}
+
+/**
+ * Stores 8 4D vectors from structure of arrays form at the given indices
+ *
+ * Parameters
+ * - dst The array of vectors to store into, must not be NULL
+ * - indices The 8 indices to store to, must not be NULL
+ * - vec The vectors to store
+ */
+static inline void scatter_indexed_vec4x8(Vec4 *dst, const u32 *indices, Vec4x8 vec) {
+    harmony_assert(dst != NULL);
+    harmony_assert(indices != NULL);
+    for (u32 i = 0; i < 8; ++i) {
+        dst[indices[i]] = (Vec4){vec.x.v[i], vec.y.v[i], vec.z.v[i], vec.w.v[i]};
+    }
+}
+
+/**
+ * Loads 8 consecutive quaternions into structure of arrays form
+ *
+ * Parameters
+ * - src The quaternions to load, must not be NULL
+ * Returns
+ * - The loaded quaternions
+ */
+static inline Quatx8 gather_quatx8(const Quat *src) {
+    harmony_assert(src != NULL);
+    Vec4x8 vec = gather_vec4x8((const Vec4 *)src);
+    return (Quatx8){vec.x, vec.y, vec.z, vec.w};
+}
+
+/**
+ * Stores 8 quaternions from structure of arrays form into consecutive
+ * quaternions
+ *
+ * Parameters
+ * - dst The array to store 8 quaternions in, must not be NULL
+ * - quat The quaternions to store
+ */
+static inline void scatter_quatx8(Quat *dst, Quatx8 quat) {
+    harmony_assert(dst != NULL);
+    scatter_vec4x8((Vec4 *)dst, (Vec4x8){quat.r, quat.i, quat.j, quat.k});
+}
+
+/**
+ * Loads 8 consecutive 4x4 matrices into structure of arrays form
+ *
+ * Parameters
+ * - src The matrices to load, must not be NULL
+ * Returns
+ * - The loaded matrices
+ */
+static inline Mat4x8 gather_mat4x8(const Mat4 *src) {
+    harmony_assert(src != NULL);
+    Mat4x8 result;
+    Vec4x8 *dst_cols[4] = {&result.x, &result.y, &result.z, &result.w};
+    for (u32 c = 0; c < 4; ++c) {
+#ifdef HARMONY_SIMD_SSE
+        for (u32 i = 0; i < 8; i += 4) {
+            __m128 x = _mm_loadu_ps(&((const Vec4 *)&src[i])[c].x);
+            __m128 y = _mm_loadu_ps(&((const Vec4 *)&src[i + 1])[c].x);
+            __m128 z = _mm_loadu_ps(&((const Vec4 *)&src[i + 2])[c].x);
+            __m128 w = _mm_loadu_ps(&((const Vec4 *)&src[i + 3])[c].x);
+            _MM_TRANSPOSE4_PS(x, y, z, w);
+            _mm_storeu_ps(dst_cols[c]->x.v + i, x);
+            _mm_storeu_ps(dst_cols[c]->y.v + i, y);
+            _mm_storeu_ps(dst_cols[c]->z.v + i, z);
+            _mm_storeu_ps(dst_cols[c]->w.v + i, w);
+        }
+#else // HARMONY_SIMD_SSE
+        for (u32 i = 0; i < 8; ++i) {
+            Vec4 col = ((const Vec4 *)&src[i])[c];
+            dst_cols[c]->x.v[i] = col.x;
+            dst_cols[c]->y.v[i] = col.y;
+            dst_cols[c]->z.v[i] = col.z;
+            dst_cols[c]->w.v[i] = col.w;
+        }
+#endif // HARMONY_SIMD_SSE
+    }
+    return result;
+}
+
+/**
+ * Stores 8 4x4 matrices from structure of arrays form into consecutive
+ * matrices
+ *
+ * Parameters
+ * - dst The array to store 8 matrices in, must not be NULL
+ * - mat The matrices to store
+ */
+static inline void scatter_mat4x8(Mat4 *dst, Mat4x8 mat) {
+    harmony_assert(dst != NULL);
+    const Vec4x8 *src_cols[4] = {&mat.x, &mat.y, &mat.z, &mat.w};
+    for (u32 c = 0; c < 4; ++c) {
+#ifdef HARMONY_SIMD_SSE
+        for (u32 i = 0; i < 8; i += 4) {
+            __m128 x = _mm_loadu_ps(src_cols[c]->x.v + i);
+            __m128 y = _mm_loadu_ps(src_cols[c]->y.v + i);
+            __m128 z = _mm_loadu_ps(src_cols[c]->z.v + i);
+            __m128 w = _mm_loadu_ps(src_cols[c]->w.v + i);
+            _MM_TRANSPOSE4_PS(x, y, z, w);
+            _mm_storeu_ps(&((Vec4 *)&dst[i])[c].x, x);
+            _mm_storeu_ps(&((Vec4 *)&dst[i + 1])[c].x, y);
+            _mm_storeu_ps(&((Vec4 *)&dst[i + 2])[c].x, z);
+            _mm_storeu_ps(&((Vec4 *)&dst[i + 3])[c].x, w);
+        }
+#else // HARMONY_SIMD_SSE
+        for (u32 i = 0; i < 8; ++i) {
+            ((Vec4 *)&dst[i])[c] = (Vec4){
+                src_cols[c]->x.v[i], src_cols[c]->y.v[i], src_cols[c]->z.v[i], src_cols[c]->w.v[i],
+            };
+        }
+#endif // HARMONY_SIMD_SSE
+    }
+}
+
 #endif // HARMONY_H
@@ -142,6 +142,12 @@ HarmonyAllocator harmony_default_allocator(void);
  * Allocations are made very quickly, and are not freed individually, instead
  * the whole block is freed at once
  *
+ * An arena is either a fixed block, from harmony_arena_create() or set up by
+ * hand over any buffer, or a range of address space from
+ * harmony_arena_reserve(), whose pages are only committed as the head reaches
+ * them, so it can be given a generous capacity without using the memory, and
+ * its allocations never move
+ *
  * Note, is not thread safe
  */
 typedef struct HarmonyArena{
@@ -157,8 +163,29 @@ typedef struct HarmonyArena{
      * The next allocation to be given out
      */
     usize head;
+    /*
+     * The number of bytes from data which are backed by memory, only used by
+     * reserved arenas
+     */
+    usize committed;
+    /*
+     * The number of committed bytes kept when the arena is reset, with the
+     * pages above returned to the system, only used by reserved arenas
+     */
+    usize high_water_mark;
+    /*
+     * Whether the arena is from harmony_arena_reserve(), false for a fixed
+     * arena, whose memory is all usable
+     */
+    bool reserved;
 } HarmonyArena;
 
+/**
+ * The granularity reserved arenas commit and decommit memory in, a multiple
+ * of the page size, so a syscall is only made every so many allocations
+ */
+#define HARMONY_ARENA_COMMIT_SIZE ((usize)64 * 1024)
+
 /**
  * Allocates an arena with capacity
  *
@@ -172,9 +199,59 @@ inline HarmonyArena harmony_arena_create(const HarmonyAllocator *allocator, usiz
     harmony_assert(allocator != NULL);
     return (HarmonyArena){
         .data = harmony_alloc(allocator, capacity),
+        .capacity = capacity,
     };
 }
 
+/**
+ * Reserves address space for an arena, committing memory on demand
+ *
+ * The pages are mapped without access, and made readable and writable in
+ * steps of HARMONY_ARENA_COMMIT_SIZE as allocations reach them
+ *
+ * Parameters
+ * - capacity The size of the address range to reserve, which can far exceed
+ *   the memory expected to be used
+ * - high_water_mark The number of bytes to keep committed when the arena is
+ *   reset
+ * Returns
+ * - The reserved arena
+ * - An arena with NULL data if the reservation failed
+ */
+HarmonyArena harmony_arena_reserve(usize capacity, usize high_water_mark);
+
+/**
+ * Unmaps a reserved arena's address range
+ *
+ * Parameters
+ * - arena The arena from harmony_arena_reserve() to release, must not be NULL
+ */
+void harmony_arena_release(HarmonyArena *arena);
+
+/**
+ * Commits the pages of a reserved arena up to size bytes
+ *
+ * Called by allocations passing the committed memory
+ *
+ * Parameters
+ * - arena The arena from harmony_arena_reserve(), must not be NULL
+ * - size The number of bytes from the start of the arena to commit
+ * Returns
+ * - Whether the memory is committed, false if size exceeds capacity
+ */
+bool harmony_arena_commit(HarmonyArena *arena, usize size);
+
+/**
+ * Returns the committed pages of a reserved arena above its high water mark
+ * to the system
+ *
+ * Called by harmony_arena_reset()
+ *
+ * Parameters
+ * - arena The arena from harmony_arena_reserve(), must not be NULL
+ */
+void harmony_arena_decommit(HarmonyArena *arena);
+
 
 /**
  * Frees an arena's memory
@@ -191,12 +268,16 @@ inline void harmony_arena_destroy(const HarmonyAllocator *allocator, HarmonyAren
 /**
  * Frees all allocations from an arena
  *
+ * A reserved arena also decommits its memory above the high water mark
+ *
  * Parameters
  * - arena The arena to reset, must not be NULL
  */
 inline void harmony_arena_reset(HarmonyArena *arena) {
     harmony_assert(arena != NULL);
     arena->head = 0;
+    if (arena->reserved && arena->committed > arena->high_water_mark)
+        harmony_arena_decommit(arena);
 }
 
 /**
@@ -351,155 +432,1645 @@ void harmony_pool_reset(HarmonyPool *pool);
 bool harmony_pool_is_valid(HarmonyPool *pool);
 
 /**
- * A dynamic array
+ * The untyped fields every dynamic array starts with
  */
+typedef struct HarmonyArrayBase {
+    /**
+     * The items, NULL while nothing is allocated
+     */
+    void *data;
+    /**
+     * The number of items
+     */
+    u32 count;
+    /**
+     * The number of items there is room for
+     */
+    u32 capacity;
+    /**
+     * The number of items the inline buffer of a small array holds, 0 for
+     * arrays without one
+     */
+    u32 inline_capacity;
+} HarmonyArrayBase;
 
-// dynamic array api : TODO
+/**
+ * A dynamic array of T, zero initialized to be empty
+ *
+ * The items are accessed as array.data[i], and the fields of
+ * HarmonyArrayBase are shared through the base member, which the
+ * harmony_array_ macros use
+ */
+#define HarmonyArray(T) \
+    union { \
+        HarmonyArrayBase base; \
+        struct { \
+            T *data; \
+            u32 count; \
+            u32 capacity; \
+            u32 inline_capacity; \
+        }; \
+    }
 
 /**
- * A hash map
+ * The alignment of a small array's inline buffer, and the largest alignment
+ * its items may have
  */
+#define HARMONY_ARRAY_INLINE_ALIGNMENT 16
 
-// hash map api : TODO
+/**
+ * A dynamic array of T holding up to N items inline, only allocating once
+ * it grows past them
+ *
+ * Must be initialized with harmony_small_array_init(), and not moved while
+ * its items are inline, as data points into it
+ *
+ * The inline buffer is found from the array's address, assuming it starts at
+ * the first multiple of HARMONY_ARRAY_INLINE_ALIGNMENT after the
+ * HarmonyArrayBase, so T must not be aligned to more than that
+ */
+#define HarmonySmallArray(T, N) \
+    struct { \
+        HarmonyArray(T); \
+        _Alignas(HARMONY_ARRAY_INLINE_ALIGNMENT) T inline_items[N]; \
+        _Static_assert(_Alignof(T) <= HARMONY_ARRAY_INLINE_ALIGNMENT, \
+            "HarmonySmallArray items must not be aligned to more than HARMONY_ARRAY_INLINE_ALIGNMENT"); \
+    }
 
 /**
- * A hash set
+ * Initializes an empty small array, using its inline buffer
+ *
+ * Parameters
+ * - array A pointer to the HarmonySmallArray, must not be NULL
  */
+#define harmony_small_array_init(array) \
+    ((array)->base = (HarmonyArrayBase){ \
+        .data = (array)->inline_items, \
+        .count = 0, \
+        .capacity = sizeof((array)->inline_items) / sizeof((array)->inline_items[0]), \
+        .inline_capacity = sizeof((array)->inline_items) / sizeof((array)->inline_items[0]), \
+    })
 
-// hash set api : TODO
+/**
+ * Sets the capacity of an array to at least capacity items, exactly if it
+ * has to grow
+ *
+ * Parameters
+ * - allocator The allocator the array uses, must not be NULL
+ * - array The array, must not be NULL
+ * - item_size The size of each item in bytes
+ * - capacity The number of items to make room for
+ */
+void harmony_array_reserve_base(const HarmonyAllocator *allocator, HarmonyArrayBase *array, usize item_size, u32 capacity);
 
-#if defined(HARMONY_IMPLEMENTATION_CONTAINERS) || defined(HARMONY_IMPLEMENTATION_ALL)
+/**
+ * Makes room for count more items, growing the capacity geometrically so
+ * appending one at a time takes amortized constant time
+ *
+ * With an arena's allocator, the array grows in place while it is the
+ * arena's last allocation
+ *
+ * Parameters
+ * - allocator The allocator the array uses, must not be NULL
+ * - array The array, must not be NULL
+ * - item_size The size of each item in bytes
+ * - count The number of items to make room for past the array's count
+ */
+void harmony_array_grow_base(const HarmonyAllocator *allocator, HarmonyArrayBase *array, usize item_size, u32 count);
 
-void *harmony_default_alloc(void *dummy, usize size) {
-    (void)dummy;
-    void *allocation = malloc(size);
-    harmony_assert(allocation != NULL);
-    return allocation;
-}
+/**
+ * Reduces the capacity of an array to its count, moving the items back
+ * into a small array's inline buffer when they fit
+ *
+ * Parameters
+ * - allocator The allocator the array uses, must not be NULL
+ * - array The array, must not be NULL
+ * - item_size The size of each item in bytes
+ */
+void harmony_array_shrink_base(const HarmonyAllocator *allocator, HarmonyArrayBase *array, usize item_size);
 
-void *harmony_default_realloc(void *dummy, void *allocation, usize old_size, usize new_size) {
-    (void)dummy;
-    (void)old_size;
-    void *new_allocation = realloc(allocation, new_size);
-    harmony_assert(new_allocation != NULL);
-    return new_allocation;
-}
+/**
+ * Inserts items into an array, moving the items after them back
+ *
+ * Parameters
+ * - allocator The allocator the array uses, must not be NULL
+ * - array The array, must not be NULL
+ * - item_size The size of each item in bytes
+ * - index Where to insert the items, at most the array's count
+ * - items The items to copy in, must not point into the array, may be NULL
+ *   to leave the new items uninitialized
+ * - count The number of items to insert
+ */
+void harmony_array_insert_base(
+    const HarmonyAllocator *allocator,
+    HarmonyArrayBase *array,
+    usize item_size,
+    u32 index,
+    const void *items,
+    u32 count);
 
-void harmony_default_free(void *dummy, void *allocation, usize size) {
-    (void)dummy;
-    (void)size;
-    free(allocation);
-}
+/**
+ * Removes items from an array, moving the items after them forward
+ *
+ * Parameters
+ * - array The array, must not be NULL
+ * - item_size The size of each item in bytes
+ * - index The first item to remove
+ * - count The number of items to remove, must not pass the array's count
+ */
+void harmony_array_remove_base(HarmonyArrayBase *array, usize item_size, u32 index, u32 count);
 
-HarmonyAllocator harmony_default_allocator(void) {
-    return (HarmonyAllocator){
-        .data = NULL,
-        .alloc = (void *(*)(void *, usize))&harmony_default_alloc,
-        .realloc = (void *(*)(void *, void *, usize, usize))&harmony_default_realloc,
-        .free = (void (*)(void *, void *, usize))&harmony_default_free,
-    };
-}
+/**
+ * Removes an item from an array in constant time, replacing it with the
+ * last item
+ *
+ * Parameters
+ * - array The array, must not be NULL
+ * - item_size The size of each item in bytes
+ * - index The item to remove, must be less than the array's count
+ */
+void harmony_array_swap_remove_base(HarmonyArrayBase *array, usize item_size, u32 index);
 
-void *harmony_arena_alloc(HarmonyArena *arena, usize size) {
-    harmony_assert(arena != NULL);
-    if (size == 0)
-        return NULL;
+/**
+ * Frees an array's items, leaving it empty, with a small array back on its
+ * inline buffer
+ *
+ * Parameters
+ * - allocator The allocator the array uses, must not be NULL
+ * - array The array, must not be NULL
+ * - item_size The size of each item in bytes
+ */
+void harmony_array_destroy_base(const HarmonyAllocator *allocator, HarmonyArrayBase *array, usize item_size);
 
-    usize new_head = arena->head + harmony_align(size, 16);
-    if (new_head > arena->capacity)
-        return NULL;
+/**
+ * The size of the items of a HarmonyArray or HarmonySmallArray
+ */
+#define harmony_array_item_size(array) sizeof(*(array)->data)
 
-    void *allocation = (u8 *)arena->data + arena->head;
-    arena->head = new_head;
-    return allocation;
-}
+/**
+ * Sets the capacity of an array to at least item_capacity items
+ */
+#define harmony_array_reserve(allocator, array, item_capacity) \
+    harmony_array_reserve_base(allocator, &(array)->base, harmony_array_item_size(array), item_capacity)
 
-void *harmony_arena_realloc(HarmonyArena *arena, void *allocation, usize old_size, usize new_size) {
-    harmony_assert(arena != NULL);
-    if (new_size == 0) {
-        arena->head = (usize)allocation - (usize)arena->data;
-        return NULL;
-    }
+/**
+ * Reduces the capacity of an array to its count
+ */
+#define harmony_array_shrink(allocator, array) \
+    harmony_array_shrink_base(allocator, &(array)->base, harmony_array_item_size(array))
 
-    if ((usize)allocation + harmony_align(old_size, 16) == arena->head) {
-        usize new_head = (usize)allocation
-                       - (usize)arena->data
-                       + harmony_align(new_size, 16);
-        if (new_head > arena->capacity)
-            return NULL;
-        arena->head = new_head;
-        return allocation;
-    }
+/**
+ * Appends one item to an array, evaluating value after making room
+ *
+ * Only calls into harmony_array_grow_base() when the array is full
+ */
+#define harmony_array_push(allocator, array, value) \
+    ((array)->count == (array)->capacity \
+        ? harmony_array_grow_base(allocator, &(array)->base, harmony_array_item_size(array), 1) \
+        : (void)0, \
+     (void)((array)->data[(array)->count++] = (value)))
 
-    void *new_allocation = harmony_arena_alloc(arena, new_size);
-    memcpy(new_allocation, allocation, old_size);
-    return new_allocation;
-}
+/**
+ * Removes and gives the last item of an array, which must not be empty
+ */
+#define harmony_array_pop(array) ((array)->data[--(array)->count])
 
-void harmony_arena_free(HarmonyArena *arena, void *allocation, usize size) {
-    harmony_assert(arena != NULL);
-    if ((usize)allocation + harmony_align(size, 16) == arena->head)
-        arena->head = (usize)allocation - (usize)arena->data;
-}
+/**
+ * Appends item_count items to an array
+ */
+#define harmony_array_append(allocator, array, items, item_count) \
+    harmony_array_insert_base(allocator, &(array)->base, harmony_array_item_size(array), (array)->count, items, item_count)
 
-HarmonyPool harmony_pool_create(const HarmonyAllocator *allocator, usize item_width, usize item_count) {
-    harmony_assert(allocator != NULL);
-    item_width = harmony_max(item_width, 8);
-    HarmonyPool pool = {
-        .data = harmony_alloc(allocator, item_width * item_count),
-        .capacity = item_width * item_count,
-        .item_width = item_width,
-        .next_offset = 0,
-    };
-    harmony_pool_reset(&pool);
-    return pool;
-}
+/**
+ * Inserts item_count items into an array before index
+ */
+#define harmony_array_insert(allocator, array, index, items, item_count) \
+    harmony_array_insert_base(allocator, &(array)->base, harmony_array_item_size(array), index, items, item_count)
 
-void harmony_pool_destroy(const HarmonyAllocator *allocator, HarmonyPool *pool) {
-    harmony_assert(allocator != NULL);
-    harmony_free(allocator, pool->data, pool->capacity);
-}
+/**
+ * Removes item_count items from an array starting at index, keeping the order
+ */
+#define harmony_array_remove(array, index, item_count) \
+    harmony_array_remove_base(&(array)->base, harmony_array_item_size(array), index, item_count)
 
-void *harmony_pool_alloc(HarmonyPool *pool) {
-    harmony_assert(pool != NULL);
-    if (pool->next_offset > pool->capacity - pool->item_width)
-        return NULL;
+/**
+ * Removes the item at index from an array, replacing it with the last item
+ */
+#define harmony_array_swap_remove(array, index) \
+    harmony_array_swap_remove_base(&(array)->base, harmony_array_item_size(array), index)
 
-    void *allocation = (u8 *)pool->data + pool->next_offset;
-    pool->next_offset = *(u64 *)allocation;
+/**
+ * Removes every item from an array, keeping its capacity
+ */
+#define harmony_array_clear(array) ((void)((array)->count = 0))
 
-    return allocation;
-}
+/**
+ * Frees an array's items, leaving it empty
+ */
+#define harmony_array_destroy(allocator, array) \
+    harmony_array_destroy_base(allocator, &(array)->base, harmony_array_item_size(array))
 
-void harmony_pool_free(HarmonyPool *pool, void *allocation) {
-    harmony_assert(pool != NULL);
-    harmony_assert((usize)allocation - (usize)pool->data < pool->capacity);
-    *(u64 *)allocation = (u64)pool->next_offset;
-    pool->next_offset = (usize)allocation - (usize)pool->data;
-}
+/**
+ * Hashes a key for a HarmonyHashMap or HarmonyHashSet
+ *
+ * Every bit of the result should depend on the key, as the low 7 bits are
+ * stored to filter slots and the rest pick where to probe
+ */
+typedef u64 (*HarmonyHashFunction)(const void *key, usize size);
 
-void harmony_pool_reset(HarmonyPool *pool) {
-    harmony_assert(pool != NULL);
-    pool->next_offset = 0;
-    for (usize i = 0; i < pool->capacity; i += pool->item_width) {
-        *(u64 *)((u8 *)pool->data + i * pool->capacity) = (u64)i + 1;
-    }
-}
+/**
+ * Compares two keys for a HarmonyHashMap or HarmonyHashSet
+ */
+typedef bool (*HarmonyEqualFunction)(const void *lhs, const void *rhs, usize size);
 
-bool harmony_pool_is_valid(HarmonyPool *pool) {
-    harmony_assert(pool != NULL);
-    usize slot_count = (usize)floor((f64)pool->capacity / (f64)pool->item_width);
+/**
+ * The default hash of a key's bytes
+ *
+ * Parameters
+ * - key The key, must not be NULL
+ * - size The size of the key in bytes
+ * Returns
+ * - The hash
+ */
+u64 harmony_hash_bytes(const void *key, usize size);
 
-    for (usize i = 0; i < slot_count; ++i) {
-        if (pool->next_offset > pool->capacity - pool->item_width)
-            return false;
-        pool->next_offset = *((u64 *)pool->data + pool->next_offset);
-    }
+/**
+ * The number of slots whose control bytes are probed at once
+ */
+#define HARMONY_HASH_GROUP_WIDTH 16
 
-    if (pool->next_offset > pool->capacity - pool->item_width)
-        return true;
+/**
+ * The control byte of a slot that has never been used
+ */
+#define HARMONY_HASH_EMPTY 0x80
 
-    return false;
+/**
+ * The control byte of a slot whose key was removed, but which a probe may
+ * still have to pass over
+ */
+#define HARMONY_HASH_DELETED 0xfe
+
+/**
+ * An open addressing hash map in the style of a Swiss table
+ *
+ * Each slot has a control byte, either empty, deleted, or the low 7 bits of
+ * its key's hash, and lookups compare a group of 16 control bytes at once
+ * with SSE2, only comparing keys whose 7 bits match. Keys and values are
+ * copied into flat arrays, with the slot indexing both
+ *
+ * Removing a key only leaves a deleted marker when its group has always
+ * been full, as no probe can otherwise have passed over the group
+ *
+ * Note, pointers to keys and values are invalidated when the map grows
+ */
+typedef struct HarmonyHashMap {
+    /**
+     * The control byte of each slot
+     */
+    u8 *control;
+    /**
+     * The keys, key_size bytes apart
+     */
+    void *keys;
+    /**
+     * The values, value_size bytes apart
+     */
+    void *values;
+    /**
+     * The hash of keys, NULL for harmony_hash_bytes()
+     */
+    HarmonyHashFunction hash;
+    /**
+     * The equality of keys, NULL for memcmp()
+     */
+    HarmonyEqualFunction equal;
+    /**
+     * The size of each key in bytes
+     */
+    u32 key_size;
+    /**
+     * The size of each value in bytes, may be 0
+     */
+    u32 value_size;
+    /**
+     * The number of keys
+     */
+    u32 count;
+    /**
+     * The number of slots, a power of two multiple of the group width, or 0
+     * before anything is inserted
+     */
+    u32 capacity;
+    /**
+     * The number of keys that can be inserted before the map must grow or
+     * drop its deleted markers, keeping the load below 7/8
+     */
+    u32 growth_left;
+} HarmonyHashMap;
+
+/**
+ * Creates a hash map
+ *
+ * Parameters
+ * - allocator The allocator to use, must not be NULL
+ * - key_size The size of each key in bytes, must be greater than 0
+ * - value_size The size of each value in bytes
+ * - count The number of keys to make room for, may be 0
+ * - hash The hash of keys, NULL to hash their bytes
+ * - equal The equality of keys, NULL to compare their bytes
+ * Returns
+ * - The created map
+ */
+HarmonyHashMap harmony_hash_map_create(
+    const HarmonyAllocator *allocator,
+    u32 key_size,
+    u32 value_size,
+    u32 count,
+    HarmonyHashFunction hash,
+    HarmonyEqualFunction equal);
+
+/**
+ * Frees a hash map's memory
+ *
+ * Parameters
+ * - allocator The allocator the map was created with, must not be NULL
+ * - map The map to destroy, must not be NULL
+ */
+void harmony_hash_map_destroy(const HarmonyAllocator *allocator, HarmonyHashMap *map);
+
+/**
+ * Removes every key from a hash map, keeping its capacity
+ *
+ * Parameters
+ * - map The map to clear, must not be NULL
+ */
+void harmony_hash_map_clear(HarmonyHashMap *map);
+
+/**
+ * Makes room for count keys without growing again
+ *
+ * Parameters
+ * - allocator The allocator the map was created with, must not be NULL
+ * - map The map, must not be NULL
+ * - count The total number of keys to make room for
+ */
+void harmony_hash_map_reserve(const HarmonyAllocator *allocator, HarmonyHashMap *map, u32 count);
+
+/**
+ * Finds the value of a key
+ *
+ * Parameters
+ * - map The map to search, must not be NULL
+ * - key The key to find, must not be NULL
+ * Returns
+ * - A pointer to the key's value
+ * - NULL if the key is not in the map
+ */
+void *harmony_hash_map_get(const HarmonyHashMap *map, const void *key);
+
+/**
+ * Finds the value of a key, inserting the key if it is not in the map
+ *
+ * Parameters
+ * - allocator The allocator the map was created with, must not be NULL
+ * - map The map, must not be NULL
+ * - key The key to find or insert, must not be NULL
+ * - inserted Set to whether the key was inserted, may be NULL
+ * Returns
+ * - A pointer to the key's value, uninitialized if the key was inserted
+ */
+void *harmony_hash_map_get_or_insert(
+    const HarmonyAllocator *allocator,
+    HarmonyHashMap *map,
+    const void *key,
+    bool *inserted);
+
+/**
+ * Sets the value of a key, inserting the key if it is not in the map
+ *
+ * Parameters
+ * - allocator The allocator the map was created with, must not be NULL
+ * - map The map, must not be NULL
+ * - key The key to set, must not be NULL
+ * - value The value to copy in, must not be NULL unless value_size is 0
+ * Returns
+ * - A pointer to the key's value
+ */
+void *harmony_hash_map_insert(const HarmonyAllocator *allocator, HarmonyHashMap *map, const void *key, const void *value);
+
+/**
+ * Removes a key from a hash map
+ *
+ * Parameters
+ * - map The map, must not be NULL
+ * - key The key to remove, must not be NULL
+ * Returns
+ * - Whether the key was in the map
+ */
+bool harmony_hash_map_remove(HarmonyHashMap *map, const void *key);
+
+/**
+ * Finds the next occupied slot of a hash map, for iterating over its keys
+ *
+ * Iterate with for (u32 i = harmony_hash_map_next(map, 0); i < map->capacity;
+ * i = harmony_hash_map_next(map, i + 1))
+ *
+ * Parameters
+ * - map The map, must not be NULL
+ * - slot The slot to start searching from
+ * Returns
+ * - The first occupied slot at or after slot
+ * - The map's capacity if there are no more
+ */
+u32 harmony_hash_map_next(const HarmonyHashMap *map, u32 slot);
+
+/**
+ * The key in an occupied slot of a hash map
+ */
+#define harmony_hash_map_key(map, slot) ((void *)((u8 *)(map)->keys + (usize)(slot) * (map)->key_size))
+
+/**
+ * The value in an occupied slot of a hash map
+ */
+#define harmony_hash_map_value(map, slot) ((void *)((u8 *)(map)->values + (usize)(slot) * (map)->value_size))
+
+/**
+ * The number of keys harmony_hash_set_insert_many() and
+ * harmony_hash_set_contains_many() hash and prefetch ahead of probing
+ */
+#define HARMONY_HASH_SET_BATCH 16
+
+/**
+ * An open addressing hash set with linear probing, cleared in constant time
+ *
+ * Each entry holds the set's generation when it was written, the low 32
+ * bits of its key's hash, and the key, so an entry is only occupied if its
+ * generation is the set's, and clearing just advances the generation.
+ * Removal shifts the rest of the probe run back instead of leaving markers,
+ * and the stored hashes let growth and the set operations skip rehashing
+ *
+ * Note, pointers to keys are invalidated when the set grows or a key is
+ * removed
+ */
+typedef struct HarmonyHashSet {
+    /**
+     * The entries, stride bytes apart
+     */
+    void *entries;
+    /**
+     * The hash of keys, NULL for harmony_hash_bytes()
+     */
+    HarmonyHashFunction hash;
+    /**
+     * The equality of keys, NULL for memcmp()
+     */
+    HarmonyEqualFunction equal;
+    /**
+     * The size of each key in bytes
+     */
+    u32 key_size;
+    /**
+     * The size of each entry in bytes
+     */
+    u32 stride;
+    /**
+     * The number of keys
+     */
+    u32 count;
+    /**
+     * The number of entries, a power of two, or 0 before anything is
+     * inserted
+     */
+    u32 capacity;
+    /**
+     * The generation of occupied entries, never 0
+     */
+    u32 generation;
+} HarmonyHashSet;
+
+/**
+ * Creates a hash set
+ *
+ * Parameters
+ * - allocator The allocator to use, must not be NULL
+ * - key_size The size of each key in bytes, must be greater than 0
+ * - count The number of keys to make room for, may be 0
+ * - hash The hash of keys, NULL to hash their bytes
+ * - equal The equality of keys, NULL to compare their bytes
+ * Returns
+ * - The created set
+ */
+HarmonyHashSet harmony_hash_set_create(
+    const HarmonyAllocator *allocator,
+    u32 key_size,
+    u32 count,
+    HarmonyHashFunction hash,
+    HarmonyEqualFunction equal);
+
+/**
+ * Frees a hash set's memory
+ *
+ * Parameters
+ * - allocator The allocator the set was created with, must not be NULL
+ * - set The set to destroy, must not be NULL
+ */
+void harmony_hash_set_destroy(const HarmonyAllocator *allocator, HarmonyHashSet *set);
+
+/**
+ * Removes every key from a hash set in constant time, keeping its capacity
+ *
+ * Parameters
+ * - set The set to clear, must not be NULL
+ */
+void harmony_hash_set_clear(HarmonyHashSet *set);
+
+/**
+ * Makes room for count keys without growing again
+ *
+ * Parameters
+ * - allocator The allocator the set was created with, must not be NULL
+ * - set The set, must not be NULL
+ * - count The total number of keys to make room for
+ */
+void harmony_hash_set_reserve(const HarmonyAllocator *allocator, HarmonyHashSet *set, u32 count);
+
+/**
+ * Inserts a key into a hash set
+ *
+ * Parameters
+ * - allocator The allocator the set was created with, must not be NULL
+ * - set The set, must not be NULL
+ * - key The key to insert, must not be NULL
+ * Returns
+ * - Whether the key was inserted, false if it was already in the set
+ */
+bool harmony_hash_set_insert(const HarmonyAllocator *allocator, HarmonyHashSet *set, const void *key);
+
+/**
+ * Checks whether a key is in a hash set
+ *
+ * Parameters
+ * - set The set, must not be NULL
+ * - key The key to find, must not be NULL
+ * Returns
+ * - Whether the key is in the set
+ */
+bool harmony_hash_set_contains(const HarmonyHashSet *set, const void *key);
+
+/**
+ * Removes a key from a hash set
+ *
+ * Parameters
+ * - set The set, must not be NULL
+ * - key The key to remove, must not be NULL
+ * Returns
+ * - Whether the key was in the set
+ */
+bool harmony_hash_set_remove(HarmonyHashSet *set, const void *key);
+
+/**
+ * Inserts an array of keys into a hash set
+ *
+ * The keys are hashed in batches of HARMONY_HASH_SET_BATCH, prefetching
+ * their entries before any are probed, to overlap the cache misses
+ *
+ * Parameters
+ * - allocator The allocator the set was created with, must not be NULL
+ * - set The set, must not be NULL
+ * - keys The keys to insert, key_size bytes apart
+ * - count The number of keys
+ * Returns
+ * - The number of keys inserted, not counting those already in the set
+ */
+u32 harmony_hash_set_insert_many(const HarmonyAllocator *allocator, HarmonyHashSet *set, const void *keys, u32 count);
+
+/**
+ * Checks whether each of an array of keys is in a hash set
+ *
+ * The keys are hashed in batches of HARMONY_HASH_SET_BATCH, prefetching
+ * their entries before any are probed, to overlap the cache misses
+ *
+ * Parameters
+ * - set The set, must not be NULL
+ * - keys The keys to find, key_size bytes apart
+ * - count The number of keys
+ * - results Set to whether each key is in the set, may be NULL
+ * Returns
+ * - The number of keys in the set
+ */
+u32 harmony_hash_set_contains_many(const HarmonyHashSet *set, const void *keys, u32 count, bool *results);
+
+/**
+ * Inserts every key of other into a hash set
+ *
+ * Parameters
+ * - allocator The allocator the set was created with, must not be NULL
+ * - set The set to insert into, must not be NULL
+ * - other The set to insert from, with the same key size and hash, must
+ *   not be NULL
+ */
+void harmony_hash_set_union(const HarmonyAllocator *allocator, HarmonyHashSet *set, const HarmonyHashSet *other);
+
+/**
+ * Removes every key of a hash set which is not in other
+ *
+ * Parameters
+ * - set The set to remove from, must not be NULL
+ * - other The set to keep the keys of, with the same key size and hash,
+ *   must not be NULL
+ */
+void harmony_hash_set_intersect(HarmonyHashSet *set, const HarmonyHashSet *other);
+
+/**
+ * Removes every key of other from a hash set
+ *
+ * Parameters
+ * - set The set to remove from, must not be NULL
+ * - other The set of keys to remove, with the same key size and hash, must
+ *   not be NULL
+ */
+void harmony_hash_set_subtract(HarmonyHashSet *set, const HarmonyHashSet *other);
+
+/**
+ * Finds the next occupied entry of a hash set, for iterating over its keys
+ *
+ * Iterate with for (u32 i = harmony_hash_set_next(set, 0); i < set->capacity;
+ * i = harmony_hash_set_next(set, i + 1))
+ *
+ * Parameters
+ * - set The set, must not be NULL
+ * - slot The entry to start searching from
+ * Returns
+ * - The first occupied entry at or after slot
+ * - The set's capacity if there are no more
+ */
+u32 harmony_hash_set_next(const HarmonyHashSet *set, u32 slot);
+
+/**
+ * The key in an occupied entry of a hash set
+ */
+#define harmony_hash_set_key(set, slot) ((void *)((u8 *)(set)->entries + (usize)(slot) * (set)->stride + 8))
+
+#if defined(HARMONY_IMPLEMENTATION_CONTAINERS) || defined(HARMONY_IMPLEMENTATION_ALL)
+
+extern inline void *harmony_alloc(const HarmonyAllocator *allocator, usize size);
+extern inline void *harmony_realloc(const HarmonyAllocator *allocator, void *allocation, usize old_size, usize new_size);
+extern inline void harmony_free(const HarmonyAllocator *allocator, void *allocation, usize size);
+extern inline HarmonyArena harmony_arena_create(const HarmonyAllocator *allocator, usize capacity);
+extern inline void harmony_arena_destroy(const HarmonyAllocator *allocator, HarmonyArena *arena);
+extern inline void harmony_arena_reset(HarmonyArena *arena);
+extern inline HarmonyAllocator harmony_arena_allocator(HarmonyArena *arena);
+
+void *harmony_default_alloc(void *dummy, usize size) {
+    (void)dummy;
+    void *allocation = malloc(size);
+    harmony_assert(allocation != NULL);
+    return allocation;
+}
+
+void *harmony_default_realloc(void *dummy, void *allocation, usize old_size, usize new_size) {
+    (void)dummy;
+    (void)old_size;
+    void *new_allocation = realloc(allocation, new_size);
+    harmony_assert(new_allocation != NULL);
+    return new_allocation;
+}
+
+void harmony_default_free(void *dummy, void *allocation, usize size) {
+    (void)dummy;
+    (void)size;
+    free(allocation);
+}
+
+HarmonyAllocator harmony_default_allocator(void) {
+    return (HarmonyAllocator){
+        .data = NULL,
+        .alloc = (void *(*)(void *, usize))&harmony_default_alloc,
+        .realloc = (void *(*)(void *, void *, usize, usize))&harmony_default_realloc,
+        .free = (void (*)(void *, void *, usize))&harmony_default_free,
+    };
+}
+
+void *harmony_arena_alloc(HarmonyArena *arena, usize size) {
+    harmony_assert(arena != NULL);
+    if (size == 0)
+        return NULL;
+
+    usize new_head = arena->head + harmony_align(size, 16);
+    if (new_head > arena->capacity)
+        return NULL;
+    if (arena->reserved && new_head > arena->committed && !harmony_arena_commit(arena, new_head))
+        return NULL;
+
+    void *allocation = (u8 *)arena->data + arena->head;
+    arena->head = new_head;
+    return allocation;
+}
+
+void *harmony_arena_realloc(HarmonyArena *arena, void *allocation, usize old_size, usize new_size) {
+    harmony_assert(arena != NULL);
+    if (new_size == 0) {
+        harmony_arena_free(arena, allocation, old_size);
+        return NULL;
+    }
+
+    if (allocation == NULL)
+        return harmony_arena_alloc(arena, new_size);
+
+    usize offset = (usize)allocation - (usize)arena->data;
+    if (offset + harmony_align(old_size, 16) == arena->head) {
+        usize new_head = offset + harmony_align(new_size, 16);
+        if (new_head > arena->capacity)
+            return NULL;
+        if (arena->reserved && new_head > arena->committed && !harmony_arena_commit(arena, new_head))
+            return NULL;
+        arena->head = new_head;
+        return allocation;
+    }
+
+    void *new_allocation = harmony_arena_alloc(arena, new_size);
+    if (new_allocation != NULL)
+        memcpy(new_allocation, allocation, harmony_min(old_size, new_size));
+    return new_allocation;
+}
+
+void harmony_arena_free(HarmonyArena *arena, void *allocation, usize size) {
+    harmony_assert(arena != NULL);
+    if ((usize)allocation - (usize)arena->data + harmony_align(size, 16) == arena->head)
+        arena->head = (usize)allocation - (usize)arena->data;
+}
+
+#ifdef __unix__
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+/*
+ * Maps zeroed, inaccessible pages, with MAP_ANONYMOUS where the headers expose
+ * it, which strict standard modes hide, or else a private mapping of /dev/zero
+ */
+static void *harmony_arena_map(void *address, usize size, int flags) {
+    flags |= MAP_PRIVATE;
+#ifdef MAP_NORESERVE
+    flags |= MAP_NORESERVE;
+#endif
+#if defined(MAP_ANONYMOUS)
+    return mmap(address, size, PROT_NONE, flags | MAP_ANONYMOUS, -1, 0);
+#elif defined(MAP_ANON)
+    return mmap(address, size, PROT_NONE, flags | MAP_ANON, -1, 0);
+#else
+    int zero = open("/dev/zero", O_RDWR);
+    if (zero < 0)
+        return MAP_FAILED;
+    void *data = mmap(address, size, PROT_NONE, flags, zero, 0);
+    close(zero);
+    return data;
+#endif
+}
+
+HarmonyArena harmony_arena_reserve(usize capacity, usize high_water_mark) {
+    capacity = harmony_align(capacity, HARMONY_ARENA_COMMIT_SIZE);
+    void *data = harmony_arena_map(NULL, capacity, 0);
+    if (data == MAP_FAILED) {
+        harmony_log_warning("Could not reserve %zu bytes for an arena", capacity);
+        return (HarmonyArena){0};
+    }
+    return (HarmonyArena){
+        .data = data,
+        .capacity = capacity,
+        .high_water_mark = harmony_min(harmony_align(high_water_mark, HARMONY_ARENA_COMMIT_SIZE), capacity),
+        .reserved = true,
+    };
+}
+
+void harmony_arena_release(HarmonyArena *arena) {
+    harmony_assert(arena != NULL);
+    if (arena->data != NULL)
+        munmap(arena->data, arena->capacity);
+    *arena = (HarmonyArena){0};
+}
+
+bool harmony_arena_commit(HarmonyArena *arena, usize size) {
+    harmony_assert(arena != NULL);
+    harmony_assert(arena->reserved);
+    if (size <= arena->committed)
+        return true;
+    if (size > arena->capacity)
+        return false;
+
+    usize committed = harmony_min(harmony_align(size, HARMONY_ARENA_COMMIT_SIZE), arena->capacity);
+    if (mprotect((u8 *)arena->data + arena->committed, committed - arena->committed, PROT_READ | PROT_WRITE) != 0) {
+        harmony_log_warning("Could not commit %zu bytes of an arena", committed);
+        return false;
+    }
+    arena->committed = committed;
+    return true;
+}
+
+void harmony_arena_decommit(HarmonyArena *arena) {
+    harmony_assert(arena != NULL);
+    harmony_assert(arena->reserved);
+    usize kept = harmony_max(harmony_align(arena->head, HARMONY_ARENA_COMMIT_SIZE), arena->high_water_mark);
+    if (arena->committed <= kept)
+        return;
+
+    // mapping fresh pages over the range returns the old ones to the system
+    if (harmony_arena_map((u8 *)arena->data + kept, arena->committed - kept, MAP_FIXED) == MAP_FAILED) {
+        harmony_log_warning("Could not decommit %zu bytes of an arena", arena->committed - kept);
+        return;
+    }
+    arena->committed = kept;
+}
+
+#else // __unix__
+
+#error "harmony reserved arenas only implemented for unix"
+
+#endif // __unix__
+
+HarmonyPool harmony_pool_create(const HarmonyAllocator *allocator, usize item_width, usize item_count) {
+    harmony_assert(allocator != NULL);
+    item_width = harmony_max(item_width, 8);
+    HarmonyPool pool = {
+        .data = harmony_alloc(allocator, item_width * item_count),
+        .capacity = item_width * item_count,
+        .item_width = item_width,
+        .next_offset = 0,
+    };
+    harmony_pool_reset(&pool);
+    return pool;
+}
+
+void harmony_pool_destroy(const HarmonyAllocator *allocator, HarmonyPool *pool) {
+    harmony_assert(allocator != NULL);
+    harmony_free(allocator, pool->data, pool->capacity);
+}
+
+void *harmony_pool_alloc(HarmonyPool *pool) {
+    harmony_assert(pool != NULL);
+    if (pool->next_offset > pool->capacity - pool->item_width)
+        return NULL;
+
+    void *allocation = (u8 *)pool->data + pool->next_offset;
+    pool->next_offset = *(u64 *)allocation;
+
+    return allocation;
+}
+
+void harmony_pool_free(HarmonyPool *pool, void *allocation) {
+    harmony_assert(pool != NULL);
+    harmony_assert((usize)allocation - (usize)pool->data < pool->capacity);
+    *(u64 *)allocation = (u64)pool->next_offset;
+    pool->next_offset = (usize)allocation - (usize)pool->data;
+}
+
+void harmony_pool_reset(HarmonyPool *pool) {
+    harmony_assert(pool != NULL);
+    pool->next_offset = 0;
+    for (usize i = 0; i < pool->capacity; i += pool->item_width) {
+        *(u64 *)((u8 *)pool->data + i * pool->capacity) = (u64)i + 1;
+    }
+}
+
+bool harmony_pool_is_valid(HarmonyPool *pool) {
+    harmony_assert(pool != NULL);
+    usize slot_count = (usize)floor((f64)pool->capacity / (f64)pool->item_width);
+
+    for (usize i = 0; i < slot_count; ++i) {
+        if (pool->next_offset > pool->capacity - pool->item_width)
+            return false;
+        pool->next_offset = *((u64 *)pool->data + pool->next_offset);
+    }
+
+    if (pool->next_offset > pool->capacity - pool->item_width)
+        return true;
+
+    return false;
+}
+
+static inline void *harmony_array_inline_buffer(HarmonyArrayBase *array) {
+    return (u8 *)array + (sizeof(HarmonyArrayBase) + HARMONY_ARRAY_INLINE_ALIGNMENT - 1)
+                       / HARMONY_ARRAY_INLINE_ALIGNMENT * HARMONY_ARRAY_INLINE_ALIGNMENT;
+}
+
+static inline bool harmony_array_is_inline(HarmonyArrayBase *array) {
+    return array->inline_capacity > 0 && array->data == harmony_array_inline_buffer(array);
+}
+
+/**
+ * Moves an array's items to an allocation of exactly capacity items, back
+ * into the inline buffer if they fit in it
+ */
+static void harmony_array_resize(const HarmonyAllocator *allocator, HarmonyArrayBase *array, usize item_size, u32 capacity) {
+    harmony_assert(capacity >= array->count);
+    bool was_inline = harmony_array_is_inline(array);
+    if (capacity <= array->inline_capacity) {
+        if (!was_inline) {
+            void *buffer = harmony_array_inline_buffer(array);
+            memcpy(buffer, array->data, array->count * item_size);
+            harmony_free(allocator, array->data, array->capacity * item_size);
+            array->data = buffer;
+            array->capacity = array->inline_capacity;
+        }
+        return;
+    }
+
+    void *data;
+    if (was_inline || array->data == NULL) {
+        data = harmony_alloc(allocator, capacity * item_size);
+        harmony_assert(data != NULL);
+        if (was_inline)
+            memcpy(data, array->data, array->count * item_size);
+    } else {
+        data = harmony_realloc(allocator, array->data, array->capacity * item_size, capacity * item_size);
+        harmony_assert(data != NULL);
+    }
+    array->data = data;
+    array->capacity = capacity;
+}
+
+void harmony_array_reserve_base(const HarmonyAllocator *allocator, HarmonyArrayBase *array, usize item_size, u32 capacity) {
+    harmony_assert(allocator != NULL);
+    harmony_assert(array != NULL);
+    if (capacity > array->capacity)
+        harmony_array_resize(allocator, array, item_size, capacity);
+}
+
+void harmony_array_grow_base(const HarmonyAllocator *allocator, HarmonyArrayBase *array, usize item_size, u32 count) {
+    harmony_assert(allocator != NULL);
+    harmony_assert(array != NULL);
+    harmony_assert(count <= UINT32_MAX - array->count);
+    u32 needed = array->count + count;
+    if (needed <= array->capacity)
+        return;
+    u32 capacity = array->capacity > UINT32_MAX / 2 ? UINT32_MAX : harmony_max(array->capacity * 2, 8u);
+    harmony_array_resize(allocator, array, item_size, harmony_max(capacity, needed));
+}
+
+void harmony_array_shrink_base(const HarmonyAllocator *allocator, HarmonyArrayBase *array, usize item_size) {
+    harmony_assert(allocator != NULL);
+    harmony_assert(array != NULL);
+    if (harmony_array_is_inline(array) || array->capacity == array->count)
+        return;
+    if (array->count == 0 && array->inline_capacity == 0) {
+        harmony_free(allocator, array->data, array->capacity * item_size);
+        array->data = NULL;
+        array->capacity = 0;
+        return;
+    }
+    harmony_array_resize(allocator, array, item_size, array->count);
+}
+
+void harmony_array_insert_base(
+    const HarmonyAllocator *allocator,
+    HarmonyArrayBase *array,
+    usize item_size,
+    u32 index,
+    const void *items,
+    u32 count
+) {
+    harmony_assert(array != NULL);
+    harmony_assert(index <= array->count);
+    harmony_array_grow_base(allocator, array, item_size, count);
+    u8 *data = array->data;
+    if (count == 0)
+        return;
+    memmove(data + (index + count) * item_size, data + index * item_size, (array->count - index) * item_size);
+    if (items != NULL)
+        memcpy(data + index * item_size, items, count * item_size);
+    array->count += count;
+}
+
+void harmony_array_remove_base(HarmonyArrayBase *array, usize item_size, u32 index, u32 count) {
+    harmony_assert(array != NULL);
+    harmony_assert(index <= array->count && count <= array->count - index);
+    u8 *data = array->data;
+    if (count == 0)
+        return;
+    memmove(data + index * item_size, data + (index + count) * item_size, (array->count - index - count) * item_size);
+    array->count -= count;
+}
+
+void harmony_array_swap_remove_base(HarmonyArrayBase *array, usize item_size, u32 index) {
+    harmony_assert(array != NULL);
+    harmony_assert(index < array->count);
+    u8 *data = array->data;
+    --array->count;
+    if (index != array->count)
+        memcpy(data + index * item_size, data + array->count * item_size, item_size);
+}
+
+void harmony_array_destroy_base(const HarmonyAllocator *allocator, HarmonyArrayBase *array, usize item_size) {
+    harmony_assert(allocator != NULL);
+    harmony_assert(array != NULL);
+    if (array->inline_capacity > 0) {
+        if (!harmony_array_is_inline(array))
+            harmony_free(allocator, array->data, array->capacity * item_size);
+        array->data = harmony_array_inline_buffer(array);
+        array->capacity = array->inline_capacity;
+    } else {
+        if (array->data != NULL)
+            harmony_free(allocator, array->data, array->capacity * item_size);
+        array->data = NULL;
+        array->capacity = 0;
+    }
+    array->count = 0;
+}
+
+u64 harmony_hash_bytes(const void *key, usize size) {
+    harmony_assert(key != NULL);
+    const u8 *bytes = key;
+    u64 hash = 0x9e3779b97f4a7c15ull ^ ((u64)size * 0xff51afd7ed558ccdull);
+    usize i = 0;
+    for (; i + 8 <= size; i += 8) {
+        u64 word;
+        memcpy(&word, bytes + i, 8);
+        hash = (hash ^ word) * 0xbf58476d1ce4e5b9ull;
+        hash ^= hash >> 32;
+    }
+    if (i < size) {
+        // the last 1 to 7 bytes are read with fixed size, possibly overlapping loads
+        const u8 *rest = bytes + i;
+        usize rest_size = size - i;
+        u64 word;
+        if (rest_size >= 4) {
+            u32 low, high;
+            memcpy(&low, rest, sizeof(low));
+            memcpy(&high, rest + rest_size - 4, sizeof(high));
+            word = (u64)high << 32 | low;
+        } else {
+            word = (u64)rest[0] << 16 | (u64)rest[rest_size / 2] << 8 | rest[rest_size - 1];
+        }
+        hash = (hash ^ word) * 0xbf58476d1ce4e5b9ull;
+        hash ^= hash >> 32;
+    }
+    hash ^= hash >> 30;
+    hash *= 0xbf58476d1ce4e5b9ull;
+    hash ^= hash >> 27;
+    hash *= 0x94d049bb133111ebull;
+    hash ^= hash >> 31;
+    return hash;
+}
+
+/**
+ * A bit for each slot of a group whose control byte is h2
+ */
+static inline u32 harmony_hash_group_match(const u8 *control, u8 h2) {
+#ifdef HARMONY_SIMD_SSE
+    __m128i group = _mm_loadu_si128((const __m128i *)control);
+    return (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char)h2)));
+#else
+    u32 mask = 0;
+    for (u32 i = 0; i < HARMONY_HASH_GROUP_WIDTH; ++i) {
+        mask |= (u32)(control[i] == h2) << i;
+    }
+    return mask;
+#endif
+}
+
+/**
+ * A bit for each empty slot of a group
+ */
+static inline u32 harmony_hash_group_match_empty(const u8 *control) {
+    return harmony_hash_group_match(control, HARMONY_HASH_EMPTY);
+}
+
+/**
+ * A bit for each empty or deleted slot of a group, the control bytes with
+ * their high bit set
+ */
+static inline u32 harmony_hash_group_match_free(const u8 *control) {
+#ifdef HARMONY_SIMD_SSE
+    return (u32)_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)control));
+#else
+    u32 mask = 0;
+    for (u32 i = 0; i < HARMONY_HASH_GROUP_WIDTH; ++i) {
+        mask |= (u32)(control[i] >> 7) << i;
+    }
+    return mask;
+#endif
+}
+
+static inline u64 harmony_hash_map_hash(const HarmonyHashMap *map, const void *key) {
+    return map->hash != NULL ? map->hash(key, map->key_size) : harmony_hash_bytes(key, map->key_size);
+}
+
+static inline bool harmony_hash_map_equal(const HarmonyHashMap *map, const void *lhs, const void *rhs) {
+    return map->equal != NULL ? map->equal(lhs, rhs, map->key_size) : memcmp(lhs, rhs, map->key_size) == 0;
+}
+
+static usize harmony_hash_map_values_offset(u32 capacity, u32 key_size) {
+    return capacity + ((usize)capacity * key_size + 15) / 16 * 16;
+}
+
+static usize harmony_hash_map_allocation_size(u32 capacity, u32 key_size, u32 value_size) {
+    return harmony_hash_map_values_offset(capacity, key_size) + (usize)capacity * value_size;
+}
+
+/**
+ * The smallest capacity keeping count keys under the maximum load of 7/8
+ */
+static u32 harmony_hash_map_capacity_for(u32 count) {
+    u32 capacity = HARMONY_HASH_GROUP_WIDTH;
+    while (capacity / 8 * 7 < count) {
+        harmony_assert(capacity <= UINT32_MAX / 2);
+        capacity *= 2;
+    }
+    return capacity;
+}
+
+/**
+ * Finds the slot of a key
+ *
+ * Groups are probed triangularly, visiting every group of the power of two
+ * group count, and the probe ends at the first group with an empty slot
+ */
+static inline u32 harmony_hash_map_find(const HarmonyHashMap *map, const void *key, u64 hash) {
+    u32 group_mask = map->capacity / HARMONY_HASH_GROUP_WIDTH - 1;
+    u32 group = (u32)(hash >> 7) & group_mask;
+    u8 h2 = (u8)(hash & 0x7f);
+    for (u32 step = 1;; ++step) {
+        const u8 *control = map->control + group * HARMONY_HASH_GROUP_WIDTH;
+        for (u32 matches = harmony_hash_group_match(control, h2); matches != 0; matches &= matches - 1) {
+            u32 slot = group * HARMONY_HASH_GROUP_WIDTH + (u32)__builtin_ctz(matches);
+            if (harmony_hash_map_equal(map, harmony_hash_map_key(map, slot), key))
+                return slot;
+        }
+        if (harmony_hash_group_match_empty(control) != 0)
+            return UINT32_MAX;
+        group = (group + step) & group_mask;
+    }
+}
+
+/**
+ * Finds the first empty or deleted slot along a hash's probe sequence
+ */
+static u32 harmony_hash_map_find_free(const HarmonyHashMap *map, u64 hash) {
+    u32 group_mask = map->capacity / HARMONY_HASH_GROUP_WIDTH - 1;
+    u32 group = (u32)(hash >> 7) & group_mask;
+    for (u32 step = 1;; ++step) {
+        u32 free_slots = harmony_hash_group_match_free(map->control + group * HARMONY_HASH_GROUP_WIDTH);
+        if (free_slots != 0)
+            return group * HARMONY_HASH_GROUP_WIDTH + (u32)__builtin_ctz(free_slots);
+        group = (group + step) & group_mask;
+    }
+}
+
+/**
+ * Moves every key into a new table of capacity slots, dropping the deleted
+ * markers
+ */
+static void harmony_hash_map_rehash(const HarmonyAllocator *allocator, HarmonyHashMap *map, u32 capacity) {
+    harmony_assert(capacity >= HARMONY_HASH_GROUP_WIDTH && (capacity & (capacity - 1)) == 0);
+    harmony_assert((u64)capacity * 7 / 8 >= map->count);
+
+    u8 *allocation = harmony_alloc(allocator, harmony_hash_map_allocation_size(capacity, map->key_size, map->value_size));
+    harmony_assert(allocation != NULL);
+    HarmonyHashMap new_map = *map;
+    new_map.control = allocation;
+    new_map.keys = allocation + capacity;
+    new_map.values = allocation + harmony_hash_map_values_offset(capacity, map->key_size);
+    new_map.capacity = capacity;
+    new_map.growth_left = capacity / 8 * 7 - map->count;
+    memset(new_map.control, HARMONY_HASH_EMPTY, capacity);
+
+    for (u32 slot = harmony_hash_map_next(map, 0); slot < map->capacity; slot = harmony_hash_map_next(map, slot + 1)) {
+        const void *key = harmony_hash_map_key(map, slot);
+        u64 hash = harmony_hash_map_hash(map, key);
+        u32 new_slot = harmony_hash_map_find_free(&new_map, hash);
+        new_map.control[new_slot] = (u8)(hash & 0x7f);
+        memcpy(harmony_hash_map_key(&new_map, new_slot), key, map->key_size);
+        memcpy(harmony_hash_map_value(&new_map, new_slot), harmony_hash_map_value(map, slot), map->value_size);
+    }
+
+    if (map->capacity > 0)
+        harmony_free(allocator, map->control, harmony_hash_map_allocation_size(map->capacity, map->key_size, map->value_size));
+    *map = new_map;
+}
+
+HarmonyHashMap harmony_hash_map_create(
+    const HarmonyAllocator *allocator,
+    u32 key_size,
+    u32 value_size,
+    u32 count,
+    HarmonyHashFunction hash,
+    HarmonyEqualFunction equal
+) {
+    harmony_assert(allocator != NULL);
+    harmony_assert(key_size > 0);
+    HarmonyHashMap map = {
+        .hash = hash,
+        .equal = equal,
+        .key_size = key_size,
+        .value_size = value_size,
+    };
+    if (count > 0)
+        harmony_hash_map_rehash(allocator, &map, harmony_hash_map_capacity_for(count));
+    return map;
+}
+
+void harmony_hash_map_destroy(const HarmonyAllocator *allocator, HarmonyHashMap *map) {
+    harmony_assert(allocator != NULL);
+    harmony_assert(map != NULL);
+    if (map->capacity > 0)
+        harmony_free(allocator, map->control, harmony_hash_map_allocation_size(map->capacity, map->key_size, map->value_size));
+    *map = (HarmonyHashMap){0};
+}
+
+void harmony_hash_map_clear(HarmonyHashMap *map) {
+    harmony_assert(map != NULL);
+    if (map->capacity > 0)
+        memset(map->control, HARMONY_HASH_EMPTY, map->capacity);
+    map->count = 0;
+    map->growth_left = map->capacity / 8 * 7;
+}
+
+void harmony_hash_map_reserve(const HarmonyAllocator *allocator, HarmonyHashMap *map, u32 count) {
+    harmony_assert(allocator != NULL);
+    harmony_assert(map != NULL);
+    if (count > map->count && count - map->count > map->growth_left)
+        harmony_hash_map_rehash(allocator, map, harmony_hash_map_capacity_for(count));
+}
+
+void *harmony_hash_map_get(const HarmonyHashMap *map, const void *key) {
+    harmony_assert(map != NULL);
+    harmony_assert(key != NULL);
+    if (map->count == 0)
+        return NULL;
+    u32 slot = harmony_hash_map_find(map, key, harmony_hash_map_hash(map, key));
+    return slot == UINT32_MAX ? NULL : harmony_hash_map_value(map, slot);
+}
+
+void *harmony_hash_map_get_or_insert(
+    const HarmonyAllocator *allocator,
+    HarmonyHashMap *map,
+    const void *key,
+    bool *inserted
+) {
+    harmony_assert(allocator != NULL);
+    harmony_assert(map != NULL);
+    harmony_assert(key != NULL);
+    u64 hash = harmony_hash_map_hash(map, key);
+    if (map->count > 0) {
+        u32 slot = harmony_hash_map_find(map, key, hash);
+        if (slot != UINT32_MAX) {
+            if (inserted != NULL)
+                *inserted = false;
+            return harmony_hash_map_value(map, slot);
+        }
+    }
+
+    if (map->growth_left == 0) {
+        // with over half the 7/8 load made of deleted markers, dropping them is enough
+        u32 capacity = map->count < map->capacity / 16 * 7 ? map->capacity : harmony_hash_map_capacity_for(map->count + 1);
+        harmony_hash_map_rehash(allocator, map, capacity);
+    }
+
+    u32 slot = harmony_hash_map_find_free(map, hash);
+    if (map->control[slot] == HARMONY_HASH_EMPTY)
+        --map->growth_left;
+    map->control[slot] = (u8)(hash & 0x7f);
+    memcpy(harmony_hash_map_key(map, slot), key, map->key_size);
+    ++map->count;
+    if (inserted != NULL)
+        *inserted = true;
+    return harmony_hash_map_value(map, slot);
+}
+
+void *harmony_hash_map_insert(const HarmonyAllocator *allocator, HarmonyHashMap *map, const void *key, const void *value) {
+    void *dst = harmony_hash_map_get_or_insert(allocator, map, key, NULL);
+    if (map->value_size > 0)
+        memcpy(dst, value, map->value_size);
+    return dst;
+}
+
+bool harmony_hash_map_remove(HarmonyHashMap *map, const void *key) {
+    harmony_assert(map != NULL);
+    harmony_assert(key != NULL);
+    if (map->count == 0)
+        return false;
+    u32 slot = harmony_hash_map_find(map, key, harmony_hash_map_hash(map, key));
+    if (slot == UINT32_MAX)
+        return false;
+
+    // a group with an empty slot has never been full since the last rehash,
+    // so no probe passed over it, and the slot can be emptied
+    const u8 *group = map->control + slot / HARMONY_HASH_GROUP_WIDTH * HARMONY_HASH_GROUP_WIDTH;
+    if (harmony_hash_group_match_empty(group) != 0) {
+        map->control[slot] = HARMONY_HASH_EMPTY;
+        ++map->growth_left;
+    } else {
+        map->control[slot] = HARMONY_HASH_DELETED;
+    }
+    --map->count;
+    return true;
+}
+
+u32 harmony_hash_map_next(const HarmonyHashMap *map, u32 slot) {
+    harmony_assert(map != NULL);
+    for (; slot < map->capacity; ++slot) {
+        if (map->control[slot] < HARMONY_HASH_EMPTY)
+            return slot;
+    }
+    return map->capacity;
+}
+
+/**
+ * The generation and hash at the start of a hash set entry
+ */
+static inline u32 *harmony_hash_set_header(const HarmonyHashSet *set, u32 slot) {
+    return (u32 *)((u8 *)set->entries + (usize)slot * set->stride);
+}
+
+static inline u32 harmony_hash_set_hash(const HarmonyHashSet *set, const void *key) {
+    return (u32)(set->hash != NULL ? set->hash(key, set->key_size) : harmony_hash_bytes(key, set->key_size));
+}
+
+static inline bool harmony_hash_set_equal(const HarmonyHashSet *set, const void *lhs, const void *rhs) {
+    return set->equal != NULL ? set->equal(lhs, rhs, set->key_size) : memcmp(lhs, rhs, set->key_size) == 0;
+}
+
+static inline u32 harmony_hash_set_find(const HarmonyHashSet *set, const void *key, u32 hash) {
+    u32 mask = set->capacity - 1;
+    for (u32 slot = hash & mask;; slot = (slot + 1) & mask) {
+        const u32 *header = harmony_hash_set_header(set, slot);
+        if (header[0] != set->generation)
+            return UINT32_MAX;
+        if (header[1] == hash && harmony_hash_set_equal(set, header + 2, key))
+            return slot;
+    }
+}
+
+/**
+ * Inserts a key with a known hash, the set must have room for it
+ */
+static inline bool harmony_hash_set_insert_hashed(HarmonyHashSet *set, const void *key, u32 hash) {
+    u32 mask = set->capacity - 1;
+    for (u32 slot = hash & mask;; slot = (slot + 1) & mask) {
+        u32 *header = harmony_hash_set_header(set, slot);
+        if (header[0] != set->generation) {
+            header[0] = set->generation;
+            header[1] = hash;
+            memcpy(header + 2, key, set->key_size);
+            ++set->count;
+            return true;
+        }
+        if (header[1] == hash && harmony_hash_set_equal(set, header + 2, key))
+            return false;
+    }
+}
+
+/**
+ * Removes the key in an occupied entry, moving back each following key of
+ * the probe run whose home entry is not between the gap and it
+ */
+static void harmony_hash_set_remove_slot(HarmonyHashSet *set, u32 hole) {
+    u32 mask = set->capacity - 1;
+    for (u32 slot = (hole + 1) & mask;; slot = (slot + 1) & mask) {
+        u32 *header = harmony_hash_set_header(set, slot);
+        if (header[0] != set->generation)
+            break;
+        u32 home = header[1] & mask;
+        if (((slot - home) & mask) >= ((slot - hole) & mask)) {
+            memcpy(harmony_hash_set_header(set, hole), header, set->stride);
+            hole = slot;
+        }
+    }
+    harmony_hash_set_header(set, hole)[0] = 0;
+    --set->count;
+}
+
+/**
+ * The smallest capacity keeping count keys under the maximum load of 3/4
+ */
+static u32 harmony_hash_set_capacity_for(u32 count) {
+    u32 capacity = 16;
+    while (capacity / 4 * 3 < count) {
+        harmony_assert(capacity <= UINT32_MAX / 2);
+        capacity *= 2;
+    }
+    return capacity;
+}
+
+static void harmony_hash_set_rehash(const HarmonyAllocator *allocator, HarmonyHashSet *set, u32 capacity) {
+    harmony_assert(capacity / 4 * 3 >= set->count);
+    void *entries = harmony_alloc(allocator, (usize)capacity * set->stride);
+    harmony_assert(entries != NULL);
+    memset(entries, 0, (usize)capacity * set->stride);
+
+    HarmonyHashSet new_set = *set;
+    new_set.entries = entries;
+    new_set.capacity = capacity;
+    new_set.count = 0;
+    new_set.generation = 1;
+    u32 mask = capacity - 1;
+    for (u32 slot = harmony_hash_set_next(set, 0); slot < set->capacity; slot = harmony_hash_set_next(set, slot + 1)) {
+        const u32 *header = harmony_hash_set_header(set, slot);
+        u32 new_slot = header[1] & mask;
+        while (harmony_hash_set_header(&new_set, new_slot)[0] != 0) {
+            new_slot = (new_slot + 1) & mask;
+        }
+        u32 *new_header = harmony_hash_set_header(&new_set, new_slot);
+        memcpy(new_header, header, set->stride);
+        new_header[0] = 1;
+        ++new_set.count;
+    }
+
+    if (set->capacity > 0)
+        harmony_free(allocator, set->entries, (usize)set->capacity * set->stride);
+    *set = new_set;
+}
+
+HarmonyHashSet harmony_hash_set_create(
+    const HarmonyAllocator *allocator,
+    u32 key_size,
+    u32 count,
+    HarmonyHashFunction hash,
+    HarmonyEqualFunction equal
+) {
+    harmony_assert(allocator != NULL);
+    harmony_assert(key_size > 0);
+    HarmonyHashSet set = {
+        .hash = hash,
+        .equal = equal,
+        .key_size = key_size,
+        .stride = (key_size + 8 + 7) / 8 * 8,
+        .generation = 1,
+    };
+    if (count > 0)
+        harmony_hash_set_rehash(allocator, &set, harmony_hash_set_capacity_for(count));
+    return set;
+}
+
+void harmony_hash_set_destroy(const HarmonyAllocator *allocator, HarmonyHashSet *set) {
+    harmony_assert(allocator != NULL);
+    harmony_assert(set != NULL);
+    if (set->capacity > 0)
+        harmony_free(allocator, set->entries, (usize)set->capacity * set->stride);
+    *set = (HarmonyHashSet){0};
+}
+
+void harmony_hash_set_clear(HarmonyHashSet *set) {
+    harmony_assert(set != NULL);
+    set->count = 0;
+    if (++set->generation == 0) {
+        for (u32 slot = 0; slot < set->capacity; ++slot) {
+            harmony_hash_set_header(set, slot)[0] = 0;
+        }
+        set->generation = 1;
+    }
+}
+
+void harmony_hash_set_reserve(const HarmonyAllocator *allocator, HarmonyHashSet *set, u32 count) {
+    harmony_assert(allocator != NULL);
+    harmony_assert(set != NULL);
+    if (count > set->capacity / 4 * 3)
+        harmony_hash_set_rehash(allocator, set, harmony_hash_set_capacity_for(count));
+}
+
+bool harmony_hash_set_insert(const HarmonyAllocator *allocator, HarmonyHashSet *set, const void *key) {
+    harmony_assert(key != NULL);
+    harmony_hash_set_reserve(allocator, set, set->count + 1);
+    return harmony_hash_set_insert_hashed(set, key, harmony_hash_set_hash(set, key));
+}
+
+bool harmony_hash_set_contains(const HarmonyHashSet *set, const void *key) {
+    harmony_assert(set != NULL);
+    harmony_assert(key != NULL);
+    if (set->count == 0)
+        return false;
+    return harmony_hash_set_find(set, key, harmony_hash_set_hash(set, key)) != UINT32_MAX;
+}
+
+bool harmony_hash_set_remove(HarmonyHashSet *set, const void *key) {
+    harmony_assert(set != NULL);
+    harmony_assert(key != NULL);
+    if (set->count == 0)
+        return false;
+    u32 slot = harmony_hash_set_find(set, key, harmony_hash_set_hash(set, key));
+    if (slot == UINT32_MAX)
+        return false;
+    harmony_hash_set_remove_slot(set, slot);
+    return true;
+}
+
+u32 harmony_hash_set_insert_many(const HarmonyAllocator *allocator, HarmonyHashSet *set, const void *keys, u32 count) {
+    harmony_assert(set != NULL);
+    harmony_assert(keys != NULL || count == 0);
+    const u8 *key_bytes = keys;
+    u32 inserted = 0;
+    u32 hashes[HARMONY_HASH_SET_BATCH];
+    for (u32 begin = 0; begin < count; begin += HARMONY_HASH_SET_BATCH) {
+        u32 batch = harmony_min(count - begin, (u32)HARMONY_HASH_SET_BATCH);
+        harmony_hash_set_reserve(allocator, set, set->count + batch);
+        u32 mask = set->capacity - 1;
+        for (u32 i = 0; i < batch; ++i) {
+            hashes[i] = harmony_hash_set_hash(set, key_bytes + (usize)(begin + i) * set->key_size);
+            __builtin_prefetch(harmony_hash_set_header(set, hashes[i] & mask), 1);
+        }
+        for (u32 i = 0; i < batch; ++i) {
+            inserted += harmony_hash_set_insert_hashed(set, key_bytes + (usize)(begin + i) * set->key_size, hashes[i]);
+        }
+    }
+    return inserted;
+}
+
+u32 harmony_hash_set_contains_many(const HarmonyHashSet *set, const void *keys, u32 count, bool *results) {
+    harmony_assert(set != NULL);
+    harmony_assert(keys != NULL || count == 0);
+    const u8 *key_bytes = keys;
+    if (set->count == 0) {
+        if (results != NULL)
+            memset(results, 0, count * sizeof(*results));
+        return 0;
+    }
+
+    u32 mask = set->capacity - 1;
+    u32 found = 0;
+    u32 hashes[HARMONY_HASH_SET_BATCH];
+    for (u32 begin = 0; begin < count; begin += HARMONY_HASH_SET_BATCH) {
+        u32 batch = harmony_min(count - begin, (u32)HARMONY_HASH_SET_BATCH);
+        for (u32 i = 0; i < batch; ++i) {
+            hashes[i] = harmony_hash_set_hash(set, key_bytes + (usize)(begin + i) * set->key_size);
+            __builtin_prefetch(harmony_hash_set_header(set, hashes[i] & mask), 0);
+        }
+        for (u32 i = 0; i < batch; ++i) {
+            bool contained = harmony_hash_set_find(set, key_bytes + (usize)(begin + i) * set->key_size, hashes[i]) != UINT32_MAX;
+            if (results != NULL)
+                results[begin + i] = contained;
+            found += contained;
+        }
+    }
+    return found;
+}
+
+void harmony_hash_set_union(const HarmonyAllocator *allocator, HarmonyHashSet *set, const HarmonyHashSet *other) {
+    harmony_assert(set != NULL);
+    harmony_assert(other != NULL);
+    harmony_assert(set->key_size == other->key_size && set->hash == other->hash);
+    harmony_hash_set_reserve(allocator, set, set->count + other->count);
+    for (u32 slot = harmony_hash_set_next(other, 0); slot < other->capacity; slot = harmony_hash_set_next(other, slot + 1)) {
+        const u32 *header = harmony_hash_set_header(other, slot);
+        harmony_hash_set_insert_hashed(set, header + 2, header[1]);
+    }
+}
+
+/**
+ * Removes the keys of a set which are, or are not, in other
+ *
+ * After a removal the same entry is checked again, as a later key may have
+ * been moved into it, and a key moved from the start of the table to the end
+ * is only checked twice
+ */
+static void harmony_hash_set_filter(HarmonyHashSet *set, const HarmonyHashSet *other, bool keep_contained) {
+    for (u32 slot = 0; slot < set->capacity;) {
+        const u32 *header = harmony_hash_set_header(set, slot);
+        if (header[0] == set->generation) {
+            bool contained = other->count > 0 && harmony_hash_set_find(other, header + 2, header[1]) != UINT32_MAX;
+            if (contained != keep_contained) {
+                harmony_hash_set_remove_slot(set, slot);
+                continue;
+            }
+        }
+        ++slot;
+    }
+}
+
+void harmony_hash_set_intersect(HarmonyHashSet *set, const HarmonyHashSet *other) {
+    harmony_assert(set != NULL);
+    harmony_assert(other != NULL);
+    harmony_assert(set->key_size == other->key_size && set->hash == other->hash);
+    harmony_hash_set_filter(set, other, true);
+}
+
+void harmony_hash_set_subtract(HarmonyHashSet *set, const HarmonyHashSet *other) {
+    harmony_assert(set != NULL);
+    harmony_assert(other != NULL);
+    harmony_assert(set->key_size == other->key_size && set->hash == other->hash);
+    if (set == other) {
+        harmony_hash_set_clear(set);
+        return;
+    }
+    if (other->count >= set->count) {
+        harmony_hash_set_filter(set, other, false);
+        return;
+    }
+    for (u32 slot = harmony_hash_set_next(other, 0); slot < other->capacity && set->count > 0; slot = harmony_hash_set_next(other, slot + 1)) {
+        const u32 *header = harmony_hash_set_header(other, slot);
+        u32 found = harmony_hash_set_find(set, header + 2, header[1]);
+        if (found != UINT32_MAX)
+            harmony_hash_set_remove_slot(set, found);
+    }
+}
+
+u32 harmony_hash_set_next(const HarmonyHashSet *set, u32 slot) {
+    harmony_assert(set != NULL);
+    for (; slot < set->capacity; ++slot) {
+        if (harmony_hash_set_header(set, slot)[0] == set->generation)
+            return slot;
+    }
+    return set->capacity;
 }
 
 #endif // defined(HARMONY_IMPLEMENTATION_CONTAINERS) || defined(HARMONY_IMPLEMENTATION_ALL)
@@ -1525,6 +1525,9 @@ void harmony_vk_dispatch(VkCommandBuffer cmd, u32 x, u32 y, u32 z);
 #include <X11/Xutil.h>
 #include <vulkan/vulkan_xlib.h>
 
+// X.h defines Complex as a polygon shape, hiding the Harmony type
+#undef Complex
+
 typedef struct HarmonyX11Funcs {
     Display *(*XOpenDisplay)(_Xconst char*);
     int (*XCloseDisplay)(Display*);
@@ -28,135 +28,10560 @@
 #define HARMONY_MATH_H
 
 #include "harmony.h"
+#include "harmony_containers.h"
 
-// random number generators : TODO
+/**
+ * A PCG32 random number generator, XSH RR output over a 64-bit LCG
+ *
+ * Small and fast, with 2^63 selectable streams; use one per thread
+ */
+typedef struct HarmonyPcg32 {
+    u64 state;
+    u64 inc;
+} HarmonyPcg32;
 
-// hash functions : TODO
+/**
+ * Seeds a PCG32 generator
+ *
+ * Generators with the same seed and different streams produce independent
+ * sequences
+ *
+ * Parameters
+ * - rng The generator to seed, must not be NULL
+ * - seed The starting state
+ * - stream The sequence to select, only the low 63 bits are used
+ */
+void harmony_pcg32_seed(HarmonyPcg32 *rng, u64 seed, u64 stream);
 
 /**
- * Creates a model matrix for 2D graphics
+ * Generates the next 32 random bits
  *
  * Parameters
- * - position The position of the model
- * - scale The scale of the model
- * - rotation The rotation of the model
+ * - rng The generator, must not be NULL
  * Returns
- * - The created matrix
+ * - The random bits
  */
-Mat4 harmony_model_matrix_2d(Vec3 position, Vec2 scale, f32 rotation);
+u32 harmony_pcg32_next(HarmonyPcg32 *rng);
 
 /**
- * Creates a model matrix for 3D graphics
+ * Generates a uniform random integer in [0, bound) without modulo bias
  *
  * Parameters
- * - position The position of the model
- * - scale The scale of the model
- * - rotation The rotation of the model
+ * - rng The generator, must not be NULL
+ * - bound The exclusive upper bound, must be greater than 0
  * Returns
- * - The created matrix
+ * - The random integer
  */
-Mat4 harmony_model_matrix_3d(Vec3 position, Vec3 scale, Quat rotation);
+u32 harmony_pcg32_bounded(HarmonyPcg32 *rng, u32 bound);
 
 /**
- * Creates a view matrix
+ * Generates a uniform random float in [0, 1)
  *
  * Parameters
- * - position The position of the camera
- * - zoom The zoom of the camera
- * - rotation The rotation of the camera
+ * - rng The generator, must not be NULL
  * Returns
- * - The created matrix
+ * - The random float
  */
-Mat4 harmony_view_matrix(Vec3 position, f32 zoom, Quat rotation);
+f32 harmony_pcg32_f32(HarmonyPcg32 *rng);
 
 /**
- * Creates an orthographic projection matrix
+ * Advances a PCG32 generator as if delta numbers were generated, in
+ * logarithmic time
  *
  * Parameters
- * - left The left-hand side of the view frustum
- * - right The right-hand side of the view frustum
- * - top The top of the view frustum
- * - bottom The bottom of the view frustum
- * - near The near plane of the view frustum
- * - far The far plane of the view frustum
+ * - rng The generator, must not be NULL
+ * - delta The number of steps to skip
+ */
+void harmony_pcg32_advance(HarmonyPcg32 *rng, u64 delta);
+
+/**
+ * A xoshiro256** random number generator
+ *
+ * Has a period of 2^256 - 1 and jump functions to split it into independent
+ * sequences
+ */
+typedef struct HarmonyXoshiro256 {
+    u64 s[4];
+} HarmonyXoshiro256;
+
+/**
+ * Seeds a xoshiro256** generator, expanding the seed with splitmix64
+ *
+ * Parameters
+ * - rng The generator to seed, must not be NULL
+ * - seed The seed, any value including 0
+ */
+void harmony_xoshiro256_seed(HarmonyXoshiro256 *rng, u64 seed);
+
+/**
+ * Generates the next 64 random bits
+ *
+ * Parameters
+ * - rng The generator, must not be NULL
  * Returns
- * - The created matrix
+ * - The random bits
  */
-Mat4 harmony_orthographic_projection(f32 left, f32 right, f32 top, f32 bottom, f32 near, f32 far);
+u64 harmony_xoshiro256_next(HarmonyXoshiro256 *rng);
 
 /**
- * Creates a perspective projection matrix
+ * Generates a uniform random float in [0, 1)
  *
  * Parameters
- * - fov The field of view of the projection in radians
- * - aspect The aspect ratio of the projection
- * - near The near plane of the projection, must be greater than 0.0f
- * - far The far plane of the projection, must be greater than near
+ * - rng The generator, must not be NULL
  * Returns
- * - The created matrix
+ * - The random float
  */
-Mat4 harmony_perspective_projection(f32 fov, f32 aspect, f32 near, f32 far);
+f32 harmony_xoshiro256_f32(HarmonyXoshiro256 *rng);
 
-#if defined(HARMONY_IMPLEMENTATION_MATH) || defined(HARMONY_IMPLEMENTATION_ALL)
+/**
+ * Advances a xoshiro256** generator by 2^128 steps
+ *
+ * Calling repeatedly gives 2^128 non-overlapping sequences, such as one for
+ * each thread
+ *
+ * Parameters
+ * - rng The generator, must not be NULL
+ */
+void harmony_xoshiro256_jump(HarmonyXoshiro256 *rng);
 
-Mat4 harmony_model_matrix_2d(Vec3 position, Vec2 scale, f32 rotation) {
-    Mat2 m2 = smat2(1.0f);
-    m2.x.x = scale.x;
-    m2.y.y = scale.y;
-    m2 = mmul2((Mat2){
-        {cosf(rotation), sinf(rotation)},
-        {-sinf(rotation), cosf(rotation)},
-    }, m2);
-    Mat4 m4 = mat2to4(m2);
-    m4.w.x = position.x;
-    m4.w.y = position.y;
-    m4.w.z = position.z;
-    return m4;
-}
+/**
+ * Advances a xoshiro256** generator by 2^192 steps
+ *
+ * Useful to give each process its own range of harmony_xoshiro256_jump()
+ * sequences
+ *
+ * Parameters
+ * - rng The generator, must not be NULL
+ */
+void harmony_xoshiro256_long_jump(HarmonyXoshiro256 *rng);
 
-Mat4 harmony_model_matrix_3d(Vec3 position, Vec3 scale, Quat rotation) {
-    Mat3 m3 = smat3(1.0f);
-    m3.x.x = scale.x;
-    m3.y.y = scale.y;
-    m3.z.z = scale.z;
-    m3 = rotate_mat3(rotation, m3);
-    Mat4 m4 = mat3to4(m3);
-    m4.w.x = position.x;
-    m4.w.y = position.y;
-    m4.w.z = position.z;
-    return m4;
-}
+/**
+ * The number of xoshiro256** generators run in lock step by bulk fills
+ */
+#define HARMONY_RANDOM_LANES 8
 
-Mat4 harmony_view_matrix(Vec3 position, f32 zoom, Quat rotation) {
-    Mat4 rot = mat3to4(rotate_mat3(qconj(rotation), smat3(1.0f)));
-    Mat4 pos = smat4(1.0f);
-    pos.x.x = zoom;
-    pos.y.y = zoom;
-    pos.w.x = -position.x;
-    pos.w.y = -position.y;
-    pos.w.z = -position.z;
-    return mmul4(rot, pos);
-}
+/**
+ * Interleaved xoshiro256** generators for filling arrays in bulk
+ *
+ * Each lane is a separate sequence, 2^128 steps apart, stored as structure of
+ * arrays so all lanes advance in one set of vector instructions
+ */
+typedef struct HarmonyRandom {
+    u64 s[4][HARMONY_RANDOM_LANES];
+} HarmonyRandom;
 
-Mat4 harmony_orthographic_projection(f32 left, f32 right, f32 top, f32 bottom, f32 near, f32 far) {
-    return (Mat4){
-        {2.0f / (right - left), 0.0f, 0.0f, 0.0f},
-        {0.0f, 2.0f / (bottom - top), 0.0f, 0.0f},
-        {0.0f, 0.0f, 1.0f / (far - near), 0.0f},
-        {-(right + left) / (right - left), -(bottom + top) / (bottom - top), -(near) / (far - near), 1.0f},
-    };
-}
+/**
+ * Seeds a bulk generator
+ *
+ * Parameters
+ * - rng The generator to seed, must not be NULL
+ * - seed The seed, any value including 0
+ */
+void harmony_random_seed(HarmonyRandom *rng, u64 seed);
 
-Mat4 harmony_perspective_projection(f32 fov, f32 aspect, f32 near, f32 far) {
-    harmony_assert(near > 0.0f);
-    harmony_assert(far > near);
-    f32 scale = 1 / tanf(fov / 2);
-    return (Mat4){
-        {scale / aspect, 0.0f, 0.0f, 0.0f},
-        {0.0f, scale, 0.0f, 0.0f},
-        {0.0f, 0.0f, far / (far - near), 1.0f},
-        {0.0f, 0.0f, -(far * near) / (far - near), 0.0f},
-    };
+/**
+ * Seeds a bulk generator from a xoshiro256** generator, jumping src once for
+ * each lane
+ *
+ * Seeding each thread's generator from the same src gives independent
+ * sequences
+ *
+ * Parameters
+ * - rng The generator to seed, must not be NULL
+ * - src The generator to split, must not be NULL
+ */
+void harmony_random_split(HarmonyRandom *rng, HarmonyXoshiro256 *src);
+
+/**
+ * Fills an array with random bits
+ *
+ * Parameters
+ * - rng The generator, must not be NULL
+ * - dst The array to fill, must not be NULL
+ * - count The number of values to generate
+ */
+void harmony_random_u64s(HarmonyRandom *rng, u64 *dst, usize count);
+
+/**
+ * Fills an array with uniform random floats in [0, 1)
+ *
+ * Parameters
+ * - rng The generator, must not be NULL
+ * - dst The array to fill, must not be NULL
+ * - count The number of values to generate
+ */
+void harmony_random_f32s(HarmonyRandom *rng, f32 *dst, usize count);
+
+/**
+ * Fills an array with uniform random floats in [min, max)
+ *
+ * Parameters
+ * - rng The generator, must not be NULL
+ * - dst The array to fill, must not be NULL
+ * - count The number of values to generate
+ * - min The inclusive lower bound
+ * - max The exclusive upper bound
+ */
+void harmony_random_range_f32s(HarmonyRandom *rng, f32 *dst, usize count, f32 min, f32 max);
+
+/**
+ * Fills an array with normally distributed random floats, using the
+ * Box-Muller transform over 8 lanes with the approximate logarithm and
+ * sincos of harmony_approx_log2() and harmony_approx_sincos()
+ *
+ * Parameters
+ * - rng The generator, must not be NULL
+ * - dst The array to fill, must not be NULL
+ * - count The number of values to generate
+ * - mean The mean of the distribution
+ * - stddev The standard deviation of the distribution
+ */
+void harmony_random_gaussian_f32s(HarmonyRandom *rng, f32 *dst, usize count, f32 mean, f32 stddev);
+
+/**
+ * Fills an array with uniformly distributed random unit vectors
+ *
+ * Computes 8 vectors at a time, with the approximate sincos of
+ * harmony_approx_sincos()
+ *
+ * Parameters
+ * - rng The generator, must not be NULL
+ * - dst The array to fill, must not be NULL
+ * - count The number of vectors to generate
+ */
+void harmony_random_unit_vec3s(HarmonyRandom *rng, Vec3 *dst, usize count);
+
+/**
+ * The number of 64-bit words of key material used by the hash functions
+ */
+#define HARMONY_HASH_SECRET_SIZE 24
+
+/**
+ * The number of bytes held back by a streaming hash between updates
+ */
+#define HARMONY_HASH_BUFFER_SIZE 256
+
+/**
+ * The state of a streaming hash
+ *
+ * Large, so should be kept in static or heap memory rather than created for
+ * each short key; use harmony_hash() for short keys
+ */
+typedef struct HarmonyHashState {
+    u64 acc[8];
+    u64 secret[HARMONY_HASH_SECRET_SIZE];
+    u64 seed;
+    usize total;
+    usize buffered;
+    u32 block_stripes;
+    u8 buffer[HARMONY_HASH_BUFFER_SIZE];
+    u8 tail[64];
+} HarmonyHashState;
+
+/**
+ * Hashes a buffer into 64 bits, not suitable for cryptography
+ *
+ * Keys of up to 16 bytes take a branch-light path with no loops, keys over
+ * 128 bytes are processed in 64 byte stripes by vector kernels dispatched
+ * through harmony_kernels()
+ *
+ * Parameters
+ * - data The bytes to hash, may only be NULL if size is 0
+ * - size The number of bytes to hash
+ * Returns
+ * - The hash
+ */
+u64 harmony_hash(const void *data, usize size);
+
+/**
+ * Hashes a buffer into 64 bits with a seed
+ *
+ * Different seeds give unrelated hashes, useful to resist collisions from
+ * untrusted keys, or to get several hashes of the same key
+ *
+ * Parameters
+ * - data The bytes to hash, may only be NULL if size is 0
+ * - size The number of bytes to hash
+ * - seed The seed, 0 gives the same hash as harmony_hash()
+ * Returns
+ * - The hash
+ */
+u64 harmony_hash_seeded(const void *data, usize size, u64 seed);
+
+/**
+ * Begins a streaming hash
+ *
+ * The hash of all the data passed to harmony_hash_update() is the same as
+ * harmony_hash_seeded() on the concatenated data
+ *
+ * Parameters
+ * - state The state to initialize, must not be NULL
+ * - seed The seed, 0 gives the same hash as harmony_hash()
+ */
+void harmony_hash_init(HarmonyHashState *state, u64 seed);
+
+/**
+ * Adds data to a streaming hash
+ *
+ * Parameters
+ * - state The state, must not be NULL
+ * - data The bytes to add, may only be NULL if size is 0
+ * - size The number of bytes to add
+ */
+void harmony_hash_update(HarmonyHashState *state, const void *data, usize size);
+
+/**
+ * Finishes a streaming hash
+ *
+ * Does not modify the state, so more data may still be added afterwards
+ *
+ * Parameters
+ * - state The state, must not be NULL
+ * Returns
+ * - The hash of all the data added so far
+ */
+u64 harmony_hash_final(const HarmonyHashState *state);
+
+/**
+ * The most octaves a fractal noise can sum
+ */
+#define HARMONY_NOISE_MAX_OCTAVES 16
+
+/**
+ * The basis of a coherent noise
+ */
+typedef enum HarmonyNoiseType {
+    /**
+     * Gradient noise interpolated over the corners of a grid cell
+     */
+    HARMONY_NOISE_PERLIN,
+    /**
+     * Gradient noise summed over the corners of a simplex, cheaper than
+     * Perlin noise in higher dimensions and without axis aligned artifacts
+     */
+    HARMONY_NOISE_SIMPLEX,
+} HarmonyNoiseType;
+
+/**
+ * How the octaves of a fractal noise are combined
+ */
+typedef enum HarmonyNoiseFractal {
+    /**
+     * Fractal Brownian motion, a sum of octaves, in approximately [-1, 1]
+     */
+    HARMONY_NOISE_FBM,
+    /**
+     * A sum of (1 - |octave|)^2, with sharp ridges, in [0, 1]
+     */
+    HARMONY_NOISE_RIDGED,
+} HarmonyNoiseFractal;
+
+/**
+ * Seeds for each octave of a fractal noise
+ */
+typedef struct HarmonyNoise {
+    u32 seeds[HARMONY_NOISE_MAX_OCTAVES];
+} HarmonyNoise;
+
+/**
+ * The shape of a fractal noise
+ */
+typedef struct HarmonyNoiseConfig {
+    /**
+     * The number of dimensions to sample, 2, 3 or 4
+     */
+    u32 dimensions;
+    /**
+     * The basis noise
+     */
+    HarmonyNoiseType type;
+    /**
+     * How octaves are combined
+     */
+    HarmonyNoiseFractal fractal;
+    /**
+     * The number of octaves, from 1 to HARMONY_NOISE_MAX_OCTAVES
+     */
+    u32 octaves;
+    /**
+     * The frequency of the first octave
+     */
+    f32 frequency;
+    /**
+     * The frequency multiplier between octaves, usually 2.0f
+     */
+    f32 lacunarity;
+    /**
+     * The amplitude multiplier between octaves, usually 0.5f
+     */
+    f32 gain;
+} HarmonyNoiseConfig;
+
+/**
+ * A grid of noise samples
+ *
+ * Sample (x, y, z) is at origin + (x, y, z) * step, with the fourth
+ * coordinate fixed at origin[3] for 4D noise; samples are stored with x
+ * varying fastest, then y, then z
+ */
+typedef struct HarmonyNoiseRegion {
+    f32 origin[4];
+    f32 step[3];
+    u32 width;
+    u32 height;
+    /**
+     * The number of slices, 1 for 2D noise
+     */
+    u32 depth;
+} HarmonyNoiseRegion;
+
+/**
+ * Seeds a noise, generating a seed for each octave with PCG32
+ *
+ * Parameters
+ * - noise The noise to seed, must not be NULL
+ * - seed The seed
+ */
+void harmony_noise_seed(HarmonyNoise *noise, u64 seed);
+
+/**
+ * Samples 2D Perlin noise
+ *
+ * Parameters
+ * - seed The seed for the gradient lattice
+ * - x, y The coordinates to sample
+ * Returns
+ * - The noise, approximately in [-1, 1]
+ */
+f32 harmony_perlin_2d(u32 seed, f32 x, f32 y);
+
+/**
+ * Samples 3D Perlin noise
+ *
+ * Parameters
+ * - seed The seed for the gradient lattice
+ * - x, y, z The coordinates to sample
+ * Returns
+ * - The noise, approximately in [-1, 1]
+ */
+f32 harmony_perlin_3d(u32 seed, f32 x, f32 y, f32 z);
+
+/**
+ * Samples 4D Perlin noise
+ *
+ * Parameters
+ * - seed The seed for the gradient lattice
+ * - x, y, z, w The coordinates to sample
+ * Returns
+ * - The noise, approximately in [-1, 1]
+ */
+f32 harmony_perlin_4d(u32 seed, f32 x, f32 y, f32 z, f32 w);
+
+/**
+ * Samples 2D simplex noise
+ *
+ * Parameters
+ * - seed The seed for the gradient lattice
+ * - x, y The coordinates to sample
+ * Returns
+ * - The noise, approximately in [-1, 1]
+ */
+f32 harmony_simplex_2d(u32 seed, f32 x, f32 y);
+
+/**
+ * Samples 3D simplex noise
+ *
+ * Parameters
+ * - seed The seed for the gradient lattice
+ * - x, y, z The coordinates to sample
+ * Returns
+ * - The noise, approximately in [-1, 1]
+ */
+f32 harmony_simplex_3d(u32 seed, f32 x, f32 y, f32 z);
+
+/**
+ * Samples 4D simplex noise
+ *
+ * Parameters
+ * - seed The seed for the gradient lattice
+ * - x, y, z, w The coordinates to sample
+ * Returns
+ * - The noise, approximately in [-1, 1]
+ */
+f32 harmony_simplex_4d(u32 seed, f32 x, f32 y, f32 z, f32 w);
+
+/**
+ * Samples a fractal noise at one point
+ *
+ * Parameters
+ * - noise The seeds, must not be NULL
+ * - config The shape of the noise, must not be NULL
+ * - point The coordinates, config->dimensions of them, must not be NULL
+ * Returns
+ * - The noise
+ */
+f32 harmony_noise_sample(const HarmonyNoise *noise, const HarmonyNoiseConfig *config, const f32 *point);
+
+/**
+ * Fills a grid with fractal noise
+ *
+ * Samples are computed 8 at a time along each row, by kernels dispatched
+ * through harmony_kernels()
+ *
+ * Parameters
+ * - dst The samples to write, width * height * depth of them, must not be NULL
+ * - noise The seeds, must not be NULL
+ * - config The shape of the noise, must not be NULL
+ * - region The grid to sample, must not be NULL
+ */
+void harmony_noise_fill(
+    f32 *dst,
+    const HarmonyNoise *noise,
+    const HarmonyNoiseConfig *config,
+    const HarmonyNoiseRegion *region);
+
+/**
+ * Fills a grid with fractal noise, splitting rows across threads
+ *
+ * Gives the same samples as harmony_noise_fill()
+ *
+ * Parameters
+ * - thread_count The number of threads to use
+ * - dst The samples to write, width * height * depth of them, must not be NULL
+ * - noise The seeds, must not be NULL
+ * - config The shape of the noise, must not be NULL
+ * - region The grid to sample, must not be NULL
+ */
+void harmony_noise_fill_parallel(
+    u32 thread_count,
+    f32 *dst,
+    const HarmonyNoise *noise,
+    const HarmonyNoiseConfig *config,
+    const HarmonyNoiseRegion *region);
+
+/**
+ * The most prime factors an FFT size can have
+ */
+#define HARMONY_FFT_MAX_FACTORS 32
+
+/**
+ * Precomputed factors and twiddles for FFTs of one size
+ *
+ * Sizes with factors of 2 and 4 are fastest, other prime factors use a
+ * slower generic pass
+ *
+ * Note, a plan may only be used by one transform at a time, as it holds the
+ * scratch memory for the transform
+ */
+typedef struct HarmonyFftPlan {
+    /**
+     * The memory holding the twiddles and scratch
+     */
+    void *allocation;
+    /**
+     * The size of the allocation in bytes
+     */
+    usize allocation_size;
+    /**
+     * The number of complex values transformed
+     */
+    usize size;
+    /**
+     * The twiddles for each pass, followed by the roots of unity for each
+     * generic pass
+     */
+    Complex *twiddles;
+    /**
+     * The twiddles to split a complex FFT into a real FFT, NULL for complex
+     * plans
+     */
+    Complex *real_twiddles;
+    /**
+     * size complex values to transform through
+     */
+    Complex *scratch;
+    /**
+     * The radix of each pass
+     */
+    u32 factors[HARMONY_FFT_MAX_FACTORS];
+    /**
+     * The number of passes
+     */
+    u32 factor_count;
+} HarmonyFftPlan;
+
+/**
+ * Precomputed plans for 2D FFTs
+ */
+typedef struct HarmonyFft2dPlan {
+    HarmonyFftPlan rows;
+    HarmonyFftPlan columns;
+    /**
+     * width * height complex values to transpose through
+     */
+    Complex *transposed;
+} HarmonyFft2dPlan;
+
+/**
+ * Creates a plan for complex FFTs
+ *
+ * Parameters
+ * - allocator The allocator for the twiddles and scratch, must not be NULL
+ * - size The number of complex values to transform, must be greater than 0
+ *   and have at most HARMONY_FFT_MAX_FACTORS factors
+ * Returns
+ * - The created plan
+ */
+HarmonyFftPlan harmony_fft_plan_create(const HarmonyAllocator *allocator, usize size);
+
+/**
+ * Creates a plan for real FFTs
+ *
+ * Parameters
+ * - allocator The allocator for the twiddles and scratch, must not be NULL
+ * - size The number of real values to transform, must be even
+ * Returns
+ * - The created plan
+ */
+HarmonyFftPlan harmony_fft_real_plan_create(const HarmonyAllocator *allocator, usize size);
+
+/**
+ * Destroys an FFT plan
+ *
+ * Parameters
+ * - allocator The allocator the plan was created with, must not be NULL
+ * - plan The plan to destroy, must not be NULL
+ */
+void harmony_fft_plan_destroy(const HarmonyAllocator *allocator, HarmonyFftPlan *plan);
+
+/**
+ * Computes a forward FFT, with a negative exponent and no scaling
+ *
+ * Passes are dispatched through harmony_kernels()
+ *
+ * Parameters
+ * - plan A complex plan, must not be NULL
+ * - dst The plan->size values to write, must not be NULL, may be src
+ * - src The plan->size values to transform, must not be NULL
+ */
+void harmony_fft(const HarmonyFftPlan *plan, Complex *dst, const Complex *src);
+
+/**
+ * Computes an inverse FFT, with a positive exponent, scaled by 1 / size so
+ * that it undoes harmony_fft()
+ *
+ * Parameters
+ * - plan A complex plan, must not be NULL
+ * - dst The plan->size values to write, must not be NULL, may be src
+ * - src The plan->size values to transform, must not be NULL
+ */
+void harmony_fft_inverse(const HarmonyFftPlan *plan, Complex *dst, const Complex *src);
+
+/**
+ * Computes a forward FFT of real values, with a half size complex FFT
+ *
+ * The spectrum of real values is conjugate symmetric, so only the first
+ * size / 2 + 1 values are written
+ *
+ * Parameters
+ * - plan A real plan, must not be NULL
+ * - dst The size / 2 + 1 values to write, must not be NULL
+ * - src The size values to transform, must not be NULL
+ */
+void harmony_fft_real(const HarmonyFftPlan *plan, Complex *dst, const f32 *src);
+
+/**
+ * Computes an inverse FFT from half a spectrum to real values, undoing
+ * harmony_fft_real()
+ *
+ * Parameters
+ * - plan A real plan, must not be NULL
+ * - dst The size values to write, must not be NULL
+ * - src The size / 2 + 1 values to transform, must not be NULL
+ */
+void harmony_fft_real_inverse(const HarmonyFftPlan *plan, f32 *dst, const Complex *src);
+
+/**
+ * Creates a plan for 2D complex FFTs
+ *
+ * Parameters
+ * - allocator The allocator for the plans, must not be NULL
+ * - width The number of values in each row, must be greater than 0
+ * - height The number of rows, must be greater than 0
+ * Returns
+ * - The created plan
+ */
+HarmonyFft2dPlan harmony_fft_2d_plan_create(const HarmonyAllocator *allocator, usize width, usize height);
+
+/**
+ * Destroys a 2D FFT plan
+ *
+ * Parameters
+ * - allocator The allocator the plan was created with, must not be NULL
+ * - plan The plan to destroy, must not be NULL
+ */
+void harmony_fft_2d_plan_destroy(const HarmonyAllocator *allocator, HarmonyFft2dPlan *plan);
+
+/**
+ * Computes a forward 2D FFT, transforming each row then each column
+ *
+ * Parameters
+ * - plan The plan, must not be NULL
+ * - dst The width * height values to write, row by row, must not be NULL,
+ *   may be src
+ * - src The width * height values to transform, must not be NULL
+ */
+void harmony_fft_2d(const HarmonyFft2dPlan *plan, Complex *dst, const Complex *src);
+
+/**
+ * Computes an inverse 2D FFT, scaled by 1 / (width * height)
+ *
+ * Parameters
+ * - plan The plan, must not be NULL
+ * - dst The width * height values to write, row by row, must not be NULL,
+ *   may be src
+ * - src The width * height values to transform, must not be NULL
+ */
+void harmony_fft_2d_inverse(const HarmonyFft2dPlan *plan, Complex *dst, const Complex *src);
+
+/**
+ * The functions computed by the approximate math kernels
+ */
+typedef enum HarmonyApproxFunction {
+    HARMONY_APPROX_SINCOS,
+    HARMONY_APPROX_EXP2,
+    HARMONY_APPROX_LOG2,
+    HARMONY_APPROX_ATAN2,
+    HARMONY_APPROX_RSQRT,
+} HarmonyApproxFunction;
+
+/**
+ * Computes the sine and cosine of count values
+ *
+ * Accurate to an absolute error of 1.2e-7 for |src| <= 8192, degrading
+ * beyond as the range reduction loses precision, |src| must be below 1e9
+ *
+ * Parameters
+ * - sin_dst The sines to write, must not be NULL
+ * - cos_dst The cosines to write, must not be NULL
+ * - src The angles in radians, must not be NULL
+ * - count The number of values
+ */
+void harmony_approx_sincos(f32 *sin_dst, f32 *cos_dst, const f32 *src, usize count);
+
+/**
+ * Computes 2 to the power of count values
+ *
+ * Accurate to a relative error of 1.5e-7, inputs are clamped to
+ * [-126, 127] so results stay normal
+ *
+ * Parameters
+ * - dst The powers to write, must not be NULL, may be src
+ * - src The exponents, must not be NULL
+ * - count The number of values
+ */
+void harmony_approx_exp2(f32 *dst, const f32 *src, usize count);
+
+/**
+ * Computes the base 2 logarithm of count values
+ *
+ * Accurate to an absolute error of 1.2e-7 for inputs in [0.5, 2] and a
+ * relative error of 1.2e-7 elsewhere, inputs must be positive and normal
+ *
+ * Parameters
+ * - dst The logarithms to write, must not be NULL, may be src
+ * - src The values, must not be NULL
+ * - count The number of values
+ */
+void harmony_approx_log2(f32 *dst, const f32 *src, usize count);
+
+/**
+ * Computes the angle of count points, as atan2f() does
+ *
+ * Accurate to an absolute error of 3e-7 radians, the angle of the origin
+ * is 0 with the sign of y
+ *
+ * Parameters
+ * - dst The angles in [-pi, pi] to write, must not be NULL
+ * - y The y coordinates, must not be NULL
+ * - x The x coordinates, must not be NULL
+ * - count The number of values
+ */
+void harmony_approx_atan2(f32 *dst, const f32 *y, const f32 *x, usize count);
+
+/**
+ * Computes the reciprocal square root of count values
+ *
+ * An integer estimate refined by two Newton steps, accurate to a relative
+ * error of 4.7e-6, inputs must be positive and normal
+ *
+ * Parameters
+ * - dst The reciprocal square roots to write, must not be NULL, may be src
+ * - src The values, must not be NULL
+ * - count The number of values
+ */
+void harmony_approx_rsqrt(f32 *dst, const f32 *src, usize count);
+
+/**
+ * Creates a model matrix for 2D graphics
+ *
+ * Parameters
+ * - position The position of the model
+ * - scale The scale of the model
+ * - rotation The rotation of the model
+ * Returns
+ * - The created matrix
+ */
+Mat4 harmony_model_matrix_2d(Vec3 position, Vec2 scale, f32 rotation);
+
+/**
+ * Creates a model matrix for 3D graphics
+ *
+ * Parameters
+ * - position The position of the model
+ * - scale The scale of the model
+ * - rotation The rotation of the model
+ * Returns
+ * - The created matrix
+ */
+Mat4 harmony_model_matrix_3d(Vec3 position, Vec3 scale, Quat rotation);
+
+/**
+ * Structure of arrays input streams for building 2D model matrices
+ *
+ * Each pointer is an array of one component, with one element per model
+ */
+typedef struct HarmonyModelStreams2D {
+    /**
+     * The x, y, and z components of each position
+     */
+    const f32 *position[3];
+    /**
+     * The x and y components of each scale
+     */
+    const f32 *scale[2];
+    /**
+     * The rotation of each model in radians
+     */
+    const f32 *rotation;
+} HarmonyModelStreams2D;
+
+/**
+ * Structure of arrays input streams for building 3D model matrices
+ *
+ * Each pointer is an array of one component, with one element per model
+ */
+typedef struct HarmonyModelStreams3D {
+    /**
+     * The x, y, and z components of each position
+     */
+    const f32 *position[3];
+    /**
+     * The x, y, and z components of each scale
+     */
+    const f32 *scale[3];
+    /**
+     * The r, i, j, and k components of each rotation, which must be normalized
+     */
+    const f32 *rotation[4];
+} HarmonyModelStreams3D;
+
+/**
+ * Creates model matrices for 2D graphics in bulk
+ *
+ * Processes 8 models at a time, writing the matrices in order, so dst can be
+ * a buffer mapped from the GPU; the rotations use the approximate sincos of
+ * harmony_approx_sincos(), so the results may differ from
+ * harmony_model_matrix_2d() by rounding
+ *
+ * Parameters
+ * - dst The array to write count matrices to, must not be NULL
+ * - src The streams to read count models from, must not be NULL
+ * - count The number of models
+ */
+void harmony_model_matrices_2d(Mat4 *dst, const HarmonyModelStreams2D *src, usize count);
+
+/**
+ * Creates model matrices for 3D graphics in bulk
+ *
+ * Processes 8 models at a time, writing the matrices in order, so dst can be
+ * a buffer mapped from the GPU
+ *
+ * Parameters
+ * - dst The array to write count matrices to, must not be NULL
+ * - src The streams to read count models from, must not be NULL
+ * - count The number of models
+ */
+void harmony_model_matrices_3d(Mat4 *dst, const HarmonyModelStreams3D *src, usize count);
+
+/**
+ * Creates model matrices for 2D graphics in bulk, split across threads
+ *
+ * Parameters
+ * - thread_count The number of threads to use
+ * - dst The array to write count matrices to, must not be NULL
+ * - src The streams to read count models from, must not be NULL
+ * - count The number of models
+ */
+void harmony_model_matrices_2d_parallel(u32 thread_count, Mat4 *dst, const HarmonyModelStreams2D *src, usize count);
+
+/**
+ * Creates model matrices for 3D graphics in bulk, split across threads
+ *
+ * Parameters
+ * - thread_count The number of threads to use
+ * - dst The array to write count matrices to, must not be NULL
+ * - src The streams to read count models from, must not be NULL
+ * - count The number of models
+ */
+void harmony_model_matrices_3d_parallel(u32 thread_count, Mat4 *dst, const HarmonyModelStreams3D *src, usize count);
+
+/**
+ * Creates a 3D affine model transform for 2D graphics
+ *
+ * Equivalent to harmony_model_matrix_2d(), without the constant last row
+ *
+ * Parameters
+ * - position The position of the model
+ * - scale The scale of the model
+ * - rotation The rotation of the model
+ * Returns
+ * - The created transform
+ */
+Affine3 harmony_model_affine_2d(Vec3 position, Vec2 scale, f32 rotation);
+
+/**
+ * Creates a 3D affine model transform for 3D graphics
+ *
+ * Equivalent to harmony_model_matrix_3d(), without the constant last row
+ *
+ * Parameters
+ * - position The position of the model
+ * - scale The scale of the model
+ * - rotation The rotation of the model
+ * Returns
+ * - The created transform
+ */
+Affine3 harmony_model_affine_3d(Vec3 position, Vec3 scale, Quat rotation);
+
+/**
+ * Creates 3D affine model transforms in bulk
+ *
+ * Equivalent to harmony_model_affine_3d() for each model, processing 8 at a
+ * time
+ *
+ * Parameters
+ * - dst The array to write count transforms to, must not be NULL
+ * - src The streams to read count models from, must not be NULL
+ * - count The number of models
+ */
+void harmony_model_affines_3d(Affine3 *dst, const HarmonyModelStreams3D *src, usize count);
+
+/**
+ * Structure of arrays quaternions
+ *
+ * Each pointer is an array of one component, with one element per quaternion
+ */
+typedef struct HarmonyQuatStreams {
+    /**
+     * The r, i, j, and k components of each quaternion
+     */
+    f32 *components[4];
+} HarmonyQuatStreams;
+
+/**
+ * Normalizes quaternions in bulk
+ *
+ * Parameters
+ * - dst The streams to write count quaternions to, must not be NULL, may be
+ *   src
+ * - src The streams to read count quaternions from, must not be NULL, none
+ *   may be zero
+ * - count The number of quaternions
+ */
+void harmony_quats_normalize(const HarmonyQuatStreams *dst, const HarmonyQuatStreams *src, usize count);
+
+/**
+ * Interpolates normalized quaternions in bulk, linearly then normalized
+ *
+ * Takes the shortest path, negating rhs where it is more than a half turn
+ * from lhs; cheaper than harmony_quats_slerp(), but the angular speed is not
+ * constant, speeding up towards t = 0.5
+ *
+ * Parameters
+ * - dst The streams to write count quaternions to, must not be NULL, may be
+ *   lhs or rhs
+ * - lhs The quaternions at t = 0, must not be NULL
+ * - rhs The quaternions at t = 1, must not be NULL
+ * - t The interpolation factor of each quaternion, must not be NULL
+ * - count The number of quaternions
+ */
+void harmony_quats_nlerp(
+    const HarmonyQuatStreams *dst,
+    const HarmonyQuatStreams *lhs,
+    const HarmonyQuatStreams *rhs,
+    const f32 *t,
+    usize count);
+
+/**
+ * Interpolates normalized quaternions in bulk, at a constant angular speed
+ *
+ * Takes the shortest path, negating rhs where it is more than a half turn
+ * from lhs; the angles are computed with the approximate functions, and
+ * nearly equal quaternions are interpolated linearly
+ *
+ * Parameters
+ * - dst The streams to write count quaternions to, must not be NULL, may be
+ *   lhs or rhs
+ * - lhs The quaternions at t = 0, must not be NULL
+ * - rhs The quaternions at t = 1, must not be NULL
+ * - t The interpolation factor of each quaternion, must not be NULL
+ * - count The number of quaternions
+ */
+void harmony_quats_slerp(
+    const HarmonyQuatStreams *dst,
+    const HarmonyQuatStreams *lhs,
+    const HarmonyQuatStreams *rhs,
+    const f32 *t,
+    usize count);
+
+/**
+ * Converts normalized quaternions to rotation matrices in bulk
+ *
+ * Equivalent to rotate_mat3(quat, smat3(1.0f)), computed directly
+ *
+ * Parameters
+ * - dst The array to write count matrices to, must not be NULL
+ * - src The streams to read count quaternions from, must not be NULL
+ * - count The number of quaternions
+ */
+void harmony_quats_to_mat3(Mat3 *dst, const HarmonyQuatStreams *src, usize count);
+
+/**
+ * The channels animated for each joint
+ */
+typedef enum HarmonyAnimationChannel {
+    HARMONY_ANIMATION_TRANSLATION,
+    HARMONY_ANIMATION_ROTATION,
+    HARMONY_ANIMATION_SCALE,
+    HARMONY_ANIMATION_CHANNEL_COUNT,
+} HarmonyAnimationChannel;
+
+/**
+ * The keys of one channel, for creating a clip
+ */
+typedef struct HarmonyAnimationKeys {
+    /**
+     * The time of each key in seconds, increasing
+     */
+    const f32 *times;
+    /**
+     * The value of each key, Vec3 for translations and scales, and normalized
+     * Quat for rotations
+     */
+    const void *values;
+    /**
+     * The number of keys, 0 leaves the channel at its identity value
+     */
+    u32 count;
+} HarmonyAnimationKeys;
+
+/**
+ * The keys of one joint, for creating a clip
+ */
+typedef struct HarmonyAnimationTrack {
+    HarmonyAnimationKeys channels[HARMONY_ANIMATION_CHANNEL_COUNT];
+} HarmonyAnimationTrack;
+
+/**
+ * The compressed keys of one channel in a clip
+ *
+ * Each component is quantized to 16 bits over the range of the channel, the
+ * times and values being separate arrays, so a search only touches times
+ */
+typedef struct HarmonyAnimationChannelKeys {
+    /**
+     * The number of keys
+     */
+    u32 count;
+    /**
+     * The index of the first time in the clip's times
+     */
+    u32 first_time;
+    /**
+     * The index of the first value in the clip's values, with the components
+     * of each key together
+     */
+    u32 first_value;
+    /**
+     * The minimum of each component
+     */
+    f32 min[4];
+    /**
+     * The range of each component divided by the largest quantized value
+     */
+    f32 step[4];
+} HarmonyAnimationChannelKeys;
+
+/**
+ * An immutable animation clip, holding keyframes for a set of joints
+ */
+typedef struct HarmonyAnimationClip {
+    /**
+     * The single allocation holding the channels, times, and values
+     */
+    void *allocation;
+    /**
+     * The size of the allocation in bytes
+     */
+    usize allocation_size;
+    /**
+     * The channels of each joint, HARMONY_ANIMATION_CHANNEL_COUNT per joint
+     */
+    HarmonyAnimationChannelKeys *channels;
+    /**
+     * The key times of every channel
+     */
+    f32 *times;
+    /**
+     * The quantized key values of every channel
+     */
+    u16 *values;
+    /**
+     * The time of the last key
+     */
+    f32 duration;
+    /**
+     * The number of joints
+     */
+    u32 joint_count;
+} HarmonyAnimationClip;
+
+/**
+ * The local transforms of a set of joints
+ *
+ * Each pointer is an array with one element per joint, and the poses of
+ * several instances are stored one after another
+ */
+typedef struct HarmonyPose {
+    Vec3 *translations;
+    Quat *rotations;
+    Vec3 *scales;
+} HarmonyPose;
+
+/**
+ * Creates an animation clip, compressing the keys
+ *
+ * Parameters
+ * - allocator The allocator to use, must not be NULL
+ * - tracks The keys of each joint, must not be NULL
+ * - joint_count The number of joints
+ * Returns
+ * - The created clip
+ */
+HarmonyAnimationClip harmony_animation_clip_create(
+    const HarmonyAllocator *allocator,
+    const HarmonyAnimationTrack *tracks,
+    u32 joint_count);
+
+/**
+ * Destroys an animation clip
+ *
+ * Parameters
+ * - allocator The allocator used to create the clip, must not be NULL
+ * - clip The clip to destroy, must not be NULL
+ */
+void harmony_animation_clip_destroy(const HarmonyAllocator *allocator, HarmonyAnimationClip *clip);
+
+/**
+ * Gets the number of cursors each instance of a clip needs
+ *
+ * Cursors cache the current key of each channel, so playing forward costs
+ * O(1) per channel, and jumping back costs a binary search; they are zero
+ * initialized, and must be kept with their instance between samples
+ *
+ * Parameters
+ * - clip The clip, must not be NULL
+ * Returns
+ * - The number of cursors
+ */
+u32 harmony_animation_cursor_count(const HarmonyAnimationClip *clip);
+
+/**
+ * Samples a clip for several instances
+ *
+ * Translations and scales are interpolated linearly, rotations are
+ * interpolated linearly along the shortest path then normalized
+ *
+ * Parameters
+ * - clip The clip to sample, must not be NULL
+ * - cursors The cursors of each instance, one after another, must not be
+ *   NULL
+ * - times The time to sample each instance at, clamped to the clip, must not
+ *   be NULL
+ * - dst The poses to write, joint_count per instance, must not be NULL
+ * - instance_count The number of instances
+ */
+void harmony_animation_sample(
+    const HarmonyAnimationClip *clip,
+    u32 *cursors,
+    const f32 *times,
+    const HarmonyPose *dst,
+    u32 instance_count);
+
+/**
+ * Samples a clip for several instances, split across threads
+ *
+ * Parameters
+ * - thread_count The number of threads to use
+ * - clip The clip to sample, must not be NULL
+ * - cursors The cursors of each instance, one after another, must not be
+ *   NULL
+ * - times The time to sample each instance at, clamped to the clip, must not
+ *   be NULL
+ * - dst The poses to write, joint_count per instance, must not be NULL
+ * - instance_count The number of instances
+ */
+void harmony_animation_sample_parallel(
+    u32 thread_count,
+    const HarmonyAnimationClip *clip,
+    u32 *cursors,
+    const f32 *times,
+    const HarmonyPose *dst,
+    u32 instance_count);
+
+/**
+ * Blends poses joint by joint
+ *
+ * Translations and scales are interpolated linearly, rotations along the
+ * shortest path then normalized, so blending with a weight of 0 for some
+ * joints masks them
+ *
+ * Parameters
+ * - dst The poses to write, must not be NULL, may be lhs or rhs
+ * - lhs The poses at weight 0, must not be NULL
+ * - rhs The poses at weight 1, must not be NULL
+ * - weights The weight of each joint, must not be NULL
+ * - joint_count The total number of joints in the poses
+ */
+void harmony_pose_blend(
+    const HarmonyPose *dst,
+    const HarmonyPose *lhs,
+    const HarmonyPose *rhs,
+    const f32 *weights,
+    usize joint_count);
+
+/**
+ * The parent of root transforms
+ */
+#define HARMONY_TRANSFORM_NONE UINT32_MAX
+
+/**
+ * A hierarchy of transforms, with world transforms updated incrementally
+ *
+ * Nodes are stored in structure of arrays form in depth first order, so
+ * parents come before their children and every subtree is contiguous; adding
+ * a node moves the nodes after its parent's subtree, so nodes are referred to
+ * by handles, which stay stable
+ */
+typedef struct HarmonyTransformHierarchy {
+    /**
+     * The single allocation holding every array
+     */
+    void *allocation;
+    /**
+     * The size of the allocation in bytes
+     */
+    usize allocation_size;
+    /**
+     * The maximum number of nodes
+     */
+    u32 capacity;
+    /**
+     * The number of nodes
+     */
+    u32 count;
+    /**
+     * The index of each node's parent, or HARMONY_TRANSFORM_NONE for roots
+     */
+    u32 *parents;
+    /**
+     * The number of nodes in each node's subtree, including itself
+     */
+    u32 *sizes;
+    /**
+     * The handle of each node
+     */
+    u32 *handles;
+    /**
+     * The index of the node of each handle
+     */
+    u32 *indices;
+    /**
+     * Whether each node's local transform changed since the last update
+     */
+    bool *dirty;
+    /**
+     * The local transform of each node, as model streams compatible with
+     * harmony_model_matrix_3d()
+     */
+    f32 *position[3];
+    f32 *scale[3];
+    f32 *rotation[4];
+    /**
+     * The world transform of each node
+     */
+    Affine3 *worlds;
+    /**
+     * Scratch for splitting updates across threads
+     */
+    u32 *tasks;
+} HarmonyTransformHierarchy;
+
+/**
+ * Creates an empty transform hierarchy
+ *
+ * Parameters
+ * - allocator The allocator to use, must not be NULL
+ * - capacity The maximum number of nodes
+ * Returns
+ * - The created hierarchy
+ */
+HarmonyTransformHierarchy harmony_transform_hierarchy_create(const HarmonyAllocator *allocator, u32 capacity);
+
+/**
+ * Destroys a transform hierarchy
+ *
+ * Parameters
+ * - allocator The allocator used to create the hierarchy, must not be NULL
+ * - hierarchy The hierarchy to destroy, must not be NULL
+ */
+void harmony_transform_hierarchy_destroy(const HarmonyAllocator *allocator, HarmonyTransformHierarchy *hierarchy);
+
+/**
+ * Adds a node to a transform hierarchy
+ *
+ * Moves the nodes after the parent's subtree, so costs O(count) in the worst
+ * case; the node's world transform is computed by the next update
+ *
+ * Parameters
+ * - hierarchy The hierarchy, must not be NULL, must not be full
+ * - parent The handle of the parent, or HARMONY_TRANSFORM_NONE for a root
+ * - position The local position
+ * - scale The local scale
+ * - rotation The local rotation, which must be normalized
+ * Returns
+ * - The handle of the node
+ */
+u32 harmony_transform_add(
+    HarmonyTransformHierarchy *hierarchy,
+    u32 parent,
+    Vec3 position,
+    Vec3 scale,
+    Quat rotation);
+
+/**
+ * Sets the local transform of a node, marking its subtree for update
+ *
+ * Parameters
+ * - hierarchy The hierarchy, must not be NULL
+ * - handle The handle of the node
+ * - position The local position
+ * - scale The local scale
+ * - rotation The local rotation, which must be normalized
+ */
+void harmony_transform_set(
+    HarmonyTransformHierarchy *hierarchy,
+    u32 handle,
+    Vec3 position,
+    Vec3 scale,
+    Quat rotation);
+
+/**
+ * Gets the world transform of a node, as of the last update
+ *
+ * Parameters
+ * - hierarchy The hierarchy, must not be NULL
+ * - handle The handle of the node
+ * Returns
+ * - The world transform
+ */
+Affine3 harmony_transform_world(const HarmonyTransformHierarchy *hierarchy, u32 handle);
+
+/**
+ * Recomputes the world transforms of every subtree with a changed node
+ *
+ * Parameters
+ * - hierarchy The hierarchy, must not be NULL
+ * Returns
+ * - The number of nodes updated
+ */
+u32 harmony_transform_update(HarmonyTransformHierarchy *hierarchy);
+
+/**
+ * Recomputes changed world transforms, updating independent subtrees on
+ * separate threads
+ *
+ * Gives the same transforms as harmony_transform_update(); the hierarchy is
+ * split below its roots until there are enough subtrees for the threads
+ *
+ * Parameters
+ * - thread_count The number of threads to use
+ * - hierarchy The hierarchy, must not be NULL
+ * Returns
+ * - The number of nodes updated
+ */
+u32 harmony_transform_update_parallel(u32 thread_count, HarmonyTransformHierarchy *hierarchy);
+
+/**
+ * Creates a 3D affine view transform
+ *
+ * Equivalent to harmony_view_matrix(), without the constant last row
+ *
+ * Parameters
+ * - position The position of the camera
+ * - zoom The zoom of the camera
+ * - rotation The rotation of the camera
+ * Returns
+ * - The created transform
+ */
+Affine3 harmony_view_affine(Vec3 position, f32 zoom, Quat rotation);
+
+/**
+ * Creates a view matrix
+ *
+ * Parameters
+ * - position The position of the camera
+ * - zoom The zoom of the camera
+ * - rotation The rotation of the camera
+ * Returns
+ * - The created matrix
+ */
+Mat4 harmony_view_matrix(Vec3 position, f32 zoom, Quat rotation);
+
+/**
+ * Creates an orthographic projection matrix
+ *
+ * Parameters
+ * - left The left-hand side of the view frustum
+ * - right The right-hand side of the view frustum
+ * - top The top of the view frustum
+ * - bottom The bottom of the view frustum
+ * - near The near plane of the view frustum
+ * - far The far plane of the view frustum
+ * Returns
+ * - The created matrix
+ */
+Mat4 harmony_orthographic_projection(f32 left, f32 right, f32 top, f32 bottom, f32 near, f32 far);
+
+/**
+ * Creates a perspective projection matrix
+ *
+ * Parameters
+ * - fov The field of view of the projection in radians
+ * - aspect The aspect ratio of the projection
+ * - near The near plane of the projection, must be greater than 0.0f
+ * - far The far plane of the projection, must be greater than near
+ * Returns
+ * - The created matrix
+ */
+Mat4 harmony_perspective_projection(f32 fov, f32 aspect, f32 near, f32 far);
+
+/**
+ * The six planes bounding a view frustum
+ *
+ * Each plane's xyz is its unit normal, pointing into the frustum, and its w
+ * the offset along it, so that a point p is inside when dot(xyz, p) + w >= 0
+ */
+typedef struct HarmonyFrustum {
+    /**
+     * The left, right, bottom, top, near, and far planes
+     */
+    Vec4 planes[6];
+} HarmonyFrustum;
+
+/**
+ * Extracts the planes of a view frustum from its projection
+ *
+ * Expects the clip space of harmony_perspective_projection() and
+ * harmony_orthographic_projection(), with depth from 0.0f to 1.0f
+ *
+ * Parameters
+ * - view_projection The projection times the view matrix, giving the world
+ *   space frustum, or the projection alone, giving the view space frustum
+ * Returns
+ * - The frustum, with normalized planes
+ */
+HarmonyFrustum harmony_frustum_create(Mat4 view_projection);
+
+/**
+ * Structure of arrays axis aligned bounding boxes
+ *
+ * Each pointer is an array of one component, with one element per box
+ */
+typedef struct HarmonyAabbStreams {
+    /**
+     * The x, y, and z components of each box's minimum corner
+     */
+    f32 *min[3];
+    /**
+     * The x, y, and z components of each box's maximum corner
+     */
+    f32 *max[3];
+} HarmonyAabbStreams;
+
+/**
+ * Structure of arrays bounding spheres
+ *
+ * Each pointer is an array of one component, with one element per sphere
+ */
+typedef struct HarmonySphereStreams {
+    /**
+     * The x, y, and z components of each sphere's center
+     */
+    f32 *center[3];
+    /**
+     * The radius of each sphere
+     */
+    f32 *radius;
+} HarmonySphereStreams;
+
+/**
+ * Tests axis aligned bounding boxes against a frustum in bulk, 8 at a time
+ *
+ * A box is visible unless it is entirely outside one of the planes; boxes
+ * near the frustum's edges may be visible while outside it
+ *
+ * Parameters
+ * - visible The bitmask to write, with (count + 31) / 32 words, bit i % 32
+ *   of word i / 32 being set when box i is visible, must not be NULL
+ * - frustum The frustum, must not be NULL
+ * - src The streams to read count boxes from, must not be NULL
+ * - count The number of boxes
+ */
+void harmony_cull_aabbs(u32 *visible, const HarmonyFrustum *frustum, const HarmonyAabbStreams *src, usize count);
+
+/**
+ * Tests axis aligned bounding boxes against a frustum in bulk, in parallel
+ *
+ * Equivalent to harmony_cull_aabbs(), splitting the boxes between threads in
+ * blocks of 32
+ *
+ * Parameters
+ * - thread_count The number of threads to use
+ * - visible The bitmask to write, must not be NULL
+ * - frustum The frustum, must not be NULL
+ * - src The streams to read count boxes from, must not be NULL
+ * - count The number of boxes
+ */
+void harmony_cull_aabbs_parallel(
+    u32 thread_count,
+    u32 *visible,
+    const HarmonyFrustum *frustum,
+    const HarmonyAabbStreams *src,
+    usize count);
+
+/**
+ * Tests bounding spheres against a frustum in bulk, 8 at a time
+ *
+ * A sphere is visible unless it is entirely outside one of the planes
+ *
+ * Parameters
+ * - visible The bitmask to write, with (count + 31) / 32 words, bit i % 32
+ *   of word i / 32 being set when sphere i is visible, must not be NULL
+ * - frustum The frustum, must not be NULL
+ * - src The streams to read count spheres from, must not be NULL
+ * - count The number of spheres
+ */
+void harmony_cull_spheres(u32 *visible, const HarmonyFrustum *frustum, const HarmonySphereStreams *src, usize count);
+
+/**
+ * Tests bounding spheres against a frustum in bulk, in parallel
+ *
+ * Equivalent to harmony_cull_spheres(), splitting the spheres between
+ * threads in blocks of 32
+ *
+ * Parameters
+ * - thread_count The number of threads to use
+ * - visible The bitmask to write, must not be NULL
+ * - frustum The frustum, must not be NULL
+ * - src The streams to read count spheres from, must not be NULL
+ * - count The number of spheres
+ */
+void harmony_cull_spheres_parallel(
+    u32 thread_count,
+    u32 *visible,
+    const HarmonyFrustum *frustum,
+    const HarmonySphereStreams *src,
+    usize count);
+
+/**
+ * Compacts a visibility bitmask into the indices of the visible objects
+ *
+ * Parameters
+ * - dst The array to write the indices to in increasing order, must not be
+ *   NULL, with space for every visible index, at most count
+ * - visible The bitmask written by the culling functions, must not be NULL
+ * - count The number of objects in the bitmask
+ * Returns
+ * - The number of visible objects written
+ */
+usize harmony_visible_indices(u32 *dst, const u32 *visible, usize count);
+
+/**
+ * Where a ray hit a primitive
+ */
+typedef struct HarmonyRayHit {
+    /**
+     * The distance along the ray, in multiples of its direction
+     */
+    f32 distance;
+    /**
+     * The barycentric coordinates of the hit on a triangle, weighting its
+     * second and third vertices, or 0.0f for boxes
+     */
+    f32 u, v;
+    /**
+     * The index of the primitive hit
+     */
+    u32 index;
+} HarmonyRayHit;
+
+/**
+ * Intersects a ray with a triangle, from either side
+ *
+ * Uses the Moller-Trumbore test, missing triangles parallel to the ray
+ *
+ * Parameters
+ * - origin The origin of the ray
+ * - direction The direction of the ray, need not be normalized
+ * - a, b, c The vertices of the triangle
+ * - max_distance The furthest distance along the ray to hit
+ * - hit Where to write the distance and barycentrics of a hit, must not be
+ *   NULL, the index being left unchanged
+ * Returns
+ * - Whether the ray hit the triangle between 0.0f and max_distance
+ */
+bool harmony_ray_triangle(Vec3 origin, Vec3 direction, Vec3 a, Vec3 b, Vec3 c, f32 max_distance, HarmonyRayHit *hit);
+
+/**
+ * Intersects a ray with a triangle, from either side, without gaps between
+ * triangles sharing an edge
+ *
+ * Uses the watertight test of Woop, Benthin, and Wald, shearing the
+ * triangle into the ray's space and falling back to double precision where
+ * an edge passes exactly through the ray
+ *
+ * Parameters
+ * - origin The origin of the ray
+ * - direction The direction of the ray, need not be normalized
+ * - a, b, c The vertices of the triangle
+ * - max_distance The furthest distance along the ray to hit
+ * - hit Where to write the distance and barycentrics of a hit, must not be
+ *   NULL, the index being left unchanged
+ * Returns
+ * - Whether the ray hit the triangle between 0.0f and max_distance
+ */
+bool harmony_ray_triangle_watertight(
+    Vec3 origin,
+    Vec3 direction,
+    Vec3 a,
+    Vec3 b,
+    Vec3 c,
+    f32 max_distance,
+    HarmonyRayHit *hit);
+
+/**
+ * The intersection tests of the ray packet kernels
+ */
+typedef enum HarmonyRayTest {
+    HARMONY_RAY_TRIANGLE,
+    HARMONY_RAY_TRIANGLE_WATERTIGHT,
+    HARMONY_RAY_AABB,
+} HarmonyRayTest;
+
+/**
+ * Structure of arrays rays
+ *
+ * Each pointer is an array of one component, with one element per ray
+ */
+typedef struct HarmonyRayStreams {
+    /**
+     * The x, y, and z components of each ray's origin
+     */
+    f32 *origin[3];
+    /**
+     * The x, y, and z components of each ray's direction
+     */
+    f32 *direction[3];
+} HarmonyRayStreams;
+
+/**
+ * Structure of arrays triangles
+ *
+ * Each pointer is an array of one component, with one element per triangle
+ */
+typedef struct HarmonyTriangleStreams {
+    /**
+     * The x, y, and z components of each triangle's first vertex
+     */
+    f32 *a[3];
+    /**
+     * The x, y, and z components of each triangle's second vertex
+     */
+    f32 *b[3];
+    /**
+     * The x, y, and z components of each triangle's third vertex
+     */
+    f32 *c[3];
+} HarmonyTriangleStreams;
+
+/**
+ * Structure of arrays ray hits
+ *
+ * Each pointer is an array of one field of HarmonyRayHit, with one element
+ * per ray
+ */
+typedef struct HarmonyRayHitStreams {
+    /**
+     * The distance of each ray's closest hit
+     */
+    f32 *distance;
+    /**
+     * The barycentric coordinates of each ray's closest hit
+     */
+    f32 *u, *v;
+    /**
+     * The index of the primitive each ray hit
+     */
+    u32 *index;
+} HarmonyRayHitStreams;
+
+/**
+ * Intersects rays with triangles in bulk, 8 rays at a time
+ *
+ * Each ray's hit is replaced where a triangle is hit closer than its current
+ * distance, so the distances should start at the furthest to hit, and the
+ * earliest triangle wins between hits at the same distance; gives the same
+ * hits as harmony_ray_triangle()
+ *
+ * Parameters
+ * - hits The hits to update, one for each ray, must not be NULL
+ * - rays The streams to read ray_count rays from, must not be NULL
+ * - ray_count The number of rays
+ * - triangles The streams to read triangle_count triangles from, must not
+ *   be NULL
+ * - triangle_count The number of triangles
+ */
+void harmony_rays_triangles(
+    const HarmonyRayHitStreams *hits,
+    const HarmonyRayStreams *rays,
+    usize ray_count,
+    const HarmonyTriangleStreams *triangles,
+    usize triangle_count);
+
+/**
+ * Intersects rays with triangles in bulk with the watertight test, 8 rays
+ * at a time
+ *
+ * Equivalent to harmony_rays_triangles(), giving the same hits as
+ * harmony_ray_triangle_watertight()
+ *
+ * Parameters
+ * - hits The hits to update, one for each ray, must not be NULL
+ * - rays The streams to read ray_count rays from, must not be NULL
+ * - ray_count The number of rays
+ * - triangles The streams to read triangle_count triangles from, must not
+ *   be NULL
+ * - triangle_count The number of triangles
+ */
+void harmony_rays_triangles_watertight(
+    const HarmonyRayHitStreams *hits,
+    const HarmonyRayStreams *rays,
+    usize ray_count,
+    const HarmonyTriangleStreams *triangles,
+    usize triangle_count);
+
+/**
+ * Intersects rays with axis aligned bounding boxes in bulk with the slab
+ * test, 8 rays at a time
+ *
+ * Each ray's hit is replaced where it enters a box closer than its current
+ * distance, a ray starting inside a box hitting it at 0.0f, and the
+ * barycentrics are set to 0.0f
+ *
+ * Parameters
+ * - hits The hits to update, one for each ray, must not be NULL
+ * - rays The streams to read ray_count rays from, must not be NULL
+ * - ray_count The number of rays
+ * - boxes The streams to read box_count boxes from, must not be NULL
+ * - box_count The number of boxes
+ */
+void harmony_rays_aabbs(
+    const HarmonyRayHitStreams *hits,
+    const HarmonyRayStreams *rays,
+    usize ray_count,
+    const HarmonyAabbStreams *boxes,
+    usize box_count);
+
+/**
+ * Computes the bounding boxes of triangles
+ *
+ * Parameters
+ * - dst The streams to write count boxes to, must not be NULL
+ * - vertices The vertices of the triangles, must not be NULL
+ * - indices Three vertex indices for each triangle, must not be NULL
+ * - count The number of triangles
+ */
+void harmony_triangle_bounds(const HarmonyAabbStreams *dst, const Vec3 *vertices, const u32 *indices, usize count);
+
+/**
+ * The most primitives a bounding volume hierarchy leaf holds, unless they
+ * cannot be split
+ */
+#define HARMONY_BVH_LEAF_SIZE 8
+
+/**
+ * The most nodes on a bounding volume hierarchy traversal stack, bounding
+ * the depth of the tree
+ */
+#define HARMONY_BVH_STACK_SIZE 64
+
+/**
+ * A node in a bounding volume hierarchy, 32 bytes
+ */
+typedef struct HarmonyBvhNode {
+    /**
+     * The minimum corner of the node's bounds
+     */
+    Vec3 min;
+    /**
+     * The index of the first of the two adjacent children of an interior
+     * node, or of the first primitive in a leaf
+     */
+    u32 first;
+    /**
+     * The maximum corner of the node's bounds
+     */
+    Vec3 max;
+    /**
+     * The number of primitives in a leaf, or 0 for an interior node
+     */
+    u32 count;
+} HarmonyBvhNode;
+
+/**
+ * A bounding volume hierarchy over boxes, built with the surface area
+ * heuristic
+ *
+ * The tree refers to primitives by index, the caller keeping their
+ * geometry; parents always precede their children
+ */
+typedef struct HarmonyBvh {
+    /**
+     * The single allocation holding the nodes and primitive indices
+     */
+    void *allocation;
+    /**
+     * The size of the allocation in bytes
+     */
+    usize allocation_size;
+    /**
+     * The nodes, the first being the root
+     */
+    HarmonyBvhNode *nodes;
+    /**
+     * The primitive indices, in leaf order
+     */
+    u32 *primitives;
+    /**
+     * The number of nodes
+     */
+    u32 node_count;
+    /**
+     * The number of primitives
+     */
+    u32 primitive_count;
+} HarmonyBvh;
+
+/**
+ * Builds a bounding volume hierarchy, binning with the surface area
+ * heuristic
+ *
+ * Parameters
+ * - allocator The allocator to use, must not be NULL
+ * - bounds The streams to read the count primitives' boxes from, must not
+ *   be NULL
+ * - count The number of primitives, must be greater than 0
+ * Returns
+ * - The created hierarchy
+ */
+HarmonyBvh harmony_bvh_create(const HarmonyAllocator *allocator, const HarmonyAabbStreams *bounds, u32 count);
+
+/**
+ * Builds a bounding volume hierarchy, in parallel
+ *
+ * Equivalent to harmony_bvh_create(), splitting the top of the tree serially
+ * then building its subtrees on separate threads, giving the same tree for
+ * any thread count
+ *
+ * Parameters
+ * - thread_count The number of threads to use
+ * - allocator The allocator to use, must not be NULL
+ * - bounds The streams to read the count primitives' boxes from, must not
+ *   be NULL
+ * - count The number of primitives, must be greater than 0
+ * Returns
+ * - The created hierarchy
+ */
+HarmonyBvh harmony_bvh_create_parallel(
+    u32 thread_count,
+    const HarmonyAllocator *allocator,
+    const HarmonyAabbStreams *bounds,
+    u32 count);
+
+/**
+ * Destroys a bounding volume hierarchy
+ *
+ * Parameters
+ * - allocator The allocator it was created with, must not be NULL
+ * - bvh The hierarchy to destroy, must not be NULL
+ */
+void harmony_bvh_destroy(const HarmonyAllocator *allocator, HarmonyBvh *bvh);
+
+/**
+ * Recomputes the bounds of every node after primitives moved, keeping the
+ * tree's structure
+ *
+ * The tree stays correct, though slower to traverse as primitives move
+ * further from where it was built
+ *
+ * Parameters
+ * - bvh The hierarchy, must not be NULL
+ * - bounds The streams to read the primitives' new boxes from, must not be
+ *   NULL
+ */
+void harmony_bvh_refit(HarmonyBvh *bvh, const HarmonyAabbStreams *bounds);
+
+/**
+ * Finds the closest triangle a ray hits
+ *
+ * Gives the same hit as testing every triangle with harmony_ray_triangle(),
+ * taking the lowest index between hits at the same distance
+ *
+ * Parameters
+ * - bvh The hierarchy, built over the triangles' bounds, must not be NULL
+ * - vertices The vertices of the triangles, must not be NULL
+ * - indices Three vertex indices for each triangle, must not be NULL
+ * - origin The origin of the ray
+ * - direction The direction of the ray, need not be normalized
+ * - max_distance The furthest distance along the ray to hit
+ * - hit Where to write the closest hit, must not be NULL
+ * Returns
+ * - Whether the ray hit any triangle
+ */
+bool harmony_bvh_ray_triangles(
+    const HarmonyBvh *bvh,
+    const Vec3 *vertices,
+    const u32 *indices,
+    Vec3 origin,
+    Vec3 direction,
+    f32 max_distance,
+    HarmonyRayHit *hit);
+
+/**
+ * Tests whether a ray hits any triangle, stopping at the first hit found
+ *
+ * Parameters
+ * - bvh The hierarchy, built over the triangles' bounds, must not be NULL
+ * - vertices The vertices of the triangles, must not be NULL
+ * - indices Three vertex indices for each triangle, must not be NULL
+ * - origin The origin of the ray
+ * - direction The direction of the ray, need not be normalized
+ * - max_distance The furthest distance along the ray to hit
+ * Returns
+ * - Whether the ray hit any triangle between 0.0f and max_distance
+ */
+bool harmony_bvh_ray_triangles_any(
+    const HarmonyBvh *bvh,
+    const Vec3 *vertices,
+    const u32 *indices,
+    Vec3 origin,
+    Vec3 direction,
+    f32 max_distance);
+
+/**
+ * Finds the closest box a ray hits
+ *
+ * A ray starting inside a box hits it at 0.0f
+ *
+ * Parameters
+ * - bvh The hierarchy, built over the boxes, must not be NULL
+ * - bounds The streams to read the boxes from, must not be NULL
+ * - origin The origin of the ray
+ * - direction The direction of the ray, need not be normalized
+ * - max_distance The furthest distance along the ray to hit
+ * - hit Where to write the closest hit, must not be NULL
+ * Returns
+ * - Whether the ray hit any box
+ */
+bool harmony_bvh_ray_aabbs(
+    const HarmonyBvh *bvh,
+    const HarmonyAabbStreams *bounds,
+    Vec3 origin,
+    Vec3 direction,
+    f32 max_distance,
+    HarmonyRayHit *hit);
+
+/**
+ * Finds the primitives whose boxes overlap a region
+ *
+ * Parameters
+ * - bvh The hierarchy, must not be NULL
+ * - bounds The streams to read the primitives' boxes from, must not be NULL
+ * - min The minimum corner of the region
+ * - max The maximum corner of the region
+ * - dst The array to write overlapping primitive indices to, may be NULL if
+ *   capacity is 0
+ * - capacity The most indices to write
+ * Returns
+ * - The number of overlapping primitives, which may exceed capacity
+ */
+u32 harmony_bvh_overlap(
+    const HarmonyBvh *bvh,
+    const HarmonyAabbStreams *bounds,
+    Vec3 min,
+    Vec3 max,
+    u32 *dst,
+    u32 capacity);
+
+/**
+ * Streams of point positions, one array for each axis
+ */
+typedef struct HarmonyPointStreams {
+    /**
+     * The x, y and z positions
+     */
+    f32 *position[3];
+} HarmonyPointStreams;
+
+/**
+ * Two point indices, the lower first
+ */
+typedef struct HarmonyPair {
+    u32 a;
+    u32 b;
+} HarmonyPair;
+
+/**
+ * The number of ranges harmony_hash_grid_pairs_parallel() splits the grid's
+ * entries into
+ */
+#define HARMONY_HASH_GRID_TASK_COUNT 256
+
+/**
+ * A uniform grid of cubic cells over points, hashing each cell into a
+ * bucket so space is unbounded
+ *
+ * The entries are sorted by bucket with a counting sort, keeping a copy of
+ * their positions in the same order, so a rebuild is linear in the number of
+ * points and queries read memory in order
+ *
+ * Cell coordinates are clamped to 2^20 cells either side of the origin
+ */
+typedef struct HarmonyHashGrid {
+    /**
+     * The single allocation holding every array
+     */
+    void *allocation;
+    /**
+     * The size of the allocation in bytes
+     */
+    usize allocation_size;
+    /**
+     * Where each bucket's entries begin, with one past the last bucket
+     */
+    u32 *bucket_starts;
+    /**
+     * The point index of each entry
+     */
+    u32 *entries;
+    /**
+     * The packed cell coordinates of each entry
+     */
+    u64 *cells;
+    /**
+     * The x, y and z positions of each entry
+     */
+    f32 *positions[3];
+    /**
+     * The bucket of each point, used while building
+     */
+    u32 *buckets;
+    /**
+     * The edge length of each cell
+     */
+    f32 cell_size;
+    /**
+     * The number of buckets, a power of two
+     */
+    u32 bucket_count;
+    /**
+     * The most points the grid can hold
+     */
+    u32 capacity;
+    /**
+     * The number of points in the grid
+     */
+    u32 count;
+} HarmonyHashGrid;
+
+/**
+ * Creates an empty spatial hash grid
+ *
+ * Parameters
+ * - allocator The allocator to use, must not be NULL
+ * - capacity The most points the grid can hold
+ * - cell_size The edge length of each cell, must be greater than 0.0f,
+ *   ideally the largest radius pairs are found within
+ * Returns
+ * - The created grid
+ */
+HarmonyHashGrid harmony_hash_grid_create(const HarmonyAllocator *allocator, u32 capacity, f32 cell_size);
+
+/**
+ * Destroys a spatial hash grid
+ *
+ * Parameters
+ * - allocator The allocator it was created with, must not be NULL
+ * - grid The grid to destroy, must not be NULL
+ */
+void harmony_hash_grid_destroy(const HarmonyAllocator *allocator, HarmonyHashGrid *grid);
+
+/**
+ * Rebuilds a spatial hash grid over points, replacing its previous points
+ *
+ * Parameters
+ * - grid The grid, must not be NULL
+ * - points The streams to read the points from, must not be NULL
+ * - count The number of points, must not exceed the grid's capacity
+ */
+void harmony_hash_grid_build(HarmonyHashGrid *grid, const HarmonyPointStreams *points, u32 count);
+
+/**
+ * Finds the points within a distance of a position
+ *
+ * Parameters
+ * - grid The grid, must not be NULL
+ * - center The position to search around
+ * - radius The furthest distance to find points at
+ * - dst The array to write point indices to, may be NULL if capacity is 0
+ * - capacity The most indices to write
+ * Returns
+ * - The number of points found, which may exceed capacity
+ */
+u32 harmony_hash_grid_query_sphere(const HarmonyHashGrid *grid, Vec3 center, f32 radius, u32 *dst, u32 capacity);
+
+/**
+ * Finds the points inside a box
+ *
+ * Parameters
+ * - grid The grid, must not be NULL
+ * - min The minimum corner of the box
+ * - max The maximum corner of the box
+ * - dst The array to write point indices to, may be NULL if capacity is 0
+ * - capacity The most indices to write
+ * Returns
+ * - The number of points found, which may exceed capacity
+ */
+u32 harmony_hash_grid_query_aabb(const HarmonyHashGrid *grid, Vec3 min, Vec3 max, u32 *dst, u32 capacity);
+
+/**
+ * Finds every pair of points within a distance of each other
+ *
+ * Each pair is found once, in an order which depends only on the points
+ *
+ * Parameters
+ * - grid The grid, must not be NULL
+ * - radius The furthest distance between paired points, must not exceed
+ *   the grid's cell size
+ * - dst The array to write pairs to, may be NULL if capacity is 0
+ * - capacity The most pairs to write
+ * Returns
+ * - The number of pairs found, which may exceed capacity
+ */
+u32 harmony_hash_grid_pairs(const HarmonyHashGrid *grid, f32 radius, HarmonyPair *dst, u32 capacity);
+
+/**
+ * Finds every pair of points within a distance of each other, in parallel
+ *
+ * Counts the pairs in each range of cells, then writes them, giving the
+ * same pairs in the same order as harmony_hash_grid_pairs()
+ *
+ * Parameters
+ * - thread_count The number of threads to use
+ * - grid The grid, must not be NULL
+ * - radius The furthest distance between paired points, must not exceed
+ *   the grid's cell size
+ * - dst The array to write pairs to, may be NULL if capacity is 0
+ * - capacity The most pairs to write
+ * Returns
+ * - The number of pairs found, which may exceed capacity
+ */
+u32 harmony_hash_grid_pairs_parallel(
+    u32 thread_count,
+    const HarmonyHashGrid *grid,
+    f32 radius,
+    HarmonyPair *dst,
+    u32 capacity);
+
+/**
+ * The kinds of convex shape collision is tested between
+ */
+typedef enum HarmonyShapeType {
+    HARMONY_SHAPE_SPHERE,
+    HARMONY_SHAPE_CAPSULE,
+    HARMONY_SHAPE_BOX,
+    HARMONY_SHAPE_HULL,
+} HarmonyShapeType;
+
+/**
+ * A convex shape in its own space, centered on the origin
+ */
+typedef struct HarmonyShape {
+    /**
+     * The kind of shape, selecting which of the fields are used
+     */
+    HarmonyShapeType type;
+    /**
+     * The radius of a sphere or capsule
+     */
+    f32 radius;
+    /**
+     * Half the distance between a capsule's end centers, along its y axis
+     */
+    f32 half_height;
+    /**
+     * Half the size of a box along each axis
+     */
+    Vec3 half_extents;
+    /**
+     * The vertices of a convex hull, each on the hull's boundary
+     */
+    const Vec3 *vertices;
+    /**
+     * The number of vertices of a convex hull, must be greater than 0
+     */
+    u32 vertex_count;
+} HarmonyShape;
+
+/**
+ * A shape placed in the world
+ */
+typedef struct HarmonyCollider {
+    /**
+     * The shape, must not be NULL
+     */
+    const HarmonyShape *shape;
+    /**
+     * The position of the shape's origin
+     */
+    Vec3 position;
+    /**
+     * The rotation of the shape, must be normalized
+     */
+    Quat rotation;
+} HarmonyCollider;
+
+/**
+ * The closest points between two colliders, or their deepest points when
+ * they overlap
+ */
+typedef struct HarmonySeparation {
+    /**
+     * The unit direction from the first collider to the second
+     */
+    Vec3 normal;
+    /**
+     * The distance between the colliders, negative by the penetration depth
+     * when they overlap
+     */
+    f32 distance;
+    /**
+     * The point on the first collider
+     */
+    Vec3 point_a;
+    /**
+     * The point on the second collider
+     */
+    Vec3 point_b;
+} HarmonySeparation;
+
+/**
+ * The most points a contact manifold holds
+ */
+#define HARMONY_MANIFOLD_MAX_POINTS 4
+
+/**
+ * The contact between two overlapping colliders
+ */
+typedef struct HarmonyManifold {
+    /**
+     * The unit direction from the first collider to the second
+     */
+    Vec3 normal;
+    /**
+     * The number of contact points, 0 when the colliders do not overlap
+     */
+    u32 point_count;
+    /**
+     * The contact points, halfway between the colliders' surfaces
+     */
+    Vec3 points[HARMONY_MANIFOLD_MAX_POINTS];
+    /**
+     * The penetration depth at each contact point
+     */
+    f32 depths[HARMONY_MANIFOLD_MAX_POINTS];
+} HarmonyManifold;
+
+/**
+ * Tests whether two colliders overlap using GJK, stopping as soon as a
+ * separating direction is found
+ *
+ * Parameters
+ * - a The first collider, must not be NULL
+ * - b The second collider, must not be NULL
+ * Returns
+ * - Whether the colliders overlap
+ */
+bool harmony_gjk_intersect(const HarmonyCollider *a, const HarmonyCollider *b);
+
+/**
+ * Finds the distance and closest points between two colliders using GJK,
+ * or the penetration depth and deepest points using EPA when they overlap
+ *
+ * Spheres and capsules are handled as a point or segment with a radius, so
+ * their overlaps only need EPA when their cores overlap
+ *
+ * Parameters
+ * - a The first collider, must not be NULL
+ * - b The second collider, must not be NULL
+ * - dst Where to write the separation, must not be NULL
+ * Returns
+ * - Whether the colliders overlap
+ */
+bool harmony_gjk_epa(const HarmonyCollider *a, const HarmonyCollider *b, HarmonySeparation *dst);
+
+/**
+ * Finds the contact manifold between two colliders
+ *
+ * Flat faces touching give up to HARMONY_MANIFOLD_MAX_POINTS points, found
+ * by clipping the faces against each other, otherwise one point is given
+ *
+ * Parameters
+ * - a The first collider, must not be NULL
+ * - b The second collider, must not be NULL
+ * - dst Where to write the manifold, must not be NULL
+ * Returns
+ * - Whether the colliders overlap
+ */
+bool harmony_collide(const HarmonyCollider *a, const HarmonyCollider *b, HarmonyManifold *dst);
+
+/**
+ * Finds the contact manifolds of a batch of pairs, such as those found by a
+ * broad phase
+ *
+ * Parameters
+ * - dst The array to write one manifold for each pair to, must not be NULL
+ * - colliders The colliders the pairs index, must not be NULL
+ * - pairs The pairs of colliders to test, must not be NULL
+ * - count The number of pairs
+ * Returns
+ * - The number of pairs which overlap
+ */
+u32 harmony_collide_pairs(HarmonyManifold *dst, const HarmonyCollider *colliders, const HarmonyPair *pairs, u32 count);
+
+/**
+ * Finds the contact manifolds of a batch of pairs, in parallel
+ *
+ * Parameters
+ * - thread_count The number of threads to use
+ * - dst The array to write one manifold for each pair to, must not be NULL
+ * - colliders The colliders the pairs index, must not be NULL
+ * - pairs The pairs of colliders to test, must not be NULL
+ * - count The number of pairs
+ * Returns
+ * - The number of pairs which overlap
+ */
+u32 harmony_collide_pairs_parallel(
+    u32 thread_count,
+    HarmonyManifold *dst,
+    const HarmonyCollider *colliders,
+    const HarmonyPair *pairs,
+    u32 count);
+
+/**
+ * Streams of rigid body state, one array for each component
+ */
+typedef struct HarmonyBodyStreams {
+    /**
+     * The x, y and z positions of the centers of mass
+     */
+    f32 *position[3];
+    /**
+     * The r, i, j and k components of the orientations
+     */
+    f32 *orientation[4];
+    /**
+     * The x, y and z linear velocities
+     */
+    f32 *velocity[3];
+    /**
+     * The x, y and z angular velocities, in world space
+     */
+    f32 *angular_velocity[3];
+    /**
+     * The inverse masses, 0.0f for static bodies
+     */
+    f32 *inverse_mass;
+    /**
+     * The inverses of the principal moments of inertia, along the body's
+     * own axes
+     */
+    f32 *inverse_inertia[3];
+    /**
+     * How long each body has been moving slowly enough to sleep, in seconds
+     */
+    f32 *sleep_time;
+    /**
+     * Whether each body is simulated, false while its island sleeps
+     */
+    u8 *awake;
+} HarmonyBodyStreams;
+
+/**
+ * A ball and socket joint, holding a point on each of two bodies together
+ */
+typedef struct HarmonyJoint {
+    /**
+     * The first body
+     */
+    u32 a;
+    /**
+     * The second body
+     */
+    u32 b;
+    /**
+     * The joint's position in the first body's space
+     */
+    Vec3 anchor_a;
+    /**
+     * The joint's position in the second body's space
+     */
+    Vec3 anchor_b;
+} HarmonyJoint;
+
+/**
+ * The solver's state for one contact point or joint
+ */
+typedef struct HarmonyConstraint {
+    /**
+     * The first body
+     */
+    u32 a;
+    /**
+     * The second body
+     */
+    u32 b;
+    /**
+     * The point from the first body's center of mass
+     */
+    Vec3 offset_a;
+    /**
+     * The point from the second body's center of mass
+     */
+    Vec3 offset_b;
+    /**
+     * The contact normal, from the first body to the second
+     */
+    Vec3 normal;
+    /**
+     * The two friction directions, perpendicular to the normal
+     */
+    Vec3 tangents[2];
+    /**
+     * The effective mass along the normal
+     */
+    f32 normal_mass;
+    /**
+     * The effective mass along each friction direction
+     */
+    f32 tangent_mass[2];
+    /**
+     * The impulse applied along the normal so far this step
+     */
+    f32 normal_impulse;
+    /**
+     * The impulse applied along each friction direction so far this step
+     */
+    f32 tangent_impulse[2];
+    /**
+     * The separating speed pushing the bodies out of penetration
+     */
+    f32 bias;
+    /**
+     * The index of the joint, or UINT32_MAX for a contact
+     */
+    u32 joint;
+    /**
+     * The inverse of the joint's effective mass matrix
+     */
+    Mat3 joint_mass;
+    /**
+     * The velocity pulling the joint's points back together
+     */
+    Vec3 joint_bias;
+    /**
+     * The impulse applied to the joint so far this step
+     */
+    Vec3 joint_impulse;
+} HarmonyConstraint;
+
+/**
+ * The impulses a contact point ended a step with, to start the next step's
+ * solve from
+ */
+typedef struct HarmonyCachedContact {
+    /**
+     * The pair of bodies, the first in the upper 32 bits
+     */
+    u64 key;
+    /**
+     * The point in the first body's space
+     */
+    Vec3 point;
+    /**
+     * The impulse along the normal
+     */
+    f32 normal_impulse;
+    /**
+     * The impulse along each friction direction
+     */
+    f32 tangent_impulse[2];
+} HarmonyCachedContact;
+
+/**
+ * The most colors constraints are split into, the last holding any which
+ * did not fit in the others and being solved serially
+ */
+#define HARMONY_PHYSICS_COLORS 64
+
+/**
+ * A world of rigid bodies, stepped with semi-implicit Euler integration and
+ * a sequential impulse solver
+ *
+ * Constraints are colored so no two of a color share a moving body, letting
+ * each color be solved in parallel, and start from the impulses they ended
+ * the previous step with, matched by body pair and contact point. Bodies
+ * connected by contacts or joints form islands, which sleep once all their
+ * bodies have been slow for HARMONY_PHYSICS_SLEEP_TIME
+ */
+typedef struct HarmonyPhysics {
+    /**
+     * The single allocation holding every array
+     */
+    void *allocation;
+    /**
+     * The size of the allocation in bytes
+     */
+    usize allocation_size;
+    /**
+     * The state of each body
+     */
+    HarmonyBodyStreams bodies;
+    /**
+     * The island of each body after a step, the lowest index of the bodies
+     * in it, or UINT32_MAX for static bodies
+     */
+    u32 *islands;
+    /**
+     * The joints
+     */
+    HarmonyJoint *joints;
+    /**
+     * The constraints of the last step, ordered by color
+     */
+    HarmonyConstraint *constraints;
+    /**
+     * The contact impulses of the last step, ordered by key
+     */
+    HarmonyCachedContact *contact_cache;
+    /**
+     * The impulse each joint ended the last step with
+     */
+    Vec3 *joint_impulses;
+    /**
+     * The world space inverse inertia of each body
+     */
+    Mat3 *inverse_inertia;
+    /**
+     * The colors used by each body's constraints
+     */
+    u64 *color_masks;
+    /**
+     * The color of each constraint
+     */
+    u32 *colors;
+    /**
+     * The lowest sleep time in each island, indexed by its lowest body
+     */
+    f32 *island_sleep;
+    /**
+     * Where each color's constraints begin, with one past the last color
+     */
+    u32 color_starts[HARMONY_PHYSICS_COLORS + 1];
+    /**
+     * The acceleration of gravity
+     */
+    Vec3 gravity;
+    /**
+     * The friction coefficient of every contact
+     */
+    f32 friction;
+    /**
+     * The number of solver iterations each step
+     */
+    u32 iterations;
+    /**
+     * The number of bodies
+     */
+    u32 body_count;
+    /**
+     * The most bodies the world can hold
+     */
+    u32 body_capacity;
+    /**
+     * The number of joints
+     */
+    u32 joint_count;
+    /**
+     * The most joints the world can hold
+     */
+    u32 joint_capacity;
+    /**
+     * The number of constraints in the last step
+     */
+    u32 constraint_count;
+    /**
+     * The number of contacts in the cache
+     */
+    u32 contact_cache_count;
+    /**
+     * The most contact points a step can take
+     */
+    u32 contact_capacity;
+} HarmonyPhysics;
+
+/**
+ * How long, in seconds, an island's bodies must be slow before it sleeps
+ */
+#define HARMONY_PHYSICS_SLEEP_TIME 0.5f
+
+/**
+ * Creates an empty physics world, with gravity along negative y
+ *
+ * Parameters
+ * - allocator The allocator to use, must not be NULL
+ * - body_capacity The most bodies the world can hold
+ * - joint_capacity The most joints the world can hold
+ * - contact_capacity The most contact points a step can take
+ * Returns
+ * - The created world
+ */
+HarmonyPhysics harmony_physics_create(
+    const HarmonyAllocator *allocator,
+    u32 body_capacity,
+    u32 joint_capacity,
+    u32 contact_capacity);
+
+/**
+ * Destroys a physics world
+ *
+ * Parameters
+ * - allocator The allocator it was created with, must not be NULL
+ * - physics The world to destroy, must not be NULL
+ */
+void harmony_physics_destroy(const HarmonyAllocator *allocator, HarmonyPhysics *physics);
+
+/**
+ * Adds a body to a physics world, at rest and awake
+ *
+ * Parameters
+ * - physics The world, must not be NULL, and must have room for the body
+ * - position The position of the body's center of mass
+ * - orientation The orientation of the body, must be normalized
+ * - mass The mass of the body, 0.0f for a static body
+ * - inertia The principal moments of inertia along the body's axes, such
+ *   as from harmony_box_inertia(), ignored for static bodies
+ * Returns
+ * - The index of the body
+ */
+u32 harmony_physics_add_body(HarmonyPhysics *physics, Vec3 position, Quat orientation, f32 mass, Vec3 inertia);
+
+/**
+ * Adds a ball and socket joint between two bodies
+ *
+ * Parameters
+ * - physics The world, must not be NULL, and must have room for the joint
+ * - a The first body
+ * - b The second body
+ * - anchor The joint's position in world space, in the bodies' current
+ *   placement
+ * Returns
+ * - The index of the joint
+ */
+u32 harmony_physics_add_joint(HarmonyPhysics *physics, u32 a, u32 b, Vec3 anchor);
+
+/**
+ * Wakes a body and its island, such as after moving it or changing its
+ * velocity
+ *
+ * Parameters
+ * - physics The world, must not be NULL
+ * - body The body to wake
+ */
+void harmony_physics_wake(HarmonyPhysics *physics, u32 body);
+
+/**
+ * Computes the principal moments of inertia of a solid box
+ *
+ * Parameters
+ * - mass The mass of the box
+ * - half_extents Half the size of the box along each axis
+ * Returns
+ * - The moments of inertia along the box's axes
+ */
+Vec3 harmony_box_inertia(f32 mass, Vec3 half_extents);
+
+/**
+ * Computes the principal moments of inertia of a solid sphere
+ *
+ * Parameters
+ * - mass The mass of the sphere
+ * - radius The radius of the sphere
+ * Returns
+ * - The moments of inertia along each axis
+ */
+Vec3 harmony_sphere_inertia(f32 mass, f32 radius);
+
+/**
+ * Adds gravity to the velocities of awake, moving bodies
+ *
+ * Parameters
+ * - bodies The bodies, must not be NULL
+ * - count The number of bodies
+ * - gravity The acceleration of gravity
+ * - dt The time step in seconds
+ */
+void harmony_bodies_integrate_velocities(const HarmonyBodyStreams *bodies, usize count, Vec3 gravity, f32 dt);
+
+/**
+ * Moves and turns awake, moving bodies by their velocities, renormalizing
+ * their orientations
+ *
+ * Parameters
+ * - bodies The bodies, must not be NULL
+ * - count The number of bodies
+ * - dt The time step in seconds
+ */
+void harmony_bodies_integrate_positions(const HarmonyBodyStreams *bodies, usize count, f32 dt);
+
+/**
+ * Steps a physics world
+ *
+ * Wakes and sleeps islands, adds gravity, solves the contacts and joints,
+ * then integrates the bodies. The manifolds are typically found from the
+ * bodies' current placement with harmony_collide_pairs()
+ *
+ * Parameters
+ * - thread_count The number of threads to solve each color with
+ * - physics The world, must not be NULL
+ * - pairs The pairs of bodies in contact, may be NULL if pair_count is 0
+ * - manifolds The contact manifold of each pair, its normal pointing from
+ *   the first body to the second, may be NULL if pair_count is 0
+ * - pair_count The number of pairs
+ * - dt The time step in seconds, must be greater than 0.0f
+ */
+void harmony_physics_step(
+    u32 thread_count,
+    HarmonyPhysics *physics,
+    const HarmonyPair *pairs,
+    const HarmonyManifold *manifolds,
+    u32 pair_count,
+    f32 dt);
+
+/**
+ * The number of samples a particle curve is baked to, evenly spaced over a
+ * particle's life
+ */
+#define HARMONY_PARTICLE_CURVE_SAMPLES 32
+
+/**
+ * A parameter over a particle's life, baked to a table sampled linearly
+ */
+typedef struct HarmonyParticleCurve {
+    /**
+     * The value at each sample, the first at birth and the last at death
+     */
+    f32 samples[HARMONY_PARTICLE_CURVE_SAMPLES];
+} HarmonyParticleCurve;
+
+/**
+ * The curves driving particles' appearance over their lives
+ */
+typedef struct HarmonyParticleCurves {
+    /**
+     * The size of each particle
+     */
+    HarmonyParticleCurve size;
+    /**
+     * The red, green, blue and alpha of each particle, clamped to [0, 1]
+     */
+    HarmonyParticleCurve color[4];
+} HarmonyParticleCurves;
+
+/**
+ * Streams of particle state, one array for each component
+ */
+typedef struct HarmonyParticleStreams {
+    /**
+     * The x, y and z positions
+     */
+    f32 *position[3];
+    /**
+     * The x, y and z velocities
+     */
+    f32 *velocity[3];
+    /**
+     * The time since each particle was emitted, in seconds
+     */
+    f32 *age;
+    /**
+     * The inverse of each particle's lifetime in seconds
+     */
+    f32 *inverse_lifetime;
+    /**
+     * The size from the size curve
+     */
+    f32 *size;
+    /**
+     * The color from the color curves, as 8 bit red, green, blue and alpha
+     * from the lowest byte up
+     */
+    u32 *color;
+} HarmonyParticleStreams;
+
+/**
+ * The vertex of one particle, laid out to be bound as an instance rate
+ * vertex buffer
+ *
+ * The attributes are the position as VK_FORMAT_R32G32B32_SFLOAT at offset
+ * 0, the size as VK_FORMAT_R32_SFLOAT at offset 12, and the color as
+ * VK_FORMAT_R8G8B8A8_UNORM at offset 16, with a stride of
+ * sizeof(HarmonyParticleVertex)
+ */
+typedef struct HarmonyParticleVertex {
+    Vec3 position;
+    f32 size;
+    u32 color;
+} HarmonyParticleVertex;
+
+/**
+ * Where and how particles are emitted, each value picked uniformly within
+ * its spread
+ */
+typedef struct HarmonyParticleEmitter {
+    /**
+     * The center of the box particles start in
+     */
+    Vec3 position;
+    /**
+     * Half the size of the box particles start in
+     */
+    Vec3 position_spread;
+    /**
+     * The mean starting velocity
+     */
+    Vec3 velocity;
+    /**
+     * The most each component of the starting velocity differs from the mean
+     */
+    Vec3 velocity_spread;
+    /**
+     * The shortest lifetime in seconds, must be greater than 0.0f
+     */
+    f32 min_lifetime;
+    /**
+     * The longest lifetime in seconds, at least min_lifetime
+     */
+    f32 max_lifetime;
+} HarmonyParticleEmitter;
+
+/**
+ * The number of ranges parallel particle updates and sorts are split into
+ */
+#define HARMONY_PARTICLE_TASK_COUNT 64
+
+/**
+ * A pool of particles, kept in emission order with dead particles removed
+ */
+typedef struct HarmonyParticles {
+    /**
+     * The single allocation holding every array
+     */
+    void *allocation;
+    /**
+     * The size of the allocation in bytes
+     */
+    usize allocation_size;
+    /**
+     * The state of each particle
+     */
+    HarmonyParticleStreams streams;
+    /**
+     * The particles from back to front after harmony_particles_sort()
+     */
+    u32 *order;
+    /**
+     * Scratch for sorting
+     */
+    u32 *keys[2];
+    /**
+     * Scratch for sorting
+     */
+    u32 *indices;
+    /**
+     * The digit counts of each sort range
+     */
+    u32 *histograms;
+    /**
+     * The curves giving each particle's size and color
+     */
+    HarmonyParticleCurves curves;
+    /**
+     * The acceleration of gravity
+     */
+    Vec3 gravity;
+    /**
+     * How quickly velocity is lost, per second
+     */
+    f32 drag;
+    /**
+     * The number of live particles
+     */
+    u32 count;
+    /**
+     * The most particles the pool can hold
+     */
+    u32 capacity;
+} HarmonyParticles;
+
+/**
+ * Bakes a curve from linearly interpolated keys
+ *
+ * Parameters
+ * - dst The curve to write, must not be NULL
+ * - times The time of each key over the particle's life, from 0.0f at birth
+ *   to 1.0f at death, increasing, must not be NULL
+ * - values The value of each key, must not be NULL
+ * - count The number of keys, must be greater than 0, values before the
+ *   first key and after the last are held
+ */
+void harmony_particle_curve(HarmonyParticleCurve *dst, const f32 *times, const f32 *values, u32 count);
+
+/**
+ * Creates an empty particle pool, with no gravity or drag, and white
+ * particles of size 1.0f
+ *
+ * Parameters
+ * - allocator The allocator to use, must not be NULL
+ * - capacity The most particles the pool can hold
+ * Returns
+ * - The created pool
+ */
+HarmonyParticles harmony_particles_create(const HarmonyAllocator *allocator, u32 capacity);
+
+/**
+ * Destroys a particle pool
+ *
+ * Parameters
+ * - allocator The allocator it was created with, must not be NULL
+ * - particles The pool to destroy, must not be NULL
+ */
+void harmony_particles_destroy(const HarmonyAllocator *allocator, HarmonyParticles *particles);
+
+/**
+ * Emits particles at the end of a pool
+ *
+ * Particles are generated in blocks, each from its own generator seeded
+ * from a hash of the seed and the block, so the result does not depend on
+ * the number of threads, and different seeds give unrelated particles
+ *
+ * Parameters
+ * - thread_count The number of threads to use
+ * - particles The pool, must not be NULL
+ * - emitter How to emit the particles, must not be NULL
+ * - count The number of particles to emit, fewer if the pool fills
+ * - seed The seed of the random values
+ * Returns
+ * - The number of particles emitted
+ */
+u32 harmony_particles_emit(
+    u32 thread_count,
+    HarmonyParticles *particles,
+    const HarmonyParticleEmitter *emitter,
+    u32 count,
+    u64 seed);
+
+/**
+ * Advances every particle, removing those past their lifetime while keeping
+ * the rest in order, and evaluating the size and color curves
+ *
+ * Velocities gain gravity then lose drag implicitly, before moving the
+ * positions
+ *
+ * Parameters
+ * - thread_count The number of threads to use
+ * - particles The pool, must not be NULL
+ * - dt The time step in seconds
+ */
+void harmony_particles_update(u32 thread_count, HarmonyParticles *particles, f32 dt);
+
+/**
+ * Sorts the particles from back to front for alpha blending, by their
+ * distance from the eye, using a stable radix sort
+ *
+ * Parameters
+ * - thread_count The number of threads to use
+ * - particles The pool, must not be NULL, its order is written
+ * - eye The position of the camera
+ */
+void harmony_particles_sort(u32 thread_count, HarmonyParticles *particles, Vec3 eye);
+
+/**
+ * Writes the vertices of every particle, such as to mapped memory of a
+ * buffer bound with harmony_vk_bind_vertex_buffers()
+ *
+ * Parameters
+ * - dst The array to write count vertices to, must not be NULL
+ * - particles The pool, must not be NULL
+ * - order The order to write the particles in, such as particles->order
+ *   after harmony_particles_sort(), or NULL for the pool's order
+ */
+void harmony_particles_write_vertices(HarmonyParticleVertex *dst, const HarmonyParticles *particles, const u32 *order);
+
+/**
+ * Instruction set extensions supported by the CPU and operating system
+ */
+typedef enum HarmonyCpuFeature {
+    HARMONY_CPU_SSE2 = 1 << 0,
+    HARMONY_CPU_SSE41 = 1 << 1,
+    HARMONY_CPU_SSE42 = 1 << 2,
+    HARMONY_CPU_AVX = 1 << 3,
+    HARMONY_CPU_AVX2 = 1 << 4,
+    HARMONY_CPU_FMA = 1 << 5,
+    HARMONY_CPU_AVX512F = 1 << 6,
+} HarmonyCpuFeature;
+
+/**
+ * Queries the instruction set extensions available at runtime
+ *
+ * Uses cpuid on x86-64, and reports no features on other architectures
+ *
+ * Returns
+ * - A bitmask of HarmonyCpuFeature flags
+ */
+u32 harmony_cpu_features(void);
+
+/**
+ * A level of instruction set support which kernels are implemented for
+ *
+ * The AVX512 tier only has its own copy kernel, every other kernel in it is
+ * the AVX2 one
+ */
+typedef enum HarmonyCpuTier {
+    HARMONY_CPU_TIER_SCALAR = 0,
+    HARMONY_CPU_TIER_SSE2,
+    HARMONY_CPU_TIER_AVX2,
+    HARMONY_CPU_TIER_AVX512,
+    HARMONY_CPU_TIER_COUNT,
+} HarmonyCpuTier;
+
+/**
+ * Gets the highest kernel tier the CPU supports
+ *
+ * Returns
+ * - The highest supported tier
+ */
+HarmonyCpuTier harmony_cpu_best_tier(void);
+
+/**
+ * Hot kernels with implementations selected at runtime
+ *
+ * Every tier evaluates the same operations in the same order as the scalar
+ * kernels, so the results are identical whichever tier is selected
+ */
+typedef struct HarmonyKernels {
+    /**
+     * The tier the kernels were selected for
+     */
+    HarmonyCpuTier tier;
+    /**
+     * Copies size bytes, bypassing the cache for large copies
+     */
+    void (*copy)(void *dst, const void *src, usize size);
+    /**
+     * Mixes count samples of src, scaled by gain, into dst
+     */
+    void (*mix)(f32 *dst, const f32 *src, f32 gain, usize count);
+    /**
+     * Builds count 2D model matrices from structure of arrays streams
+     */
+    void (*model_matrices_2d)(Mat4 *dst, const HarmonyModelStreams2D *src, usize count);
+    /**
+     * Builds count 3D model matrices from structure of arrays streams
+     */
+    void (*model_matrices_3d)(Mat4 *dst, const HarmonyModelStreams3D *src, usize count);
+    /**
+     * Generates count * HARMONY_RANDOM_LANES random values, lane interleaved
+     */
+    void (*random)(HarmonyRandom *rng, u64 *dst, usize count);
+    /**
+     * Accumulates count 64 byte stripes into the 8 hash accumulators, the
+     * key material advancing one word for each stripe
+     */
+    void (*hash_stripes)(u64 *acc, const u8 *data, const u64 *secret, usize count);
+    /**
+     * Samples one octave of noise at count points, given as one array for
+     * each of the dimensions
+     */
+    void (*noise)(f32 *dst, const f32 *const *points, usize count, u32 seed, u32 dimensions, HarmonyNoiseType type);
+    /**
+     * Computes one radix pass of an FFT, from l1 * radix * ido values in src
+     * to dst; roots holds the radix roots of unity used by generic passes
+     */
+    void (*fft_pass)(
+        Complex *dst,
+        const Complex *src,
+        const Complex *twiddles,
+        const Complex *roots,
+        u32 radix,
+        usize l1,
+        usize ido,
+        bool inverse);
+    /**
+     * Computes an approximate function of count values, dst2 and src2 being
+     * the cosines for sincos and the x coordinates for atan2
+     */
+    void (*approx)(f32 *dst, f32 *dst2, const f32 *src, const f32 *src2, usize count, HarmonyApproxFunction function);
+    /**
+     * Normalizes count quaternions
+     */
+    void (*quat_normalize)(const HarmonyQuatStreams *dst, const HarmonyQuatStreams *src, usize count);
+    /**
+     * Interpolates count quaternions along the shortest path, spherically or
+     * linearly then normalized
+     */
+    void (*quat_blend)(
+        const HarmonyQuatStreams *dst,
+        const HarmonyQuatStreams *lhs,
+        const HarmonyQuatStreams *rhs,
+        const f32 *t,
+        usize count,
+        bool spherical);
+    /**
+     * Builds count rotation matrices, as Affine3 with scales and positions
+     * when affine is set, or as Mat3 ignoring them
+     */
+    void (*rotation_matrices)(f32 *dst, const HarmonyModelStreams3D *src, usize count, bool affine);
+    /**
+     * Tests count boxes, as 3 minimum then 3 maximum streams, or count
+     * spheres, as 3 center streams and a radius stream, against 6 planes,
+     * writing whole words of the visibility bitmask
+     */
+    void (*cull)(u32 *visible, const Vec4 *planes, const f32 *const *bounds, usize count, bool spheres);
+    /**
+     * Intersects count rays with primitive_count triangles, as 9 streams of
+     * vertex components, or boxes, as 3 minimum then 3 maximum streams,
+     * keeping each ray's closest hit
+     */
+    void (*ray_packets)(
+        const HarmonyRayHitStreams *hits,
+        const HarmonyRayStreams *rays,
+        usize count,
+        const f32 *const *primitives,
+        usize primitive_count,
+        HarmonyRayTest test);
+    /**
+     * Adds gravity to the velocities of count bodies, or moves and turns
+     * them by their velocities when positions is set, skipping bodies which
+     * are asleep or static
+     */
+    void (*integrate_bodies)(const HarmonyBodyStreams *bodies, usize count, Vec3 gravity, f32 dt, bool positions);
+    /**
+     * Advances count particles, evaluating their curves, and packs those
+     * still alive to the front in order, returning how many there are
+     */
+    usize (*update_particles)(
+        const HarmonyParticleStreams *particles,
+        usize count,
+        const HarmonyParticleCurves *curves,
+        Vec3 gravity,
+        f32 drag,
+        f32 dt);
+} HarmonyKernels;
+
+/**
+ * Gets the kernel dispatch table
+ *
+ * The best tier supported by the CPU is selected on the first call, unless a
+ * tier was already chosen with harmony_kernels_select()
+ *
+ * Returns
+ * - The dispatch table, never NULL
+ */
+const HarmonyKernels *harmony_kernels(void);
+
+/**
+ * Forces the kernel dispatch table to use a tier
+ *
+ * The table is switched atomically; kernels already running on other threads
+ * finish with the tier they started with
+ *
+ * Parameters
+ * - tier The tier to select
+ * Returns
+ * - true if the tier was selected
+ * - false if the CPU does not support the tier, leaving the table unchanged
+ */
+bool harmony_kernels_select(HarmonyCpuTier tier);
+
+/**
+ * Copies memory, using non-temporal stores for large copies
+ *
+ * Useful for writing to GPU mapped memory, or data which will not be read
+ * again soon, dispatched through harmony_kernels()
+ *
+ * Parameters
+ * - dst The destination, must not be NULL or overlap src
+ * - src The source, must not be NULL
+ * - size The number of bytes to copy
+ */
+void harmony_copy(void *dst, const void *src, usize size);
+
+/**
+ * Mixes samples into a buffer, dst[i] += src[i] * gain
+ *
+ * Dispatched through harmony_kernels()
+ *
+ * Parameters
+ * - dst The samples to mix into, must not be NULL
+ * - src The samples to mix, must not be NULL
+ * - gain The gain to scale src by
+ * - count The number of samples
+ */
+void harmony_mix(f32 *dst, const f32 *src, f32 gain, usize count);
+
+#if defined(HARMONY_IMPLEMENTATION_MATH) || defined(HARMONY_IMPLEMENTATION_ALL)
+
+#include <stdatomic.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+
+#include <cpuid.h>
+#include <immintrin.h>
+
+/**
+ * Defined when kernels for x86 instruction set extensions are compiled with
+ * function target attributes, independent of the compiler flags
+ */
+#define HARMONY_X86_KERNELS
+
+#define HARMONY_TARGET_SSE2 __attribute__((target("sse2")))
+#define HARMONY_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define HARMONY_TARGET_AVX512 __attribute__((target("avx512f")))
+
+static u64 harmony_xgetbv(u32 index) {
+    u32 eax;
+    u32 edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(index));
+    return ((u64)edx << 32) | eax;
+}
+
+#endif // (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+
+void harmony_pcg32_seed(HarmonyPcg32 *rng, u64 seed, u64 stream) {
+    harmony_assert(rng != NULL);
+    rng->state = 0;
+    rng->inc = (stream << 1) | 1;
+    harmony_pcg32_next(rng);
+    rng->state += seed;
+    harmony_pcg32_next(rng);
+}
+
+#define HARMONY_PCG32_MULTIPLIER 6364136223846793005ull
+
+u32 harmony_pcg32_next(HarmonyPcg32 *rng) {
+    harmony_assert(rng != NULL);
+    u64 state = rng->state;
+    rng->state = state * HARMONY_PCG32_MULTIPLIER + rng->inc;
+    u32 xorshifted = (u32)(((state >> 18) ^ state) >> 27);
+    u32 rot = (u32)(state >> 59);
+    return (xorshifted >> rot) | (xorshifted << ((32 - rot) & 31));
+}
+
+u32 harmony_pcg32_bounded(HarmonyPcg32 *rng, u32 bound) {
+    harmony_assert(rng != NULL);
+    harmony_assert(bound > 0);
+    u64 m = (u64)harmony_pcg32_next(rng) * bound;
+    if ((u32)m < bound) {
+        u32 threshold = (0u - bound) % bound;
+        while ((u32)m < threshold) {
+            m = (u64)harmony_pcg32_next(rng) * bound;
+        }
+    }
+    return (u32)(m >> 32);
+}
+
+f32 harmony_pcg32_f32(HarmonyPcg32 *rng) {
+    return (f32)(harmony_pcg32_next(rng) >> 8) * 0x1.0p-24f;
+}
+
+void harmony_pcg32_advance(HarmonyPcg32 *rng, u64 delta) {
+    harmony_assert(rng != NULL);
+    u64 mult = HARMONY_PCG32_MULTIPLIER;
+    u64 plus = rng->inc;
+    u64 acc_mult = 1;
+    u64 acc_plus = 0;
+    while (delta > 0) {
+        if (delta & 1) {
+            acc_mult *= mult;
+            acc_plus = acc_plus * mult + plus;
+        }
+        plus = (mult + 1) * plus;
+        mult *= mult;
+        delta >>= 1;
+    }
+    rng->state = acc_mult * rng->state + acc_plus;
+}
+
+static u64 harmony_splitmix64(u64 *state) {
+    u64 z = (*state += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+static u64 harmony_rotl64(u64 x, u32 k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+void harmony_xoshiro256_seed(HarmonyXoshiro256 *rng, u64 seed) {
+    harmony_assert(rng != NULL);
+    for (u32 i = 0; i < 4; ++i) {
+        rng->s[i] = harmony_splitmix64(&seed);
+    }
+}
+
+u64 harmony_xoshiro256_next(HarmonyXoshiro256 *rng) {
+    harmony_assert(rng != NULL);
+    u64 *s = rng->s;
+    u64 result = harmony_rotl64(s[1] * 5, 7) * 9;
+    u64 t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = harmony_rotl64(s[3], 45);
+    return result;
+}
+
+f32 harmony_xoshiro256_f32(HarmonyXoshiro256 *rng) {
+    return (f32)(harmony_xoshiro256_next(rng) >> 40) * 0x1.0p-24f;
+}
+
+static void harmony_xoshiro256_jump_by(HarmonyXoshiro256 *rng, const u64 polynomial[4]) {
+    u64 s[4] = {0, 0, 0, 0};
+    for (u32 i = 0; i < 4; ++i) {
+        for (u32 b = 0; b < 64; ++b) {
+            if (polynomial[i] & ((u64)1 << b)) {
+                for (u32 j = 0; j < 4; ++j) {
+                    s[j] ^= rng->s[j];
+                }
+            }
+            harmony_xoshiro256_next(rng);
+        }
+    }
+    for (u32 j = 0; j < 4; ++j) {
+        rng->s[j] = s[j];
+    }
+}
+
+void harmony_xoshiro256_jump(HarmonyXoshiro256 *rng) {
+    harmony_assert(rng != NULL);
+    static const u64 polynomial[4] = {
+        0x180ec6d33cfd0abaull, 0xd5a61266f0c9392cull, 0xa9582618e03fc9aaull, 0x39abdc4529b1661cull,
+    };
+    harmony_xoshiro256_jump_by(rng, polynomial);
+}
+
+void harmony_xoshiro256_long_jump(HarmonyXoshiro256 *rng) {
+    harmony_assert(rng != NULL);
+    static const u64 polynomial[4] = {
+        0x76e15d3efefdcbbfull, 0xc5004e441c522fb3ull, 0x77710069854ee241ull, 0x39109bb02acbe635ull,
+    };
+    harmony_xoshiro256_jump_by(rng, polynomial);
+}
+
+void harmony_random_seed(HarmonyRandom *rng, u64 seed) {
+    HarmonyXoshiro256 src;
+    harmony_xoshiro256_seed(&src, seed);
+    harmony_random_split(rng, &src);
+}
+
+void harmony_random_split(HarmonyRandom *rng, HarmonyXoshiro256 *src) {
+    harmony_assert(rng != NULL);
+    harmony_assert(src != NULL);
+    for (u32 lane = 0; lane < HARMONY_RANDOM_LANES; ++lane) {
+        harmony_xoshiro256_jump(src);
+        for (u32 i = 0; i < 4; ++i) {
+            rng->s[i][lane] = src->s[i];
+        }
+    }
+}
+
+static void harmony_random_scalar(HarmonyRandom *rng, u64 *dst, usize count) {
+    for (usize n = 0; n < count; ++n) {
+        for (u32 lane = 0; lane < HARMONY_RANDOM_LANES; ++lane) {
+            u64 s0 = rng->s[0][lane];
+            u64 s1 = rng->s[1][lane];
+            u64 s2 = rng->s[2][lane];
+            u64 s3 = rng->s[3][lane];
+            dst[n * HARMONY_RANDOM_LANES + lane] = harmony_rotl64(s1 * 5, 7) * 9;
+            u64 t = s1 << 17;
+            s2 ^= s0;
+            s3 ^= s1;
+            s1 ^= s2;
+            s0 ^= s3;
+            s2 ^= t;
+            s3 = harmony_rotl64(s3, 45);
+            rng->s[0][lane] = s0;
+            rng->s[1][lane] = s1;
+            rng->s[2][lane] = s2;
+            rng->s[3][lane] = s3;
+        }
+    }
+}
+
+#ifdef HARMONY_X86_KERNELS
+
+HARMONY_TARGET_AVX2
+static inline __m256i harmony_random_step_avx2(__m256i *s0, __m256i *s1, __m256i *s2, __m256i *s3) {
+    __m256i x5 = _mm256_add_epi64(_mm256_slli_epi64(*s1, 2), *s1);
+    __m256i rot = _mm256_or_si256(_mm256_slli_epi64(x5, 7), _mm256_srli_epi64(x5, 57));
+    __m256i result = _mm256_add_epi64(_mm256_slli_epi64(rot, 3), rot);
+    __m256i t = _mm256_slli_epi64(*s1, 17);
+    *s2 = _mm256_xor_si256(*s2, *s0);
+    *s3 = _mm256_xor_si256(*s3, *s1);
+    *s1 = _mm256_xor_si256(*s1, *s2);
+    *s0 = _mm256_xor_si256(*s0, *s3);
+    *s2 = _mm256_xor_si256(*s2, t);
+    *s3 = _mm256_or_si256(_mm256_slli_epi64(*s3, 45), _mm256_srli_epi64(*s3, 19));
+    return result;
+}
+
+HARMONY_TARGET_AVX2
+static void harmony_random_avx2(HarmonyRandom *rng, u64 *dst, usize count) {
+    // two independent groups of four lanes hide the latency of each step
+    __m256i a0 = _mm256_loadu_si256((const __m256i *)rng->s[0]);
+    __m256i a1 = _mm256_loadu_si256((const __m256i *)rng->s[1]);
+    __m256i a2 = _mm256_loadu_si256((const __m256i *)rng->s[2]);
+    __m256i a3 = _mm256_loadu_si256((const __m256i *)rng->s[3]);
+    __m256i b0 = _mm256_loadu_si256((const __m256i *)(rng->s[0] + 4));
+    __m256i b1 = _mm256_loadu_si256((const __m256i *)(rng->s[1] + 4));
+    __m256i b2 = _mm256_loadu_si256((const __m256i *)(rng->s[2] + 4));
+    __m256i b3 = _mm256_loadu_si256((const __m256i *)(rng->s[3] + 4));
+    for (usize n = 0; n < count; ++n) {
+        __m256i a = harmony_random_step_avx2(&a0, &a1, &a2, &a3);
+        __m256i b = harmony_random_step_avx2(&b0, &b1, &b2, &b3);
+        _mm256_storeu_si256((__m256i *)(dst + n * HARMONY_RANDOM_LANES), a);
+        _mm256_storeu_si256((__m256i *)(dst + n * HARMONY_RANDOM_LANES + 4), b);
+    }
+    _mm256_storeu_si256((__m256i *)rng->s[0], a0);
+    _mm256_storeu_si256((__m256i *)rng->s[1], a1);
+    _mm256_storeu_si256((__m256i *)rng->s[2], a2);
+    _mm256_storeu_si256((__m256i *)rng->s[3], a3);
+    _mm256_storeu_si256((__m256i *)(rng->s[0] + 4), b0);
+    _mm256_storeu_si256((__m256i *)(rng->s[1] + 4), b1);
+    _mm256_storeu_si256((__m256i *)(rng->s[2] + 4), b2);
+    _mm256_storeu_si256((__m256i *)(rng->s[3] + 4), b3);
+}
+
+#endif // HARMONY_X86_KERNELS
+
+/**
+ * Loads up to 8 elements from a stream, filling the remaining lanes with 0
+ */
+static F32x8 harmony_stream_load(const f32 *stream, usize count) {
+    F32x8 lanes = {0};
+    memcpy(lanes.v, stream, harmony_min(count, 8) * sizeof(f32));
+    return lanes;
+}
+
+/**
+ * The number of random values generated at a time by the bulk fills, kept on
+ * the stack
+ */
+#define HARMONY_RANDOM_CHUNK 256
+
+void harmony_random_u64s(HarmonyRandom *rng, u64 *dst, usize count) {
+    harmony_assert(rng != NULL);
+    harmony_assert(dst != NULL);
+    const HarmonyKernels *kernels = harmony_kernels();
+    usize whole = count / HARMONY_RANDOM_LANES;
+    kernels->random(rng, dst, whole);
+    if (count > whole * HARMONY_RANDOM_LANES) {
+        u64 tail[HARMONY_RANDOM_LANES];
+        kernels->random(rng, tail, 1);
+        for (usize i = whole * HARMONY_RANDOM_LANES; i < count; ++i) {
+            dst[i] = tail[i - whole * HARMONY_RANDOM_LANES];
+        }
+    }
+}
+
+void harmony_random_f32s(HarmonyRandom *rng, f32 *dst, usize count) {
+    harmony_random_range_f32s(rng, dst, count, 0.0f, 1.0f);
+}
+
+void harmony_random_range_f32s(HarmonyRandom *rng, f32 *dst, usize count, f32 min, f32 max) {
+    harmony_assert(rng != NULL);
+    harmony_assert(dst != NULL);
+    f32 scale = (max - min) * 0x1.0p-24f;
+    // min + scale * (2^24 - 1) rounds up to max when |min| is large next to max - min
+    f32 upper = min < max ? nextafterf(max, min) : INFINITY;
+    u64 bits[HARMONY_RANDOM_CHUNK];
+    u32 halves[2 * HARMONY_RANDOM_CHUNK];
+    for (usize i = 0; i < count; i += 2 * HARMONY_RANDOM_CHUNK) {
+        usize n = harmony_min(count - i, 2 * HARMONY_RANDOM_CHUNK);
+        usize words = (n + 1) / 2;
+        harmony_random_u64s(rng, bits, words);
+        memcpy(halves, bits, words * sizeof(*bits));
+        usize j = 0;
+#ifdef HARMONY_SIMD_SSE
+        __m128 scale4 = _mm_set1_ps(scale);
+        __m128 min4 = _mm_set1_ps(min);
+        __m128 upper4 = _mm_set1_ps(upper);
+        for (; j + 4 <= n; j += 4) {
+            __m128i mantissa = _mm_srli_epi32(_mm_loadu_si128((const __m128i *)(halves + j)), 8);
+            __m128 value = harmony_m128_madd(min4, _mm_cvtepi32_ps(mantissa), scale4);
+            _mm_storeu_ps(dst + i + j, _mm_min_ps(value, upper4));
+        }
+#endif // HARMONY_SIMD_SSE
+        for (; j < n; ++j) {
+            dst[i + j] = fminf((f32)(i32)(halves[j] >> 8) * scale + min, upper);
+        }
+    }
+}
+
+void harmony_random_gaussian_f32s(HarmonyRandom *rng, f32 *dst, usize count, f32 mean, f32 stddev) {
+    harmony_assert(rng != NULL);
+    harmony_assert(dst != NULL);
+    F32x8 one = sf32x8(1.0f);
+    // -2 ln(u) = -2 ln(2) log2(u)
+    F32x8 log_scale = sf32x8(-2.0f * 0.69314718f);
+    F32x8 angle_scale = sf32x8((f32)(2.0 * PI));
+    F32x8 stddev8 = sf32x8(stddev);
+    F32x8 mean8 = sf32x8(mean);
+    f32 uniform[HARMONY_RANDOM_CHUNK];
+    f32 logs[HARMONY_RANDOM_CHUNK / 2];
+    f32 sines[HARMONY_RANDOM_CHUNK / 2];
+    f32 cosines[HARMONY_RANDOM_CHUNK / 2];
+    for (usize i = 0; i < count; i += HARMONY_RANDOM_CHUNK) {
+        usize n = harmony_min(count - i, HARMONY_RANDOM_CHUNK);
+        // each pair gives a cosine output in the first half and a sine output in the second
+        usize pairs = ((n + 1) / 2 + 7) & ~(usize)7;
+        harmony_random_f32s(rng, uniform, 2 * pairs);
+        for (usize j = 0; j < pairs; j += 8) {
+            F32x8 u = harmony_stream_load(uniform + j, 8);
+            F32x8 angle = fmul8(angle_scale, harmony_stream_load(uniform + pairs + j, 8));
+            // 1 - u is in (0, 1], so the logarithm is finite
+            memcpy(logs + j, fsub8(one, u).v, sizeof(u.v));
+            memcpy(uniform + pairs + j, angle.v, sizeof(angle.v));
+        }
+        harmony_approx_log2(logs, logs, pairs);
+        harmony_approx_sincos(sines, cosines, uniform + pairs, pairs);
+        for (usize j = 0; j < pairs; j += 8) {
+            F32x8 radius = fmul8(fsqrt8(fmul8(log_scale, harmony_stream_load(logs + j, 8))), stddev8);
+            F32x8 c = fmadd8(mean8, radius, harmony_stream_load(cosines + j, 8));
+            F32x8 s = fmadd8(mean8, radius, harmony_stream_load(sines + j, 8));
+            memcpy(uniform + j, c.v, sizeof(c.v));
+            memcpy(uniform + pairs + j, s.v, sizeof(s.v));
+        }
+        memcpy(dst + i, uniform, n * sizeof(*dst));
+    }
+}
+
+void harmony_random_unit_vec3s(HarmonyRandom *rng, Vec3 *dst, usize count) {
+    harmony_assert(rng != NULL);
+    harmony_assert(dst != NULL);
+    F32x8 one = sf32x8(1.0f);
+    F32x8 two = sf32x8(2.0f);
+    F32x8 angle_scale = sf32x8((f32)(2.0 * PI));
+    f32 uniform[HARMONY_RANDOM_CHUNK];
+    f32 sines[HARMONY_RANDOM_CHUNK / 2];
+    f32 cosines[HARMONY_RANDOM_CHUNK / 2];
+    for (usize i = 0; i < count; i += HARMONY_RANDOM_CHUNK / 2) {
+        usize n = harmony_min(count - i, HARMONY_RANDOM_CHUNK / 2);
+        usize lanes = (n + 7) & ~(usize)7;
+        harmony_random_f32s(rng, uniform, 2 * lanes);
+        for (usize j = 0; j < lanes; j += 8) {
+            F32x8 angle = fmul8(angle_scale, harmony_stream_load(uniform + lanes + j, 8));
+            memcpy(uniform + lanes + j, angle.v, sizeof(angle.v));
+        }
+        harmony_approx_sincos(sines, cosines, uniform + lanes, lanes);
+        for (usize j = 0; j < n; j += 8) {
+            // z is in [-1, 1), so 1 - z^2 cannot round below 0
+            F32x8 z = fsub8(fmul8(harmony_stream_load(uniform + j, 8), two), one);
+            F32x8 radius = fsqrt8(fsub8(one, fmul8(z, z)));
+            Vec3x8 vec = {
+                fmul8(radius, harmony_stream_load(cosines + j, 8)),
+                fmul8(radius, harmony_stream_load(sines + j, 8)),
+                z,
+            };
+            if (j + 8 <= n) {
+                scatter_vec3x8(dst + i + j, vec);
+            } else {
+                Vec3 tail[8];
+                scatter_vec3x8(tail, vec);
+                memcpy(dst + i + j, tail, (n - j) * sizeof(*dst));
+            }
+        }
+    }
+}
+
+static const u64 harmony_hash_default_secret[HARMONY_HASH_SECRET_SIZE] = {
+    0xfd4733187e87fe56ull, 0xb15f6238ba5de0c2ull, 0x05832440d3f9b93dull, 0xdb06126b08924056ull,
+    0xefe315e91a7f9d24ull, 0x9e27136a463e33bbull, 0x2b96b2e4eae09856ull, 0xe8e3e9b48b1bbb98ull,
+    0x6fa5cd1f301126afull, 0x988402a87005f6beull, 0x3c28111101e96946ull, 0x52bdf49d99a5d6faull,
+    0xdcb4a128bcf94485ull, 0xb3eadd9ba516c1beull, 0x10cccb900e6db0f6ull, 0xa8af679f8de4759bull,
+    0xd0b683f11103e5a8ull, 0x934c2c8c4dd3973full, 0xbc1a029b3d2094afull, 0x633d24dbbdd83b16ull,
+    0x981a259cad2d1757ull, 0xbb81122c888337e6ull, 0xc1dd917b11507667ull, 0x07f96ed5790ab566ull,
+};
+
+#define HARMONY_HASH_PRIME32_1 0x9e3779b1u
+#define HARMONY_HASH_PRIME64_1 0x9e3779b185ebca87ull
+#define HARMONY_HASH_PRIME64_2 0xc2b2ae3d27d4eb4full
+#define HARMONY_HASH_PRIME64_3 0x165667b19e3779f9ull
+#define HARMONY_HASH_PRIME64_4 0x85ebca77c2b2ae63ull
+#define HARMONY_HASH_PRIME64_5 0x27d4eb2f165667c5ull
+
+#define HARMONY_HASH_STRIPE 64
+#define HARMONY_HASH_BLOCK_STRIPES 16
+#define HARMONY_HASH_MID_SIZE 128
+
+// the words of key material used for the final stripe, and for merging
+#define HARMONY_HASH_LAST_STRIPE_SECRET 13
+#define HARMONY_HASH_MERGE_SECRET 3
+
+static u64 harmony_hash_read64(const u8 *data) {
+    u64 value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+static u32 harmony_hash_read32(const u8 *data) {
+    u32 value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+static u64 harmony_hash_swap64(u64 x) {
+    return ((x << 56) & 0xff00000000000000ull)
+         | ((x << 40) & 0x00ff000000000000ull)
+         | ((x << 24) & 0x0000ff0000000000ull)
+         | ((x << 8) & 0x000000ff00000000ull)
+         | ((x >> 8) & 0x00000000ff000000ull)
+         | ((x >> 24) & 0x0000000000ff0000ull)
+         | ((x >> 40) & 0x000000000000ff00ull)
+         | ((x >> 56) & 0x00000000000000ffull);
+}
+
+static u64 harmony_hash_fold64(u64 lhs, u64 rhs) {
+#ifdef __SIZEOF_INT128__
+    __extension__ unsigned __int128 product = (unsigned __int128)lhs * rhs;
+    return (u64)product ^ (u64)(product >> 64);
+#else // __SIZEOF_INT128__
+    u64 lo_lo = (lhs & 0xffffffffu) * (rhs & 0xffffffffu);
+    u64 hi_lo = (lhs >> 32) * (rhs & 0xffffffffu);
+    u64 lo_hi = (lhs & 0xffffffffu) * (rhs >> 32);
+    u64 hi_hi = (lhs >> 32) * (rhs >> 32);
+    u64 cross = (lo_lo >> 32) + (hi_lo & 0xffffffffu) + lo_hi;
+    u64 hi = (hi_lo >> 32) + (cross >> 32) + hi_hi;
+    u64 lo = (cross << 32) | (lo_lo & 0xffffffffu);
+    return lo ^ hi;
+#endif // __SIZEOF_INT128__
+}
+
+static u64 harmony_hash_avalanche(u64 h) {
+    h ^= h >> 37;
+    h *= 0x165667919e3779f9ull;
+    return h ^ (h >> 32);
+}
+
+static u64 harmony_hash_avalanche64(u64 h) {
+    h ^= h >> 33;
+    h *= HARMONY_HASH_PRIME64_2;
+    h ^= h >> 29;
+    h *= HARMONY_HASH_PRIME64_3;
+    return h ^ (h >> 32);
+}
+
+static u64 harmony_hash_rrmxmx(u64 h, u64 size) {
+    h ^= harmony_rotl64(h, 49) ^ harmony_rotl64(h, 24);
+    h *= 0x9fb21c651e98df25ull;
+    h ^= (h >> 35) + size;
+    h *= 0x9fb21c651e98df25ull;
+    return h ^ (h >> 28);
+}
+
+static u64 harmony_hash_mix16(const u8 *data, const u64 *secret, u64 seed) {
+    return harmony_hash_fold64(
+        harmony_hash_read64(data) ^ (secret[0] + seed),
+        harmony_hash_read64(data + 8) ^ (secret[1] - seed));
+}
+
+static u64 harmony_hash_short(const u8 *data, usize size, const u64 *secret, u64 seed) {
+    if (size > 8) {
+        u64 lo = harmony_hash_read64(data) ^ ((secret[3] ^ secret[4]) + seed);
+        u64 hi = harmony_hash_read64(data + size - 8) ^ ((secret[5] ^ secret[6]) - seed);
+        return harmony_hash_avalanche(size + harmony_hash_swap64(lo) + hi + harmony_hash_fold64(lo, hi));
+    }
+    if (size >= 4) {
+        u64 seed32 = seed ^ harmony_hash_swap64(seed & 0xffffffffu);
+        u64 input = harmony_hash_read32(data + size - 4) + ((u64)harmony_hash_read32(data) << 32);
+        return harmony_hash_rrmxmx(input ^ ((secret[1] ^ secret[2]) - seed32), size);
+    }
+    if (size > 0) {
+        u32 combined = ((u32)data[0] << 16) | ((u32)data[size >> 1] << 24) | (u32)data[size - 1] | ((u32)size << 8);
+        u64 flip = (u64)((u32)secret[0] ^ (u32)(secret[0] >> 32)) + seed;
+        return harmony_hash_avalanche64((u64)combined ^ flip);
+    }
+    return harmony_hash_avalanche64(seed ^ secret[7] ^ secret[8]);
+}
+
+static u64 harmony_hash_mid(const u8 *data, usize size, const u64 *secret, u64 seed) {
+    u64 acc = size * HARMONY_HASH_PRIME64_1;
+    if (size > 32) {
+        if (size > 64) {
+            if (size > 96) {
+                acc += harmony_hash_mix16(data + 48, secret + 12, seed);
+                acc += harmony_hash_mix16(data + size - 64, secret + 14, seed);
+            }
+            acc += harmony_hash_mix16(data + 32, secret + 8, seed);
+            acc += harmony_hash_mix16(data + size - 48, secret + 10, seed);
+        }
+        acc += harmony_hash_mix16(data + 16, secret + 4, seed);
+        acc += harmony_hash_mix16(data + size - 32, secret + 6, seed);
+    }
+    acc += harmony_hash_mix16(data, secret, seed);
+    acc += harmony_hash_mix16(data + size - 16, secret + 2, seed);
+    return harmony_hash_avalanche(acc);
+}
+
+static void harmony_hash_stripes_scalar(u64 *acc, const u8 *data, const u64 *secret, usize count) {
+    for (usize n = 0; n < count; ++n) {
+        const u8 *stripe = data + n * HARMONY_HASH_STRIPE;
+        for (u32 i = 0; i < 8; ++i) {
+            u64 value = harmony_hash_read64(stripe + i * 8);
+            u64 keyed = value ^ secret[n + i];
+            acc[i ^ 1] += value;
+            acc[i] += (keyed & 0xffffffffu) * (keyed >> 32);
+        }
+    }
+}
+
+#ifdef HARMONY_X86_KERNELS
+
+HARMONY_TARGET_SSE2
+static void harmony_hash_stripes_sse2(u64 *acc, const u8 *data, const u64 *secret, usize count) {
+    __m128i sums[4];
+    for (u32 i = 0; i < 4; ++i) {
+        sums[i] = _mm_loadu_si128((const __m128i *)(acc + i * 2));
+    }
+    for (usize n = 0; n < count; ++n) {
+        const u8 *stripe = data + n * HARMONY_HASH_STRIPE;
+        for (u32 i = 0; i < 4; ++i) {
+            __m128i value = _mm_loadu_si128((const __m128i *)(stripe + i * 16));
+            __m128i keyed = _mm_xor_si128(value, _mm_loadu_si128((const __m128i *)(secret + n + i * 2)));
+            __m128i product = _mm_mul_epu32(keyed, _mm_srli_epi64(keyed, 32));
+            __m128i swapped = _mm_shuffle_epi32(value, _MM_SHUFFLE(1, 0, 3, 2));
+            sums[i] = _mm_add_epi64(sums[i], _mm_add_epi64(product, swapped));
+        }
+    }
+    for (u32 i = 0; i < 4; ++i) {
+        _mm_storeu_si128((__m128i *)(acc + i * 2), sums[i]);
+    }
+}
+
+HARMONY_TARGET_AVX2
+static void harmony_hash_stripes_avx2(u64 *acc, const u8 *data, const u64 *secret, usize count) {
+    __m256i lo = _mm256_loadu_si256((const __m256i *)acc);
+    __m256i hi = _mm256_loadu_si256((const __m256i *)(acc + 4));
+    for (usize n = 0; n < count; ++n) {
+        const u8 *stripe = data + n * HARMONY_HASH_STRIPE;
+        __m256i value_lo = _mm256_loadu_si256((const __m256i *)stripe);
+        __m256i value_hi = _mm256_loadu_si256((const __m256i *)(stripe + 32));
+        __m256i keyed_lo = _mm256_xor_si256(value_lo, _mm256_loadu_si256((const __m256i *)(secret + n)));
+        __m256i keyed_hi = _mm256_xor_si256(value_hi, _mm256_loadu_si256((const __m256i *)(secret + n + 4)));
+        __m256i product_lo = _mm256_mul_epu32(keyed_lo, _mm256_srli_epi64(keyed_lo, 32));
+        __m256i product_hi = _mm256_mul_epu32(keyed_hi, _mm256_srli_epi64(keyed_hi, 32));
+        __m256i swapped_lo = _mm256_shuffle_epi32(value_lo, _MM_SHUFFLE(1, 0, 3, 2));
+        __m256i swapped_hi = _mm256_shuffle_epi32(value_hi, _MM_SHUFFLE(1, 0, 3, 2));
+        lo = _mm256_add_epi64(lo, _mm256_add_epi64(product_lo, swapped_lo));
+        hi = _mm256_add_epi64(hi, _mm256_add_epi64(product_hi, swapped_hi));
+    }
+    _mm256_storeu_si256((__m256i *)acc, lo);
+    _mm256_storeu_si256((__m256i *)(acc + 4), hi);
+}
+
+#endif // HARMONY_X86_KERNELS
+
+static void harmony_hash_scramble(u64 *acc, const u64 *secret) {
+    for (u32 i = 0; i < 8; ++i) {
+        u64 a = acc[i];
+        a ^= a >> 47;
+        a ^= secret[i];
+        acc[i] = a * HARMONY_HASH_PRIME32_1;
+    }
+}
+
+/**
+ * Accumulates stripes, scrambling after each block of
+ * HARMONY_HASH_BLOCK_STRIPES, so a hash may be computed in any number of
+ * pieces
+ */
+static void harmony_hash_consume(
+    u64 *acc,
+    u32 *block_stripes,
+    const u8 *data,
+    usize count,
+    const u64 *secret,
+    const HarmonyKernels *kernels
+) {
+    while (count > 0) {
+        usize n = harmony_min(count, HARMONY_HASH_BLOCK_STRIPES - *block_stripes);
+        kernels->hash_stripes(acc, data, secret + *block_stripes, n);
+        data += n * HARMONY_HASH_STRIPE;
+        count -= n;
+        *block_stripes += (u32)n;
+        if (*block_stripes == HARMONY_HASH_BLOCK_STRIPES) {
+            harmony_hash_scramble(acc, secret + HARMONY_HASH_SECRET_SIZE - 8);
+            *block_stripes = 0;
+        }
+    }
+}
+
+static void harmony_hash_init_acc(u64 *acc) {
+    acc[0] = HARMONY_HASH_PRIME32_1;
+    acc[1] = HARMONY_HASH_PRIME64_1;
+    acc[2] = HARMONY_HASH_PRIME64_2;
+    acc[3] = HARMONY_HASH_PRIME64_3;
+    acc[4] = HARMONY_HASH_PRIME64_4;
+    acc[5] = HARMONY_HASH_PRIME64_5;
+    acc[6] = 0x85ebca6bu;
+    acc[7] = 0xc2b2ae35u;
+}
+
+static u64 harmony_hash_merge(const u64 *acc, const u64 *secret, usize size) {
+    u64 result = size * HARMONY_HASH_PRIME64_1;
+    for (u32 i = 0; i < 4; ++i) {
+        result += harmony_hash_fold64(
+            acc[i * 2] ^ secret[HARMONY_HASH_MERGE_SECRET + i * 2],
+            acc[i * 2 + 1] ^ secret[HARMONY_HASH_MERGE_SECRET + i * 2 + 1]);
+    }
+    return harmony_hash_avalanche(result);
+}
+
+static void harmony_hash_derive_secret(u64 *secret, u64 seed) {
+    for (u32 i = 0; i < HARMONY_HASH_SECRET_SIZE; i += 2) {
+        secret[i] = harmony_hash_default_secret[i] + seed;
+        secret[i + 1] = harmony_hash_default_secret[i + 1] - seed;
+    }
+}
+
+u64 harmony_hash(const void *data, usize size) {
+    return harmony_hash_seeded(data, size, 0);
+}
+
+u64 harmony_hash_seeded(const void *data, usize size, u64 seed) {
+    harmony_assert(data != NULL || size == 0);
+    const u8 *bytes = data;
+    if (size <= 16)
+        return harmony_hash_short(bytes, size, harmony_hash_default_secret, seed);
+    if (size <= HARMONY_HASH_MID_SIZE)
+        return harmony_hash_mid(bytes, size, harmony_hash_default_secret, seed);
+
+    u64 seeded_secret[HARMONY_HASH_SECRET_SIZE];
+    const u64 *secret = harmony_hash_default_secret;
+    if (seed != 0) {
+        harmony_hash_derive_secret(seeded_secret, seed);
+        secret = seeded_secret;
+    }
+
+    const HarmonyKernels *kernels = harmony_kernels();
+    u64 acc[8];
+    harmony_hash_init_acc(acc);
+    u32 block_stripes = 0;
+    harmony_hash_consume(acc, &block_stripes, bytes, (size - 1) / HARMONY_HASH_STRIPE, secret, kernels);
+    kernels->hash_stripes(acc, bytes + size - HARMONY_HASH_STRIPE, secret + HARMONY_HASH_LAST_STRIPE_SECRET, 1);
+    return harmony_hash_merge(acc, secret, size);
+}
+
+void harmony_hash_init(HarmonyHashState *state, u64 seed) {
+    harmony_assert(state != NULL);
+    harmony_hash_init_acc(state->acc);
+    harmony_hash_derive_secret(state->secret, seed);
+    state->seed = seed;
+    state->total = 0;
+    state->buffered = 0;
+    state->block_stripes = 0;
+}
+
+void harmony_hash_update(HarmonyHashState *state, const void *data, usize size) {
+    harmony_assert(state != NULL);
+    harmony_assert(data != NULL || size == 0);
+    const u8 *bytes = data;
+    state->total += size;
+    if (state->buffered + size <= HARMONY_HASH_BUFFER_SIZE) {
+        if (size > 0)
+            memcpy(state->buffer + state->buffered, bytes, size);
+        state->buffered += size;
+        return;
+    }
+
+    // stripes are only consumed when more data follows them, so the final
+    // stripe is always left for harmony_hash_final()
+    const HarmonyKernels *kernels = harmony_kernels();
+    usize stripe_count = HARMONY_HASH_BUFFER_SIZE / HARMONY_HASH_STRIPE;
+    if (state->buffered > 0) {
+        usize fill = HARMONY_HASH_BUFFER_SIZE - state->buffered;
+        memcpy(state->buffer + state->buffered, bytes, fill);
+        bytes += fill;
+        size -= fill;
+        harmony_hash_consume(state->acc, &state->block_stripes, state->buffer, stripe_count, state->secret, kernels);
+        memcpy(state->tail, state->buffer + HARMONY_HASH_BUFFER_SIZE - sizeof(state->tail), sizeof(state->tail));
+        state->buffered = 0;
+    }
+    if (size > HARMONY_HASH_BUFFER_SIZE) {
+        usize whole = (size - 1) / HARMONY_HASH_STRIPE;
+        harmony_hash_consume(state->acc, &state->block_stripes, bytes, whole, state->secret, kernels);
+        bytes += whole * HARMONY_HASH_STRIPE;
+        size -= whole * HARMONY_HASH_STRIPE;
+        memcpy(state->tail, bytes - sizeof(state->tail), sizeof(state->tail));
+    }
+    memcpy(state->buffer, bytes, size);
+    state->buffered = size;
+}
+
+u64 harmony_hash_final(const HarmonyHashState *state) {
+    harmony_assert(state != NULL);
+    if (state->total <= 16)
+        return harmony_hash_short(state->buffer, state->total, harmony_hash_default_secret, state->seed);
+    if (state->total <= HARMONY_HASH_MID_SIZE)
+        return harmony_hash_mid(state->buffer, state->total, harmony_hash_default_secret, state->seed);
+
+    const HarmonyKernels *kernels = harmony_kernels();
+    u64 acc[8];
+    memcpy(acc, state->acc, sizeof(acc));
+    u32 block_stripes = state->block_stripes;
+    harmony_hash_consume(acc, &block_stripes, state->buffer,
+        (state->buffered - 1) / HARMONY_HASH_STRIPE, state->secret, kernels);
+
+    u8 last[HARMONY_HASH_STRIPE];
+    const u8 *last_stripe = state->buffer + state->buffered - HARMONY_HASH_STRIPE;
+    if (state->buffered < HARMONY_HASH_STRIPE) {
+        usize from_tail = HARMONY_HASH_STRIPE - state->buffered;
+        memcpy(last, state->tail + sizeof(state->tail) - from_tail, from_tail);
+        memcpy(last + from_tail, state->buffer, state->buffered);
+        last_stripe = last;
+    }
+    kernels->hash_stripes(acc, last_stripe, state->secret + HARMONY_HASH_LAST_STRIPE_SECRET, 1);
+    return harmony_hash_merge(acc, state->secret, state->total);
+}
+
+// scales bringing the extremes of each noise close to [-1, 1]
+#define HARMONY_PERLIN_2D_SCALE 1.41421356f
+#define HARMONY_PERLIN_3D_SCALE 0.9649f
+#define HARMONY_PERLIN_4D_SCALE 0.86f
+#define HARMONY_SIMPLEX_2D_SCALE 99.2043f
+#define HARMONY_SIMPLEX_3D_SCALE 32.7f
+#define HARMONY_SIMPLEX_4D_SCALE 27.0f
+
+#define HARMONY_SIMPLEX_F2 0.36602540378443865f
+#define HARMONY_SIMPLEX_G2 0.21132486540518713f
+#define HARMONY_SIMPLEX_F3 0.33333333333333333f
+#define HARMONY_SIMPLEX_G3 0.16666666666666667f
+#define HARMONY_SIMPLEX_F4 0.30901699437494742f
+#define HARMONY_SIMPLEX_G4 0.13819660112501051f
+
+static const f32 harmony_noise_grad2[2][8] = {
+    {1.0f, 0.70710678f, 0.0f, -0.70710678f, -1.0f, -0.70710678f, 0.0f, 0.70710678f},
+    {0.0f, 0.70710678f, 1.0f, 0.70710678f, 0.0f, -0.70710678f, -1.0f, -0.70710678f},
+};
+
+static const f32 harmony_noise_grad3[3][16] = {
+    {1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, -1.0f, 0.0f},
+    {1.0f, 1.0f, -1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f},
+    {0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, -1.0f, -1.0f, 0.0f, 1.0f, 0.0f, -1.0f},
+};
+
+static const f32 harmony_noise_grad4[4][32] = {
+    {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f,
+     -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f},
+    {-1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+     -1.0f, -1.0f, 1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f},
+    {-1.0f, -1.0f, 1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f,
+     0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, -1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f, 1.0f},
+    {-1.0f, -1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f, 1.0f, -1.0f, -1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f, 1.0f,
+     -1.0f, -1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f},
+};
+
+#define HARMONY_NOISE_PRIME_X 0x9e3779b1u
+#define HARMONY_NOISE_PRIME_Y 0x85ebca77u
+#define HARMONY_NOISE_PRIME_Z 0xc2b2ae3du
+#define HARMONY_NOISE_PRIME_W 0x27d4eb2fu
+
+/**
+ * Hashes a lattice point, where the coordinates have already been multiplied
+ * by their primes and summed with the seed
+ */
+static u32 harmony_noise_hash(u32 h) {
+    h ^= h >> 15;
+    h *= 0x2c1b3c6du;
+    h ^= h >> 12;
+    h *= 0x297a2d39u;
+    return h ^ (h >> 15);
+}
+
+static f32 harmony_noise_fade(f32 t) {
+    return t * t * t * ((t * 6.0f - 15.0f) * t + 10.0f);
+}
+
+static f32 harmony_noise_lerp(f32 a, f32 b, f32 t) {
+    return a + t * (b - a);
+}
+
+static f32 harmony_noise_dot2(u32 h, f32 x, f32 y) {
+    return harmony_noise_grad2[0][h & 7] * x + harmony_noise_grad2[1][h & 7] * y;
+}
+
+static f32 harmony_noise_dot3(u32 h, f32 x, f32 y, f32 z) {
+    return harmony_noise_grad3[0][h & 15] * x + harmony_noise_grad3[1][h & 15] * y + harmony_noise_grad3[2][h & 15] * z;
+}
+
+static f32 harmony_noise_dot4(u32 h, f32 x, f32 y, f32 z, f32 w) {
+    return harmony_noise_grad4[0][h & 31] * x + harmony_noise_grad4[1][h & 31] * y
+         + harmony_noise_grad4[2][h & 31] * z + harmony_noise_grad4[3][h & 31] * w;
+}
+
+void harmony_noise_seed(HarmonyNoise *noise, u64 seed) {
+    harmony_assert(noise != NULL);
+    HarmonyPcg32 rng;
+    harmony_pcg32_seed(&rng, seed, 0);
+    for (u32 i = 0; i < HARMONY_NOISE_MAX_OCTAVES; ++i) {
+        noise->seeds[i] = harmony_pcg32_next(&rng);
+    }
+}
+
+f32 harmony_perlin_2d(u32 seed, f32 x, f32 y) {
+    f32 fx = floorf(x);
+    f32 fy = floorf(y);
+    f32 dx = x - fx;
+    f32 dy = y - fy;
+    u32 hx = (u32)(i32)fx * HARMONY_NOISE_PRIME_X;
+    u32 hy = seed + (u32)(i32)fy * HARMONY_NOISE_PRIME_Y;
+
+    f32 n00 = harmony_noise_dot2(harmony_noise_hash(hx + hy), dx, dy);
+    f32 n10 = harmony_noise_dot2(harmony_noise_hash(hx + HARMONY_NOISE_PRIME_X + hy), dx - 1.0f, dy);
+    f32 n01 = harmony_noise_dot2(harmony_noise_hash(hx + hy + HARMONY_NOISE_PRIME_Y), dx, dy - 1.0f);
+    f32 n11 = harmony_noise_dot2(
+        harmony_noise_hash(hx + HARMONY_NOISE_PRIME_X + hy + HARMONY_NOISE_PRIME_Y), dx - 1.0f, dy - 1.0f);
+
+    f32 u = harmony_noise_fade(dx);
+    f32 v = harmony_noise_fade(dy);
+    f32 result = harmony_noise_lerp(harmony_noise_lerp(n00, n10, u), harmony_noise_lerp(n01, n11, u), v);
+    return result * HARMONY_PERLIN_2D_SCALE;
+}
+
+f32 harmony_perlin_3d(u32 seed, f32 x, f32 y, f32 z) {
+    f32 fx = floorf(x);
+    f32 fy = floorf(y);
+    f32 fz = floorf(z);
+    f32 d[3] = {x - fx, y - fy, z - fz};
+    u32 h[3] = {
+        (u32)(i32)fx * HARMONY_NOISE_PRIME_X,
+        (u32)(i32)fy * HARMONY_NOISE_PRIME_Y,
+        seed + (u32)(i32)fz * HARMONY_NOISE_PRIME_Z,
+    };
+
+    f32 n[8];
+    for (u32 c = 0; c < 8; ++c) {
+        u32 cx = c & 1;
+        u32 cy = (c >> 1) & 1;
+        u32 cz = c >> 2;
+        u32 hash = harmony_noise_hash((h[0] + cx * HARMONY_NOISE_PRIME_X)
+                                    + (h[1] + cy * HARMONY_NOISE_PRIME_Y)
+                                    + (h[2] + cz * HARMONY_NOISE_PRIME_Z));
+        n[c] = harmony_noise_dot3(hash, d[0] - (f32)cx, d[1] - (f32)cy, d[2] - (f32)cz);
+    }
+
+    f32 u = harmony_noise_fade(d[0]);
+    f32 v = harmony_noise_fade(d[1]);
+    f32 w = harmony_noise_fade(d[2]);
+    f32 result = harmony_noise_lerp(
+        harmony_noise_lerp(harmony_noise_lerp(n[0], n[1], u), harmony_noise_lerp(n[2], n[3], u), v),
+        harmony_noise_lerp(harmony_noise_lerp(n[4], n[5], u), harmony_noise_lerp(n[6], n[7], u), v),
+        w);
+    return result * HARMONY_PERLIN_3D_SCALE;
+}
+
+f32 harmony_perlin_4d(u32 seed, f32 x, f32 y, f32 z, f32 w) {
+    static const u32 primes[4] = {
+        HARMONY_NOISE_PRIME_X, HARMONY_NOISE_PRIME_Y, HARMONY_NOISE_PRIME_Z, HARMONY_NOISE_PRIME_W,
+    };
+    f32 p[4] = {x, y, z, w};
+    f32 d[4];
+    f32 fade[4];
+    u32 h = seed;
+    for (u32 i = 0; i < 4; ++i) {
+        f32 f = floorf(p[i]);
+        d[i] = p[i] - f;
+        fade[i] = harmony_noise_fade(d[i]);
+        h += (u32)(i32)f * primes[i];
+    }
+
+    f32 n[16];
+    for (u32 c = 0; c < 16; ++c) {
+        u32 hash = h;
+        f32 offset[4];
+        for (u32 i = 0; i < 4; ++i) {
+            u32 bit = (c >> i) & 1;
+            hash += bit * primes[i];
+            offset[i] = d[i] - (f32)bit;
+        }
+        n[c] = harmony_noise_dot4(harmony_noise_hash(hash), offset[0], offset[1], offset[2], offset[3]);
+    }
+    for (u32 i = 0; i < 4; ++i) {
+        u32 half = 8u >> i;
+        for (u32 c = 0; c < half; ++c) {
+            n[c] = harmony_noise_lerp(n[c * 2], n[c * 2 + 1], fade[i]);
+        }
+    }
+    return n[0] * HARMONY_PERLIN_4D_SCALE;
+}
+
+f32 harmony_simplex_2d(u32 seed, f32 x, f32 y) {
+    f32 s = (x + y) * HARMONY_SIMPLEX_F2;
+    f32 i = floorf(x + s);
+    f32 j = floorf(y + s);
+    f32 t = (i + j) * HARMONY_SIMPLEX_G2;
+    f32 x0 = x - (i - t);
+    f32 y0 = y - (j - t);
+    u32 i1 = x0 > y0 ? 1 : 0;
+    u32 j1 = 1 - i1;
+
+    f32 cx[3] = {x0, x0 - (f32)i1 + HARMONY_SIMPLEX_G2, x0 - 1.0f + 2.0f * HARMONY_SIMPLEX_G2};
+    f32 cy[3] = {y0, y0 - (f32)j1 + HARMONY_SIMPLEX_G2, y0 - 1.0f + 2.0f * HARMONY_SIMPLEX_G2};
+    u32 hx = (u32)(i32)i * HARMONY_NOISE_PRIME_X;
+    u32 hy = seed + (u32)(i32)j * HARMONY_NOISE_PRIME_Y;
+    u32 h[3] = {
+        hx + hy,
+        (hx + i1 * HARMONY_NOISE_PRIME_X) + (hy + j1 * HARMONY_NOISE_PRIME_Y),
+        (hx + HARMONY_NOISE_PRIME_X) + (hy + HARMONY_NOISE_PRIME_Y),
+    };
+
+    f32 result = 0.0f;
+    for (u32 c = 0; c < 3; ++c) {
+        f32 a = harmony_max(0.5f - cx[c] * cx[c] - cy[c] * cy[c], 0.0f);
+        a *= a;
+        result += a * a * harmony_noise_dot2(harmony_noise_hash(h[c]), cx[c], cy[c]);
+    }
+    return result * HARMONY_SIMPLEX_2D_SCALE;
+}
+
+f32 harmony_simplex_3d(u32 seed, f32 x, f32 y, f32 z) {
+    f32 s = (x + y + z) * HARMONY_SIMPLEX_F3;
+    f32 i = floorf(x + s);
+    f32 j = floorf(y + s);
+    f32 k = floorf(z + s);
+    f32 t = (i + j + k) * HARMONY_SIMPLEX_G3;
+    f32 x0 = x - (i - t);
+    f32 y0 = y - (j - t);
+    f32 z0 = z - (k - t);
+
+    u32 xy = x0 >= y0;
+    u32 xz = x0 >= z0;
+    u32 yz = y0 >= z0;
+    u32 i1 = xy & xz;
+    u32 j1 = (xy ^ 1) & yz;
+    u32 k1 = (xz ^ 1) & (yz ^ 1);
+    u32 i2 = xy | xz;
+    u32 j2 = (xy ^ 1) | yz;
+    u32 k2 = (xz ^ 1) | (yz ^ 1);
+
+    f32 cx[4] = {x0, x0 - (f32)i1 + HARMONY_SIMPLEX_G3, x0 - (f32)i2 + 2.0f * HARMONY_SIMPLEX_G3,
+                 x0 - 1.0f + 3.0f * HARMONY_SIMPLEX_G3};
+    f32 cy[4] = {y0, y0 - (f32)j1 + HARMONY_SIMPLEX_G3, y0 - (f32)j2 + 2.0f * HARMONY_SIMPLEX_G3,
+                 y0 - 1.0f + 3.0f * HARMONY_SIMPLEX_G3};
+    f32 cz[4] = {z0, z0 - (f32)k1 + HARMONY_SIMPLEX_G3, z0 - (f32)k2 + 2.0f * HARMONY_SIMPLEX_G3,
+                 z0 - 1.0f + 3.0f * HARMONY_SIMPLEX_G3};
+    u32 hx = (u32)(i32)i * HARMONY_NOISE_PRIME_X;
+    u32 hy = (u32)(i32)j * HARMONY_NOISE_PRIME_Y;
+    u32 hz = seed + (u32)(i32)k * HARMONY_NOISE_PRIME_Z;
+    u32 h[4] = {
+        hx + hy + hz,
+        (hx + i1 * HARMONY_NOISE_PRIME_X) + (hy + j1 * HARMONY_NOISE_PRIME_Y) + (hz + k1 * HARMONY_NOISE_PRIME_Z),
+        (hx + i2 * HARMONY_NOISE_PRIME_X) + (hy + j2 * HARMONY_NOISE_PRIME_Y) + (hz + k2 * HARMONY_NOISE_PRIME_Z),
+        (hx + HARMONY_NOISE_PRIME_X) + (hy + HARMONY_NOISE_PRIME_Y) + (hz + HARMONY_NOISE_PRIME_Z),
+    };
+
+    f32 result = 0.0f;
+    for (u32 c = 0; c < 4; ++c) {
+        f32 a = harmony_max(0.6f - cx[c] * cx[c] - cy[c] * cy[c] - cz[c] * cz[c], 0.0f);
+        a *= a;
+        result += a * a * harmony_noise_dot3(harmony_noise_hash(h[c]), cx[c], cy[c], cz[c]);
+    }
+    return result * HARMONY_SIMPLEX_3D_SCALE;
+}
+
+f32 harmony_simplex_4d(u32 seed, f32 x, f32 y, f32 z, f32 w) {
+    static const u32 primes[4] = {
+        HARMONY_NOISE_PRIME_X, HARMONY_NOISE_PRIME_Y, HARMONY_NOISE_PRIME_Z, HARMONY_NOISE_PRIME_W,
+    };
+    f32 p[4] = {x, y, z, w};
+    f32 s = (x + y + z + w) * HARMONY_SIMPLEX_F4;
+    f32 cell[4];
+    for (u32 i = 0; i < 4; ++i) {
+        cell[i] = floorf(p[i] + s);
+    }
+    f32 t = (cell[0] + cell[1] + cell[2] + cell[3]) * HARMONY_SIMPLEX_G4;
+    f32 d[4];
+    for (u32 i = 0; i < 4; ++i) {
+        d[i] = p[i] - (cell[i] - t);
+    }
+
+    // the rank of each axis orders the corners of the simplex
+    u32 rank[4] = {0, 0, 0, 0};
+    for (u32 i = 0; i < 4; ++i) {
+        for (u32 j = i + 1; j < 4; ++j) {
+            if (d[i] > d[j])
+                ++rank[i];
+            else
+                ++rank[j];
+        }
+    }
+
+    u32 base = seed;
+    for (u32 i = 0; i < 4; ++i) {
+        base += (u32)(i32)cell[i] * primes[i];
+    }
+
+    f32 result = 0.0f;
+    for (u32 c = 0; c < 5; ++c) {
+        u32 hash = base;
+        f32 offset[4];
+        f32 dist = 0.6f;
+        for (u32 i = 0; i < 4; ++i) {
+            u32 step = rank[i] + c >= 4 ? 1 : 0;
+            hash += step * primes[i];
+            offset[i] = d[i] - (f32)step + (f32)c * HARMONY_SIMPLEX_G4;
+            dist -= offset[i] * offset[i];
+        }
+        f32 a = harmony_max(dist, 0.0f);
+        a *= a;
+        result += a * a * harmony_noise_dot4(harmony_noise_hash(hash), offset[0], offset[1], offset[2], offset[3]);
+    }
+    return result * HARMONY_SIMPLEX_4D_SCALE;
+}
+
+static void harmony_noise_scalar(
+    f32 *dst,
+    const f32 *const *points,
+    usize count,
+    u32 seed,
+    u32 dimensions,
+    HarmonyNoiseType type
+) {
+    for (usize i = 0; i < count; ++i) {
+        f32 x = points[0][i];
+        f32 y = points[1][i];
+        switch (dimensions * 2 + (type == HARMONY_NOISE_SIMPLEX ? 1 : 0)) {
+            case 4: dst[i] = harmony_perlin_2d(seed, x, y); break;
+            case 5: dst[i] = harmony_simplex_2d(seed, x, y); break;
+            case 6: dst[i] = harmony_perlin_3d(seed, x, y, points[2][i]); break;
+            case 7: dst[i] = harmony_simplex_3d(seed, x, y, points[2][i]); break;
+            case 8: dst[i] = harmony_perlin_4d(seed, x, y, points[2][i], points[3][i]); break;
+            case 9: dst[i] = harmony_simplex_4d(seed, x, y, points[2][i], points[3][i]); break;
+            default: harmony_error("Invalid noise dimensions: %u\n", dimensions);
+        }
+    }
+}
+
+#ifdef HARMONY_X86_KERNELS
+
+HARMONY_TARGET_AVX2
+static inline __m256i harmony_noise_hash_avx2(__m256i h) {
+    h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 15));
+    h = _mm256_mullo_epi32(h, _mm256_set1_epi32(0x2c1b3c6d));
+    h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 12));
+    h = _mm256_mullo_epi32(h, _mm256_set1_epi32(0x297a2d39));
+    return _mm256_xor_si256(h, _mm256_srli_epi32(h, 15));
+}
+
+HARMONY_TARGET_AVX2
+static inline __m256 harmony_noise_fade_avx2(__m256 t) {
+    __m256 poly = _mm256_sub_ps(_mm256_mul_ps(t, _mm256_set1_ps(6.0f)), _mm256_set1_ps(15.0f));
+    poly = _mm256_add_ps(_mm256_mul_ps(poly, t), _mm256_set1_ps(10.0f));
+    return _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(t, t), t), poly);
+}
+
+HARMONY_TARGET_AVX2
+static inline __m256 harmony_noise_lerp_avx2(__m256 a, __m256 b, __m256 t) {
+    return _mm256_add_ps(a, _mm256_mul_ps(t, _mm256_sub_ps(b, a)));
+}
+
+HARMONY_TARGET_AVX2
+static inline __m256 harmony_noise_dot2_avx2(__m256i h, __m256 x, __m256 y) {
+    __m256 gx = _mm256_permutevar8x32_ps(_mm256_loadu_ps(harmony_noise_grad2[0]), h);
+    __m256 gy = _mm256_permutevar8x32_ps(_mm256_loadu_ps(harmony_noise_grad2[1]), h);
+    return _mm256_add_ps(_mm256_mul_ps(gx, x), _mm256_mul_ps(gy, y));
+}
+
+HARMONY_TARGET_AVX2
+static inline __m256 harmony_noise_grad3_avx2(const f32 *table, __m256i h, __m256 high) {
+    __m256 lo = _mm256_permutevar8x32_ps(_mm256_loadu_ps(table), h);
+    __m256 hi = _mm256_permutevar8x32_ps(_mm256_loadu_ps(table + 8), h);
+    return _mm256_blendv_ps(lo, hi, high);
+}
+
+HARMONY_TARGET_AVX2
+static inline __m256 harmony_noise_dot3_avx2(__m256i h, __m256 x, __m256 y, __m256 z) {
+    // bit 3 of the hash selects the upper half of the 16 gradients
+    __m256 high = _mm256_castsi256_ps(_mm256_slli_epi32(h, 28));
+    __m256 gx = harmony_noise_grad3_avx2(harmony_noise_grad3[0], h, high);
+    __m256 gy = harmony_noise_grad3_avx2(harmony_noise_grad3[1], h, high);
+    __m256 gz = harmony_noise_grad3_avx2(harmony_noise_grad3[2], h, high);
+    return _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(gx, x), _mm256_mul_ps(gy, y)), _mm256_mul_ps(gz, z));
+}
+
+HARMONY_TARGET_AVX2
+static __m256 harmony_perlin_2d_avx2(__m256i seed, __m256 x, __m256 y) {
+    __m256 one = _mm256_set1_ps(1.0f);
+    __m256i prime_x = _mm256_set1_epi32((i32)HARMONY_NOISE_PRIME_X);
+    __m256i prime_y = _mm256_set1_epi32((i32)HARMONY_NOISE_PRIME_Y);
+    __m256 fx = _mm256_floor_ps(x);
+    __m256 fy = _mm256_floor_ps(y);
+    __m256 dx = _mm256_sub_ps(x, fx);
+    __m256 dy = _mm256_sub_ps(y, fy);
+    __m256i hx = _mm256_mullo_epi32(_mm256_cvttps_epi32(fx), prime_x);
+    __m256i hy = _mm256_add_epi32(seed, _mm256_mullo_epi32(_mm256_cvttps_epi32(fy), prime_y));
+    __m256i hx1 = _mm256_add_epi32(hx, prime_x);
+    __m256i hy1 = _mm256_add_epi32(hy, prime_y);
+
+    __m256 n00 = harmony_noise_dot2_avx2(harmony_noise_hash_avx2(_mm256_add_epi32(hx, hy)), dx, dy);
+    __m256 n10 = harmony_noise_dot2_avx2(harmony_noise_hash_avx2(_mm256_add_epi32(hx1, hy)), _mm256_sub_ps(dx, one), dy);
+    __m256 n01 = harmony_noise_dot2_avx2(harmony_noise_hash_avx2(_mm256_add_epi32(hx, hy1)), dx, _mm256_sub_ps(dy, one));
+    __m256 n11 = harmony_noise_dot2_avx2(
+        harmony_noise_hash_avx2(_mm256_add_epi32(hx1, hy1)), _mm256_sub_ps(dx, one), _mm256_sub_ps(dy, one));
+
+    __m256 u = harmony_noise_fade_avx2(dx);
+    __m256 v = harmony_noise_fade_avx2(dy);
+    __m256 result = harmony_noise_lerp_avx2(
+        harmony_noise_lerp_avx2(n00, n10, u), harmony_noise_lerp_avx2(n01, n11, u), v);
+    return _mm256_mul_ps(result, _mm256_set1_ps(HARMONY_PERLIN_2D_SCALE));
+}
+
+HARMONY_TARGET_AVX2
+static __m256 harmony_perlin_3d_avx2(__m256i seed, __m256 x, __m256 y, __m256 z) {
+    __m256 one = _mm256_set1_ps(1.0f);
+    __m256i prime_x = _mm256_set1_epi32((i32)HARMONY_NOISE_PRIME_X);
+    __m256i prime_y = _mm256_set1_epi32((i32)HARMONY_NOISE_PRIME_Y);
+    __m256i prime_z = _mm256_set1_epi32((i32)HARMONY_NOISE_PRIME_Z);
+    __m256 fx = _mm256_floor_ps(x);
+    __m256 fy = _mm256_floor_ps(y);
+    __m256 fz = _mm256_floor_ps(z);
+    __m256 d0[3] = {_mm256_sub_ps(x, fx), _mm256_sub_ps(y, fy), _mm256_sub_ps(z, fz)};
+    __m256 d1[3] = {_mm256_sub_ps(d0[0], one), _mm256_sub_ps(d0[1], one), _mm256_sub_ps(d0[2], one)};
+    __m256i hx[2];
+    __m256i hy[2];
+    __m256i hz[2];
+    hx[0] = _mm256_mullo_epi32(_mm256_cvttps_epi32(fx), prime_x);
+    hy[0] = _mm256_mullo_epi32(_mm256_cvttps_epi32(fy), prime_y);
+    hz[0] = _mm256_add_epi32(seed, _mm256_mullo_epi32(_mm256_cvttps_epi32(fz), prime_z));
+    hx[1] = _mm256_add_epi32(hx[0], prime_x);
+    hy[1] = _mm256_add_epi32(hy[0], prime_y);
+    hz[1] = _mm256_add_epi32(hz[0], prime_z);
+
+    __m256 n[8];
+    for (u32 c = 0; c < 8; ++c) {
+        u32 cx = c & 1;
+        u32 cy = (c >> 1) & 1;
+        u32 cz = c >> 2;
+        __m256i hash = harmony_noise_hash_avx2(_mm256_add_epi32(_mm256_add_epi32(hx[cx], hy[cy]), hz[cz]));
+        n[c] = harmony_noise_dot3_avx2(hash, cx ? d1[0] : d0[0], cy ? d1[1] : d0[1], cz ? d1[2] : d0[2]);
+    }
+
+    __m256 u = harmony_noise_fade_avx2(d0[0]);
+    __m256 v = harmony_noise_fade_avx2(d0[1]);
+    __m256 w = harmony_noise_fade_avx2(d0[2]);
+    __m256 result = harmony_noise_lerp_avx2(
+        harmony_noise_lerp_avx2(harmony_noise_lerp_avx2(n[0], n[1], u), harmony_noise_lerp_avx2(n[2], n[3], u), v),
+        harmony_noise_lerp_avx2(harmony_noise_lerp_avx2(n[4], n[5], u), harmony_noise_lerp_avx2(n[6], n[7], u), v),
+        w);
+    return _mm256_mul_ps(result, _mm256_set1_ps(HARMONY_PERLIN_3D_SCALE));
+}
+
+HARMONY_TARGET_AVX2
+static __m256 harmony_simplex_2d_avx2(__m256i seed, __m256 x, __m256 y) {
+    __m256 one = _mm256_set1_ps(1.0f);
+    __m256 g2 = _mm256_set1_ps(HARMONY_SIMPLEX_G2);
+    __m256i prime_x = _mm256_set1_epi32((i32)HARMONY_NOISE_PRIME_X);
+    __m256i prime_y = _mm256_set1_epi32((i32)HARMONY_NOISE_PRIME_Y);
+    __m256 s = _mm256_mul_ps(_mm256_add_ps(x, y), _mm256_set1_ps(HARMONY_SIMPLEX_F2));
+    __m256 i = _mm256_floor_ps(_mm256_add_ps(x, s));
+    __m256 j = _mm256_floor_ps(_mm256_add_ps(y, s));
+    __m256 t = _mm256_mul_ps(_mm256_add_ps(i, j), g2);
+    __m256 x0 = _mm256_sub_ps(x, _mm256_sub_ps(i, t));
+    __m256 y0 = _mm256_sub_ps(y, _mm256_sub_ps(j, t));
+    __m256 i1 = _mm256_cmp_ps(x0, y0, _CMP_GT_OQ);
+
+    __m256 cx[3] = {
+        x0,
+        _mm256_add_ps(_mm256_sub_ps(x0, _mm256_and_ps(i1, one)), g2),
+        _mm256_add_ps(_mm256_sub_ps(x0, one), _mm256_set1_ps(2.0f * HARMONY_SIMPLEX_G2)),
+    };
+    __m256 cy[3] = {
+        y0,
+        _mm256_add_ps(_mm256_sub_ps(y0, _mm256_andnot_ps(i1, one)), g2),
+        _mm256_add_ps(_mm256_sub_ps(y0, one), _mm256_set1_ps(2.0f * HARMONY_SIMPLEX_G2)),
+    };
+    __m256i hx = _mm256_mullo_epi32(_mm256_cvttps_epi32(i), prime_x);
+    __m256i hy = _mm256_add_epi32(seed, _mm256_mullo_epi32(_mm256_cvttps_epi32(j), prime_y));
+    __m256i h[3] = {
+        _mm256_add_epi32(hx, hy),
+        _mm256_add_epi32(
+            _mm256_add_epi32(hx, _mm256_and_si256(_mm256_castps_si256(i1), prime_x)),
+            _mm256_add_epi32(hy, _mm256_andnot_si256(_mm256_castps_si256(i1), prime_y))),
+        _mm256_add_epi32(_mm256_add_epi32(hx, prime_x), _mm256_add_epi32(hy, prime_y)),
+    };
+
+    __m256 result = _mm256_setzero_ps();
+    for (u32 c = 0; c < 3; ++c) {
+        __m256 a = _mm256_sub_ps(_mm256_sub_ps(_mm256_set1_ps(0.5f), _mm256_mul_ps(cx[c], cx[c])), _mm256_mul_ps(cy[c], cy[c]));
+        a = _mm256_max_ps(a, _mm256_setzero_ps());
+        a = _mm256_mul_ps(a, a);
+        __m256 dot = harmony_noise_dot2_avx2(harmony_noise_hash_avx2(h[c]), cx[c], cy[c]);
+        result = _mm256_add_ps(result, _mm256_mul_ps(_mm256_mul_ps(a, a), dot));
+    }
+    return _mm256_mul_ps(result, _mm256_set1_ps(HARMONY_SIMPLEX_2D_SCALE));
+}
+
+HARMONY_TARGET_AVX2
+static __m256 harmony_simplex_3d_avx2(__m256i seed, __m256 x, __m256 y, __m256 z) {
+    __m256 one = _mm256_set1_ps(1.0f);
+    __m256 ones = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+    __m256i prime_x = _mm256_set1_epi32((i32)HARMONY_NOISE_PRIME_X);
+    __m256i prime_y = _mm256_set1_epi32((i32)HARMONY_NOISE_PRIME_Y);
+    __m256i prime_z = _mm256_set1_epi32((i32)HARMONY_NOISE_PRIME_Z);
+    __m256 s = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(x, y), z), _mm256_set1_ps(HARMONY_SIMPLEX_F3));
+    __m256 i = _mm256_floor_ps(_mm256_add_ps(x, s));
+    __m256 j = _mm256_floor_ps(_mm256_add_ps(y, s));
+    __m256 k = _mm256_floor_ps(_mm256_add_ps(z, s));
+    __m256 t = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(i, j), k), _mm256_set1_ps(HARMONY_SIMPLEX_G3));
+    __m256 x0 = _mm256_sub_ps(x, _mm256_sub_ps(i, t));
+    __m256 y0 = _mm256_sub_ps(y, _mm256_sub_ps(j, t));
+    __m256 z0 = _mm256_sub_ps(z, _mm256_sub_ps(k, t));
+
+    __m256 xy = _mm256_cmp_ps(x0, y0, _CMP_GE_OQ);
+    __m256 xz = _mm256_cmp_ps(x0, z0, _CMP_GE_OQ);
+    __m256 yz = _mm256_cmp_ps(y0, z0, _CMP_GE_OQ);
+    __m256 step[2][3] = {
+        {_mm256_and_ps(xy, xz), _mm256_andnot_ps(xy, yz), _mm256_andnot_ps(_mm256_or_ps(xz, yz), ones)},
+        {_mm256_or_ps(xy, xz), _mm256_or_ps(_mm256_andnot_ps(xy, ones), yz), _mm256_andnot_ps(_mm256_and_ps(xz, yz), ones)},
+    };
+
+    __m256 c0[3] = {x0, y0, z0};
+    __m256 cx[4][3];
+    __m256i hx = _mm256_mullo_epi32(_mm256_cvttps_epi32(i), prime_x);
+    __m256i hy = _mm256_mullo_epi32(_mm256_cvttps_epi32(j), prime_y);
+    __m256i hz = _mm256_add_epi32(seed, _mm256_mullo_epi32(_mm256_cvttps_epi32(k), prime_z));
+    __m256i primes[3] = {prime_x, prime_y, prime_z};
+    __m256i h[4];
+    for (u32 a = 0; a < 3; ++a) {
+        cx[0][a] = c0[a];
+        cx[1][a] = _mm256_add_ps(_mm256_sub_ps(c0[a], _mm256_and_ps(step[0][a], one)), _mm256_set1_ps(HARMONY_SIMPLEX_G3));
+        cx[2][a] = _mm256_add_ps(_mm256_sub_ps(c0[a], _mm256_and_ps(step[1][a], one)), _mm256_set1_ps(2.0f * HARMONY_SIMPLEX_G3));
+        cx[3][a] = _mm256_add_ps(_mm256_sub_ps(c0[a], one), _mm256_set1_ps(3.0f * HARMONY_SIMPLEX_G3));
+    }
+    h[0] = _mm256_add_epi32(_mm256_add_epi32(hx, hy), hz);
+    h[3] = _mm256_add_epi32(h[0], _mm256_add_epi32(_mm256_add_epi32(prime_x, prime_y), prime_z));
+    for (u32 c = 1; c < 3; ++c) {
+        h[c] = h[0];
+        for (u32 a = 0; a < 3; ++a) {
+            h[c] = _mm256_add_epi32(h[c], _mm256_and_si256(_mm256_castps_si256(step[c - 1][a]), primes[a]));
+        }
+    }
+
+    __m256 result = _mm256_setzero_ps();
+    for (u32 c = 0; c < 4; ++c) {
+        __m256 a = _mm256_sub_ps(_mm256_set1_ps(0.6f), _mm256_mul_ps(cx[c][0], cx[c][0]));
+        a = _mm256_sub_ps(a, _mm256_mul_ps(cx[c][1], cx[c][1]));
+        a = _mm256_sub_ps(a, _mm256_mul_ps(cx[c][2], cx[c][2]));
+        a = _mm256_max_ps(a, _mm256_setzero_ps());
+        a = _mm256_mul_ps(a, a);
+        __m256 dot = harmony_noise_dot3_avx2(harmony_noise_hash_avx2(h[c]), cx[c][0], cx[c][1], cx[c][2]);
+        result = _mm256_add_ps(result, _mm256_mul_ps(_mm256_mul_ps(a, a), dot));
+    }
+    return _mm256_mul_ps(result, _mm256_set1_ps(HARMONY_SIMPLEX_3D_SCALE));
+}
+
+HARMONY_TARGET_AVX2
+static void harmony_noise_avx2(
+    f32 *dst,
+    const f32 *const *points,
+    usize count,
+    u32 seed,
+    u32 dimensions,
+    HarmonyNoiseType type
+) {
+    if (dimensions > 3) {
+        harmony_noise_scalar(dst, points, count, seed, dimensions, type);
+        return;
+    }
+    __m256i seeds = _mm256_set1_epi32((i32)seed);
+    usize i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 x = _mm256_loadu_ps(points[0] + i);
+        __m256 y = _mm256_loadu_ps(points[1] + i);
+        __m256 result;
+        if (dimensions == 2) {
+            result = type == HARMONY_NOISE_SIMPLEX
+                ? harmony_simplex_2d_avx2(seeds, x, y)
+                : harmony_perlin_2d_avx2(seeds, x, y);
+        } else {
+            __m256 z = _mm256_loadu_ps(points[2] + i);
+            result = type == HARMONY_NOISE_SIMPLEX
+                ? harmony_simplex_3d_avx2(seeds, x, y, z)
+                : harmony_perlin_3d_avx2(seeds, x, y, z);
+        }
+        _mm256_storeu_ps(dst + i, result);
+    }
+    const f32 *tail[4] = {points[0] + i, points[1] + i, dimensions > 2 ? points[2] + i : NULL, NULL};
+    harmony_noise_scalar(dst + i, tail, count - i, seed, dimensions, type);
+}
+
+#endif // HARMONY_X86_KERNELS
+
+/**
+ * The number of samples computed at a time along a row, kept on the stack
+ */
+#define HARMONY_NOISE_CHUNK 256
+
+static f32 harmony_noise_octave_sum(const HarmonyNoiseConfig *config, f32 sum, f32 octave, f32 amplitude) {
+    if (config->fractal == HARMONY_NOISE_RIDGED) {
+        f32 ridge = 1.0f - fabsf(octave);
+        return sum + ridge * ridge * amplitude;
+    }
+    return sum + octave * amplitude;
+}
+
+static f32 harmony_noise_amplitude_sum(const HarmonyNoiseConfig *config) {
+    f32 amplitude = 1.0f;
+    f32 total = 0.0f;
+    for (u32 o = 0; o < config->octaves; ++o) {
+        total += amplitude;
+        amplitude *= config->gain;
+    }
+    return total;
+}
+
+f32 harmony_noise_sample(const HarmonyNoise *noise, const HarmonyNoiseConfig *config, const f32 *point) {
+    harmony_assert(noise != NULL);
+    harmony_assert(config != NULL);
+    harmony_assert(point != NULL);
+    harmony_assert(config->dimensions >= 2 && config->dimensions <= 4);
+    harmony_assert(config->octaves >= 1 && config->octaves <= HARMONY_NOISE_MAX_OCTAVES);
+
+    f32 sum = 0.0f;
+    f32 amplitude = 1.0f;
+    f32 frequency = config->frequency;
+    for (u32 o = 0; o < config->octaves; ++o) {
+        f32 p[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+        const f32 *points[4] = {&p[0], &p[1], &p[2], &p[3]};
+        for (u32 i = 0; i < config->dimensions; ++i) {
+            p[i] = point[i] * frequency;
+        }
+        f32 octave;
+        harmony_noise_scalar(&octave, points, 1, noise->seeds[o], config->dimensions, config->type);
+        sum = harmony_noise_octave_sum(config, sum, octave, amplitude);
+        amplitude *= config->gain;
+        frequency *= config->lacunarity;
+    }
+    return sum / harmony_noise_amplitude_sum(config);
+}
+
+static void harmony_noise_fill_rows(
+    f32 *dst,
+    const HarmonyNoise *noise,
+    const HarmonyNoiseConfig *config,
+    const HarmonyNoiseRegion *region,
+    usize first_row,
+    usize last_row
+) {
+    const HarmonyKernels *kernels = harmony_kernels();
+    f32 scale = 1.0f / harmony_noise_amplitude_sum(config);
+    f32 coords[4][HARMONY_NOISE_CHUNK];
+    f32 octave[HARMONY_NOISE_CHUNK];
+    f32 sum[HARMONY_NOISE_CHUNK];
+    const f32 *points[4] = {coords[0], coords[1], coords[2], coords[3]};
+
+    for (usize row = first_row; row < last_row; ++row) {
+        f32 point[4] = {
+            0.0f,
+            region->origin[1] + (f32)(row % region->height) * region->step[1],
+            region->origin[2] + (f32)(row / region->height) * region->step[2],
+            region->origin[3],
+        };
+        f32 *row_dst = dst + row * region->width;
+        for (usize x = 0; x < region->width; x += HARMONY_NOISE_CHUNK) {
+            usize n = harmony_min(region->width - x, (usize)HARMONY_NOISE_CHUNK);
+            for (usize i = 0; i < n; ++i) {
+                sum[i] = 0.0f;
+            }
+            f32 amplitude = 1.0f;
+            f32 frequency = config->frequency;
+            for (u32 o = 0; o < config->octaves; ++o) {
+                for (usize i = 0; i < n; ++i) {
+                    coords[0][i] = (region->origin[0] + (f32)(x + i) * region->step[0]) * frequency;
+                }
+                for (u32 d = 1; d < config->dimensions; ++d) {
+                    f32 value = point[d] * frequency;
+                    for (usize i = 0; i < n; ++i) {
+                        coords[d][i] = value;
+                    }
+                }
+                kernels->noise(octave, points, n, noise->seeds[o], config->dimensions, config->type);
+                for (usize i = 0; i < n; ++i) {
+                    sum[i] = harmony_noise_octave_sum(config, sum[i], octave[i], amplitude);
+                }
+                amplitude *= config->gain;
+                frequency *= config->lacunarity;
+            }
+            for (usize i = 0; i < n; ++i) {
+                row_dst[x + i] = sum[i] * scale;
+            }
+        }
+    }
+}
+
+void harmony_noise_fill(
+    f32 *dst,
+    const HarmonyNoise *noise,
+    const HarmonyNoiseConfig *config,
+    const HarmonyNoiseRegion *region
+) {
+    harmony_assert(dst != NULL);
+    harmony_assert(noise != NULL);
+    harmony_assert(config != NULL);
+    harmony_assert(region != NULL);
+    harmony_assert(config->dimensions >= 2 && config->dimensions <= 4);
+    harmony_assert(config->octaves >= 1 && config->octaves <= HARMONY_NOISE_MAX_OCTAVES);
+    harmony_assert(config->dimensions > 2 || region->depth == 1);
+    harmony_noise_fill_rows(dst, noise, config, region, 0, (usize)region->height * region->depth);
+}
+
+typedef struct HarmonyNoiseFillArgs {
+    f32 *dst;
+    const HarmonyNoise *noise;
+    const HarmonyNoiseConfig *config;
+    const HarmonyNoiseRegion *region;
+} HarmonyNoiseFillArgs;
+
+static void harmony_noise_fill_range(void *data, usize begin, usize end) {
+    HarmonyNoiseFillArgs *args = data;
+    harmony_noise_fill_rows(args->dst, args->noise, args->config, args->region, begin, end);
+}
+
+void harmony_noise_fill_parallel(
+    u32 thread_count,
+    f32 *dst,
+    const HarmonyNoise *noise,
+    const HarmonyNoiseConfig *config,
+    const HarmonyNoiseRegion *region
+) {
+    harmony_assert(dst != NULL);
+    harmony_assert(noise != NULL);
+    harmony_assert(config != NULL);
+    harmony_assert(region != NULL);
+    harmony_assert(config->dimensions >= 2 && config->dimensions <= 4);
+    harmony_assert(config->octaves >= 1 && config->octaves <= HARMONY_NOISE_MAX_OCTAVES);
+    harmony_assert(config->dimensions > 2 || region->depth == 1);
+    HarmonyNoiseFillArgs args = {dst, noise, config, region};
+    harmony_parallel_for(thread_count, (usize)region->height * region->depth, harmony_noise_fill_range, &args);
+}
+
+static Complex harmony_fft_twiddle(const Complex *twiddles, usize index, bool inverse) {
+    Complex w = twiddles[index];
+    if (inverse)
+        w.i = -w.i;
+    return w;
+}
+
+static void harmony_fft_pass_scalar(
+    Complex *dst,
+    const Complex *src,
+    const Complex *twiddles,
+    const Complex *roots,
+    u32 radix,
+    usize l1,
+    usize ido,
+    bool inverse
+) {
+    if (radix == 2) {
+        for (usize k = 0; k < l1; ++k) {
+            for (usize i = 0; i < ido; ++i) {
+                Complex a = src[i + ido * (2 * k)];
+                Complex b = src[i + ido * (2 * k + 1)];
+                dst[i + ido * k] = cadd(a, b);
+                dst[i + ido * (k + l1)] = cmul(csub(a, b), harmony_fft_twiddle(twiddles, i, inverse));
+            }
+        }
+    } else if (radix == 4) {
+        for (usize k = 0; k < l1; ++k) {
+            for (usize i = 0; i < ido; ++i) {
+                Complex a0 = src[i + ido * (4 * k)];
+                Complex a1 = src[i + ido * (4 * k + 1)];
+                Complex a2 = src[i + ido * (4 * k + 2)];
+                Complex a3 = src[i + ido * (4 * k + 3)];
+                Complex t0 = cadd(a0, a2);
+                Complex t1 = csub(a0, a2);
+                Complex t2 = cadd(a1, a3);
+                Complex t3 = csub(a1, a3);
+                // multiplies t3 by -i, or by i for the inverse
+                Complex rotated = inverse ? (Complex){-t3.i, t3.r} : (Complex){t3.i, -t3.r};
+                dst[i + ido * k] = cadd(t0, t2);
+                dst[i + ido * (k + l1)] = cmul(cadd(t1, rotated), harmony_fft_twiddle(twiddles, i, inverse));
+                dst[i + ido * (k + l1 * 2)] = cmul(csub(t0, t2), harmony_fft_twiddle(twiddles, ido + i, inverse));
+                dst[i + ido * (k + l1 * 3)] = cmul(csub(t1, rotated), harmony_fft_twiddle(twiddles, ido * 2 + i, inverse));
+            }
+        }
+    } else {
+        for (usize k = 0; k < l1; ++k) {
+            for (usize i = 0; i < ido; ++i) {
+                for (u32 j = 0; j < radix; ++j) {
+                    Complex sum = {0.0f, 0.0f};
+                    for (u32 q = 0; q < radix; ++q) {
+                        Complex root = harmony_fft_twiddle(roots, (usize)q * j % radix, inverse);
+                        sum = cadd(sum, cmul(src[i + ido * (q + radix * k)], root));
+                    }
+                    if (j > 0)
+                        sum = cmul(sum, harmony_fft_twiddle(twiddles, (j - 1) * ido + i, inverse));
+                    dst[i + ido * (k + l1 * j)] = sum;
+                }
+            }
+        }
+    }
+}
+
+#ifdef HARMONY_X86_KERNELS
+
+/**
+ * Multiplies four interleaved complex numbers
+ */
+HARMONY_TARGET_AVX2
+static inline __m256 harmony_fft_cmul_avx2(__m256 lhs, __m256 rhs) {
+    __m256 swapped = _mm256_permute_ps(lhs, _MM_SHUFFLE(2, 3, 0, 1));
+    return _mm256_addsub_ps(
+        _mm256_mul_ps(lhs, _mm256_moveldup_ps(rhs)),
+        _mm256_mul_ps(swapped, _mm256_movehdup_ps(rhs)));
+}
+
+HARMONY_TARGET_AVX2
+static void harmony_fft_pass_avx2(
+    Complex *dst,
+    const Complex *src,
+    const Complex *twiddles,
+    const Complex *roots,
+    u32 radix,
+    usize l1,
+    usize ido,
+    bool inverse
+) {
+    if ((radix != 2 && radix != 4) || ido % 4 != 0) {
+        harmony_fft_pass_scalar(dst, src, twiddles, roots, radix, l1, ido, inverse);
+        return;
+    }
+    f32 *out = (f32 *)dst;
+    const f32 *in = (const f32 *)src;
+    const f32 *tw = (const f32 *)twiddles;
+    // negating the imaginary parts of the twiddles conjugates them
+    __m256 conj = inverse ? _mm256_setr_ps(0.0f, -0.0f, 0.0f, -0.0f, 0.0f, -0.0f, 0.0f, -0.0f) : _mm256_setzero_ps();
+
+    if (radix == 2) {
+        for (usize k = 0; k < l1; ++k) {
+            for (usize i = 0; i < ido; i += 4) {
+                __m256 a = _mm256_loadu_ps(in + 2 * (i + ido * (2 * k)));
+                __m256 b = _mm256_loadu_ps(in + 2 * (i + ido * (2 * k + 1)));
+                __m256 w = _mm256_xor_ps(_mm256_loadu_ps(tw + 2 * i), conj);
+                _mm256_storeu_ps(out + 2 * (i + ido * k), _mm256_add_ps(a, b));
+                _mm256_storeu_ps(out + 2 * (i + ido * (k + l1)), harmony_fft_cmul_avx2(_mm256_sub_ps(a, b), w));
+            }
+        }
+        return;
+    }
+
+    // multiplying by -i swaps the parts and negates the new imaginary part
+    __m256 rotate_sign = inverse
+        ? _mm256_setr_ps(-0.0f, 0.0f, -0.0f, 0.0f, -0.0f, 0.0f, -0.0f, 0.0f)
+        : _mm256_setr_ps(0.0f, -0.0f, 0.0f, -0.0f, 0.0f, -0.0f, 0.0f, -0.0f);
+    for (usize k = 0; k < l1; ++k) {
+        for (usize i = 0; i < ido; i += 4) {
+            __m256 a0 = _mm256_loadu_ps(in + 2 * (i + ido * (4 * k)));
+            __m256 a1 = _mm256_loadu_ps(in + 2 * (i + ido * (4 * k + 1)));
+            __m256 a2 = _mm256_loadu_ps(in + 2 * (i + ido * (4 * k + 2)));
+            __m256 a3 = _mm256_loadu_ps(in + 2 * (i + ido * (4 * k + 3)));
+            __m256 t0 = _mm256_add_ps(a0, a2);
+            __m256 t1 = _mm256_sub_ps(a0, a2);
+            __m256 t2 = _mm256_add_ps(a1, a3);
+            __m256 t3 = _mm256_sub_ps(a1, a3);
+            __m256 rotated = _mm256_xor_ps(_mm256_permute_ps(t3, _MM_SHUFFLE(2, 3, 0, 1)), rotate_sign);
+            __m256 w1 = _mm256_xor_ps(_mm256_loadu_ps(tw + 2 * i), conj);
+            __m256 w2 = _mm256_xor_ps(_mm256_loadu_ps(tw + 2 * (ido + i)), conj);
+            __m256 w3 = _mm256_xor_ps(_mm256_loadu_ps(tw + 2 * (ido * 2 + i)), conj);
+            _mm256_storeu_ps(out + 2 * (i + ido * k), _mm256_add_ps(t0, t2));
+            _mm256_storeu_ps(out + 2 * (i + ido * (k + l1)), harmony_fft_cmul_avx2(_mm256_add_ps(t1, rotated), w1));
+            _mm256_storeu_ps(out + 2 * (i + ido * (k + l1 * 2)), harmony_fft_cmul_avx2(_mm256_sub_ps(t0, t2), w2));
+            _mm256_storeu_ps(out + 2 * (i + ido * (k + l1 * 3)), harmony_fft_cmul_avx2(_mm256_sub_ps(t1, rotated), w3));
+        }
+    }
+}
+
+#endif // HARMONY_X86_KERNELS
+
+static u32 harmony_fft_factor(u32 *factors, usize size) {
+    u32 count = 0;
+    while (size % 4 == 0) {
+        harmony_assert(count < HARMONY_FFT_MAX_FACTORS);
+        factors[count++] = 4;
+        size /= 4;
+    }
+    while (size % 2 == 0) {
+        harmony_assert(count < HARMONY_FFT_MAX_FACTORS);
+        factors[count++] = 2;
+        size /= 2;
+    }
+    for (usize p = 3; p * p <= size; p += 2) {
+        while (size % p == 0) {
+            harmony_assert(count < HARMONY_FFT_MAX_FACTORS);
+            factors[count++] = (u32)p;
+            size /= p;
+        }
+    }
+    if (size > 1) {
+        harmony_assert(count < HARMONY_FFT_MAX_FACTORS);
+        factors[count++] = (u32)size;
+    }
+    return count;
+}
+
+static Complex harmony_fft_root(usize index, usize size) {
+    f64 angle = -2.0 * PI * (f64)index / (f64)size;
+    return (Complex){(f32)cos(angle), (f32)sin(angle)};
+}
+
+static HarmonyFftPlan harmony_fft_plan_alloc(const HarmonyAllocator *allocator, usize size, usize real_size) {
+    harmony_assert(allocator != NULL);
+    harmony_assert(size > 0);
+
+    HarmonyFftPlan plan = {0};
+    plan.size = size;
+    plan.factor_count = harmony_fft_factor(plan.factors, size);
+
+    usize twiddle_count = 0;
+    usize l1 = 1;
+    for (u32 s = 0; s < plan.factor_count; ++s) {
+        u32 radix = plan.factors[s];
+        usize ido = size / (l1 * radix);
+        twiddle_count += (radix - 1) * ido + (radix == 2 || radix == 4 ? 0 : radix);
+        l1 *= radix;
+    }
+    usize real_count = real_size / 2;
+    usize count = twiddle_count + real_count + size;
+    plan.allocation_size = count * sizeof(Complex);
+    plan.allocation = harmony_alloc(allocator, plan.allocation_size);
+    harmony_assert(plan.allocation != NULL);
+    plan.twiddles = plan.allocation;
+    plan.real_twiddles = real_size > 0 ? plan.twiddles + twiddle_count : NULL;
+    plan.scratch = plan.twiddles + twiddle_count + real_count;
+
+    Complex *twiddles = plan.twiddles;
+    l1 = 1;
+    for (u32 s = 0; s < plan.factor_count; ++s) {
+        u32 radix = plan.factors[s];
+        usize ido = size / (l1 * radix);
+        for (u32 j = 1; j < radix; ++j) {
+            for (usize i = 0; i < ido; ++i) {
+                *twiddles++ = harmony_fft_root(j * l1 * i, size);
+            }
+        }
+        if (radix != 2 && radix != 4) {
+            for (u32 q = 0; q < radix; ++q) {
+                *twiddles++ = harmony_fft_root(q, radix);
+            }
+        }
+        l1 *= radix;
+    }
+    for (usize k = 0; k < real_count; ++k) {
+        plan.real_twiddles[k] = harmony_fft_root(k, real_size);
+    }
+    return plan;
+}
+
+HarmonyFftPlan harmony_fft_plan_create(const HarmonyAllocator *allocator, usize size) {
+    return harmony_fft_plan_alloc(allocator, size, 0);
+}
+
+HarmonyFftPlan harmony_fft_real_plan_create(const HarmonyAllocator *allocator, usize size) {
+    harmony_assert(size >= 2 && (size & 1) == 0);
+    return harmony_fft_plan_alloc(allocator, size / 2, size);
+}
+
+void harmony_fft_plan_destroy(const HarmonyAllocator *allocator, HarmonyFftPlan *plan) {
+    harmony_assert(allocator != NULL);
+    harmony_assert(plan != NULL);
+    harmony_free(allocator, plan->allocation, plan->allocation_size);
+    *plan = (HarmonyFftPlan){0};
+}
+
+static void harmony_fft_transform(const HarmonyFftPlan *plan, Complex *dst, const Complex *src, bool inverse) {
+    usize size = plan->size;
+    u32 count = plan->factor_count;
+    if (count == 0) {
+        dst[0] = src[0];
+        return;
+    }
+
+    // passes alternate between dst and the scratch, ending in dst
+    const Complex *in = src;
+    if (src == dst && count % 2 == 1) {
+        memcpy(plan->scratch, src, size * sizeof(*src));
+        in = plan->scratch;
+    }
+    const HarmonyKernels *kernels = harmony_kernels();
+    const Complex *twiddles = plan->twiddles;
+    usize l1 = 1;
+    for (u32 s = 0; s < count; ++s) {
+        u32 radix = plan->factors[s];
+        usize ido = size / (l1 * radix);
+        Complex *out = (count - 1 - s) % 2 == 0 ? dst : plan->scratch;
+        const Complex *roots = twiddles + (radix - 1) * ido;
+        kernels->fft_pass(out, in, twiddles, roots, radix, l1, ido, inverse);
+        twiddles = roots + (radix == 2 || radix == 4 ? 0 : radix);
+        in = out;
+        l1 *= radix;
+    }
+}
+
+void harmony_fft(const HarmonyFftPlan *plan, Complex *dst, const Complex *src) {
+    harmony_assert(plan != NULL);
+    harmony_assert(dst != NULL);
+    harmony_assert(src != NULL);
+    harmony_fft_transform(plan, dst, src, false);
+}
+
+void harmony_fft_inverse(const HarmonyFftPlan *plan, Complex *dst, const Complex *src) {
+    harmony_assert(plan != NULL);
+    harmony_assert(dst != NULL);
+    harmony_assert(src != NULL);
+    harmony_fft_transform(plan, dst, src, true);
+    f32 scale = 1.0f / (f32)plan->size;
+    f32 *values = (f32 *)dst;
+    for (usize i = 0; i < plan->size * 2; ++i) {
+        values[i] *= scale;
+    }
+}
+
+void harmony_fft_real(const HarmonyFftPlan *plan, Complex *dst, const f32 *src) {
+    harmony_assert(plan != NULL);
+    harmony_assert(plan->real_twiddles != NULL);
+    harmony_assert(dst != NULL);
+    harmony_assert(src != NULL);
+
+    // even values are packed into the real parts and odd into the imaginary,
+    // then the half size spectrum is split into the spectra of each
+    usize half = plan->size;
+    harmony_fft_transform(plan, dst, (const Complex *)src, false);
+    Complex first = dst[0];
+    dst[0] = (Complex){first.r + first.i, 0.0f};
+    dst[half] = (Complex){first.r - first.i, 0.0f};
+    for (usize k = 1; k <= half / 2; ++k) {
+        Complex a = dst[k];
+        Complex b = dst[half - k];
+        for (u32 side = 0; side < 2; ++side) {
+            usize index = side == 0 ? k : half - k;
+            Complex conj = {b.r, -b.i};
+            Complex even = cadd(a, conj);
+            even = (Complex){even.r * 0.5f, even.i * 0.5f};
+            Complex odd = csub(a, conj);
+            odd = (Complex){odd.i * 0.5f, -odd.r * 0.5f};
+            dst[index] = cadd(even, cmul(plan->real_twiddles[index], odd));
+            Complex swap = a;
+            a = b;
+            b = swap;
+        }
+    }
+}
+
+void harmony_fft_real_inverse(const HarmonyFftPlan *plan, f32 *dst, const Complex *src) {
+    harmony_assert(plan != NULL);
+    harmony_assert(plan->real_twiddles != NULL);
+    harmony_assert(dst != NULL);
+    harmony_assert(src != NULL);
+
+    usize half = plan->size;
+    Complex *packed = (Complex *)dst;
+    for (usize k = 0; k < half; ++k) {
+        Complex a = src[k];
+        Complex conj = {src[half - k].r, -src[half - k].i};
+        Complex even = cadd(a, conj);
+        Complex diff = csub(a, conj);
+        Complex w = plan->real_twiddles[k];
+        Complex odd = cmul((Complex){w.r, -w.i}, diff);
+        packed[k] = (Complex){(even.r - odd.i) * 0.5f, (even.i + odd.r) * 0.5f};
+    }
+    harmony_fft_inverse(plan, packed, packed);
+}
+
+HarmonyFft2dPlan harmony_fft_2d_plan_create(const HarmonyAllocator *allocator, usize width, usize height) {
+    harmony_assert(allocator != NULL);
+    harmony_assert(width > 0 && height > 0);
+    HarmonyFft2dPlan plan = {
+        .rows = harmony_fft_plan_create(allocator, width),
+        .columns = harmony_fft_plan_create(allocator, height),
+        .transposed = harmony_alloc(allocator, width * height * sizeof(Complex)),
+    };
+    harmony_assert(plan.transposed != NULL);
+    return plan;
+}
+
+void harmony_fft_2d_plan_destroy(const HarmonyAllocator *allocator, HarmonyFft2dPlan *plan) {
+    harmony_assert(allocator != NULL);
+    harmony_assert(plan != NULL);
+    harmony_free(allocator, plan->transposed, plan->rows.size * plan->columns.size * sizeof(Complex));
+    harmony_fft_plan_destroy(allocator, &plan->columns);
+    harmony_fft_plan_destroy(allocator, &plan->rows);
+    plan->transposed = NULL;
+}
+
+/**
+ * Transposes a matrix of rows * columns values in cache sized tiles
+ */
+static void harmony_fft_transpose(Complex *dst, const Complex *src, usize rows, usize columns) {
+    const usize tile = 16;
+    for (usize r0 = 0; r0 < rows; r0 += tile) {
+        for (usize c0 = 0; c0 < columns; c0 += tile) {
+            usize r1 = harmony_min(r0 + tile, rows);
+            usize c1 = harmony_min(c0 + tile, columns);
+            for (usize r = r0; r < r1; ++r) {
+                for (usize c = c0; c < c1; ++c) {
+                    dst[c * rows + r] = src[r * columns + c];
+                }
+            }
+        }
+    }
+}
+
+static void harmony_fft_2d_transform(const HarmonyFft2dPlan *plan, Complex *dst, const Complex *src, bool inverse) {
+    usize width = plan->rows.size;
+    usize height = plan->columns.size;
+    void (*transform)(const HarmonyFftPlan *, Complex *, const Complex *) = inverse ? harmony_fft_inverse : harmony_fft;
+    for (usize y = 0; y < height; ++y) {
+        transform(&plan->rows, dst + y * width, src + y * width);
+    }
+    harmony_fft_transpose(plan->transposed, dst, height, width);
+    for (usize x = 0; x < width; ++x) {
+        transform(&plan->columns, plan->transposed + x * height, plan->transposed + x * height);
+    }
+    harmony_fft_transpose(dst, plan->transposed, width, height);
+}
+
+void harmony_fft_2d(const HarmonyFft2dPlan *plan, Complex *dst, const Complex *src) {
+    harmony_assert(plan != NULL);
+    harmony_assert(dst != NULL);
+    harmony_assert(src != NULL);
+    harmony_fft_2d_transform(plan, dst, src, false);
+}
+
+void harmony_fft_2d_inverse(const HarmonyFft2dPlan *plan, Complex *dst, const Complex *src) {
+    harmony_assert(plan != NULL);
+    harmony_assert(dst != NULL);
+    harmony_assert(src != NULL);
+    harmony_fft_2d_transform(plan, dst, src, true);
+}
+
+// the polynomials are the minimax fits from Cephes, evaluated with separate
+// multiplies and adds so every tier gives identical results
+#define HARMONY_APPROX_PIO2_1 1.5703125f
+#define HARMONY_APPROX_PIO2_2 4.837512969970703125e-4f
+#define HARMONY_APPROX_PIO2_3 7.54978995489188216e-8f
+#define HARMONY_APPROX_LOG2E_FRACTION 0.44269504088896341f
+#define HARMONY_APPROX_RSQRT_MAGIC 0x5f375a86u
+
+static f32 harmony_approx_from_bits(u32 bits) {
+    f32 value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static u32 harmony_approx_to_bits(f32 value) {
+    u32 bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static void harmony_approx_sincos_scalar(f32 *sin_dst, f32 *cos_dst, f32 x) {
+    // reduces to [-pi/4, pi/4] with pi/2 split in three, so the products are exact
+    f32 q = rintf(x * 0.63661977236758134f);
+    f32 r = x - q * HARMONY_APPROX_PIO2_1;
+    r = r - q * HARMONY_APPROX_PIO2_2;
+    r = r - q * HARMONY_APPROX_PIO2_3;
+    f32 z = r * r;
+    f32 sin_r = ((-1.9515295891e-4f * z + 8.3321608736e-3f) * z - 1.6666654611e-1f) * z * r + r;
+    f32 cos_r = ((2.443315711809948e-5f * z - 1.388731625493765e-3f) * z + 4.166664568298827e-2f) * z * z - 0.5f * z + 1.0f;
+
+    u32 quadrant = (u32)(i32)q;
+    f32 s = quadrant & 1 ? cos_r : sin_r;
+    f32 c = quadrant & 1 ? sin_r : cos_r;
+    *sin_dst = quadrant & 2 ? -s : s;
+    *cos_dst = (quadrant + 1) & 2 ? -c : c;
+}
+
+static f32 harmony_approx_exp2_scalar(f32 x) {
+    x = x > -126.0f ? x : -126.0f;
+    x = x < 127.0f ? x : 127.0f;
+    f32 n = rintf(x);
+    f32 f = x - n;
+    f32 p = 1.535336188319500e-4f * f + 1.339887440266574e-3f;
+    p = p * f + 9.618437357674640e-3f;
+    p = p * f + 5.550332471162809e-2f;
+    p = p * f + 2.402264791363012e-1f;
+    p = p * f + 6.931472028550421e-1f;
+    p = p * f + 1.0f;
+    return p * harmony_approx_from_bits((u32)((i32)n + 127) << 23);
+}
+
+static f32 harmony_approx_log2_scalar(f32 value) {
+    // splits into an exponent and a mantissa in [sqrt(1/2), sqrt(2)]
+    u32 bits = harmony_approx_to_bits(value);
+    f32 e = (f32)((i32)(bits >> 23) - 127);
+    f32 m = harmony_approx_from_bits((bits & 0x7fffffu) | 0x3f800000u);
+    bool above = m > 1.41421356f;
+    m = above ? m * 0.5f : m;
+    e = above ? e + 1.0f : e;
+
+    f32 x = m - 1.0f;
+    f32 z = x * x;
+    f32 p = 7.0376836292e-2f * x - 1.1514610310e-1f;
+    p = p * x + 1.1676998740e-1f;
+    p = p * x - 1.2420140846e-1f;
+    p = p * x + 1.4249322787e-1f;
+    p = p * x - 1.6668057665e-1f;
+    p = p * x + 2.0000714765e-1f;
+    p = p * x - 2.4999993993e-1f;
+    p = p * x + 3.3333331174e-1f;
+    f32 y = x * (z * p) - 0.5f * z;
+
+    // multiplies by log2(e) as 1 + a fraction, adding the terms smallest first
+    f32 result = y * HARMONY_APPROX_LOG2E_FRACTION;
+    result = result + x * HARMONY_APPROX_LOG2E_FRACTION;
+    result = result + y;
+    result = result + x;
+    return result + e;
+}
+
+static f32 harmony_approx_atan2_scalar(f32 y, f32 x) {
+    f32 ax = fabsf(x);
+    f32 ay = fabsf(y);
+    f32 hi = ax > ay ? ax : ay;
+    f32 lo = ax < ay ? ax : ay;
+    f32 a = hi > 0.0f ? lo / hi : 0.0f;
+
+    // reduces to [0, tan(pi/8)] using atan(a) = pi/4 + atan((a - 1) / (a + 1))
+    bool above = a > 0.41421356f;
+    f32 t = above ? (a - 1.0f) / (a + 1.0f) : a;
+    f32 base = above ? 0.78539816f : 0.0f;
+    f32 z = t * t;
+    f32 p = ((8.05374449538e-2f * z - 1.38776856032e-1f) * z + 1.99777106478e-1f) * z - 3.33329491539e-1f;
+    f32 result = base + (p * z * t + t);
+
+    result = ay > ax ? 1.57079633f - result : result;
+    result = x < 0.0f ? 3.14159265f - result : result;
+    // the result is not negative yet, so the sign of y, even of -0, gives the half plane
+    return copysignf(result, y);
+}
+
+static f32 harmony_approx_rsqrt_scalar(f32 x) {
+    f32 y = harmony_approx_from_bits(HARMONY_APPROX_RSQRT_MAGIC - (harmony_approx_to_bits(x) >> 1));
+    f32 half = 0.5f * x;
+    y = y * (1.5f - half * y * y);
+    return y * (1.5f - half * y * y);
+}
+
+static void harmony_approx_scalar(
+    f32 *dst,
+    f32 *dst2,
+    const f32 *src,
+    const f32 *src2,
+    usize count,
+    HarmonyApproxFunction function
+) {
+    switch (function) {
+        case HARMONY_APPROX_SINCOS:
+            for (usize i = 0; i < count; ++i) {
+                harmony_approx_sincos_scalar(dst + i, dst2 + i, src[i]);
+            }
+            break;
+        case HARMONY_APPROX_EXP2:
+            for (usize i = 0; i < count; ++i) {
+                dst[i] = harmony_approx_exp2_scalar(src[i]);
+            }
+            break;
+        case HARMONY_APPROX_LOG2:
+            for (usize i = 0; i < count; ++i) {
+                dst[i] = harmony_approx_log2_scalar(src[i]);
+            }
+            break;
+        case HARMONY_APPROX_ATAN2:
+            for (usize i = 0; i < count; ++i) {
+                dst[i] = harmony_approx_atan2_scalar(src[i], src2[i]);
+            }
+            break;
+        case HARMONY_APPROX_RSQRT:
+            for (usize i = 0; i < count; ++i) {
+                dst[i] = harmony_approx_rsqrt_scalar(src[i]);
+            }
+            break;
+    }
+}
+
+#ifdef HARMONY_X86_KERNELS
+
+HARMONY_TARGET_AVX2
+static inline __m256 harmony_approx_madd_avx2(__m256 a, __m256 b, __m256 c) {
+    return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+}
+
+HARMONY_TARGET_AVX2
+static inline __m256 harmony_approx_msub_avx2(__m256 a, __m256 b, __m256 c) {
+    return _mm256_sub_ps(_mm256_mul_ps(a, b), c);
+}
+
+HARMONY_TARGET_AVX2
+static inline void harmony_approx_sincos_avx2(__m256 *sin_dst, __m256 *cos_dst, __m256 x) {
+    __m256 q = _mm256_round_ps(_mm256_mul_ps(x, _mm256_set1_ps(0.63661977236758134f)),
+        _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m256 r = _mm256_sub_ps(x, _mm256_mul_ps(q, _mm256_set1_ps(HARMONY_APPROX_PIO2_1)));
+    r = _mm256_sub_ps(r, _mm256_mul_ps(q, _mm256_set1_ps(HARMONY_APPROX_PIO2_2)));
+    r = _mm256_sub_ps(r, _mm256_mul_ps(q, _mm256_set1_ps(HARMONY_APPROX_PIO2_3)));
+    __m256 z = _mm256_mul_ps(r, r);
+
+    __m256 sin_r = harmony_approx_madd_avx2(_mm256_set1_ps(-1.9515295891e-4f), z, _mm256_set1_ps(8.3321608736e-3f));
+    sin_r = harmony_approx_msub_avx2(sin_r, z, _mm256_set1_ps(1.6666654611e-1f));
+    sin_r = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(sin_r, z), r), r);
+    __m256 cos_r = harmony_approx_msub_avx2(_mm256_set1_ps(2.443315711809948e-5f), z, _mm256_set1_ps(1.388731625493765e-3f));
+    cos_r = harmony_approx_madd_avx2(cos_r, z, _mm256_set1_ps(4.166664568298827e-2f));
+    cos_r = _mm256_sub_ps(_mm256_mul_ps(_mm256_mul_ps(cos_r, z), z), _mm256_mul_ps(_mm256_set1_ps(0.5f), z));
+    cos_r = _mm256_add_ps(cos_r, _mm256_set1_ps(1.0f));
+
+    __m256i quadrant = _mm256_cvtps_epi32(q);
+    __m256 swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(
+        _mm256_and_si256(quadrant, _mm256_set1_epi32(1)), _mm256_set1_epi32(1)));
+    __m256 s = _mm256_blendv_ps(sin_r, cos_r, swap);
+    __m256 c = _mm256_blendv_ps(cos_r, sin_r, swap);
+    // moves bit 1 of the quadrant into the sign bit
+    __m256 sin_sign = _mm256_castsi256_ps(_mm256_slli_epi32(quadrant, 30));
+    __m256 cos_sign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(quadrant, _mm256_set1_epi32(1)), 30));
+    __m256 sign = _mm256_set1_ps(-0.0f);
+    *sin_dst = _mm256_xor_ps(s, _mm256_and_ps(sin_sign, sign));
+    *cos_dst = _mm256_xor_ps(c, _mm256_and_ps(cos_sign, sign));
+}
+
+HARMONY_TARGET_AVX2
+static inline __m256 harmony_approx_exp2_avx2(__m256 x) {
+    x = _mm256_max_ps(x, _mm256_set1_ps(-126.0f));
+    x = _mm256_min_ps(x, _mm256_set1_ps(127.0f));
+    __m256 n = _mm256_round_ps(x, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m256 f = _mm256_sub_ps(x, n);
+    __m256 p = harmony_approx_madd_avx2(_mm256_set1_ps(1.535336188319500e-4f), f, _mm256_set1_ps(1.339887440266574e-3f));
+    p = harmony_approx_madd_avx2(p, f, _mm256_set1_ps(9.618437357674640e-3f));
+    p = harmony_approx_madd_avx2(p, f, _mm256_set1_ps(5.550332471162809e-2f));
+    p = harmony_approx_madd_avx2(p, f, _mm256_set1_ps(2.402264791363012e-1f));
+    p = harmony_approx_madd_avx2(p, f, _mm256_set1_ps(6.931472028550421e-1f));
+    p = harmony_approx_madd_avx2(p, f, _mm256_set1_ps(1.0f));
+    __m256i scale = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23);
+    return _mm256_mul_ps(p, _mm256_castsi256_ps(scale));
+}
+
+HARMONY_TARGET_AVX2
+static inline __m256 harmony_approx_log2_avx2(__m256 value) {
+    __m256i bits = _mm256_castps_si256(value);
+    __m256 e = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(127)));
+    __m256 m = _mm256_castsi256_ps(_mm256_or_si256(
+        _mm256_and_si256(bits, _mm256_set1_epi32(0x7fffff)), _mm256_set1_epi32(0x3f800000)));
+    __m256 above = _mm256_cmp_ps(m, _mm256_set1_ps(1.41421356f), _CMP_GT_OQ);
+    m = _mm256_blendv_ps(m, _mm256_mul_ps(m, _mm256_set1_ps(0.5f)), above);
+    e = _mm256_blendv_ps(e, _mm256_add_ps(e, _mm256_set1_ps(1.0f)), above);
+
+    __m256 x = _mm256_sub_ps(m, _mm256_set1_ps(1.0f));
+    __m256 z = _mm256_mul_ps(x, x);
+    __m256 p = harmony_approx_msub_avx2(_mm256_set1_ps(7.0376836292e-2f), x, _mm256_set1_ps(1.1514610310e-1f));
+    p = harmony_approx_madd_avx2(p, x, _mm256_set1_ps(1.1676998740e-1f));
+    p = harmony_approx_msub_avx2(p, x, _mm256_set1_ps(1.2420140846e-1f));
+    p = harmony_approx_madd_avx2(p, x, _mm256_set1_ps(1.4249322787e-1f));
+    p = harmony_approx_msub_avx2(p, x, _mm256_set1_ps(1.6668057665e-1f));
+    p = harmony_approx_madd_avx2(p, x, _mm256_set1_ps(2.0000714765e-1f));
+    p = harmony_approx_msub_avx2(p, x, _mm256_set1_ps(2.4999993993e-1f));
+    p = harmony_approx_madd_avx2(p, x, _mm256_set1_ps(3.3333331174e-1f));
+    __m256 y = _mm256_sub_ps(_mm256_mul_ps(x, _mm256_mul_ps(z, p)), _mm256_mul_ps(_mm256_set1_ps(0.5f), z));
+
+    __m256 log2e_fraction = _mm256_set1_ps(HARMONY_APPROX_LOG2E_FRACTION);
+    __m256 result = _mm256_mul_ps(y, log2e_fraction);
+    result = _mm256_add_ps(result, _mm256_mul_ps(x, log2e_fraction));
+    result = _mm256_add_ps(result, y);
+    result = _mm256_add_ps(result, x);
+    return _mm256_add_ps(result, e);
+}
+
+HARMONY_TARGET_AVX2
+static inline __m256 harmony_approx_atan2_avx2(__m256 y, __m256 x) {
+    __m256 sign = _mm256_set1_ps(-0.0f);
+    __m256 zero = _mm256_setzero_ps();
+    __m256 ax = _mm256_andnot_ps(sign, x);
+    __m256 ay = _mm256_andnot_ps(sign, y);
+    __m256 hi = _mm256_max_ps(ax, ay);
+    __m256 lo = _mm256_min_ps(ax, ay);
+    __m256 a = _mm256_blendv_ps(zero, _mm256_div_ps(lo, hi), _mm256_cmp_ps(hi, zero, _CMP_GT_OQ));
+
+    __m256 one = _mm256_set1_ps(1.0f);
+    __m256 above = _mm256_cmp_ps(a, _mm256_set1_ps(0.41421356f), _CMP_GT_OQ);
+    __m256 t = _mm256_blendv_ps(a, _mm256_div_ps(_mm256_sub_ps(a, one), _mm256_add_ps(a, one)), above);
+    __m256 base = _mm256_and_ps(above, _mm256_set1_ps(0.78539816f));
+    __m256 z = _mm256_mul_ps(t, t);
+    __m256 p = harmony_approx_msub_avx2(_mm256_set1_ps(8.05374449538e-2f), z, _mm256_set1_ps(1.38776856032e-1f));
+    p = harmony_approx_madd_avx2(p, z, _mm256_set1_ps(1.99777106478e-1f));
+    p = harmony_approx_msub_avx2(p, z, _mm256_set1_ps(3.33329491539e-1f));
+    __m256 result = _mm256_add_ps(base, _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(p, z), t), t));
+
+    result = _mm256_blendv_ps(result, _mm256_sub_ps(_mm256_set1_ps(1.57079633f), result), _mm256_cmp_ps(ay, ax, _CMP_GT_OQ));
+    result = _mm256_blendv_ps(result, _mm256_sub_ps(_mm256_set1_ps(3.14159265f), result), _mm256_cmp_ps(x, zero, _CMP_LT_OQ));
+    return _mm256_or_ps(result, _mm256_and_ps(y, sign));
+}
+
+HARMONY_TARGET_AVX2
+static inline __m256 harmony_approx_rsqrt_avx2(__m256 x) {
+    __m256 y = _mm256_castsi256_ps(_mm256_sub_epi32(
+        _mm256_set1_epi32((i32)HARMONY_APPROX_RSQRT_MAGIC), _mm256_srli_epi32(_mm256_castps_si256(x), 1)));
+    __m256 half = _mm256_mul_ps(_mm256_set1_ps(0.5f), x);
+    __m256 three_halves = _mm256_set1_ps(1.5f);
+    y = _mm256_mul_ps(y, _mm256_sub_ps(three_halves, _mm256_mul_ps(_mm256_mul_ps(half, y), y)));
+    return _mm256_mul_ps(y, _mm256_sub_ps(three_halves, _mm256_mul_ps(_mm256_mul_ps(half, y), y)));
+}
+
+HARMONY_TARGET_AVX2
+static void harmony_approx_avx2(
+    f32 *dst,
+    f32 *dst2,
+    const f32 *src,
+    const f32 *src2,
+    usize count,
+    HarmonyApproxFunction function
+) {
+    usize i = 0;
+    switch (function) {
+        case HARMONY_APPROX_SINCOS:
+            for (; i + 8 <= count; i += 8) {
+                __m256 sines, cosines;
+                harmony_approx_sincos_avx2(&sines, &cosines, _mm256_loadu_ps(src + i));
+                _mm256_storeu_ps(dst + i, sines);
+                _mm256_storeu_ps(dst2 + i, cosines);
+            }
+            break;
+        case HARMONY_APPROX_EXP2:
+            for (; i + 8 <= count; i += 8) {
+                _mm256_storeu_ps(dst + i, harmony_approx_exp2_avx2(_mm256_loadu_ps(src + i)));
+            }
+            break;
+        case HARMONY_APPROX_LOG2:
+            for (; i + 8 <= count; i += 8) {
+                _mm256_storeu_ps(dst + i, harmony_approx_log2_avx2(_mm256_loadu_ps(src + i)));
+            }
+            break;
+        case HARMONY_APPROX_ATAN2:
+            for (; i + 8 <= count; i += 8) {
+                _mm256_storeu_ps(dst + i, harmony_approx_atan2_avx2(_mm256_loadu_ps(src + i), _mm256_loadu_ps(src2 + i)));
+            }
+            break;
+        case HARMONY_APPROX_RSQRT:
+            for (; i + 8 <= count; i += 8) {
+                _mm256_storeu_ps(dst + i, harmony_approx_rsqrt_avx2(_mm256_loadu_ps(src + i)));
+            }
+            break;
+    }
+    if (i < count)
+        harmony_approx_scalar(
+            dst + i,
+            dst2 != NULL ? dst2 + i : NULL,
+            src + i,
+            src2 != NULL ? src2 + i : NULL,
+            count - i,
+            function);
+}
+
+#endif // HARMONY_X86_KERNELS
+
+void harmony_approx_sincos(f32 *sin_dst, f32 *cos_dst, const f32 *src, usize count) {
+    harmony_assert(sin_dst != NULL);
+    harmony_assert(cos_dst != NULL);
+    harmony_assert(src != NULL);
+    harmony_kernels()->approx(sin_dst, cos_dst, src, NULL, count, HARMONY_APPROX_SINCOS);
+}
+
+void harmony_approx_exp2(f32 *dst, const f32 *src, usize count) {
+    harmony_assert(dst != NULL);
+    harmony_assert(src != NULL);
+    harmony_kernels()->approx(dst, NULL, src, NULL, count, HARMONY_APPROX_EXP2);
+}
+
+void harmony_approx_log2(f32 *dst, const f32 *src, usize count) {
+    harmony_assert(dst != NULL);
+    harmony_assert(src != NULL);
+    harmony_kernels()->approx(dst, NULL, src, NULL, count, HARMONY_APPROX_LOG2);
+}
+
+void harmony_approx_atan2(f32 *dst, const f32 *y, const f32 *x, usize count) {
+    harmony_assert(dst != NULL);
+    harmony_assert(y != NULL);
+    harmony_assert(x != NULL);
+    harmony_kernels()->approx(dst, NULL, y, x, count, HARMONY_APPROX_ATAN2);
+}
+
+void harmony_approx_rsqrt(f32 *dst, const f32 *src, usize count) {
+    harmony_assert(dst != NULL);
+    harmony_assert(src != NULL);
+    harmony_kernels()->approx(dst, NULL, src, NULL, count, HARMONY_APPROX_RSQRT);
+}
+
+Mat4 harmony_model_matrix_2d(Vec3 position, Vec2 scale, f32 rotation) {
+    return affine3to4(harmony_model_affine_2d(position, scale, rotation));
+}
+
+Mat4 harmony_model_matrix_3d(Vec3 position, Vec3 scale, Quat rotation) {
+    return affine3to4(harmony_model_affine_3d(position, scale, rotation));
+}
+
+Affine3 harmony_model_affine_2d(Vec3 position, Vec2 scale, f32 rotation) {
+    f32 cos_rotation = cosf(rotation);
+    f32 sin_rotation = sinf(rotation);
+    return (Affine3){
+        {cos_rotation * scale.x, sin_rotation * scale.x, 0.0f},
+        {-sin_rotation * scale.y, cos_rotation * scale.y, 0.0f},
+        {0.0f, 0.0f, 1.0f},
+        position,
+    };
+}
+
+Affine3 harmony_model_affine_3d(Vec3 position, Vec3 scale, Quat rotation) {
+    return (Affine3){
+        rotate_vec3(rotation, (Vec3){scale.x, 0.0f, 0.0f}),
+        rotate_vec3(rotation, (Vec3){0.0f, scale.y, 0.0f}),
+        rotate_vec3(rotation, (Vec3){0.0f, 0.0f, scale.z}),
+        position,
+    };
+}
+
+Affine3 harmony_view_affine(Vec3 position, f32 zoom, Quat rotation) {
+    Mat3 rot = rotate_mat3(qconj(rotation), smat3(1.0f));
+    Affine3 result = {
+        svmul3(zoom, rot.x),
+        svmul3(zoom, rot.y),
+        rot.z,
+        {0.0f, 0.0f, 0.0f},
+    };
+    result.w = svmul3(-1.0f, atransform_dir((Affine3){rot.x, rot.y, rot.z, {0.0f, 0.0f, 0.0f}}, position));
+    return result;
+}
+
+/**
+ * Writes up to 8 matrices from structure of arrays form
+ */
+static void harmony_stream_store_mat4(Mat4 *dst, Mat4x8 mat, usize count) {
+    if (count >= 8) {
+        scatter_mat4x8(dst, mat);
+    } else {
+        Mat4 tail[8];
+        scatter_mat4x8(tail, mat);
+        memcpy(dst, tail, count * sizeof(Mat4));
+    }
+}
+
+static void harmony_model_matrices_2d_scalar(Mat4 *dst, const HarmonyModelStreams2D *src, usize count) {
+    for (usize i = 0; i < count; ++i) {
+        f32 sin_rotation, cos_rotation;
+        harmony_approx_sincos_scalar(&sin_rotation, &cos_rotation, src->rotation[i]);
+        f32 scale_x = src->scale[0][i];
+        f32 scale_y = src->scale[1][i];
+        dst[i] = (Mat4){
+            {cos_rotation * scale_x, sin_rotation * scale_x, 0.0f, 0.0f},
+            {-sin_rotation * scale_y, cos_rotation * scale_y, 0.0f, 0.0f},
+            {0.0f, 0.0f, 1.0f, 0.0f},
+            {src->position[0][i], src->position[1][i], src->position[2][i], 1.0f},
+        };
+    }
+}
+
+void harmony_model_matrices_2d(Mat4 *dst, const HarmonyModelStreams2D *src, usize count) {
+    harmony_assert(dst != NULL);
+    harmony_assert(src != NULL);
+    harmony_kernels()->model_matrices_2d(dst, src, count);
+}
+
+static void harmony_model_matrices_3d_scalar(Mat4 *dst, const HarmonyModelStreams3D *src, usize count) {
+    for (usize i = 0; i < count; ++i) {
+        f32 r = src->rotation[0][i];
+        f32 qi = src->rotation[1][i];
+        f32 qj = src->rotation[2][i];
+        f32 qk = src->rotation[3][i];
+        f32 scale_x = src->scale[0][i];
+        f32 scale_y = src->scale[1][i];
+        f32 scale_z = src->scale[2][i];
+
+        f32 ii = qi * qi;
+        f32 jj = qj * qj;
+        f32 kk = qk * qk;
+        f32 ij = qi * qj;
+        f32 ik = qi * qk;
+        f32 jk = qj * qk;
+        f32 ri = r * qi;
+        f32 rj = r * qj;
+        f32 rk = r * qk;
+
+        dst[i] = (Mat4){
+            {
+                scale_x * (1.0f - 2.0f * (jj + kk)),
+                scale_x * (2.0f * (ij + rk)),
+                scale_x * (2.0f * (ik - rj)),
+                0.0f,
+            },
+            {
+                scale_y * (2.0f * (ij - rk)),
+                scale_y * (1.0f - 2.0f * (ii + kk)),
+                scale_y * (2.0f * (jk + ri)),
+                0.0f,
+            },
+            {
+                scale_z * (2.0f * (ik + rj)),
+                scale_z * (2.0f * (jk - ri)),
+                scale_z * (1.0f - 2.0f * (ii + jj)),
+                0.0f,
+            },
+            {src->position[0][i], src->position[1][i], src->position[2][i], 1.0f},
+        };
+    }
+}
+
+#ifdef HARMONY_X86_KERNELS
+
+static void harmony_model_matrices_3d_wide(Mat4 *dst, const HarmonyModelStreams3D *src, usize count) {
+    F32x8 zero = sf32x8(0.0f);
+    F32x8 one = sf32x8(1.0f);
+    F32x8 two = sf32x8(2.0f);
+    for (usize i = 0; i < count; i += 8) {
+        usize lanes = count - i;
+        F32x8 r = harmony_stream_load(src->rotation[0] + i, lanes);
+        F32x8 qi = harmony_stream_load(src->rotation[1] + i, lanes);
+        F32x8 qj = harmony_stream_load(src->rotation[2] + i, lanes);
+        F32x8 qk = harmony_stream_load(src->rotation[3] + i, lanes);
+        F32x8 scale_x = harmony_stream_load(src->scale[0] + i, lanes);
+        F32x8 scale_y = harmony_stream_load(src->scale[1] + i, lanes);
+        F32x8 scale_z = harmony_stream_load(src->scale[2] + i, lanes);
+
+        F32x8 ii = fmul8(qi, qi);
+        F32x8 jj = fmul8(qj, qj);
+        F32x8 kk = fmul8(qk, qk);
+        F32x8 ij = fmul8(qi, qj);
+        F32x8 ik = fmul8(qi, qk);
+        F32x8 jk = fmul8(qj, qk);
+        F32x8 ri = fmul8(r, qi);
+        F32x8 rj = fmul8(r, qj);
+        F32x8 rk = fmul8(r, qk);
+
+        Mat4x8 mat = {
+            {
+                fmul8(scale_x, fsub8(one, fmul8(two, fadd8(jj, kk)))),
+                fmul8(scale_x, fmul8(two, fadd8(ij, rk))),
+                fmul8(scale_x, fmul8(two, fsub8(ik, rj))),
+                zero,
+            },
+            {
+                fmul8(scale_y, fmul8(two, fsub8(ij, rk))),
+                fmul8(scale_y, fsub8(one, fmul8(two, fadd8(ii, kk)))),
+                fmul8(scale_y, fmul8(two, fadd8(jk, ri))),
+                zero,
+            },
+            {
+                fmul8(scale_z, fmul8(two, fadd8(ik, rj))),
+                fmul8(scale_z, fmul8(two, fsub8(jk, ri))),
+                fmul8(scale_z, fsub8(one, fmul8(two, fadd8(ii, jj)))),
+                zero,
+            },
+            {
+                harmony_stream_load(src->position[0] + i, lanes),
+                harmony_stream_load(src->position[1] + i, lanes),
+                harmony_stream_load(src->position[2] + i, lanes),
+                one,
+            },
+        };
+        harmony_stream_store_mat4(dst + i, mat, lanes);
+    }
+}
+
+#endif // HARMONY_X86_KERNELS
+
+void harmony_model_matrices_3d(Mat4 *dst, const HarmonyModelStreams3D *src, usize count) {
+    harmony_assert(dst != NULL);
+    harmony_assert(src != NULL);
+    harmony_kernels()->model_matrices_3d(dst, src, count);
+}
+
+typedef struct HarmonyModelMatricesArgs {
+    Mat4 *dst;
+    const void *src;
+    usize count;
+} HarmonyModelMatricesArgs;
+
+static void harmony_model_matrices_2d_range(void *data, usize begin, usize end) {
+    HarmonyModelMatricesArgs *args = data;
+    const HarmonyModelStreams2D *src = args->src;
+    usize first = begin * 8;
+    usize last = harmony_min(end * 8, args->count);
+    HarmonyModelStreams2D range = {
+        .position = {src->position[0] + first, src->position[1] + first, src->position[2] + first},
+        .scale = {src->scale[0] + first, src->scale[1] + first},
+        .rotation = src->rotation + first,
+    };
+    harmony_model_matrices_2d(args->dst + first, &range, last - first);
+}
+
+static void harmony_model_matrices_3d_range(void *data, usize begin, usize end) {
+    HarmonyModelMatricesArgs *args = data;
+    const HarmonyModelStreams3D *src = args->src;
+    usize first = begin * 8;
+    usize last = harmony_min(end * 8, args->count);
+    HarmonyModelStreams3D range = {
+        .position = {src->position[0] + first, src->position[1] + first, src->position[2] + first},
+        .scale = {src->scale[0] + first, src->scale[1] + first, src->scale[2] + first},
+        .rotation = {
+            src->rotation[0] + first, src->rotation[1] + first,
+            src->rotation[2] + first, src->rotation[3] + first,
+        },
+    };
+    harmony_model_matrices_3d(args->dst + first, &range, last - first);
+}
+
+void harmony_model_matrices_2d_parallel(u32 thread_count, Mat4 *dst, const HarmonyModelStreams2D *src, usize count) {
+    harmony_assert(dst != NULL);
+    harmony_assert(src != NULL);
+    HarmonyModelMatricesArgs args = {dst, src, count};
+    harmony_parallel_for(thread_count, (count + 7) / 8, harmony_model_matrices_2d_range, &args);
+}
+
+void harmony_model_matrices_3d_parallel(u32 thread_count, Mat4 *dst, const HarmonyModelStreams3D *src, usize count) {
+    harmony_assert(dst != NULL);
+    harmony_assert(src != NULL);
+    HarmonyModelMatricesArgs args = {dst, src, count};
+    harmony_parallel_for(thread_count, (count + 7) / 8, harmony_model_matrices_3d_range, &args);
+}
+
+Mat4 harmony_view_matrix(Vec3 position, f32 zoom, Quat rotation) {
+    return affine3to4(harmony_view_affine(position, zoom, rotation));
+}
+
+Mat4 harmony_orthographic_projection(f32 left, f32 right, f32 top, f32 bottom, f32 near, f32 far) {
+    return (Mat4){
+        {2.0f / (right - left), 0.0f, 0.0f, 0.0f},
+        {0.0f, 2.0f / (bottom - top), 0.0f, 0.0f},
+        {0.0f, 0.0f, 1.0f / (far - near), 0.0f},
+        {-(right + left) / (right - left), -(bottom + top) / (bottom - top), -(near) / (far - near), 1.0f},
+    };
+}
+
+Mat4 harmony_perspective_projection(f32 fov, f32 aspect, f32 near, f32 far) {
+    harmony_assert(near > 0.0f);
+    harmony_assert(far > near);
+    f32 scale = 1 / tanf(fov / 2);
+    return (Mat4){
+        {scale / aspect, 0.0f, 0.0f, 0.0f},
+        {0.0f, scale, 0.0f, 0.0f},
+        {0.0f, 0.0f, far / (far - near), 1.0f},
+        {0.0f, 0.0f, -(far * near) / (far - near), 0.0f},
+    };
+}
+
+u32 harmony_cpu_features(void) {
+    u32 features = 0;
+#ifdef HARMONY_X86_KERNELS
+    u32 eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+        return 0;
+
+    if (edx & bit_SSE2)
+        features |= HARMONY_CPU_SSE2;
+    if (ecx & bit_SSE4_1)
+        features |= HARMONY_CPU_SSE41;
+    if (ecx & bit_SSE4_2)
+        features |= HARMONY_CPU_SSE42;
+
+    // the os must also save the wide registers on context switches
+    u64 xcr0 = (ecx & bit_OSXSAVE) ? harmony_xgetbv(0) : 0;
+    bool os_avx = (xcr0 & 0x6) == 0x6;
+    bool os_avx512 = (xcr0 & 0xe6) == 0xe6;
+    if (os_avx && (ecx & bit_AVX)) {
+        features |= HARMONY_CPU_AVX;
+        if (ecx & bit_FMA)
+            features |= HARMONY_CPU_FMA;
+    }
+
+    if (__get_cpuid_max(0, NULL) >= 7) {
+        __cpuid_count(7, 0, eax, ebx, ecx, edx);
+        if (os_avx && (ebx & bit_AVX2))
+            features |= HARMONY_CPU_AVX2;
+        if (os_avx512 && (ebx & bit_AVX512F))
+            features |= HARMONY_CPU_AVX512F;
+    }
+#endif // HARMONY_X86_KERNELS
+    return features;
+}
+
+HarmonyCpuTier harmony_cpu_best_tier(void) {
+    u32 features = harmony_cpu_features();
+    if ((features & HARMONY_CPU_AVX512F) && (features & HARMONY_CPU_AVX2) && (features & HARMONY_CPU_FMA))
+        return HARMONY_CPU_TIER_AVX512;
+    if ((features & HARMONY_CPU_AVX2) && (features & HARMONY_CPU_FMA))
+        return HARMONY_CPU_TIER_AVX2;
+    if (features & HARMONY_CPU_SSE2)
+        return HARMONY_CPU_TIER_SSE2;
+    return HARMONY_CPU_TIER_SCALAR;
+}
+
+/**
+ * Copies at or above this size in bytes use non-temporal stores
+ */
+#define HARMONY_COPY_STREAM_THRESHOLD (1 << 20)
+
+static void harmony_copy_scalar(void *dst, const void *src, usize size) {
+    memcpy(dst, src, size);
+}
+
+static void harmony_mix_scalar(f32 *dst, const f32 *src, f32 gain, usize count) {
+    for (usize i = 0; i < count; ++i)
+        dst[i] += src[i] * gain;
+}
+
+#ifdef HARMONY_X86_KERNELS
+
+/**
+ * Copies the unaligned head of a streaming copy, returning the bytes copied
+ */
+static usize harmony_copy_head(void *dst, const void *src, usize alignment) {
+    usize head = (alignment - ((usize)dst & (alignment - 1))) & (alignment - 1);
+    memcpy(dst, src, head);
+    return head;
+}
+
+HARMONY_TARGET_SSE2 static void harmony_copy_sse2(void *dst, const void *src, usize size) {
+    if (size < HARMONY_COPY_STREAM_THRESHOLD) {
+        memcpy(dst, src, size);
+        return;
+    }
+    usize i = harmony_copy_head(dst, src, 16);
+    for (; i + 64 <= size; i += 64) {
+        const u8 *s = (const u8 *)src + i;
+        u8 *d = (u8 *)dst + i;
+        __m128i a = _mm_loadu_si128((const __m128i *)s);
+        __m128i b = _mm_loadu_si128((const __m128i *)(s + 16));
+        __m128i c = _mm_loadu_si128((const __m128i *)(s + 32));
+        __m128i e = _mm_loadu_si128((const __m128i *)(s + 48));
+        _mm_stream_si128((__m128i *)d, a);
+        _mm_stream_si128((__m128i *)(d + 16), b);
+        _mm_stream_si128((__m128i *)(d + 32), c);
+        _mm_stream_si128((__m128i *)(d + 48), e);
+    }
+    _mm_sfence();
+    memcpy((u8 *)dst + i, (const u8 *)src + i, size - i);
+}
+
+HARMONY_TARGET_AVX2 static void harmony_copy_avx2(void *dst, const void *src, usize size) {
+    if (size < HARMONY_COPY_STREAM_THRESHOLD) {
+        memcpy(dst, src, size);
+        return;
+    }
+    usize i = harmony_copy_head(dst, src, 32);
+    for (; i + 128 <= size; i += 128) {
+        const u8 *s = (const u8 *)src + i;
+        u8 *d = (u8 *)dst + i;
+        __m256i a = _mm256_loadu_si256((const __m256i *)s);
+        __m256i b = _mm256_loadu_si256((const __m256i *)(s + 32));
+        __m256i c = _mm256_loadu_si256((const __m256i *)(s + 64));
+        __m256i e = _mm256_loadu_si256((const __m256i *)(s + 96));
+        _mm256_stream_si256((__m256i *)d, a);
+        _mm256_stream_si256((__m256i *)(d + 32), b);
+        _mm256_stream_si256((__m256i *)(d + 64), c);
+        _mm256_stream_si256((__m256i *)(d + 96), e);
+    }
+    _mm_sfence();
+    memcpy((u8 *)dst + i, (const u8 *)src + i, size - i);
+}
+
+HARMONY_TARGET_AVX512 static void harmony_copy_avx512(void *dst, const void *src, usize size) {
+    if (size < HARMONY_COPY_STREAM_THRESHOLD) {
+        memcpy(dst, src, size);
+        return;
+    }
+    usize i = harmony_copy_head(dst, src, 64);
+    for (; i + 128 <= size; i += 128) {
+        const u8 *s = (const u8 *)src + i;
+        u8 *d = (u8 *)dst + i;
+        __m512i a = _mm512_loadu_si512(s);
+        __m512i b = _mm512_loadu_si512(s + 64);
+        _mm512_stream_si512((void *)d, a);
+        _mm512_stream_si512((void *)(d + 64), b);
+    }
+    _mm_sfence();
+    memcpy((u8 *)dst + i, (const u8 *)src + i, size - i);
+}
+
+HARMONY_TARGET_SSE2 static void harmony_mix_sse2(f32 *dst, const f32 *src, f32 gain, usize count) {
+    __m128 g = _mm_set1_ps(gain);
+    usize i = 0;
+    for (; i + 4 <= count; i += 4)
+        _mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), _mm_mul_ps(_mm_loadu_ps(src + i), g)));
+    harmony_mix_scalar(dst + i, src + i, gain, count - i);
+}
+
+// multiply and add are kept separate, so every tier gives identical results
+HARMONY_TARGET_AVX2 static void harmony_mix_avx2(f32 *dst, const f32 *src, f32 gain, usize count) {
+    __m256 g = _mm256_set1_ps(gain);
+    usize i = 0;
+    for (; i + 8 <= count; i += 8)
+        _mm256_storeu_ps(dst + i, _mm256_add_ps(_mm256_loadu_ps(dst + i), _mm256_mul_ps(_mm256_loadu_ps(src + i), g)));
+    harmony_mix_scalar(dst + i, src + i, gain, count - i);
+}
+
+/**
+ * Transposes an 8x8 block of floats held in 8 registers
+ */
+HARMONY_TARGET_AVX2 static void harmony_transpose_8x8_avx2(__m256 rows[8]) {
+    __m256 t0 = _mm256_unpacklo_ps(rows[0], rows[1]);
+    __m256 t1 = _mm256_unpackhi_ps(rows[0], rows[1]);
+    __m256 t2 = _mm256_unpacklo_ps(rows[2], rows[3]);
+    __m256 t3 = _mm256_unpackhi_ps(rows[2], rows[3]);
+    __m256 t4 = _mm256_unpacklo_ps(rows[4], rows[5]);
+    __m256 t5 = _mm256_unpackhi_ps(rows[4], rows[5]);
+    __m256 t6 = _mm256_unpacklo_ps(rows[6], rows[7]);
+    __m256 t7 = _mm256_unpackhi_ps(rows[6], rows[7]);
+    __m256 s0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+    __m256 s1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+    __m256 s2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+    __m256 s3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+    __m256 s4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+    __m256 s5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+    __m256 s6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+    __m256 s7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+    rows[0] = _mm256_permute2f128_ps(s0, s4, 0x20);
+    rows[1] = _mm256_permute2f128_ps(s1, s5, 0x20);
+    rows[2] = _mm256_permute2f128_ps(s2, s6, 0x20);
+    rows[3] = _mm256_permute2f128_ps(s3, s7, 0x20);
+    rows[4] = _mm256_permute2f128_ps(s0, s4, 0x31);
+    rows[5] = _mm256_permute2f128_ps(s1, s5, 0x31);
+    rows[6] = _mm256_permute2f128_ps(s2, s6, 0x31);
+    rows[7] = _mm256_permute2f128_ps(s3, s7, 0x31);
+}
+
+HARMONY_TARGET_AVX2 static void harmony_model_matrices_2d_avx2(Mat4 *dst, const HarmonyModelStreams2D *src, usize count) {
+    __m256 zero = _mm256_setzero_ps();
+    __m256 one = _mm256_set1_ps(1.0f);
+    __m256 sign = _mm256_set1_ps(-0.0f);
+    usize i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 sin_rotation, cos_rotation;
+        harmony_approx_sincos_avx2(&sin_rotation, &cos_rotation, _mm256_loadu_ps(src->rotation + i));
+        __m256 scale_x = _mm256_loadu_ps(src->scale[0] + i);
+        __m256 scale_y = _mm256_loadu_ps(src->scale[1] + i);
+
+        __m256 low[8] = {
+            _mm256_mul_ps(cos_rotation, scale_x),
+            _mm256_mul_ps(sin_rotation, scale_x),
+            zero,
+            zero,
+            _mm256_mul_ps(_mm256_xor_ps(sin_rotation, sign), scale_y),
+            _mm256_mul_ps(cos_rotation, scale_y),
+            zero,
+            zero,
+        };
+        __m256 high[8] = {
+            zero,
+            zero,
+            one,
+            zero,
+            _mm256_loadu_ps(src->position[0] + i),
+            _mm256_loadu_ps(src->position[1] + i),
+            _mm256_loadu_ps(src->position[2] + i),
+            one,
+        };
+        harmony_transpose_8x8_avx2(low);
+        harmony_transpose_8x8_avx2(high);
+        for (u32 j = 0; j < 8; ++j) {
+            _mm256_storeu_ps((f32 *)&dst[i + j], low[j]);
+            _mm256_storeu_ps((f32 *)&dst[i + j] + 8, high[j]);
+        }
+    }
+    HarmonyModelStreams2D tail = {
+        .position = {src->position[0] + i, src->position[1] + i, src->position[2] + i},
+        .scale = {src->scale[0] + i, src->scale[1] + i},
+        .rotation = src->rotation + i,
+    };
+    harmony_model_matrices_2d_scalar(dst + i, &tail, count - i);
+}
+
+HARMONY_TARGET_AVX2 static void harmony_model_matrices_3d_avx2(Mat4 *dst, const HarmonyModelStreams3D *src, usize count) {
+    __m256 zero = _mm256_setzero_ps();
+    __m256 one = _mm256_set1_ps(1.0f);
+    __m256 two = _mm256_set1_ps(2.0f);
+    usize i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 r = _mm256_loadu_ps(src->rotation[0] + i);
+        __m256 qi = _mm256_loadu_ps(src->rotation[1] + i);
+        __m256 qj = _mm256_loadu_ps(src->rotation[2] + i);
+        __m256 qk = _mm256_loadu_ps(src->rotation[3] + i);
+        __m256 scale_x = _mm256_loadu_ps(src->scale[0] + i);
+        __m256 scale_y = _mm256_loadu_ps(src->scale[1] + i);
+        __m256 scale_z = _mm256_loadu_ps(src->scale[2] + i);
+
+        __m256 ii = _mm256_mul_ps(qi, qi);
+        __m256 jj = _mm256_mul_ps(qj, qj);
+        __m256 kk = _mm256_mul_ps(qk, qk);
+        __m256 ij = _mm256_mul_ps(qi, qj);
+        __m256 ik = _mm256_mul_ps(qi, qk);
+        __m256 jk = _mm256_mul_ps(qj, qk);
+        __m256 ri = _mm256_mul_ps(r, qi);
+        __m256 rj = _mm256_mul_ps(r, qj);
+        __m256 rk = _mm256_mul_ps(r, qk);
+
+        __m256 low[8] = {
+            _mm256_mul_ps(scale_x, _mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(jj, kk)))),
+            _mm256_mul_ps(scale_x, _mm256_mul_ps(two, _mm256_add_ps(ij, rk))),
+            _mm256_mul_ps(scale_x, _mm256_mul_ps(two, _mm256_sub_ps(ik, rj))),
+            zero,
+            _mm256_mul_ps(scale_y, _mm256_mul_ps(two, _mm256_sub_ps(ij, rk))),
+            _mm256_mul_ps(scale_y, _mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(ii, kk)))),
+            _mm256_mul_ps(scale_y, _mm256_mul_ps(two, _mm256_add_ps(jk, ri))),
+            zero,
+        };
+        __m256 high[8] = {
+            _mm256_mul_ps(scale_z, _mm256_mul_ps(two, _mm256_add_ps(ik, rj))),
+            _mm256_mul_ps(scale_z, _mm256_mul_ps(two, _mm256_sub_ps(jk, ri))),
+            _mm256_mul_ps(scale_z, _mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(ii, jj)))),
+            zero,
+            _mm256_loadu_ps(src->position[0] + i),
+            _mm256_loadu_ps(src->position[1] + i),
+            _mm256_loadu_ps(src->position[2] + i),
+            one,
+        };
+        harmony_transpose_8x8_avx2(low);
+        harmony_transpose_8x8_avx2(high);
+        for (u32 j = 0; j < 8; ++j) {
+            _mm256_storeu_ps((f32 *)&dst[i + j], low[j]);
+            _mm256_storeu_ps((f32 *)&dst[i + j] + 8, high[j]);
+        }
+    }
+    HarmonyModelStreams3D tail = {
+        .position = {src->position[0] + i, src->position[1] + i, src->position[2] + i},
+        .scale = {src->scale[0] + i, src->scale[1] + i, src->scale[2] + i},
+        .rotation = {src->rotation[0] + i, src->rotation[1] + i, src->rotation[2] + i, src->rotation[3] + i},
+    };
+    harmony_model_matrices_3d_scalar(dst + i, &tail, count - i);
+}
+
+#endif // HARMONY_X86_KERNELS
+
+static HarmonyQuatStreams harmony_quat_streams_offset(const HarmonyQuatStreams *streams, usize offset) {
+    return (HarmonyQuatStreams){{
+        streams->components[0] + offset,
+        streams->components[1] + offset,
+        streams->components[2] + offset,
+        streams->components[3] + offset,
+    }};
+}
+
+static void harmony_quat_normalize_scalar(const HarmonyQuatStreams *dst, const HarmonyQuatStreams *src, usize count) {
+    for (usize i = 0; i < count; ++i) {
+        f32 r = src->components[0][i];
+        f32 qi = src->components[1][i];
+        f32 qj = src->components[2][i];
+        f32 qk = src->components[3][i];
+        f32 inv_len = 1.0f / sqrtf(r * r + qi * qi + qj * qj + qk * qk);
+        dst->components[0][i] = r * inv_len;
+        dst->components[1][i] = qi * inv_len;
+        dst->components[2][i] = qj * inv_len;
+        dst->components[3][i] = qk * inv_len;
+    }
+}
+
+// above this cosine the angle is too small for the sines to be accurate,
+// and linear interpolation is indistinguishable
+#define HARMONY_SLERP_LINEAR_COS 0.9995f
+
+static void harmony_quat_blend_scalar(
+    const HarmonyQuatStreams *dst,
+    const HarmonyQuatStreams *lhs,
+    const HarmonyQuatStreams *rhs,
+    const f32 *t,
+    usize count,
+    bool spherical
+) {
+    for (usize i = 0; i < count; ++i) {
+        f32 a[4];
+        f32 b[4];
+        for (u32 c = 0; c < 4; ++c) {
+            a[c] = lhs->components[c][i];
+            b[c] = rhs->components[c][i];
+        }
+        f32 cos_angle = a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3];
+        if (cos_angle < 0.0f) {
+            for (u32 c = 0; c < 4; ++c) {
+                b[c] = -b[c];
+            }
+            cos_angle = -cos_angle;
+        }
+
+        f32 lhs_weight = 1.0f - t[i];
+        f32 rhs_weight = t[i];
+        if (spherical && cos_angle < HARMONY_SLERP_LINEAR_COS) {
+            f32 sin_angle = sqrtf(1.0f - cos_angle * cos_angle);
+            f32 angle = harmony_approx_atan2_scalar(sin_angle, cos_angle);
+            f32 lhs_sin, rhs_sin, unused;
+            harmony_approx_sincos_scalar(&lhs_sin, &unused, lhs_weight * angle);
+            harmony_approx_sincos_scalar(&rhs_sin, &unused, rhs_weight * angle);
+            f32 inv_sin = 1.0f / sin_angle;
+            lhs_weight = lhs_sin * inv_sin;
+            rhs_weight = rhs_sin * inv_sin;
+        }
+
+        f32 q[4];
+        for (u32 c = 0; c < 4; ++c) {
+            q[c] = a[c] * lhs_weight + b[c] * rhs_weight;
+        }
+        f32 inv_len = 1.0f / sqrtf(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+        for (u32 c = 0; c < 4; ++c) {
+            dst->components[c][i] = q[c] * inv_len;
+        }
+    }
+}
+
+static void harmony_rotation_matrices_scalar(f32 *dst, const HarmonyModelStreams3D *src, usize count, bool affine) {
+    usize stride = affine ? 12 : 9;
+    for (usize i = 0; i < count; ++i) {
+        f32 r = src->rotation[0][i];
+        f32 qi = src->rotation[1][i];
+        f32 qj = src->rotation[2][i];
+        f32 qk = src->rotation[3][i];
+        f32 scale_x = affine ? src->scale[0][i] : 1.0f;
+        f32 scale_y = affine ? src->scale[1][i] : 1.0f;
+        f32 scale_z = affine ? src->scale[2][i] : 1.0f;
+
+        f32 ii = qi * qi;
+        f32 jj = qj * qj;
+        f32 kk = qk * qk;
+        f32 ij = qi * qj;
+        f32 ik = qi * qk;
+        f32 jk = qj * qk;
+        f32 ri = r * qi;
+        f32 rj = r * qj;
+        f32 rk = r * qk;
+
+        f32 *out = dst + i * stride;
+        out[0] = scale_x * (1.0f - 2.0f * (jj + kk));
+        out[1] = scale_x * (2.0f * (ij + rk));
+        out[2] = scale_x * (2.0f * (ik - rj));
+        out[3] = scale_y * (2.0f * (ij - rk));
+        out[4] = scale_y * (1.0f - 2.0f * (ii + kk));
+        out[5] = scale_y * (2.0f * (jk + ri));
+        out[6] = scale_z * (2.0f * (ik + rj));
+        out[7] = scale_z * (2.0f * (jk - ri));
+        out[8] = scale_z * (1.0f - 2.0f * (ii + jj));
+        if (affine) {
+            out[9] = src->position[0][i];
+            out[10] = src->position[1][i];
+            out[11] = src->position[2][i];
+        }
+    }
+}
+
+#ifdef HARMONY_X86_KERNELS
+
+HARMONY_TARGET_AVX2
+static inline __m256 harmony_quat_inv_len_avx2(__m256 r, __m256 qi, __m256 qj, __m256 qk) {
+    __m256 len2 = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(
+        _mm256_mul_ps(r, r), _mm256_mul_ps(qi, qi)), _mm256_mul_ps(qj, qj)), _mm256_mul_ps(qk, qk));
+    return _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_sqrt_ps(len2));
+}
+
+HARMONY_TARGET_AVX2
+static void harmony_quat_normalize_avx2(const HarmonyQuatStreams *dst, const HarmonyQuatStreams *src, usize count) {
+    usize i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 q[4];
+        for (u32 c = 0; c < 4; ++c) {
+            q[c] = _mm256_loadu_ps(src->components[c] + i);
+        }
+        __m256 inv_len = harmony_quat_inv_len_avx2(q[0], q[1], q[2], q[3]);
+        for (u32 c = 0; c < 4; ++c) {
+            _mm256_storeu_ps(dst->components[c] + i, _mm256_mul_ps(q[c], inv_len));
+        }
+    }
+    HarmonyQuatStreams dst_tail = harmony_quat_streams_offset(dst, i);
+    HarmonyQuatStreams src_tail = harmony_quat_streams_offset(src, i);
+    harmony_quat_normalize_scalar(&dst_tail, &src_tail, count - i);
+}
+
+HARMONY_TARGET_AVX2
+static void harmony_quat_blend_avx2(
+    const HarmonyQuatStreams *dst,
+    const HarmonyQuatStreams *lhs,
+    const HarmonyQuatStreams *rhs,
+    const f32 *t,
+    usize count,
+    bool spherical
+) {
+    __m256 zero = _mm256_setzero_ps();
+    __m256 one = _mm256_set1_ps(1.0f);
+    __m256 sign = _mm256_set1_ps(-0.0f);
+    usize i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 a[4];
+        __m256 b[4];
+        for (u32 c = 0; c < 4; ++c) {
+            a[c] = _mm256_loadu_ps(lhs->components[c] + i);
+            b[c] = _mm256_loadu_ps(rhs->components[c] + i);
+        }
+        __m256 cos_angle = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(
+            _mm256_mul_ps(a[0], b[0]), _mm256_mul_ps(a[1], b[1])), _mm256_mul_ps(a[2], b[2])), _mm256_mul_ps(a[3], b[3]));
+        __m256 flip = _mm256_and_ps(_mm256_cmp_ps(cos_angle, zero, _CMP_LT_OQ), sign);
+        for (u32 c = 0; c < 4; ++c) {
+            b[c] = _mm256_xor_ps(b[c], flip);
+        }
+        cos_angle = _mm256_xor_ps(cos_angle, flip);
+
+        __m256 rhs_weight = _mm256_loadu_ps(t + i);
+        __m256 lhs_weight = _mm256_sub_ps(one, rhs_weight);
+        if (spherical) {
+            __m256 curved = _mm256_cmp_ps(cos_angle, _mm256_set1_ps(HARMONY_SLERP_LINEAR_COS), _CMP_LT_OQ);
+            __m256 sin_angle = _mm256_sqrt_ps(_mm256_sub_ps(one, _mm256_mul_ps(cos_angle, cos_angle)));
+            __m256 angle = harmony_approx_atan2_avx2(sin_angle, cos_angle);
+            __m256 lhs_sin, rhs_sin, unused;
+            harmony_approx_sincos_avx2(&lhs_sin, &unused, _mm256_mul_ps(lhs_weight, angle));
+            harmony_approx_sincos_avx2(&rhs_sin, &unused, _mm256_mul_ps(rhs_weight, angle));
+            __m256 inv_sin = _mm256_div_ps(one, sin_angle);
+            lhs_weight = _mm256_blendv_ps(lhs_weight, _mm256_mul_ps(lhs_sin, inv_sin), curved);
+            rhs_weight = _mm256_blendv_ps(rhs_weight, _mm256_mul_ps(rhs_sin, inv_sin), curved);
+        }
+
+        __m256 q[4];
+        for (u32 c = 0; c < 4; ++c) {
+            q[c] = _mm256_add_ps(_mm256_mul_ps(a[c], lhs_weight), _mm256_mul_ps(b[c], rhs_weight));
+        }
+        __m256 inv_len = harmony_quat_inv_len_avx2(q[0], q[1], q[2], q[3]);
+        for (u32 c = 0; c < 4; ++c) {
+            _mm256_storeu_ps(dst->components[c] + i, _mm256_mul_ps(q[c], inv_len));
+        }
+    }
+    HarmonyQuatStreams dst_tail = harmony_quat_streams_offset(dst, i);
+    HarmonyQuatStreams lhs_tail = harmony_quat_streams_offset(lhs, i);
+    HarmonyQuatStreams rhs_tail = harmony_quat_streams_offset(rhs, i);
+    harmony_quat_blend_scalar(&dst_tail, &lhs_tail, &rhs_tail, t + i, count - i, spherical);
+}
+
+HARMONY_TARGET_AVX2
+static void harmony_rotation_matrices_avx2(f32 *dst, const HarmonyModelStreams3D *src, usize count, bool affine) {
+    __m256 zero = _mm256_setzero_ps();
+    __m256 one = _mm256_set1_ps(1.0f);
+    __m256 two = _mm256_set1_ps(2.0f);
+    usize stride = affine ? 12 : 9;
+    usize i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 r = _mm256_loadu_ps(src->rotation[0] + i);
+        __m256 qi = _mm256_loadu_ps(src->rotation[1] + i);
+        __m256 qj = _mm256_loadu_ps(src->rotation[2] + i);
+        __m256 qk = _mm256_loadu_ps(src->rotation[3] + i);
+        __m256 scale_x = affine ? _mm256_loadu_ps(src->scale[0] + i) : one;
+        __m256 scale_y = affine ? _mm256_loadu_ps(src->scale[1] + i) : one;
+        __m256 scale_z = affine ? _mm256_loadu_ps(src->scale[2] + i) : one;
+
+        __m256 ii = _mm256_mul_ps(qi, qi);
+        __m256 jj = _mm256_mul_ps(qj, qj);
+        __m256 kk = _mm256_mul_ps(qk, qk);
+        __m256 ij = _mm256_mul_ps(qi, qj);
+        __m256 ik = _mm256_mul_ps(qi, qk);
+        __m256 jk = _mm256_mul_ps(qj, qk);
+        __m256 ri = _mm256_mul_ps(r, qi);
+        __m256 rj = _mm256_mul_ps(r, qj);
+        __m256 rk = _mm256_mul_ps(r, qk);
+
+        __m256 low[8] = {
+            _mm256_mul_ps(scale_x, _mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(jj, kk)))),
+            _mm256_mul_ps(scale_x, _mm256_mul_ps(two, _mm256_add_ps(ij, rk))),
+            _mm256_mul_ps(scale_x, _mm256_mul_ps(two, _mm256_sub_ps(ik, rj))),
+            _mm256_mul_ps(scale_y, _mm256_mul_ps(two, _mm256_sub_ps(ij, rk))),
+            _mm256_mul_ps(scale_y, _mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(ii, kk)))),
+            _mm256_mul_ps(scale_y, _mm256_mul_ps(two, _mm256_add_ps(jk, ri))),
+            _mm256_mul_ps(scale_z, _mm256_mul_ps(two, _mm256_add_ps(ik, rj))),
+            _mm256_mul_ps(scale_z, _mm256_mul_ps(two, _mm256_sub_ps(jk, ri))),
+        };
+        __m256 high[8] = {
+            _mm256_mul_ps(scale_z, _mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(ii, jj)))),
+            affine ? _mm256_loadu_ps(src->position[0] + i) : zero,
+            affine ? _mm256_loadu_ps(src->position[1] + i) : zero,
+            affine ? _mm256_loadu_ps(src->position[2] + i) : zero,
+            zero, zero, zero, zero,
+        };
+        harmony_transpose_8x8_avx2(low);
+        harmony_transpose_8x8_avx2(high);
+        for (u32 j = 0; j < 8; ++j) {
+            f32 *out = dst + (i + j) * stride;
+            _mm256_storeu_ps(out, low[j]);
+            if (affine)
+                _mm_storeu_ps(out + 8, _mm256_castps256_ps128(high[j]));
+            else
+                out[8] = _mm_cvtss_f32(_mm256_castps256_ps128(high[j]));
+        }
+    }
+    HarmonyModelStreams3D tail = {
+        .rotation = {src->rotation[0] + i, src->rotation[1] + i, src->rotation[2] + i, src->rotation[3] + i},
+    };
+    if (affine) {
+        for (u32 c = 0; c < 3; ++c) {
+            tail.position[c] = src->position[c] + i;
+            tail.scale[c] = src->scale[c] + i;
+        }
+    }
+    harmony_rotation_matrices_scalar(dst + i * stride, &tail, count - i, affine);
+}
+
+#endif // HARMONY_X86_KERNELS
+
+void harmony_model_affines_3d(Affine3 *dst, const HarmonyModelStreams3D *src, usize count) {
+    harmony_assert(dst != NULL);
+    harmony_assert(src != NULL);
+    harmony_kernels()->rotation_matrices((f32 *)dst, src, count, true);
+}
+
+void harmony_quats_normalize(const HarmonyQuatStreams *dst, const HarmonyQuatStreams *src, usize count) {
+    harmony_assert(dst != NULL);
+    harmony_assert(src != NULL);
+    harmony_kernels()->quat_normalize(dst, src, count);
+}
+
+void harmony_quats_nlerp(
+    const HarmonyQuatStreams *dst,
+    const HarmonyQuatStreams *lhs,
+    const HarmonyQuatStreams *rhs,
+    const f32 *t,
+    usize count
+) {
+    harmony_assert(dst != NULL);
+    harmony_assert(lhs != NULL);
+    harmony_assert(rhs != NULL);
+    harmony_assert(t != NULL);
+    harmony_kernels()->quat_blend(dst, lhs, rhs, t, count, false);
+}
+
+void harmony_quats_slerp(
+    const HarmonyQuatStreams *dst,
+    const HarmonyQuatStreams *lhs,
+    const HarmonyQuatStreams *rhs,
+    const f32 *t,
+    usize count
+) {
+    harmony_assert(dst != NULL);
+    harmony_assert(lhs != NULL);
+    harmony_assert(rhs != NULL);
+    harmony_assert(t != NULL);
+    harmony_kernels()->quat_blend(dst, lhs, rhs, t, count, true);
+}
+
+void harmony_quats_to_mat3(Mat3 *dst, const HarmonyQuatStreams *src, usize count) {
+    harmony_assert(dst != NULL);
+    harmony_assert(src != NULL);
+    HarmonyModelStreams3D streams = {
+        .rotation = {src->components[0], src->components[1], src->components[2], src->components[3]},
+    };
+    harmony_kernels()->rotation_matrices((f32 *)dst, &streams, count, false);
+}
+
+static u32 harmony_animation_components(u32 channel) {
+    return channel == HARMONY_ANIMATION_ROTATION ? 4 : 3;
+}
+
+HarmonyAnimationClip harmony_animation_clip_create(
+    const HarmonyAllocator *allocator,
+    const HarmonyAnimationTrack *tracks,
+    u32 joint_count
+) {
+    harmony_assert(allocator != NULL);
+    harmony_assert(tracks != NULL || joint_count == 0);
+
+    usize channel_count = (usize)joint_count * HARMONY_ANIMATION_CHANNEL_COUNT;
+    usize time_count = 0;
+    usize value_count = 0;
+    // consecutive channels sharing a times array share the copy in the clip
+    const HarmonyAnimationKeys *previous = NULL;
+    for (u32 joint = 0; joint < joint_count; ++joint) {
+        for (u32 channel = 0; channel < HARMONY_ANIMATION_CHANNEL_COUNT; ++channel) {
+            const HarmonyAnimationKeys *keys = &tracks[joint].channels[channel];
+            harmony_assert(keys->count == 0 || (keys->times != NULL && keys->values != NULL));
+            if (previous == NULL || keys->times != previous->times || keys->count != previous->count)
+                time_count += keys->count;
+            previous = keys;
+            value_count += (usize)keys->count * harmony_animation_components(channel);
+        }
+    }
+
+    HarmonyAnimationClip clip = {0};
+    clip.joint_count = joint_count;
+    clip.allocation_size = channel_count * sizeof(*clip.channels)
+                         + time_count * sizeof(*clip.times)
+                         + value_count * sizeof(*clip.values);
+    clip.allocation = harmony_alloc(allocator, harmony_max(clip.allocation_size, 1));
+    harmony_assert(clip.allocation != NULL);
+    clip.channels = clip.allocation;
+    clip.times = (f32 *)(clip.channels + channel_count);
+    clip.values = (u16 *)(clip.times + time_count);
+
+    u32 next_time = 0;
+    u32 first_time = 0;
+    u32 first_value = 0;
+    previous = NULL;
+    for (u32 joint = 0; joint < joint_count; ++joint) {
+        for (u32 channel = 0; channel < HARMONY_ANIMATION_CHANNEL_COUNT; ++channel) {
+            const HarmonyAnimationKeys *keys = &tracks[joint].channels[channel];
+            HarmonyAnimationChannelKeys *dst = &clip.channels[joint * HARMONY_ANIMATION_CHANNEL_COUNT + channel];
+            u32 components = harmony_animation_components(channel);
+            const f32 *values = keys->values;
+            if (previous == NULL || keys->times != previous->times || keys->count != previous->count) {
+                first_time = next_time;
+                next_time += keys->count;
+            }
+            previous = keys;
+            *dst = (HarmonyAnimationChannelKeys){
+                .count = keys->count,
+                .first_time = first_time,
+                .first_value = first_value,
+            };
+
+            for (u32 k = 0; k < keys->count; ++k) {
+                harmony_assert(k == 0 || keys->times[k] >= keys->times[k - 1]);
+                clip.times[first_time + k] = keys->times[k];
+            }
+            if (keys->count > 0)
+                clip.duration = harmony_max(clip.duration, keys->times[keys->count - 1]);
+
+            for (u32 c = 0; c < components; ++c) {
+                f32 min = INFINITY;
+                f32 max = -INFINITY;
+                for (u32 k = 0; k < keys->count; ++k) {
+                    min = harmony_min(min, values[k * components + c]);
+                    max = harmony_max(max, values[k * components + c]);
+                }
+                if (keys->count == 0)
+                    continue;
+                dst->min[c] = min;
+                dst->step[c] = (max - min) / (f32)UINT16_MAX;
+                f32 scale = max > min ? (f32)UINT16_MAX / (max - min) : 0.0f;
+                for (u32 k = 0; k < keys->count; ++k) {
+                    f32 quantized = rintf((values[k * components + c] - min) * scale);
+                    clip.values[first_value + k * components + c] = (u16)harmony_min(quantized, (f32)UINT16_MAX);
+                }
+            }
+            first_value += keys->count * components;
+        }
+    }
+    return clip;
+}
+
+void harmony_animation_clip_destroy(const HarmonyAllocator *allocator, HarmonyAnimationClip *clip) {
+    harmony_assert(allocator != NULL);
+    harmony_assert(clip != NULL);
+    harmony_free(allocator, clip->allocation, harmony_max(clip->allocation_size, 1));
+    *clip = (HarmonyAnimationClip){0};
+}
+
+u32 harmony_animation_cursor_count(const HarmonyAnimationClip *clip) {
+    harmony_assert(clip != NULL);
+    return clip->joint_count * HARMONY_ANIMATION_CHANNEL_COUNT;
+}
+
+// how far a cursor steps forward before falling back to a binary search
+#define HARMONY_ANIMATION_SCAN 4
+
+/**
+ * Finds the last key at or before time, or the first key if there is none
+ */
+static u32 harmony_animation_seek(const f32 *times, u32 count, u32 cursor, f32 time) {
+    if (cursor < count && times[cursor] <= time) {
+        for (u32 step = 0; step < HARMONY_ANIMATION_SCAN; ++step) {
+            if (cursor + 1 >= count || times[cursor + 1] > time)
+                return cursor;
+            ++cursor;
+        }
+    }
+    u32 low = 0;
+    u32 high = count;
+    while (high - low > 1) {
+        u32 mid = low + (high - low) / 2;
+        if (times[mid] <= time)
+            low = mid;
+        else
+            high = mid;
+    }
+    return low;
+}
+
+/**
+ * The keys around a time in one times array, and how far between them it is
+ */
+typedef struct HarmonyAnimationSpan {
+    u32 first_time;
+    u32 count;
+    u32 key;
+    u32 next;
+    f32 alpha;
+} HarmonyAnimationSpan;
+
+static void harmony_animation_locate(
+    HarmonyAnimationSpan *span,
+    const HarmonyAnimationClip *clip,
+    const HarmonyAnimationChannelKeys *keys,
+    u32 cursor,
+    f32 time
+) {
+    const f32 *times = clip->times + keys->first_time;
+    u32 k = harmony_animation_seek(times, keys->count, cursor, time);
+    span->first_time = keys->first_time;
+    span->count = keys->count;
+    span->key = k;
+    span->next = k + 1 < keys->count ? k + 1 : k;
+    span->alpha = 0.0f;
+    if (span->next != k && time > times[k]) {
+        f32 alpha = (time - times[k]) / (times[span->next] - times[k]);
+        span->alpha = alpha < 1.0f ? alpha : 1.0f;
+    }
+}
+
+static inline void harmony_animation_interpolate(
+    f32 *dst,
+    const HarmonyAnimationClip *clip,
+    const HarmonyAnimationChannelKeys *keys,
+    u32 components,
+    const HarmonyAnimationSpan *span
+) {
+    const u16 *values = clip->values + keys->first_value;
+    f32 a[4];
+    f32 b[4];
+    f32 dot = 0.0f;
+    for (u32 c = 0; c < components; ++c) {
+        a[c] = keys->min[c] + (f32)values[span->key * components + c] * keys->step[c];
+        b[c] = keys->min[c] + (f32)values[span->next * components + c] * keys->step[c];
+        dot += a[c] * b[c];
+    }
+    if (components == 4) {
+        f32 direction = dot < 0.0f ? -1.0f : 1.0f;
+        f32 len2 = 0.0f;
+        for (u32 c = 0; c < 4; ++c) {
+            dst[c] = a[c] + (b[c] * direction - a[c]) * span->alpha;
+            len2 += dst[c] * dst[c];
+        }
+        f32 inv_len = 1.0f / sqrtf(len2);
+        for (u32 c = 0; c < 4; ++c) {
+            dst[c] *= inv_len;
+        }
+    } else {
+        for (u32 c = 0; c < components; ++c) {
+            dst[c] = a[c] + (b[c] - a[c]) * span->alpha;
+        }
+    }
+}
+
+static void harmony_animation_sample_instances(
+    const HarmonyAnimationClip *clip,
+    u32 *cursors,
+    const f32 *times,
+    const HarmonyPose *dst,
+    usize begin,
+    usize end
+) {
+    u32 joint_count = clip->joint_count;
+    u32 cursor_count = joint_count * HARMONY_ANIMATION_CHANNEL_COUNT;
+    for (usize instance = begin; instance < end; ++instance) {
+        f32 time = harmony_clamp(times[instance], 0.0f, clip->duration);
+        u32 *instance_cursors = cursors + instance * cursor_count;
+        f32 *translations = (f32 *)(dst->translations + instance * joint_count);
+        f32 *rotations = (f32 *)(dst->rotations + instance * joint_count);
+        f32 *scales = (f32 *)(dst->scales + instance * joint_count);
+
+        // channels sharing times share the search, which is common when keys
+        // are sampled at a fixed rate
+        HarmonyAnimationSpan span = {.first_time = UINT32_MAX};
+        for (u32 joint = 0; joint < joint_count; ++joint) {
+            const HarmonyAnimationChannelKeys *keys = clip->channels + joint * HARMONY_ANIMATION_CHANNEL_COUNT;
+            u32 *joint_cursors = instance_cursors + joint * HARMONY_ANIMATION_CHANNEL_COUNT;
+            HarmonyAnimationSpan spans[HARMONY_ANIMATION_CHANNEL_COUNT];
+            for (u32 channel = 0; channel < HARMONY_ANIMATION_CHANNEL_COUNT; ++channel) {
+                if (keys[channel].count == 0)
+                    continue;
+                if (keys[channel].first_time != span.first_time || keys[channel].count != span.count)
+                    harmony_animation_locate(&span, clip, &keys[channel], joint_cursors[channel], time);
+                joint_cursors[channel] = span.key;
+                spans[channel] = span;
+            }
+
+            if (keys[HARMONY_ANIMATION_TRANSLATION].count > 0)
+                harmony_animation_interpolate(translations + joint * 3, clip,
+                    &keys[HARMONY_ANIMATION_TRANSLATION], 3, &spans[HARMONY_ANIMATION_TRANSLATION]);
+            else
+                memcpy(translations + joint * 3, &(Vec3){0.0f, 0.0f, 0.0f}, sizeof(Vec3));
+            if (keys[HARMONY_ANIMATION_ROTATION].count > 0)
+                harmony_animation_interpolate(rotations + joint * 4, clip,
+                    &keys[HARMONY_ANIMATION_ROTATION], 4, &spans[HARMONY_ANIMATION_ROTATION]);
+            else
+                memcpy(rotations + joint * 4, &(Quat){1.0f, 0.0f, 0.0f, 0.0f}, sizeof(Quat));
+            if (keys[HARMONY_ANIMATION_SCALE].count > 0)
+                harmony_animation_interpolate(scales + joint * 3, clip,
+                    &keys[HARMONY_ANIMATION_SCALE], 3, &spans[HARMONY_ANIMATION_SCALE]);
+            else
+                memcpy(scales + joint * 3, &(Vec3){1.0f, 1.0f, 1.0f}, sizeof(Vec3));
+        }
+    }
+}
+
+void harmony_animation_sample(
+    const HarmonyAnimationClip *clip,
+    u32 *cursors,
+    const f32 *times,
+    const HarmonyPose *dst,
+    u32 instance_count
+) {
+    harmony_assert(clip != NULL);
+    harmony_assert(cursors != NULL);
+    harmony_assert(times != NULL);
+    harmony_assert(dst != NULL);
+    harmony_animation_sample_instances(clip, cursors, times, dst, 0, instance_count);
+}
+
+typedef struct HarmonyAnimationSampleArgs {
+    const HarmonyAnimationClip *clip;
+    u32 *cursors;
+    const f32 *times;
+    const HarmonyPose *dst;
+} HarmonyAnimationSampleArgs;
+
+static void harmony_animation_sample_range(void *data, usize begin, usize end) {
+    HarmonyAnimationSampleArgs *args = data;
+    harmony_animation_sample_instances(args->clip, args->cursors, args->times, args->dst, begin, end);
+}
+
+void harmony_animation_sample_parallel(
+    u32 thread_count,
+    const HarmonyAnimationClip *clip,
+    u32 *cursors,
+    const f32 *times,
+    const HarmonyPose *dst,
+    u32 instance_count
+) {
+    harmony_assert(clip != NULL);
+    harmony_assert(cursors != NULL);
+    harmony_assert(times != NULL);
+    harmony_assert(dst != NULL);
+    HarmonyAnimationSampleArgs args = {clip, cursors, times, dst};
+    harmony_parallel_for(thread_count, instance_count, harmony_animation_sample_range, &args);
+}
+
+void harmony_pose_blend(
+    const HarmonyPose *dst,
+    const HarmonyPose *lhs,
+    const HarmonyPose *rhs,
+    const f32 *weights,
+    usize joint_count
+) {
+    harmony_assert(dst != NULL);
+    harmony_assert(lhs != NULL);
+    harmony_assert(rhs != NULL);
+    harmony_assert(weights != NULL);
+    for (usize i = 0; i < joint_count; ++i) {
+        f32 w = weights[i];
+        Vec3 lt = lhs->translations[i];
+        Vec3 rt = rhs->translations[i];
+        dst->translations[i] = (Vec3){lt.x + (rt.x - lt.x) * w, lt.y + (rt.y - lt.y) * w, lt.z + (rt.z - lt.z) * w};
+        Vec3 ls = lhs->scales[i];
+        Vec3 rs = rhs->scales[i];
+        dst->scales[i] = (Vec3){ls.x + (rs.x - ls.x) * w, ls.y + (rs.y - ls.y) * w, ls.z + (rs.z - ls.z) * w};
+
+        Quat a = lhs->rotations[i];
+        Quat b = rhs->rotations[i];
+        f32 rhs_weight = a.r * b.r + a.i * b.i + a.j * b.j + a.k * b.k < 0.0f ? -w : w;
+        f32 lhs_weight = 1.0f - w;
+        Quat q = {
+            a.r * lhs_weight + b.r * rhs_weight,
+            a.i * lhs_weight + b.i * rhs_weight,
+            a.j * lhs_weight + b.j * rhs_weight,
+            a.k * lhs_weight + b.k * rhs_weight,
+        };
+        f32 inv_len = 1.0f / sqrtf(q.r * q.r + q.i * q.i + q.j * q.j + q.k * q.k);
+        dst->rotations[i] = (Quat){q.r * inv_len, q.i * inv_len, q.j * inv_len, q.k * inv_len};
+    }
+}
+
+HarmonyTransformHierarchy harmony_transform_hierarchy_create(const HarmonyAllocator *allocator, u32 capacity) {
+    harmony_assert(allocator != NULL);
+    harmony_assert(capacity > 0 && capacity < HARMONY_TRANSFORM_NONE);
+
+    HarmonyTransformHierarchy hierarchy = {0};
+    hierarchy.capacity = capacity;
+    // parents, sizes, handles, and indices, ten streams, two task lists and
+    // their counts, the worlds, then the flags
+    hierarchy.allocation_size = (usize)capacity * (4 * sizeof(u32) + 10 * sizeof(f32) + 3 * sizeof(u32)
+                                                 + sizeof(Affine3) + sizeof(bool));
+    hierarchy.allocation = harmony_alloc(allocator, hierarchy.allocation_size);
+    harmony_assert(hierarchy.allocation != NULL);
+
+    u32 *words = hierarchy.allocation;
+    hierarchy.parents = words;
+    hierarchy.sizes = words + capacity;
+    hierarchy.handles = words + 2 * (usize)capacity;
+    hierarchy.indices = words + 3 * (usize)capacity;
+    f32 *streams = (f32 *)(words + 4 * (usize)capacity);
+    for (u32 c = 0; c < 3; ++c) {
+        hierarchy.position[c] = streams + c * (usize)capacity;
+        hierarchy.scale[c] = streams + (3 + c) * (usize)capacity;
+    }
+    for (u32 c = 0; c < 4; ++c) {
+        hierarchy.rotation[c] = streams + (6 + c) * (usize)capacity;
+    }
+    hierarchy.tasks = (u32 *)(streams + 10 * (usize)capacity);
+    hierarchy.worlds = (Affine3 *)(hierarchy.tasks + 3 * (usize)capacity);
+    hierarchy.dirty = (bool *)(hierarchy.worlds + capacity);
+    return hierarchy;
+}
+
+void harmony_transform_hierarchy_destroy(const HarmonyAllocator *allocator, HarmonyTransformHierarchy *hierarchy) {
+    harmony_assert(allocator != NULL);
+    harmony_assert(hierarchy != NULL);
+    harmony_free(allocator, hierarchy->allocation, hierarchy->allocation_size);
+    *hierarchy = (HarmonyTransformHierarchy){0};
+}
+
+static void harmony_transform_store(HarmonyTransformHierarchy *hierarchy, u32 index, Vec3 position, Vec3 scale, Quat rotation) {
+    hierarchy->position[0][index] = position.x;
+    hierarchy->position[1][index] = position.y;
+    hierarchy->position[2][index] = position.z;
+    hierarchy->scale[0][index] = scale.x;
+    hierarchy->scale[1][index] = scale.y;
+    hierarchy->scale[2][index] = scale.z;
+    hierarchy->rotation[0][index] = rotation.r;
+    hierarchy->rotation[1][index] = rotation.i;
+    hierarchy->rotation[2][index] = rotation.j;
+    hierarchy->rotation[3][index] = rotation.k;
+    hierarchy->dirty[index] = true;
+}
+
+u32 harmony_transform_add(
+    HarmonyTransformHierarchy *hierarchy,
+    u32 parent,
+    Vec3 position,
+    Vec3 scale,
+    Quat rotation
+) {
+    harmony_assert(hierarchy != NULL);
+    harmony_assert(hierarchy->count < hierarchy->capacity);
+    harmony_assert(parent == HARMONY_TRANSFORM_NONE || parent < hierarchy->count);
+
+    // the node goes at the end of its parent's subtree, keeping it contiguous
+    u32 parent_index = parent == HARMONY_TRANSFORM_NONE ? HARMONY_TRANSFORM_NONE : hierarchy->indices[parent];
+    u32 index = parent == HARMONY_TRANSFORM_NONE ? hierarchy->count : parent_index + hierarchy->sizes[parent_index];
+    usize moved = hierarchy->count - index;
+    if (moved > 0) {
+        u32 *u32_arrays[] = {hierarchy->parents, hierarchy->sizes, hierarchy->handles};
+        for (u32 a = 0; a < 3; ++a) {
+            memmove(u32_arrays[a] + index + 1, u32_arrays[a] + index, moved * sizeof(u32));
+        }
+        for (u32 c = 0; c < 3; ++c) {
+            memmove(hierarchy->position[c] + index + 1, hierarchy->position[c] + index, moved * sizeof(f32));
+            memmove(hierarchy->scale[c] + index + 1, hierarchy->scale[c] + index, moved * sizeof(f32));
+        }
+        for (u32 c = 0; c < 4; ++c) {
+            memmove(hierarchy->rotation[c] + index + 1, hierarchy->rotation[c] + index, moved * sizeof(f32));
+        }
+        memmove(hierarchy->worlds + index + 1, hierarchy->worlds + index, moved * sizeof(Affine3));
+        memmove(hierarchy->dirty + index + 1, hierarchy->dirty + index, moved * sizeof(bool));
+        for (u32 i = index + 1; i <= hierarchy->count; ++i) {
+            if (hierarchy->parents[i] != HARMONY_TRANSFORM_NONE && hierarchy->parents[i] >= index)
+                ++hierarchy->parents[i];
+            hierarchy->indices[hierarchy->handles[i]] = i;
+        }
+    }
+    for (u32 ancestor = parent_index; ancestor != HARMONY_TRANSFORM_NONE; ancestor = hierarchy->parents[ancestor]) {
+        ++hierarchy->sizes[ancestor];
+    }
+
+    u32 handle = hierarchy->count++;
+    hierarchy->parents[index] = parent_index;
+    hierarchy->sizes[index] = 1;
+    hierarchy->handles[index] = handle;
+    hierarchy->indices[handle] = index;
+    harmony_transform_store(hierarchy, index, position, scale, rotation);
+    return handle;
+}
+
+void harmony_transform_set(
+    HarmonyTransformHierarchy *hierarchy,
+    u32 handle,
+    Vec3 position,
+    Vec3 scale,
+    Quat rotation
+) {
+    harmony_assert(hierarchy != NULL);
+    harmony_assert(handle < hierarchy->count);
+    harmony_transform_store(hierarchy, hierarchy->indices[handle], position, scale, rotation);
+}
+
+Affine3 harmony_transform_world(const HarmonyTransformHierarchy *hierarchy, u32 handle) {
+    harmony_assert(hierarchy != NULL);
+    harmony_assert(handle < hierarchy->count);
+    return hierarchy->worlds[hierarchy->indices[handle]];
+}
+
+/**
+ * Recomputes the world transforms of the nodes in [begin, end), whose
+ * parents outside the range must be up to date
+ */
+static void harmony_transform_compute(HarmonyTransformHierarchy *hierarchy, u32 begin, u32 end) {
+    HarmonyModelStreams3D locals = {
+        .position = {hierarchy->position[0] + begin, hierarchy->position[1] + begin, hierarchy->position[2] + begin},
+        .scale = {hierarchy->scale[0] + begin, hierarchy->scale[1] + begin, hierarchy->scale[2] + begin},
+        .rotation = {
+            hierarchy->rotation[0] + begin,
+            hierarchy->rotation[1] + begin,
+            hierarchy->rotation[2] + begin,
+            hierarchy->rotation[3] + begin,
+        },
+    };
+    harmony_model_affines_3d(hierarchy->worlds + begin, &locals, end - begin);
+    for (u32 i = begin; i < end; ++i) {
+        u32 parent = hierarchy->parents[i];
+        if (parent != HARMONY_TRANSFORM_NONE)
+            hierarchy->worlds[i] = acompose(hierarchy->worlds[parent], hierarchy->worlds[i]);
+        hierarchy->dirty[i] = false;
+    }
+}
+
+/**
+ * Updates the dirty subtrees in [begin, end), which must be whole subtrees
+ */
+static u32 harmony_transform_update_range(HarmonyTransformHierarchy *hierarchy, u32 begin, u32 end) {
+    u32 updated = 0;
+    u32 i = begin;
+    while (i < end) {
+        if (!hierarchy->dirty[i]) {
+            ++i;
+            continue;
+        }
+        u32 subtree_end = i + hierarchy->sizes[i];
+        harmony_transform_compute(hierarchy, i, subtree_end);
+        updated += subtree_end - i;
+        i = subtree_end;
+    }
+    return updated;
+}
+
+u32 harmony_transform_update(HarmonyTransformHierarchy *hierarchy) {
+    harmony_assert(hierarchy != NULL);
+    return harmony_transform_update_range(hierarchy, 0, hierarchy->count);
+}
+
+// the most levels the hierarchy is split below its roots for threads
+#define HARMONY_TRANSFORM_SPLIT_LEVELS 8
+
+typedef struct HarmonyTransformUpdateArgs {
+    HarmonyTransformHierarchy *hierarchy;
+    const u32 *tasks;
+    u32 *counts;
+} HarmonyTransformUpdateArgs;
+
+static void harmony_transform_update_tasks(void *data, usize begin, usize end) {
+    HarmonyTransformUpdateArgs *args = data;
+    for (usize t = begin; t < end; ++t) {
+        u32 root = args->tasks[t];
+        args->counts[t] = harmony_transform_update_range(args->hierarchy, root, root + args->hierarchy->sizes[root]);
+    }
+}
+
+u32 harmony_transform_update_parallel(u32 thread_count, HarmonyTransformHierarchy *hierarchy) {
+    harmony_assert(hierarchy != NULL);
+    u32 *tasks = hierarchy->tasks;
+    u32 *next = tasks + hierarchy->capacity;
+    u32 *counts = next + hierarchy->capacity;
+
+    u32 task_count = 0;
+    for (u32 i = 0; i < hierarchy->count; i += hierarchy->sizes[i]) {
+        tasks[task_count++] = i;
+    }
+
+    // replaces each subtree with its children, updating the subtree's root
+    // first, until there are several subtrees for each thread
+    u32 updated = 0;
+    u32 target = harmony_max(thread_count, 1u) * 4;
+    for (u32 level = 0; level < HARMONY_TRANSFORM_SPLIT_LEVELS && task_count > 0 && task_count < target; ++level) {
+        u32 next_count = 0;
+        for (u32 t = 0; t < task_count; ++t) {
+            u32 root = tasks[t];
+            bool dirty = hierarchy->dirty[root];
+            if (hierarchy->sizes[root] > 1 && dirty) {
+                harmony_transform_compute(hierarchy, root, root + 1);
+                ++updated;
+            }
+            if (hierarchy->sizes[root] == 1) {
+                next[next_count++] = root;
+                continue;
+            }
+            for (u32 child = root + 1; child < root + hierarchy->sizes[root]; child += hierarchy->sizes[child]) {
+                hierarchy->dirty[child] = hierarchy->dirty[child] || dirty;
+                next[next_count++] = child;
+            }
+        }
+        u32 *swap = tasks;
+        tasks = next;
+        next = swap;
+        task_count = next_count;
+    }
+
+    HarmonyTransformUpdateArgs args = {hierarchy, tasks, counts};
+    harmony_parallel_for(thread_count, task_count, harmony_transform_update_tasks, &args);
+    for (u32 t = 0; t < task_count; ++t) {
+        updated += counts[t];
+    }
+    return updated;
+}
+
+HarmonyFrustum harmony_frustum_create(Mat4 view_projection) {
+    const f32 *m = (const f32 *)&view_projection;
+    Vec4 rows[4];
+    for (u32 r = 0; r < 4; ++r) {
+        rows[r] = (Vec4){m[r], m[4 + r], m[8 + r], m[12 + r]};
+    }
+    // -w <= x <= w, -w <= y <= w, and 0 <= z <= w in clip space
+    Vec4 planes[6] = {
+        vadd4(rows[3], rows[0]),
+        vsub4(rows[3], rows[0]),
+        vadd4(rows[3], rows[1]),
+        vsub4(rows[3], rows[1]),
+        rows[2],
+        vsub4(rows[3], rows[2]),
+    };
+    HarmonyFrustum frustum;
+    for (u32 p = 0; p < 6; ++p) {
+        f32 len = sqrtf(planes[p].x * planes[p].x + planes[p].y * planes[p].y + planes[p].z * planes[p].z);
+        harmony_assert(len > 0.0f);
+        frustum.planes[p] = svmul4(1.0f / len, planes[p]);
+    }
+    return frustum;
+}
+
+/**
+ * Selects the streams each plane tests: the corner furthest along its normal
+ * for boxes, or the center for spheres
+ */
+static void harmony_cull_streams(const f32 *streams[6][3], const Vec4 *planes, const f32 *const *bounds, bool spheres) {
+    for (u32 p = 0; p < 6; ++p) {
+        for (u32 c = 0; c < 3; ++c) {
+            streams[p][c] = spheres || ((const f32 *)&planes[p])[c] < 0.0f ? bounds[c] : bounds[3 + c];
+        }
+    }
+}
+
+static void harmony_cull_scalar(u32 *visible, const Vec4 *planes, const f32 *const *bounds, usize count, bool spheres) {
+    const f32 *streams[6][3];
+    harmony_cull_streams(streams, planes, bounds, spheres);
+    for (usize word = 0; word * 32 < count; ++word) {
+        visible[word] = 0;
+    }
+    for (usize i = 0; i < count; ++i) {
+        f32 threshold = spheres ? -bounds[3][i] : 0.0f;
+        bool inside = true;
+        for (u32 p = 0; p < 6; ++p) {
+            f32 distance = planes[p].x * streams[p][0][i] + planes[p].y * streams[p][1][i]
+                         + planes[p].z * streams[p][2][i] + planes[p].w;
+            inside = inside && distance >= threshold;
+        }
+        visible[i / 32] |= (u32)inside << (i & 31);
+    }
+}
+
+#ifdef HARMONY_X86_KERNELS
+
+HARMONY_TARGET_AVX2
+static void harmony_cull_avx2(u32 *visible, const Vec4 *planes, const f32 *const *bounds, usize count, bool spheres) {
+    const f32 *streams[6][3];
+    harmony_cull_streams(streams, planes, bounds, spheres);
+    __m256 normals[6][3];
+    __m256 offsets[6];
+    for (u32 p = 0; p < 6; ++p) {
+        normals[p][0] = _mm256_set1_ps(planes[p].x);
+        normals[p][1] = _mm256_set1_ps(planes[p].y);
+        normals[p][2] = _mm256_set1_ps(planes[p].z);
+        offsets[p] = _mm256_set1_ps(planes[p].w);
+    }
+    __m256 zero = _mm256_setzero_ps();
+    __m256 sign = _mm256_set1_ps(-0.0f);
+    usize i = 0;
+    for (; i + 32 <= count; i += 32) {
+        u32 word = 0;
+        for (u32 lane = 0; lane < 32; lane += 8) {
+            __m256 threshold = spheres ? _mm256_xor_ps(_mm256_loadu_ps(bounds[3] + i + lane), sign) : zero;
+            __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+            for (u32 p = 0; p < 6; ++p) {
+                __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(
+                    _mm256_mul_ps(normals[p][0], _mm256_loadu_ps(streams[p][0] + i + lane)),
+                    _mm256_mul_ps(normals[p][1], _mm256_loadu_ps(streams[p][1] + i + lane))),
+                    _mm256_mul_ps(normals[p][2], _mm256_loadu_ps(streams[p][2] + i + lane))),
+                    offsets[p]);
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, threshold, _CMP_GE_OQ));
+            }
+            word |= (u32)_mm256_movemask_ps(inside) << lane;
+        }
+        visible[i / 32] = word;
+    }
+    const f32 *tail[6];
+    for (u32 s = 0; s < (spheres ? 4u : 6u); ++s) {
+        tail[s] = bounds[s] + i;
+    }
+    harmony_cull_scalar(visible + i / 32, planes, tail, count - i, spheres);
+}
+
+#endif // HARMONY_X86_KERNELS
+
+void harmony_cull_aabbs(u32 *visible, const HarmonyFrustum *frustum, const HarmonyAabbStreams *src, usize count) {
+    harmony_assert(visible != NULL);
+    harmony_assert(frustum != NULL);
+    harmony_assert(src != NULL);
+    const f32 *bounds[6] = {src->min[0], src->min[1], src->min[2], src->max[0], src->max[1], src->max[2]};
+    harmony_kernels()->cull(visible, frustum->planes, bounds, count, false);
+}
+
+void harmony_cull_spheres(u32 *visible, const HarmonyFrustum *frustum, const HarmonySphereStreams *src, usize count) {
+    harmony_assert(visible != NULL);
+    harmony_assert(frustum != NULL);
+    harmony_assert(src != NULL);
+    const f32 *bounds[4] = {src->center[0], src->center[1], src->center[2], src->radius};
+    harmony_kernels()->cull(visible, frustum->planes, bounds, count, true);
+}
+
+typedef struct HarmonyCullArgs {
+    u32 *visible;
+    const Vec4 *planes;
+    const f32 *bounds[6];
+    usize count;
+    bool spheres;
+} HarmonyCullArgs;
+
+static void harmony_cull_range(void *data, usize begin, usize end) {
+    HarmonyCullArgs *args = data;
+    usize first = begin * 32;
+    usize last = harmony_min(end * 32, args->count);
+    const f32 *bounds[6];
+    for (u32 s = 0; s < (args->spheres ? 4u : 6u); ++s) {
+        bounds[s] = args->bounds[s] + first;
+    }
+    harmony_kernels()->cull(args->visible + begin, args->planes, bounds, last - first, args->spheres);
+}
+
+void harmony_cull_aabbs_parallel(
+    u32 thread_count,
+    u32 *visible,
+    const HarmonyFrustum *frustum,
+    const HarmonyAabbStreams *src,
+    usize count
+) {
+    harmony_assert(visible != NULL);
+    harmony_assert(frustum != NULL);
+    harmony_assert(src != NULL);
+    HarmonyCullArgs args = {
+        visible,
+        frustum->planes,
+        {src->min[0], src->min[1], src->min[2], src->max[0], src->max[1], src->max[2]},
+        count,
+        false,
+    };
+    harmony_parallel_for(thread_count, (count + 31) / 32, harmony_cull_range, &args);
+}
+
+void harmony_cull_spheres_parallel(
+    u32 thread_count,
+    u32 *visible,
+    const HarmonyFrustum *frustum,
+    const HarmonySphereStreams *src,
+    usize count
+) {
+    harmony_assert(visible != NULL);
+    harmony_assert(frustum != NULL);
+    harmony_assert(src != NULL);
+    HarmonyCullArgs args = {
+        visible,
+        frustum->planes,
+        {src->center[0], src->center[1], src->center[2], src->radius},
+        count,
+        true,
+    };
+    harmony_parallel_for(thread_count, (count + 31) / 32, harmony_cull_range, &args);
+}
+
+usize harmony_visible_indices(u32 *dst, const u32 *visible, usize count) {
+    harmony_assert(dst != NULL);
+    harmony_assert(visible != NULL);
+    usize written = 0;
+    for (usize word = 0; word * 32 < count; ++word) {
+        for (u32 bits = visible[word]; bits != 0; bits &= bits - 1) {
+            dst[written++] = (u32)(word * 32) + (u32)__builtin_ctz(bits);
+        }
+    }
+    return written;
+}
+
+bool harmony_ray_triangle(Vec3 origin, Vec3 direction, Vec3 a, Vec3 b, Vec3 c, f32 max_distance, HarmonyRayHit *hit) {
+    harmony_assert(hit != NULL);
+    Vec3 e1 = {b.x - a.x, b.y - a.y, b.z - a.z};
+    Vec3 e2 = {c.x - a.x, c.y - a.y, c.z - a.z};
+    Vec3 p = {
+        direction.y * e2.z - direction.z * e2.y,
+        direction.z * e2.x - direction.x * e2.z,
+        direction.x * e2.y - direction.y * e2.x,
+    };
+    f32 det = e1.x * p.x + e1.y * p.y + e1.z * p.z;
+    if (det == 0.0f)
+        return false;
+    f32 inv_det = 1.0f / det;
+    Vec3 s = {origin.x - a.x, origin.y - a.y, origin.z - a.z};
+    f32 u = (s.x * p.x + s.y * p.y + s.z * p.z) * inv_det;
+    if (!(u >= 0.0f && u <= 1.0f))
+        return false;
+    Vec3 q = {
+        s.y * e1.z - s.z * e1.y,
+        s.z * e1.x - s.x * e1.z,
+        s.x * e1.y - s.y * e1.x,
+    };
+    f32 v = (direction.x * q.x + direction.y * q.y + direction.z * q.z) * inv_det;
+    if (!(v >= 0.0f && u + v <= 1.0f))
+        return false;
+    f32 t = (e2.x * q.x + e2.y * q.y + e2.z * q.z) * inv_det;
+    if (!(t >= 0.0f && t <= max_distance))
+        return false;
+    hit->distance = t;
+    hit->u = u;
+    hit->v = v;
+    return true;
+}
+
+bool harmony_ray_triangle_watertight(
+    Vec3 origin,
+    Vec3 direction,
+    Vec3 a,
+    Vec3 b,
+    Vec3 c,
+    f32 max_distance,
+    HarmonyRayHit *hit
+) {
+    harmony_assert(hit != NULL);
+    // the axis the ray mostly follows becomes z, keeping the winding
+    const f32 *d = (const f32 *)&direction;
+    f32 abs_x = fabsf(d[0]);
+    f32 abs_y = fabsf(d[1]);
+    f32 abs_z = fabsf(d[2]);
+    u32 kz = abs_x >= abs_y && abs_x >= abs_z ? 0 : abs_y >= abs_z ? 1 : 2;
+    u32 kx = kz == 2 ? 0 : kz + 1;
+    u32 ky = kx == 2 ? 0 : kx + 1;
+    if (d[kz] < 0.0f) {
+        u32 swap = kx;
+        kx = ky;
+        ky = swap;
+    }
+    f32 sx = d[kx] / d[kz];
+    f32 sy = d[ky] / d[kz];
+    f32 sz = 1.0f / d[kz];
+
+    // shears the vertices, relative to the origin, so the ray runs along z
+    f32 va[3] = {a.x - origin.x, a.y - origin.y, a.z - origin.z};
+    f32 vb[3] = {b.x - origin.x, b.y - origin.y, b.z - origin.z};
+    f32 vc[3] = {c.x - origin.x, c.y - origin.y, c.z - origin.z};
+    f32 ax = va[kx] - sx * va[kz];
+    f32 ay = va[ky] - sy * va[kz];
+    f32 bx = vb[kx] - sx * vb[kz];
+    f32 by = vb[ky] - sy * vb[kz];
+    f32 cx = vc[kx] - sx * vc[kz];
+    f32 cy = vc[ky] - sy * vc[kz];
+
+    f32 u = cx * by - cy * bx;
+    f32 v = ax * cy - ay * cx;
+    f32 w = bx * ay - by * ax;
+    if (u == 0.0f || v == 0.0f || w == 0.0f) {
+        u = (f32)((f64)cx * (f64)by - (f64)cy * (f64)bx);
+        v = (f32)((f64)ax * (f64)cy - (f64)ay * (f64)cx);
+        w = (f32)((f64)bx * (f64)ay - (f64)by * (f64)ax);
+    }
+    if ((u < 0.0f || v < 0.0f || w < 0.0f) && (u > 0.0f || v > 0.0f || w > 0.0f))
+        return false;
+    f32 det = u + v + w;
+    if (det == 0.0f)
+        return false;
+    f32 inv_det = 1.0f / det;
+    f32 t = (u * (sz * va[kz]) + v * (sz * vb[kz]) + w * (sz * vc[kz])) * inv_det;
+    if (!(t >= 0.0f && t <= max_distance))
+        return false;
+    hit->distance = t;
+    hit->u = v * inv_det;
+    hit->v = w * inv_det;
+    return true;
+}
+
+void harmony_triangle_bounds(const HarmonyAabbStreams *dst, const Vec3 *vertices, const u32 *indices, usize count) {
+    harmony_assert(dst != NULL);
+    harmony_assert(vertices != NULL);
+    harmony_assert(indices != NULL);
+    for (usize i = 0; i < count; ++i) {
+        const f32 *a = (const f32 *)&vertices[indices[3 * i]];
+        const f32 *b = (const f32 *)&vertices[indices[3 * i + 1]];
+        const f32 *c = (const f32 *)&vertices[indices[3 * i + 2]];
+        for (u32 axis = 0; axis < 3; ++axis) {
+            dst->min[axis][i] = harmony_min(harmony_min(a[axis], b[axis]), c[axis]);
+            dst->max[axis][i] = harmony_max(harmony_max(a[axis], b[axis]), c[axis]);
+        }
+    }
+}
+
+// the number of bins the surface area heuristic evaluates splits between
+#define HARMONY_BVH_BINS 16
+// below this depth splits use the surface area heuristic, and at or past it
+// the median, keeping the depth within HARMONY_BVH_STACK_SIZE
+#define HARMONY_BVH_SAH_DEPTH 32
+// subtrees with fewer primitives are not split further for threads
+#define HARMONY_BVH_TASK_SIZE 1024
+// the most subtrees split off for threads
+#define HARMONY_BVH_TASK_COUNT (4 * HARMONY_MAX_THREADS)
+// widens ray intervals against nodes by a few ulps, so that rounding never
+// culls a node holding a hit
+#define HARMONY_BVH_ROBUST_SCALE (1.0f + 8.0f * FLT_EPSILON)
+
+typedef struct HarmonyBvhBuild {
+    HarmonyBvhNode *nodes;
+    u32 *primitives;
+    Vec3 *mins;
+    Vec3 *maxs;
+    Vec3 *centroids;
+} HarmonyBvhBuild;
+
+typedef struct HarmonyBvhTask {
+    u32 node;
+    u32 begin;
+    u32 end;
+    u32 depth;
+    u32 next;
+} HarmonyBvhTask;
+
+static f32 harmony_bvh_area(Vec3 min, Vec3 max) {
+    f32 x = max.x - min.x;
+    f32 y = max.y - min.y;
+    f32 z = max.z - min.z;
+    return x * y + y * z + z * x;
+}
+
+static void harmony_bvh_grow(Vec3 *min, Vec3 *max, Vec3 point_min, Vec3 point_max) {
+    min->x = harmony_min(min->x, point_min.x);
+    min->y = harmony_min(min->y, point_min.y);
+    min->z = harmony_min(min->z, point_min.z);
+    max->x = harmony_max(max->x, point_max.x);
+    max->y = harmony_max(max->y, point_max.y);
+    max->z = harmony_max(max->z, point_max.z);
+}
+
+static u32 harmony_bvh_bin(f32 centroid, f32 centroid_min, f32 scale) {
+    u32 bin = (u32)((centroid - centroid_min) * scale);
+    return harmony_min(bin, HARMONY_BVH_BINS - 1u);
+}
+
+/**
+ * Moves the primitive with the nth smallest centroid on an axis to nth, with
+ * smaller ones before it and larger ones after
+ */
+static void harmony_bvh_select(const HarmonyBvhBuild *build, u32 axis, u32 begin, u32 end, u32 nth) {
+    u32 *primitives = build->primitives;
+    while (end - begin > 1) {
+        f32 pivot = ((const f32 *)&build->centroids[primitives[begin + (end - begin) / 2]])[axis];
+        u32 less = begin;
+        u32 i = begin;
+        u32 greater = end;
+        while (i < greater) {
+            f32 key = ((const f32 *)&build->centroids[primitives[i]])[axis];
+            u32 primitive = primitives[i];
+            if (key < pivot) {
+                primitives[i++] = primitives[less];
+                primitives[less++] = primitive;
+            } else if (key > pivot) {
+                primitives[i] = primitives[--greater];
+                primitives[greater] = primitive;
+            } else {
+                ++i;
+            }
+        }
+        if (nth < less)
+            end = less;
+        else if (nth >= greater)
+            begin = greater;
+        else
+            return;
+    }
+}
+
+/**
+ * Bounds a node's primitives, then either leaves it a leaf or partitions
+ * them into two children at middle
+ */
+static bool harmony_bvh_split(const HarmonyBvhBuild *build, u32 node_index, u32 begin, u32 end, u32 depth, u32 *middle) {
+    Vec3 min = {INFINITY, INFINITY, INFINITY};
+    Vec3 max = {-INFINITY, -INFINITY, -INFINITY};
+    Vec3 centroid_min = min;
+    Vec3 centroid_max = max;
+    for (u32 i = begin; i < end; ++i) {
+        u32 primitive = build->primitives[i];
+        harmony_bvh_grow(&min, &max, build->mins[primitive], build->maxs[primitive]);
+        harmony_bvh_grow(&centroid_min, &centroid_max, build->centroids[primitive], build->centroids[primitive]);
+    }
+    HarmonyBvhNode *node = &build->nodes[node_index];
+    *node = (HarmonyBvhNode){min, begin, max, end - begin};
+    u32 count = end - begin;
+    if (count <= 1)
+        return false;
+
+    Vec3 extents = vsub3(centroid_max, centroid_min);
+    u32 axis = extents.x >= extents.y && extents.x >= extents.z ? 0 : extents.y >= extents.z ? 1 : 2;
+    f32 extent = ((const f32 *)&extents)[axis];
+    if (extent > 0.0f && depth < HARMONY_BVH_SAH_DEPTH) {
+        struct {
+            Vec3 min;
+            Vec3 max;
+            u32 count;
+        } bins[HARMONY_BVH_BINS];
+        for (u32 b = 0; b < HARMONY_BVH_BINS; ++b) {
+            bins[b].min = (Vec3){INFINITY, INFINITY, INFINITY};
+            bins[b].max = (Vec3){-INFINITY, -INFINITY, -INFINITY};
+            bins[b].count = 0;
+        }
+        f32 first = ((const f32 *)&centroid_min)[axis];
+        f32 scale = (f32)HARMONY_BVH_BINS / extent;
+        for (u32 i = begin; i < end; ++i) {
+            u32 primitive = build->primitives[i];
+            u32 b = harmony_bvh_bin(((const f32 *)&build->centroids[primitive])[axis], first, scale);
+            harmony_bvh_grow(&bins[b].min, &bins[b].max, build->mins[primitive], build->maxs[primitive]);
+            ++bins[b].count;
+        }
+
+        // the cost of splitting before each bin, sweeping the right sides
+        // then adding the left sides
+        f32 costs[HARMONY_BVH_BINS];
+        Vec3 side_min = bins[HARMONY_BVH_BINS - 1].min;
+        Vec3 side_max = bins[HARMONY_BVH_BINS - 1].max;
+        u32 side_count = bins[HARMONY_BVH_BINS - 1].count;
+        for (u32 b = HARMONY_BVH_BINS - 1; b > 0; --b) {
+            costs[b] = side_count == 0 ? INFINITY : (f32)side_count * harmony_bvh_area(side_min, side_max);
+            harmony_bvh_grow(&side_min, &side_max, bins[b - 1].min, bins[b - 1].max);
+            side_count += bins[b - 1].count;
+        }
+        side_min = bins[0].min;
+        side_max = bins[0].max;
+        side_count = bins[0].count;
+        u32 best = 1;
+        f32 best_cost = INFINITY;
+        for (u32 b = 1; b < HARMONY_BVH_BINS; ++b) {
+            f32 cost = costs[b] + (side_count == 0 ? INFINITY : (f32)side_count * harmony_bvh_area(side_min, side_max));
+            if (cost < best_cost) {
+                best = b;
+                best_cost = cost;
+            }
+            harmony_bvh_grow(&side_min, &side_max, bins[b].min, bins[b].max);
+            side_count += bins[b].count;
+        }
+
+        // a traversal step costs as much as testing one primitive
+        f32 area = harmony_bvh_area(min, max);
+        if (count <= HARMONY_BVH_LEAF_SIZE && (f32)count * area <= area + best_cost)
+            return false;
+        u32 i = begin;
+        u32 j = end;
+        while (i < j) {
+            u32 primitive = build->primitives[i];
+            if (harmony_bvh_bin(((const f32 *)&build->centroids[primitive])[axis], first, scale) < best) {
+                ++i;
+            } else {
+                build->primitives[i] = build->primitives[--j];
+                build->primitives[j] = primitive;
+            }
+        }
+        *middle = i;
+        return true;
+    }
+
+    if (count <= HARMONY_BVH_LEAF_SIZE)
+        return false;
+    *middle = begin + count / 2;
+    harmony_bvh_select(build, axis, begin, end, *middle);
+    return true;
+}
+
+static void harmony_bvh_build_subtree(const HarmonyBvhBuild *build, u32 node, u32 begin, u32 end, u32 depth, u32 *next) {
+    u32 middle;
+    if (!harmony_bvh_split(build, node, begin, end, depth, &middle))
+        return;
+    u32 children = *next;
+    *next += 2;
+    build->nodes[node].first = children;
+    build->nodes[node].count = 0;
+    harmony_bvh_build_subtree(build, children, begin, middle, depth + 1, next);
+    harmony_bvh_build_subtree(build, children + 1, middle, end, depth + 1, next);
+}
+
+typedef struct HarmonyBvhBuildArgs {
+    const HarmonyBvhBuild *build;
+    HarmonyBvhTask *tasks;
+} HarmonyBvhBuildArgs;
+
+static void harmony_bvh_build_tasks(void *data, usize begin, usize end) {
+    HarmonyBvhBuildArgs *args = data;
+    for (usize t = begin; t < end; ++t) {
+        HarmonyBvhTask *task = &args->tasks[t];
+        harmony_bvh_build_subtree(args->build, task->node, task->begin, task->end, task->depth, &task->next);
+    }
+}
+
+HarmonyBvh harmony_bvh_create(const HarmonyAllocator *allocator, const HarmonyAabbStreams *bounds, u32 count) {
+    return harmony_bvh_create_parallel(1, allocator, bounds, count);
+}
+
+HarmonyBvh harmony_bvh_create_parallel(
+    u32 thread_count,
+    const HarmonyAllocator *allocator,
+    const HarmonyAabbStreams *bounds,
+    u32 count
+) {
+    harmony_assert(allocator != NULL);
+    harmony_assert(bounds != NULL);
+    harmony_assert(count > 0 && count <= UINT32_MAX / 2);
+
+    HarmonyBvh bvh = {0};
+    u32 capacity = 2 * count - 1;
+    bvh.allocation_size = capacity * sizeof(HarmonyBvhNode) + count * sizeof(u32);
+    bvh.allocation = harmony_alloc(allocator, bvh.allocation_size);
+    harmony_assert(bvh.allocation != NULL);
+    bvh.nodes = bvh.allocation;
+    bvh.primitives = (u32 *)(bvh.nodes + capacity);
+    bvh.primitive_count = count;
+
+    // the nodes as built, with gaps between subtrees, then the primitives'
+    // boxes and centroids, then two lists of tasks
+    usize scratch_size = capacity * sizeof(HarmonyBvhNode) + 3 * (usize)count * sizeof(Vec3)
+                       + 2 * HARMONY_BVH_TASK_COUNT * sizeof(HarmonyBvhTask);
+    void *scratch = harmony_alloc(allocator, scratch_size);
+    harmony_assert(scratch != NULL);
+    HarmonyBvhBuild build = {.nodes = scratch, .primitives = bvh.primitives};
+    build.mins = (Vec3 *)(build.nodes + capacity);
+    build.maxs = build.mins + count;
+    build.centroids = build.maxs + count;
+    HarmonyBvhTask *tasks = (HarmonyBvhTask *)(build.centroids + count);
+    HarmonyBvhTask *next_tasks = tasks + HARMONY_BVH_TASK_COUNT;
+    for (u32 i = 0; i < count; ++i) {
+        build.mins[i] = (Vec3){bounds->min[0][i], bounds->min[1][i], bounds->min[2][i]};
+        build.maxs[i] = (Vec3){bounds->max[0][i], bounds->max[1][i], bounds->max[2][i]};
+        build.centroids[i] = svmul3(0.5f, vadd3(build.mins[i], build.maxs[i]));
+        build.primitives[i] = i;
+    }
+
+    // splits the top of the tree serially until there are several subtrees
+    // for each thread
+    u32 task_count = 1;
+    tasks[0] = (HarmonyBvhTask){0, 0, count, 0, 0};
+    u32 next = 1;
+    u32 target = harmony_clamp(thread_count, 1u, HARMONY_MAX_THREADS) * 4;
+    bool splitting = true;
+    while (splitting && task_count < target) {
+        splitting = false;
+        u32 next_count = 0;
+        for (u32 t = 0; t < task_count; ++t) {
+            HarmonyBvhTask task = tasks[t];
+            if (task.end - task.begin <= HARMONY_BVH_TASK_SIZE) {
+                next_tasks[next_count++] = task;
+                continue;
+            }
+            u32 middle;
+            if (!harmony_bvh_split(&build, task.node, task.begin, task.end, task.depth, &middle))
+                continue;
+            build.nodes[task.node].first = next;
+            build.nodes[task.node].count = 0;
+            next_tasks[next_count++] = (HarmonyBvhTask){next, task.begin, middle, task.depth + 1, 0};
+            next_tasks[next_count++] = (HarmonyBvhTask){next + 1, middle, task.end, task.depth + 1, 0};
+            next += 2;
+            splitting = true;
+        }
+        HarmonyBvhTask *swap = tasks;
+        tasks = next_tasks;
+        next_tasks = swap;
+        task_count = next_count;
+    }
+
+    // each subtree of n primitives needs at most 2n - 2 nodes below its root
+    for (u32 t = 0; t < task_count; ++t) {
+        tasks[t].next = next;
+        next += 2 * (tasks[t].end - tasks[t].begin) - 2;
+    }
+    HarmonyBvhBuildArgs args = {&build, tasks};
+    harmony_parallel_for(thread_count, task_count, harmony_bvh_build_tasks, &args);
+
+    // renumbers the nodes depth first, closing the gaps, so the tree is the
+    // same for any thread count
+    u32 stack[2 * HARMONY_BVH_STACK_SIZE];
+    u32 top = 0;
+    bvh.nodes[0] = build.nodes[0];
+    bvh.node_count = 1;
+    stack[top++] = 0;
+    while (top > 0) {
+        HarmonyBvhNode *node = &bvh.nodes[stack[--top]];
+        if (node->count > 0)
+            continue;
+        u32 children = bvh.node_count;
+        bvh.node_count += 2;
+        bvh.nodes[children] = build.nodes[node->first];
+        bvh.nodes[children + 1] = build.nodes[node->first + 1];
+        node->first = children;
+        harmony_assert(top + 2 <= 2 * HARMONY_BVH_STACK_SIZE);
+        stack[top++] = children + 1;
+        stack[top++] = children;
+    }
+
+    harmony_free(allocator, scratch, scratch_size);
+    return bvh;
+}
+
+void harmony_bvh_destroy(const HarmonyAllocator *allocator, HarmonyBvh *bvh) {
+    harmony_assert(allocator != NULL);
+    harmony_assert(bvh != NULL);
+    harmony_free(allocator, bvh->allocation, bvh->allocation_size);
+    *bvh = (HarmonyBvh){0};
+}
+
+void harmony_bvh_refit(HarmonyBvh *bvh, const HarmonyAabbStreams *bounds) {
+    harmony_assert(bvh != NULL);
+    harmony_assert(bounds != NULL);
+    for (u32 n = bvh->node_count; n-- > 0;) {
+        HarmonyBvhNode *node = &bvh->nodes[n];
+        Vec3 min = {INFINITY, INFINITY, INFINITY};
+        Vec3 max = {-INFINITY, -INFINITY, -INFINITY};
+        if (node->count > 0) {
+            for (u32 i = node->first; i < node->first + node->count; ++i) {
+                u32 primitive = bvh->primitives[i];
+                harmony_bvh_grow(&min, &max,
+                    (Vec3){bounds->min[0][primitive], bounds->min[1][primitive], bounds->min[2][primitive]},
+                    (Vec3){bounds->max[0][primitive], bounds->max[1][primitive], bounds->max[2][primitive]});
+            }
+        } else {
+            harmony_bvh_grow(&min, &max, bvh->nodes[node->first].min, bvh->nodes[node->first].max);
+            harmony_bvh_grow(&min, &max, bvh->nodes[node->first + 1].min, bvh->nodes[node->first + 1].max);
+        }
+        node->min = min;
+        node->max = max;
+    }
+}
+
+typedef struct HarmonyBvhEntry {
+    u32 node;
+    f32 distance;
+} HarmonyBvhEntry;
+
+typedef struct HarmonyBvhRay {
+    Vec3 origin;
+    Vec3 inverse;
+    // whether each axis's direction is negative, making its maximum bound
+    // the nearer
+    bool negative[3];
+} HarmonyBvhRay;
+
+static HarmonyBvhRay harmony_bvh_ray(Vec3 origin, Vec3 direction) {
+    HarmonyBvhRay ray = {origin, {1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z}, {0}};
+    for (u32 axis = 0; axis < 3; ++axis) {
+        ray.negative[axis] = signbit(((const f32 *)&ray.inverse)[axis]);
+    }
+    return ray;
+}
+
+/**
+ * Intersects a ray with a box's slabs, giving the distances it enters and
+ * leaves, the entry clamped to start at 0.0f
+ *
+ * A ray parallel to a slab has an infinite inverse direction, giving
+ * infinite distances, or NaN when it lies on the slab's plane, which the
+ * comparisons ignore, leaving the slab unbounded
+ */
+static void harmony_bvh_slabs(const HarmonyBvhRay *ray, const f32 *min, const f32 *max, f32 *enter, f32 *leave) {
+    f32 near = 0.0f;
+    f32 far = INFINITY;
+    for (u32 axis = 0; axis < 3; ++axis) {
+        f32 origin = ((const f32 *)&ray->origin)[axis];
+        f32 inverse = ((const f32 *)&ray->inverse)[axis];
+        f32 t0 = ((ray->negative[axis] ? max : min)[axis] - origin) * inverse;
+        f32 t1 = ((ray->negative[axis] ? min : max)[axis] - origin) * inverse;
+        near = t0 > near ? t0 : near;
+        far = t1 < far ? t1 : far;
+    }
+    *enter = near;
+    *leave = far;
+}
+
+static bool harmony_bvh_ray_node(const HarmonyBvhRay *ray, const HarmonyBvhNode *node, f32 limit, f32 *distance) {
+    f32 leave;
+    harmony_bvh_slabs(ray, (const f32 *)&node->min, (const f32 *)&node->max, distance, &leave);
+    return *distance <= harmony_min(leave, limit) * HARMONY_BVH_ROBUST_SCALE;
+}
+
+/**
+ * Pushes the children of an interior node a ray hits, the nearer last so it
+ * is visited first
+ */
+static u32 harmony_bvh_push_children(
+    const HarmonyBvh *bvh,
+    const HarmonyBvhNode *node,
+    const HarmonyBvhRay *ray,
+    f32 limit,
+    HarmonyBvhEntry *stack,
+    u32 top
+) {
+    f32 distances[2];
+    bool hits[2] = {
+        harmony_bvh_ray_node(ray, &bvh->nodes[node->first], limit, &distances[0]),
+        harmony_bvh_ray_node(ray, &bvh->nodes[node->first + 1], limit, &distances[1]),
+    };
+    u32 near = distances[1] < distances[0] ? 1 : 0;
+    if (hits[1 - near])
+        stack[top++] = (HarmonyBvhEntry){node->first + 1 - near, distances[1 - near]};
+    if (hits[near])
+        stack[top++] = (HarmonyBvhEntry){node->first + near, distances[near]};
+    harmony_assert(top <= HARMONY_BVH_STACK_SIZE);
+    return top;
+}
+
+bool harmony_bvh_ray_triangles(
+    const HarmonyBvh *bvh,
+    const Vec3 *vertices,
+    const u32 *indices,
+    Vec3 origin,
+    Vec3 direction,
+    f32 max_distance,
+    HarmonyRayHit *hit
+) {
+    harmony_assert(bvh != NULL);
+    harmony_assert(vertices != NULL);
+    harmony_assert(indices != NULL);
+    harmony_assert(hit != NULL);
+    HarmonyBvhRay ray = harmony_bvh_ray(origin, direction);
+    HarmonyRayHit best = {max_distance, 0.0f, 0.0f, UINT32_MAX};
+    HarmonyBvhEntry stack[HARMONY_BVH_STACK_SIZE];
+    u32 top = 0;
+    f32 distance;
+    if (harmony_bvh_ray_node(&ray, &bvh->nodes[0], max_distance, &distance))
+        stack[top++] = (HarmonyBvhEntry){0, distance};
+    while (top > 0) {
+        HarmonyBvhEntry entry = stack[--top];
+        if (entry.distance > best.distance * HARMONY_BVH_ROBUST_SCALE)
+            continue;
+        const HarmonyBvhNode *node = &bvh->nodes[entry.node];
+        if (node->count == 0) {
+            top = harmony_bvh_push_children(bvh, node, &ray, best.distance, stack, top);
+            continue;
+        }
+        for (u32 i = node->first; i < node->first + node->count; ++i) {
+            HarmonyRayHit candidate = {.index = bvh->primitives[i]};
+            const u32 *triangle = indices + 3 * (usize)candidate.index;
+            if (harmony_ray_triangle(origin, direction,
+                    vertices[triangle[0]], vertices[triangle[1]], vertices[triangle[2]], best.distance, &candidate)
+                && (candidate.distance < best.distance || candidate.index < best.index))
+                best = candidate;
+        }
+    }
+    if (best.index == UINT32_MAX)
+        return false;
+    *hit = best;
+    return true;
+}
+
+bool harmony_bvh_ray_triangles_any(
+    const HarmonyBvh *bvh,
+    const Vec3 *vertices,
+    const u32 *indices,
+    Vec3 origin,
+    Vec3 direction,
+    f32 max_distance
+) {
+    harmony_assert(bvh != NULL);
+    harmony_assert(vertices != NULL);
+    harmony_assert(indices != NULL);
+    HarmonyBvhRay ray = harmony_bvh_ray(origin, direction);
+    HarmonyBvhEntry stack[HARMONY_BVH_STACK_SIZE];
+    u32 top = 0;
+    f32 distance;
+    if (harmony_bvh_ray_node(&ray, &bvh->nodes[0], max_distance, &distance))
+        stack[top++] = (HarmonyBvhEntry){0, distance};
+    while (top > 0) {
+        const HarmonyBvhNode *node = &bvh->nodes[stack[--top].node];
+        if (node->count == 0) {
+            top = harmony_bvh_push_children(bvh, node, &ray, max_distance, stack, top);
+            continue;
+        }
+        for (u32 i = node->first; i < node->first + node->count; ++i) {
+            HarmonyRayHit candidate;
+            const u32 *triangle = indices + 3 * (usize)bvh->primitives[i];
+            if (harmony_ray_triangle(origin, direction,
+                    vertices[triangle[0]], vertices[triangle[1]], vertices[triangle[2]], max_distance, &candidate))
+                return true;
+        }
+    }
+    return false;
+}
+
+bool harmony_bvh_ray_aabbs(
+    const HarmonyBvh *bvh,
+    const HarmonyAabbStreams *bounds,
+    Vec3 origin,
+    Vec3 direction,
+    f32 max_distance,
+    HarmonyRayHit *hit
+) {
+    harmony_assert(bvh != NULL);
+    harmony_assert(bounds != NULL);
+    harmony_assert(hit != NULL);
+    HarmonyBvhRay ray = harmony_bvh_ray(origin, direction);
+    HarmonyRayHit best = {max_distance, 0.0f, 0.0f, UINT32_MAX};
+    HarmonyBvhEntry stack[HARMONY_BVH_STACK_SIZE];
+    u32 top = 0;
+    f32 distance;
+    if (harmony_bvh_ray_node(&ray, &bvh->nodes[0], max_distance, &distance))
+        stack[top++] = (HarmonyBvhEntry){0, distance};
+    while (top > 0) {
+        HarmonyBvhEntry entry = stack[--top];
+        if (entry.distance > best.distance * HARMONY_BVH_ROBUST_SCALE)
+            continue;
+        const HarmonyBvhNode *node = &bvh->nodes[entry.node];
+        if (node->count == 0) {
+            top = harmony_bvh_push_children(bvh, node, &ray, best.distance, stack, top);
+            continue;
+        }
+        for (u32 i = node->first; i < node->first + node->count; ++i) {
+            u32 primitive = bvh->primitives[i];
+            f32 min[3] = {bounds->min[0][primitive], bounds->min[1][primitive], bounds->min[2][primitive]};
+            f32 max[3] = {bounds->max[0][primitive], bounds->max[1][primitive], bounds->max[2][primitive]};
+            f32 leave;
+            harmony_bvh_slabs(&ray, min, max, &distance, &leave);
+            if (distance <= harmony_min(leave, best.distance)
+                && (distance < best.distance || primitive < best.index))
+                best = (HarmonyRayHit){distance, 0.0f, 0.0f, primitive};
+        }
+    }
+    if (best.index == UINT32_MAX)
+        return false;
+    *hit = best;
+    return true;
+}
+
+u32 harmony_bvh_overlap(
+    const HarmonyBvh *bvh,
+    const HarmonyAabbStreams *bounds,
+    Vec3 min,
+    Vec3 max,
+    u32 *dst,
+    u32 capacity
+) {
+    harmony_assert(bvh != NULL);
+    harmony_assert(bounds != NULL);
+    harmony_assert(dst != NULL || capacity == 0);
+    u32 stack[HARMONY_BVH_STACK_SIZE];
+    u32 top = 0;
+    u32 found = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        const HarmonyBvhNode *node = &bvh->nodes[stack[--top]];
+        if (node->min.x > max.x || node->min.y > max.y || node->min.z > max.z
+         || node->max.x < min.x || node->max.y < min.y || node->max.z < min.z)
+            continue;
+        if (node->count == 0) {
+            harmony_assert(top + 2 <= HARMONY_BVH_STACK_SIZE);
+            stack[top++] = node->first + 1;
+            stack[top++] = node->first;
+            continue;
+        }
+        for (u32 i = node->first; i < node->first + node->count; ++i) {
+            u32 primitive = bvh->primitives[i];
+            if (bounds->min[0][primitive] > max.x || bounds->min[1][primitive] > max.y || bounds->min[2][primitive] > max.z
+             || bounds->max[0][primitive] < min.x || bounds->max[1][primitive] < min.y || bounds->max[2][primitive] < min.z)
+                continue;
+            if (found < capacity)
+                dst[found] = primitive;
+            ++found;
+        }
+    }
+    return found;
+}
+
+static void harmony_ray_packets_scalar(
+    const HarmonyRayHitStreams *hits,
+    const HarmonyRayStreams *rays,
+    usize count,
+    const f32 *const *primitives,
+    usize primitive_count,
+    HarmonyRayTest test
+) {
+    for (usize i = 0; i < count; ++i) {
+        Vec3 origin = {rays->origin[0][i], rays->origin[1][i], rays->origin[2][i]};
+        Vec3 direction = {rays->direction[0][i], rays->direction[1][i], rays->direction[2][i]};
+        HarmonyBvhRay ray = harmony_bvh_ray(origin, direction);
+        HarmonyRayHit best = {hits->distance[i], hits->u[i], hits->v[i], hits->index[i]};
+        for (usize p = 0; p < primitive_count; ++p) {
+            HarmonyRayHit candidate = {.index = (u32)p};
+            bool hit;
+            if (test == HARMONY_RAY_AABB) {
+                f32 min[3] = {primitives[0][p], primitives[1][p], primitives[2][p]};
+                f32 max[3] = {primitives[3][p], primitives[4][p], primitives[5][p]};
+                f32 leave;
+                harmony_bvh_slabs(&ray, min, max, &candidate.distance, &leave);
+                hit = candidate.distance <= leave;
+            } else {
+                Vec3 a = {primitives[0][p], primitives[1][p], primitives[2][p]};
+                Vec3 b = {primitives[3][p], primitives[4][p], primitives[5][p]};
+                Vec3 c = {primitives[6][p], primitives[7][p], primitives[8][p]};
+                hit = test == HARMONY_RAY_TRIANGLE
+                    ? harmony_ray_triangle(origin, direction, a, b, c, best.distance, &candidate)
+                    : harmony_ray_triangle_watertight(origin, direction, a, b, c, best.distance, &candidate);
+            }
+            if (hit && candidate.distance < best.distance)
+                best = candidate;
+        }
+        hits->distance[i] = best.distance;
+        hits->u[i] = best.u;
+        hits->v[i] = best.v;
+        hits->index[i] = best.index;
+    }
+}
+
+#ifdef HARMONY_X86_KERNELS
+
+typedef struct HarmonyRayPacketAvx2 {
+    __m256 origin[3];
+    __m256 direction[3];
+    __m256 distance;
+    __m256 u;
+    __m256 v;
+    __m256i index;
+} HarmonyRayPacketAvx2;
+
+HARMONY_TARGET_AVX2
+static inline void harmony_ray_packet_update_avx2(HarmonyRayPacketAvx2 *packet, __m256 hit, __m256 distance, __m256 u, __m256 v, usize index) {
+    packet->distance = _mm256_blendv_ps(packet->distance, distance, hit);
+    packet->u = _mm256_blendv_ps(packet->u, u, hit);
+    packet->v = _mm256_blendv_ps(packet->v, v, hit);
+    packet->index = _mm256_castps_si256(_mm256_blendv_ps(
+        _mm256_castsi256_ps(packet->index), _mm256_castsi256_ps(_mm256_set1_epi32((i32)index)), hit));
+}
+
+HARMONY_TARGET_AVX2
+static inline __m256 harmony_ray_dot_avx2(const __m256 *lhs, const __m256 *rhs) {
+    return _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(lhs[0], rhs[0]), _mm256_mul_ps(lhs[1], rhs[1])), _mm256_mul_ps(lhs[2], rhs[2]));
+}
+
+HARMONY_TARGET_AVX2
+static inline void harmony_ray_cross_avx2(__m256 *dst, const __m256 *lhs, const __m256 *rhs) {
+    dst[0] = _mm256_sub_ps(_mm256_mul_ps(lhs[1], rhs[2]), _mm256_mul_ps(lhs[2], rhs[1]));
+    dst[1] = _mm256_sub_ps(_mm256_mul_ps(lhs[2], rhs[0]), _mm256_mul_ps(lhs[0], rhs[2]));
+    dst[2] = _mm256_sub_ps(_mm256_mul_ps(lhs[0], rhs[1]), _mm256_mul_ps(lhs[1], rhs[0]));
+}
+
+HARMONY_TARGET_AVX2
+static void harmony_ray_packet_triangles_avx2(HarmonyRayPacketAvx2 *packet, const f32 *const *primitives, usize count) {
+    __m256 zero = _mm256_setzero_ps();
+    __m256 one = _mm256_set1_ps(1.0f);
+    for (usize p = 0; p < count; ++p) {
+        __m256 a[3], e1[3], e2[3];
+        for (u32 c = 0; c < 3; ++c) {
+            a[c] = _mm256_set1_ps(primitives[c][p]);
+            e1[c] = _mm256_set1_ps(primitives[3 + c][p] - primitives[c][p]);
+            e2[c] = _mm256_set1_ps(primitives[6 + c][p] - primitives[c][p]);
+        }
+        __m256 pv[3], s[3], q[3];
+        harmony_ray_cross_avx2(pv, packet->direction, e2);
+        __m256 det = harmony_ray_dot_avx2(e1, pv);
+        __m256 inv_det = _mm256_div_ps(one, det);
+        for (u32 c = 0; c < 3; ++c) {
+            s[c] = _mm256_sub_ps(packet->origin[c], a[c]);
+        }
+        __m256 u = _mm256_mul_ps(harmony_ray_dot_avx2(s, pv), inv_det);
+        harmony_ray_cross_avx2(q, s, e1);
+        __m256 v = _mm256_mul_ps(harmony_ray_dot_avx2(packet->direction, q), inv_det);
+        __m256 t = _mm256_mul_ps(harmony_ray_dot_avx2(e2, q), inv_det);
+
+        __m256 hit = _mm256_and_ps(_mm256_cmp_ps(det, zero, _CMP_NEQ_OQ), _mm256_cmp_ps(u, zero, _CMP_GE_OQ));
+        hit = _mm256_and_ps(hit, _mm256_cmp_ps(u, one, _CMP_LE_OQ));
+        hit = _mm256_and_ps(hit, _mm256_cmp_ps(v, zero, _CMP_GE_OQ));
+        hit = _mm256_and_ps(hit, _mm256_cmp_ps(_mm256_add_ps(u, v), one, _CMP_LE_OQ));
+        hit = _mm256_and_ps(hit, _mm256_cmp_ps(t, zero, _CMP_GE_OQ));
+        hit = _mm256_and_ps(hit, _mm256_cmp_ps(t, packet->distance, _CMP_LT_OQ));
+        if (_mm256_movemask_ps(hit) != 0)
+            harmony_ray_packet_update_avx2(packet, hit, t, u, v, p);
+    }
+}
+
+/**
+ * Permutes each lane's axes so the axis its ray mostly follows is z
+ */
+HARMONY_TARGET_AVX2
+static inline void harmony_ray_permute_avx2(__m256 *dst, const __m256 *src, __m256 kz_x, __m256 kz_y, __m256 swap) {
+    __m256 x = _mm256_blendv_ps(_mm256_blendv_ps(src[0], src[2], kz_y), src[1], kz_x);
+    __m256 y = _mm256_blendv_ps(_mm256_blendv_ps(src[1], src[0], kz_y), src[2], kz_x);
+    dst[0] = _mm256_blendv_ps(x, y, swap);
+    dst[1] = _mm256_blendv_ps(y, x, swap);
+    dst[2] = _mm256_blendv_ps(_mm256_blendv_ps(src[2], src[1], kz_y), src[0], kz_x);
+}
+
+HARMONY_TARGET_AVX2
+static void harmony_ray_packet_watertight_avx2(HarmonyRayPacketAvx2 *packet, const f32 *const *primitives, usize count) {
+    __m256 zero = _mm256_setzero_ps();
+    __m256 one = _mm256_set1_ps(1.0f);
+    __m256 abs_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    __m256 abs_x = _mm256_and_ps(packet->direction[0], abs_mask);
+    __m256 abs_y = _mm256_and_ps(packet->direction[1], abs_mask);
+    __m256 abs_z = _mm256_and_ps(packet->direction[2], abs_mask);
+    __m256 kz_x = _mm256_and_ps(_mm256_cmp_ps(abs_x, abs_y, _CMP_GE_OQ), _mm256_cmp_ps(abs_x, abs_z, _CMP_GE_OQ));
+    __m256 kz_y = _mm256_andnot_ps(kz_x, _mm256_cmp_ps(abs_y, abs_z, _CMP_GE_OQ));
+    __m256 no_swap = _mm256_setzero_ps();
+    __m256 d[3];
+    harmony_ray_permute_avx2(d, packet->direction, kz_x, kz_y, no_swap);
+    __m256 swap = _mm256_cmp_ps(d[2], zero, _CMP_LT_OQ);
+    harmony_ray_permute_avx2(d, packet->direction, kz_x, kz_y, swap);
+    __m256 sx = _mm256_div_ps(d[0], d[2]);
+    __m256 sy = _mm256_div_ps(d[1], d[2]);
+    __m256 sz = _mm256_div_ps(one, d[2]);
+
+    for (usize p = 0; p < count; ++p) {
+        __m256 vertices[3][3];
+        __m256 xs[3], ys[3];
+        for (u32 vertex = 0; vertex < 3; ++vertex) {
+            __m256 relative[3];
+            for (u32 c = 0; c < 3; ++c) {
+                relative[c] = _mm256_sub_ps(_mm256_set1_ps(primitives[3 * vertex + c][p]), packet->origin[c]);
+            }
+            harmony_ray_permute_avx2(vertices[vertex], relative, kz_x, kz_y, swap);
+            xs[vertex] = _mm256_sub_ps(vertices[vertex][0], _mm256_mul_ps(sx, vertices[vertex][2]));
+            ys[vertex] = _mm256_sub_ps(vertices[vertex][1], _mm256_mul_ps(sy, vertices[vertex][2]));
+        }
+        __m256 u = _mm256_sub_ps(_mm256_mul_ps(xs[2], ys[1]), _mm256_mul_ps(ys[2], xs[1]));
+        __m256 v = _mm256_sub_ps(_mm256_mul_ps(xs[0], ys[2]), _mm256_mul_ps(ys[0], xs[2]));
+        __m256 w = _mm256_sub_ps(_mm256_mul_ps(xs[1], ys[0]), _mm256_mul_ps(ys[1], xs[0]));
+        __m256 exact = _mm256_or_ps(_mm256_or_ps(
+            _mm256_cmp_ps(u, zero, _CMP_EQ_OQ), _mm256_cmp_ps(v, zero, _CMP_EQ_OQ)), _mm256_cmp_ps(w, zero, _CMP_EQ_OQ));
+        u32 exact_lanes = (u32)_mm256_movemask_ps(exact);
+        if (exact_lanes != 0) {
+            // recomputes the lanes where an edge passes through the ray in
+            // double precision
+            f32 lanes[9][8];
+            for (u32 vertex = 0; vertex < 3; ++vertex) {
+                _mm256_storeu_ps(lanes[2 * vertex], xs[vertex]);
+                _mm256_storeu_ps(lanes[2 * vertex + 1], ys[vertex]);
+            }
+            _mm256_storeu_ps(lanes[6], u);
+            _mm256_storeu_ps(lanes[7], v);
+            _mm256_storeu_ps(lanes[8], w);
+            for (u32 lane = 0; lane < 8; ++lane) {
+                if ((exact_lanes >> lane & 1) == 0)
+                    continue;
+                f64 ax = lanes[0][lane], ay = lanes[1][lane];
+                f64 bx = lanes[2][lane], by = lanes[3][lane];
+                f64 cx = lanes[4][lane], cy = lanes[5][lane];
+                lanes[6][lane] = (f32)(cx * by - cy * bx);
+                lanes[7][lane] = (f32)(ax * cy - ay * cx);
+                lanes[8][lane] = (f32)(bx * ay - by * ax);
+            }
+            u = _mm256_loadu_ps(lanes[6]);
+            v = _mm256_loadu_ps(lanes[7]);
+            w = _mm256_loadu_ps(lanes[8]);
+        }
+        __m256 negative = _mm256_or_ps(_mm256_or_ps(
+            _mm256_cmp_ps(u, zero, _CMP_LT_OQ), _mm256_cmp_ps(v, zero, _CMP_LT_OQ)), _mm256_cmp_ps(w, zero, _CMP_LT_OQ));
+        __m256 positive = _mm256_or_ps(_mm256_or_ps(
+            _mm256_cmp_ps(u, zero, _CMP_GT_OQ), _mm256_cmp_ps(v, zero, _CMP_GT_OQ)), _mm256_cmp_ps(w, zero, _CMP_GT_OQ));
+        __m256 det = _mm256_add_ps(_mm256_add_ps(u, v), w);
+        __m256 inv_det = _mm256_div_ps(one, det);
+        __m256 t = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(
+            _mm256_mul_ps(u, _mm256_mul_ps(sz, vertices[0][2])),
+            _mm256_mul_ps(v, _mm256_mul_ps(sz, vertices[1][2]))),
+            _mm256_mul_ps(w, _mm256_mul_ps(sz, vertices[2][2]))), inv_det);
+
+        __m256 hit = _mm256_andnot_ps(_mm256_and_ps(negative, positive), _mm256_cmp_ps(det, zero, _CMP_NEQ_OQ));
+        hit = _mm256_and_ps(hit, _mm256_cmp_ps(t, zero, _CMP_GE_OQ));
+        hit = _mm256_and_ps(hit, _mm256_cmp_ps(t, packet->distance, _CMP_LT_OQ));
+        if (_mm256_movemask_ps(hit) != 0)
+            harmony_ray_packet_update_avx2(packet, hit, t, _mm256_mul_ps(v, inv_det), _mm256_mul_ps(w, inv_det), p);
+    }
+}
+
+HARMONY_TARGET_AVX2
+static void harmony_ray_packet_aabbs_avx2(HarmonyRayPacketAvx2 *packet, const f32 *const *primitives, usize count) {
+    __m256 zero = _mm256_setzero_ps();
+    __m256 inverse[3];
+    for (u32 c = 0; c < 3; ++c) {
+        inverse[c] = _mm256_div_ps(_mm256_set1_ps(1.0f), packet->direction[c]);
+    }
+    for (usize p = 0; p < count; ++p) {
+        __m256 near = zero;
+        __m256 far = _mm256_set1_ps(INFINITY);
+        for (u32 c = 0; c < 3; ++c) {
+            // the sign of the inverse direction picks the nearer bound, and
+            // max and min ignore NaN in their first operand as the scalar
+            // comparisons do
+            __m256 min = _mm256_set1_ps(primitives[c][p]);
+            __m256 max = _mm256_set1_ps(primitives[3 + c][p]);
+            __m256 t0 = _mm256_mul_ps(_mm256_sub_ps(_mm256_blendv_ps(min, max, inverse[c]), packet->origin[c]), inverse[c]);
+            __m256 t1 = _mm256_mul_ps(_mm256_sub_ps(_mm256_blendv_ps(max, min, inverse[c]), packet->origin[c]), inverse[c]);
+            near = _mm256_max_ps(t0, near);
+            far = _mm256_min_ps(t1, far);
+        }
+        __m256 hit = _mm256_and_ps(_mm256_cmp_ps(near, far, _CMP_LE_OQ), _mm256_cmp_ps(near, packet->distance, _CMP_LT_OQ));
+        if (_mm256_movemask_ps(hit) != 0)
+            harmony_ray_packet_update_avx2(packet, hit, near, zero, zero, p);
+    }
+}
+
+HARMONY_TARGET_AVX2
+static void harmony_ray_packets_avx2(
+    const HarmonyRayHitStreams *hits,
+    const HarmonyRayStreams *rays,
+    usize count,
+    const f32 *const *primitives,
+    usize primitive_count,
+    HarmonyRayTest test
+) {
+    usize i = 0;
+    for (; i + 8 <= count; i += 8) {
+        HarmonyRayPacketAvx2 packet;
+        for (u32 c = 0; c < 3; ++c) {
+            packet.origin[c] = _mm256_loadu_ps(rays->origin[c] + i);
+            packet.direction[c] = _mm256_loadu_ps(rays->direction[c] + i);
+        }
+        packet.distance = _mm256_loadu_ps(hits->distance + i);
+        packet.u = _mm256_loadu_ps(hits->u + i);
+        packet.v = _mm256_loadu_ps(hits->v + i);
+        packet.index = _mm256_loadu_si256((const __m256i *)(hits->index + i));
+        switch (test) {
+            case HARMONY_RAY_TRIANGLE: harmony_ray_packet_triangles_avx2(&packet, primitives, primitive_count); break;
+            case HARMONY_RAY_TRIANGLE_WATERTIGHT: harmony_ray_packet_watertight_avx2(&packet, primitives, primitive_count); break;
+            case HARMONY_RAY_AABB: harmony_ray_packet_aabbs_avx2(&packet, primitives, primitive_count); break;
+        }
+        _mm256_storeu_ps(hits->distance + i, packet.distance);
+        _mm256_storeu_ps(hits->u + i, packet.u);
+        _mm256_storeu_ps(hits->v + i, packet.v);
+        _mm256_storeu_si256((__m256i *)(hits->index + i), packet.index);
+    }
+    HarmonyRayHitStreams hit_tail = {hits->distance + i, hits->u + i, hits->v + i, hits->index + i};
+    HarmonyRayStreams ray_tail;
+    for (u32 c = 0; c < 3; ++c) {
+        ray_tail.origin[c] = rays->origin[c] + i;
+        ray_tail.direction[c] = rays->direction[c] + i;
+    }
+    harmony_ray_packets_scalar(&hit_tail, &ray_tail, count - i, primitives, primitive_count, test);
+}
+
+#endif // HARMONY_X86_KERNELS
+
+void harmony_rays_triangles(
+    const HarmonyRayHitStreams *hits,
+    const HarmonyRayStreams *rays,
+    usize ray_count,
+    const HarmonyTriangleStreams *triangles,
+    usize triangle_count
+) {
+    harmony_assert(hits != NULL);
+    harmony_assert(rays != NULL);
+    harmony_assert(triangles != NULL);
+    const f32 *primitives[9] = {
+        triangles->a[0], triangles->a[1], triangles->a[2],
+        triangles->b[0], triangles->b[1], triangles->b[2],
+        triangles->c[0], triangles->c[1], triangles->c[2],
+    };
+    harmony_kernels()->ray_packets(hits, rays, ray_count, primitives, triangle_count, HARMONY_RAY_TRIANGLE);
+}
+
+void harmony_rays_triangles_watertight(
+    const HarmonyRayHitStreams *hits,
+    const HarmonyRayStreams *rays,
+    usize ray_count,
+    const HarmonyTriangleStreams *triangles,
+    usize triangle_count
+) {
+    harmony_assert(hits != NULL);
+    harmony_assert(rays != NULL);
+    harmony_assert(triangles != NULL);
+    const f32 *primitives[9] = {
+        triangles->a[0], triangles->a[1], triangles->a[2],
+        triangles->b[0], triangles->b[1], triangles->b[2],
+        triangles->c[0], triangles->c[1], triangles->c[2],
+    };
+    harmony_kernels()->ray_packets(hits, rays, ray_count, primitives, triangle_count, HARMONY_RAY_TRIANGLE_WATERTIGHT);
+}
+
+void harmony_rays_aabbs(
+    const HarmonyRayHitStreams *hits,
+    const HarmonyRayStreams *rays,
+    usize ray_count,
+    const HarmonyAabbStreams *boxes,
+    usize box_count
+) {
+    harmony_assert(hits != NULL);
+    harmony_assert(rays != NULL);
+    harmony_assert(boxes != NULL);
+    const f32 *primitives[6] = {boxes->min[0], boxes->min[1], boxes->min[2], boxes->max[0], boxes->max[1], boxes->max[2]};
+    harmony_kernels()->ray_packets(hits, rays, ray_count, primitives, box_count, HARMONY_RAY_AABB);
+}
+
+#define HARMONY_HASH_GRID_LIMIT (1 << 20)
+#define HARMONY_HASH_GRID_MASK ((1ull << 21) - 1)
+
+static inline u64 harmony_hash_grid_cell(const HarmonyHashGrid *grid, f32 x, f32 y, f32 z) {
+    f32 inverse = 1.0f / grid->cell_size;
+    f32 position[3] = {x, y, z};
+    u64 cell = 0;
+    for (u32 axis = 0; axis < 3; ++axis) {
+        f32 coordinate = floorf(position[axis] * inverse);
+        coordinate = harmony_clamp(coordinate, -(f32)HARMONY_HASH_GRID_LIMIT, (f32)(HARMONY_HASH_GRID_LIMIT - 1));
+        cell = cell << 21 | (u64)((i32)coordinate + HARMONY_HASH_GRID_LIMIT);
+    }
+    return cell;
+}
+
+static inline u32 harmony_hash_grid_bucket(const HarmonyHashGrid *grid, u64 cell) {
+    // the top bits of the product depend on every coordinate
+    return (u32)((cell * 0x9e3779b97f4a7c15ull) >> (64 - __builtin_ctz(grid->bucket_count)));
+}
+
+HarmonyHashGrid harmony_hash_grid_create(const HarmonyAllocator *allocator, u32 capacity, f32 cell_size) {
+    harmony_assert(allocator != NULL);
+    harmony_assert(cell_size > 0.0f);
+    harmony_assert(capacity <= UINT32_MAX / 4);
+
+    HarmonyHashGrid grid = {.cell_size = cell_size, .capacity = capacity};
+    grid.bucket_count = 16;
+    while (grid.bucket_count < 2 * capacity) {
+        grid.bucket_count *= 2;
+    }
+    grid.allocation_size = (usize)capacity * (sizeof(u64) + 5 * sizeof(u32))
+                         + ((usize)grid.bucket_count + 1) * sizeof(u32);
+    grid.allocation = harmony_alloc(allocator, grid.allocation_size);
+    harmony_assert(grid.allocation != NULL);
+    grid.cells = grid.allocation;
+    grid.positions[0] = (f32 *)(grid.cells + capacity);
+    grid.positions[1] = grid.positions[0] + capacity;
+    grid.positions[2] = grid.positions[1] + capacity;
+    grid.entries = (u32 *)(grid.positions[2] + capacity);
+    grid.buckets = grid.entries + capacity;
+    grid.bucket_starts = grid.buckets + capacity;
+    memset(grid.bucket_starts, 0, ((usize)grid.bucket_count + 1) * sizeof(u32));
+    return grid;
+}
+
+void harmony_hash_grid_destroy(const HarmonyAllocator *allocator, HarmonyHashGrid *grid) {
+    harmony_assert(allocator != NULL);
+    harmony_assert(grid != NULL);
+    harmony_free(allocator, grid->allocation, grid->allocation_size);
+    *grid = (HarmonyHashGrid){0};
+}
+
+void harmony_hash_grid_build(HarmonyHashGrid *grid, const HarmonyPointStreams *points, u32 count) {
+    harmony_assert(grid != NULL);
+    harmony_assert(points != NULL);
+    harmony_assert(count <= grid->capacity);
+    grid->count = count;
+
+    // counts each bucket's points one slot ahead, so the prefix sum gives
+    // where each bucket begins
+    u32 *starts = grid->bucket_starts;
+    memset(starts, 0, ((usize)grid->bucket_count + 1) * sizeof(u32));
+    for (u32 i = 0; i < count; ++i) {
+        u64 cell = harmony_hash_grid_cell(grid, points->position[0][i], points->position[1][i], points->position[2][i]);
+        grid->buckets[i] = harmony_hash_grid_bucket(grid, cell);
+        ++starts[grid->buckets[i] + 1];
+    }
+    for (u32 b = 0; b < grid->bucket_count; ++b) {
+        starts[b + 1] += starts[b];
+    }
+
+    // scatters each point to the next slot in its bucket, which moves each
+    // start to the next bucket's, then shifts them back
+    for (u32 i = 0; i < count; ++i) {
+        u32 slot = starts[grid->buckets[i]]++;
+        f32 x = points->position[0][i];
+        f32 y = points->position[1][i];
+        f32 z = points->position[2][i];
+        grid->entries[slot] = i;
+        grid->cells[slot] = harmony_hash_grid_cell(grid, x, y, z);
+        grid->positions[0][slot] = x;
+        grid->positions[1][slot] = y;
+        grid->positions[2][slot] = z;
+    }
+    memmove(starts + 1, starts, grid->bucket_count * sizeof(u32));
+    starts[0] = 0;
+}
+
+/**
+ * Finds the points inside a box, and within a distance of a position if
+ * radius is not negative
+ */
+static u32 harmony_hash_grid_query(
+    const HarmonyHashGrid *grid,
+    Vec3 min,
+    Vec3 max,
+    Vec3 center,
+    f32 radius,
+    u32 *dst,
+    u32 capacity
+) {
+    f32 radius_squared = radius * radius;
+    u64 low = harmony_hash_grid_cell(grid, min.x, min.y, min.z);
+    u64 high = harmony_hash_grid_cell(grid, max.x, max.y, max.z);
+    u64 lows[3] = {low >> 42, low >> 21 & HARMONY_HASH_GRID_MASK, low & HARMONY_HASH_GRID_MASK};
+    u64 highs[3] = {high >> 42, high >> 21 & HARMONY_HASH_GRID_MASK, high & HARMONY_HASH_GRID_MASK};
+    f64 cell_count = (f64)(highs[0] - lows[0] + 1) * (f64)(highs[1] - lows[1] + 1) * (f64)(highs[2] - lows[2] + 1);
+    u32 found = 0;
+
+    // a box covering more cells than there are points is faster to search
+    // by testing every point
+    bool every_point = cell_count > (f64)grid->count;
+    for (u64 x = lows[0]; x <= highs[0]; ++x) {
+        for (u64 y = lows[1]; y <= highs[1]; ++y) {
+            for (u64 z = lows[2]; z <= highs[2]; ++z) {
+                u64 cell = x << 42 | y << 21 | z;
+                u32 bucket = harmony_hash_grid_bucket(grid, cell);
+                u32 begin = every_point ? 0 : grid->bucket_starts[bucket];
+                u32 end = every_point ? grid->count : grid->bucket_starts[bucket + 1];
+                for (u32 i = begin; i < end; ++i) {
+                    if (!every_point && grid->cells[i] != cell)
+                        continue;
+                    f32 px = grid->positions[0][i];
+                    f32 py = grid->positions[1][i];
+                    f32 pz = grid->positions[2][i];
+                    if (px < min.x || py < min.y || pz < min.z || px > max.x || py > max.y || pz > max.z)
+                        continue;
+                    if (radius >= 0.0f) {
+                        f32 dx = px - center.x;
+                        f32 dy = py - center.y;
+                        f32 dz = pz - center.z;
+                        if (dx * dx + dy * dy + dz * dz > radius_squared)
+                            continue;
+                    }
+                    if (found < capacity)
+                        dst[found] = grid->entries[i];
+                    ++found;
+                }
+                if (every_point)
+                    return found;
+            }
+        }
+    }
+    return found;
+}
+
+u32 harmony_hash_grid_query_sphere(const HarmonyHashGrid *grid, Vec3 center, f32 radius, u32 *dst, u32 capacity) {
+    harmony_assert(grid != NULL);
+    harmony_assert(dst != NULL || capacity == 0);
+    if (!(radius >= 0.0f))
+        return 0;
+    Vec3 min = {center.x - radius, center.y - radius, center.z - radius};
+    Vec3 max = {center.x + radius, center.y + radius, center.z + radius};
+    return harmony_hash_grid_query(grid, min, max, center, radius, dst, capacity);
+}
+
+u32 harmony_hash_grid_query_aabb(const HarmonyHashGrid *grid, Vec3 min, Vec3 max, u32 *dst, u32 capacity) {
+    harmony_assert(grid != NULL);
+    harmony_assert(dst != NULL || capacity == 0);
+    if (min.x > max.x || min.y > max.y || min.z > max.z)
+        return 0;
+    return harmony_hash_grid_query(grid, min, max, min, -1.0f, dst, capacity);
+}
+
+/**
+ * Moves an entry index back to the start of its run of entries in the same
+ * cell, so ranges split between cells
+ */
+static inline u32 harmony_hash_grid_run_start(const HarmonyHashGrid *grid, u32 entry) {
+    while (entry > 0 && entry < grid->count && grid->cells[entry - 1] == grid->cells[entry]) {
+        --entry;
+    }
+    return entry;
+}
+
+/**
+ * Finds the pairs found from the entries in [begin, end), writing them from
+ * found onwards
+ */
+static u32 harmony_hash_grid_pairs_range(
+    const HarmonyHashGrid *grid,
+    f32 radius,
+    u32 begin,
+    u32 end,
+    HarmonyPair *dst,
+    u32 found,
+    u32 capacity
+) {
+    f32 radius_squared = radius * radius;
+    const f32 *xs = grid->positions[0];
+    const f32 *ys = grid->positions[1];
+    const f32 *zs = grid->positions[2];
+    for (u32 run = begin; run < end;) {
+        // entries in the same cell are usually together, so share the
+        // neighboring cells' lookups
+        u64 cell = grid->cells[run];
+        u32 run_end = run + 1;
+        while (run_end < end && grid->cells[run_end] == cell) {
+            ++run_end;
+        }
+        // only the cell itself and the 13 neighbors after it are searched,
+        // each pair between neighboring cells being found from the first
+        u64 coordinates[3] = {cell >> 42, cell >> 21 & HARMONY_HASH_GRID_MASK, cell & HARMONY_HASH_GRID_MASK};
+        for (u32 n = 13; n < 27; ++n) {
+            u64 neighbor = 0;
+            bool outside = false;
+            for (u32 axis = 0, offsets = n; axis < 3; ++axis, offsets /= 3) {
+                u64 coordinate = coordinates[axis] + offsets % 3 - 1;
+                outside |= coordinate > HARMONY_HASH_GRID_MASK;
+                neighbor = neighbor << 21 | coordinate;
+            }
+            if (outside)
+                continue;
+            u32 bucket = harmony_hash_grid_bucket(grid, neighbor);
+            u32 first = n == 13 ? harmony_max(grid->bucket_starts[bucket], run + 1) : grid->bucket_starts[bucket];
+            for (u32 j = first; j < grid->bucket_starts[bucket + 1]; ++j) {
+                if (grid->cells[j] != neighbor)
+                    continue;
+                u32 last = n == 13 ? harmony_min(run_end, j) : run_end;
+                for (u32 i = run; i < last; ++i) {
+                    f32 dx = xs[j] - xs[i];
+                    f32 dy = ys[j] - ys[i];
+                    f32 dz = zs[j] - zs[i];
+                    if (dx * dx + dy * dy + dz * dz > radius_squared)
+                        continue;
+                    if (found < capacity) {
+                        u32 a = grid->entries[i];
+                        u32 b = grid->entries[j];
+                        dst[found] = a < b ? (HarmonyPair){a, b} : (HarmonyPair){b, a};
+                    }
+                    ++found;
+                }
+            }
+        }
+        run = run_end;
+    }
+    return found;
+}
+
+u32 harmony_hash_grid_pairs(const HarmonyHashGrid *grid, f32 radius, HarmonyPair *dst, u32 capacity) {
+    harmony_assert(grid != NULL);
+    harmony_assert(radius <= grid->cell_size);
+    harmony_assert(dst != NULL || capacity == 0);
+    return harmony_hash_grid_pairs_range(grid, radius, 0, grid->count, dst, 0, capacity);
+}
+
+typedef struct HarmonyHashGridPairsArgs {
+    const HarmonyHashGrid *grid;
+    f32 radius;
+    HarmonyPair *dst;
+    u32 capacity;
+    u32 task_count;
+    u32 *offsets;
+} HarmonyHashGridPairsArgs;
+
+static void harmony_hash_grid_count_range(void *data, usize begin, usize end) {
+    HarmonyHashGridPairsArgs *args = data;
+    const HarmonyHashGrid *grid = args->grid;
+    for (usize task = begin; task < end; ++task) {
+        u32 first = harmony_hash_grid_run_start(grid, (u32)((u64)grid->count * task / args->task_count));
+        u32 last = harmony_hash_grid_run_start(grid, (u32)((u64)grid->count * (task + 1) / args->task_count));
+        args->offsets[task + 1] = harmony_hash_grid_pairs_range(grid, args->radius, first, last, NULL, 0, 0);
+    }
+}
+
+static void harmony_hash_grid_write_range(void *data, usize begin, usize end) {
+    HarmonyHashGridPairsArgs *args = data;
+    const HarmonyHashGrid *grid = args->grid;
+    for (usize task = begin; task < end; ++task) {
+        if (args->offsets[task] >= args->capacity)
+            continue;
+        u32 first = harmony_hash_grid_run_start(grid, (u32)((u64)grid->count * task / args->task_count));
+        u32 last = harmony_hash_grid_run_start(grid, (u32)((u64)grid->count * (task + 1) / args->task_count));
+        harmony_hash_grid_pairs_range(grid, args->radius, first, last, args->dst, args->offsets[task], args->capacity);
+    }
+}
+
+u32 harmony_hash_grid_pairs_parallel(
+    u32 thread_count,
+    const HarmonyHashGrid *grid,
+    f32 radius,
+    HarmonyPair *dst,
+    u32 capacity
+) {
+    harmony_assert(grid != NULL);
+    harmony_assert(radius <= grid->cell_size);
+    harmony_assert(dst != NULL || capacity == 0);
+    if (thread_count <= 1)
+        return harmony_hash_grid_pairs(grid, radius, dst, capacity);
+
+    u32 offsets[HARMONY_HASH_GRID_TASK_COUNT + 1] = {0};
+    HarmonyHashGridPairsArgs args = {grid, radius, dst, capacity, HARMONY_HASH_GRID_TASK_COUNT, offsets};
+    harmony_parallel_for(thread_count, HARMONY_HASH_GRID_TASK_COUNT, harmony_hash_grid_count_range, &args);
+    for (u32 task = 0; task < HARMONY_HASH_GRID_TASK_COUNT; ++task) {
+        offsets[task + 1] += offsets[task];
+    }
+    harmony_parallel_for(thread_count, HARMONY_HASH_GRID_TASK_COUNT, harmony_hash_grid_write_range, &args);
+    return offsets[HARMONY_HASH_GRID_TASK_COUNT];
+}
+
+#define HARMONY_GJK_MAX_ITERATIONS 32
+#define HARMONY_GJK_TOLERANCE 1.0e-6f
+#define HARMONY_EPA_MAX_VERTICES 64
+#define HARMONY_EPA_MAX_FACES 128
+#define HARMONY_EPA_TOLERANCE 1.0e-4f
+#define HARMONY_CONTACT_FACE_SIZE 16
+#define HARMONY_CONTACT_FACE_SLOP 0.02f
+
+/**
+ * Finds the columns of a normalized quaternion's rotation matrix, the
+ * rotated x, y and z axes
+ */
+static inline void harmony_quat_axes(Vec3 axes[3], Quat q) {
+    axes[0] = (Vec3){1.0f - 2.0f * (q.j * q.j + q.k * q.k), 2.0f * (q.i * q.j + q.r * q.k), 2.0f * (q.i * q.k - q.r * q.j)};
+    axes[1] = (Vec3){2.0f * (q.i * q.j - q.r * q.k), 1.0f - 2.0f * (q.i * q.i + q.k * q.k), 2.0f * (q.j * q.k + q.r * q.i)};
+    axes[2] = (Vec3){2.0f * (q.i * q.k + q.r * q.j), 2.0f * (q.j * q.k - q.r * q.i), 1.0f - 2.0f * (q.i * q.i + q.j * q.j)};
+}
+
+/**
+ * A collider's shape with its rotation as axes, and its radius separate
+ * from the core the support function searches
+ */
+typedef struct HarmonyGjkShape {
+    const HarmonyShape *shape;
+    Vec3 position;
+    Vec3 axes[3];
+    f32 radius;
+} HarmonyGjkShape;
+
+typedef struct HarmonyGjkVertex {
+    Vec3 w;
+    Vec3 a;
+    Vec3 b;
+} HarmonyGjkVertex;
+
+typedef struct HarmonyGjkSimplex {
+    HarmonyGjkVertex vertices[4];
+    f32 weights[4];
+    u32 count;
+} HarmonyGjkSimplex;
+
+static HarmonyGjkShape harmony_gjk_shape(const HarmonyCollider *collider) {
+    harmony_assert(collider != NULL);
+    harmony_assert(collider->shape != NULL);
+    const HarmonyShape *shape = collider->shape;
+    HarmonyGjkShape s = {
+        .shape = shape,
+        .position = collider->position,
+        .radius = shape->type == HARMONY_SHAPE_SPHERE || shape->type == HARMONY_SHAPE_CAPSULE ? shape->radius : 0.0f,
+    };
+    harmony_quat_axes(s.axes, collider->rotation);
+    harmony_assert(shape->type != HARMONY_SHAPE_HULL || (shape->vertices != NULL && shape->vertex_count > 0));
+    return s;
+}
+
+static inline Vec3 harmony_gjk_world(const HarmonyGjkShape *s, Vec3 local) {
+    return vadd3(s->position, vadd3(vadd3(svmul3(local.x, s->axes[0]), svmul3(local.y, s->axes[1])), svmul3(local.z, s->axes[2])));
+}
+
+static inline Vec3 harmony_gjk_local(const HarmonyGjkShape *s, Vec3 direction) {
+    return (Vec3){vdot3(direction, s->axes[0]), vdot3(direction, s->axes[1]), vdot3(direction, s->axes[2])};
+}
+
+/**
+ * Counts the vertices of a shape's core, a point for spheres and a segment
+ * for capsules
+ */
+static inline u32 harmony_gjk_core_count(const HarmonyShape *shape) {
+    switch (shape->type) {
+        case HARMONY_SHAPE_SPHERE: return 1;
+        case HARMONY_SHAPE_CAPSULE: return 2;
+        case HARMONY_SHAPE_BOX: return 8;
+        case HARMONY_SHAPE_HULL: return shape->vertex_count;
+    }
+    return 0;
+}
+
+static inline Vec3 harmony_gjk_core_vertex(const HarmonyShape *shape, u32 index) {
+    switch (shape->type) {
+        case HARMONY_SHAPE_SPHERE: return (Vec3){0.0f, 0.0f, 0.0f};
+        case HARMONY_SHAPE_CAPSULE: return (Vec3){0.0f, index == 0 ? -shape->half_height : shape->half_height, 0.0f};
+        case HARMONY_SHAPE_BOX: return (Vec3){
+            index & 1 ? shape->half_extents.x : -shape->half_extents.x,
+            index & 2 ? shape->half_extents.y : -shape->half_extents.y,
+            index & 4 ? shape->half_extents.z : -shape->half_extents.z,
+        };
+        case HARMONY_SHAPE_HULL: return shape->vertices[index];
+    }
+    return (Vec3){0.0f, 0.0f, 0.0f};
+}
+
+/**
+ * Finds the point of a shape's core furthest along a direction
+ */
+static Vec3 harmony_gjk_support(const HarmonyGjkShape *s, Vec3 direction) {
+    const HarmonyShape *shape = s->shape;
+    Vec3 d = harmony_gjk_local(s, direction);
+    Vec3 local = {0.0f, 0.0f, 0.0f};
+    switch (shape->type) {
+        case HARMONY_SHAPE_SPHERE: break;
+        case HARMONY_SHAPE_CAPSULE: {
+            local.y = d.y >= 0.0f ? shape->half_height : -shape->half_height;
+        } break;
+        case HARMONY_SHAPE_BOX: {
+            local.x = d.x >= 0.0f ? shape->half_extents.x : -shape->half_extents.x;
+            local.y = d.y >= 0.0f ? shape->half_extents.y : -shape->half_extents.y;
+            local.z = d.z >= 0.0f ? shape->half_extents.z : -shape->half_extents.z;
+        } break;
+        case HARMONY_SHAPE_HULL: {
+            f32 best = -INFINITY;
+            for (u32 i = 0; i < shape->vertex_count; ++i) {
+                f32 distance = vdot3(shape->vertices[i], d);
+                if (distance > best) {
+                    best = distance;
+                    local = shape->vertices[i];
+                }
+            }
+        } break;
+    }
+    return harmony_gjk_world(s, local);
+}
+
+static inline HarmonyGjkVertex harmony_gjk_minkowski(const HarmonyGjkShape *a, const HarmonyGjkShape *b, Vec3 direction) {
+    HarmonyGjkVertex vertex;
+    vertex.a = harmony_gjk_support(a, direction);
+    vertex.b = harmony_gjk_support(b, svmul3(-1.0f, direction));
+    vertex.w = vsub3(vertex.a, vertex.b);
+    return vertex;
+}
+
+/**
+ * Keeps the simplex's vertices with the given indices and weights
+ */
+static void harmony_gjk_keep(HarmonyGjkSimplex *s, u32 count, const u32 *indices, const f32 *weights) {
+    HarmonyGjkVertex kept[4];
+    for (u32 i = 0; i < count; ++i) {
+        kept[i] = s->vertices[indices[i]];
+    }
+    for (u32 i = 0; i < count; ++i) {
+        s->vertices[i] = kept[i];
+        s->weights[i] = weights[i];
+    }
+    s->count = count;
+}
+
+static void harmony_gjk_segment(HarmonyGjkSimplex *s) {
+    Vec3 a = s->vertices[0].w;
+    Vec3 edge = vsub3(s->vertices[1].w, a);
+    f32 length_squared = vdot3(edge, edge);
+    f32 t = length_squared > 0.0f ? -vdot3(a, edge) / length_squared : 0.0f;
+    if (!(t > 0.0f)) {
+        harmony_gjk_keep(s, 1, (u32[]){0}, (f32[]){1.0f});
+    } else if (t >= 1.0f) {
+        harmony_gjk_keep(s, 1, (u32[]){1}, (f32[]){1.0f});
+    } else {
+        harmony_gjk_keep(s, 2, (u32[]){0, 1}, (f32[]){1.0f - t, t});
+    }
+}
+
+/**
+ * Finds the closest point of a triangle to the origin by its Voronoi
+ * regions
+ */
+static void harmony_gjk_triangle(HarmonyGjkSimplex *s) {
+    Vec3 a = s->vertices[0].w;
+    Vec3 b = s->vertices[1].w;
+    Vec3 c = s->vertices[2].w;
+    Vec3 ab = vsub3(b, a);
+    Vec3 ac = vsub3(c, a);
+
+    f32 d1 = -vdot3(ab, a);
+    f32 d2 = -vdot3(ac, a);
+    if (d1 <= 0.0f && d2 <= 0.0f) {
+        harmony_gjk_keep(s, 1, (u32[]){0}, (f32[]){1.0f});
+        return;
+    }
+    f32 d3 = -vdot3(ab, b);
+    f32 d4 = -vdot3(ac, b);
+    if (d3 >= 0.0f && d4 <= d3) {
+        harmony_gjk_keep(s, 1, (u32[]){1}, (f32[]){1.0f});
+        return;
+    }
+    f32 vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) {
+        f32 t = d1 / (d1 - d3);
+        harmony_gjk_keep(s, 2, (u32[]){0, 1}, (f32[]){1.0f - t, t});
+        return;
+    }
+    f32 d5 = -vdot3(ab, c);
+    f32 d6 = -vdot3(ac, c);
+    if (d6 >= 0.0f && d5 <= d6) {
+        harmony_gjk_keep(s, 1, (u32[]){2}, (f32[]){1.0f});
+        return;
+    }
+    f32 vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) {
+        f32 t = d2 / (d2 - d6);
+        harmony_gjk_keep(s, 2, (u32[]){0, 2}, (f32[]){1.0f - t, t});
+        return;
+    }
+    f32 va = d3 * d6 - d5 * d4;
+    if (va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f) {
+        f32 t = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+        harmony_gjk_keep(s, 2, (u32[]){1, 2}, (f32[]){1.0f - t, t});
+        return;
+    }
+    f32 total = va + vb + vc;
+    if (!(total > 0.0f)) {
+        // a degenerate triangle, whose closest point is on its longest edge
+        f32 lengths[3] = {vdot3(ab, ab), vdot3(ac, ac), vdot3(vsub3(c, b), vsub3(c, b))};
+        u32 first = lengths[0] >= lengths[1] && lengths[0] >= lengths[2] ? 0 : lengths[1] >= lengths[2] ? 0 : 1;
+        u32 second = lengths[0] >= lengths[1] && lengths[0] >= lengths[2] ? 1 : 2;
+        harmony_gjk_keep(s, 2, (u32[]){first, second}, (f32[]){0.5f, 0.5f});
+        harmony_gjk_segment(s);
+        return;
+    }
+    f32 v = vb / total;
+    f32 w = vc / total;
+    harmony_gjk_keep(s, 3, (u32[]){0, 1, 2}, (f32[]){1.0f - v - w, v, w});
+}
+
+/**
+ * Finds the closest point of a tetrahedron to the origin, keeping all four
+ * vertices if it contains the origin
+ */
+static void harmony_gjk_tetrahedron(HarmonyGjkSimplex *s) {
+    static const u32 faces[4][4] = {{0, 1, 2, 3}, {0, 2, 3, 1}, {0, 3, 1, 2}, {1, 3, 2, 0}};
+    Vec3 a = s->vertices[0].w;
+    Vec3 normal = vcross3(vsub3(s->vertices[1].w, a), vsub3(s->vertices[2].w, a));
+    Vec3 d = vsub3(s->vertices[3].w, a);
+    f32 volume = vdot3(normal, d);
+    bool flat = fabsf(volume) <= FLT_EPSILON * vlen3(normal) * vlen3(d);
+
+    HarmonyGjkSimplex best = {.count = 0};
+    f32 best_distance = INFINITY;
+    bool outside = false;
+    for (u32 f = 0; f < 4; ++f) {
+        Vec3 p = s->vertices[faces[f][0]].w;
+        Vec3 n = vcross3(vsub3(s->vertices[faces[f][1]].w, p), vsub3(s->vertices[faces[f][2]].w, p));
+        f32 origin_side = -vdot3(n, p);
+        f32 opposite_side = vdot3(n, vsub3(s->vertices[faces[f][3]].w, p));
+        if (!flat && origin_side * opposite_side >= 0.0f)
+            continue;
+        outside = true;
+        HarmonyGjkSimplex face = *s;
+        harmony_gjk_keep(&face, 3, faces[f], (f32[]){0.0f, 0.0f, 0.0f});
+        harmony_gjk_triangle(&face);
+        Vec3 closest = {0.0f, 0.0f, 0.0f};
+        for (u32 i = 0; i < face.count; ++i) {
+            closest = vadd3(closest, svmul3(face.weights[i], face.vertices[i].w));
+        }
+        f32 distance = vdot3(closest, closest);
+        if (distance < best_distance) {
+            best_distance = distance;
+            best = face;
+        }
+    }
+    if (outside) {
+        *s = best;
+    } else {
+        s->weights[0] = s->weights[1] = s->weights[2] = s->weights[3] = 0.25f;
+    }
+}
+
+static inline Vec3 harmony_gjk_closest(const HarmonyGjkSimplex *s, u32 point) {
+    Vec3 closest = {0.0f, 0.0f, 0.0f};
+    for (u32 i = 0; i < s->count; ++i) {
+        const HarmonyGjkVertex *vertex = &s->vertices[i];
+        Vec3 p = point == 0 ? vertex->w : point == 1 ? vertex->a : vertex->b;
+        closest = vadd3(closest, svmul3(s->weights[i], p));
+    }
+    return closest;
+}
+
+/**
+ * Runs GJK between two shapes' cores, leaving the simplex nearest the
+ * origin of their Minkowski difference
+ *
+ * Stops early, reporting no overlap, once the cores are known to be further
+ * apart than margin, if margin is not negative
+ */
+static bool harmony_gjk(const HarmonyGjkShape *a, const HarmonyGjkShape *b, HarmonyGjkSimplex *s, f32 margin) {
+    Vec3 v = vsub3(a->position, b->position);
+    if (vdot3(v, v) == 0.0f)
+        v = (Vec3){1.0f, 0.0f, 0.0f};
+    s->count = 0;
+    f32 scale = 0.0f;
+    for (u32 iteration = 0; iteration < HARMONY_GJK_MAX_ITERATIONS; ++iteration) {
+        HarmonyGjkVertex vertex = harmony_gjk_minkowski(a, b, svmul3(-1.0f, v));
+        f32 length_squared = vdot3(v, v);
+        f32 progress = vdot3(v, vertex.w);
+        if (margin >= 0.0f && progress > 0.0f && progress * progress > margin * margin * length_squared)
+            return false;
+        if (s->count > 0 && length_squared - progress <= HARMONY_GJK_TOLERANCE * length_squared)
+            return false;
+        bool repeated = false;
+        for (u32 i = 0; i < s->count; ++i) {
+            repeated |= s->vertices[i].w.x == vertex.w.x && s->vertices[i].w.y == vertex.w.y && s->vertices[i].w.z == vertex.w.z;
+        }
+        if (repeated)
+            return false;
+
+        s->vertices[s->count++] = vertex;
+        scale = harmony_max(scale, vdot3(vertex.w, vertex.w));
+        switch (s->count) {
+            case 1: s->weights[0] = 1.0f; break;
+            case 2: harmony_gjk_segment(s); break;
+            case 3: harmony_gjk_triangle(s); break;
+            case 4: harmony_gjk_tetrahedron(s); break;
+        }
+        if (s->count == 4)
+            return true;
+        v = harmony_gjk_closest(s, 0);
+        if (vdot3(v, v) <= HARMONY_GJK_TOLERANCE * HARMONY_GJK_TOLERANCE * scale)
+            return true;
+    }
+    return false;
+}
+
+typedef struct HarmonyEpaFace {
+    u32 vertices[3];
+    Vec3 normal;
+    f32 distance;
+} HarmonyEpaFace;
+
+static inline HarmonyEpaFace harmony_epa_face(const HarmonyGjkVertex *vertices, u32 a, u32 b, u32 c) {
+    HarmonyEpaFace face = {{a, b, c}, {0.0f, 0.0f, 0.0f}, INFINITY};
+    Vec3 normal = vcross3(vsub3(vertices[b].w, vertices[a].w), vsub3(vertices[c].w, vertices[a].w));
+    f32 length = vlen3(normal);
+    if (length > 0.0f) {
+        face.normal = svmul3(1.0f / length, normal);
+        face.distance = vdot3(face.normal, vertices[a].w);
+    }
+    return face;
+}
+
+/**
+ * Grows a simplex containing the origin into a tetrahedron, returning false
+ * if the Minkowski difference is flat
+ */
+static bool harmony_epa_tetrahedron(const HarmonyGjkShape *a, const HarmonyGjkShape *b, HarmonyGjkSimplex *s) {
+    static const Vec3 axes[6] = {{1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}};
+    f32 scale = 0.0f;
+    for (u32 i = 0; i < s->count; ++i) {
+        scale = harmony_max(scale, vdot3(s->vertices[i].w, s->vertices[i].w));
+    }
+    f32 tolerance = HARMONY_GJK_TOLERANCE * harmony_max(scale, FLT_MIN);
+    if (s->count == 1) {
+        for (u32 i = 0; i < 6 && s->count == 1; ++i) {
+            HarmonyGjkVertex vertex = harmony_gjk_minkowski(a, b, axes[i]);
+            Vec3 offset = vsub3(vertex.w, s->vertices[0].w);
+            if (vdot3(offset, offset) > tolerance)
+                s->vertices[s->count++] = vertex;
+        }
+    }
+    if (s->count == 2) {
+        Vec3 edge = vsub3(s->vertices[1].w, s->vertices[0].w);
+        for (u32 i = 0; i < 6 && s->count == 2; ++i) {
+            Vec3 direction = vcross3(edge, axes[i]);
+            if (vdot3(direction, direction) == 0.0f)
+                continue;
+            HarmonyGjkVertex vertex = harmony_gjk_minkowski(a, b, direction);
+            Vec3 off_line = vcross3(edge, vsub3(vertex.w, s->vertices[0].w));
+            if (vdot3(off_line, off_line) > tolerance * vdot3(edge, edge))
+                s->vertices[s->count++] = vertex;
+        }
+    }
+    if (s->count == 3) {
+        Vec3 normal = vcross3(vsub3(s->vertices[1].w, s->vertices[0].w), vsub3(s->vertices[2].w, s->vertices[0].w));
+        for (u32 i = 0; i < 2 && s->count == 3; ++i) {
+            HarmonyGjkVertex vertex = harmony_gjk_minkowski(a, b, svmul3(i == 0 ? 1.0f : -1.0f, normal));
+            f32 height = vdot3(normal, vsub3(vertex.w, s->vertices[0].w));
+            if (height * height > tolerance * vdot3(normal, normal))
+                s->vertices[s->count++] = vertex;
+        }
+    }
+    return s->count == 4;
+}
+
+/**
+ * Expands the polytope around the origin of the Minkowski difference until
+ * its face nearest the origin is on the boundary
+ */
+static bool harmony_epa(const HarmonyGjkShape *a, const HarmonyGjkShape *b, const HarmonyGjkSimplex *simplex, HarmonySeparation *dst) {
+    HarmonyGjkSimplex tetrahedron = *simplex;
+    if (!harmony_epa_tetrahedron(a, b, &tetrahedron))
+        return false;
+
+    HarmonyGjkVertex vertices[HARMONY_EPA_MAX_VERTICES];
+    HarmonyEpaFace faces[HARMONY_EPA_MAX_FACES];
+    u32 edges[3 * HARMONY_EPA_MAX_FACES][2];
+    u32 vertex_count = 4;
+    u32 face_count = 0;
+    memcpy(vertices, tetrahedron.vertices, sizeof(tetrahedron.vertices));
+
+    // winds each face so its normal points away from the fourth vertex
+    static const u32 initial_faces[4][4] = {{0, 1, 2, 3}, {0, 3, 1, 2}, {0, 2, 3, 1}, {1, 3, 2, 0}};
+    for (u32 f = 0; f < 4; ++f) {
+        const u32 *t = initial_faces[f];
+        Vec3 normal = vcross3(vsub3(vertices[t[1]].w, vertices[t[0]].w), vsub3(vertices[t[2]].w, vertices[t[0]].w));
+        bool inward = vdot3(normal, vsub3(vertices[t[3]].w, vertices[t[0]].w)) > 0.0f;
+        faces[face_count++] = harmony_epa_face(vertices, t[0], inward ? t[2] : t[1], inward ? t[1] : t[2]);
+    }
+
+    u32 closest = 0;
+    for (;;) {
+        closest = 0;
+        for (u32 f = 1; f < face_count; ++f) {
+            if (faces[f].distance < faces[closest].distance)
+                closest = f;
+        }
+        HarmonyEpaFace face = faces[closest];
+        if (face.distance == INFINITY)
+            return false;
+        HarmonyGjkVertex vertex = harmony_gjk_minkowski(a, b, face.normal);
+        f32 distance = vdot3(face.normal, vertex.w);
+        if (distance - face.distance <= HARMONY_EPA_TOLERANCE * harmony_max(distance, 1.0f)
+         || vertex_count == HARMONY_EPA_MAX_VERTICES)
+            break;
+
+        // removes every face the new vertex sees, keeping the edges on the
+        // boundary of the hole, which face the other way in their neighbors
+        u32 new_vertex = vertex_count;
+        vertices[vertex_count++] = vertex;
+        u32 edge_count = 0;
+        for (u32 f = 0; f < face_count;) {
+            if (vdot3(faces[f].normal, vsub3(vertex.w, vertices[faces[f].vertices[0]].w)) <= 0.0f) {
+                ++f;
+                continue;
+            }
+            for (u32 e = 0; e < 3; ++e) {
+                u32 from = faces[f].vertices[e];
+                u32 to = faces[f].vertices[(e + 1) % 3];
+                u32 shared = edge_count;
+                for (u32 i = 0; i < edge_count; ++i) {
+                    if (edges[i][0] == to && edges[i][1] == from)
+                        shared = i;
+                }
+                if (shared < edge_count) {
+                    edges[shared][0] = edges[--edge_count][0];
+                    edges[shared][1] = edges[edge_count][1];
+                } else {
+                    edges[edge_count][0] = from;
+                    edges[edge_count++][1] = to;
+                }
+            }
+            faces[f] = faces[--face_count];
+        }
+        if (face_count + edge_count > HARMONY_EPA_MAX_FACES)
+            return false;
+        for (u32 e = 0; e < edge_count; ++e) {
+            faces[face_count++] = harmony_epa_face(vertices, edges[e][0], edges[e][1], new_vertex);
+        }
+    }
+
+    // the closest face's nearest point to the origin, as barycentric
+    // coordinates for the points on each shape
+    const HarmonyEpaFace *face = &faces[closest];
+    const HarmonyGjkVertex *va = &vertices[face->vertices[0]];
+    const HarmonyGjkVertex *vb = &vertices[face->vertices[1]];
+    const HarmonyGjkVertex *vc = &vertices[face->vertices[2]];
+    Vec3 e0 = vsub3(vb->w, va->w);
+    Vec3 e1 = vsub3(vc->w, va->w);
+    Vec3 p = vsub3(svmul3(face->distance, face->normal), va->w);
+    f32 d00 = vdot3(e0, e0);
+    f32 d01 = vdot3(e0, e1);
+    f32 d11 = vdot3(e1, e1);
+    f32 d20 = vdot3(p, e0);
+    f32 d21 = vdot3(p, e1);
+    f32 denominator = d00 * d11 - d01 * d01;
+    f32 v = denominator != 0.0f ? (d11 * d20 - d01 * d21) / denominator : 0.0f;
+    f32 w = denominator != 0.0f ? (d00 * d21 - d01 * d20) / denominator : 0.0f;
+    f32 u = 1.0f - v - w;
+    dst->normal = face->normal;
+    dst->distance = -face->distance;
+    dst->point_a = vadd3(vadd3(svmul3(u, va->a), svmul3(v, vb->a)), svmul3(w, vc->a));
+    dst->point_b = vadd3(vadd3(svmul3(u, va->b), svmul3(v, vb->b)), svmul3(w, vc->b));
+    return true;
+}
+
+static bool harmony_gjk_epa_shapes(const HarmonyGjkShape *a, const HarmonyGjkShape *b, HarmonySeparation *dst) {
+    HarmonyGjkSimplex s;
+    bool overlap = harmony_gjk(a, b, &s, -1.0f);
+    if (!overlap) {
+        Vec3 v = harmony_gjk_closest(&s, 0);
+        f32 length = vlen3(v);
+        if (length > 0.0f) {
+            dst->normal = svmul3(-1.0f / length, v);
+            dst->distance = length;
+            dst->point_a = harmony_gjk_closest(&s, 1);
+            dst->point_b = harmony_gjk_closest(&s, 2);
+        } else {
+            overlap = true;
+        }
+    }
+    if (overlap && !harmony_epa(a, b, &s, dst)) {
+        // the cores only touch, or their Minkowski difference is flat, so
+        // the normal is across the simplex the origin lies on
+        Vec3 normal = {0.0f, 1.0f, 0.0f};
+        Vec3 offset = vsub3(b->position, a->position);
+        if (s.count == 2 || s.count == 3) {
+            Vec3 edge = vsub3(s.vertices[1].w, s.vertices[0].w);
+            Vec3 across = s.count == 3 ? vsub3(s.vertices[2].w, s.vertices[0].w) : vcross3(edge, offset);
+            if (s.count == 2 && vdot3(across, across) == 0.0f)
+                across = vcross3(edge, fabsf(edge.x) < fabsf(edge.y) ? (Vec3){1.0f, 0.0f, 0.0f} : (Vec3){0.0f, 1.0f, 0.0f});
+            normal = vcross3(edge, across);
+        } else if (vdot3(offset, offset) > 0.0f) {
+            normal = offset;
+        }
+        f32 length = vlen3(normal);
+        normal = length > 0.0f ? svmul3(1.0f / length, normal) : (Vec3){0.0f, 1.0f, 0.0f};
+        if (vdot3(normal, offset) < 0.0f)
+            normal = svmul3(-1.0f, normal);
+        dst->normal = normal;
+        dst->distance = 0.0f;
+        dst->point_a = harmony_gjk_closest(&s, 1);
+        dst->point_b = harmony_gjk_closest(&s, 2);
+    }
+    dst->distance -= a->radius + b->radius;
+    dst->point_a = vadd3(dst->point_a, svmul3(a->radius, dst->normal));
+    dst->point_b = vsub3(dst->point_b, svmul3(b->radius, dst->normal));
+    return dst->distance < 0.0f;
+}
+
+bool harmony_gjk_intersect(const HarmonyCollider *a, const HarmonyCollider *b) {
+    harmony_assert(a != NULL);
+    harmony_assert(b != NULL);
+    HarmonyGjkShape shape_a = harmony_gjk_shape(a);
+    HarmonyGjkShape shape_b = harmony_gjk_shape(b);
+    HarmonyGjkSimplex s;
+    f32 margin = shape_a.radius + shape_b.radius;
+    if (harmony_gjk(&shape_a, &shape_b, &s, margin))
+        return true;
+    // stopping early leaves no simplex
+    Vec3 v = harmony_gjk_closest(&s, 0);
+    return s.count > 0 && vdot3(v, v) < margin * margin;
+}
+
+bool harmony_gjk_epa(const HarmonyCollider *a, const HarmonyCollider *b, HarmonySeparation *dst) {
+    harmony_assert(a != NULL);
+    harmony_assert(b != NULL);
+    harmony_assert(dst != NULL);
+    HarmonyGjkShape shape_a = harmony_gjk_shape(a);
+    HarmonyGjkShape shape_b = harmony_gjk_shape(b);
+    return harmony_gjk_epa_shapes(&shape_a, &shape_b, dst);
+}
+
+/**
+ * Gathers the core vertices of a shape within a slop, relative to its size,
+ * of its furthest along a direction, ordered counterclockwise around it
+ */
+static u32 harmony_contact_face(const HarmonyGjkShape *s, Vec3 direction, Vec3 *dst, f32 *level) {
+    const HarmonyShape *shape = s->shape;
+    Vec3 local = harmony_gjk_local(s, direction);
+    u32 count = harmony_gjk_core_count(shape);
+    f32 max = -INFINITY;
+    f32 extent = 0.0f;
+    for (u32 i = 0; i < count; ++i) {
+        Vec3 vertex = harmony_gjk_core_vertex(shape, i);
+        max = harmony_max(max, vdot3(vertex, local));
+        extent = harmony_max(extent, vdot3(vertex, vertex));
+    }
+    f32 threshold = max - HARMONY_CONTACT_FACE_SLOP * sqrtf(extent);
+    u32 found = 0;
+    for (u32 i = 0; i < count && found < HARMONY_CONTACT_FACE_SIZE; ++i) {
+        Vec3 vertex = harmony_gjk_core_vertex(shape, i);
+        if (vdot3(vertex, local) >= threshold)
+            dst[found++] = harmony_gjk_world(s, vertex);
+    }
+    *level = max + vdot3(s->position, direction);
+    if (found < 3)
+        return found;
+
+    Vec3 center = {0.0f, 0.0f, 0.0f};
+    for (u32 i = 0; i < found; ++i) {
+        center = vadd3(center, dst[i]);
+    }
+    center = svmul3(1.0f / (f32)found, center);
+    Vec3 tangent = vcross3(direction, fabsf(direction.x) < 0.5f ? (Vec3){1.0f, 0.0f, 0.0f} : (Vec3){0.0f, 1.0f, 0.0f});
+    Vec3 bitangent = vcross3(direction, tangent);
+    f32 angles[HARMONY_CONTACT_FACE_SIZE];
+    for (u32 i = 0; i < found; ++i) {
+        Vec3 offset = vsub3(dst[i], center);
+        angles[i] = atan2f(vdot3(offset, bitangent), vdot3(offset, tangent));
+    }
+    for (u32 i = 1; i < found; ++i) {
+        for (u32 j = i; j > 0 && angles[j] < angles[j - 1]; --j) {
+            f32 angle = angles[j];
+            angles[j] = angles[j - 1];
+            angles[j - 1] = angle;
+            Vec3 vertex = dst[j];
+            dst[j] = dst[j - 1];
+            dst[j - 1] = vertex;
+        }
+    }
+    return found;
+}
+
+/**
+ * Clips a polygon, or a segment, against the side planes of a convex
+ * polygon ordered counterclockwise around its normal
+ */
+static u32 harmony_contact_clip(Vec3 *dst, const Vec3 *polygon, u32 count, const Vec3 *reference, u32 reference_count, Vec3 normal) {
+    Vec3 buffers[2][2 * HARMONY_CONTACT_FACE_SIZE + 2 * HARMONY_CONTACT_FACE_SIZE];
+    Vec3 *src = buffers[0];
+    memcpy(src, polygon, count * sizeof(*polygon));
+    for (u32 e = 0; e < reference_count && count > 0; ++e) {
+        Vec3 origin = reference[e];
+        Vec3 side = vcross3(vsub3(reference[(e + 1) % reference_count], origin), normal);
+        Vec3 *out = src == buffers[0] ? buffers[1] : buffers[0];
+        u32 out_count = 0;
+        if (count == 2) {
+            f32 d0 = vdot3(vsub3(src[0], origin), side);
+            f32 d1 = vdot3(vsub3(src[1], origin), side);
+            if (d0 > 0.0f && d1 > 0.0f) {
+                count = 0;
+                break;
+            }
+            out[0] = d0 > 0.0f ? vadd3(src[0], svmul3(d0 / (d0 - d1), vsub3(src[1], src[0]))) : src[0];
+            out[1] = d1 > 0.0f ? vadd3(src[1], svmul3(d1 / (d1 - d0), vsub3(src[0], src[1]))) : src[1];
+            out_count = 2;
+        } else {
+            for (u32 i = 0; i < count; ++i) {
+                Vec3 previous = src[(i + count - 1) % count];
+                Vec3 current = src[i];
+                f32 dp = vdot3(vsub3(previous, origin), side);
+                f32 dc = vdot3(vsub3(current, origin), side);
+                if ((dp > 0.0f) != (dc > 0.0f))
+                    out[out_count++] = vadd3(previous, svmul3(dp / (dp - dc), vsub3(current, previous)));
+                if (dc <= 0.0f)
+                    out[out_count++] = current;
+            }
+        }
+        src = out;
+        count = out_count;
+    }
+    memcpy(dst, src, count * sizeof(*src));
+    return count;
+}
+
+/**
+ * Reduces contact points to the deepest, the furthest from it, and the two
+ * spanning the most area either side of the line between them
+ */
+static u32 harmony_contact_reduce(Vec3 *points, f32 *depths, u32 count, Vec3 normal) {
+    if (count <= HARMONY_MANIFOLD_MAX_POINTS)
+        return count;
+    u32 chosen[4] = {0, 0, 0, 0};
+    for (u32 i = 1; i < count; ++i) {
+        if (depths[i] > depths[chosen[0]])
+            chosen[0] = i;
+    }
+    f32 best = -1.0f;
+    for (u32 i = 0; i < count; ++i) {
+        Vec3 offset = vsub3(points[i], points[chosen[0]]);
+        if (vdot3(offset, offset) > best) {
+            best = vdot3(offset, offset);
+            chosen[1] = i;
+        }
+    }
+    Vec3 line = vsub3(points[chosen[1]], points[chosen[0]]);
+    f32 most = 0.0f;
+    f32 least = 0.0f;
+    chosen[2] = chosen[3] = count;
+    for (u32 i = 0; i < count; ++i) {
+        f32 area = vdot3(vcross3(line, vsub3(points[i], points[chosen[0]])), normal);
+        if (area > most) {
+            most = area;
+            chosen[2] = i;
+        }
+        if (area < least) {
+            least = area;
+            chosen[3] = i;
+        }
+    }
+    Vec3 kept_points[4];
+    f32 kept_depths[4];
+    u32 kept = 0;
+    for (u32 c = 0; c < 4; ++c) {
+        if (chosen[c] == count || (c == 1 && chosen[1] == chosen[0]))
+            continue;
+        kept_points[kept] = points[chosen[c]];
+        kept_depths[kept++] = depths[chosen[c]];
+    }
+    memcpy(points, kept_points, kept * sizeof(*points));
+    memcpy(depths, kept_depths, kept * sizeof(*depths));
+    return kept;
+}
+
+static bool harmony_collide_shapes(const HarmonyGjkShape *a, const HarmonyGjkShape *b, HarmonyManifold *dst) {
+    *dst = (HarmonyManifold){0};
+    HarmonySeparation separation;
+    if (!harmony_gjk_epa_shapes(a, b, &separation))
+        return false;
+    Vec3 normal = separation.normal;
+    dst->normal = normal;
+
+    Vec3 face_a[HARMONY_CONTACT_FACE_SIZE];
+    Vec3 face_b[HARMONY_CONTACT_FACE_SIZE];
+    f32 level_a, level_b;
+    u32 count_a = harmony_contact_face(a, normal, face_a, &level_a);
+    u32 count_b = harmony_contact_face(b, svmul3(-1.0f, normal), face_b, &level_b);
+    level_a += a->radius;
+    level_b = -level_b - b->radius;
+
+    // clips the face with fewer vertices against the other, measuring the
+    // depth of each clipped point from the other's plane
+    bool reference_a = count_a >= count_b;
+    u32 reference_count = reference_a ? count_a : count_b;
+    u32 incident_count = reference_a ? count_b : count_a;
+    Vec3 points[4 * HARMONY_CONTACT_FACE_SIZE];
+    f32 depths[4 * HARMONY_CONTACT_FACE_SIZE];
+    u32 count = 0;
+    if (reference_count >= 3 && incident_count >= 2) {
+        count = harmony_contact_clip(
+            points,
+            reference_a ? face_b : face_a,
+            incident_count,
+            reference_a ? face_a : face_b,
+            reference_count,
+            reference_a ? normal : svmul3(-1.0f, normal));
+        u32 kept = 0;
+        for (u32 i = 0; i < count; ++i) {
+            f32 height = vdot3(points[i], normal);
+            f32 top = reference_a ? level_a : height + a->radius;
+            f32 bottom = reference_a ? height - b->radius : level_b;
+            if (top - bottom < 0.0f)
+                continue;
+            points[kept] = vadd3(points[i], svmul3(0.5f * (top + bottom) - height, normal));
+            depths[kept++] = top - bottom;
+        }
+        count = harmony_contact_reduce(points, depths, kept, normal);
+    }
+    if (count == 0) {
+        points[0] = svmul3(0.5f, vadd3(separation.point_a, separation.point_b));
+        depths[0] = -separation.distance;
+        count = 1;
+    }
+    dst->point_count = count;
+    memcpy(dst->points, points, count * sizeof(*points));
+    memcpy(dst->depths, depths, count * sizeof(*depths));
+    return true;
+}
+
+bool harmony_collide(const HarmonyCollider *a, const HarmonyCollider *b, HarmonyManifold *dst) {
+    harmony_assert(a != NULL);
+    harmony_assert(b != NULL);
+    harmony_assert(dst != NULL);
+    HarmonyGjkShape shape_a = harmony_gjk_shape(a);
+    HarmonyGjkShape shape_b = harmony_gjk_shape(b);
+    return harmony_collide_shapes(&shape_a, &shape_b, dst);
+}
+
+typedef struct HarmonyCollidePairsArgs {
+    HarmonyManifold *dst;
+    const HarmonyCollider *colliders;
+    const HarmonyPair *pairs;
+} HarmonyCollidePairsArgs;
+
+static void harmony_collide_pairs_range(void *data, usize begin, usize end) {
+    HarmonyCollidePairsArgs *args = data;
+    for (usize i = begin; i < end; ++i) {
+        harmony_collide(&args->colliders[args->pairs[i].a], &args->colliders[args->pairs[i].b], &args->dst[i]);
+    }
+}
+
+u32 harmony_collide_pairs(HarmonyManifold *dst, const HarmonyCollider *colliders, const HarmonyPair *pairs, u32 count) {
+    return harmony_collide_pairs_parallel(1, dst, colliders, pairs, count);
+}
+
+u32 harmony_collide_pairs_parallel(
+    u32 thread_count,
+    HarmonyManifold *dst,
+    const HarmonyCollider *colliders,
+    const HarmonyPair *pairs,
+    u32 count
+) {
+    harmony_assert(dst != NULL);
+    harmony_assert(colliders != NULL);
+    harmony_assert(pairs != NULL);
+    HarmonyCollidePairsArgs args = {dst, colliders, pairs};
+    if (thread_count <= 1)
+        harmony_collide_pairs_range(&args, 0, count);
+    else
+        harmony_parallel_for(thread_count, count, harmony_collide_pairs_range, &args);
+    u32 touching = 0;
+    for (u32 i = 0; i < count; ++i) {
+        touching += dst[i].point_count > 0;
+    }
+    return touching;
+}
+
+static void harmony_integrate_bodies_range(
+    const HarmonyBodyStreams *bodies,
+    usize begin,
+    usize end,
+    Vec3 gravity,
+    f32 dt,
+    bool positions
+) {
+    f32 dv[3] = {gravity.x * dt, gravity.y * dt, gravity.z * dt};
+    f32 h = 0.5f * dt;
+    for (usize i = begin; i < end; ++i) {
+        if (!bodies->awake[i] || !(bodies->inverse_mass[i] > 0.0f))
+            continue;
+        if (!positions) {
+            for (u32 c = 0; c < 3; ++c) {
+                bodies->velocity[c][i] += dv[c];
+            }
+            continue;
+        }
+        for (u32 c = 0; c < 3; ++c) {
+            bodies->position[c][i] += bodies->velocity[c][i] * dt;
+        }
+        f32 r = bodies->orientation[0][i];
+        f32 qi = bodies->orientation[1][i];
+        f32 qj = bodies->orientation[2][i];
+        f32 qk = bodies->orientation[3][i];
+        f32 wx = bodies->angular_velocity[0][i];
+        f32 wy = bodies->angular_velocity[1][i];
+        f32 wz = bodies->angular_velocity[2][i];
+        // q += dt / 2 * (0, w) * q
+        f32 nr = r - h * (wx * qi + wy * qj + wz * qk);
+        f32 ni = qi + h * (r * wx + (wy * qk - wz * qj));
+        f32 nj = qj + h * (r * wy + (wz * qi - wx * qk));
+        f32 nk = qk + h * (r * wz + (wx * qj - wy * qi));
+        f32 inv_len = 1.0f / sqrtf(nr * nr + ni * ni + nj * nj + nk * nk);
+        bodies->orientation[0][i] = nr * inv_len;
+        bodies->orientation[1][i] = ni * inv_len;
+        bodies->orientation[2][i] = nj * inv_len;
+        bodies->orientation[3][i] = nk * inv_len;
+    }
+}
+
+static void harmony_integrate_bodies_scalar(
+    const HarmonyBodyStreams *bodies,
+    usize count,
+    Vec3 gravity,
+    f32 dt,
+    bool positions
+) {
+    harmony_integrate_bodies_range(bodies, 0, count, gravity, dt, positions);
+}
+
+#ifdef HARMONY_X86_KERNELS
+
+HARMONY_TARGET_AVX2
+static void harmony_integrate_bodies_avx2(
+    const HarmonyBodyStreams *bodies,
+    usize count,
+    Vec3 gravity,
+    f32 dt,
+    bool positions
+) {
+    __m256 zero = _mm256_setzero_ps();
+    __m256 dv[3] = {
+        _mm256_set1_ps(gravity.x * dt),
+        _mm256_set1_ps(gravity.y * dt),
+        _mm256_set1_ps(gravity.z * dt),
+    };
+    __m256 step = _mm256_set1_ps(dt);
+    __m256 h = _mm256_set1_ps(0.5f * dt);
+    usize i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i awake = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(bodies->awake + i)));
+        __m256 moving = _mm256_and_ps(
+            _mm256_castsi256_ps(_mm256_cmpgt_epi32(awake, _mm256_setzero_si256())),
+            _mm256_cmp_ps(_mm256_loadu_ps(bodies->inverse_mass + i), zero, _CMP_GT_OQ));
+        if (_mm256_movemask_ps(moving) == 0)
+            continue;
+        if (!positions) {
+            for (u32 c = 0; c < 3; ++c) {
+                __m256 v = _mm256_loadu_ps(bodies->velocity[c] + i);
+                _mm256_storeu_ps(bodies->velocity[c] + i, _mm256_blendv_ps(v, _mm256_add_ps(v, dv[c]), moving));
+            }
+            continue;
+        }
+        for (u32 c = 0; c < 3; ++c) {
+            __m256 p = _mm256_loadu_ps(bodies->position[c] + i);
+            __m256 moved = _mm256_add_ps(p, _mm256_mul_ps(_mm256_loadu_ps(bodies->velocity[c] + i), step));
+            _mm256_storeu_ps(bodies->position[c] + i, _mm256_blendv_ps(p, moved, moving));
+        }
+        __m256 r = _mm256_loadu_ps(bodies->orientation[0] + i);
+        __m256 qi = _mm256_loadu_ps(bodies->orientation[1] + i);
+        __m256 qj = _mm256_loadu_ps(bodies->orientation[2] + i);
+        __m256 qk = _mm256_loadu_ps(bodies->orientation[3] + i);
+        __m256 wx = _mm256_loadu_ps(bodies->angular_velocity[0] + i);
+        __m256 wy = _mm256_loadu_ps(bodies->angular_velocity[1] + i);
+        __m256 wz = _mm256_loadu_ps(bodies->angular_velocity[2] + i);
+        __m256 q[4];
+        q[0] = _mm256_sub_ps(r, _mm256_mul_ps(h, _mm256_add_ps(_mm256_add_ps(
+            _mm256_mul_ps(wx, qi), _mm256_mul_ps(wy, qj)), _mm256_mul_ps(wz, qk))));
+        q[1] = _mm256_add_ps(qi, _mm256_mul_ps(h, _mm256_add_ps(
+            _mm256_mul_ps(r, wx), _mm256_sub_ps(_mm256_mul_ps(wy, qk), _mm256_mul_ps(wz, qj)))));
+        q[2] = _mm256_add_ps(qj, _mm256_mul_ps(h, _mm256_add_ps(
+            _mm256_mul_ps(r, wy), _mm256_sub_ps(_mm256_mul_ps(wz, qi), _mm256_mul_ps(wx, qk)))));
+        q[3] = _mm256_add_ps(qk, _mm256_mul_ps(h, _mm256_add_ps(
+            _mm256_mul_ps(r, wz), _mm256_sub_ps(_mm256_mul_ps(wx, qj), _mm256_mul_ps(wy, qi)))));
+        __m256 inv_len = harmony_quat_inv_len_avx2(q[0], q[1], q[2], q[3]);
+        __m256 old[4] = {r, qi, qj, qk};
+        for (u32 c = 0; c < 4; ++c) {
+            _mm256_storeu_ps(bodies->orientation[c] + i, _mm256_blendv_ps(old[c], _mm256_mul_ps(q[c], inv_len), moving));
+        }
+    }
+    harmony_integrate_bodies_range(bodies, i, count, gravity, dt, positions);
+}
+
+#endif // HARMONY_X86_KERNELS
+
+void harmony_bodies_integrate_velocities(const HarmonyBodyStreams *bodies, usize count, Vec3 gravity, f32 dt) {
+    harmony_assert(bodies != NULL);
+    harmony_kernels()->integrate_bodies(bodies, count, gravity, dt, false);
+}
+
+void harmony_bodies_integrate_positions(const HarmonyBodyStreams *bodies, usize count, f32 dt) {
+    harmony_assert(bodies != NULL);
+    harmony_kernels()->integrate_bodies(bodies, count, (Vec3){0.0f, 0.0f, 0.0f}, dt, true);
+}
+
+HarmonyPhysics harmony_physics_create(
+    const HarmonyAllocator *allocator,
+    u32 body_capacity,
+    u32 joint_capacity,
+    u32 contact_capacity
+) {
+    harmony_assert(allocator != NULL);
+    harmony_assert((u64)contact_capacity + joint_capacity <= UINT32_MAX);
+
+    HarmonyPhysics physics = {
+        .gravity = {0.0f, -9.81f, 0.0f},
+        .friction = 0.6f,
+        .iterations = 10,
+        .body_capacity = body_capacity,
+        .joint_capacity = joint_capacity,
+        .contact_capacity = contact_capacity,
+    };
+    usize constraint_capacity = (usize)contact_capacity + joint_capacity;
+    physics.allocation_size = (usize)body_capacity * (sizeof(u64) + sizeof(Mat3) + 19 * sizeof(f32) + sizeof(u32) + sizeof(u8))
+                            + constraint_capacity * (sizeof(HarmonyConstraint) + sizeof(u32))
+                            + (usize)contact_capacity * sizeof(HarmonyCachedContact)
+                            + (usize)joint_capacity * (sizeof(HarmonyJoint) + sizeof(Vec3));
+    physics.allocation = harmony_alloc(allocator, physics.allocation_size);
+    harmony_assert(physics.allocation != NULL);
+
+    // the widest alignments first, so every array stays aligned
+    physics.color_masks = physics.allocation;
+    physics.contact_cache = (HarmonyCachedContact *)(physics.color_masks + body_capacity);
+    physics.constraints = (HarmonyConstraint *)(physics.contact_cache + contact_capacity);
+    physics.inverse_inertia = (Mat3 *)(physics.constraints + constraint_capacity);
+    physics.joints = (HarmonyJoint *)(physics.inverse_inertia + body_capacity);
+    physics.joint_impulses = (Vec3 *)(physics.joints + joint_capacity);
+    f32 *streams = (f32 *)(physics.joint_impulses + joint_capacity);
+    HarmonyBodyStreams *bodies = &physics.bodies;
+    for (u32 c = 0; c < 3; ++c) {
+        bodies->position[c] = streams;
+        streams += body_capacity;
+        bodies->velocity[c] = streams;
+        streams += body_capacity;
+        bodies->angular_velocity[c] = streams;
+        streams += body_capacity;
+        bodies->inverse_inertia[c] = streams;
+        streams += body_capacity;
+    }
+    for (u32 c = 0; c < 4; ++c) {
+        bodies->orientation[c] = streams;
+        streams += body_capacity;
+    }
+    bodies->inverse_mass = streams;
+    bodies->sleep_time = bodies->inverse_mass + body_capacity;
+    physics.island_sleep = bodies->sleep_time + body_capacity;
+    physics.islands = (u32 *)(physics.island_sleep + body_capacity);
+    physics.colors = physics.islands + body_capacity;
+    bodies->awake = (u8 *)(physics.colors + constraint_capacity);
+    return physics;
+}
+
+void harmony_physics_destroy(const HarmonyAllocator *allocator, HarmonyPhysics *physics) {
+    harmony_assert(allocator != NULL);
+    harmony_assert(physics != NULL);
+    harmony_free(allocator, physics->allocation, physics->allocation_size);
+    *physics = (HarmonyPhysics){0};
+}
+
+u32 harmony_physics_add_body(HarmonyPhysics *physics, Vec3 position, Quat orientation, f32 mass, Vec3 inertia) {
+    harmony_assert(physics != NULL);
+    harmony_assert(physics->body_count < physics->body_capacity);
+    harmony_assert(mass >= 0.0f);
+    u32 body = physics->body_count++;
+    HarmonyBodyStreams *bodies = &physics->bodies;
+    f32 p[3] = {position.x, position.y, position.z};
+    f32 q[4] = {orientation.r, orientation.i, orientation.j, orientation.k};
+    f32 moments[3] = {inertia.x, inertia.y, inertia.z};
+    for (u32 c = 0; c < 3; ++c) {
+        bodies->position[c][body] = p[c];
+        bodies->velocity[c][body] = 0.0f;
+        bodies->angular_velocity[c][body] = 0.0f;
+        bodies->inverse_inertia[c][body] = mass > 0.0f && moments[c] > 0.0f ? 1.0f / moments[c] : 0.0f;
+    }
+    for (u32 c = 0; c < 4; ++c) {
+        bodies->orientation[c][body] = q[c];
+    }
+    bodies->inverse_mass[body] = mass > 0.0f ? 1.0f / mass : 0.0f;
+    bodies->sleep_time[body] = 0.0f;
+    bodies->awake[body] = 1;
+    physics->islands[body] = mass > 0.0f ? body : UINT32_MAX;
+    return body;
+}
+
+static inline Vec3 harmony_body_load(f32 *const *streams, u32 body) {
+    return (Vec3){streams[0][body], streams[1][body], streams[2][body]};
+}
+
+static inline void harmony_body_store(f32 *const *streams, u32 body, Vec3 value) {
+    streams[0][body] = value.x;
+    streams[1][body] = value.y;
+    streams[2][body] = value.z;
+}
+
+static inline Quat harmony_body_orientation(const HarmonyBodyStreams *bodies, u32 body) {
+    return (Quat){
+        bodies->orientation[0][body],
+        bodies->orientation[1][body],
+        bodies->orientation[2][body],
+        bodies->orientation[3][body],
+    };
+}
+
+u32 harmony_physics_add_joint(HarmonyPhysics *physics, u32 a, u32 b, Vec3 anchor) {
+    harmony_assert(physics != NULL);
+    harmony_assert(physics->joint_count < physics->joint_capacity);
+    harmony_assert(a < physics->body_count);
+    harmony_assert(b < physics->body_count);
+    harmony_assert(a != b);
+    u32 bodies[2] = {a, b};
+    Vec3 local[2];
+    for (u32 k = 0; k < 2; ++k) {
+        Vec3 axes[3];
+        harmony_quat_axes(axes, harmony_body_orientation(&physics->bodies, bodies[k]));
+        Vec3 offset = vsub3(anchor, harmony_body_load(physics->bodies.position, bodies[k]));
+        local[k] = (Vec3){vdot3(offset, axes[0]), vdot3(offset, axes[1]), vdot3(offset, axes[2])};
+    }
+    u32 joint = physics->joint_count++;
+    physics->joints[joint] = (HarmonyJoint){a, b, local[0], local[1]};
+    physics->joint_impulses[joint] = (Vec3){0.0f, 0.0f, 0.0f};
+    return joint;
+}
+
+void harmony_physics_wake(HarmonyPhysics *physics, u32 body) {
+    harmony_assert(physics != NULL);
+    harmony_assert(body < physics->body_count);
+    u32 island = physics->islands[body];
+    if (island == UINT32_MAX)
+        return;
+    physics->bodies.sleep_time[body] = 0.0f;
+    for (u32 i = island; i < physics->body_count; ++i) {
+        if (physics->islands[i] == island)
+            physics->bodies.awake[i] = 1;
+    }
+}
+
+Vec3 harmony_box_inertia(f32 mass, Vec3 half_extents) {
+    f32 x2 = half_extents.x * half_extents.x;
+    f32 y2 = half_extents.y * half_extents.y;
+    f32 z2 = half_extents.z * half_extents.z;
+    f32 scale = mass / 3.0f;
+    return (Vec3){scale * (y2 + z2), scale * (x2 + z2), scale * (x2 + y2)};
+}
+
+Vec3 harmony_sphere_inertia(f32 mass, f32 radius) {
+    f32 moment = 0.4f * mass * radius * radius;
+    return (Vec3){moment, moment, moment};
+}
+
+// how far a contact point may move in its first body's space and still
+// start from its impulses of the previous step
+#define HARMONY_PHYSICS_CACHE_DISTANCE 0.05f
+// the fraction of the position error corrected each step
+#define HARMONY_PHYSICS_BAUMGARTE 0.2f
+// the penetration allowed to stay, so resting contacts do not jitter
+#define HARMONY_PHYSICS_SLOP 0.005f
+// below these speeds a body counts towards its island sleeping
+#define HARMONY_PHYSICS_SLEEP_LINEAR 0.05f
+#define HARMONY_PHYSICS_SLEEP_ANGULAR 0.05f
+// batches smaller than this are solved without waking the threads
+#define HARMONY_PHYSICS_PARALLEL_MIN 256
+
+static inline Vec3 harmony_mat3_apply(const Mat3 *m, Vec3 v) {
+    return vadd3(vadd3(svmul3(v.x, m->x), svmul3(v.y, m->y)), svmul3(v.z, m->z));
+}
+
+static inline bool harmony_physics_moving(const HarmonyPhysics *physics, u32 body) {
+    return physics->bodies.inverse_mass[body] > 0.0f && physics->bodies.awake[body];
+}
+
+static inline u32 harmony_physics_find(u32 *islands, u32 body) {
+    while (islands[body] != body) {
+        islands[body] = islands[islands[body]];
+        body = islands[body];
+    }
+    return body;
+}
+
+static inline void harmony_physics_union(u32 *islands, u32 a, u32 b) {
+    if (islands[a] == UINT32_MAX || islands[b] == UINT32_MAX)
+        return;
+    a = harmony_physics_find(islands, a);
+    b = harmony_physics_find(islands, b);
+    // the lower index is always the root, so a single forward pass can
+    // flatten every island
+    if (a < b)
+        islands[b] = a;
+    else if (b < a)
+        islands[a] = b;
+}
+
+/**
+ * Groups the bodies into islands through their contacts and joints, then
+ * wakes or sleeps each island as a whole
+ */
+static void harmony_physics_islands(
+    HarmonyPhysics *physics,
+    const HarmonyPair *pairs,
+    const HarmonyManifold *manifolds,
+    u32 pair_count
+) {
+    HarmonyBodyStreams *bodies = &physics->bodies;
+    u32 *islands = physics->islands;
+    for (u32 i = 0; i < physics->body_count; ++i) {
+        islands[i] = bodies->inverse_mass[i] > 0.0f ? i : UINT32_MAX;
+    }
+    for (u32 p = 0; p < pair_count; ++p) {
+        if (manifolds[p].point_count > 0)
+            harmony_physics_union(islands, pairs[p].a, pairs[p].b);
+    }
+    for (u32 j = 0; j < physics->joint_count; ++j) {
+        harmony_physics_union(islands, physics->joints[j].a, physics->joints[j].b);
+    }
+
+    for (u32 i = 0; i < physics->body_count; ++i) {
+        if (islands[i] == UINT32_MAX)
+            continue;
+        islands[i] = islands[islands[i]];
+        if (islands[i] == i)
+            physics->island_sleep[i] = bodies->sleep_time[i];
+        else
+            physics->island_sleep[islands[i]] = harmony_min(physics->island_sleep[islands[i]], bodies->sleep_time[i]);
+    }
+    for (u32 i = 0; i < physics->body_count; ++i) {
+        if (islands[i] == UINT32_MAX)
+            continue;
+        bool awake = physics->island_sleep[islands[i]] < HARMONY_PHYSICS_SLEEP_TIME;
+        bodies->awake[i] = awake;
+        if (!awake) {
+            for (u32 c = 0; c < 3; ++c) {
+                bodies->velocity[c][i] = 0.0f;
+                bodies->angular_velocity[c][i] = 0.0f;
+            }
+        }
+    }
+}
+
+/**
+ * Gives a constraint between two bodies the lowest color neither of their
+ * other constraints has, ignoring static bodies as they are never written
+ */
+static inline u32 harmony_physics_color(HarmonyPhysics *physics, u32 a, u32 b) {
+    const f32 *inverse_mass = physics->bodies.inverse_mass;
+    u64 used = 1ull << (HARMONY_PHYSICS_COLORS - 1);
+    if (inverse_mass[a] > 0.0f)
+        used |= physics->color_masks[a];
+    if (inverse_mass[b] > 0.0f)
+        used |= physics->color_masks[b];
+    u32 color = used == UINT64_MAX ? HARMONY_PHYSICS_COLORS - 1 : (u32)__builtin_ctzll(~used);
+    u64 bit = 1ull << color;
+    if (inverse_mass[a] > 0.0f)
+        physics->color_masks[a] |= bit;
+    if (inverse_mass[b] > 0.0f)
+        physics->color_masks[b] |= bit;
+    return color;
+}
+
+static inline f32 harmony_physics_effective_mass(const HarmonyPhysics *physics, const HarmonyConstraint *constraint, Vec3 direction) {
+    Vec3 ra = vcross3(constraint->offset_a, direction);
+    Vec3 rb = vcross3(constraint->offset_b, direction);
+    f32 k = physics->bodies.inverse_mass[constraint->a] + physics->bodies.inverse_mass[constraint->b]
+          + vdot3(ra, harmony_mat3_apply(&physics->inverse_inertia[constraint->a], ra))
+          + vdot3(rb, harmony_mat3_apply(&physics->inverse_inertia[constraint->b], rb));
+    return k > 0.0f ? 1.0f / k : 0.0f;
+}
+
+static inline Vec3 harmony_physics_local_point(const HarmonyBodyStreams *bodies, u32 body, Vec3 offset) {
+    Vec3 axes[3];
+    harmony_quat_axes(axes, harmony_body_orientation(bodies, body));
+    return (Vec3){vdot3(offset, axes[0]), vdot3(offset, axes[1]), vdot3(offset, axes[2])};
+}
+
+static int harmony_cached_contact_compare(const void *lhs, const void *rhs) {
+    const HarmonyCachedContact *a = lhs;
+    const HarmonyCachedContact *b = rhs;
+    if (a->key != b->key)
+        return a->key < b->key ? -1 : 1;
+    f32 pa[3] = {a->point.x, a->point.y, a->point.z};
+    f32 pb[3] = {b->point.x, b->point.y, b->point.z};
+    for (u32 c = 0; c < 3; ++c) {
+        if (pa[c] != pb[c])
+            return pa[c] < pb[c] ? -1 : 1;
+    }
+    return 0;
+}
+
+/**
+ * Finds the cached contact of the same pair of bodies closest to a point,
+ * or NULL if none are close enough
+ */
+static const HarmonyCachedContact *harmony_physics_cached(const HarmonyPhysics *physics, u64 key, Vec3 point) {
+    const HarmonyCachedContact *cache = physics->contact_cache;
+    u32 low = 0;
+    u32 high = physics->contact_cache_count;
+    while (low < high) {
+        u32 mid = low + (high - low) / 2;
+        if (cache[mid].key < key)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    const HarmonyCachedContact *best = NULL;
+    f32 best_distance = HARMONY_PHYSICS_CACHE_DISTANCE * HARMONY_PHYSICS_CACHE_DISTANCE;
+    for (u32 i = low; i < physics->contact_cache_count && cache[i].key == key; ++i) {
+        Vec3 offset = vsub3(cache[i].point, point);
+        f32 distance = vdot3(offset, offset);
+        if (distance < best_distance) {
+            best = &cache[i];
+            best_distance = distance;
+        }
+    }
+    return best;
+}
+
+static void harmony_physics_contact(
+    const HarmonyPhysics *physics,
+    HarmonyConstraint *dst,
+    u32 a,
+    u32 b,
+    const HarmonyManifold *manifold,
+    u32 point,
+    f32 dt
+) {
+    const HarmonyBodyStreams *bodies = &physics->bodies;
+    Vec3 n = manifold->normal;
+    Vec3 tangent = fabsf(n.x) >= 0.57735f ? (Vec3){n.y, -n.x, 0.0f} : (Vec3){0.0f, n.z, -n.y};
+    tangent = svmul3(1.0f / vlen3(tangent), tangent);
+    *dst = (HarmonyConstraint){
+        .a = a,
+        .b = b,
+        .offset_a = vsub3(manifold->points[point], harmony_body_load(bodies->position, a)),
+        .offset_b = vsub3(manifold->points[point], harmony_body_load(bodies->position, b)),
+        .normal = n,
+        .tangents = {tangent, vcross3(n, tangent)},
+        .bias = HARMONY_PHYSICS_BAUMGARTE / dt * harmony_max(manifold->depths[point] - HARMONY_PHYSICS_SLOP, 0.0f),
+        .joint = UINT32_MAX,
+    };
+    const HarmonyCachedContact *cached = harmony_physics_cached(
+        physics, (u64)a << 32 | b, harmony_physics_local_point(bodies, a, dst->offset_a));
+    if (cached != NULL) {
+        dst->normal_impulse = cached->normal_impulse;
+        dst->tangent_impulse[0] = cached->tangent_impulse[0];
+        dst->tangent_impulse[1] = cached->tangent_impulse[1];
+    }
+    dst->normal_mass = harmony_physics_effective_mass(physics, dst, n);
+    dst->tangent_mass[0] = harmony_physics_effective_mass(physics, dst, dst->tangents[0]);
+    dst->tangent_mass[1] = harmony_physics_effective_mass(physics, dst, dst->tangents[1]);
+}
+
+static void harmony_physics_joint(const HarmonyPhysics *physics, HarmonyConstraint *dst, u32 index, f32 dt) {
+    const HarmonyBodyStreams *bodies = &physics->bodies;
+    const HarmonyJoint *joint = &physics->joints[index];
+    u32 a = joint->a;
+    u32 b = joint->b;
+    Vec3 axes_a[3], axes_b[3];
+    harmony_quat_axes(axes_a, harmony_body_orientation(bodies, a));
+    harmony_quat_axes(axes_b, harmony_body_orientation(bodies, b));
+    Vec3 ra = vadd3(vadd3(svmul3(joint->anchor_a.x, axes_a[0]), svmul3(joint->anchor_a.y, axes_a[1])), svmul3(joint->anchor_a.z, axes_a[2]));
+    Vec3 rb = vadd3(vadd3(svmul3(joint->anchor_b.x, axes_b[0]), svmul3(joint->anchor_b.y, axes_b[1])), svmul3(joint->anchor_b.z, axes_b[2]));
+    Vec3 error = vsub3(
+        vadd3(harmony_body_load(bodies->position, b), rb),
+        vadd3(harmony_body_load(bodies->position, a), ra));
+
+    // K = (ma + mb) I - [ra] Ia [ra] - [rb] Ib [rb], built a column at a time
+    f32 inverse_mass = bodies->inverse_mass[a] + bodies->inverse_mass[b];
+    const Mat3 *ia = &physics->inverse_inertia[a];
+    const Mat3 *ib = &physics->inverse_inertia[b];
+    Vec3 k[3];
+    for (u32 c = 0; c < 3; ++c) {
+        Vec3 e = {c == 0 ? 1.0f : 0.0f, c == 1 ? 1.0f : 0.0f, c == 2 ? 1.0f : 0.0f};
+        k[c] = vsub3(vsub3(
+            svmul3(inverse_mass, e),
+            vcross3(ra, harmony_mat3_apply(ia, vcross3(ra, e)))),
+            vcross3(rb, harmony_mat3_apply(ib, vcross3(rb, e))));
+    }
+    // K is symmetric, so the rows of its inverse from cross products are
+    // also its columns
+    Vec3 yz = vcross3(k[1], k[2]);
+    Vec3 zx = vcross3(k[2], k[0]);
+    Vec3 xy = vcross3(k[0], k[1]);
+    f32 det = vdot3(k[0], yz);
+    f32 inv_det = det != 0.0f ? 1.0f / det : 0.0f;
+    *dst = (HarmonyConstraint){
+        .a = a,
+        .b = b,
+        .offset_a = ra,
+        .offset_b = rb,
+        .joint = index,
+        .joint_mass = {svmul3(inv_det, yz), svmul3(inv_det, zx), svmul3(inv_det, xy)},
+        .joint_bias = svmul3(HARMONY_PHYSICS_BAUMGARTE / dt, error),
+        .joint_impulse = physics->joint_impulses[index],
+    };
+}
+
+static inline Vec3 harmony_physics_relative_velocity(const HarmonyPhysics *physics, const HarmonyConstraint *constraint) {
+    const HarmonyBodyStreams *bodies = &physics->bodies;
+    Vec3 va = vadd3(
+        harmony_body_load(bodies->velocity, constraint->a),
+        vcross3(harmony_body_load(bodies->angular_velocity, constraint->a), constraint->offset_a));
+    Vec3 vb = vadd3(
+        harmony_body_load(bodies->velocity, constraint->b),
+        vcross3(harmony_body_load(bodies->angular_velocity, constraint->b), constraint->offset_b));
+    return vsub3(vb, va);
+}
+
+/**
+ * Applies an impulse to the second body of a constraint and its opposite
+ * to the first, leaving static bodies untouched
+ */
+static inline void harmony_physics_apply(const HarmonyPhysics *physics, const HarmonyConstraint *constraint, Vec3 impulse) {
+    const HarmonyBodyStreams *bodies = &physics->bodies;
+    u32 a = constraint->a;
+    u32 b = constraint->b;
+    if (bodies->inverse_mass[a] > 0.0f) {
+        harmony_body_store(bodies->velocity, a, vsub3(
+            harmony_body_load(bodies->velocity, a), svmul3(bodies->inverse_mass[a], impulse)));
+        harmony_body_store(bodies->angular_velocity, a, vsub3(
+            harmony_body_load(bodies->angular_velocity, a),
+            harmony_mat3_apply(&physics->inverse_inertia[a], vcross3(constraint->offset_a, impulse))));
+    }
+    if (bodies->inverse_mass[b] > 0.0f) {
+        harmony_body_store(bodies->velocity, b, vadd3(
+            harmony_body_load(bodies->velocity, b), svmul3(bodies->inverse_mass[b], impulse)));
+        harmony_body_store(bodies->angular_velocity, b, vadd3(
+            harmony_body_load(bodies->angular_velocity, b),
+            harmony_mat3_apply(&physics->inverse_inertia[b], vcross3(constraint->offset_b, impulse))));
+    }
+}
+
+static void harmony_physics_solve(const HarmonyPhysics *physics, HarmonyConstraint *constraint) {
+    if (constraint->joint != UINT32_MAX) {
+        Vec3 velocity = harmony_physics_relative_velocity(physics, constraint);
+        Vec3 impulse = harmony_mat3_apply(&constraint->joint_mass, vsub3(svmul3(-1.0f, velocity), constraint->joint_bias));
+        constraint->joint_impulse = vadd3(constraint->joint_impulse, impulse);
+        harmony_physics_apply(physics, constraint, impulse);
+        return;
+    }
+
+    // friction first, so the non-penetration impulse has the last word
+    f32 limit = physics->friction * constraint->normal_impulse;
+    for (u32 t = 0; t < 2; ++t) {
+        f32 speed = vdot3(harmony_physics_relative_velocity(physics, constraint), constraint->tangents[t]);
+        f32 previous = constraint->tangent_impulse[t];
+        f32 accumulated = harmony_clamp(previous - constraint->tangent_mass[t] * speed, -limit, limit);
+        constraint->tangent_impulse[t] = accumulated;
+        harmony_physics_apply(physics, constraint, svmul3(accumulated - previous, constraint->tangents[t]));
+    }
+
+    f32 speed = vdot3(harmony_physics_relative_velocity(physics, constraint), constraint->normal);
+    f32 previous = constraint->normal_impulse;
+    f32 accumulated = harmony_max(previous + constraint->normal_mass * (constraint->bias - speed), 0.0f);
+    constraint->normal_impulse = accumulated;
+    harmony_physics_apply(physics, constraint, svmul3(accumulated - previous, constraint->normal));
+}
+
+typedef struct HarmonyPhysicsSolveArgs {
+    const HarmonyPhysics *physics;
+    HarmonyConstraint *constraints;
+} HarmonyPhysicsSolveArgs;
+
+static void harmony_physics_solve_range(void *data, usize begin, usize end) {
+    HarmonyPhysicsSolveArgs *args = data;
+    for (usize i = begin; i < end; ++i) {
+        harmony_physics_solve(args->physics, &args->constraints[i]);
+    }
+}
+
+/**
+ * The shared state of a solve run in one parallel region, where each color of
+ * each iteration is split into chunks which the threads claim in order
+ */
+typedef struct HarmonyPhysicsSolveRegion {
+    const HarmonyPhysics *physics;
+    /**
+     * The first chunk of each color within an iteration, with one past the
+     * last color
+     */
+    u32 chunk_starts[HARMONY_PHYSICS_COLORS + 1];
+    u32 chunk_count;
+    atomic_uint next;
+    atomic_uint done;
+} HarmonyPhysicsSolveRegion;
+
+static void harmony_physics_solve_region(void *data, usize begin, usize end) {
+    (void)begin;
+    (void)end;
+    HarmonyPhysicsSolveRegion *region = data;
+    const HarmonyPhysics *physics = region->physics;
+    u32 per_iteration = region->chunk_starts[HARMONY_PHYSICS_COLORS];
+    for (;;) {
+        u32 chunk = atomic_fetch_add_explicit(&region->next, 1, memory_order_relaxed);
+        if (chunk >= region->chunk_count)
+            return;
+        u32 local = chunk % per_iteration;
+        u32 c = 0;
+        while (region->chunk_starts[c + 1] <= local)
+            ++c;
+
+        // waits until every chunk of the earlier colors is done, which acts as
+        // a barrier between colors; the earliest unfinished chunk never waits,
+        // so this cannot deadlock, even when the threads run one after another
+        u32 color_first = chunk - local + region->chunk_starts[c];
+        while (atomic_load_explicit(&region->done, memory_order_acquire) < color_first)
+            thrd_yield();
+
+        u32 first = physics->color_starts[c];
+        u64 count = physics->color_starts[c + 1] - first;
+        u64 chunks = region->chunk_starts[c + 1] - region->chunk_starts[c];
+        u64 index = local - region->chunk_starts[c];
+        HarmonyPhysicsSolveArgs args = {physics, physics->constraints + first};
+        harmony_physics_solve_range(&args, (usize)(count * index / chunks), (usize)(count * (index + 1) / chunks));
+        atomic_fetch_add_explicit(&region->done, 1, memory_order_release);
+    }
+}
+
+void harmony_physics_step(
+    u32 thread_count,
+    HarmonyPhysics *physics,
+    const HarmonyPair *pairs,
+    const HarmonyManifold *manifolds,
+    u32 pair_count,
+    f32 dt
+) {
+    harmony_assert(physics != NULL);
+    harmony_assert(pair_count == 0 || (pairs != NULL && manifolds != NULL));
+    harmony_assert(dt > 0.0f);
+    HarmonyBodyStreams *bodies = &physics->bodies;
+    u32 body_count = physics->body_count;
+
+    harmony_physics_islands(physics, pairs, manifolds, pair_count);
+    harmony_bodies_integrate_velocities(bodies, body_count, physics->gravity, dt);
+
+    // world space inverse inertia, R diag(I^-1) R^T
+    for (u32 i = 0; i < body_count; ++i) {
+        Mat3 *inertia = &physics->inverse_inertia[i];
+        if (!harmony_physics_moving(physics, i)) {
+            *inertia = (Mat3){{0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f}};
+            continue;
+        }
+        Vec3 axes[3];
+        harmony_quat_axes(axes, harmony_body_orientation(bodies, i));
+        Vec3 scaled[3];
+        for (u32 c = 0; c < 3; ++c) {
+            scaled[c] = svmul3(bodies->inverse_inertia[c][i], axes[c]);
+        }
+        inertia->x = vadd3(vadd3(svmul3(axes[0].x, scaled[0]), svmul3(axes[1].x, scaled[1])), svmul3(axes[2].x, scaled[2]));
+        inertia->y = vadd3(vadd3(svmul3(axes[0].y, scaled[0]), svmul3(axes[1].y, scaled[1])), svmul3(axes[2].y, scaled[2]));
+        inertia->z = vadd3(vadd3(svmul3(axes[0].z, scaled[0]), svmul3(axes[1].z, scaled[1])), svmul3(axes[2].z, scaled[2]));
+    }
+
+    // colors every constraint, then counts them so each color's constraints
+    // can be written together
+    memset(physics->color_masks, 0, body_count * sizeof(u64));
+    u32 counts[HARMONY_PHYSICS_COLORS] = {0};
+    u32 count = 0;
+    for (u32 p = 0; p < pair_count; ++p) {
+        u32 a = pairs[p].a;
+        u32 b = pairs[p].b;
+        if (!harmony_physics_moving(physics, a) && !harmony_physics_moving(physics, b))
+            continue;
+        for (u32 point = 0; point < manifolds[p].point_count; ++point) {
+            harmony_assert(count < physics->contact_capacity);
+            u32 color = harmony_physics_color(physics, a, b);
+            physics->colors[count++] = color;
+            ++counts[color];
+        }
+    }
+    for (u32 j = 0; j < physics->joint_count; ++j) {
+        u32 a = physics->joints[j].a;
+        u32 b = physics->joints[j].b;
+        if (!harmony_physics_moving(physics, a) && !harmony_physics_moving(physics, b))
+            continue;
+        u32 color = harmony_physics_color(physics, a, b);
+        physics->colors[count++] = color;
+        ++counts[color];
+    }
+    physics->constraint_count = count;
+    u32 cursors[HARMONY_PHYSICS_COLORS];
+    u32 start = 0;
+    for (u32 c = 0; c < HARMONY_PHYSICS_COLORS; ++c) {
+        physics->color_starts[c] = start;
+        cursors[c] = start;
+        start += counts[c];
+    }
+    physics->color_starts[HARMONY_PHYSICS_COLORS] = start;
+
+    u32 index = 0;
+    for (u32 p = 0; p < pair_count; ++p) {
+        u32 a = pairs[p].a;
+        u32 b = pairs[p].b;
+        if (!harmony_physics_moving(physics, a) && !harmony_physics_moving(physics, b))
+            continue;
+        for (u32 point = 0; point < manifolds[p].point_count; ++point) {
+            u32 slot = cursors[physics->colors[index++]]++;
+            harmony_physics_contact(physics, &physics->constraints[slot], a, b, &manifolds[p], point, dt);
+        }
+    }
+    for (u32 j = 0; j < physics->joint_count; ++j) {
+        const HarmonyJoint *joint = &physics->joints[j];
+        if (!harmony_physics_moving(physics, joint->a) && !harmony_physics_moving(physics, joint->b))
+            continue;
+        u32 slot = cursors[physics->colors[index++]]++;
+        harmony_physics_joint(physics, &physics->constraints[slot], j, dt);
+    }
+
+    // warm starts from the previous step's impulses, which converges far
+    // faster when the contacts barely change
+    for (u32 i = 0; i < count; ++i) {
+        const HarmonyConstraint *constraint = &physics->constraints[i];
+        Vec3 impulse = constraint->joint_impulse;
+        if (constraint->joint == UINT32_MAX) {
+            impulse = vadd3(vadd3(
+                svmul3(constraint->normal_impulse, constraint->normal),
+                svmul3(constraint->tangent_impulse[0], constraint->tangents[0])),
+                svmul3(constraint->tangent_impulse[1], constraint->tangents[1]));
+        }
+        harmony_physics_apply(physics, constraint, impulse);
+    }
+
+    // no two constraints of a color share a moving body, so each color is
+    // solved in parallel with the same result as serially, except the last
+    // which holds whatever did not fit in the others; every iteration runs in
+    // one parallel region, so the threads are only started once a step
+    u32 workers = harmony_clamp(thread_count, 1u, HARMONY_MAX_THREADS);
+    HarmonyPhysicsSolveRegion region = {.physics = physics};
+    u32 chunks = 0;
+    bool parallel = false;
+    for (u32 c = 0; c < HARMONY_PHYSICS_COLORS; ++c) {
+        u32 size = physics->color_starts[c + 1] - physics->color_starts[c];
+        bool split = workers > 1 && c != HARMONY_PHYSICS_COLORS - 1 && size >= HARMONY_PHYSICS_PARALLEL_MIN;
+        region.chunk_starts[c] = chunks;
+        chunks += size == 0 ? 0 : split ? workers : 1;
+        parallel = parallel || split;
+    }
+    region.chunk_starts[HARMONY_PHYSICS_COLORS] = chunks;
+    if (parallel) {
+        region.chunk_count = chunks * physics->iterations;
+        atomic_init(&region.next, 0);
+        atomic_init(&region.done, 0);
+        harmony_parallel_for(workers, workers, harmony_physics_solve_region, &region);
+    } else {
+        HarmonyPhysicsSolveArgs args = {physics, physics->constraints};
+        for (u32 iteration = 0; iteration < physics->iterations; ++iteration) {
+            harmony_physics_solve_range(&args, 0, count);
+        }
+    }
+
+    // keeps the impulses in the bodies' own space, before they move
+    u32 cached = 0;
+    for (u32 i = 0; i < count; ++i) {
+        const HarmonyConstraint *constraint = &physics->constraints[i];
+        if (constraint->joint != UINT32_MAX) {
+            physics->joint_impulses[constraint->joint] = constraint->joint_impulse;
+            continue;
+        }
+        physics->contact_cache[cached++] = (HarmonyCachedContact){
+            .key = (u64)constraint->a << 32 | constraint->b,
+            .point = harmony_physics_local_point(bodies, constraint->a, constraint->offset_a),
+            .normal_impulse = constraint->normal_impulse,
+            .tangent_impulse = {constraint->tangent_impulse[0], constraint->tangent_impulse[1]},
+        };
+    }
+    qsort(physics->contact_cache, cached, sizeof(*physics->contact_cache), harmony_cached_contact_compare);
+    physics->contact_cache_count = cached;
+
+    harmony_bodies_integrate_positions(bodies, body_count, dt);
+
+    for (u32 i = 0; i < body_count; ++i) {
+        if (!harmony_physics_moving(physics, i))
+            continue;
+        Vec3 v = harmony_body_load(bodies->velocity, i);
+        Vec3 w = harmony_body_load(bodies->angular_velocity, i);
+        bool slow = vdot3(v, v) < HARMONY_PHYSICS_SLEEP_LINEAR * HARMONY_PHYSICS_SLEEP_LINEAR
+                 && vdot3(w, w) < HARMONY_PHYSICS_SLEEP_ANGULAR * HARMONY_PHYSICS_SLEEP_ANGULAR;
+        bodies->sleep_time[i] = slow ? bodies->sleep_time[i] + dt : 0.0f;
+    }
+}
+
+void harmony_particle_curve(HarmonyParticleCurve *dst, const f32 *times, const f32 *values, u32 count) {
+    harmony_assert(dst != NULL);
+    harmony_assert(times != NULL);
+    harmony_assert(values != NULL);
+    harmony_assert(count > 0);
+    u32 key = 0;
+    for (u32 s = 0; s < HARMONY_PARTICLE_CURVE_SAMPLES; ++s) {
+        f32 t = (f32)s / (f32)(HARMONY_PARTICLE_CURVE_SAMPLES - 1);
+        while (key + 1 < count && times[key + 1] <= t) {
+            ++key;
+        }
+        if (t <= times[0] || key + 1 == count) {
+            dst->samples[s] = t <= times[0] ? values[0] : values[count - 1];
+            continue;
+        }
+        f32 frac = (t - times[key]) / (times[key + 1] - times[key]);
+        dst->samples[s] = values[key] + (values[key + 1] - values[key]) * frac;
+    }
+}
+
+static inline f32 harmony_particle_curve_sample(const HarmonyParticleCurve *curve, f32 t) {
+    f32 x = harmony_min(t, 1.0f) * (f32)(HARMONY_PARTICLE_CURVE_SAMPLES - 1);
+    i32 segment = harmony_min((i32)x, HARMONY_PARTICLE_CURVE_SAMPLES - 2);
+    f32 frac = x - (f32)segment;
+    f32 a = curve->samples[segment];
+    f32 b = curve->samples[segment + 1];
+    return a + (b - a) * frac;
+}
+
+static inline u32 harmony_particle_color(const HarmonyParticleCurves *curves, f32 t) {
+    u32 color = 0;
+    for (u32 c = 0; c < 4; ++c) {
+        f32 value = harmony_particle_curve_sample(&curves->color[c], t);
+        value = harmony_clamp(value, 0.0f, 1.0f);
+        color |= (u32)(value * 255.0f + 0.5f) << (8 * c);
+    }
+    return color;
+}
+
+/**
+ * Updates particles from begin to end, writing those still alive from
+ * write onwards, which must not be past begin
+ */
+static usize harmony_update_particles_range(
+    const HarmonyParticleStreams *particles,
+    usize begin,
+    usize end,
+    usize write,
+    const HarmonyParticleCurves *curves,
+    Vec3 gravity,
+    f32 drag,
+    f32 dt
+) {
+    f32 dv[3] = {gravity.x * dt, gravity.y * dt, gravity.z * dt};
+    f32 damping = 1.0f / (1.0f + drag * dt);
+    for (usize i = begin; i < end; ++i) {
+        f32 age = particles->age[i] + dt;
+        f32 inverse_lifetime = particles->inverse_lifetime[i];
+        f32 t = age * inverse_lifetime;
+        if (!(t < 1.0f))
+            continue;
+        for (u32 c = 0; c < 3; ++c) {
+            f32 v = (particles->velocity[c][i] + dv[c]) * damping;
+            particles->position[c][write] = particles->position[c][i] + v * dt;
+            particles->velocity[c][write] = v;
+        }
+        particles->age[write] = age;
+        particles->inverse_lifetime[write] = inverse_lifetime;
+        particles->size[write] = harmony_particle_curve_sample(&curves->size, t);
+        particles->color[write] = harmony_particle_color(curves, t);
+        ++write;
+    }
+    return write;
+}
+
+static usize harmony_update_particles_scalar(
+    const HarmonyParticleStreams *particles,
+    usize count,
+    const HarmonyParticleCurves *curves,
+    Vec3 gravity,
+    f32 drag,
+    f32 dt
+) {
+    return harmony_update_particles_range(particles, 0, count, 0, curves, gravity, drag, dt);
+}
+
+#ifdef HARMONY_X86_KERNELS
+
+/**
+ * The lanes kept by each 8 bit mask, packed to the front as 4 bit indices
+ */
+static const u32 harmony_left_pack_avx2[256] = {
+    0x00000000, 0x00000000, 0x00000001, 0x00000010, 0x00000002, 0x00000020, 0x00000021, 0x00000210,
+    0x00000003, 0x00000030, 0x00000031, 0x00000310, 0x00000032, 0x00000320, 0x00000321, 0x00003210,
+    0x00000004, 0x00000040, 0x00000041, 0x00000410, 0x00000042, 0x00000420, 0x00000421, 0x00004210,
+    0x00000043, 0x00000430, 0x00000431, 0x00004310, 0x00000432, 0x00004320, 0x00004321, 0x00043210,
+    0x00000005, 0x00000050, 0x00000051, 0x00000510, 0x00000052, 0x00000520, 0x00000521, 0x00005210,
+    0x00000053, 0x00000530, 0x00000531, 0x00005310, 0x00000532, 0x00005320, 0x00005321, 0x00053210,
+    0x00000054, 0x00000540, 0x00000541, 0x00005410, 0x00000542, 0x00005420, 0x00005421, 0x00054210,
+    0x00000543, 0x00005430, 0x00005431, 0x00054310, 0x00005432, 0x00054320, 0x00054321, 0x00543210,
+    0x00000006, 0x00000060, 0x00000061, 0x00000610, 0x00000062, 0x00000620, 0x00000621, 0x00006210,
+    0x00000063, 0x00000630, 0x00000631, 0x00006310, 0x00000632, 0x00006320, 0x00006321, 0x00063210,
+    0x00000064, 0x00000640, 0x00000641, 0x00006410, 0x00000642, 0x00006420, 0x00006421, 0x00064210,
+    0x00000643, 0x00006430, 0x00006431, 0x00064310, 0x00006432, 0x00064320, 0x00064321, 0x00643210,
+    0x00000065, 0x00000650, 0x00000651, 0x00006510, 0x00000652, 0x00006520, 0x00006521, 0x00065210,
+    0x00000653, 0x00006530, 0x00006531, 0x00065310, 0x00006532, 0x00065320, 0x00065321, 0x00653210,
+    0x00000654, 0x00006540, 0x00006541, 0x00065410, 0x00006542, 0x00065420, 0x00065421, 0x00654210,
+    0x00006543, 0x00065430, 0x00065431, 0x00654310, 0x00065432, 0x00654320, 0x00654321, 0x06543210,
+    0x00000007, 0x00000070, 0x00000071, 0x00000710, 0x00000072, 0x00000720, 0x00000721, 0x00007210,
+    0x00000073, 0x00000730, 0x00000731, 0x00007310, 0x00000732, 0x00007320, 0x00007321, 0x00073210,
+    0x00000074, 0x00000740, 0x00000741, 0x00007410, 0x00000742, 0x00007420, 0x00007421, 0x00074210,
+    0x00000743, 0x00007430, 0x00007431, 0x00074310, 0x00007432, 0x00074320, 0x00074321, 0x00743210,
+    0x00000075, 0x00000750, 0x00000751, 0x00007510, 0x00000752, 0x00007520, 0x00007521, 0x00075210,
+    0x00000753, 0x00007530, 0x00007531, 0x00075310, 0x00007532, 0x00075320, 0x00075321, 0x00753210,
+    0x00000754, 0x00007540, 0x00007541, 0x00075410, 0x00007542, 0x00075420, 0x00075421, 0x00754210,
+    0x00007543, 0x00075430, 0x00075431, 0x00754310, 0x00075432, 0x00754320, 0x00754321, 0x07543210,
+    0x00000076, 0x00000760, 0x00000761, 0x00007610, 0x00000762, 0x00007620, 0x00007621, 0x00076210,
+    0x00000763, 0x00007630, 0x00007631, 0x00076310, 0x00007632, 0x00076320, 0x00076321, 0x00763210,
+    0x00000764, 0x00007640, 0x00007641, 0x00076410, 0x00007642, 0x00076420, 0x00076421, 0x00764210,
+    0x00007643, 0x00076430, 0x00076431, 0x00764310, 0x00076432, 0x00764320, 0x00764321, 0x07643210,
+    0x00000765, 0x00007650, 0x00007651, 0x00076510, 0x00007652, 0x00076520, 0x00076521, 0x00765210,
+    0x00007653, 0x00076530, 0x00076531, 0x00765310, 0x00076532, 0x00765320, 0x00765321, 0x07653210,
+    0x00007654, 0x00076540, 0x00076541, 0x00765410, 0x00076542, 0x00765420, 0x00765421, 0x07654210,
+    0x00076543, 0x00765430, 0x00765431, 0x07654310, 0x00765432, 0x07654320, 0x07654321, 0x76543210,
+};
+
+HARMONY_TARGET_AVX2
+static inline __m256 harmony_particle_curve_sample_avx2(const HarmonyParticleCurve *curve, __m256 t) {
+    __m256 x = _mm256_mul_ps(_mm256_min_ps(t, _mm256_set1_ps(1.0f)), _mm256_set1_ps((f32)(HARMONY_PARTICLE_CURVE_SAMPLES - 1)));
+    __m256i segment = _mm256_min_epi32(_mm256_cvttps_epi32(x), _mm256_set1_epi32(HARMONY_PARTICLE_CURVE_SAMPLES - 2));
+    __m256 frac = _mm256_sub_ps(x, _mm256_cvtepi32_ps(segment));
+    __m256 a = _mm256_i32gather_ps(curve->samples, segment, 4);
+    __m256 b = _mm256_i32gather_ps(curve->samples + 1, segment, 4);
+    return _mm256_add_ps(a, _mm256_mul_ps(_mm256_sub_ps(b, a), frac));
+}
+
+HARMONY_TARGET_AVX2
+static usize harmony_update_particles_avx2(
+    const HarmonyParticleStreams *particles,
+    usize count,
+    const HarmonyParticleCurves *curves,
+    Vec3 gravity,
+    f32 drag,
+    f32 dt
+) {
+    __m256 dv[3] = {
+        _mm256_set1_ps(gravity.x * dt),
+        _mm256_set1_ps(gravity.y * dt),
+        _mm256_set1_ps(gravity.z * dt),
+    };
+    __m256 damping = _mm256_set1_ps(1.0f / (1.0f + drag * dt));
+    __m256 step = _mm256_set1_ps(dt);
+    __m256 one = _mm256_set1_ps(1.0f);
+    __m256i shifts = _mm256_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28);
+    usize write = 0;
+    usize i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 age = _mm256_add_ps(_mm256_loadu_ps(particles->age + i), step);
+        __m256 inverse_lifetime = _mm256_loadu_ps(particles->inverse_lifetime + i);
+        __m256 t = _mm256_mul_ps(age, inverse_lifetime);
+        u32 alive = (u32)_mm256_movemask_ps(_mm256_cmp_ps(t, one, _CMP_LT_OQ));
+        if (alive == 0)
+            continue;
+
+        // every lane is stored packed to the front, the lanes past the
+        // survivors landing on slots already read
+        __m256i keep = _mm256_and_si256(
+            _mm256_srlv_epi32(_mm256_set1_epi32((i32)harmony_left_pack_avx2[alive]), shifts), _mm256_set1_epi32(0xf));
+        for (u32 c = 0; c < 3; ++c) {
+            __m256 v = _mm256_mul_ps(_mm256_add_ps(_mm256_loadu_ps(particles->velocity[c] + i), dv[c]), damping);
+            __m256 p = _mm256_add_ps(_mm256_loadu_ps(particles->position[c] + i), _mm256_mul_ps(v, step));
+            _mm256_storeu_ps(particles->position[c] + write, _mm256_permutevar8x32_ps(p, keep));
+            _mm256_storeu_ps(particles->velocity[c] + write, _mm256_permutevar8x32_ps(v, keep));
+        }
+        __m256 size = harmony_particle_curve_sample_avx2(&curves->size, t);
+        __m256i color = _mm256_setzero_si256();
+        for (u32 c = 0; c < 4; ++c) {
+            __m256 value = harmony_particle_curve_sample_avx2(&curves->color[c], t);
+            value = _mm256_min_ps(_mm256_max_ps(value, _mm256_setzero_ps()), one);
+            __m256i byte = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(value, _mm256_set1_ps(255.0f)), _mm256_set1_ps(0.5f)));
+            color = _mm256_or_si256(color, _mm256_slli_epi32(byte, (i32)(8 * c)));
+        }
+        _mm256_storeu_ps(particles->age + write, _mm256_permutevar8x32_ps(age, keep));
+        _mm256_storeu_ps(particles->inverse_lifetime + write, _mm256_permutevar8x32_ps(inverse_lifetime, keep));
+        _mm256_storeu_ps(particles->size + write, _mm256_permutevar8x32_ps(size, keep));
+        _mm256_storeu_si256((__m256i *)(particles->color + write), _mm256_permutevar8x32_epi32(color, keep));
+        write += (usize)__builtin_popcount(alive);
+    }
+    return harmony_update_particles_range(particles, i, count, write, curves, gravity, drag, dt);
+}
+
+#endif // HARMONY_X86_KERNELS
+
+HarmonyParticles harmony_particles_create(const HarmonyAllocator *allocator, u32 capacity) {
+    harmony_assert(allocator != NULL);
+    HarmonyParticles particles = {.capacity = capacity};
+    particles.allocation_size = (usize)capacity * 14 * sizeof(u32) + (usize)HARMONY_PARTICLE_TASK_COUNT * 256 * sizeof(u32);
+    particles.allocation = harmony_alloc(allocator, particles.allocation_size);
+    harmony_assert(particles.allocation != NULL);
+
+    f32 *streams = particles.allocation;
+    for (u32 c = 0; c < 3; ++c) {
+        particles.streams.position[c] = streams + c * capacity;
+        particles.streams.velocity[c] = streams + (3 + c) * capacity;
+    }
+    particles.streams.age = streams + 6 * (usize)capacity;
+    particles.streams.inverse_lifetime = particles.streams.age + capacity;
+    particles.streams.size = particles.streams.inverse_lifetime + capacity;
+    particles.streams.color = (u32 *)(particles.streams.size + capacity);
+    particles.order = particles.streams.color + capacity;
+    particles.keys[0] = particles.order + capacity;
+    particles.keys[1] = particles.keys[0] + capacity;
+    particles.indices = particles.keys[1] + capacity;
+    particles.histograms = particles.indices + capacity;
+
+    for (u32 s = 0; s < HARMONY_PARTICLE_CURVE_SAMPLES; ++s) {
+        particles.curves.size.samples[s] = 1.0f;
+        for (u32 c = 0; c < 4; ++c) {
+            particles.curves.color[c].samples[s] = 1.0f;
+        }
+    }
+    return particles;
+}
+
+void harmony_particles_destroy(const HarmonyAllocator *allocator, HarmonyParticles *particles) {
+    harmony_assert(allocator != NULL);
+    harmony_assert(particles != NULL);
+    harmony_free(allocator, particles->allocation, particles->allocation_size);
+    *particles = (HarmonyParticles){0};
+}
+
+// particles are emitted in blocks of this many, each with its own generator
+#define HARMONY_PARTICLE_EMIT_BLOCK 4096
+
+typedef struct HarmonyParticlesEmitArgs {
+    HarmonyParticles *particles;
+    const HarmonyParticleEmitter *emitter;
+    u32 first;
+    u32 count;
+    u64 seed;
+} HarmonyParticlesEmitArgs;
+
+static void harmony_particles_emit_range(void *data, usize begin, usize end) {
+    HarmonyParticlesEmitArgs *args = data;
+    const HarmonyParticleEmitter *emitter = args->emitter;
+    HarmonyParticleStreams *streams = &args->particles->streams;
+    f32 position[3] = {emitter->position.x, emitter->position.y, emitter->position.z};
+    f32 position_spread[3] = {emitter->position_spread.x, emitter->position_spread.y, emitter->position_spread.z};
+    f32 velocity[3] = {emitter->velocity.x, emitter->velocity.y, emitter->velocity.z};
+    f32 velocity_spread[3] = {emitter->velocity_spread.x, emitter->velocity_spread.y, emitter->velocity_spread.z};
+    f32 size = args->particles->curves.size.samples[0];
+    u32 color = harmony_particle_color(&args->particles->curves, 0.0f);
+    for (usize block = begin; block < end; ++block) {
+        // mixes the seed before adding the block, as seed + block would make
+        // block k + 1 of one seed the same as block k of the next
+        u64 state = args->seed;
+        state = harmony_splitmix64(&state) ^ block;
+        HarmonyRandom rng;
+        harmony_random_seed(&rng, harmony_splitmix64(&state));
+        usize first = args->first + block * HARMONY_PARTICLE_EMIT_BLOCK;
+        usize n = harmony_min(args->count - block * HARMONY_PARTICLE_EMIT_BLOCK, (usize)HARMONY_PARTICLE_EMIT_BLOCK);
+        for (u32 c = 0; c < 3; ++c) {
+            harmony_random_range_f32s(&rng, streams->position[c] + first, n,
+                position[c] - position_spread[c], position[c] + position_spread[c]);
+            harmony_random_range_f32s(&rng, streams->velocity[c] + first, n,
+                velocity[c] - velocity_spread[c], velocity[c] + velocity_spread[c]);
+        }
+        f32 *inverse_lifetime = streams->inverse_lifetime + first;
+        harmony_random_range_f32s(&rng, inverse_lifetime, n, emitter->min_lifetime, emitter->max_lifetime);
+        for (usize i = 0; i < n; ++i) {
+            inverse_lifetime[i] = 1.0f / inverse_lifetime[i];
+            streams->age[first + i] = 0.0f;
+            streams->size[first + i] = size;
+            streams->color[first + i] = color;
+        }
+    }
+}
+
+u32 harmony_particles_emit(
+    u32 thread_count,
+    HarmonyParticles *particles,
+    const HarmonyParticleEmitter *emitter,
+    u32 count,
+    u64 seed
+) {
+    harmony_assert(particles != NULL);
+    harmony_assert(emitter != NULL);
+    harmony_assert(emitter->min_lifetime > 0.0f && emitter->max_lifetime >= emitter->min_lifetime);
+    count = harmony_min(count, particles->capacity - particles->count);
+    HarmonyParticlesEmitArgs args = {particles, emitter, particles->count, count, seed};
+    usize block_count = ((usize)count + HARMONY_PARTICLE_EMIT_BLOCK - 1) / HARMONY_PARTICLE_EMIT_BLOCK;
+    if (thread_count <= 1)
+        harmony_particles_emit_range(&args, 0, block_count);
+    else
+        harmony_parallel_for(thread_count, block_count, harmony_particles_emit_range, &args);
+    particles->count += count;
+    return count;
+}
+
+static HarmonyParticleStreams harmony_particle_streams_offset(const HarmonyParticleStreams *streams, usize offset) {
+    HarmonyParticleStreams result;
+    for (u32 c = 0; c < 3; ++c) {
+        result.position[c] = streams->position[c] + offset;
+        result.velocity[c] = streams->velocity[c] + offset;
+    }
+    result.age = streams->age + offset;
+    result.inverse_lifetime = streams->inverse_lifetime + offset;
+    result.size = streams->size + offset;
+    result.color = streams->color + offset;
+    return result;
+}
+
+typedef struct HarmonyParticlesUpdateArgs {
+    HarmonyParticles *particles;
+    f32 dt;
+    u32 survivors[HARMONY_PARTICLE_TASK_COUNT];
+} HarmonyParticlesUpdateArgs;
+
+static inline usize harmony_particle_task_begin(usize count, usize task) {
+    return count * task / HARMONY_PARTICLE_TASK_COUNT;
+}
+
+static void harmony_particles_update_range(void *data, usize begin, usize end) {
+    HarmonyParticlesUpdateArgs *args = data;
+    HarmonyParticles *particles = args->particles;
+    for (usize task = begin; task < end; ++task) {
+        usize first = harmony_particle_task_begin(particles->count, task);
+        usize last = harmony_particle_task_begin(particles->count, task + 1);
+        HarmonyParticleStreams streams = harmony_particle_streams_offset(&particles->streams, first);
+        args->survivors[task] = (u32)harmony_kernels()->update_particles(
+            &streams, last - first, &particles->curves, particles->gravity, particles->drag, args->dt);
+    }
+}
+
+void harmony_particles_update(u32 thread_count, HarmonyParticles *particles, f32 dt) {
+    harmony_assert(particles != NULL);
+    if (thread_count <= 1) {
+        particles->count = (u32)harmony_kernels()->update_particles(
+            &particles->streams, particles->count, &particles->curves, particles->gravity, particles->drag, dt);
+        return;
+    }
+
+    // each range is compacted in place in parallel, then the survivors are
+    // moved down in order
+    HarmonyParticlesUpdateArgs args = {.particles = particles, .dt = dt};
+    harmony_parallel_for(thread_count, HARMONY_PARTICLE_TASK_COUNT, harmony_particles_update_range, &args);
+    HarmonyParticleStreams *streams = &particles->streams;
+    f32 *f32_streams[9] = {
+        streams->position[0], streams->position[1], streams->position[2],
+        streams->velocity[0], streams->velocity[1], streams->velocity[2],
+        streams->age, streams->inverse_lifetime, streams->size,
+    };
+    usize write = 0;
+    for (usize task = 0; task < HARMONY_PARTICLE_TASK_COUNT; ++task) {
+        usize first = harmony_particle_task_begin(particles->count, task);
+        usize survivors = args.survivors[task];
+        if (write != first) {
+            for (u32 s = 0; s < 9; ++s) {
+                memmove(f32_streams[s] + write, f32_streams[s] + first, survivors * sizeof(f32));
+            }
+            memmove(streams->color + write, streams->color + first, survivors * sizeof(u32));
+        }
+        write += survivors;
+    }
+    particles->count = (u32)write;
+}
+
+typedef struct HarmonyParticlesSortArgs {
+    HarmonyParticles *particles;
+    Vec3 eye;
+    const u32 *src_keys;
+    u32 *dst_keys;
+    const u32 *src_indices;
+    u32 *dst_indices;
+    u32 shift;
+} HarmonyParticlesSortArgs;
+
+static void harmony_particles_sort_keys(void *data, usize begin, usize end) {
+    HarmonyParticlesSortArgs *args = data;
+    HarmonyParticles *particles = args->particles;
+    const HarmonyParticleStreams *streams = &particles->streams;
+    usize first = harmony_particle_task_begin(particles->count, begin);
+    usize last = harmony_particle_task_begin(particles->count, end);
+    for (usize i = first; i < last; ++i) {
+        f32 dx = streams->position[0][i] - args->eye.x;
+        f32 dy = streams->position[1][i] - args->eye.y;
+        f32 dz = streams->position[2][i] - args->eye.z;
+        f32 distance = dx * dx + dy * dy + dz * dz;
+        u32 bits;
+        memcpy(&bits, &distance, sizeof(bits));
+        // positive floats order as their bits, inverted to sort the
+        // furthest first
+        particles->keys[0][i] = ~bits;
+    }
+}
+
+static void harmony_particles_sort_count(void *data, usize begin, usize end) {
+    HarmonyParticlesSortArgs *args = data;
+    HarmonyParticles *particles = args->particles;
+    for (usize task = begin; task < end; ++task) {
+        u32 *histogram = particles->histograms + task * 256;
+        memset(histogram, 0, 256 * sizeof(u32));
+        usize first = harmony_particle_task_begin(particles->count, task);
+        usize last = harmony_particle_task_begin(particles->count, task + 1);
+        for (usize i = first; i < last; ++i) {
+            ++histogram[args->src_keys[i] >> args->shift & 0xff];
+        }
+    }
+}
+
+static void harmony_particles_sort_scatter(void *data, usize begin, usize end) {
+    HarmonyParticlesSortArgs *args = data;
+    HarmonyParticles *particles = args->particles;
+    for (usize task = begin; task < end; ++task) {
+        u32 *offsets = particles->histograms + task * 256;
+        usize first = harmony_particle_task_begin(particles->count, task);
+        usize last = harmony_particle_task_begin(particles->count, task + 1);
+        for (usize i = first; i < last; ++i) {
+            u32 key = args->src_keys[i];
+            u32 slot = offsets[key >> args->shift & 0xff]++;
+            args->dst_keys[slot] = key;
+            args->dst_indices[slot] = args->src_indices != NULL ? args->src_indices[i] : (u32)i;
+        }
+    }
+}
+
+static void harmony_particles_sort_run(u32 thread_count, HarmonyParallelFn fn, HarmonyParticlesSortArgs *args) {
+    if (thread_count <= 1)
+        fn(args, 0, HARMONY_PARTICLE_TASK_COUNT);
+    else
+        harmony_parallel_for(thread_count, HARMONY_PARTICLE_TASK_COUNT, fn, args);
+}
+
+void harmony_particles_sort(u32 thread_count, HarmonyParticles *particles, Vec3 eye) {
+    harmony_assert(particles != NULL);
+    HarmonyParticlesSortArgs args = {.particles = particles, .eye = eye};
+    harmony_particles_sort_run(thread_count, harmony_particles_sort_keys, &args);
+
+    // least significant byte first, each pass counting every range's
+    // digits, then scattering each range from where its digits begin, the
+    // fourth pass ending in the order
+    u32 *indices[2] = {particles->indices, particles->order};
+    for (u32 pass = 0; pass < 4; ++pass) {
+        args.src_keys = particles->keys[pass % 2];
+        args.dst_keys = particles->keys[(pass + 1) % 2];
+        args.src_indices = pass == 0 ? NULL : indices[(pass + 1) % 2];
+        args.dst_indices = indices[pass % 2];
+        args.shift = 8 * pass;
+        harmony_particles_sort_run(thread_count, harmony_particles_sort_count, &args);
+        u32 offset = 0;
+        for (u32 digit = 0; digit < 256; ++digit) {
+            for (u32 task = 0; task < HARMONY_PARTICLE_TASK_COUNT; ++task) {
+                u32 *slot = &particles->histograms[task * 256 + digit];
+                u32 n = *slot;
+                *slot = offset;
+                offset += n;
+            }
+        }
+        harmony_particles_sort_run(thread_count, harmony_particles_sort_scatter, &args);
+    }
+}
+
+void harmony_particles_write_vertices(HarmonyParticleVertex *dst, const HarmonyParticles *particles, const u32 *order) {
+    harmony_assert(dst != NULL);
+    harmony_assert(particles != NULL);
+    const HarmonyParticleStreams *streams = &particles->streams;
+    for (u32 n = 0; n < particles->count; ++n) {
+        u32 i = order != NULL ? order[n] : n;
+        dst[n] = (HarmonyParticleVertex){
+            {streams->position[0][i], streams->position[1][i], streams->position[2][i]},
+            streams->size[i],
+            streams->color[i],
+        };
+    }
+}
+
+static const HarmonyKernels harmony_kernel_tiers[HARMONY_CPU_TIER_COUNT] = {
+    [HARMONY_CPU_TIER_SCALAR] = {
+        HARMONY_CPU_TIER_SCALAR,
+        harmony_copy_scalar,
+        harmony_mix_scalar,
+        harmony_model_matrices_2d_scalar,
+        harmony_model_matrices_3d_scalar,
+        harmony_random_scalar,
+        harmony_hash_stripes_scalar,
+        harmony_noise_scalar,
+        harmony_fft_pass_scalar,
+        harmony_approx_scalar,
+        harmony_quat_normalize_scalar,
+        harmony_quat_blend_scalar,
+        harmony_rotation_matrices_scalar,
+        harmony_cull_scalar,
+        harmony_ray_packets_scalar,
+        harmony_integrate_bodies_scalar,
+        harmony_update_particles_scalar,
+    },
+#ifdef HARMONY_X86_KERNELS
+    [HARMONY_CPU_TIER_SSE2] = {
+        HARMONY_CPU_TIER_SSE2,
+        harmony_copy_sse2,
+        harmony_mix_sse2,
+        harmony_model_matrices_2d_scalar,
+        harmony_model_matrices_3d_wide,
+        harmony_random_scalar,
+        harmony_hash_stripes_sse2,
+        harmony_noise_scalar,
+        harmony_fft_pass_scalar,
+        harmony_approx_scalar,
+        harmony_quat_normalize_scalar,
+        harmony_quat_blend_scalar,
+        harmony_rotation_matrices_scalar,
+        harmony_cull_scalar,
+        harmony_ray_packets_scalar,
+        harmony_integrate_bodies_scalar,
+        harmony_update_particles_scalar,
+    },
+    [HARMONY_CPU_TIER_AVX2] = {
+        HARMONY_CPU_TIER_AVX2,
+        harmony_copy_avx2,
+        harmony_mix_avx2,
+        harmony_model_matrices_2d_avx2,
+        harmony_model_matrices_3d_avx2,
+        harmony_random_avx2,
+        harmony_hash_stripes_avx2,
+        harmony_noise_avx2,
+        harmony_fft_pass_avx2,
+        harmony_approx_avx2,
+        harmony_quat_normalize_avx2,
+        harmony_quat_blend_avx2,
+        harmony_rotation_matrices_avx2,
+        harmony_cull_avx2,
+        harmony_ray_packets_avx2,
+        harmony_integrate_bodies_avx2,
+        harmony_update_particles_avx2,
+    },
+    [HARMONY_CPU_TIER_AVX512] = {
+        HARMONY_CPU_TIER_AVX512,
+        harmony_copy_avx512,
+        harmony_mix_avx2,
+        harmony_model_matrices_2d_avx2,
+        harmony_model_matrices_3d_avx2,
+        harmony_random_avx2,
+        harmony_hash_stripes_avx2,
+        harmony_noise_avx2,
+        harmony_fft_pass_avx2,
+        harmony_approx_avx2,
+        harmony_quat_normalize_avx2,
+        harmony_quat_blend_avx2,
+        harmony_rotation_matrices_avx2,
+        harmony_cull_avx2,
+        harmony_ray_packets_avx2,
+        harmony_integrate_bodies_avx2,
+        harmony_update_particles_avx2,
+    },
+#endif // HARMONY_X86_KERNELS
+};
+
+static _Atomic(const HarmonyKernels *) harmony_kernels_selected;
+static once_flag harmony_kernels_once = ONCE_FLAG_INIT;
+
+static void harmony_kernels_init(void) {
+    // keeps a tier chosen by harmony_kernels_select() before the first call
+    const HarmonyKernels *expected = NULL;
+    atomic_compare_exchange_strong(&harmony_kernels_selected, &expected,
+        &harmony_kernel_tiers[harmony_cpu_best_tier()]);
+}
+
+const HarmonyKernels *harmony_kernels(void) {
+    call_once(&harmony_kernels_once, harmony_kernels_init);
+    return atomic_load_explicit(&harmony_kernels_selected, memory_order_acquire);
+}
+
+bool harmony_kernels_select(HarmonyCpuTier tier) {
+    harmony_assert(tier < HARMONY_CPU_TIER_COUNT);
+    if (tier > harmony_cpu_best_tier())
+        return false;
+    atomic_store_explicit(&harmony_kernels_selected, &harmony_kernel_tiers[tier], memory_order_release);
+    return true;
+}
+
+void harmony_copy(void *dst, const void *src, usize size) {
+    harmony_assert(dst != NULL);
+    harmony_assert(src != NULL);
+    harmony_kernels()->copy(dst, src, size);
+}
+
+void harmony_mix(f32 *dst, const f32 *src, f32 gain, usize count) {
+    harmony_assert(dst != NULL);
+    harmony_assert(src != NULL);
+    harmony_kernels()->mix(dst, src, gain, count);
 }
 
 #endif // defined(HARMONY_IMPLEMENTATION_MATH) || defined(HARMONY_IMPLEMENTATION_ALL)
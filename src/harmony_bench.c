@@ -0,0 +1,1717 @@
+#ifndef HARMONY_IMPLEMENTATION_ALL
+#define HARMONY_IMPLEMENTATION_ALL
+#endif
+#include "harmony.h"
+#include "harmony_containers.h"
+#include "harmony_math.h"
+
+/**
+ * Benchmarks for the performance sensitive parts of Harmony
+ *
+ * Each benchmark prints its results to stdout, and should be built with
+ * optimizations enabled
+ */
+
+static f64 bench_seconds(void) {
+    struct timespec time;
+    timespec_get(&time, TIME_UTC);
+    return (f64)time.tv_sec + (f64)time.tv_nsec / 1.0e9;
+}
+
+static f32 bench_random_f32(void) {
+    return (f32)rand() / (f32)RAND_MAX * 2.0f - 1.0f;
+}
+
+static void bench_mmul_naive(f32 *dst, u32 size, const f32 *lhs, const f32 *rhs) {
+    for (u32 i = 0; i < size; ++i) {
+        for (u32 j = 0; j < size; ++j) {
+            dst[i * size + j] = 0.0f;
+            for (u32 k = 0; k < size; ++k) {
+                dst[i * size + j] += lhs[k * size + j] * rhs[i * size + k];
+            }
+        }
+    }
+}
+
+static void bench_mmul(u32 thread_count) {
+    printf("mmul GFLOP/s (%u threads)\n", thread_count);
+    printf("%8s %12s %12s %12s\n", "size", "naive", "mmul", "parallel");
+    for (u32 size = 4; size <= 2048; size *= 2) {
+        usize count = (usize)size * size;
+        f32 *lhs = malloc(count * sizeof(*lhs));
+        f32 *rhs = malloc(count * sizeof(*rhs));
+        f32 *dst = malloc(count * sizeof(*dst));
+        for (usize i = 0; i < count; ++i) {
+            lhs[i] = bench_random_f32();
+            rhs[i] = bench_random_f32();
+        }
+
+        f64 flops = 2.0 * (f64)size * (f64)size * (f64)size;
+        u32 iterations = (u32)harmony_max(1.0, 1.0e9 / flops);
+        f64 results[3] = {0};
+
+        // the naive loop is skipped at large sizes, where it takes minutes
+        if (size <= 512) {
+            f64 begin = bench_seconds();
+            for (u32 i = 0; i < iterations; ++i)
+                bench_mmul_naive(dst, size, lhs, rhs);
+            results[0] = flops * iterations / (bench_seconds() - begin) / 1.0e9;
+        }
+
+        f64 begin = bench_seconds();
+        for (u32 i = 0; i < iterations; ++i)
+            mmul(dst, size, size, lhs, size, size, rhs);
+        results[1] = flops * iterations / (bench_seconds() - begin) / 1.0e9;
+
+        begin = bench_seconds();
+        for (u32 i = 0; i < iterations; ++i)
+            mmul_parallel(thread_count, dst, size, size, lhs, size, size, rhs);
+        results[2] = flops * iterations / (bench_seconds() - begin) / 1.0e9;
+
+        printf("%8u %12.3f %12.3f %12.3f\n", size, results[0], results[1], results[2]);
+
+        free(dst);
+        free(rhs);
+        free(lhs);
+    }
+}
+
+static void bench_model_matrices(u32 thread_count) {
+    usize count = 100000;
+    f32 *streams[11];
+    for (u32 i = 0; i < harmony_countof(streams); ++i) {
+        streams[i] = malloc(count * sizeof(f32));
+        for (usize j = 0; j < count; ++j)
+            streams[i][j] = bench_random_f32();
+    }
+    for (usize j = 0; j < count; ++j) {
+        Vec4 q = vnorm4((Vec4){streams[6][j], streams[7][j], streams[8][j], streams[9][j]});
+        streams[6][j] = q.x;
+        streams[7][j] = q.y;
+        streams[8][j] = q.z;
+        streams[9][j] = q.w;
+    }
+    HarmonyModelStreams2D src_2d = {
+        {streams[0], streams[1], streams[2]}, {streams[3], streams[4]}, streams[10],
+    };
+    HarmonyModelStreams3D src_3d = {
+        {streams[0], streams[1], streams[2]}, {streams[3], streams[4], streams[5]},
+        {streams[6], streams[7], streams[8], streams[9]},
+    };
+    Mat4 *dst = malloc(count * sizeof(*dst));
+    u32 iterations = 50;
+
+    printf("model matrices, millions of matrices/s (%zu instances, %u threads)\n", count, thread_count);
+    printf("%8s %12s %12s %12s\n", "type", "single", "batch", "parallel");
+
+    f64 results[3];
+    f64 begin = bench_seconds();
+    for (u32 n = 0; n < iterations; ++n) {
+        for (usize j = 0; j < count; ++j) {
+            dst[j] = harmony_model_matrix_2d(
+                (Vec3){streams[0][j], streams[1][j], streams[2][j]},
+                (Vec2){streams[3][j], streams[4][j]}, streams[10][j]);
+        }
+    }
+    results[0] = (f64)(count * iterations) / (bench_seconds() - begin) / 1.0e6;
+    begin = bench_seconds();
+    for (u32 n = 0; n < iterations; ++n)
+        harmony_model_matrices_2d(dst, &src_2d, count);
+    results[1] = (f64)(count * iterations) / (bench_seconds() - begin) / 1.0e6;
+    begin = bench_seconds();
+    for (u32 n = 0; n < iterations; ++n)
+        harmony_model_matrices_2d_parallel(thread_count, dst, &src_2d, count);
+    results[2] = (f64)(count * iterations) / (bench_seconds() - begin) / 1.0e6;
+    printf("%8s %12.2f %12.2f %12.2f\n", "2d", results[0], results[1], results[2]);
+
+    begin = bench_seconds();
+    for (u32 n = 0; n < iterations; ++n) {
+        for (usize j = 0; j < count; ++j) {
+            dst[j] = harmony_model_matrix_3d(
+                (Vec3){streams[0][j], streams[1][j], streams[2][j]},
+                (Vec3){streams[3][j], streams[4][j], streams[5][j]},
+                (Quat){streams[6][j], streams[7][j], streams[8][j], streams[9][j]});
+        }
+    }
+    results[0] = (f64)(count * iterations) / (bench_seconds() - begin) / 1.0e6;
+    begin = bench_seconds();
+    for (u32 n = 0; n < iterations; ++n)
+        harmony_model_matrices_3d(dst, &src_3d, count);
+    results[1] = (f64)(count * iterations) / (bench_seconds() - begin) / 1.0e6;
+    begin = bench_seconds();
+    for (u32 n = 0; n < iterations; ++n)
+        harmony_model_matrices_3d_parallel(thread_count, dst, &src_3d, count);
+    results[2] = (f64)(count * iterations) / (bench_seconds() - begin) / 1.0e6;
+    printf("%8s %12.2f %12.2f %12.2f\n", "3d", results[0], results[1], results[2]);
+
+    free(dst);
+    for (u32 i = 0; i < harmony_countof(streams); ++i)
+        free(streams[i]);
+}
+
+static void bench_random(void) {
+    usize count = 1u << 20;
+    f32 *dst = malloc(count * sizeof(*dst));
+    Vec3 *vecs = malloc(count * sizeof(*vecs));
+    u32 iterations = 20;
+    HarmonyPcg32 pcg;
+    harmony_pcg32_seed(&pcg, 1, 1);
+    HarmonyXoshiro256 xoshiro;
+    harmony_xoshiro256_seed(&xoshiro, 1);
+    HarmonyRandom rng;
+    harmony_random_seed(&rng, 1);
+
+    printf("random numbers, millions of values/s\n");
+    printf("%12s %12s\n", "generator", "rate");
+
+    f64 begin = bench_seconds();
+    for (u32 n = 0; n < iterations; ++n) {
+        for (usize i = 0; i < count; ++i)
+            dst[i] = (f32)rand() / (f32)RAND_MAX;
+    }
+    printf("%12s %12.2f\n", "rand", (f64)(count * iterations) / (bench_seconds() - begin) / 1.0e6);
+
+    begin = bench_seconds();
+    for (u32 n = 0; n < iterations; ++n) {
+        for (usize i = 0; i < count; ++i)
+            dst[i] = harmony_pcg32_f32(&pcg);
+    }
+    printf("%12s %12.2f\n", "pcg32", (f64)(count * iterations) / (bench_seconds() - begin) / 1.0e6);
+
+    begin = bench_seconds();
+    for (u32 n = 0; n < iterations; ++n) {
+        for (usize i = 0; i < count; ++i)
+            dst[i] = harmony_xoshiro256_f32(&xoshiro);
+    }
+    printf("%12s %12.2f\n", "xoshiro256", (f64)(count * iterations) / (bench_seconds() - begin) / 1.0e6);
+
+    HarmonyCpuTier best = harmony_cpu_best_tier();
+    harmony_kernels_select(HARMONY_CPU_TIER_SCALAR);
+    begin = bench_seconds();
+    for (u32 n = 0; n < iterations; ++n)
+        harmony_random_f32s(&rng, dst, count);
+    printf("%12s %12.2f\n", "bulk scalar", (f64)(count * iterations) / (bench_seconds() - begin) / 1.0e6);
+    harmony_kernels_select(best);
+
+    begin = bench_seconds();
+    for (u32 n = 0; n < iterations; ++n)
+        harmony_random_f32s(&rng, dst, count);
+    printf("%12s %12.2f\n", "bulk", (f64)(count * iterations) / (bench_seconds() - begin) / 1.0e6);
+
+    begin = bench_seconds();
+    for (u32 n = 0; n < iterations; ++n)
+        harmony_random_gaussian_f32s(&rng, dst, count, 0.0f, 1.0f);
+    printf("%12s %12.2f\n", "gaussian", (f64)(count * iterations) / (bench_seconds() - begin) / 1.0e6);
+
+    begin = bench_seconds();
+    for (u32 n = 0; n < iterations; ++n)
+        harmony_random_unit_vec3s(&rng, vecs, count);
+    printf("%12s %12.2f\n", "unit vec3", (f64)(count * iterations) / (bench_seconds() - begin) / 1.0e6);
+
+    free(vecs);
+    free(dst);
+}
+
+// results are accumulated here so the compiler cannot remove the work
+static volatile u64 bench_sink;
+
+static u32 bench_crc32_table[256];
+
+static void bench_crc32_init(void) {
+    for (u32 i = 0; i < 256; ++i) {
+        u32 crc = i;
+        for (u32 j = 0; j < 8; ++j)
+            crc = (crc >> 1) ^ (0xedb88320u & (0u - (crc & 1)));
+        bench_crc32_table[i] = crc;
+    }
+}
+
+static u32 bench_crc32(const u8 *data, usize size) {
+    u32 crc = 0xffffffffu;
+    for (usize i = 0; i < size; ++i)
+        crc = (crc >> 8) ^ bench_crc32_table[(crc ^ data[i]) & 0xff];
+    return ~crc;
+}
+
+static void bench_hash(void) {
+    usize max_size = (usize)64 << 20;
+    u8 *data = malloc(max_size);
+    for (usize i = 0; i < max_size; ++i)
+        data[i] = (u8)rand();
+    bench_crc32_init();
+    HarmonyCpuTier best = harmony_cpu_best_tier();
+
+    static const usize sizes[] = {8, 16, 32, 64, 256, 1 << 10, 1 << 12, 1 << 16, 1 << 20, 1 << 24, 1 << 26};
+    printf("hash GB/s\n");
+    printf("%10s %12s %12s %12s %12s\n", "size", "crc32", "scalar", "hash", "streaming");
+    for (u32 n = 0; n < harmony_countof(sizes); ++n) {
+        usize size = sizes[n];
+        usize iterations = harmony_max(((usize)1 << 28) / size, (usize)2);
+        // keys are offset each iteration so hashes of short keys are not hoisted
+        usize offsets = harmony_min(max_size - size + 1, (usize)4096);
+        f64 results[4];
+
+        f64 begin = bench_seconds();
+        for (usize i = 0; i < iterations; ++i)
+            bench_sink += bench_crc32(data + i % offsets, size);
+        results[0] = (f64)(size * iterations) / (bench_seconds() - begin) / 1.0e9;
+
+        harmony_kernels_select(HARMONY_CPU_TIER_SCALAR);
+        begin = bench_seconds();
+        for (usize i = 0; i < iterations; ++i)
+            bench_sink += harmony_hash(data + i % offsets, size);
+        results[1] = (f64)(size * iterations) / (bench_seconds() - begin) / 1.0e9;
+        harmony_kernels_select(best);
+
+        begin = bench_seconds();
+        for (usize i = 0; i < iterations; ++i)
+            bench_sink += harmony_hash(data + i % offsets, size);
+        results[2] = (f64)(size * iterations) / (bench_seconds() - begin) / 1.0e9;
+
+        HarmonyHashState state;
+        begin = bench_seconds();
+        for (usize i = 0; i < iterations; ++i) {
+            harmony_hash_init(&state, 0);
+            harmony_hash_update(&state, data + i % offsets, size);
+            bench_sink += harmony_hash_final(&state);
+        }
+        results[3] = (f64)(size * iterations) / (bench_seconds() - begin) / 1.0e9;
+
+        printf("%10zu %12.2f %12.2f %12.2f %12.2f\n", size, results[0], results[1], results[2], results[3]);
+    }
+
+    free(data);
+}
+
+static void bench_noise(u32 thread_count) {
+    usize count = 1u << 20;
+    f32 *dst = malloc(count * sizeof(*dst));
+    HarmonyNoise noise;
+    harmony_noise_seed(&noise, 1);
+    HarmonyCpuTier best = harmony_cpu_best_tier();
+
+    printf("noise, millions of samples/s (1 octave, %u threads)\n", thread_count);
+    printf("%12s %12s %12s %12s %12s\n", "noise", "single", "scalar", "fill", "parallel");
+    for (u32 dimensions = 2; dimensions <= 4; ++dimensions) {
+        for (u32 type = HARMONY_NOISE_PERLIN; type <= HARMONY_NOISE_SIMPLEX; ++type) {
+            HarmonyNoiseConfig config = {dimensions, (HarmonyNoiseType)type, HARMONY_NOISE_FBM, 1, 0.05f, 2.0f, 0.5f};
+            HarmonyNoiseRegion region = {{0.0f, 0.0f, 0.0f, 0.0f}, {1.0f, 1.0f, 1.0f}, 1024, 1024, 1};
+            if (dimensions > 2)
+                region = (HarmonyNoiseRegion){{0.0f, 0.0f, 0.0f, 0.0f}, {1.0f, 1.0f, 1.0f}, 128, 128, 64};
+            f64 results[4];
+
+            f64 begin = bench_seconds();
+            for (usize i = 0; i < count; ++i) {
+                f32 x = (f32)(i % region.width) * config.frequency;
+                f32 y = (f32)(i / region.width % region.height) * config.frequency;
+                f32 z = (f32)(i / region.width / region.height) * config.frequency;
+                u32 seed = noise.seeds[0];
+                switch (dimensions * 2 + type) {
+                    case 4: dst[i] = harmony_perlin_2d(seed, x, y); break;
+                    case 5: dst[i] = harmony_simplex_2d(seed, x, y); break;
+                    case 6: dst[i] = harmony_perlin_3d(seed, x, y, z); break;
+                    case 7: dst[i] = harmony_simplex_3d(seed, x, y, z); break;
+                    case 8: dst[i] = harmony_perlin_4d(seed, x, y, z, 0.0f); break;
+                    default: dst[i] = harmony_simplex_4d(seed, x, y, z, 0.0f); break;
+                }
+            }
+            results[0] = (f64)count / (bench_seconds() - begin) / 1.0e6;
+
+            harmony_kernels_select(HARMONY_CPU_TIER_SCALAR);
+            begin = bench_seconds();
+            harmony_noise_fill(dst, &noise, &config, &region);
+            results[1] = (f64)count / (bench_seconds() - begin) / 1.0e6;
+            harmony_kernels_select(best);
+
+            begin = bench_seconds();
+            harmony_noise_fill(dst, &noise, &config, &region);
+            results[2] = (f64)count / (bench_seconds() - begin) / 1.0e6;
+
+            begin = bench_seconds();
+            harmony_noise_fill_parallel(thread_count, dst, &noise, &config, &region);
+            results[3] = (f64)count / (bench_seconds() - begin) / 1.0e6;
+
+            char name[16];
+            snprintf(name, sizeof(name), "%s %uD", type == HARMONY_NOISE_PERLIN ? "perlin" : "simplex", dimensions);
+            printf("%12s %12.2f %12.2f %12.2f %12.2f\n", name, results[0], results[1], results[2], results[3]);
+        }
+    }
+
+    free(dst);
+}
+
+static void bench_fft(void) {
+    HarmonyAllocator allocator = harmony_default_allocator();
+    usize max_size = 65536;
+    Complex *src = malloc(max_size * sizeof(*src));
+    Complex *dst = malloc((max_size + 1) * sizeof(*dst));
+    f32 *real = malloc(max_size * sizeof(*real));
+    for (usize i = 0; i < max_size; ++i) {
+        src[i] = (Complex){bench_random_f32(), bench_random_f32()};
+        real[i] = bench_random_f32();
+    }
+    HarmonyCpuTier best = harmony_cpu_best_tier();
+
+    printf("fft, nanoseconds per transform\n");
+    printf("%12s %12s %12s %12s %12s\n", "size", "scalar", "complex", "real", "inverse");
+    for (usize size = 64; size <= max_size; size *= 4) {
+        usize repeats = (usize)(1u << 24) / size;
+        HarmonyFftPlan plan = harmony_fft_plan_create(&allocator, size);
+        HarmonyFftPlan real_plan = harmony_fft_real_plan_create(&allocator, size);
+        f64 results[4];
+
+        harmony_kernels_select(HARMONY_CPU_TIER_SCALAR);
+        f64 begin = bench_seconds();
+        for (usize r = 0; r < repeats; ++r) {
+            harmony_fft(&plan, dst, src);
+        }
+        results[0] = (bench_seconds() - begin) / (f64)repeats * 1.0e9;
+        harmony_kernels_select(best);
+
+        begin = bench_seconds();
+        for (usize r = 0; r < repeats; ++r) {
+            harmony_fft(&plan, dst, src);
+        }
+        results[1] = (bench_seconds() - begin) / (f64)repeats * 1.0e9;
+
+        begin = bench_seconds();
+        for (usize r = 0; r < repeats; ++r) {
+            harmony_fft_real(&real_plan, dst, real);
+        }
+        results[2] = (bench_seconds() - begin) / (f64)repeats * 1.0e9;
+
+        begin = bench_seconds();
+        for (usize r = 0; r < repeats; ++r) {
+            harmony_fft_inverse(&plan, dst, src);
+        }
+        results[3] = (bench_seconds() - begin) / (f64)repeats * 1.0e9;
+        bench_sink += (u64)dst[size / 2].r;
+
+        printf("%12zu %12.0f %12.0f %12.0f %12.0f\n", size, results[0], results[1], results[2], results[3]);
+        harmony_fft_plan_destroy(&allocator, &real_plan);
+        harmony_fft_plan_destroy(&allocator, &plan);
+    }
+
+    free(real);
+    free(dst);
+    free(src);
+}
+
+static void bench_approx(void) {
+    usize count = 1u << 20;
+    f32 *x = malloc(count * sizeof(*x));
+    f32 *y = malloc(count * sizeof(*y));
+    f32 *dst = malloc(count * sizeof(*dst));
+    f32 *dst2 = malloc(count * sizeof(*dst2));
+    for (usize i = 0; i < count; ++i) {
+        x[i] = bench_random_f32() * 100.0f;
+        y[i] = bench_random_f32() * 100.0f + 100.5f;
+    }
+    HarmonyCpuTier best = harmony_cpu_best_tier();
+    const char *names[] = {"sincos", "exp2", "log2", "atan2", "rsqrt"};
+
+    printf("approximate math, millions of values/s\n");
+    printf("%12s %12s %12s %12s\n", "function", "libm", "scalar", "approx");
+    for (u32 function = HARMONY_APPROX_SINCOS; function <= HARMONY_APPROX_RSQRT; ++function) {
+        f64 results[3];
+
+        f64 begin = bench_seconds();
+        for (usize i = 0; i < count; ++i) {
+            switch (function) {
+                case HARMONY_APPROX_SINCOS: dst[i] = sinf(x[i]); dst2[i] = cosf(x[i]); break;
+                case HARMONY_APPROX_EXP2: dst[i] = exp2f(x[i]); break;
+                case HARMONY_APPROX_LOG2: dst[i] = log2f(y[i]); break;
+                case HARMONY_APPROX_ATAN2: dst[i] = atan2f(x[i], y[i]); break;
+                default: dst[i] = 1.0f / sqrtf(y[i]); break;
+            }
+        }
+        results[0] = (f64)count / (bench_seconds() - begin) / 1.0e6;
+
+        for (u32 pass = 0; pass < 2; ++pass) {
+            harmony_kernels_select(pass == 0 ? HARMONY_CPU_TIER_SCALAR : best);
+            begin = bench_seconds();
+            switch (function) {
+                case HARMONY_APPROX_SINCOS: harmony_approx_sincos(dst, dst2, x, count); break;
+                case HARMONY_APPROX_EXP2: harmony_approx_exp2(dst, x, count); break;
+                case HARMONY_APPROX_LOG2: harmony_approx_log2(dst, y, count); break;
+                case HARMONY_APPROX_ATAN2: harmony_approx_atan2(dst, x, y, count); break;
+                default: harmony_approx_rsqrt(dst, y, count); break;
+            }
+            results[1 + pass] = (f64)count / (bench_seconds() - begin) / 1.0e6;
+        }
+        bench_sink += (u64)dst[count / 2];
+
+        printf("%12s %12.2f %12.2f %12.2f\n", names[function], results[0], results[1], results[2]);
+    }
+
+    free(dst2);
+    free(dst);
+    free(y);
+    free(x);
+}
+
+static void bench_quats(void) {
+    usize count = 1u << 16;
+    f32 *streams = malloc(17 * count * sizeof(*streams));
+    HarmonyQuatStreams lhs, rhs, dst;
+    for (u32 c = 0; c < 4; ++c) {
+        lhs.components[c] = streams + c * count;
+        rhs.components[c] = streams + (4 + c) * count;
+        dst.components[c] = streams + (8 + c) * count;
+    }
+    f32 *t = streams + 12 * count;
+    for (usize i = 0; i < 13 * count; ++i) {
+        streams[i] = bench_random_f32();
+    }
+    harmony_quats_normalize(&lhs, &lhs, count);
+    harmony_quats_normalize(&rhs, &rhs, count);
+    HarmonyModelStreams3D models;
+    for (u32 c = 0; c < 3; ++c) {
+        models.position[c] = streams + (13 + c) * count;
+        models.scale[c] = t;
+    }
+    for (u32 c = 0; c < 4; ++c) {
+        models.rotation[c] = lhs.components[c];
+    }
+    Affine3 *affines = malloc(count * sizeof(*affines));
+    Mat3 *rotations = malloc(count * sizeof(*rotations));
+    HarmonyCpuTier best = harmony_cpu_best_tier();
+    const char *names[] = {"normalize", "nlerp", "slerp", "to mat3", "affines"};
+    u32 repeats = 64;
+
+    printf("quaternions, millions of joints/s\n");
+    printf("%12s %12s %12s\n", "kernel", "scalar", "batch");
+    for (u32 kernel = 0; kernel < 5; ++kernel) {
+        f64 results[2];
+        for (u32 pass = 0; pass < 2; ++pass) {
+            harmony_kernels_select(pass == 0 ? HARMONY_CPU_TIER_SCALAR : best);
+            f64 begin = bench_seconds();
+            for (u32 r = 0; r < repeats; ++r) {
+                switch (kernel) {
+                    case 0: harmony_quats_normalize(&dst, &lhs, count); break;
+                    case 1: harmony_quats_nlerp(&dst, &lhs, &rhs, t, count); break;
+                    case 2: harmony_quats_slerp(&dst, &lhs, &rhs, t, count); break;
+                    case 3: harmony_quats_to_mat3(rotations, &lhs, count); break;
+                    default: harmony_model_affines_3d(affines, &models, count); break;
+                }
+            }
+            results[pass] = (f64)count * repeats / (bench_seconds() - begin) / 1.0e6;
+        }
+        bench_sink += (u64)(dst.components[0][count / 2] + rotations[count / 2].x.x + affines[count / 2].w.x);
+
+        printf("%12s %12.2f %12.2f\n", names[kernel], results[0], results[1]);
+    }
+
+    free(rotations);
+    free(affines);
+    free(streams);
+}
+
+/**
+ * Samples one channel of uncompressed keys with a binary search, as ad hoc
+ * code would
+ */
+static void bench_animation_naive(f32 *dst, const HarmonyAnimationKeys *keys, u32 components, f32 time) {
+    const f32 *values = keys->values;
+    u32 low = 0;
+    u32 high = keys->count;
+    while (high - low > 1) {
+        u32 mid = (low + high) / 2;
+        if (keys->times[mid] <= time)
+            low = mid;
+        else
+            high = mid;
+    }
+    u32 next = low + 1 < keys->count ? low + 1 : low;
+    f32 alpha = next != low ? harmony_clamp((time - keys->times[low]) / (keys->times[next] - keys->times[low]), 0.0f, 1.0f) : 0.0f;
+    f32 len2 = 0.0f;
+    for (u32 c = 0; c < components; ++c) {
+        dst[c] = values[low * components + c] + (values[next * components + c] - values[low * components + c]) * alpha;
+        len2 += dst[c] * dst[c];
+    }
+    for (u32 c = 0; components == 4 && c < 4; ++c) {
+        dst[c] /= sqrtf(len2);
+    }
+}
+
+static void bench_animation(u32 thread_count) {
+    HarmonyAllocator allocator = harmony_default_allocator();
+    u32 joint_count = 80;
+    u32 key_count = 60;
+    u32 instance_count = 1000;
+    u32 frame_count = 120;
+
+    f32 *times = malloc(key_count * sizeof(*times));
+    for (u32 k = 0; k < key_count; ++k) {
+        times[k] = (f32)k / 30.0f;
+    }
+    f32 *values = malloc(joint_count * HARMONY_ANIMATION_CHANNEL_COUNT * key_count * 4 * sizeof(*values));
+    HarmonyAnimationTrack *tracks = malloc(joint_count * sizeof(*tracks));
+    for (u32 joint = 0; joint < joint_count; ++joint) {
+        for (u32 channel = 0; channel < HARMONY_ANIMATION_CHANNEL_COUNT; ++channel) {
+            u32 components = channel == HARMONY_ANIMATION_ROTATION ? 4 : 3;
+            f32 *channel_values = values + (joint * HARMONY_ANIMATION_CHANNEL_COUNT + channel) * key_count * 4;
+            for (u32 i = 0; i < key_count * components; ++i) {
+                channel_values[i] = bench_random_f32();
+            }
+            tracks[joint].channels[channel] = (HarmonyAnimationKeys){times, channel_values, key_count};
+        }
+    }
+    HarmonyAnimationClip clip = harmony_animation_clip_create(&allocator, tracks, joint_count);
+
+    u32 *cursors = calloc((usize)instance_count * harmony_animation_cursor_count(&clip), sizeof(*cursors));
+    f32 *offsets = malloc(instance_count * sizeof(*offsets));
+    f32 *sample_times = malloc(instance_count * sizeof(*sample_times));
+    f32 *weights = malloc((usize)instance_count * joint_count * sizeof(*weights));
+    usize pose_count = (usize)instance_count * joint_count;
+    HarmonyPose poses[2];
+    for (u32 i = 0; i < 2; ++i) {
+        poses[i] = (HarmonyPose){
+            malloc(pose_count * sizeof(Vec3)),
+            malloc(pose_count * sizeof(Quat)),
+            malloc(pose_count * sizeof(Vec3)),
+        };
+    }
+    for (u32 i = 0; i < instance_count; ++i) {
+        offsets[i] = (bench_random_f32() + 1.0f) * 0.5f;
+    }
+    for (usize i = 0; i < pose_count; ++i) {
+        weights[i] = 0.5f;
+    }
+    f64 joints = (f64)pose_count * frame_count;
+    f64 results[4];
+
+    f64 begin = bench_seconds();
+    for (u32 frame = 0; frame < frame_count; ++frame) {
+        for (u32 i = 0; i < instance_count; ++i) {
+            f32 time = fmodf(offsets[i] + (f32)frame / 60.0f, clip.duration);
+            for (u32 joint = 0; joint < joint_count; ++joint) {
+                usize index = (usize)i * joint_count + joint;
+                bench_animation_naive((f32 *)&poses[0].translations[index], &tracks[joint].channels[0], 3, time);
+                bench_animation_naive((f32 *)&poses[0].rotations[index], &tracks[joint].channels[1], 4, time);
+                bench_animation_naive((f32 *)&poses[0].scales[index], &tracks[joint].channels[2], 3, time);
+            }
+        }
+    }
+    results[0] = joints / ((bench_seconds() - begin) * 1.0e3);
+
+    begin = bench_seconds();
+    for (u32 frame = 0; frame < frame_count; ++frame) {
+        for (u32 i = 0; i < instance_count; ++i) {
+            sample_times[i] = fmodf(offsets[i] + (f32)frame / 60.0f, clip.duration);
+        }
+        harmony_animation_sample(&clip, cursors, sample_times, &poses[0], instance_count);
+    }
+    results[1] = joints / ((bench_seconds() - begin) * 1.0e3);
+
+    begin = bench_seconds();
+    for (u32 frame = 0; frame < frame_count; ++frame) {
+        for (u32 i = 0; i < instance_count; ++i) {
+            sample_times[i] = fmodf(offsets[i] + (f32)frame / 60.0f, clip.duration);
+        }
+        harmony_animation_sample_parallel(thread_count, &clip, cursors, sample_times, &poses[0], instance_count);
+    }
+    results[2] = joints / ((bench_seconds() - begin) * 1.0e3);
+
+    harmony_animation_sample(&clip, cursors, sample_times, &poses[1], instance_count);
+    begin = bench_seconds();
+    for (u32 frame = 0; frame < frame_count; ++frame) {
+        harmony_pose_blend(&poses[0], &poses[0], &poses[1], weights, pose_count);
+    }
+    results[3] = joints / ((bench_seconds() - begin) * 1.0e3);
+    bench_sink += (u64)poses[0].rotations[pose_count / 2].r;
+
+    printf("animation, thousands of joints/ms (%u instances of %u joints, %u threads)\n", instance_count, joint_count, thread_count);
+    printf("%12s %12s %12s %12s\n", "naive", "cursors", "parallel", "blend");
+    printf("%12.2f %12.2f %12.2f %12.2f\n", results[0] / 1.0e3, results[1] / 1.0e3, results[2] / 1.0e3, results[3] / 1.0e3);
+
+    for (u32 i = 0; i < 2; ++i) {
+        free(poses[i].scales);
+        free(poses[i].rotations);
+        free(poses[i].translations);
+    }
+    free(weights);
+    free(sample_times);
+    free(offsets);
+    free(cursors);
+    harmony_animation_clip_destroy(&allocator, &clip);
+    free(tracks);
+    free(values);
+    free(times);
+}
+
+static void bench_transforms(u32 thread_count) {
+    HarmonyAllocator allocator = harmony_default_allocator();
+    u32 count = 100000;
+    u32 frame_count = 100;
+    HarmonyTransformHierarchy hierarchy = harmony_transform_hierarchy_create(&allocator, count);
+    u32 *parents = malloc(count * sizeof(*parents));
+    Vec3 *positions = malloc(count * sizeof(*positions));
+    Quat *rotations = malloc(count * sizeof(*rotations));
+    Affine3 *worlds = malloc(count * sizeof(*worlds));
+    Vec3 scale = {1.0f, 1.0f, 1.0f};
+    for (u32 handle = 0; handle < count; ++handle) {
+        // a hundred roots, each a tree with about eight children per node
+        parents[handle] = handle < 100 ? HARMONY_TRANSFORM_NONE : (handle - 100) / 8;
+        positions[handle] = (Vec3){bench_random_f32(), bench_random_f32(), bench_random_f32()};
+        rotations[handle] = axis_angle((Vec3){0.0f, 1.0f, 0.0f}, bench_random_f32());
+        harmony_transform_add(&hierarchy, parents[handle], positions[handle], scale, rotations[handle]);
+    }
+    f64 nodes = (f64)count * frame_count;
+    f64 results[4];
+    u32 updated = 0;
+
+    f64 begin = bench_seconds();
+    for (u32 frame = 0; frame < frame_count; ++frame) {
+        for (u32 handle = 0; handle < count; ++handle) {
+            Affine3 local = harmony_model_affine_3d(positions[handle], scale, rotations[handle]);
+            worlds[handle] = parents[handle] == HARMONY_TRANSFORM_NONE ? local : acompose(worlds[parents[handle]], local);
+        }
+    }
+    results[0] = nodes / ((bench_seconds() - begin) * 1.0e3);
+    bench_sink += (u64)worlds[count - 1].w.x;
+
+    begin = bench_seconds();
+    for (u32 frame = 0; frame < frame_count; ++frame) {
+        for (u32 root = 0; root < 100; ++root) {
+            harmony_transform_set(&hierarchy, root, positions[root], scale, rotations[root]);
+        }
+        updated = harmony_transform_update(&hierarchy);
+    }
+    results[1] = nodes / ((bench_seconds() - begin) * 1.0e3);
+
+    begin = bench_seconds();
+    for (u32 frame = 0; frame < frame_count; ++frame) {
+        for (u32 root = 0; root < 100; ++root) {
+            harmony_transform_set(&hierarchy, root, positions[root], scale, rotations[root]);
+        }
+        updated = harmony_transform_update_parallel(thread_count, &hierarchy);
+    }
+    results[2] = nodes / ((bench_seconds() - begin) * 1.0e3);
+
+    // a tenth of the roots move each frame
+    begin = bench_seconds();
+    for (u32 frame = 0; frame < frame_count; ++frame) {
+        for (u32 root = frame % 10; root < 100; root += 10) {
+            harmony_transform_set(&hierarchy, root, positions[root], scale, rotations[root]);
+        }
+        updated = harmony_transform_update(&hierarchy);
+    }
+    results[3] = nodes / ((bench_seconds() - begin) * 1.0e3);
+    bench_sink += (u64)harmony_transform_world(&hierarchy, count - 1).w.x;
+
+    printf("transforms, thousands of nodes/ms (%u nodes, %u threads, %u updated when a tenth moves)\n", count, thread_count, updated);
+    printf("%12s %12s %12s %12s\n", "naive", "all dirty", "parallel", "tenth dirty");
+    printf("%12.2f %12.2f %12.2f %12.2f\n", results[0] / 1.0e3, results[1] / 1.0e3, results[2] / 1.0e3, results[3] / 1.0e3);
+
+    free(worlds);
+    free(rotations);
+    free(positions);
+    free(parents);
+    harmony_transform_hierarchy_destroy(&allocator, &hierarchy);
+}
+
+static void bench_culling(u32 thread_count) {
+    usize count = 1u << 20;
+    usize words = (count + 31) / 32;
+    f32 *bounds = malloc(10 * count * sizeof(*bounds));
+    for (usize i = 0; i < count; ++i) {
+        for (u32 c = 0; c < 3; ++c) {
+            f32 center = bench_random_f32() * 100.0f;
+            f32 extent = bench_random_f32() * 0.5f + 1.0f;
+            bounds[c * count + i] = center - extent;
+            bounds[(3 + c) * count + i] = center + extent;
+            bounds[(6 + c) * count + i] = center;
+        }
+        bounds[9 * count + i] = bench_random_f32() * 0.5f + 1.0f;
+    }
+    HarmonyAabbStreams aabbs = {
+        {bounds, bounds + count, bounds + 2 * count},
+        {bounds + 3 * count, bounds + 4 * count, bounds + 5 * count},
+    };
+    HarmonySphereStreams spheres = {{bounds + 6 * count, bounds + 7 * count, bounds + 8 * count}, bounds + 9 * count};
+    HarmonyFrustum frustum = harmony_frustum_create(harmony_perspective_projection(1.2f, 1.5f, 0.1f, 80.0f));
+    u32 *visible = malloc(words * sizeof(*visible));
+    u32 *indices = malloc(count * sizeof(*indices));
+    HarmonyCpuTier best = harmony_cpu_best_tier();
+    const char *names[] = {"aabbs", "spheres"};
+    u32 repeats = 20;
+    usize visible_count = 0;
+
+    printf("frustum culling, ms per %zu objects (%u threads)\n", count, thread_count);
+    printf("%12s %12s %12s %12s %12s\n", "shape", "scalar", "batch", "parallel", "indices");
+    for (u32 shape = 0; shape < 2; ++shape) {
+        f64 results[4];
+        for (u32 pass = 0; pass < 3; ++pass) {
+            harmony_kernels_select(pass == 0 ? HARMONY_CPU_TIER_SCALAR : best);
+            f64 begin = bench_seconds();
+            for (u32 r = 0; r < repeats; ++r) {
+                if (shape == 0 && pass < 2)
+                    harmony_cull_aabbs(visible, &frustum, &aabbs, count);
+                else if (shape == 0)
+                    harmony_cull_aabbs_parallel(thread_count, visible, &frustum, &aabbs, count);
+                else if (pass < 2)
+                    harmony_cull_spheres(visible, &frustum, &spheres, count);
+                else
+                    harmony_cull_spheres_parallel(thread_count, visible, &frustum, &spheres, count);
+            }
+            results[pass] = (bench_seconds() - begin) * 1.0e3 / repeats;
+        }
+        f64 begin = bench_seconds();
+        for (u32 r = 0; r < repeats; ++r) {
+            visible_count = harmony_visible_indices(indices, visible, count);
+        }
+        results[3] = (bench_seconds() - begin) * 1.0e3 / repeats;
+        bench_sink += visible_count;
+
+        printf("%12s %12.3f %12.3f %12.3f %12.3f\n", names[shape], results[0], results[1], results[2], results[3]);
+    }
+    printf("%zu of %zu visible\n", visible_count, count);
+
+    free(indices);
+    free(visible);
+    free(bounds);
+}
+
+static void bench_bvh(u32 thread_count) {
+    HarmonyAllocator allocator = harmony_default_allocator();
+    u32 grid = 708;
+    u32 count = 2 * grid * grid;
+    Vec3 *vertices = malloc((usize)(grid + 1) * (grid + 1) * sizeof(*vertices));
+    u32 *indices = malloc(3 * (usize)count * sizeof(*indices));
+    f32 *streams = malloc(6 * (usize)count * sizeof(*streams));
+    for (u32 z = 0; z <= grid; ++z) {
+        for (u32 x = 0; x <= grid; ++x) {
+            f32 height = sinf((f32)x * 0.05f) * cosf((f32)z * 0.03f) * 8.0f + bench_random_f32() * 0.2f;
+            vertices[z * (grid + 1) + x] = (Vec3){(f32)x, height, (f32)z};
+        }
+    }
+    for (u32 z = 0, t = 0; z < grid; ++z) {
+        for (u32 x = 0; x < grid; ++x, t += 2) {
+            u32 corner = z * (grid + 1) + x;
+            u32 quad[6] = {corner, corner + 1, corner + grid + 1, corner + 1, corner + grid + 2, corner + grid + 1};
+            memcpy(indices + 3 * (usize)t, quad, sizeof(quad));
+        }
+    }
+    HarmonyAabbStreams bounds;
+    for (u32 axis = 0; axis < 3; ++axis) {
+        bounds.min[axis] = streams + axis * (usize)count;
+        bounds.max[axis] = streams + (3 + axis) * (usize)count;
+    }
+    harmony_triangle_bounds(&bounds, vertices, indices, count);
+
+    f64 begin = bench_seconds();
+    HarmonyBvh bvh = harmony_bvh_create(&allocator, &bounds, count);
+    f64 build = (bench_seconds() - begin) * 1.0e3;
+    harmony_bvh_destroy(&allocator, &bvh);
+    begin = bench_seconds();
+    bvh = harmony_bvh_create_parallel(thread_count, &allocator, &bounds, count);
+    f64 build_parallel = (bench_seconds() - begin) * 1.0e3;
+
+    u32 ray_count = 1u << 18;
+    Vec3 *origins = malloc(ray_count * sizeof(*origins));
+    Vec3 *directions = malloc(ray_count * sizeof(*directions));
+    // a camera's rays in scanline order, looking down across the terrain
+    u32 width = 512;
+    for (u32 i = 0; i < ray_count; ++i) {
+        f32 u = (f32)(i % width) / (f32)width - 0.5f;
+        f32 v = (f32)(i / width) / (f32)(ray_count / width) - 0.5f;
+        origins[i] = (Vec3){(f32)grid * 0.5f, 40.0f, -20.0f};
+        directions[i] = (Vec3){u, -0.4f + v * 0.5f, 1.0f};
+    }
+    HarmonyRayHit hit;
+    u32 hits = 0;
+    begin = bench_seconds();
+    for (u32 i = 0; i < ray_count; ++i) {
+        hits += harmony_bvh_ray_triangles(&bvh, vertices, indices, origins[i], directions[i], INFINITY, &hit);
+    }
+    f64 closest = ray_count / (bench_seconds() - begin) / 1.0e6;
+
+    // line of sight from the camera to points on a plane through the hills
+    u32 occluded = 0;
+    begin = bench_seconds();
+    for (u32 i = 0; i < ray_count; ++i) {
+        Vec3 target = {(f32)(i % width) / (f32)width * (f32)grid, 2.0f, (f32)(i / width) / (f32)(ray_count / width) * (f32)grid};
+        Vec3 direction = vsub3(target, origins[i]);
+        occluded += harmony_bvh_ray_triangles_any(&bvh, vertices, indices, origins[i], direction, 1.0f);
+    }
+    f64 any = ray_count / (bench_seconds() - begin) / 1.0e6;
+
+    u32 brute_count = 8;
+    begin = bench_seconds();
+    for (u32 i = 0; i < brute_count; ++i) {
+        HarmonyRayHit best = {INFINITY, 0.0f, 0.0f, UINT32_MAX};
+        for (u32 t = 0; t < count; ++t) {
+            const u32 *triangle = indices + 3 * (usize)t;
+            harmony_ray_triangle(origins[i], directions[i],
+                vertices[triangle[0]], vertices[triangle[1]], vertices[triangle[2]], best.distance, &best);
+        }
+        bench_sink += (u64)best.distance;
+    }
+    f64 brute = brute_count / (bench_seconds() - begin) / 1.0e6;
+    bench_sink += hits + occluded;
+
+    printf("bvh, %u triangles, %u nodes, build %.1f ms, parallel build %.1f ms (%u threads)\n",
+        count, bvh.node_count, build, build_parallel, thread_count);
+    printf("%12s %12s %12s\n", "brute", "closest", "any");
+    printf("%12.6f %12.3f %12.3f  millions of rays/s (%u hits, %u occluded)\n", brute, closest, any, hits, occluded);
+
+    harmony_bvh_destroy(&allocator, &bvh);
+    free(directions);
+    free(origins);
+    free(streams);
+    free(indices);
+    free(vertices);
+}
+
+static void bench_rays(void) {
+    usize ray_count = 4096;
+    usize primitive_count = 256;
+    f32 *ray_data = malloc(6 * ray_count * sizeof(*ray_data));
+    f32 *primitive_data = malloc(9 * primitive_count * sizeof(*primitive_data));
+    f32 *hit_data = malloc(3 * ray_count * sizeof(*hit_data));
+    u32 *hit_indices = malloc(ray_count * sizeof(*hit_indices));
+    HarmonyRayStreams rays;
+    HarmonyTriangleStreams triangles;
+    HarmonyAabbStreams boxes;
+    for (u32 c = 0; c < 3; ++c) {
+        rays.origin[c] = ray_data + c * ray_count;
+        rays.direction[c] = ray_data + (3 + c) * ray_count;
+        triangles.a[c] = primitive_data + c * primitive_count;
+        triangles.b[c] = primitive_data + (3 + c) * primitive_count;
+        triangles.c[c] = primitive_data + (6 + c) * primitive_count;
+        boxes.min[c] = triangles.a[c];
+        boxes.max[c] = triangles.b[c];
+    }
+    HarmonyRayHitStreams hits = {hit_data, hit_data + ray_count, hit_data + 2 * ray_count, hit_indices};
+    // coherent rays from one eye through a screen, like a primary ray packet
+    for (usize i = 0; i < ray_count; ++i) {
+        Vec3 target = {(f32)(i % 64) / 32.0f - 1.0f, (f32)(i / 64) / 32.0f - 1.0f, 4.0f};
+        for (u32 c = 0; c < 3; ++c) {
+            rays.origin[c][i] = 0.0f;
+            rays.direction[c][i] = ((f32 *)&target)[c];
+        }
+    }
+    for (usize i = 0; i < primitive_count; ++i) {
+        for (u32 c = 0; c < 3; ++c) {
+            f32 center = c == 2 ? bench_random_f32() * 8.0f + 12.0f : bench_random_f32() * 6.0f;
+            triangles.a[c][i] = center - 0.5f;
+            triangles.b[c][i] = center + bench_random_f32() * 0.5f + 0.5f;
+            triangles.c[c][i] = center + bench_random_f32() * 0.5f;
+        }
+    }
+    HarmonyCpuTier best = harmony_cpu_best_tier();
+    const char *names[] = {"moller", "watertight", "aabb"};
+    u32 repeats = 4;
+    u32 hit_count = 0;
+
+    printf("ray packets, million ray-primitive tests per second (%zu rays x %zu primitives)\n", ray_count, primitive_count);
+    printf("%12s %12s %12s\n", "test", "scalar", "batch");
+    for (u32 test = HARMONY_RAY_TRIANGLE; test <= HARMONY_RAY_AABB; ++test) {
+        f64 results[2];
+        for (u32 pass = 0; pass < 2; ++pass) {
+            harmony_kernels_select(pass == 0 ? HARMONY_CPU_TIER_SCALAR : best);
+            f64 begin = bench_seconds();
+            for (u32 r = 0; r < repeats; ++r) {
+                for (usize i = 0; i < ray_count; ++i) {
+                    hits.distance[i] = INFINITY;
+                    hits.index[i] = UINT32_MAX;
+                }
+                if (test == HARMONY_RAY_TRIANGLE)
+                    harmony_rays_triangles(&hits, &rays, ray_count, &triangles, primitive_count);
+                else if (test == HARMONY_RAY_TRIANGLE_WATERTIGHT)
+                    harmony_rays_triangles_watertight(&hits, &rays, ray_count, &triangles, primitive_count);
+                else
+                    harmony_rays_aabbs(&hits, &rays, ray_count, &boxes, primitive_count);
+            }
+            results[pass] = (f64)(ray_count * primitive_count * repeats) / (bench_seconds() - begin) * 1.0e-6;
+        }
+        hit_count = 0;
+        for (usize i = 0; i < ray_count; ++i) {
+            hit_count += hits.index[i] != UINT32_MAX;
+        }
+        bench_sink += hit_count;
+
+        printf("%12s %12.1f %12.1f (%u hits)\n", names[test], results[0], results[1], hit_count);
+    }
+
+    free(hit_indices);
+    free(hit_data);
+    free(primitive_data);
+    free(ray_data);
+}
+
+static void bench_hash_grid(u32 thread_count) {
+    HarmonyAllocator allocator = harmony_default_allocator();
+    u32 count = 50000;
+    u32 pair_capacity = 1u << 20;
+    f32 radius = 1.0f;
+    f32 *position_data = malloc(3 * (usize)count * sizeof(*position_data));
+    HarmonyPair *pairs = malloc(pair_capacity * sizeof(*pairs));
+    HarmonyPointStreams points = {{position_data, position_data + count, position_data + 2 * count}};
+    for (u32 i = 0; i < 3 * count; ++i) {
+        position_data[i] = bench_random_f32() * 15.0f;
+    }
+    HarmonyHashGrid grid = harmony_hash_grid_create(&allocator, count, radius);
+    u32 repeats = 20;
+    u32 pair_count = 0;
+
+    f64 begin = bench_seconds();
+    for (u32 r = 0; r < repeats; ++r) {
+        harmony_hash_grid_build(&grid, &points, count);
+    }
+    f64 build = (bench_seconds() - begin) * 1.0e3 / repeats;
+
+    begin = bench_seconds();
+    for (u32 r = 0; r < repeats; ++r) {
+        pair_count = harmony_hash_grid_pairs(&grid, radius, pairs, pair_capacity);
+    }
+    f64 serial = (bench_seconds() - begin) * 1.0e3 / repeats;
+
+    begin = bench_seconds();
+    for (u32 r = 0; r < repeats; ++r) {
+        pair_count = harmony_hash_grid_pairs_parallel(thread_count, &grid, radius, pairs, pair_capacity);
+    }
+    f64 parallel = (bench_seconds() - begin) * 1.0e3 / repeats;
+
+    begin = bench_seconds();
+    u32 naive_count = 0;
+    for (u32 i = 0; i < count; ++i) {
+        for (u32 j = i + 1; j < count; ++j) {
+            f32 dx = points.position[0][j] - points.position[0][i];
+            f32 dy = points.position[1][j] - points.position[1][i];
+            f32 dz = points.position[2][j] - points.position[2][i];
+            if (dx * dx + dy * dy + dz * dz <= radius * radius) {
+                if (naive_count < pair_capacity)
+                    pairs[naive_count] = (HarmonyPair){i, j};
+                ++naive_count;
+            }
+        }
+    }
+    f64 naive = (bench_seconds() - begin) * 1.0e3;
+    bench_sink += naive_count;
+
+    printf("spatial hash grid, %u points, %u pairs within %.1f (%u threads)\n", count, pair_count, (f64)radius, thread_count);
+    printf("%12s %12s %12s\n", "method", "ms", "pairs/ms");
+    printf("%12s %12.3f %12s\n", "build", build, "");
+    printf("%12s %12.3f %12.0f\n", "naive", naive, naive_count / naive);
+    printf("%12s %12.3f %12.0f\n", "grid", serial, pair_count / serial);
+    printf("%12s %12.3f %12.0f\n", "parallel", parallel, pair_count / parallel);
+
+    harmony_hash_grid_destroy(&allocator, &grid);
+    free(pairs);
+    free(position_data);
+}
+
+static void bench_collision(u32 thread_count) {
+    HarmonyAllocator allocator = harmony_default_allocator();
+    u32 count = 20000;
+    u32 pair_capacity = 1u << 18;
+    Vec3 corners[8];
+    for (u32 i = 0; i < 8; ++i) {
+        corners[i] = (Vec3){i & 1 ? 0.4f : -0.4f, i & 2 ? 0.3f : -0.3f, i & 4 ? 0.5f : -0.5f};
+    }
+    HarmonyShape shapes[4] = {
+        {.type = HARMONY_SHAPE_SPHERE, .radius = 0.5f},
+        {.type = HARMONY_SHAPE_CAPSULE, .radius = 0.25f, .half_height = 0.25f},
+        {.type = HARMONY_SHAPE_BOX, .half_extents = {0.3f, 0.4f, 0.5f}},
+        {.type = HARMONY_SHAPE_HULL, .vertices = corners, .vertex_count = 8},
+    };
+    HarmonyCollider *colliders = malloc(count * sizeof(*colliders));
+    f32 *position_data = malloc(3 * (usize)count * sizeof(*position_data));
+    HarmonyPair *pairs = malloc(pair_capacity * sizeof(*pairs));
+    HarmonyManifold *manifolds = malloc(pair_capacity * sizeof(*manifolds));
+    HarmonyPointStreams points = {{position_data, position_data + count, position_data + 2 * count}};
+    for (u32 i = 0; i < count; ++i) {
+        Quat q = {bench_random_f32(), bench_random_f32(), bench_random_f32(), bench_random_f32() + 0.1f};
+        f32 length = sqrtf(q.r * q.r + q.i * q.i + q.j * q.j + q.k * q.k);
+        Vec3 position = {bench_random_f32() * 14.0f, bench_random_f32() * 14.0f, bench_random_f32() * 14.0f};
+        colliders[i] = (HarmonyCollider){&shapes[i % 4], position, {q.r / length, q.i / length, q.j / length, q.k / length}};
+        points.position[0][i] = position.x;
+        points.position[1][i] = position.y;
+        points.position[2][i] = position.z;
+    }
+
+    // every shape fits in a sphere of radius 0.71, so the broad phase
+    // pairs centers closer than twice that
+    HarmonyHashGrid grid = harmony_hash_grid_create(&allocator, count, 1.42f);
+    harmony_hash_grid_build(&grid, &points, count);
+    u32 pair_count = harmony_hash_grid_pairs(&grid, 1.42f, pairs, pair_capacity);
+    harmony_assert(pair_count <= pair_capacity);
+    u32 repeats = 10;
+    u32 touching = 0;
+
+    f64 begin = bench_seconds();
+    u32 intersecting = 0;
+    for (u32 r = 0; r < repeats; ++r) {
+        intersecting = 0;
+        for (u32 p = 0; p < pair_count; ++p) {
+            intersecting += harmony_gjk_intersect(&colliders[pairs[p].a], &colliders[pairs[p].b]);
+        }
+    }
+    f64 intersect = (bench_seconds() - begin) * 1.0e3 / repeats;
+    bench_sink += intersecting;
+
+    begin = bench_seconds();
+    for (u32 r = 0; r < repeats; ++r) {
+        touching = harmony_collide_pairs(manifolds, colliders, pairs, pair_count);
+    }
+    f64 serial = (bench_seconds() - begin) * 1.0e3 / repeats;
+
+    begin = bench_seconds();
+    for (u32 r = 0; r < repeats; ++r) {
+        touching = harmony_collide_pairs_parallel(thread_count, manifolds, colliders, pairs, pair_count);
+    }
+    f64 parallel = (bench_seconds() - begin) * 1.0e3 / repeats;
+
+    printf("narrow phase, %u candidate pairs, %u touching (%u threads)\n", pair_count, touching, thread_count);
+    printf("%12s %12s %12s\n", "method", "ms", "pairs/ms");
+    printf("%12s %12.3f %12.0f\n", "intersect", intersect, pair_count / intersect);
+    printf("%12s %12.3f %12.0f\n", "manifolds", serial, pair_count / serial);
+    printf("%12s %12.3f %12.0f\n", "parallel", parallel, pair_count / parallel);
+
+    harmony_hash_grid_destroy(&allocator, &grid);
+    free(manifolds);
+    free(pairs);
+    free(position_data);
+    free(colliders);
+}
+
+/**
+ * Runs boxes on a static floor for a number of frames, with the hash grid
+ * broad phase and contact manifolds found each frame, giving the mean
+ * milliseconds of the narrow phase and of the step
+ */
+static u32 bench_physics_scene(
+    u32 thread_count,
+    const Vec3 *positions,
+    u32 count,
+    u32 frames,
+    f64 *collide_ms,
+    f64 *step_ms
+) {
+    HarmonyAllocator allocator = harmony_default_allocator();
+    HarmonyShape floor_shape = {.type = HARMONY_SHAPE_BOX, .half_extents = {1000.0f, 1.0f, 1000.0f}};
+    HarmonyShape box = {.type = HARMONY_SHAPE_BOX, .half_extents = {0.5f, 0.5f, 0.5f}};
+    Quat identity = {1.0f, 0.0f, 0.0f, 0.0f};
+    u32 pair_capacity = 16 * count;
+    HarmonyPhysics physics = harmony_physics_create(&allocator, count + 1, 0, 4 * pair_capacity);
+    harmony_physics_add_body(&physics, (Vec3){0.0f, -1.0f, 0.0f}, identity, 0.0f, (Vec3){0.0f, 0.0f, 0.0f});
+    for (u32 i = 0; i < count; ++i) {
+        harmony_physics_add_body(&physics, positions[i], identity, 1.0f, harmony_box_inertia(1.0f, box.half_extents));
+    }
+    HarmonyCollider *colliders = malloc((count + 1) * sizeof(*colliders));
+    HarmonyPair *pairs = malloc(pair_capacity * sizeof(*pairs));
+    HarmonyManifold *manifolds = malloc(pair_capacity * sizeof(*manifolds));
+    // the grid holds the boxes only, the floor is paired with any box low
+    // enough to touch it
+    HarmonyBodyStreams *bodies = &physics.bodies;
+    HarmonyPointStreams points = {{bodies->position[0] + 1, bodies->position[1] + 1, bodies->position[2] + 1}};
+    HarmonyHashGrid grid = harmony_hash_grid_create(&allocator, count, 1.75f);
+
+    *collide_ms = 0.0;
+    *step_ms = 0.0;
+    for (u32 frame = 0; frame < frames; ++frame) {
+        f64 begin = bench_seconds();
+        for (u32 i = 0; i <= count; ++i) {
+            colliders[i] = (HarmonyCollider){
+                i == 0 ? &floor_shape : &box,
+                {bodies->position[0][i], bodies->position[1][i], bodies->position[2][i]},
+                {bodies->orientation[0][i], bodies->orientation[1][i], bodies->orientation[2][i], bodies->orientation[3][i]},
+            };
+        }
+        harmony_hash_grid_build(&grid, &points, count);
+        u32 pair_count = harmony_hash_grid_pairs(&grid, 1.75f, pairs, pair_capacity);
+        harmony_assert(pair_count <= pair_capacity);
+        for (u32 p = 0; p < pair_count; ++p) {
+            pairs[p] = (HarmonyPair){pairs[p].a + 1, pairs[p].b + 1};
+        }
+        for (u32 i = 1; i <= count && pair_count < pair_capacity; ++i) {
+            if (bodies->position[1][i] < 0.9f)
+                pairs[pair_count++] = (HarmonyPair){0, i};
+        }
+        harmony_collide_pairs_parallel(thread_count, manifolds, colliders, pairs, pair_count);
+        f64 middle = bench_seconds();
+        harmony_physics_step(thread_count, &physics, pairs, manifolds, pair_count, 1.0f / 60.0f);
+        f64 end = bench_seconds();
+        *collide_ms += (middle - begin) * 1.0e3;
+        *step_ms += (end - middle) * 1.0e3;
+    }
+    *collide_ms /= frames;
+    *step_ms /= frames;
+
+    u32 awake = 0;
+    for (u32 i = 1; i <= count; ++i) {
+        awake += bodies->awake[i];
+    }
+    bench_sink += (u64)physics.constraint_count;
+    harmony_hash_grid_destroy(&allocator, &grid);
+    harmony_physics_destroy(&allocator, &physics);
+    free(manifolds);
+    free(pairs);
+    free(colliders);
+    return awake;
+}
+
+static void bench_physics(u32 thread_count) {
+    u32 tower_count = 100;
+    u32 tower_height = 10;
+    u32 stack_count = tower_count * tower_height;
+    u32 pile_count = 4000;
+    Vec3 *positions = malloc(pile_count * sizeof(*positions));
+    u32 frames = 120;
+
+    printf("rigid bodies, %u frames (%u threads)\n", frames, thread_count);
+    printf("%12s %8s %12s %12s %12s %8s\n", "scene", "threads", "bodies", "collide ms", "step ms", "awake");
+    for (u32 t = 0; t < 2; ++t) {
+        u32 threads = t == 0 ? 1 : thread_count;
+        for (u32 i = 0; i < stack_count; ++i) {
+            u32 tower = i / tower_height;
+            positions[i] = (Vec3){
+                (f32)(tower % 10) * 3.0f + bench_random_f32() * 0.02f,
+                0.5f + (f32)(i % tower_height) * 1.0f,
+                (f32)(tower / 10) * 3.0f + bench_random_f32() * 0.02f,
+            };
+        }
+        f64 collide, step;
+        u32 awake = bench_physics_scene(threads, positions, stack_count, frames, &collide, &step);
+        printf("%12s %8u %12u %12.3f %12.3f %8u\n", "stacks", threads, stack_count, collide, step, awake);
+
+        // a loose pile, dropped in layers onto a square
+        for (u32 i = 0; i < pile_count; ++i) {
+            positions[i] = (Vec3){
+                bench_random_f32() * 12.0f,
+                1.0f + (f32)(i / 400) * 1.2f + bench_random_f32() * 0.1f,
+                bench_random_f32() * 12.0f,
+            };
+        }
+        awake = bench_physics_scene(threads, positions, pile_count, frames, &collide, &step);
+        printf("%12s %8u %12u %12.3f %12.3f %8u\n", "pile", threads, pile_count, collide, step, awake);
+    }
+
+    free(positions);
+}
+
+static const f32 *bench_particle_distances;
+
+static int bench_particle_compare(const void *lhs, const void *rhs) {
+    f32 a = bench_particle_distances[*(const u32 *)lhs];
+    f32 b = bench_particle_distances[*(const u32 *)rhs];
+    return a < b ? 1 : a > b ? -1 : 0;
+}
+
+static void bench_particles(u32 thread_count) {
+    HarmonyAllocator allocator = harmony_default_allocator();
+    u32 count = 500000;
+    u32 repeats = 10;
+    HarmonyParticles particles = harmony_particles_create(&allocator, count);
+    particles.gravity = (Vec3){0.0f, -9.81f, 0.0f};
+    particles.drag = 0.2f;
+    harmony_particle_curve(&particles.curves.size, (f32[]){0.0f, 0.2f, 1.0f}, (f32[]){0.1f, 0.5f, 1.0f}, 3);
+    harmony_particle_curve(&particles.curves.color[3], (f32[]){0.0f, 1.0f}, (f32[]){1.0f, 0.0f}, 2);
+    HarmonyParticleEmitter emitter = {
+        .position_spread = {20.0f, 1.0f, 20.0f},
+        .velocity = {0.0f, 10.0f, 0.0f},
+        .velocity_spread = {2.0f, 2.0f, 2.0f},
+        .min_lifetime = 20.0f,
+        .max_lifetime = 30.0f,
+    };
+    HarmonyParticleVertex *vertices = malloc(count * sizeof(*vertices));
+    f32 *distances = malloc(count * sizeof(*distances));
+    u32 *order = malloc(count * sizeof(*order));
+    Vec3 eye = {0.0f, 5.0f, -40.0f};
+    f32 dt = 1.0f / 60.0f;
+
+    printf("particles, %u (%u threads)\n", count, thread_count);
+    printf("%24s %12s %12s\n", "method", "ms", "Mparticles/s");
+
+    f64 begin = bench_seconds();
+    for (u32 r = 0; r < repeats; ++r) {
+        particles.count = 0;
+        harmony_particles_emit(1, &particles, &emitter, count, r);
+    }
+    f64 ms = (bench_seconds() - begin) * 1.0e3 / repeats;
+    printf("%24s %12.3f %12.1f\n", "emit", ms, count / ms * 1.0e-3);
+
+    begin = bench_seconds();
+    for (u32 r = 0; r < repeats; ++r) {
+        particles.count = 0;
+        harmony_particles_emit(thread_count, &particles, &emitter, count, r);
+    }
+    ms = (bench_seconds() - begin) * 1.0e3 / repeats;
+    printf("%24s %12.3f %12.1f\n", "emit parallel", ms, count / ms * 1.0e-3);
+
+    HarmonyCpuTier best = harmony_cpu_best_tier();
+    harmony_kernels_select(HARMONY_CPU_TIER_SCALAR);
+    begin = bench_seconds();
+    for (u32 r = 0; r < repeats; ++r) {
+        harmony_particles_update(1, &particles, dt);
+    }
+    ms = (bench_seconds() - begin) * 1.0e3 / repeats;
+    printf("%24s %12.3f %12.1f\n", "update scalar", ms, count / ms * 1.0e-3);
+    harmony_kernels_select(best);
+
+    begin = bench_seconds();
+    for (u32 r = 0; r < repeats; ++r) {
+        harmony_particles_update(1, &particles, dt);
+    }
+    ms = (bench_seconds() - begin) * 1.0e3 / repeats;
+    printf("%24s %12.3f %12.1f\n", "update", ms, count / ms * 1.0e-3);
+
+    begin = bench_seconds();
+    for (u32 r = 0; r < repeats; ++r) {
+        harmony_particles_update(thread_count, &particles, dt);
+    }
+    ms = (bench_seconds() - begin) * 1.0e3 / repeats;
+    printf("%24s %12.3f %12.1f\n", "update parallel", ms, count / ms * 1.0e-3);
+    harmony_assert(particles.count == count);
+
+    begin = bench_seconds();
+    for (u32 r = 0; r < repeats; ++r) {
+        for (u32 i = 0; i < count; ++i) {
+            f32 dx = particles.streams.position[0][i] - eye.x;
+            f32 dy = particles.streams.position[1][i] - eye.y;
+            f32 dz = particles.streams.position[2][i] - eye.z;
+            distances[i] = dx * dx + dy * dy + dz * dz;
+            order[i] = i;
+        }
+        bench_particle_distances = distances;
+        qsort(order, count, sizeof(*order), bench_particle_compare);
+    }
+    ms = (bench_seconds() - begin) * 1.0e3 / repeats;
+    printf("%24s %12.3f %12.1f\n", "sort qsort", ms, count / ms * 1.0e-3);
+
+    begin = bench_seconds();
+    for (u32 r = 0; r < repeats; ++r) {
+        harmony_particles_sort(1, &particles, eye);
+    }
+    ms = (bench_seconds() - begin) * 1.0e3 / repeats;
+    printf("%24s %12.3f %12.1f\n", "sort radix", ms, count / ms * 1.0e-3);
+
+    begin = bench_seconds();
+    for (u32 r = 0; r < repeats; ++r) {
+        harmony_particles_sort(thread_count, &particles, eye);
+    }
+    ms = (bench_seconds() - begin) * 1.0e3 / repeats;
+    printf("%24s %12.3f %12.1f\n", "sort radix parallel", ms, count / ms * 1.0e-3);
+
+    begin = bench_seconds();
+    for (u32 r = 0; r < repeats; ++r) {
+        harmony_particles_write_vertices(vertices, &particles, particles.order);
+    }
+    ms = (bench_seconds() - begin) * 1.0e3 / repeats;
+    printf("%24s %12.3f %12.1f\n", "write sorted vertices", ms, count / ms * 1.0e-3);
+    bench_sink += vertices[count / 2].color + order[count / 2];
+
+    free(order);
+    free(distances);
+    free(vertices);
+    harmony_particles_destroy(&allocator, &particles);
+}
+
+static void bench_arrays(void) {
+    HarmonyAllocator allocator = harmony_default_allocator();
+    printf("array append Mitems/s\n");
+    printf("%10s %12s %12s %12s %12s %12s %12s\n", "count", "realloc +1", "realloc x2", "array", "arena", "small", "bulk");
+    for (u32 count = 1000; count <= 10000000; count *= 10) {
+        u32 repeats = harmony_max(10000000 / count, 1u);
+        f64 rates[6];
+        u64 check = 0;
+
+        f64 begin = bench_seconds();
+        for (u32 r = 0; r < repeats; ++r) {
+            u32 *data = NULL;
+            for (u32 i = 0; i < count; ++i) {
+                data = realloc(data, (i + 1) * sizeof(*data));
+                data[i] = i;
+            }
+            check += data[count - 1];
+            free(data);
+        }
+        rates[0] = (f64)count * repeats / (bench_seconds() - begin);
+
+        begin = bench_seconds();
+        for (u32 r = 0; r < repeats; ++r) {
+            u32 *data = NULL;
+            u32 capacity = 0;
+            for (u32 i = 0; i < count; ++i) {
+                if (i == capacity) {
+                    capacity = harmony_max(capacity * 2, 8u);
+                    data = realloc(data, capacity * sizeof(*data));
+                }
+                data[i] = i;
+            }
+            check += data[count - 1];
+            free(data);
+        }
+        rates[1] = (f64)count * repeats / (bench_seconds() - begin);
+
+        begin = bench_seconds();
+        for (u32 r = 0; r < repeats; ++r) {
+            HarmonyArray(u32) array = {0};
+            for (u32 i = 0; i < count; ++i) {
+                harmony_array_push(&allocator, &array, i);
+            }
+            check += array.data[count - 1];
+            harmony_array_destroy(&allocator, &array);
+        }
+        rates[2] = (f64)count * repeats / (bench_seconds() - begin);
+
+        HarmonyArena arena = harmony_arena_create(&allocator, harmony_align(count * 2 * sizeof(u32), 16));
+        HarmonyAllocator arena_allocator = harmony_arena_allocator(&arena);
+        begin = bench_seconds();
+        for (u32 r = 0; r < repeats; ++r) {
+            HarmonyArray(u32) array = {0};
+            for (u32 i = 0; i < count; ++i) {
+                harmony_array_push(&arena_allocator, &array, i);
+            }
+            check += array.data[count - 1];
+            harmony_arena_reset(&arena);
+        }
+        rates[3] = (f64)count * repeats / (bench_seconds() - begin);
+        harmony_arena_destroy(&allocator, &arena);
+
+        begin = bench_seconds();
+        for (u32 r = 0; r < repeats; ++r) {
+            HarmonySmallArray(u32, 64) array;
+            harmony_small_array_init(&array);
+            for (u32 i = 0; i < count; ++i) {
+                harmony_array_push(&allocator, &array, i);
+            }
+            check += array.data[count - 1];
+            harmony_array_destroy(&allocator, &array);
+        }
+        rates[4] = (f64)count * repeats / (bench_seconds() - begin);
+
+        u32 chunk[256];
+        for (u32 i = 0; i < 256; ++i) {
+            chunk[i] = i;
+        }
+        begin = bench_seconds();
+        for (u32 r = 0; r < repeats; ++r) {
+            HarmonyArray(u32) array = {0};
+            for (u32 i = 0; i < count; i += 256) {
+                harmony_array_append(&allocator, &array, chunk, harmony_min(count - i, 256u));
+            }
+            check += array.data[count - 1];
+            harmony_array_destroy(&allocator, &array);
+        }
+        rates[5] = (f64)count * repeats / (bench_seconds() - begin);
+
+        printf("%10u %12.1f %12.1f %12.1f %12.1f %12.1f %12.1f\n", count,
+            rates[0] * 1.0e-6, rates[1] * 1.0e-6, rates[2] * 1.0e-6,
+            rates[3] * 1.0e-6, rates[4] * 1.0e-6, rates[5] * 1.0e-6);
+        if (check == 0)
+            printf("unexpected checksum\n");
+    }
+}
+
+static void bench_hash_maps(void) {
+    HarmonyAllocator allocator = harmony_default_allocator();
+    printf("hash map u64 -> u64, ns/op\n");
+    printf("%10s %12s %12s %12s %12s %12s\n", "count", "insert", "reserved", "hit", "miss", "remove");
+    u32 max_count = 10000000;
+    u64 *keys = malloc(max_count * sizeof(*keys));
+    u64 *misses = malloc(max_count * sizeof(*misses));
+    u64 state = 0x853c49e6748fea9bull;
+    for (u32 i = 0; i < max_count; ++i) {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        keys[i] = state | 1;
+        misses[i] = state & ~1ull;
+    }
+
+    for (u32 count = 1000; count <= max_count; count *= 10) {
+        u32 repeats = harmony_max(10000000 / count, 1u);
+        f64 ns[5];
+        u64 check = 0;
+
+        f64 begin = bench_seconds();
+        for (u32 r = 0; r < repeats; ++r) {
+            HarmonyHashMap map = harmony_hash_map_create(&allocator, sizeof(u64), sizeof(u64), 0, NULL, NULL);
+            for (u32 i = 0; i < count; ++i) {
+                harmony_hash_map_insert(&allocator, &map, &keys[i], &i);
+            }
+            check += map.count;
+            harmony_hash_map_destroy(&allocator, &map);
+        }
+        ns[0] = (bench_seconds() - begin) * 1.0e9 / ((f64)count * repeats);
+
+        HarmonyHashMap map = harmony_hash_map_create(&allocator, sizeof(u64), sizeof(u64), count, NULL, NULL);
+        begin = bench_seconds();
+        for (u32 r = 0; r < repeats; ++r) {
+            harmony_hash_map_clear(&map);
+            for (u32 i = 0; i < count; ++i) {
+                harmony_hash_map_insert(&allocator, &map, &keys[i], &i);
+            }
+        }
+        ns[1] = (bench_seconds() - begin) * 1.0e9 / ((f64)count * repeats);
+
+        begin = bench_seconds();
+        for (u32 r = 0; r < repeats; ++r) {
+            for (u32 i = 0; i < count; ++i) {
+                check += *(u64 *)harmony_hash_map_get(&map, &keys[i]);
+            }
+        }
+        ns[2] = (bench_seconds() - begin) * 1.0e9 / ((f64)count * repeats);
+
+        begin = bench_seconds();
+        for (u32 r = 0; r < repeats; ++r) {
+            for (u32 i = 0; i < count; ++i) {
+                check += harmony_hash_map_get(&map, &misses[i]) == NULL;
+            }
+        }
+        ns[3] = (bench_seconds() - begin) * 1.0e9 / ((f64)count * repeats);
+
+        begin = bench_seconds();
+        for (u32 i = 0; i < count; ++i) {
+            check += harmony_hash_map_remove(&map, &keys[i]);
+        }
+        ns[4] = (bench_seconds() - begin) * 1.0e9 / count;
+        harmony_hash_map_destroy(&allocator, &map);
+
+        printf("%10u %12.1f %12.1f %12.1f %12.1f %12.1f\n", count, ns[0], ns[1], ns[2], ns[3], ns[4]);
+        if (check == 0)
+            printf("unexpected checksum\n");
+    }
+    free(misses);
+    free(keys);
+}
+
+static int bench_u32_compare(const void *lhs, const void *rhs) {
+    u32 a = *(const u32 *)lhs;
+    u32 b = *(const u32 *)rhs;
+    return a < b ? -1 : a > b ? 1 : 0;
+}
+
+static u32 bench_sorted_build(u32 *dst, const u32 *keys, u32 count) {
+    memcpy(dst, keys, count * sizeof(*dst));
+    qsort(dst, count, sizeof(*dst), bench_u32_compare);
+    u32 unique = 0;
+    for (u32 i = 0; i < count; ++i) {
+        if (unique == 0 || dst[unique - 1] != dst[i])
+            dst[unique++] = dst[i];
+    }
+    return unique;
+}
+
+static bool bench_sorted_contains(const u32 *sorted, u32 count, u32 key) {
+    u32 begin = 0;
+    while (count > 0) {
+        u32 half = count / 2;
+        if (sorted[begin + half] < key) {
+            begin += half + 1;
+            count -= half + 1;
+        } else {
+            count = half;
+        }
+    }
+    return sorted[begin] == key;
+}
+
+static void bench_hash_sets(void) {
+    HarmonyAllocator allocator = harmony_default_allocator();
+    printf("hash set vs sorted array, u32 keys with duplicates, ns/key\n");
+    printf("set intersect includes copying into a cleared set\n");
+    printf("%10s %14s %12s %12s %12s %12s\n", "count", "method", "build", "contains", "batched", "intersect");
+    u32 max_count = 1000000;
+    u32 *keys = malloc(max_count * sizeof(*keys));
+    u32 *other_keys = malloc(max_count * sizeof(*other_keys));
+    u32 *queries = malloc(max_count * sizeof(*queries));
+    u32 *sorted = malloc(max_count * sizeof(*sorted));
+    u32 *other_sorted = malloc(max_count * sizeof(*other_sorted));
+    u32 *intersection = malloc(max_count * sizeof(*intersection));
+
+    for (u32 count = 1000; count <= max_count; count *= 10) {
+        u32 repeats = harmony_max(1000000 / count, 1u);
+        u32 state = 12345;
+        for (u32 i = 0; i < count; ++i) {
+            state = state * 1664525u + 1013904223u;
+            keys[i] = (state >> 4) % (count * 2);
+            state = state * 1664525u + 1013904223u;
+            other_keys[i] = (state >> 4) % (count * 2);
+            state = state * 1664525u + 1013904223u;
+            queries[i] = (state >> 4) % (count * 4);
+        }
+        f64 ns[4];
+        u64 check = 0;
+
+        HarmonyHashSet set = harmony_hash_set_create(&allocator, sizeof(u32), 0, NULL, NULL);
+        HarmonyHashSet other = harmony_hash_set_create(&allocator, sizeof(u32), 0, NULL, NULL);
+        HarmonyHashSet result = harmony_hash_set_create(&allocator, sizeof(u32), 0, NULL, NULL);
+        harmony_hash_set_insert_many(&allocator, &other, other_keys, count);
+        f64 begin = bench_seconds();
+        for (u32 r = 0; r < repeats; ++r) {
+            harmony_hash_set_clear(&set);
+            harmony_hash_set_insert_many(&allocator, &set, keys, count);
+        }
+        ns[0] = (bench_seconds() - begin) * 1.0e9 / ((f64)count * repeats);
+
+        begin = bench_seconds();
+        for (u32 r = 0; r < repeats; ++r) {
+            for (u32 i = 0; i < count; ++i) {
+                check += harmony_hash_set_contains(&set, &queries[i]);
+            }
+        }
+        ns[1] = (bench_seconds() - begin) * 1.0e9 / ((f64)count * repeats);
+
+        begin = bench_seconds();
+        for (u32 r = 0; r < repeats; ++r) {
+            check += harmony_hash_set_contains_many(&set, queries, count, NULL);
+        }
+        ns[2] = (bench_seconds() - begin) * 1.0e9 / ((f64)count * repeats);
+
+        begin = bench_seconds();
+        for (u32 r = 0; r < repeats; ++r) {
+            harmony_hash_set_clear(&result);
+            harmony_hash_set_union(&allocator, &result, &set);
+            harmony_hash_set_intersect(&result, &other);
+            check += result.count;
+        }
+        ns[3] = (bench_seconds() - begin) * 1.0e9 / ((f64)count * repeats);
+        printf("%10u %14s %12.1f %12.1f %12.1f %12.1f\n", count, "hash set", ns[0], ns[1], ns[2], ns[3]);
+        harmony_hash_set_destroy(&allocator, &result);
+        harmony_hash_set_destroy(&allocator, &other);
+        harmony_hash_set_destroy(&allocator, &set);
+
+        u32 other_unique = bench_sorted_build(other_sorted, other_keys, count);
+        u32 unique = 0;
+        begin = bench_seconds();
+        for (u32 r = 0; r < repeats; ++r) {
+            unique = bench_sorted_build(sorted, keys, count);
+        }
+        ns[0] = (bench_seconds() - begin) * 1.0e9 / ((f64)count * repeats);
+
+        begin = bench_seconds();
+        for (u32 r = 0; r < repeats; ++r) {
+            for (u32 i = 0; i < count; ++i) {
+                check += bench_sorted_contains(sorted, unique, queries[i]);
+            }
+        }
+        ns[1] = ns[2] = (bench_seconds() - begin) * 1.0e9 / ((f64)count * repeats);
+
+        begin = bench_seconds();
+        for (u32 r = 0; r < repeats; ++r) {
+            u32 written = 0;
+            for (u32 i = 0, j = 0; i < unique && j < other_unique;) {
+                if (sorted[i] < other_sorted[j]) {
+                    ++i;
+                } else if (sorted[i] > other_sorted[j]) {
+                    ++j;
+                } else {
+                    intersection[written++] = sorted[i];
+                    ++i;
+                    ++j;
+                }
+            }
+            check += written;
+        }
+        ns[3] = (bench_seconds() - begin) * 1.0e9 / ((f64)count * repeats);
+        printf("%10u %14s %12.1f %12.1f %12.1f %12.1f\n", count, "sorted array", ns[0], ns[1], ns[2], ns[3]);
+        if (check == 0)
+            printf("unexpected checksum\n");
+    }
+    free(intersection);
+    free(other_sorted);
+    free(sorted);
+    free(queries);
+    free(other_keys);
+    free(keys);
+}
+
+static void bench_arenas(void) {
+    HarmonyAllocator allocator = harmony_default_allocator();
+    u32 count = 1 << 20;
+    usize size = 64;
+    u32 repeats = 10;
+    void **allocations = malloc(count * sizeof(*allocations));
+
+    printf("arena, %u allocations of %zu bytes\n", count, size);
+    printf("%24s %12s %12s\n", "method", "ms", "Mallocs/s");
+
+    f64 begin = bench_seconds();
+    for (u32 r = 0; r < repeats; ++r) {
+        for (u32 i = 0; i < count; ++i) {
+            allocations[i] = malloc(size);
+            *(u8 *)allocations[i] = (u8)i;
+        }
+        for (u32 i = 0; i < count; ++i) {
+            free(allocations[i]);
+        }
+    }
+    f64 ms = (bench_seconds() - begin) * 1.0e3 / repeats;
+    printf("%24s %12.3f %12.1f\n", "malloc + free", ms, count / ms * 1.0e-3);
+
+    HarmonyArena fixed = harmony_arena_create(&allocator, count * size);
+    begin = bench_seconds();
+    for (u32 r = 0; r < repeats; ++r) {
+        harmony_arena_reset(&fixed);
+        for (u32 i = 0; i < count; ++i) {
+            allocations[i] = harmony_arena_alloc(&fixed, size);
+            *(u8 *)allocations[i] = (u8)i;
+        }
+    }
+    ms = (bench_seconds() - begin) * 1.0e3 / repeats;
+    printf("%24s %12.3f %12.1f\n", "fixed arena", ms, count / ms * 1.0e-3);
+    harmony_arena_destroy(&allocator, &fixed);
+
+    HarmonyArena reserved = harmony_arena_reserve((usize)1 << 36, count * size);
+    begin = bench_seconds();
+    for (u32 i = 0; i < count; ++i) {
+        allocations[i] = harmony_arena_alloc(&reserved, size);
+        *(u8 *)allocations[i] = (u8)i;
+    }
+    ms = (bench_seconds() - begin) * 1.0e3;
+    printf("%24s %12.3f %12.1f\n", "reserved, committing", ms, count / ms * 1.0e-3);
+
+    begin = bench_seconds();
+    for (u32 r = 0; r < repeats; ++r) {
+        harmony_arena_reset(&reserved);
+        for (u32 i = 0; i < count; ++i) {
+            allocations[i] = harmony_arena_alloc(&reserved, size);
+            *(u8 *)allocations[i] = (u8)i;
+        }
+    }
+    ms = (bench_seconds() - begin) * 1.0e3 / repeats;
+    printf("%24s %12.3f %12.1f\n", "reserved, committed", ms, count / ms * 1.0e-3);
+
+    reserved.high_water_mark = 0;
+    begin = bench_seconds();
+    for (u32 r = 0; r < repeats; ++r) {
+        harmony_arena_reset(&reserved);
+        for (u32 i = 0; i < count; ++i) {
+            allocations[i] = harmony_arena_alloc(&reserved, size);
+            *(u8 *)allocations[i] = (u8)i;
+        }
+    }
+    ms = (bench_seconds() - begin) * 1.0e3 / repeats;
+    printf("%24s %12.3f %12.1f\n", "reserved, decommitting", ms, count / ms * 1.0e-3);
+    harmony_arena_release(&reserved);
+
+    free(allocations);
+}
+
+int main(void) {
+    u32 thread_count = 8;
+
+    bench_mmul(thread_count);
+    bench_model_matrices(thread_count);
+    bench_random();
+    bench_hash();
+    bench_noise(thread_count);
+    bench_fft();
+    bench_approx();
+    bench_quats();
+    bench_animation(thread_count);
+    bench_transforms(thread_count);
+    bench_culling(thread_count);
+    bench_bvh(thread_count);
+    bench_rays();
+    bench_hash_grid(thread_count);
+    bench_collision(thread_count);
+    bench_physics(thread_count);
+    bench_particles(thread_count);
+    bench_arrays();
+    bench_hash_maps();
+    bench_hash_sets();
+    bench_arenas();
+}
@@ -10,7 +10,2879 @@
 
 #include <alloca.h>
 
+static f32 test_random_f32(void) {
+    return (f32)rand() / (f32)RAND_MAX * 2.0f - 1.0f;
+}
+
+static bool test_nearly_equal(const f32 *lhs, const f32 *rhs, u32 count) {
+    for (u32 i = 0; i < count; ++i) {
+        if (fabsf(lhs[i] - rhs[i]) > 1.0e-5f)
+            return false;
+    }
+    return true;
+}
+
+static Quat test_qmul_reference(Quat lhs, Quat rhs) {
+    return (Quat){
+        lhs.r * rhs.r - lhs.i * rhs.i - lhs.j * rhs.j - lhs.k * rhs.k,
+        lhs.r * rhs.i + lhs.i * rhs.r + lhs.j * rhs.k - lhs.k * rhs.j,
+        lhs.r * rhs.j - lhs.i * rhs.k + lhs.j * rhs.r + lhs.k * rhs.i,
+        lhs.r * rhs.k + lhs.i * rhs.j - lhs.j * rhs.i + lhs.k * rhs.r,
+    };
+}
+
+static void test_fixed_size_math(void) {
+    for (u32 n = 0; n < 1000; ++n) {
+        Mat4 lhs;
+        Mat4 rhs;
+        for (u32 i = 0; i < 16; ++i) {
+            ((f32 *)&lhs)[i] = test_random_f32();
+            ((f32 *)&rhs)[i] = test_random_f32();
+        }
+
+        Mat4 mat = mmul4(lhs, rhs);
+        Mat4 mat_ref;
+        mmul((f32 *)&mat_ref, 4, 4, (f32 *)&lhs, 4, 4, (f32 *)&rhs);
+        harmony_assert(test_nearly_equal((f32 *)&mat, (f32 *)&mat_ref, 16));
+
+        Vec4 vec = mvmul4(lhs, rhs.x);
+        Vec4 vec_ref;
+        mvmul(4, 4, (f32 *)&vec_ref, (f32 *)&lhs, (f32 *)&rhs.x);
+        harmony_assert(test_nearly_equal((f32 *)&vec, (f32 *)&vec_ref, 4));
+
+        Vec4 sum = vadd4(vsub4(vmul4(lhs.x, lhs.y), svmul4(2.0f, lhs.z)), vdiv4(lhs.w, svec4(3.0f)));
+        Vec4 sum_ref;
+        for (u32 i = 0; i < 4; ++i) {
+            ((f32 *)&sum_ref)[i] = ((f32 *)&lhs.x)[i] * ((f32 *)&lhs.y)[i]
+                                 - 2.0f * ((f32 *)&lhs.z)[i]
+                                 + ((f32 *)&lhs.w)[i] / 3.0f;
+        }
+        harmony_assert(test_nearly_equal((f32 *)&sum, (f32 *)&sum_ref, 4));
+
+        f32 len_ref;
+        vlen(4, &len_ref, (f32 *)&lhs.x);
+        harmony_assert(fabsf(vlen4(lhs.x) - len_ref) < 1.0e-5f);
+        Vec4 norm = vnorm4(lhs.x);
+        Vec4 norm_ref;
+        vnorm(4, (f32 *)&norm_ref, (f32 *)&lhs.x);
+        harmony_assert(test_nearly_equal((f32 *)&norm, (f32 *)&norm_ref, 4));
+
+        Quat q = {lhs.x.x, lhs.x.y, lhs.x.z, lhs.x.w};
+        Quat r = {rhs.x.x, rhs.x.y, rhs.x.z, rhs.x.w};
+        Quat quat = qmul(q, r);
+        Quat quat_ref = test_qmul_reference(q, r);
+        harmony_assert(test_nearly_equal((f32 *)&quat, (f32 *)&quat_ref, 4));
+
+        Vec3 rotated = rotate_vec3(q, (Vec3){r.i, r.j, r.k});
+        Quat rotated_ref = test_qmul_reference(q, test_qmul_reference((Quat){0.0f, r.i, r.j, r.k}, qconj(q)));
+        harmony_assert(test_nearly_equal((f32 *)&rotated, &rotated_ref.i, 3));
+    }
+}
+
+static bool test_wide_close(const f32 *lhs, const f32 *rhs, u32 count) {
+    for (u32 i = 0; i < count; ++i) {
+        if (fabsf(lhs[i] - rhs[i]) > 1.0e-5f * (1.0f + fabsf(rhs[i])))
+            return false;
+    }
+    return true;
+}
+
+static void test_wide_math(void) {
+    for (u32 n = 0; n < 100; ++n) {
+        f32 s[8];
+        Vec3 a3[8], b3[8];
+        Vec4 a4[8], b4[8];
+        Mat4 ma[8], mb[8];
+        Quat qa[8], qb[8];
+        for (u32 i = 0; i < 8; ++i) {
+            s[i] = test_random_f32();
+            a3[i] = (Vec3){test_random_f32(), test_random_f32(), test_random_f32()};
+            b3[i] = (Vec3){test_random_f32(), test_random_f32(), test_random_f32()};
+            a4[i] = (Vec4){test_random_f32(), test_random_f32(), test_random_f32(), test_random_f32()};
+            b4[i] = (Vec4){test_random_f32(), test_random_f32(), test_random_f32(), test_random_f32()};
+            for (u32 j = 0; j < 16; ++j) {
+                ((f32 *)&ma[i])[j] = test_random_f32();
+                ((f32 *)&mb[i])[j] = test_random_f32();
+            }
+            Vec4 q = vnorm4((Vec4){test_random_f32(), test_random_f32(), test_random_f32(), 1.0f});
+            Vec4 r = vnorm4((Vec4){test_random_f32(), test_random_f32(), 1.0f, test_random_f32()});
+            qa[i] = (Quat){q.x, q.y, q.z, q.w};
+            qb[i] = (Quat){r.x, r.y, r.z, r.w};
+        }
+
+        F32x8 ws;
+        memcpy(ws.v, s, sizeof(s));
+        F32x8 wt = sf32x8(1.5f);
+        Vec3x8 wa3 = gather_vec3x8(a3);
+        Vec3x8 wb3 = gather_vec3x8(b3);
+        Vec4x8 wa4 = gather_vec4x8(a4);
+        Vec4x8 wb4 = gather_vec4x8(b4);
+        Mat4x8 wma = gather_mat4x8(ma);
+        Mat4x8 wmb = gather_mat4x8(mb);
+        Quatx8 wqa = gather_quatx8(qa);
+        Quatx8 wqb = gather_quatx8(qb);
+
+        Vec3 out3[8], ref3[8];
+        Vec4 out4[8], ref4[8];
+        Mat4 outm[8], refm[8];
+        Quat outq[8], refq[8];
+        f32 ref1[8];
+
+        scatter_vec3x8(out3, wa3);
+        scatter_vec4x8(out4, wa4);
+        scatter_mat4x8(outm, wma);
+        scatter_quatx8(outq, wqa);
+        harmony_assert(memcmp(out3, a3, sizeof(a3)) == 0 && memcmp(out4, a4, sizeof(a4)) == 0);
+        harmony_assert(memcmp(outm, ma, sizeof(ma)) == 0 && memcmp(outq, qa, sizeof(qa)) == 0);
+
+        F32x8 lanes[6] = {
+            fadd8(ws, wt), fsub8(ws, wt), fmul8(ws, wt), fdiv8(ws, wt), fsqrt8(fmul8(ws, ws)), fmadd8(ws, wt, ws),
+        };
+        for (u32 i = 0; i < 8; ++i) {
+            harmony_assert(lanes[0].v[i] == s[i] + 1.5f && lanes[1].v[i] == s[i] - 1.5f);
+            harmony_assert(lanes[2].v[i] == s[i] * 1.5f && lanes[3].v[i] == s[i] / 1.5f);
+            harmony_assert(test_wide_close(&lanes[4].v[i], (f32[]){fabsf(s[i])}, 1));
+            harmony_assert(test_wide_close(&lanes[5].v[i], (f32[]){s[i] + 1.5f * s[i]}, 1));
+        }
+
+        scatter_vec3x8(out3, vadd3x8(wa3, wb3));
+        for (u32 i = 0; i < 8; ++i) {
+            ref3[i] = vadd3(a3[i], b3[i]);
+        }
+        harmony_assert(test_wide_close((f32 *)out3, (f32 *)ref3, 24));
+        scatter_vec3x8(out3, vsub3x8(wa3, wb3));
+        for (u32 i = 0; i < 8; ++i) {
+            ref3[i] = vsub3(a3[i], b3[i]);
+        }
+        harmony_assert(test_wide_close((f32 *)out3, (f32 *)ref3, 24));
+        scatter_vec3x8(out3, vmul3x8(wa3, wb3));
+        for (u32 i = 0; i < 8; ++i) {
+            ref3[i] = vmul3(a3[i], b3[i]);
+        }
+        harmony_assert(test_wide_close((f32 *)out3, (f32 *)ref3, 24));
+        scatter_vec3x8(out3, svmul3x8(ws, wa3));
+        for (u32 i = 0; i < 8; ++i) {
+            ref3[i] = svmul3(s[i], a3[i]);
+        }
+        harmony_assert(test_wide_close((f32 *)out3, (f32 *)ref3, 24));
+        scatter_vec3x8(out3, vnorm3x8(wa3));
+        for (u32 i = 0; i < 8; ++i) {
+            ref3[i] = vnorm3(a3[i]);
+        }
+        harmony_assert(test_wide_close((f32 *)out3, (f32 *)ref3, 24));
+        scatter_vec3x8(out3, vcross3x8(wa3, wb3));
+        for (u32 i = 0; i < 8; ++i) {
+            ref3[i] = vcross3(a3[i], b3[i]);
+        }
+        harmony_assert(test_wide_close((f32 *)out3, (f32 *)ref3, 24));
+        scatter_vec3x8(out3, rotate_vec3x8(wqa, wa3));
+        for (u32 i = 0; i < 8; ++i) {
+            ref3[i] = rotate_vec3(qa[i], a3[i]);
+        }
+        harmony_assert(test_wide_close((f32 *)out3, (f32 *)ref3, 24));
+
+        F32x8 dot3 = vdot3x8(wa3, wb3);
+        F32x8 len3 = vlen3x8(wa3);
+        for (u32 i = 0; i < 8; ++i) {
+            ref1[i] = vdot3(a3[i], b3[i]);
+        }
+        harmony_assert(test_wide_close(dot3.v, ref1, 8));
+        for (u32 i = 0; i < 8; ++i) {
+            ref1[i] = vlen3(a3[i]);
+        }
+        harmony_assert(test_wide_close(len3.v, ref1, 8));
+
+        scatter_vec4x8(out4, vadd4x8(wa4, wb4));
+        for (u32 i = 0; i < 8; ++i) {
+            ref4[i] = vadd4(a4[i], b4[i]);
+        }
+        harmony_assert(test_wide_close((f32 *)out4, (f32 *)ref4, 32));
+        scatter_vec4x8(out4, vsub4x8(wa4, wb4));
+        for (u32 i = 0; i < 8; ++i) {
+            ref4[i] = vsub4(a4[i], b4[i]);
+        }
+        harmony_assert(test_wide_close((f32 *)out4, (f32 *)ref4, 32));
+        scatter_vec4x8(out4, vmul4x8(wa4, wb4));
+        for (u32 i = 0; i < 8; ++i) {
+            ref4[i] = vmul4(a4[i], b4[i]);
+        }
+        harmony_assert(test_wide_close((f32 *)out4, (f32 *)ref4, 32));
+        scatter_vec4x8(out4, svmul4x8(ws, wa4));
+        for (u32 i = 0; i < 8; ++i) {
+            ref4[i] = svmul4(s[i], a4[i]);
+        }
+        harmony_assert(test_wide_close((f32 *)out4, (f32 *)ref4, 32));
+        scatter_vec4x8(out4, vnorm4x8(wa4));
+        for (u32 i = 0; i < 8; ++i) {
+            ref4[i] = vnorm4(a4[i]);
+        }
+        harmony_assert(test_wide_close((f32 *)out4, (f32 *)ref4, 32));
+        scatter_vec4x8(out4, mvmul4x8(wma, wa4));
+        for (u32 i = 0; i < 8; ++i) {
+            ref4[i] = mvmul4(ma[i], a4[i]);
+        }
+        harmony_assert(test_wide_close((f32 *)out4, (f32 *)ref4, 32));
+
+        F32x8 dot4 = vdot4x8(wa4, wb4);
+        F32x8 len4 = vlen4x8(wa4);
+        for (u32 i = 0; i < 8; ++i) {
+            ref1[i] = vdot4(a4[i], b4[i]);
+        }
+        harmony_assert(test_wide_close(dot4.v, ref1, 8));
+        for (u32 i = 0; i < 8; ++i) {
+            ref1[i] = vlen4(a4[i]);
+        }
+        harmony_assert(test_wide_close(len4.v, ref1, 8));
+
+        scatter_mat4x8(outm, mmul4x8(wma, wmb));
+        for (u32 i = 0; i < 8; ++i) {
+            refm[i] = mmul4(ma[i], mb[i]);
+        }
+        harmony_assert(test_wide_close((f32 *)outm, (f32 *)refm, 128));
+
+        scatter_quatx8(outq, qmulx8(wqa, wqb));
+        for (u32 i = 0; i < 8; ++i) {
+            refq[i] = qmul(qa[i], qb[i]);
+        }
+        harmony_assert(test_wide_close((f32 *)outq, (f32 *)refq, 32));
+        scatter_quatx8(outq, qconjx8(wqa));
+        for (u32 i = 0; i < 8; ++i) {
+            refq[i] = qconj(qa[i]);
+        }
+        harmony_assert(test_wide_close((f32 *)outq, (f32 *)refq, 32));
+    }
+
+    Vec3 src3[16];
+    Vec4 src4[16];
+    for (u32 i = 0; i < 16; ++i) {
+        src3[i] = (Vec3){test_random_f32(), test_random_f32(), test_random_f32()};
+        src4[i] = (Vec4){test_random_f32(), test_random_f32(), test_random_f32(), test_random_f32()};
+    }
+    u32 indices[8] = {13, 2, 7, 0, 11, 5, 14, 8};
+    Vec3x8 indexed3 = gather_indexed_vec3x8(src3, indices);
+    Vec4x8 indexed4 = gather_indexed_vec4x8(src4, indices);
+    for (u32 i = 0; i < 8; ++i) {
+        harmony_assert(indexed3.x.v[i] == src3[indices[i]].x && indexed3.z.v[i] == src3[indices[i]].z);
+        harmony_assert(indexed4.y.v[i] == src4[indices[i]].y && indexed4.w.v[i] == src4[indices[i]].w);
+    }
+    Vec3 dst3[16] = {0};
+    Vec4 dst4[16] = {0};
+    scatter_indexed_vec3x8(dst3, indices, indexed3);
+    scatter_indexed_vec4x8(dst4, indices, indexed4);
+    for (u32 i = 0; i < 16; ++i) {
+        bool written = false;
+        for (u32 j = 0; j < 8; ++j) {
+            written = written || indices[j] == i;
+        }
+        Vec3 expected3 = written ? src3[i] : (Vec3){0};
+        Vec4 expected4 = written ? src4[i] : (Vec4){0};
+        harmony_assert(memcmp(&dst3[i], &expected3, sizeof(Vec3)) == 0);
+        harmony_assert(memcmp(&dst4[i], &expected4, sizeof(Vec4)) == 0);
+    }
+}
+
+static void test_affine(void) {
+    Affine3 identity = mat4toaffine3(smat4(1.0f));
+    for (u32 n = 0; n < 1000; ++n) {
+        Affine3 a;
+        for (u32 i = 0; i < 12; ++i) {
+            ((f32 *)&a)[i] = test_random_f32();
+        }
+        a.x.x += 2.0f;
+        a.y.y += 2.0f;
+        a.z.z += 2.0f;
+        Affine3 product = acompose(a, ainverse(a));
+        harmony_assert(test_wide_close((f32 *)&product, (f32 *)&identity, 12));
+        product = acompose(ainverse(a), a);
+        harmony_assert(test_wide_close((f32 *)&product, (f32 *)&identity, 12));
+
+        Mat4 m = affine3to4(a);
+        Affine3 round_trip = mat4toaffine3(m);
+        harmony_assert(memcmp(&round_trip, &a, sizeof(a)) == 0);
+        harmony_assert(m.x.w == 0.0f && m.y.w == 0.0f && m.z.w == 0.0f && m.w.w == 1.0f);
+        Vec4 point = mvmul4(m, (Vec4){1.0f, -2.0f, 0.5f, 1.0f});
+        Vec3 point_affine = atransform_point(a, (Vec3){1.0f, -2.0f, 0.5f});
+        harmony_assert(test_wide_close((f32 *)&point_affine, (f32 *)&point, 3));
+
+        Vec4 q4 = vnorm4((Vec4){test_random_f32(), test_random_f32(), test_random_f32(), 1.0f});
+        Quat q = {q4.x, q4.y, q4.z, q4.w};
+        Vec3 position = {test_random_f32() * 10.0f, test_random_f32() * 10.0f, test_random_f32() * 10.0f};
+        Affine3 rigid = mat4toaffine3(mat3to4(rotate_mat3(q, smat3(1.0f))));
+        rigid.w = position;
+        product = acompose(ainverse_rigid(rigid), rigid);
+        harmony_assert(test_wide_close((f32 *)&product, (f32 *)&identity, 12));
+
+        f32 zoom = 1.0f + test_random_f32() * 0.5f;
+        Mat4 rot = mat3to4(rotate_mat3(qconj(q), smat3(1.0f)));
+        Mat4 pos = smat4(1.0f);
+        pos.x.x = zoom;
+        pos.y.y = zoom;
+        pos.w.x = -position.x;
+        pos.w.y = -position.y;
+        pos.w.z = -position.z;
+        Mat4 view_ref = mmul4(rot, pos);
+        Mat4 view = harmony_view_matrix(position, zoom, q);
+#ifdef __FMA__
+        // mmul4() fuses its multiply-adds with FMA, so only matches to rounding
+        harmony_assert(test_wide_close((f32 *)&view, (f32 *)&view_ref, 16));
+#else // __FMA__
+        harmony_assert(memcmp(&view, &view_ref, sizeof(view)) == 0);
+#endif // __FMA__
+        Affine3 view_affine = harmony_view_affine(position, zoom, q);
+        Mat4 view_affine4 = affine3to4(view_affine);
+        harmony_assert(memcmp(&view_affine4, &view, sizeof(view)) == 0);
+
+        Vec3 scale = {1.0f + test_random_f32() * 0.5f, 2.0f, 0.5f};
+        Mat3 m3 = smat3(1.0f);
+        m3.x.x = scale.x;
+        m3.y.y = scale.y;
+        m3.z.z = scale.z;
+        Mat4 model_ref = mat3to4(rotate_mat3(q, m3));
+        model_ref.w.x = position.x;
+        model_ref.w.y = position.y;
+        model_ref.w.z = position.z;
+        Mat4 model = harmony_model_matrix_3d(position, scale, q);
+        harmony_assert(memcmp(&model, &model_ref, sizeof(model)) == 0);
+    }
+}
+
+static void test_random(void) {
+    HarmonyPcg32 pcg;
+    harmony_pcg32_seed(&pcg, 42, 54);
+    static const u32 pcg_reference[] = {0xa15c02b7, 0x7b47f409, 0xba1d3330, 0x83d2f293, 0xbfa4784b, 0xcbed606e};
+    for (u32 i = 0; i < sizeof(pcg_reference) / sizeof(*pcg_reference); ++i) {
+        harmony_assert(harmony_pcg32_next(&pcg) == pcg_reference[i]);
+    }
+
+    HarmonyPcg32 skipped;
+    harmony_pcg32_seed(&pcg, 7, 1);
+    harmony_pcg32_seed(&skipped, 7, 1);
+    for (u32 i = 0; i < 1000; ++i) {
+        (void)harmony_pcg32_next(&pcg);
+    }
+    harmony_pcg32_advance(&skipped, 1000);
+    harmony_assert(harmony_pcg32_next(&pcg) == harmony_pcg32_next(&skipped));
+
+    for (u32 i = 0; i < 10000; ++i) {
+        harmony_assert(harmony_pcg32_bounded(&pcg, 7) < 7);
+        f32 f = harmony_pcg32_f32(&pcg);
+        harmony_assert(f >= 0.0f && f < 1.0f);
+    }
+
+    HarmonyXoshiro256 xoshiro;
+    HarmonyXoshiro256 jumped;
+    harmony_xoshiro256_seed(&xoshiro, 0);
+    jumped = xoshiro;
+    harmony_xoshiro256_jump(&jumped);
+    harmony_assert(harmony_xoshiro256_next(&xoshiro) != harmony_xoshiro256_next(&jumped));
+    for (u32 i = 0; i < 10000; ++i) {
+        f32 f = harmony_xoshiro256_f32(&xoshiro);
+        harmony_assert(f >= 0.0f && f < 1.0f);
+    }
+
+    usize count = 1u << 20;
+    f32 *values = malloc(count * sizeof(*values));
+    HarmonyRandom rng;
+    harmony_random_seed(&rng, 1234);
+
+    u32 buckets[16] = {0};
+    f64 sum = 0.0;
+    f64 square_sum = 0.0;
+    harmony_random_f32s(&rng, values, count);
+    for (usize i = 0; i < count; ++i) {
+        harmony_assert(values[i] >= 0.0f && values[i] < 1.0f);
+        ++buckets[(u32)(values[i] * 16.0f)];
+        sum += values[i];
+        square_sum += values[i] * values[i];
+    }
+    f64 mean = sum / (f64)count;
+    harmony_assert(fabs(mean - 0.5) < 0.002);
+    harmony_assert(fabs(square_sum / (f64)count - mean * mean - 1.0 / 12.0) < 0.002);
+    f64 chi_square = 0.0;
+    for (u32 i = 0; i < 16; ++i) {
+        f64 diff = (f64)buckets[i] - (f64)count / 16.0;
+        chi_square += diff * diff / ((f64)count / 16.0);
+    }
+    harmony_assert(chi_square < 37.7); // p = 0.001 with 15 degrees of freedom
+
+    harmony_random_range_f32s(&rng, values, 1001, -3.0f, 5.0f);
+    for (usize i = 0; i < 1001; ++i) {
+        harmony_assert(values[i] >= -3.0f && values[i] < 5.0f);
+    }
+
+    // a large min next to a narrow range would round the top values up to max
+    harmony_random_range_f32s(&rng, values, count - 3, 1000.0f, 1001.0f);
+    bool reached_top = false;
+    for (usize i = 0; i < count - 3; ++i) {
+        harmony_assert(values[i] >= 1000.0f && values[i] < 1001.0f);
+        reached_top = reached_top || values[i] == nextafterf(1001.0f, 0.0f);
+    }
+    harmony_assert(reached_top);
+    harmony_random_range_f32s(&rng, values, 7, 2.0f, 2.0f);
+    harmony_assert(values[0] == 2.0f && values[6] == 2.0f);
+
+    sum = 0.0;
+    square_sum = 0.0;
+    harmony_random_gaussian_f32s(&rng, values, count, 2.0f, 3.0f);
+    usize within_one = 0;
+    usize within_two = 0;
+    for (usize i = 0; i < count; ++i) {
+        sum += values[i];
+        square_sum += values[i] * values[i];
+        within_one += fabsf(values[i] - 2.0f) < 3.0f;
+        within_two += fabsf(values[i] - 2.0f) < 6.0f;
+    }
+    mean = sum / (f64)count;
+    harmony_assert(fabs(mean - 2.0) < 0.02);
+    harmony_assert(fabs(sqrt(square_sum / (f64)count - mean * mean) - 3.0) < 0.02);
+    harmony_assert(fabs((f64)within_one / (f64)count - 0.6827) < 0.005);
+    harmony_assert(fabs((f64)within_two / (f64)count - 0.9545) < 0.005);
+    values[13] = -1.0f;
+    harmony_random_gaussian_f32s(&rng, values, 13, 2.0f, 0.0f);
+    harmony_assert(values[0] == 2.0f && values[12] == 2.0f && values[13] == -1.0f);
+
+    usize vec_count = 100001;
+    Vec3 *vecs = malloc(vec_count * sizeof(*vecs));
+    harmony_random_unit_vec3s(&rng, vecs, vec_count);
+    f64 vec_sum[3] = {0.0, 0.0, 0.0};
+    for (usize i = 0; i < vec_count; ++i) {
+        Vec3 v = vecs[i];
+        harmony_assert(fabsf(sqrtf(v.x * v.x + v.y * v.y + v.z * v.z) - 1.0f) < 1.0e-5f);
+        vec_sum[0] += v.x;
+        vec_sum[1] += v.y;
+        vec_sum[2] += v.z;
+    }
+    for (u32 i = 0; i < 3; ++i) {
+        harmony_assert(fabs(vec_sum[i] / (f64)vec_count) < 0.01);
+    }
+
+    free(vecs);
+    free(values);
+}
+
+static void test_hash(void) {
+    usize size = 5000;
+    u8 *bytes = malloc(size);
+    for (usize i = 0; i < size; ++i) {
+        bytes[i] = (u8)rand();
+    }
+
+    harmony_assert(harmony_hash(NULL, 0) == harmony_hash(bytes, 0));
+    harmony_assert(harmony_hash(bytes, 0) != harmony_hash_seeded(bytes, 0, 1));
+
+    HarmonyHashState *state = malloc(sizeof(*state));
+    for (usize len = 0; len < size; len += len < 300 ? 1 : 97) {
+        u64 hash = harmony_hash(bytes, len);
+        harmony_assert(hash == harmony_hash_seeded(bytes, len, 0));
+        harmony_assert(hash != harmony_hash_seeded(bytes, len, 12345));
+        if (len > 0)
+            harmony_assert(hash != harmony_hash(bytes + 1, len));
+
+        harmony_hash_init(state, 0);
+        for (usize i = 0; i < len;) {
+            usize piece = (usize)rand() % 300;
+            piece = harmony_min(len - i, piece);
+            harmony_hash_update(state, bytes + i, piece);
+            i += piece;
+        }
+        harmony_assert(harmony_hash_final(state) == hash);
+
+        harmony_hash_init(state, 12345);
+        harmony_hash_update(state, bytes, len);
+        harmony_assert(harmony_hash_final(state) == harmony_hash_seeded(bytes, len, 12345));
+    }
+
+    // flipping any input bit should flip about half of the output bits
+    for (usize len = 1; len <= 1024; len *= 2) {
+        u64 hash = harmony_hash(bytes, len);
+        u32 flipped = 0;
+        u32 trials = 0;
+        for (usize bit = 0; bit < len * 8; bit += harmony_max(len / 8, (usize)1)) {
+            bytes[bit / 8] ^= (u8)(1u << (bit % 8));
+            u64 diff = hash ^ harmony_hash(bytes, len);
+            bytes[bit / 8] ^= (u8)(1u << (bit % 8));
+            for (; diff != 0; diff &= diff - 1) {
+                ++flipped;
+            }
+            ++trials;
+        }
+        f32 average = (f32)flipped / (f32)trials;
+        harmony_assert(average > 26.0f && average < 38.0f);
+    }
+
+    free(state);
+    free(bytes);
+}
+
+static void test_noise(void) {
+    HarmonyXoshiro256 rng;
+    harmony_xoshiro256_seed(&rng, 5);
+    for (u32 n = 0; n < 100000; ++n) {
+        f32 p[4];
+        for (u32 i = 0; i < 4; ++i) {
+            p[i] = harmony_xoshiro256_f32(&rng) * 100.0f - 50.0f;
+        }
+        f32 samples[] = {
+            harmony_perlin_2d(n, p[0], p[1]),
+            harmony_perlin_3d(n, p[0], p[1], p[2]),
+            harmony_perlin_4d(n, p[0], p[1], p[2], p[3]),
+            harmony_simplex_2d(n, p[0], p[1]),
+            harmony_simplex_3d(n, p[0], p[1], p[2]),
+            harmony_simplex_4d(n, p[0], p[1], p[2], p[3]),
+        };
+        f32 nearby[] = {
+            harmony_perlin_2d(n, p[0] + 1.0e-3f, p[1]),
+            harmony_perlin_3d(n, p[0], p[1] + 1.0e-3f, p[2]),
+            harmony_perlin_4d(n, p[0], p[1], p[2], p[3] + 1.0e-3f),
+            harmony_simplex_2d(n, p[0] + 1.0e-3f, p[1]),
+            harmony_simplex_3d(n, p[0], p[1] + 1.0e-3f, p[2]),
+            harmony_simplex_4d(n, p[0], p[1], p[2], p[3] + 1.0e-3f),
+        };
+        for (u32 i = 0; i < harmony_countof(samples); ++i) {
+            harmony_assert(fabsf(samples[i]) <= 1.05f);
+            harmony_assert(fabsf(samples[i] - nearby[i]) < 0.02f);
+        }
+    }
+    harmony_assert(harmony_perlin_2d(1, 3.0f, -7.0f) == 0.0f);
+    harmony_assert(harmony_perlin_3d(1, 3.0f, -7.0f, 2.0f) == 0.0f);
+    harmony_assert(harmony_perlin_2d(1, 0.5f, 0.5f) != harmony_perlin_2d(2, 0.5f, 0.5f));
+
+    HarmonyNoise noise;
+    harmony_noise_seed(&noise, 77);
+    HarmonyNoiseRegion region = {
+        .origin = {-3.5f, 2.25f, 0.75f, 1.5f},
+        .step = {0.37f, 0.29f, 0.41f},
+        .width = 45,
+        .height = 7,
+        .depth = 3,
+    };
+    usize count = (usize)region.width * region.height * region.depth;
+    f32 *samples = malloc(count * sizeof(*samples));
+    f32 *parallel = malloc(count * sizeof(*parallel));
+    for (u32 dimensions = 2; dimensions <= 4; ++dimensions) {
+        for (u32 type = HARMONY_NOISE_PERLIN; type <= HARMONY_NOISE_SIMPLEX; ++type) {
+            for (u32 fractal = HARMONY_NOISE_FBM; fractal <= HARMONY_NOISE_RIDGED; ++fractal) {
+                HarmonyNoiseConfig config = {
+                    .dimensions = dimensions,
+                    .type = (HarmonyNoiseType)type,
+                    .fractal = (HarmonyNoiseFractal)fractal,
+                    .octaves = 5,
+                    .frequency = 0.8f,
+                    .lacunarity = 2.0f,
+                    .gain = 0.5f,
+                };
+                region.depth = dimensions == 2 ? 1 : 3;
+                harmony_noise_fill(samples, &noise, &config, &region);
+                harmony_noise_fill_parallel(4, parallel, &noise, &config, &region);
+                usize filled = (usize)region.width * region.height * region.depth;
+                harmony_assert(memcmp(samples, parallel, filled * sizeof(*samples)) == 0);
+
+                for (u32 z = 0; z < region.depth; ++z) {
+                    for (u32 y = 0; y < region.height; ++y) {
+                        for (u32 x = 0; x < region.width; ++x) {
+                            f32 point[4] = {
+                                region.origin[0] + (f32)x * region.step[0],
+                                region.origin[1] + (f32)y * region.step[1],
+                                region.origin[2] + (f32)z * region.step[2],
+                                region.origin[3],
+                            };
+                            f32 sample = samples[(z * region.height + y) * region.width + x];
+                            harmony_assert(fabsf(sample - harmony_noise_sample(&noise, &config, point)) < 1.0e-5f);
+                            f32 min = fractal == HARMONY_NOISE_RIDGED ? 0.0f : -1.05f;
+                            f32 max = fractal == HARMONY_NOISE_RIDGED ? 1.0f : 1.05f;
+                            harmony_assert(sample >= min && sample <= max);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    free(parallel);
+    free(samples);
+}
+
+static void test_fft_reference(Complex *dst, const Complex *src, usize size, usize stride) {
+    for (usize k = 0; k < size; ++k) {
+        f64 r = 0.0;
+        f64 i = 0.0;
+        for (usize n = 0; n < size; ++n) {
+            f64 angle = -2.0 * PI * (f64)((k * n) % size) / (f64)size;
+            r += src[n * stride].r * cos(angle) - src[n * stride].i * sin(angle);
+            i += src[n * stride].r * sin(angle) + src[n * stride].i * cos(angle);
+        }
+        dst[k * stride] = (Complex){(f32)r, (f32)i};
+    }
+}
+
+static bool test_fft_nearly_equal(const Complex *lhs, const Complex *rhs, usize count, f32 tolerance) {
+    for (usize i = 0; i < count; ++i) {
+        if (fabsf(lhs[i].r - rhs[i].r) > tolerance || fabsf(lhs[i].i - rhs[i].i) > tolerance)
+            return false;
+    }
+    return true;
+}
+
+static void test_fft(void) {
+    HarmonyAllocator allocator = harmony_default_allocator();
+    usize max_size = 1024;
+    Complex *input = malloc(max_size * sizeof(*input));
+    Complex *output = malloc((max_size + 1) * sizeof(*output));
+    Complex *expected = malloc(max_size * sizeof(*expected));
+    f32 *real = malloc(max_size * sizeof(*real));
+
+    usize sizes[] = {1, 2, 3, 4, 5, 6, 7, 8, 12, 15, 16, 17, 18, 64, 100, 243, 1024};
+    for (usize s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+        usize size = sizes[s];
+        f32 tolerance = 1.0e-4f * sqrtf((f32)size) * 4.0f;
+        for (usize i = 0; i < size; ++i) {
+            input[i] = (Complex){test_random_f32(), test_random_f32()};
+        }
+        test_fft_reference(expected, input, size, 1);
+
+        HarmonyFftPlan plan = harmony_fft_plan_create(&allocator, size);
+        harmony_fft(&plan, output, input);
+        harmony_assert(test_fft_nearly_equal(output, expected, size, tolerance));
+
+        harmony_fft_inverse(&plan, output, output);
+        harmony_assert(test_fft_nearly_equal(output, input, size, 1.0e-5f * 8.0f));
+
+        memcpy(output, input, size * sizeof(*output));
+        harmony_fft(&plan, output, output);
+        harmony_assert(test_fft_nearly_equal(output, expected, size, tolerance));
+        harmony_fft_plan_destroy(&allocator, &plan);
+
+        if (size % 2 != 0)
+            continue;
+        for (usize i = 0; i < size; ++i) {
+            real[i] = input[i].r;
+            input[i].i = 0.0f;
+        }
+        test_fft_reference(expected, input, size, 1);
+        HarmonyFftPlan real_plan = harmony_fft_real_plan_create(&allocator, size);
+        harmony_fft_real(&real_plan, output, real);
+        harmony_assert(test_fft_nearly_equal(output, expected, size / 2 + 1, tolerance));
+        harmony_fft_real_inverse(&real_plan, real, output);
+        for (usize i = 0; i < size; ++i) {
+            harmony_assert(fabsf(real[i] - input[i].r) < 1.0e-4f);
+        }
+        harmony_fft_plan_destroy(&allocator, &real_plan);
+    }
+
+    usize width = 12;
+    usize height = 10;
+    for (usize i = 0; i < width * height; ++i) {
+        input[i] = (Complex){test_random_f32(), test_random_f32()};
+    }
+    Complex *rows = malloc(width * height * sizeof(*rows));
+    for (usize y = 0; y < height; ++y) {
+        test_fft_reference(rows + y * width, input + y * width, width, 1);
+    }
+    for (usize x = 0; x < width; ++x) {
+        test_fft_reference(expected + x, rows + x, height, width);
+    }
+    HarmonyFft2dPlan plan_2d = harmony_fft_2d_plan_create(&allocator, width, height);
+    harmony_fft_2d(&plan_2d, output, input);
+    harmony_assert(test_fft_nearly_equal(output, expected, width * height, 1.0e-4f * 16.0f));
+    harmony_fft_2d_inverse(&plan_2d, output, output);
+    harmony_assert(test_fft_nearly_equal(output, input, width * height, 1.0e-5f * 8.0f));
+    harmony_fft_2d_plan_destroy(&allocator, &plan_2d);
+
+    free(rows);
+    free(real);
+    free(expected);
+    free(output);
+    free(input);
+}
+
+static void test_approx(void) {
+    usize count = 100003;
+    f32 *x = malloc(count * sizeof(*x));
+    f32 *y = malloc(count * sizeof(*y));
+    f32 *sines = malloc(count * sizeof(*sines));
+    f32 *cosines = malloc(count * sizeof(*cosines));
+
+    for (usize i = 0; i < count; ++i) {
+        x[i] = test_random_f32() * 8192.0f;
+    }
+    harmony_approx_sincos(sines, cosines, x, count);
+    for (usize i = 0; i < count; ++i) {
+        harmony_assert(fabs(sines[i] - sin((f64)x[i])) < 1.2e-7);
+        harmony_assert(fabs(cosines[i] - cos((f64)x[i])) < 1.2e-7);
+    }
+
+    for (usize i = 0; i < count; ++i) {
+        x[i] = test_random_f32() * 126.0f;
+    }
+    harmony_approx_exp2(y, x, count);
+    for (usize i = 0; i < count; ++i) {
+        f64 expected = exp2((f64)x[i]);
+        harmony_assert(fabs(y[i] - expected) < 1.5e-7 * expected);
+    }
+    harmony_approx_exp2(y, (f32[]){-1000.0f, 1000.0f}, 2);
+    harmony_assert(y[0] == exp2f(-126.0f) && y[1] == exp2f(127.0f));
+
+    for (usize i = 0; i < count; ++i) {
+        x[i] = exp2f(test_random_f32() * 120.0f);
+    }
+    harmony_approx_log2(y, x, count);
+    for (usize i = 0; i < count; ++i) {
+        f64 expected = log2((f64)x[i]);
+        harmony_assert(fabs(y[i] - expected) < 1.2e-7 * harmony_max(fabs(expected), 1.0));
+    }
+
+    harmony_approx_rsqrt(y, x, count);
+    for (usize i = 0; i < count; ++i) {
+        f64 expected = 1.0 / sqrt((f64)x[i]);
+        harmony_assert(fabs(y[i] - expected) < 4.8e-6 * expected);
+    }
+
+    for (usize i = 0; i < count; ++i) {
+        x[i] = test_random_f32() * (f32)(1 + i % 7);
+        y[i] = test_random_f32() * (f32)(1 + i % 5);
+    }
+    // the signed zeros on the axes, within the first 8 lanes so every tier sees them
+    f32 axis_y[5] = {0.0f, -0.0f, 0.0f, -0.0f, -0.0f};
+    f32 axis_x[5] = {0.0f, -1.0f, -1.0f, 1.0f, 0.0f};
+    memcpy(y, axis_y, sizeof(axis_y));
+    memcpy(x, axis_x, sizeof(axis_x));
+    harmony_approx_atan2(sines, y, x, count);
+    harmony_assert(sines[0] == 0.0f && !signbit(sines[0]));
+    for (usize i = 1; i < 4; ++i) {
+        harmony_assert(sines[i] == atan2f(y[i], x[i]));
+        harmony_assert(!signbit(sines[i]) == !signbit(y[i]));
+    }
+    harmony_assert(sines[4] == 0.0f && signbit(sines[4]));
+    for (usize i = 5; i < count; ++i) {
+        harmony_assert(fabs(sines[i] - atan2((f64)y[i], (f64)x[i])) < 3.0e-7);
+    }
+
+    free(cosines);
+    free(sines);
+    free(y);
+    free(x);
+}
+
+/**
+ * Computes every approximate function of src, writing 6 * count values
+ */
+static void test_approx_all(f32 *dst, const f32 *src, usize count) {
+    harmony_approx_sincos(dst, dst + count, src, count);
+    harmony_approx_exp2(dst + 2 * count, src, count);
+    harmony_approx_atan2(dst + 3 * count, src, src + count, count);
+    for (usize i = 0; i < count; ++i) {
+        dst[4 * count + i] = fabsf(src[i]) + 1.0f;
+    }
+    harmony_approx_log2(dst + 5 * count, dst + 4 * count, count);
+    harmony_approx_rsqrt(dst + 4 * count, dst + 4 * count, count);
+}
+
+static Quat test_random_quat(void) {
+    Quat q = {test_random_f32(), test_random_f32(), test_random_f32(), test_random_f32()};
+    f32 len = sqrtf(q.r * q.r + q.i * q.i + q.j * q.j + q.k * q.k);
+    return (Quat){q.r / len, q.i / len, q.j / len, q.k / len};
+}
+
+static void test_model_matrices(void) {
+    usize count = 203;
+    f32 *streams = malloc(17 * count * sizeof(*streams));
+    HarmonyModelStreams2D models_2d;
+    HarmonyModelStreams3D models_3d;
+    for (u32 c = 0; c < 3; ++c) {
+        models_2d.position[c] = models_3d.position[c] = streams + c * count;
+        models_3d.scale[c] = streams + (3 + c) * count;
+    }
+    models_2d.scale[0] = models_3d.scale[0];
+    models_2d.scale[1] = models_3d.scale[1];
+    models_2d.rotation = streams + 6 * count;
+    for (u32 c = 0; c < 4; ++c) {
+        models_3d.rotation[c] = streams + (7 + c) * count;
+    }
+    for (usize i = 0; i < count; ++i) {
+        Quat q = test_random_quat();
+        for (u32 c = 0; c < 3; ++c) {
+            streams[c * count + i] = test_random_f32() * 100.0f;
+            streams[(3 + c) * count + i] = 0.5f + test_random_f32() * 0.25f;
+        }
+        streams[6 * count + i] = test_random_f32() * 10.0f;
+        for (u32 c = 0; c < 4; ++c) {
+            streams[(7 + c) * count + i] = ((f32 *)&q)[c];
+        }
+    }
+
+    Mat4 *serial = malloc((count + 1) * sizeof(*serial));
+    Mat4 *parallel = malloc((count + 1) * sizeof(*parallel));
+    Mat4 sentinel;
+    memset(&sentinel, 0x5a, sizeof(sentinel));
+
+    serial[count] = sentinel;
+    harmony_model_matrices_2d(serial, &models_2d, count);
+    harmony_assert(memcmp(&serial[count], &sentinel, sizeof(sentinel)) == 0);
+    for (usize i = 0; i < count; ++i) {
+        Vec3 position = {models_2d.position[0][i], models_2d.position[1][i], models_2d.position[2][i]};
+        Vec2 scale = {models_2d.scale[0][i], models_2d.scale[1][i]};
+        f32 rotation = models_2d.rotation[i];
+        Mat4 single = harmony_model_matrix_2d(position, scale, rotation);
+        Mat4 expected = {
+            {cosf(rotation) * scale.x, sinf(rotation) * scale.x, 0.0f, 0.0f},
+            {-sinf(rotation) * scale.y, cosf(rotation) * scale.y, 0.0f, 0.0f},
+            {0.0f, 0.0f, 1.0f, 0.0f},
+            {position.x, position.y, position.z, 1.0f},
+        };
+        harmony_assert(memcmp(&single, &expected, sizeof(single)) == 0);
+        harmony_assert(test_nearly_equal((f32 *)&serial[i], (f32 *)&single, 12));
+        harmony_assert(memcmp(&serial[i].w, &single.w, sizeof(Vec4)) == 0);
+    }
+    parallel[count] = sentinel;
+    harmony_model_matrices_2d_parallel(3, parallel, &models_2d, count);
+    harmony_assert(memcmp(parallel, serial, (count + 1) * sizeof(*serial)) == 0);
+
+    harmony_model_matrices_3d(serial, &models_3d, count);
+    harmony_assert(memcmp(&serial[count], &sentinel, sizeof(sentinel)) == 0);
+    for (usize i = 0; i < count; ++i) {
+        Vec3 position = {models_3d.position[0][i], models_3d.position[1][i], models_3d.position[2][i]};
+        Vec3 scale = {models_3d.scale[0][i], models_3d.scale[1][i], models_3d.scale[2][i]};
+        Quat rotation = {
+            models_3d.rotation[0][i], models_3d.rotation[1][i], models_3d.rotation[2][i], models_3d.rotation[3][i],
+        };
+        Mat4 single = harmony_model_matrix_3d(position, scale, rotation);
+        harmony_assert(test_nearly_equal((f32 *)&serial[i], (f32 *)&single, 12));
+        harmony_assert(memcmp(&serial[i].w, &single.w, sizeof(Vec4)) == 0);
+    }
+    harmony_model_matrices_3d_parallel(3, parallel, &models_3d, count);
+    harmony_assert(memcmp(parallel, serial, (count + 1) * sizeof(*serial)) == 0);
+
+    free(parallel);
+    free(serial);
+    free(streams);
+}
+
+static void test_quats(void) {
+    usize count = 1003;
+    f32 *streams = malloc(22 * count * sizeof(*streams));
+    HarmonyQuatStreams lhs, rhs, dst;
+    for (u32 c = 0; c < 4; ++c) {
+        lhs.components[c] = streams + c * count;
+        rhs.components[c] = streams + (4 + c) * count;
+        dst.components[c] = streams + (8 + c) * count;
+    }
+    f32 *t = streams + 12 * count;
+    HarmonyModelStreams3D models;
+    for (u32 c = 0; c < 3; ++c) {
+        models.position[c] = streams + (13 + c) * count;
+        models.scale[c] = streams + (16 + c) * count;
+    }
+    for (u32 c = 0; c < 4; ++c) {
+        models.rotation[c] = lhs.components[c];
+    }
+    for (usize i = 0; i < 18 * count; ++i) {
+        streams[4 * count + i] = test_random_f32();
+    }
+    for (usize i = 0; i < count; ++i) {
+        Quat q = test_random_quat();
+        lhs.components[0][i] = q.r;
+        lhs.components[1][i] = q.i;
+        lhs.components[2][i] = q.j;
+        lhs.components[3][i] = q.k;
+        t[i] = (test_random_f32() + 1.0f) * 0.5f;
+    }
+
+    harmony_quats_normalize(&dst, &rhs, count);
+    for (usize i = 0; i < count; ++i) {
+        f32 q[4];
+        for (u32 c = 0; c < 4; ++c) {
+            q[c] = rhs.components[c][i];
+        }
+        f32 len = sqrtf(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+        for (u32 c = 0; c < 4; ++c) {
+            harmony_assert(fabsf(dst.components[c][i] - q[c] / len) < 1.0e-6f);
+        }
+    }
+    harmony_quats_normalize(&rhs, &rhs, count);
+
+    Affine3 *affines = malloc(count * sizeof(*affines));
+    Mat3 *rotations = malloc(count * sizeof(*rotations));
+    harmony_model_affines_3d(affines, &models, count);
+    harmony_quats_to_mat3(rotations, &lhs, count);
+    for (usize i = 0; i < count; ++i) {
+        Vec3 position = {models.position[0][i], models.position[1][i], models.position[2][i]};
+        Vec3 scale = {models.scale[0][i], models.scale[1][i], models.scale[2][i]};
+        Quat rotation = {lhs.components[0][i], lhs.components[1][i], lhs.components[2][i], lhs.components[3][i]};
+        Affine3 expected = harmony_model_affine_3d(position, scale, rotation);
+        harmony_assert(test_nearly_equal((f32 *)&affines[i], (f32 *)&expected, 12));
+        Affine3 unit = harmony_model_affine_3d(position, (Vec3){1.0f, 1.0f, 1.0f}, rotation);
+        harmony_assert(test_nearly_equal((f32 *)&rotations[i], (f32 *)&unit, 9));
+    }
+    free(rotations);
+    free(affines);
+
+    for (u32 spherical = 0; spherical < 2; ++spherical) {
+        if (spherical)
+            harmony_quats_slerp(&dst, &lhs, &rhs, t, count);
+        else
+            harmony_quats_nlerp(&dst, &lhs, &rhs, t, count);
+        for (usize i = 0; i < count; ++i) {
+            f64 a[4], b[4], q[4];
+            f64 cos_angle = 0.0;
+            for (u32 c = 0; c < 4; ++c) {
+                a[c] = lhs.components[c][i];
+                b[c] = rhs.components[c][i];
+                cos_angle += a[c] * b[c];
+            }
+            f64 direction = cos_angle < 0.0 ? -1.0 : 1.0;
+            cos_angle = fabs(cos_angle);
+            f64 angle = acos(harmony_min(cos_angle, 1.0));
+            f64 lhs_weight = 1.0 - t[i];
+            f64 rhs_weight = t[i];
+            if (spherical) {
+                lhs_weight = sin(lhs_weight * angle) / sin(angle);
+                rhs_weight = sin(rhs_weight * angle) / sin(angle);
+            }
+            f64 len = 0.0;
+            for (u32 c = 0; c < 4; ++c) {
+                q[c] = a[c] * lhs_weight + b[c] * direction * rhs_weight;
+                len += q[c] * q[c];
+            }
+            for (u32 c = 0; c < 4; ++c) {
+                harmony_assert(fabs(dst.components[c][i] - q[c] / sqrt(len)) < 2.0e-6);
+            }
+        }
+    }
+
+    for (usize i = 0; i < count; ++i) {
+        for (u32 c = 0; c < 4; ++c) {
+            rhs.components[c][i] = -lhs.components[c][i];
+        }
+    }
+    harmony_quats_slerp(&dst, &lhs, &rhs, t, count);
+    for (u32 c = 0; c < 4; ++c) {
+        harmony_assert(test_nearly_equal(dst.components[c], lhs.components[c], (u32)count));
+    }
+
+    free(streams);
+}
+
+/**
+ * Computes every quaternion kernel of the models, writing 29 * count values
+ */
+static void test_quats_all(f32 *dst, const HarmonyModelStreams3D *models, const f32 *t, usize count) {
+    HarmonyQuatStreams lhs;
+    HarmonyQuatStreams rhs;
+    HarmonyQuatStreams out;
+    for (u32 c = 0; c < 4; ++c) {
+        lhs.components[c] = (f32 *)models->rotation[c];
+        rhs.components[c] = (f32 *)models->rotation[(c + 1) % 4];
+        out.components[c] = dst + c * count;
+    }
+    harmony_quats_slerp(&out, &lhs, &rhs, t, count);
+    for (u32 c = 0; c < 4; ++c) {
+        out.components[c] = dst + (4 + c) * count;
+    }
+    harmony_quats_nlerp(&out, &lhs, &rhs, t, count);
+    harmony_quats_normalize(&out, &out, count);
+    harmony_model_affines_3d((Affine3 *)(dst + 8 * count), models, count);
+    harmony_quats_to_mat3((Mat3 *)(dst + 20 * count), &lhs, count);
+}
+
+static void test_animation_reference(f32 *dst, const HarmonyAnimationKeys *keys, u32 components, f32 time) {
+    const f32 *values = keys->values;
+    u32 k = 0;
+    while (k + 1 < keys->count && keys->times[k + 1] <= time) {
+        ++k;
+    }
+    u32 next = k + 1 < keys->count ? k + 1 : k;
+    f32 alpha = next != k && time > keys->times[k] ? (time - keys->times[k]) / (keys->times[next] - keys->times[k]) : 0.0f;
+    f32 dot = 0.0f;
+    for (u32 c = 0; c < components; ++c) {
+        dot += values[k * components + c] * values[next * components + c];
+    }
+    f32 direction = components == 4 && dot < 0.0f ? -1.0f : 1.0f;
+    f32 len2 = 0.0f;
+    for (u32 c = 0; c < components; ++c) {
+        dst[c] = values[k * components + c] + (values[next * components + c] * direction - values[k * components + c]) * alpha;
+        len2 += dst[c] * dst[c];
+    }
+    for (u32 c = 0; components == 4 && c < 4; ++c) {
+        dst[c] /= sqrtf(len2);
+    }
+}
+
+static void test_animation(void) {
+    HarmonyAllocator allocator = harmony_default_allocator();
+    u32 joint_count = 5;
+    u32 key_count = 40;
+    f32 *times = malloc(key_count * sizeof(*times));
+    f32 *values = malloc(joint_count * HARMONY_ANIMATION_CHANNEL_COUNT * key_count * 4 * sizeof(*values));
+    for (u32 k = 0; k < key_count; ++k) {
+        times[k] = (f32)k * 0.05f + (k % 3 == 0 ? 0.02f : 0.0f);
+    }
+    HarmonyAnimationTrack tracks[5];
+    for (u32 joint = 0; joint < joint_count; ++joint) {
+        for (u32 channel = 0; channel < HARMONY_ANIMATION_CHANNEL_COUNT; ++channel) {
+            f32 *channel_values = values + (joint * HARMONY_ANIMATION_CHANNEL_COUNT + channel) * key_count * 4;
+            u32 count = key_count - joint * 7;
+            for (u32 k = 0; k < count; ++k) {
+                if (channel == HARMONY_ANIMATION_ROTATION) {
+                    Quat q = test_random_quat();
+                    memcpy(channel_values + k * 4, &q, sizeof(q));
+                } else {
+                    for (u32 c = 0; c < 3; ++c) {
+                        channel_values[k * 3 + c] = test_random_f32() * 10.0f;
+                    }
+                }
+            }
+            tracks[joint].channels[channel] = (HarmonyAnimationKeys){times, channel_values, count};
+        }
+    }
+    tracks[2].channels[HARMONY_ANIMATION_SCALE].count = 0;
+
+    HarmonyAnimationClip clip = harmony_animation_clip_create(&allocator, tracks, joint_count);
+    harmony_assert(clip.duration == times[key_count - 1]);
+    u32 instance_count = 3;
+    u32 cursor_count = harmony_animation_cursor_count(&clip);
+    u32 *cursors = calloc(instance_count * cursor_count, sizeof(*cursors));
+    u32 *fresh_cursors = calloc(instance_count * cursor_count, sizeof(*fresh_cursors));
+    usize pose_count = instance_count * joint_count;
+    Vec3 *translations = malloc(4 * pose_count * sizeof(*translations));
+    Vec3 *scales = malloc(4 * pose_count * sizeof(*scales));
+    Quat *rotations = malloc(4 * pose_count * sizeof(*rotations));
+    HarmonyPose poses[4];
+    for (u32 i = 0; i < 4; ++i) {
+        poses[i] = (HarmonyPose){translations + i * pose_count, rotations + i * pose_count, scales + i * pose_count};
+    }
+
+    for (u32 frame = 0; frame < 200; ++frame) {
+        f32 sample_times[3] = {
+            (f32)frame * 0.011f,
+            fmodf((f32)frame * 0.037f, clip.duration),
+            frame % 5 == 0 ? -1.0f : test_random_f32() * 3.0f,
+        };
+        harmony_animation_sample(&clip, cursors, sample_times, &poses[0], instance_count);
+        memset(fresh_cursors, 0, instance_count * cursor_count * sizeof(*fresh_cursors));
+        harmony_animation_sample_parallel(2, &clip, fresh_cursors, sample_times, &poses[1], instance_count);
+        harmony_assert(memcmp(translations, translations + pose_count, pose_count * sizeof(*translations)) == 0);
+        harmony_assert(memcmp(rotations, rotations + pose_count, pose_count * sizeof(*rotations)) == 0);
+        harmony_assert(memcmp(scales, scales + pose_count, pose_count * sizeof(*scales)) == 0);
+
+        for (u32 instance = 0; instance < instance_count; ++instance) {
+            f32 time = harmony_clamp(sample_times[instance], 0.0f, clip.duration);
+            for (u32 joint = 0; joint < joint_count; ++joint) {
+                usize index = instance * joint_count + joint;
+                f32 expected[4];
+                test_animation_reference(expected, &tracks[joint].channels[HARMONY_ANIMATION_TRANSLATION], 3, time);
+                harmony_assert(fabsf(translations[index].x - expected[0]) < 1.0e-3f);
+                harmony_assert(fabsf(translations[index].y - expected[1]) < 1.0e-3f);
+                harmony_assert(fabsf(translations[index].z - expected[2]) < 1.0e-3f);
+                test_animation_reference(expected, &tracks[joint].channels[HARMONY_ANIMATION_ROTATION], 4, time);
+                harmony_assert(fabsf(rotations[index].r - expected[0]) < 1.0e-3f);
+                harmony_assert(fabsf(rotations[index].i - expected[1]) < 1.0e-3f);
+                harmony_assert(fabsf(rotations[index].j - expected[2]) < 1.0e-3f);
+                harmony_assert(fabsf(rotations[index].k - expected[3]) < 1.0e-3f);
+                if (joint == 2) {
+                    harmony_assert(scales[index].x == 1.0f && scales[index].y == 1.0f && scales[index].z == 1.0f);
+                } else {
+                    test_animation_reference(expected, &tracks[joint].channels[HARMONY_ANIMATION_SCALE], 3, time);
+                    harmony_assert(fabsf(scales[index].x - expected[0]) < 1.0e-3f);
+                }
+            }
+        }
+    }
+
+    f32 weights[15];
+    for (u32 i = 0; i < pose_count; ++i) {
+        weights[i] = i % 3 == 0 ? 0.0f : i % 3 == 1 ? 1.0f : 0.5f;
+        poses[1].rotations[i] = test_random_quat();
+        poses[1].translations[i] = (Vec3){test_random_f32(), test_random_f32(), test_random_f32()};
+    }
+    harmony_pose_blend(&poses[2], &poses[0], &poses[1], weights, pose_count);
+    for (u32 i = 0; i < pose_count; ++i) {
+        Quat a = poses[0].rotations[i];
+        Quat b = poses[1].rotations[i];
+        Quat q = poses[2].rotations[i];
+        f32 direction = a.r * b.r + a.i * b.i + a.j * b.j + a.k * b.k < 0.0f ? -1.0f : 1.0f;
+        if (weights[i] == 0.0f) {
+            harmony_assert(test_nearly_equal((f32 *)&q, (f32 *)&a, 4));
+            harmony_assert(test_nearly_equal((f32 *)&poses[2].translations[i], (f32 *)&poses[0].translations[i], 3));
+        } else if (weights[i] == 1.0f) {
+            Quat expected = {b.r * direction, b.i * direction, b.j * direction, b.k * direction};
+            harmony_assert(test_nearly_equal((f32 *)&q, (f32 *)&expected, 4));
+            harmony_assert(test_nearly_equal((f32 *)&poses[2].translations[i], (f32 *)&poses[1].translations[i], 3));
+        } else {
+            f32 lhs_dot = fabsf(q.r * a.r + q.i * a.i + q.j * a.j + q.k * a.k);
+            f32 rhs_dot = fabsf(q.r * b.r + q.i * b.i + q.j * b.j + q.k * b.k);
+            harmony_assert(fabsf(lhs_dot - rhs_dot) < 1.0e-5f);
+            harmony_assert(fabsf(poses[2].scales[i].y - (poses[0].scales[i].y + poses[1].scales[i].y) * 0.5f) < 1.0e-5f);
+        }
+    }
+
+    free(rotations);
+    free(scales);
+    free(translations);
+    free(fresh_cursors);
+    free(cursors);
+    harmony_animation_clip_destroy(&allocator, &clip);
+    free(values);
+    free(times);
+}
+
+static Affine3 test_transform_reference(
+    const u32 *parents,
+    const Vec3 *positions,
+    const Vec3 *scales,
+    const Quat *rotations,
+    u32 handle
+) {
+    Affine3 world = harmony_model_affine_3d(positions[handle], scales[handle], rotations[handle]);
+    for (u32 parent = parents[handle]; parent != HARMONY_TRANSFORM_NONE; parent = parents[parent]) {
+        world = acompose(harmony_model_affine_3d(positions[parent], scales[parent], rotations[parent]), world);
+    }
+    return world;
+}
+
+static void test_transforms(void) {
+    HarmonyAllocator allocator = harmony_default_allocator();
+    u32 count = 500;
+    HarmonyTransformHierarchy hierarchy = harmony_transform_hierarchy_create(&allocator, count);
+    HarmonyTransformHierarchy parallel = harmony_transform_hierarchy_create(&allocator, count);
+    u32 *parents = malloc(count * sizeof(*parents));
+    Vec3 *positions = malloc(count * sizeof(*positions));
+    Vec3 *scales = malloc(count * sizeof(*scales));
+    Quat *rotations = malloc(count * sizeof(*rotations));
+
+    for (u32 handle = 0; handle < count; ++handle) {
+        parents[handle] = handle < 3 || rand() % 10 == 0 ? HARMONY_TRANSFORM_NONE : (u32)rand() % handle;
+        positions[handle] = (Vec3){test_random_f32(), test_random_f32(), test_random_f32()};
+        scales[handle] = (Vec3){1.0f + test_random_f32() * 0.2f, 1.0f, 1.0f - test_random_f32() * 0.2f};
+        rotations[handle] = test_random_quat();
+        harmony_assert(harmony_transform_add(&hierarchy, parents[handle], positions[handle], scales[handle], rotations[handle]) == handle);
+        harmony_assert(harmony_transform_add(&parallel, parents[handle], positions[handle], scales[handle], rotations[handle]) == handle);
+    }
+
+    harmony_assert(harmony_transform_update(&hierarchy) == count);
+    harmony_assert(harmony_transform_update_parallel(3, &parallel) == count);
+    harmony_assert(memcmp(hierarchy.worlds, parallel.worlds, count * sizeof(Affine3)) == 0);
+    for (u32 handle = 0; handle < count; ++handle) {
+        Affine3 expected = test_transform_reference(parents, positions, scales, rotations, handle);
+        Affine3 world = harmony_transform_world(&hierarchy, handle);
+        for (u32 i = 0; i < 12; ++i) {
+            harmony_assert(fabsf(((f32 *)&world)[i] - ((f32 *)&expected)[i]) < 1.0e-3f);
+        }
+    }
+    harmony_assert(harmony_transform_update(&hierarchy) == 0);
+    harmony_assert(harmony_transform_update_parallel(3, &parallel) == 0);
+
+    u32 moved = 17;
+    positions[moved] = (Vec3){2.0f, -1.0f, 0.5f};
+    harmony_transform_set(&hierarchy, moved, positions[moved], scales[moved], rotations[moved]);
+    harmony_transform_set(&parallel, moved, positions[moved], scales[moved], rotations[moved]);
+    u32 subtree = 0;
+    for (u32 handle = 0; handle < count; ++handle) {
+        u32 ancestor = handle;
+        while (ancestor != moved && ancestor != HARMONY_TRANSFORM_NONE) {
+            ancestor = parents[ancestor];
+        }
+        subtree += ancestor == moved;
+    }
+    harmony_assert(harmony_transform_update(&hierarchy) == subtree);
+    harmony_assert(harmony_transform_update_parallel(3, &parallel) == subtree);
+    harmony_assert(memcmp(hierarchy.worlds, parallel.worlds, count * sizeof(Affine3)) == 0);
+    for (u32 handle = 0; handle < count; ++handle) {
+        Affine3 expected = test_transform_reference(parents, positions, scales, rotations, handle);
+        Affine3 world = harmony_transform_world(&parallel, handle);
+        for (u32 i = 0; i < 12; ++i) {
+            harmony_assert(fabsf(((f32 *)&world)[i] - ((f32 *)&expected)[i]) < 1.0e-3f);
+        }
+    }
+
+    free(rotations);
+    free(scales);
+    free(positions);
+    free(parents);
+    harmony_transform_hierarchy_destroy(&allocator, &parallel);
+    harmony_transform_hierarchy_destroy(&allocator, &hierarchy);
+}
+
+static f32 test_cull_distance(const HarmonyFrustum *frustum, const f32 *const *bounds, usize index, bool spheres) {
+    f32 nearest = INFINITY;
+    for (u32 p = 0; p < 6; ++p) {
+        const f32 *plane = (const f32 *)&frustum->planes[p];
+        f32 distance = plane[3] + (spheres ? bounds[3][index] : 0.0f);
+        for (u32 c = 0; c < 3; ++c) {
+            f32 corner = spheres || plane[c] < 0.0f ? bounds[c][index] : bounds[3 + c][index];
+            distance += plane[c] * corner;
+        }
+        nearest = harmony_min(nearest, distance);
+    }
+    return nearest;
+}
+
+static void test_culling(void) {
+    Mat4 projection = harmony_perspective_projection(1.2f, 1.5f, 0.5f, 20.0f);
+    Mat4 view = harmony_view_matrix((Vec3){1.0f, 0.5f, -3.0f}, 1.0f, (Quat){cosf(0.15f), 0.0f, sinf(0.15f), 0.0f});
+    Mat4 view_projection;
+    mmul((f32 *)&view_projection, 4, 4, (f32 *)&projection, 4, 4, (f32 *)&view);
+    HarmonyFrustum frustum = harmony_frustum_create(view_projection);
+
+    u32 inside_count = 0;
+    for (u32 n = 0; n < 1000; ++n) {
+        Vec4 point = {test_random_f32() * 20.0f, test_random_f32() * 20.0f, test_random_f32() * 20.0f, 1.0f};
+        Vec4 clip;
+        mvmul(4, 4, (f32 *)&clip, (f32 *)&view_projection, (f32 *)&point);
+        f32 margin = 1.0e-3f * clip.w;
+        bool inside = clip.w > 0.0f && fabsf(clip.x) < clip.w - margin && fabsf(clip.y) < clip.w - margin
+                   && clip.z > margin && clip.z < clip.w - margin;
+        bool outside = clip.w <= 0.0f || fabsf(clip.x) > clip.w + margin || fabsf(clip.y) > clip.w + margin
+                    || clip.z < -margin || clip.z > clip.w + margin;
+        f32 nearest = INFINITY;
+        for (u32 p = 0; p < 6; ++p) {
+            Vec4 plane = frustum.planes[p];
+            nearest = harmony_min(nearest, plane.x * point.x + plane.y * point.y + plane.z * point.z + plane.w);
+        }
+        if (inside) {
+            harmony_assert(nearest > 0.0f);
+            ++inside_count;
+        }
+        if (outside) {
+            harmony_assert(nearest < 0.0f);
+        }
+    }
+    harmony_assert(inside_count > 0);
+
+    usize count = 1003;
+    usize words = (count + 31) / 32;
+    f32 *bounds = malloc(10 * count * sizeof(*bounds));
+    u32 *visible = malloc(2 * words * sizeof(*visible));
+    u32 *indices = malloc(count * sizeof(*indices));
+    for (usize i = 0; i < count; ++i) {
+        for (u32 c = 0; c < 3; ++c) {
+            f32 center = test_random_f32() * 25.0f;
+            f32 extent = (test_random_f32() + 1.0f) * 2.0f;
+            bounds[c * count + i] = center - extent;
+            bounds[(3 + c) * count + i] = center + extent;
+            bounds[(6 + c) * count + i] = center;
+        }
+        bounds[9 * count + i] = (test_random_f32() + 1.0f) * 2.0f;
+    }
+    // a box around the camera, with every corner outside the frustum
+    for (u32 c = 0; c < 3; ++c) {
+        bounds[c * count] = -100.0f;
+        bounds[(3 + c) * count] = 100.0f;
+    }
+    HarmonyAabbStreams aabbs = {
+        {bounds, bounds + count, bounds + 2 * count},
+        {bounds + 3 * count, bounds + 4 * count, bounds + 5 * count},
+    };
+    HarmonySphereStreams spheres = {{bounds + 6 * count, bounds + 7 * count, bounds + 8 * count}, bounds + 9 * count};
+    const f32 *aabb_bounds[6] = {aabbs.min[0], aabbs.min[1], aabbs.min[2], aabbs.max[0], aabbs.max[1], aabbs.max[2]};
+    const f32 *sphere_bounds[4] = {spheres.center[0], spheres.center[1], spheres.center[2], spheres.radius};
+
+    for (u32 shape = 0; shape < 2; ++shape) {
+        bool is_sphere = shape == 1;
+        if (is_sphere) {
+            harmony_cull_spheres(visible, &frustum, &spheres, count);
+            harmony_cull_spheres_parallel(3, visible + words, &frustum, &spheres, count);
+        } else {
+            harmony_cull_aabbs(visible, &frustum, &aabbs, count);
+            harmony_cull_aabbs_parallel(3, visible + words, &frustum, &aabbs, count);
+        }
+        harmony_assert(memcmp(visible, visible + words, words * sizeof(*visible)) == 0);
+        harmony_assert(visible[words - 1] >> (count & 31) == 0);
+
+        usize visible_count = 0;
+        usize expected_count = 0;
+        for (usize i = 0; i < count; ++i) {
+            bool bit = (visible[i / 32] >> (i & 31)) & 1;
+            f32 nearest = test_cull_distance(&frustum, is_sphere ? sphere_bounds : aabb_bounds, i, is_sphere);
+            if (fabsf(nearest) > 1.0e-4f) {
+                harmony_assert(bit == (nearest > 0.0f));
+            }
+            visible_count += bit;
+        }
+        harmony_assert(visible_count > 0 && visible_count < count);
+        if (!is_sphere) {
+            harmony_assert(visible[0] & 1);
+        }
+        expected_count = harmony_visible_indices(indices, visible, count);
+        harmony_assert(expected_count == visible_count);
+        for (usize i = 0; i < expected_count; ++i) {
+            harmony_assert((visible[indices[i] / 32] >> (indices[i] & 31)) & 1);
+            if (i > 0) {
+                harmony_assert(indices[i] > indices[i - 1]);
+            }
+        }
+    }
+
+    free(indices);
+    free(visible);
+    free(bounds);
+}
+
+static bool test_ray_triangles_reference(
+    const Vec3 *vertices,
+    const u32 *indices,
+    u32 count,
+    Vec3 origin,
+    Vec3 direction,
+    f32 max_distance,
+    HarmonyRayHit *hit
+) {
+    HarmonyRayHit best = {max_distance, 0.0f, 0.0f, UINT32_MAX};
+    for (u32 i = 0; i < count; ++i) {
+        HarmonyRayHit candidate = {.index = i};
+        if (harmony_ray_triangle(origin, direction,
+                vertices[indices[3 * i]], vertices[indices[3 * i + 1]], vertices[indices[3 * i + 2]], best.distance, &candidate)
+            && candidate.distance < best.distance)
+            best = candidate;
+    }
+    *hit = best;
+    return best.index != UINT32_MAX;
+}
+
+static bool test_ray_aabbs_reference(
+    const HarmonyAabbStreams *bounds,
+    u32 count,
+    Vec3 origin,
+    Vec3 direction,
+    f32 max_distance,
+    HarmonyRayHit *hit
+) {
+    HarmonyRayHit best = {max_distance, 0.0f, 0.0f, UINT32_MAX};
+    for (u32 i = 0; i < count; ++i) {
+        f32 near = 0.0f;
+        f32 far = INFINITY;
+        for (u32 axis = 0; axis < 3; ++axis) {
+            f32 lower = bounds->min[axis][i] - ((const f32 *)&origin)[axis];
+            f32 upper = bounds->max[axis][i] - ((const f32 *)&origin)[axis];
+            f32 inverse = 1.0f / ((const f32 *)&direction)[axis];
+            if (isinf(inverse)) {
+                if (lower > 0.0f || upper < 0.0f) {
+                    near = INFINITY;
+                    far = -INFINITY;
+                }
+                continue;
+            }
+            near = harmony_max(near, harmony_min(lower * inverse, upper * inverse));
+            far = harmony_min(far, harmony_max(lower * inverse, upper * inverse));
+        }
+        if (near <= harmony_min(far, best.distance) && near < best.distance)
+            best = (HarmonyRayHit){near, 0.0f, 0.0f, i};
+    }
+    *hit = best;
+    return best.index != UINT32_MAX;
+}
+
+static void test_bvh_rays(const HarmonyBvh *bvh, const Vec3 *vertices, const u32 *indices, const HarmonyAabbStreams *bounds, u32 count) {
+    for (u32 n = 0; n < 3000; ++n) {
+        Vec3 origin = {test_random_f32() * 12.0f, test_random_f32() * 4.0f + 3.0f, test_random_f32() * 12.0f};
+        Vec3 direction = {test_random_f32(), test_random_f32(), test_random_f32()};
+        if (n % 3 == 0) {
+            // straight down through a grid vertex, hitting where triangles meet
+            origin = (Vec3){(f32)(rand() % 21 - 10), 5.0f, (f32)(rand() % 21 - 10)};
+            direction = (Vec3){0.0f, -1.0f, 0.0f};
+        } else if (n % 3 == 1) {
+            ((f32 *)&direction)[n % 2] = 0.0f;
+        }
+        f32 max_distance = n % 4 == 0 ? 4.0f : INFINITY;
+
+        HarmonyRayHit hit = {0};
+        HarmonyRayHit expected;
+        bool found = test_ray_triangles_reference(vertices, indices, count, origin, direction, max_distance, &expected);
+        harmony_assert(harmony_bvh_ray_triangles(bvh, vertices, indices, origin, direction, max_distance, &hit) == found);
+        harmony_assert(harmony_bvh_ray_triangles_any(bvh, vertices, indices, origin, direction, max_distance) == found);
+        if (found) {
+            harmony_assert(memcmp(&hit, &expected, sizeof(hit)) == 0);
+        }
+
+        found = test_ray_aabbs_reference(bounds, count, origin, direction, max_distance, &expected);
+        harmony_assert(harmony_bvh_ray_aabbs(bvh, bounds, origin, direction, max_distance, &hit) == found);
+        if (found) {
+            harmony_assert(memcmp(&hit, &expected, sizeof(hit)) == 0);
+        }
+    }
+}
+
+static void test_bvh(void) {
+    HarmonyAllocator allocator = harmony_default_allocator();
+    u32 grid = 20;
+    u32 vertex_count = (grid + 1) * (grid + 1) + 3 * 600;
+    u32 count = 2 * grid * grid + 600;
+    Vec3 *vertices = malloc(vertex_count * sizeof(*vertices));
+    u32 *indices = malloc(3 * count * sizeof(*indices));
+    f32 *streams = malloc(6 * count * sizeof(*streams));
+    u32 *overlaps = malloc(count * sizeof(*overlaps));
+    bool *seen = malloc(count * sizeof(*seen));
+
+    // a bumpy grid from -10 to 10 sharing its edges, then loose triangles
+    for (u32 z = 0; z <= grid; ++z) {
+        for (u32 x = 0; x <= grid; ++x) {
+            vertices[z * (grid + 1) + x] = (Vec3){(f32)x - 10.0f, test_random_f32() * 0.5f, (f32)z - 10.0f};
+        }
+    }
+    u32 t = 0;
+    for (u32 z = 0; z < grid; ++z) {
+        for (u32 x = 0; x < grid; ++x) {
+            u32 corner = z * (grid + 1) + x;
+            u32 quad[6] = {corner, corner + 1, corner + grid + 1, corner + 1, corner + grid + 2, corner + grid + 1};
+            memcpy(indices + 3 * t, quad, sizeof(quad));
+            t += 2;
+        }
+    }
+    for (u32 v = (grid + 1) * (grid + 1); t < count; ++t) {
+        Vec3 center = {test_random_f32() * 10.0f, test_random_f32() * 3.0f + 1.0f, test_random_f32() * 10.0f};
+        for (u32 c = 0; c < 3; ++c, ++v) {
+            vertices[v] = vadd3(center, (Vec3){test_random_f32(), test_random_f32(), test_random_f32()});
+            indices[3 * t + c] = v;
+        }
+    }
+    HarmonyAabbStreams bounds;
+    for (u32 axis = 0; axis < 3; ++axis) {
+        bounds.min[axis] = streams + axis * count;
+        bounds.max[axis] = streams + (3 + axis) * count;
+    }
+    harmony_triangle_bounds(&bounds, vertices, indices, count);
+
+    HarmonyBvh bvh = harmony_bvh_create(&allocator, &bounds, count);
+    HarmonyBvh parallel = harmony_bvh_create_parallel(3, &allocator, &bounds, count);
+    harmony_assert(bvh.node_count == parallel.node_count);
+    harmony_assert(memcmp(bvh.nodes, parallel.nodes, bvh.node_count * sizeof(*bvh.nodes)) == 0);
+    harmony_assert(memcmp(bvh.primitives, parallel.primitives, count * sizeof(*bvh.primitives)) == 0);
+    harmony_bvh_destroy(&allocator, &parallel);
+
+    memset(seen, 0, count * sizeof(*seen));
+    for (u32 n = 0; n < bvh.node_count; ++n) {
+        const HarmonyBvhNode *node = &bvh.nodes[n];
+        if (node->count == 0) {
+            harmony_assert(node->first > n && node->first + 1 < bvh.node_count);
+            for (u32 c = 0; c < 2; ++c) {
+                const HarmonyBvhNode *child = &bvh.nodes[node->first + c];
+                harmony_assert(child->min.x >= node->min.x && child->max.x <= node->max.x);
+                harmony_assert(child->min.y >= node->min.y && child->max.y <= node->max.y);
+                harmony_assert(child->min.z >= node->min.z && child->max.z <= node->max.z);
+            }
+            continue;
+        }
+        harmony_assert(node->count <= HARMONY_BVH_LEAF_SIZE);
+        for (u32 i = node->first; i < node->first + node->count; ++i) {
+            u32 primitive = bvh.primitives[i];
+            harmony_assert(!seen[primitive]);
+            seen[primitive] = true;
+            harmony_assert(bounds.min[1][primitive] >= node->min.y && bounds.max[1][primitive] <= node->max.y);
+        }
+    }
+    for (u32 i = 0; i < count; ++i) {
+        harmony_assert(seen[i]);
+    }
+
+    test_bvh_rays(&bvh, vertices, indices, &bounds, count);
+
+    for (u32 n = 0; n < 200; ++n) {
+        Vec3 min = {test_random_f32() * 10.0f, test_random_f32() * 3.0f, test_random_f32() * 10.0f};
+        Vec3 max = vadd3(min, (Vec3){test_random_f32() + 1.0f, test_random_f32() + 1.0f, test_random_f32() + 1.0f});
+        u32 found = harmony_bvh_overlap(&bvh, &bounds, min, max, overlaps, count);
+        u32 expected = 0;
+        memset(seen, 0, count * sizeof(*seen));
+        for (u32 i = 0; i < count; ++i) {
+            seen[i] = bounds.min[0][i] <= max.x && bounds.min[1][i] <= max.y && bounds.min[2][i] <= max.z
+                   && bounds.max[0][i] >= min.x && bounds.max[1][i] >= min.y && bounds.max[2][i] >= min.z;
+            expected += seen[i];
+        }
+        harmony_assert(found == expected);
+        for (u32 i = 0; i < found; ++i) {
+            harmony_assert(seen[overlaps[i]]);
+            seen[overlaps[i]] = false;
+        }
+        harmony_assert(harmony_bvh_overlap(&bvh, &bounds, min, max, NULL, 0) == expected);
+    }
+
+    // moves the loose triangles, keeping the tree's structure
+    for (u32 v = (grid + 1) * (grid + 1); v < vertex_count; ++v) {
+        vertices[v] = vadd3(vertices[v], (Vec3){test_random_f32() * 2.0f, test_random_f32(), test_random_f32() * 2.0f});
+    }
+    harmony_triangle_bounds(&bounds, vertices, indices, count);
+    harmony_bvh_refit(&bvh, &bounds);
+    test_bvh_rays(&bvh, vertices, indices, &bounds, count);
+
+    harmony_bvh_destroy(&allocator, &bvh);
+    free(seen);
+    free(overlaps);
+    free(streams);
+    free(indices);
+    free(vertices);
+}
+
+static void test_ray_packets(void) {
+    u32 grid = 8;
+    u32 triangle_count = 2 * grid * grid + 37;
+    u32 box_count = 53;
+    u32 ray_count = 403;
+    f32 *triangle_data = malloc(9 * triangle_count * sizeof(*triangle_data));
+    f32 *box_data = malloc(6 * box_count * sizeof(*box_data));
+    f32 *ray_data = malloc(6 * ray_count * sizeof(*ray_data));
+    f32 *hit_data = malloc(3 * ray_count * sizeof(*hit_data));
+    u32 *hit_indices = malloc(ray_count * sizeof(*hit_indices));
+    Vec3 *heights = malloc((grid + 1) * (grid + 1) * sizeof(*heights));
+
+    HarmonyTriangleStreams triangles;
+    for (u32 c = 0; c < 3; ++c) {
+        triangles.a[c] = triangle_data + c * triangle_count;
+        triangles.b[c] = triangle_data + (3 + c) * triangle_count;
+        triangles.c[c] = triangle_data + (6 + c) * triangle_count;
+    }
+    HarmonyAabbStreams boxes;
+    for (u32 c = 0; c < 3; ++c) {
+        boxes.min[c] = box_data + c * box_count;
+        boxes.max[c] = box_data + (3 + c) * box_count;
+    }
+    HarmonyRayStreams rays;
+    for (u32 c = 0; c < 3; ++c) {
+        rays.origin[c] = ray_data + c * ray_count;
+        rays.direction[c] = ray_data + (3 + c) * ray_count;
+    }
+    HarmonyRayHitStreams hits = {hit_data, hit_data + ray_count, hit_data + 2 * ray_count, hit_indices};
+
+    // a bumpy grid from -4 to 4 sharing its edges, then loose triangles
+    for (u32 z = 0; z <= grid; ++z) {
+        for (u32 x = 0; x <= grid; ++x) {
+            heights[z * (grid + 1) + x] = (Vec3){(f32)x - 4.0f, test_random_f32() * 0.5f, (f32)z - 4.0f};
+        }
+    }
+    u32 t = 0;
+    for (u32 z = 0; z < grid; ++z) {
+        for (u32 x = 0; x < grid; ++x) {
+            u32 corner = z * (grid + 1) + x;
+            u32 quad[6] = {corner, corner + 1, corner + grid + 1, corner + 1, corner + grid + 2, corner + grid + 1};
+            for (u32 i = 0; i < 6; ++i, t += i % 3 == 0) {
+                f32 **vertex = i % 3 == 0 ? triangles.a : i % 3 == 1 ? triangles.b : triangles.c;
+                vertex[0][t] = heights[quad[i]].x;
+                vertex[1][t] = heights[quad[i]].y;
+                vertex[2][t] = heights[quad[i]].z;
+            }
+        }
+    }
+    for (; t < triangle_count; ++t) {
+        Vec3 center = {test_random_f32() * 4.0f, test_random_f32() * 2.0f + 1.0f, test_random_f32() * 4.0f};
+        for (u32 c = 0; c < 3; ++c) {
+            triangles.a[c][t] = ((f32 *)&center)[c] + test_random_f32();
+            triangles.b[c][t] = ((f32 *)&center)[c] + test_random_f32();
+            triangles.c[c][t] = ((f32 *)&center)[c] + test_random_f32();
+        }
+    }
+    for (u32 b = 0; b < box_count; ++b) {
+        for (u32 c = 0; c < 3; ++c) {
+            boxes.min[c][b] = test_random_f32() * 4.0f;
+            boxes.max[c][b] = boxes.min[c][b] + test_random_f32() + 1.0f;
+        }
+    }
+    for (u32 r = 0; r < ray_count; ++r) {
+        Vec3 origin = {test_random_f32() * 5.0f, test_random_f32() * 2.0f + 3.0f, test_random_f32() * 5.0f};
+        Vec3 direction = {test_random_f32(), test_random_f32(), test_random_f32()};
+        if (r % 3 == 0) {
+            // straight down through a grid vertex or an edge's midpoint
+            origin = (Vec3){(f32)(rand() % 15 - 7) * 0.5f, 5.0f, (f32)(rand() % 15 - 7) * 0.5f};
+            direction = (Vec3){0.0f, -1.0f, 0.0f};
+        } else if (r % 3 == 1) {
+            ((f32 *)&direction)[r % 2] = 0.0f;
+        }
+        for (u32 c = 0; c < 3; ++c) {
+            rays.origin[c][r] = ((f32 *)&origin)[c];
+            rays.direction[c][r] = ((f32 *)&direction)[c];
+        }
+    }
+
+    for (u32 test = HARMONY_RAY_TRIANGLE; test <= HARMONY_RAY_AABB; ++test) {
+        for (u32 r = 0; r < ray_count; ++r) {
+            hits.distance[r] = r % 4 == 0 ? 4.0f : INFINITY;
+            hits.u[r] = 0.0f;
+            hits.v[r] = 0.0f;
+            hits.index[r] = UINT32_MAX;
+        }
+        if (test == HARMONY_RAY_TRIANGLE)
+            harmony_rays_triangles(&hits, &rays, ray_count, &triangles, triangle_count);
+        else if (test == HARMONY_RAY_TRIANGLE_WATERTIGHT)
+            harmony_rays_triangles_watertight(&hits, &rays, ray_count, &triangles, triangle_count);
+        else
+            harmony_rays_aabbs(&hits, &rays, ray_count, &boxes, box_count);
+
+        for (u32 r = 0; r < ray_count; ++r) {
+            Vec3 origin = {rays.origin[0][r], rays.origin[1][r], rays.origin[2][r]};
+            Vec3 direction = {rays.direction[0][r], rays.direction[1][r], rays.direction[2][r]};
+            HarmonyRayHit expected = {r % 4 == 0 ? 4.0f : INFINITY, 0.0f, 0.0f, UINT32_MAX};
+            if (test == HARMONY_RAY_AABB) {
+                test_ray_aabbs_reference(&boxes, box_count, origin, direction, expected.distance, &expected);
+            } else {
+                for (u32 i = 0; i < triangle_count; ++i) {
+                    Vec3 a = {triangles.a[0][i], triangles.a[1][i], triangles.a[2][i]};
+                    Vec3 b = {triangles.b[0][i], triangles.b[1][i], triangles.b[2][i]};
+                    Vec3 c = {triangles.c[0][i], triangles.c[1][i], triangles.c[2][i]};
+                    HarmonyRayHit candidate = {.index = i};
+                    bool found = test == HARMONY_RAY_TRIANGLE
+                        ? harmony_ray_triangle(origin, direction, a, b, c, expected.distance, &candidate)
+                        : harmony_ray_triangle_watertight(origin, direction, a, b, c, expected.distance, &candidate);
+                    if (found && candidate.distance < expected.distance)
+                        expected = candidate;
+                }
+            }
+            HarmonyRayHit hit = {hits.distance[r], hits.u[r], hits.v[r], hits.index[r]};
+            harmony_assert(memcmp(&hit, &expected, sizeof(hit)) == 0);
+        }
+    }
+
+    // rays through the shared vertices and edges of the grid never slip between
+    // its triangles
+    Vec3 tilts[3] = {{0.0f, -1.0f, 0.0f}, {0.05f, -1.0f, -0.03f}, {-0.4f, -1.0f, 0.3f}};
+    for (u32 r = 0; r < 3 * 225; ++r) {
+        u32 point = r / 3;
+        Vec3 origin = {(f32)(point % 15) * 0.5f - 3.5f, 0.0f, (f32)(point / 15) * 0.5f - 3.5f};
+        Vec3 direction = tilts[r % 3];
+        for (u32 c = 0; c < 3; ++c) {
+            // starts above the grid so the ray reaches the point at y = 0
+            f32 start = ((f32 *)&origin)[c] - ((f32 *)&direction)[c] * 2.0f;
+            rays.origin[c][r % ray_count] = start;
+            rays.direction[c][r % ray_count] = ((f32 *)&direction)[c];
+        }
+        if (r % ray_count == ray_count - 1 || r == 3 * 225 - 1) {
+            usize count = r % ray_count + 1;
+            for (u32 i = 0; i < count; ++i) {
+                hits.distance[i] = INFINITY;
+                hits.index[i] = UINT32_MAX;
+            }
+            harmony_rays_triangles_watertight(&hits, &rays, count, &triangles, 2 * grid * grid);
+            for (u32 i = 0; i < count; ++i) {
+                harmony_assert(hits.index[i] != UINT32_MAX);
+            }
+        }
+    }
+
+    free(heights);
+    free(hit_indices);
+    free(hit_data);
+    free(ray_data);
+    free(box_data);
+    free(triangle_data);
+}
+
+static int test_compare_pairs(const void *lhs, const void *rhs) {
+    const HarmonyPair *l = lhs;
+    const HarmonyPair *r = rhs;
+    if (l->a != r->a)
+        return l->a < r->a ? -1 : 1;
+    return l->b < r->b ? -1 : l->b > r->b;
+}
+
+static void test_hash_grid(void) {
+    HarmonyAllocator allocator = harmony_default_allocator();
+    u32 count = 3000;
+    u32 pair_capacity = 1u << 16;
+    f32 *position_data = malloc(3 * count * sizeof(*position_data));
+    HarmonyPair *pairs = malloc(pair_capacity * sizeof(*pairs));
+    HarmonyPair *parallel_pairs = malloc(pair_capacity * sizeof(*parallel_pairs));
+    HarmonyPair *expected = malloc(pair_capacity * sizeof(*expected));
+    u32 *found = malloc(count * sizeof(*found));
+    bool *seen = malloc(count * sizeof(*seen));
+
+    // scattered points, some stacked on cell corners, and a few far away
+    HarmonyPointStreams points = {{position_data, position_data + count, position_data + 2 * count}};
+    for (u32 i = 0; i < count; ++i) {
+        for (u32 c = 0; c < 3; ++c) {
+            points.position[c][i] = i % 10 == 0 ? (f32)(rand() % 7 - 3) * 1.5f : test_random_f32() * 12.0f;
+        }
+        if (i % 500 == 1)
+            points.position[i % 3][i] = i % 2 == 0 ? 1.0e9f : -3.0e6f;
+    }
+
+    HarmonyHashGrid grid = harmony_hash_grid_create(&allocator, count, 1.5f);
+    harmony_assert(harmony_hash_grid_pairs(&grid, 1.0f, NULL, 0) == 0);
+    harmony_hash_grid_build(&grid, &points, count);
+
+    f32 radii[2] = {1.5f, 0.6f};
+    for (u32 r = 0; r < 2; ++r) {
+        u32 expected_count = 0;
+        for (u32 i = 0; i < count; ++i) {
+            for (u32 j = i + 1; j < count; ++j) {
+                f32 dx = points.position[0][j] - points.position[0][i];
+                f32 dy = points.position[1][j] - points.position[1][i];
+                f32 dz = points.position[2][j] - points.position[2][i];
+                if (dx * dx + dy * dy + dz * dz <= radii[r] * radii[r]) {
+                    harmony_assert(expected_count < pair_capacity);
+                    expected[expected_count++] = (HarmonyPair){i, j};
+                }
+            }
+        }
+        u32 pair_count = harmony_hash_grid_pairs(&grid, radii[r], pairs, pair_capacity);
+        harmony_assert(pair_count == expected_count);
+        harmony_assert(harmony_hash_grid_pairs_parallel(3, &grid, radii[r], parallel_pairs, pair_capacity) == pair_count);
+        harmony_assert(memcmp(pairs, parallel_pairs, pair_count * sizeof(*pairs)) == 0);
+        harmony_assert(harmony_hash_grid_pairs_parallel(3, &grid, radii[r], parallel_pairs, 100) == pair_count);
+        harmony_assert(memcmp(pairs, parallel_pairs, 100 * sizeof(*pairs)) == 0);
+        qsort(pairs, pair_count, sizeof(*pairs), test_compare_pairs);
+        harmony_assert(memcmp(pairs, expected, pair_count * sizeof(*pairs)) == 0);
+    }
+
+    for (u32 n = 0; n < 300; ++n) {
+        Vec3 center = {test_random_f32() * 12.0f, test_random_f32() * 12.0f, test_random_f32() * 12.0f};
+        f32 radius = n % 50 == 0 ? 1.0e10f : test_random_f32() * 2.0f + 2.0f;
+        Vec3 extent = {test_random_f32() + 2.0f, test_random_f32() + 2.0f, test_random_f32() + 2.0f};
+        for (u32 shape = 0; shape < 2; ++shape) {
+            u32 found_count = shape == 0
+                ? harmony_hash_grid_query_sphere(&grid, center, radius, found, count)
+                : harmony_hash_grid_query_aabb(&grid, vsub3(center, extent), vadd3(center, extent), found, count);
+            u32 expected_count = 0;
+            for (u32 i = 0; i < count; ++i) {
+                f32 dx = points.position[0][i] - center.x;
+                f32 dy = points.position[1][i] - center.y;
+                f32 dz = points.position[2][i] - center.z;
+                seen[i] = shape == 0
+                    ? dx * dx + dy * dy + dz * dz <= radius * radius
+                    : fabsf(dx) <= extent.x && fabsf(dy) <= extent.y && fabsf(dz) <= extent.z;
+                expected_count += seen[i];
+            }
+            harmony_assert(found_count == expected_count);
+            for (u32 i = 0; i < found_count; ++i) {
+                harmony_assert(seen[found[i]]);
+                seen[found[i]] = false;
+            }
+        }
+    }
+
+    harmony_hash_grid_build(&grid, &points, 10);
+    harmony_assert(harmony_hash_grid_query_sphere(&grid, (Vec3){0}, 1.0e10f, NULL, 0) == 10);
+
+    harmony_hash_grid_destroy(&allocator, &grid);
+    free(seen);
+    free(found);
+    free(expected);
+    free(parallel_pairs);
+    free(pairs);
+    free(position_data);
+}
+
+static bool test_close(f32 value, f32 expected, f32 tolerance) {
+    return fabsf(value - expected) <= tolerance;
+}
+
+static void test_collision(void) {
+    HarmonyShape sphere = {.type = HARMONY_SHAPE_SPHERE, .radius = 1.0f};
+    HarmonyShape small_sphere = {.type = HARMONY_SHAPE_SPHERE, .radius = 0.5f};
+    HarmonyShape capsule = {.type = HARMONY_SHAPE_CAPSULE, .radius = 0.5f, .half_height = 1.0f};
+    HarmonyShape box = {.type = HARMONY_SHAPE_BOX, .half_extents = {1.0f, 0.5f, 2.0f}};
+    HarmonyShape cube = {.type = HARMONY_SHAPE_BOX, .half_extents = {1.0f, 1.0f, 1.0f}};
+    Vec3 corners[8];
+    for (u32 i = 0; i < 8; ++i) {
+        corners[i] = (Vec3){i & 1 ? 1.0f : -1.0f, i & 2 ? 0.5f : -0.5f, i & 4 ? 2.0f : -2.0f};
+    }
+    HarmonyShape hull = {.type = HARMONY_SHAPE_HULL, .vertices = corners, .vertex_count = 8};
+    Quat identity = {1.0f, 0.0f, 0.0f, 0.0f};
+    HarmonySeparation separation;
+    HarmonyManifold manifold;
+
+    HarmonyCollider a = {&sphere, {0.0f, 0.0f, 0.0f}, identity};
+    HarmonyCollider b = {&small_sphere, {2.0f, 0.0f, 0.0f}, identity};
+    harmony_assert(!harmony_gjk_epa(&a, &b, &separation));
+    harmony_assert(test_close(separation.distance, 0.5f, 1.0e-5f));
+    harmony_assert(test_close(separation.normal.x, 1.0f, 1.0e-5f));
+    harmony_assert(test_close(separation.point_a.x, 1.0f, 1.0e-5f) && test_close(separation.point_b.x, 1.5f, 1.0e-5f));
+    harmony_assert(!harmony_gjk_intersect(&a, &b));
+    harmony_assert(!harmony_collide(&a, &b, &manifold) && manifold.point_count == 0);
+    b.position.x = 1.2f;
+    harmony_assert(harmony_gjk_intersect(&a, &b));
+    harmony_assert(harmony_collide(&a, &b, &manifold));
+    harmony_assert(manifold.point_count == 1 && test_close(manifold.depths[0], 0.3f, 1.0e-5f));
+    harmony_assert(test_close(manifold.points[0].x, 0.85f, 1.0e-5f) && test_close(manifold.normal.x, 1.0f, 1.0e-5f));
+    b.position.x = 0.0f;
+    harmony_assert(harmony_gjk_epa(&a, &b, &separation) && test_close(separation.distance, -1.5f, 1.0e-5f));
+    harmony_assert(test_close(vdot3(separation.normal, separation.normal), 1.0f, 1.0e-5f));
+
+    // points and spheres against boxes, hulls and capsules turned about an
+    // axis, against the distance found in their own space
+    for (u32 n = 0; n < 2000; ++n) {
+        f32 angle = test_random_f32() * 3.0f;
+        f32 c = cosf(angle);
+        f32 s = sinf(angle);
+        Vec3 p = {test_random_f32() * 3.0f, test_random_f32() * 3.0f, test_random_f32() * 4.0f};
+        f32 radius = n % 2 == 0 ? 0.0f : 0.25f;
+        HarmonyShape probe = {.type = HARMONY_SHAPE_SPHERE, .radius = radius};
+        HarmonyCollider probe_collider = {&probe, p, identity};
+        f32 expected;
+        if (n % 3 == 2) {
+            // the capsule turned about z, its segment along (-s, c, 0)
+            HarmonyCollider collider = {&capsule, {0.0f, 0.0f, 0.0f}, {cosf(0.5f * angle), 0.0f, 0.0f, sinf(0.5f * angle)}};
+            f32 t = harmony_clamp(-s * p.x + c * p.y, -1.0f, 1.0f);
+            Vec3 offset = {p.x + s * t, p.y - c * t, p.z};
+            expected = sqrtf(vdot3(offset, offset)) - 0.5f - radius;
+            harmony_assert(harmony_gjk_epa(&collider, &probe_collider, &separation) == (separation.distance < 0.0f));
+        } else {
+            // the box turned about y, taking local x to (c, 0, -s)
+            HarmonyCollider collider = {n % 3 == 0 ? &box : &hull, {0.0f, 0.0f, 0.0f}, {cosf(0.5f * angle), 0.0f, sinf(0.5f * angle), 0.0f}};
+            Vec3 local = {c * p.x - s * p.z, p.y, s * p.x + c * p.z};
+            Vec3 outside = {
+                fabsf(local.x) - 1.0f, fabsf(local.y) - 0.5f, fabsf(local.z) - 2.0f,
+            };
+            if (outside.x > 0.0f || outside.y > 0.0f || outside.z > 0.0f) {
+                Vec3 clamped = {harmony_max(outside.x, 0.0f), harmony_max(outside.y, 0.0f), harmony_max(outside.z, 0.0f)};
+                expected = sqrtf(vdot3(clamped, clamped)) - radius;
+            } else {
+                expected = harmony_max(outside.x, harmony_max(outside.y, outside.z)) - radius;
+            }
+            harmony_gjk_epa(&collider, &probe_collider, &separation);
+        }
+        harmony_assert(test_close(separation.distance, expected, 1.0e-3f));
+        harmony_assert(test_close(vdot3(separation.normal, separation.normal), 1.0f, 1.0e-4f));
+        if (fabsf(expected) > 1.0e-3f) {
+            HarmonyCollider collider = {n % 3 == 2 ? &capsule : n % 3 == 0 ? &box : &hull, {0.0f, 0.0f, 0.0f}, identity};
+            HarmonySeparation unturned;
+            harmony_assert(harmony_gjk_intersect(&collider, &probe_collider) == harmony_gjk_epa(&collider, &probe_collider, &unturned));
+        }
+    }
+
+    // a cube resting on another, turned so the faces clip to an octagon
+    a = (HarmonyCollider){&cube, {0.0f, 0.0f, 0.0f}, identity};
+    b = (HarmonyCollider){&cube, {0.3f, 1.9f, -0.2f}, {cosf(0.3927f), 0.0f, sinf(0.3927f), 0.0f}};
+    for (u32 turned = 0; turned < 2; ++turned) {
+        harmony_assert(harmony_collide(&a, &b, &manifold));
+        harmony_assert(manifold.point_count == 4);
+        harmony_assert(test_close(manifold.normal.y, 1.0f, 1.0e-4f));
+        for (u32 i = 0; i < manifold.point_count; ++i) {
+            harmony_assert(test_close(manifold.depths[i], 0.1f, 1.0e-4f));
+            harmony_assert(test_close(manifold.points[i].y, 0.95f, 1.0e-4f));
+            harmony_assert(fabsf(manifold.points[i].x) <= 1.0f + 1.0e-4f && fabsf(manifold.points[i].z) <= 1.0f + 1.0e-4f);
+        }
+        b.rotation = identity;
+    }
+    harmony_assert(harmony_gjk_epa(&a, &(HarmonyCollider){&cube, {1.5f, 0.2f, 0.1f}, identity}, &separation));
+    harmony_assert(test_close(separation.distance, -0.5f, 1.0e-4f) && test_close(separation.normal.x, 1.0f, 1.0e-4f));
+
+    // a capsule lying across a box touches along two points
+    a = (HarmonyCollider){&box, {0.0f, 0.0f, 0.0f}, identity};
+    b = (HarmonyCollider){&capsule, {0.2f, 0.9f, 0.0f}, {cosf(0.7854f), 0.0f, 0.0f, sinf(0.7854f)}};
+    harmony_assert(harmony_collide(&a, &b, &manifold));
+    harmony_assert(manifold.point_count == 2);
+    harmony_assert(test_close(manifold.normal.y, 1.0f, 1.0e-4f));
+    for (u32 i = 0; i < 2; ++i) {
+        harmony_assert(test_close(manifold.depths[i], 0.1f, 1.0e-4f));
+        harmony_assert(test_close(manifold.points[i].x, -0.8f, 1.0e-4f) || test_close(manifold.points[i].x, 1.0f, 1.0e-4f));
+    }
+
+    // a batch of every pair of a pile of shapes matches testing each pair
+    u32 collider_count = 64;
+    u32 pair_count = collider_count * (collider_count - 1) / 2;
+    HarmonyCollider *colliders = malloc(collider_count * sizeof(*colliders));
+    HarmonyPair *pairs = malloc(pair_count * sizeof(*pairs));
+    HarmonyManifold *manifolds = malloc(pair_count * sizeof(*manifolds));
+    HarmonyManifold *parallel = malloc(pair_count * sizeof(*parallel));
+    const HarmonyShape *shapes[5] = {&sphere, &capsule, &box, &cube, &hull};
+    for (u32 i = 0; i < collider_count; ++i) {
+        Quat q = {test_random_f32(), test_random_f32(), test_random_f32(), test_random_f32() + 0.1f};
+        f32 length = sqrtf(q.r * q.r + q.i * q.i + q.j * q.j + q.k * q.k);
+        q = (Quat){q.r / length, q.i / length, q.j / length, q.k / length};
+        colliders[i] = (HarmonyCollider){shapes[i % 5], {test_random_f32() * 4.0f, test_random_f32() * 4.0f, test_random_f32() * 4.0f}, q};
+    }
+    for (u32 i = 0, p = 0; i < collider_count; ++i) {
+        for (u32 j = i + 1; j < collider_count; ++j) {
+            pairs[p++] = (HarmonyPair){i, j};
+        }
+    }
+    u32 touching = harmony_collide_pairs(manifolds, colliders, pairs, pair_count);
+    harmony_assert(touching > 0 && touching < pair_count);
+    harmony_assert(harmony_collide_pairs_parallel(3, parallel, colliders, pairs, pair_count) == touching);
+    harmony_assert(memcmp(manifolds, parallel, pair_count * sizeof(*manifolds)) == 0);
+    for (u32 p = 0; p < pair_count; ++p) {
+        HarmonyCollider *pa = &colliders[pairs[p].a];
+        HarmonyCollider *pb = &colliders[pairs[p].b];
+        harmony_assert(harmony_collide(pa, pb, &manifold) == (manifolds[p].point_count > 0));
+        harmony_assert(memcmp(&manifold, &manifolds[p], sizeof(manifold)) == 0);
+        harmony_assert(manifold.point_count <= HARMONY_MANIFOLD_MAX_POINTS);
+        if (manifold.point_count == 0)
+            continue;
+        harmony_assert(test_close(vdot3(manifold.normal, manifold.normal), 1.0f, 1.0e-4f));
+        harmony_gjk_epa(pa, pb, &separation);
+        for (u32 i = 0; i < manifold.point_count; ++i) {
+            harmony_assert(manifold.depths[i] >= 0.0f && manifold.depths[i] <= -separation.distance + 1.0e-3f);
+        }
+    }
+
+    free(parallel);
+    free(manifolds);
+    free(pairs);
+    free(colliders);
+}
+
+/**
+ * Steps a world with the contacts of every pair of bodies whose bounding
+ * spheres touch, at least one of them moving
+ */
+static void test_physics_step(HarmonyPhysics *physics, const HarmonyShape *const *shapes, u32 thread_count, f32 dt) {
+    u32 count = physics->body_count;
+    HarmonyCollider *colliders = malloc(count * sizeof(*colliders));
+    HarmonyPair *pairs = malloc(16 * count * sizeof(*pairs));
+    HarmonyManifold *manifolds = malloc(16 * count * sizeof(*manifolds));
+    const HarmonyBodyStreams *bodies = &physics->bodies;
+    for (u32 i = 0; i < count; ++i) {
+        colliders[i] = (HarmonyCollider){
+            shapes[i],
+            {bodies->position[0][i], bodies->position[1][i], bodies->position[2][i]},
+            {bodies->orientation[0][i], bodies->orientation[1][i], bodies->orientation[2][i], bodies->orientation[3][i]},
+        };
+    }
+    u32 pair_count = 0;
+    for (u32 i = 0; i < count; ++i) {
+        for (u32 j = i + 1; j < count; ++j) {
+            if (bodies->inverse_mass[i] == 0.0f && bodies->inverse_mass[j] == 0.0f)
+                continue;
+            f32 reach = vlen3(shapes[i]->half_extents) + shapes[i]->radius + vlen3(shapes[j]->half_extents) + shapes[j]->radius;
+            Vec3 offset = vsub3(colliders[j].position, colliders[i].position);
+            if (vdot3(offset, offset) > reach * reach)
+                continue;
+            harmony_assert(pair_count < 16 * count);
+            pairs[pair_count++] = (HarmonyPair){i, j};
+        }
+    }
+    harmony_collide_pairs(manifolds, colliders, pairs, pair_count);
+    harmony_physics_step(thread_count, physics, pairs, manifolds, pair_count, dt);
+    free(manifolds);
+    free(pairs);
+    free(colliders);
+}
+
+static void test_physics(void) {
+    HarmonyAllocator allocator = harmony_default_allocator();
+    HarmonyShape ground = {.type = HARMONY_SHAPE_BOX, .half_extents = {20.0f, 1.0f, 20.0f}};
+    HarmonyShape box = {.type = HARMONY_SHAPE_BOX, .half_extents = {0.5f, 0.5f, 0.5f}};
+    HarmonyShape ball = {.type = HARMONY_SHAPE_SPHERE, .radius = 0.25f};
+    Quat identity = {1.0f, 0.0f, 0.0f, 0.0f};
+    Vec3 box_inertia = harmony_box_inertia(1.0f, box.half_extents);
+    harmony_assert(test_close(box_inertia.x, 1.0f / 6.0f, 1.0e-6f) && box_inertia.x == box_inertia.z);
+    harmony_assert(test_close(harmony_sphere_inertia(2.0f, 0.5f).y, 0.2f, 1.0e-6f));
+    f32 dt = 1.0f / 60.0f;
+
+    // free fall and spinning without contacts
+    HarmonyPhysics physics = harmony_physics_create(&allocator, 4, 1, 16);
+    u32 fixed = harmony_physics_add_body(&physics, (Vec3){0.0f, 0.0f, 0.0f}, identity, 0.0f, (Vec3){0.0f, 0.0f, 0.0f});
+    u32 falling = harmony_physics_add_body(&physics, (Vec3){1.0f, 10.0f, 0.0f}, identity, 2.0f, box_inertia);
+    u32 spinning = harmony_physics_add_body(&physics, (Vec3){5.0f, 0.0f, 0.0f}, identity, 1.0f, box_inertia);
+    physics.bodies.angular_velocity[1][spinning] = 1.0f;
+    for (u32 step = 0; step < 60; ++step) {
+        harmony_physics_step(1, &physics, NULL, NULL, 0, dt);
+    }
+    harmony_assert(physics.bodies.position[1][fixed] == 0.0f && physics.bodies.velocity[1][fixed] == 0.0f);
+    harmony_assert(test_close(physics.bodies.velocity[1][falling], -9.81f, 1.0e-4f));
+    harmony_assert(test_close(physics.bodies.position[1][falling], 10.0f - 9.81f * dt * dt * 60.0f * 61.0f / 2.0f, 1.0e-3f));
+    harmony_assert(physics.bodies.position[0][falling] == 1.0f && physics.bodies.orientation[0][falling] == 1.0f);
+    // the spinning body has turned a radian about y, without falling out of
+    // its island as nothing touches it
+    f32 r = physics.bodies.orientation[0][spinning];
+    f32 j = physics.bodies.orientation[2][spinning];
+    harmony_assert(test_close(r * r + j * j, 1.0f, 1.0e-5f));
+    harmony_assert(test_close(r, cosf(0.5f), 1.0e-3f) && test_close(j, sinf(0.5f), 1.0e-3f));
+    harmony_assert(physics.bodies.awake[spinning] && physics.islands[spinning] == spinning);
+    harmony_physics_destroy(&allocator, &physics);
+
+    // a stack of boxes and a separate ball settle and sleep as two islands
+    physics = harmony_physics_create(&allocator, 8, 1, 64);
+    const HarmonyShape *shapes[8];
+    u32 base = harmony_physics_add_body(&physics, (Vec3){0.0f, -1.0f, 0.0f}, identity, 0.0f, (Vec3){0.0f, 0.0f, 0.0f});
+    shapes[base] = &ground;
+    for (u32 i = 0; i < 3; ++i) {
+        u32 body = harmony_physics_add_body(&physics, (Vec3){0.02f * (f32)i, 0.55f + 1.05f * (f32)i, 0.0f}, identity, 1.0f, box_inertia);
+        shapes[body] = &box;
+    }
+    u32 lone = harmony_physics_add_body(&physics, (Vec3){5.0f, 1.0f, 0.0f}, identity, 1.0f, harmony_sphere_inertia(1.0f, 0.25f));
+    shapes[lone] = &ball;
+    for (u32 step = 0; step < 600; ++step) {
+        test_physics_step(&physics, shapes, 1, dt);
+    }
+    harmony_assert(physics.islands[base] == UINT32_MAX && physics.islands[lone] == lone);
+    for (u32 i = 1; i <= 3; ++i) {
+        harmony_assert(physics.islands[i] == 1 && !physics.bodies.awake[i]);
+        harmony_assert(test_close(physics.bodies.position[1][i], 0.5f + (f32)(i - 1), 0.02f));
+        harmony_assert(test_close(physics.bodies.orientation[0][i], 1.0f, 1.0e-3f));
+    }
+    harmony_assert(!physics.bodies.awake[lone] && test_close(physics.bodies.position[1][lone], 0.25f, 0.02f));
+
+    // a box dropped on the sleeping stack wakes it, until it all sleeps
+    // again
+    u32 dropped = harmony_physics_add_body(&physics, (Vec3){0.0f, 4.0f, 0.0f}, identity, 1.0f, box_inertia);
+    shapes[dropped] = &box;
+    bool woke = false;
+    for (u32 step = 0; step < 600; ++step) {
+        test_physics_step(&physics, shapes, 1, dt);
+        woke = woke || physics.bodies.awake[1];
+    }
+    harmony_assert(woke && !physics.bodies.awake[1] && !physics.bodies.awake[dropped]);
+    harmony_assert(physics.islands[dropped] == 1 && test_close(physics.bodies.position[1][dropped], 3.5f, 0.03f));
+    harmony_assert(physics.bodies.awake[lone] == 0);
+    harmony_physics_wake(&physics, 2);
+    harmony_assert(physics.bodies.awake[1] && physics.bodies.awake[dropped] && !physics.bodies.awake[lone]);
+    harmony_physics_destroy(&allocator, &physics);
+
+    // a pendulum swings about its joint without stretching it
+    physics = harmony_physics_create(&allocator, 2, 1, 1);
+    u32 pivot = harmony_physics_add_body(&physics, (Vec3){0.0f, 5.0f, 0.0f}, identity, 0.0f, (Vec3){0.0f, 0.0f, 0.0f});
+    u32 bob = harmony_physics_add_body(&physics, (Vec3){2.0f, 5.0f, 0.0f}, identity, 1.0f, harmony_sphere_inertia(1.0f, 0.25f));
+    harmony_physics_add_joint(&physics, pivot, bob, (Vec3){0.0f, 5.0f, 0.0f});
+    f32 lowest = 5.0f;
+    for (u32 step = 0; step < 120; ++step) {
+        harmony_physics_step(1, &physics, NULL, NULL, 0, dt);
+        Vec3 offset = {physics.bodies.position[0][bob], physics.bodies.position[1][bob] - 5.0f, physics.bodies.position[2][bob]};
+        harmony_assert(test_close(vlen3(offset), 2.0f, 0.05f));
+        lowest = harmony_min(lowest, physics.bodies.position[1][bob]);
+    }
+    harmony_assert(lowest < 3.1f && physics.constraint_count == 1 && physics.islands[bob] == bob);
+    harmony_physics_destroy(&allocator, &physics);
+
+    // a floor of boxes big enough to solve colors in parallel, giving the
+    // same result as one thread
+    u32 side = 17;
+    u32 body_count = side * side + 1;
+    HarmonyPhysics worlds[2];
+    const HarmonyShape **grid_shapes = malloc(body_count * sizeof(*grid_shapes));
+    for (u32 w = 0; w < 2; ++w) {
+        worlds[w] = harmony_physics_create(&allocator, body_count, 0, 8 * body_count);
+        grid_shapes[harmony_physics_add_body(&worlds[w], (Vec3){0.0f, -1.0f, 0.0f}, identity, 0.0f, (Vec3){0.0f, 0.0f, 0.0f})] = &ground;
+        for (u32 i = 0; i < side * side; ++i) {
+            f32 x = (f32)(i % side) * 1.1f - 9.0f;
+            f32 z = (f32)(i / side) * 1.1f - 9.0f;
+            Quat q = {cosf(0.05f * (f32)i), 0.0f, sinf(0.05f * (f32)i), 0.0f};
+            grid_shapes[harmony_physics_add_body(&worlds[w], (Vec3){x, 0.6f + 0.01f * (f32)(i % 7), z}, q, 1.0f, box_inertia)] = &box;
+        }
+    }
+    for (u32 step = 0; step < 30; ++step) {
+        test_physics_step(&worlds[0], grid_shapes, 1, dt);
+        test_physics_step(&worlds[1], grid_shapes, 3, dt);
+    }
+    harmony_assert(worlds[0].color_starts[1] >= 256);
+    for (u32 c = 0; c < 3; ++c) {
+        harmony_assert(memcmp(worlds[0].bodies.position[c], worlds[1].bodies.position[c], body_count * sizeof(f32)) == 0);
+        harmony_assert(memcmp(worlds[0].bodies.angular_velocity[c], worlds[1].bodies.angular_velocity[c], body_count * sizeof(f32)) == 0);
+    }
+    for (u32 i = 1; i < body_count; ++i) {
+        harmony_assert(test_close(worlds[0].bodies.position[1][i], 0.5f, 0.02f));
+    }
+    harmony_physics_destroy(&allocator, &worlds[1]);
+    harmony_physics_destroy(&allocator, &worlds[0]);
+    free(grid_shapes);
+}
+
+static bool test_particles_equal(const HarmonyParticles *a, const HarmonyParticles *b) {
+    if (a->count != b->count)
+        return false;
+    for (u32 c = 0; c < 3; ++c) {
+        if (memcmp(a->streams.position[c], b->streams.position[c], a->count * sizeof(f32)) != 0
+         || memcmp(a->streams.velocity[c], b->streams.velocity[c], a->count * sizeof(f32)) != 0)
+            return false;
+    }
+    return memcmp(a->streams.age, b->streams.age, a->count * sizeof(f32)) == 0
+        && memcmp(a->streams.inverse_lifetime, b->streams.inverse_lifetime, a->count * sizeof(f32)) == 0
+        && memcmp(a->streams.size, b->streams.size, a->count * sizeof(f32)) == 0
+        && memcmp(a->streams.color, b->streams.color, a->count * sizeof(u32)) == 0;
+}
+
+static void test_particles(void) {
+    HarmonyAllocator allocator = harmony_default_allocator();
+    harmony_assert(sizeof(HarmonyParticleVertex) == 20);
+    harmony_assert(offsetof(HarmonyParticleVertex, size) == 12 && offsetof(HarmonyParticleVertex, color) == 16);
+
+    HarmonyParticleCurve curve;
+    f32 times[3] = {0.25f, 0.5f, 0.75f};
+    f32 values[3] = {0.0f, 2.0f, 1.0f};
+    harmony_particle_curve(&curve, times, values, 3);
+    harmony_assert(curve.samples[0] == 0.0f && curve.samples[HARMONY_PARTICLE_CURVE_SAMPLES - 1] == 1.0f);
+    harmony_assert(test_close(curve.samples[12], 2.0f * (12.0f / 31.0f - 0.25f) / 0.25f, 1.0e-5f));
+    harmony_assert(test_close(curve.samples[20], 2.0f - (20.0f / 31.0f - 0.5f) / 0.25f, 1.0e-5f));
+
+    u32 capacity = 20000;
+    HarmonyParticles pools[2];
+    for (u32 p = 0; p < 2; ++p) {
+        pools[p] = harmony_particles_create(&allocator, capacity);
+        pools[p].gravity = (Vec3){0.0f, -10.0f, 0.0f};
+        pools[p].drag = 0.5f;
+        pools[p].curves.size = curve;
+        harmony_particle_curve(&pools[p].curves.color[3], (f32[]){0.0f, 1.0f}, (f32[]){1.0f, 0.0f}, 2);
+    }
+    HarmonyParticleEmitter emitter = {
+        .position = {1.0f, 2.0f, 3.0f},
+        .position_spread = {0.5f, 0.0f, 2.0f},
+        .velocity = {0.0f, 5.0f, 0.0f},
+        .velocity_spread = {1.0f, 1.0f, 1.0f},
+        .min_lifetime = 0.5f,
+        .max_lifetime = 1.5f,
+    };
+    HarmonyParticles *particles = &pools[0];
+    harmony_assert(harmony_particles_emit(1, particles, &emitter, 12345, 7) == 12345);
+    harmony_assert(harmony_particles_emit(3, &pools[1], &emitter, 12345, 7) == 12345);
+    harmony_assert(test_particles_equal(&pools[0], &pools[1]));
+    harmony_assert(harmony_particles_emit(1, particles, &emitter, 10000, 8) == capacity - 12345);
+    harmony_assert(harmony_particles_emit(3, &pools[1], &emitter, 10000, 8) == capacity - 12345);
+    harmony_assert(particles->count == capacity && harmony_particles_emit(1, particles, &emitter, 1, 9) == 0);
+    harmony_assert(test_particles_equal(&pools[0], &pools[1]));
+    const HarmonyParticleStreams *streams = &particles->streams;
+    for (u32 i = 0; i < particles->count; ++i) {
+        harmony_assert(streams->position[0][i] >= 0.5f && streams->position[0][i] <= 1.5f);
+        harmony_assert(streams->position[1][i] == 2.0f);
+        harmony_assert(streams->velocity[1][i] >= 4.0f && streams->velocity[1][i] <= 6.0f);
+        harmony_assert(streams->inverse_lifetime[i] >= 1.0f / 1.5f && streams->inverse_lifetime[i] <= 2.0f);
+        harmony_assert(streams->age[i] == 0.0f && streams->size[i] == 0.0f && streams->color[i] == 0xffffffff);
+    }
+
+    // the second block of seed 7 and the first of seed 8 are unrelated, not
+    // copies of each other
+    u32 matching = 0;
+    f64 sums[2] = {0.0, 0.0};
+    f64 squares[2] = {0.0, 0.0};
+    f64 products = 0.0;
+    for (u32 i = 0; i < 4096; ++i) {
+        f64 lhs = streams->position[2][4096 + i];
+        f64 rhs = streams->position[2][12345 + i];
+        matching += lhs == rhs;
+        sums[0] += lhs;
+        sums[1] += rhs;
+        squares[0] += lhs * lhs;
+        squares[1] += rhs * rhs;
+        products += lhs * rhs;
+    }
+    f64 covariance = 4096.0 * products - sums[0] * sums[1];
+    f64 correlation = covariance / sqrt((4096.0 * squares[0] - sums[0] * sums[0]) * (4096.0 * squares[1] - sums[1] * sums[1]));
+    harmony_assert(matching < 4 && fabs(correlation) < 0.1);
+
+    // the survivors keep their order, each moved, aged and recolored
+    f32 dt = 0.1f;
+    f32 *before = malloc(4 * (usize)capacity * sizeof(*before));
+    for (u32 step = 0; step < 20; ++step) {
+        u32 count = particles->count;
+        memcpy(before, streams->position[1], count * sizeof(f32));
+        memcpy(before + capacity, streams->velocity[1], count * sizeof(f32));
+        memcpy(before + 2 * capacity, streams->age, count * sizeof(f32));
+        memcpy(before + 3 * capacity, streams->inverse_lifetime, count * sizeof(f32));
+        harmony_particles_update(1, particles, dt);
+        harmony_particles_update(3, &pools[1], dt);
+        harmony_assert(test_particles_equal(&pools[0], &pools[1]));
+        u32 write = 0;
+        for (u32 i = 0; i < count; ++i) {
+            f32 age = before[2 * capacity + i] + dt;
+            f32 t = age * before[3 * capacity + i];
+            if (t >= 1.0f)
+                continue;
+            harmony_assert(write < particles->count);
+            harmony_assert(streams->age[write] == age && streams->inverse_lifetime[write] == before[3 * capacity + i]);
+            f32 v = (before[capacity + i] - 10.0f * dt) / (1.0f + 0.5f * dt);
+            harmony_assert(test_close(streams->velocity[1][write], v, 1.0e-5f));
+            harmony_assert(test_close(streams->position[1][write], before[i] + v * dt, 1.0e-5f));
+            f32 size = t < 0.25f ? 0.0f : t < 0.5f ? 8.0f * (t - 0.25f) : t < 0.75f ? 2.0f - 4.0f * (t - 0.5f) : 1.0f;
+            harmony_assert(test_close(streams->size[write], size, 0.1f));
+            harmony_assert((streams->color[write] & 0xffffff) == 0xffffff);
+            harmony_assert(fabsf((f32)(streams->color[write] >> 24) - 255.0f * (1.0f - t)) <= 1.0f);
+            ++write;
+        }
+        harmony_assert(write == particles->count);
+    }
+    harmony_assert(particles->count == 0);
+
+    // sorted from back to front, equal distances keeping their order
+    harmony_particles_emit(1, particles, &emitter, 5001, 11);
+    harmony_particles_emit(1, &pools[1], &emitter, 5001, 11);
+    for (u32 i = 0; i < 100; ++i) {
+        streams->position[0][i] = 1.0f;
+        streams->position[1][i] = 2.0f;
+        streams->position[2][i] = 3.0f;
+        pools[1].streams.position[0][i] = 1.0f;
+        pools[1].streams.position[1][i] = 2.0f;
+        pools[1].streams.position[2][i] = 3.0f;
+    }
+    Vec3 eye = {0.0f, 2.0f, -4.0f};
+    harmony_particles_sort(1, particles, eye);
+    harmony_particles_sort(3, &pools[1], eye);
+    harmony_assert(memcmp(particles->order, pools[1].order, particles->count * sizeof(u32)) == 0);
+    HarmonyParticleVertex *vertices = malloc(particles->count * sizeof(*vertices));
+    harmony_particles_write_vertices(vertices, particles, particles->order);
+    u8 *seen = calloc(particles->count, 1);
+    f32 previous = INFINITY;
+    u32 previous_index = 0;
+    for (u32 n = 0; n < particles->count; ++n) {
+        u32 i = particles->order[n];
+        harmony_assert(i < particles->count && !seen[i]);
+        seen[i] = 1;
+        Vec3 offset = vsub3(vertices[n].position, eye);
+        f32 distance = vdot3(offset, offset);
+        harmony_assert(distance <= previous);
+        if (distance == previous)
+            harmony_assert(i > previous_index);
+        previous = distance;
+        previous_index = i;
+        harmony_assert(vertices[n].position.x == streams->position[0][i] && vertices[n].size == streams->size[i]);
+        harmony_assert(vertices[n].color == streams->color[i]);
+    }
+    harmony_particles_write_vertices(vertices, particles, NULL);
+    harmony_assert(vertices[17].position.z == streams->position[2][17]);
+
+    free(seen);
+    free(vertices);
+    free(before);
+    harmony_particles_destroy(&allocator, &pools[1]);
+    harmony_particles_destroy(&allocator, &pools[0]);
+}
+
+static void test_arrays(void) {
+    HarmonyAllocator allocator = harmony_default_allocator();
+
+    HarmonyArray(u32) array = {0};
+    for (u32 i = 0; i < 1000; ++i) {
+        harmony_array_push(&allocator, &array, i);
+    }
+    harmony_assert(array.count == 1000 && array.capacity >= 1000 && array.capacity < 2000);
+    for (u32 i = 0; i < array.count; ++i) {
+        harmony_assert(array.data[i] == i);
+    }
+    harmony_assert(harmony_array_pop(&array) == 999 && array.count == 999);
+
+    u32 items[3] = {7, 8, 9};
+    harmony_array_insert(&allocator, &array, 10, items, 3);
+    harmony_assert(array.count == 1002);
+    harmony_assert(array.data[9] == 9 && array.data[10] == 7 && array.data[12] == 9 && array.data[13] == 10);
+    harmony_array_remove(&array, 10, 3);
+    harmony_assert(array.count == 999 && array.data[10] == 10 && array.data[998] == 998);
+    harmony_array_append(&allocator, &array, items, 3);
+    harmony_assert(array.count == 1002 && array.data[999] == 7 && array.data[1001] == 9);
+    harmony_array_swap_remove(&array, 0);
+    harmony_assert(array.count == 1001 && array.data[0] == 9 && array.data[1] == 1);
+    harmony_array_swap_remove(&array, array.count - 1);
+    harmony_assert(array.count == 1000 && array.data[array.count - 1] == 7);
+
+    harmony_array_shrink(&allocator, &array);
+    harmony_assert(array.capacity == 1000);
+    harmony_array_reserve(&allocator, &array, 5000);
+    harmony_assert(array.capacity == 5000 && array.data[1] == 1);
+    harmony_array_clear(&array);
+    harmony_array_shrink(&allocator, &array);
+    harmony_assert(array.data == NULL && array.capacity == 0);
+    harmony_array_push(&allocator, &array, 3);
+    harmony_array_destroy(&allocator, &array);
+    harmony_assert(array.data == NULL && array.count == 0 && array.capacity == 0);
+
+    HarmonySmallArray(u64, 4) small;
+    harmony_small_array_init(&small);
+    harmony_assert(small.data == small.inline_items && small.capacity == 4);
+    for (u64 i = 0; i < 4; ++i) {
+        harmony_array_push(&allocator, &small, i * 3);
+    }
+    harmony_assert(small.data == small.inline_items);
+    harmony_array_push(&allocator, &small, 12);
+    harmony_assert(small.data != small.inline_items && small.count == 5 && small.data[4] == 12);
+    harmony_array_remove(&small, 1, 2);
+    harmony_array_shrink(&allocator, &small);
+    harmony_assert(small.data == small.inline_items && small.count == 3 && small.capacity == 4);
+    harmony_assert(small.data[0] == 0 && small.data[1] == 9 && small.data[2] == 12);
+    harmony_array_append(&allocator, &small, NULL, 10);
+    harmony_assert(small.data != small.inline_items && small.count == 13 && small.data[2] == 12);
+    harmony_array_destroy(&allocator, &small);
+    harmony_assert(small.data == small.inline_items && small.count == 0 && small.capacity == 4);
+
+    // items aligned as much as the inline buffer still find it after growing
+    typedef struct TestAligned {
+        _Alignas(HARMONY_ARRAY_INLINE_ALIGNMENT) f32 v[4];
+    } TestAligned;
+    HarmonySmallArray(TestAligned, 2) aligned;
+    harmony_small_array_init(&aligned);
+    harmony_array_append(&allocator, &aligned, NULL, 3);
+    harmony_assert(aligned.data != aligned.inline_items && aligned.capacity >= 3);
+    harmony_array_remove(&aligned, 0, 2);
+    harmony_array_shrink(&allocator, &aligned);
+    harmony_assert(aligned.data == aligned.inline_items && aligned.capacity == 2);
+    harmony_array_destroy(&allocator, &aligned);
+
+    HarmonyArena arena = harmony_arena_create(&allocator, 1 << 16);
+    HarmonyAllocator arena_allocator = harmony_arena_allocator(&arena);
+    HarmonyArray(u32) last = {0};
+    harmony_array_push(&arena_allocator, &last, 1);
+    u32 *first_data = last.data;
+    for (u32 i = 0; i < 1000; ++i) {
+        harmony_array_push(&arena_allocator, &last, i);
+    }
+    harmony_assert(last.data == first_data && last.data[0] == 1 && last.data[1000] == 999);
+    harmony_assert(arena.head == (last.capacity * sizeof(u32) + 15) / 16 * 16);
+
+    HarmonyArray(u32) other = {0};
+    harmony_array_push(&arena_allocator, &other, 5);
+    harmony_array_reserve(&arena_allocator, &last, last.capacity + 1);
+    harmony_assert(last.data != first_data && last.data[0] == 1 && last.data[1000] == 999);
+    harmony_array_destroy(&arena_allocator, &last);
+    harmony_array_destroy(&arena_allocator, &other);
+    harmony_arena_destroy(&allocator, &arena);
+}
+
+static u64 test_hash_collide(const void *key, usize size) {
+    (void)key;
+    (void)size;
+    return 0x1234;
+}
+
+static bool test_equal_case(const void *lhs, const void *rhs, usize size) {
+    const char *l = lhs;
+    const char *r = rhs;
+    for (usize i = 0; i < size; ++i) {
+        if ((l[i] | 0x20) != (r[i] | 0x20))
+            return false;
+    }
+    return true;
+}
+
+static u64 test_hash_case(const void *key, usize size) {
+    char lower[8];
+    for (usize i = 0; i < size; ++i) {
+        lower[i] = ((const char *)key)[i] | 0x20;
+    }
+    return harmony_hash_bytes(lower, size);
+}
+
+static void test_hash_maps(void) {
+    HarmonyAllocator allocator = harmony_default_allocator();
+    harmony_assert(harmony_hash_bytes("abcdefghij", 10) != harmony_hash_bytes("abcdefghik", 10));
+    harmony_assert(harmony_hash_bytes("abc", 3) != harmony_hash_bytes("abc\0", 4));
+
+    u32 domain = 4096;
+    u32 *reference = malloc(domain * sizeof(*reference));
+    for (u32 pass = 0; pass < 2; ++pass) {
+        HarmonyHashMap map = harmony_hash_map_create(
+            &allocator, sizeof(u32), sizeof(u32), 0, pass == 0 ? NULL : test_hash_collide, NULL);
+        harmony_assert(harmony_hash_map_get(&map, &domain) == NULL && !harmony_hash_map_remove(&map, &domain));
+        memset(reference, 0xff, domain * sizeof(*reference));
+        u32 expected = 0;
+        u32 state = 1;
+        u32 operations = pass == 0 ? 200000 : 20000;
+        u32 keys = pass == 0 ? domain : 256;
+        for (u32 i = 0; i < operations; ++i) {
+            state = state * 1664525u + 1013904223u;
+            u32 key = (state >> 8) % keys;
+            if ((state >> 4) % 3 == 0) {
+                harmony_assert(harmony_hash_map_remove(&map, &key) == (reference[key] != UINT32_MAX));
+                expected -= reference[key] != UINT32_MAX;
+                reference[key] = UINT32_MAX;
+            } else {
+                bool inserted;
+                u32 *value = harmony_hash_map_get_or_insert(&allocator, &map, &key, &inserted);
+                harmony_assert(inserted == (reference[key] == UINT32_MAX));
+                harmony_assert(inserted || *value == reference[key]);
+                expected += inserted;
+                *value = i;
+                reference[key] = i;
+            }
+            harmony_assert(map.count == expected);
+        }
+        for (u32 key = 0; key < keys + 16; ++key) {
+            u32 *value = harmony_hash_map_get(&map, &key);
+            harmony_assert(key < keys && reference[key] != UINT32_MAX ? value != NULL && *value == reference[key] : value == NULL);
+        }
+        u32 iterated = 0;
+        for (u32 slot = harmony_hash_map_next(&map, 0); slot < map.capacity; slot = harmony_hash_map_next(&map, slot + 1)) {
+            u32 key = *(u32 *)harmony_hash_map_key(&map, slot);
+            harmony_assert(reference[key] == *(u32 *)harmony_hash_map_value(&map, slot));
+            ++iterated;
+        }
+        harmony_assert(iterated == expected);
+
+        harmony_hash_map_clear(&map);
+        harmony_assert(map.count == 0 && harmony_hash_map_next(&map, 0) == map.capacity);
+        harmony_hash_map_reserve(&allocator, &map, 100000);
+        u32 capacity = map.capacity;
+        harmony_assert(capacity / 8 * 7 >= 100000);
+        for (u32 key = 0; key < (pass == 0 ? 100000u : 1000u); ++key) {
+            u32 value = key * 2;
+            harmony_hash_map_insert(&allocator, &map, &key, &value);
+        }
+        harmony_assert(map.capacity == capacity);
+        u32 key = 999;
+        harmony_assert(*(u32 *)harmony_hash_map_get(&map, &key) == 1998);
+        harmony_hash_map_destroy(&allocator, &map);
+        harmony_assert(map.capacity == 0 && map.control == NULL);
+    }
+    free(reference);
+
+    HarmonyHashMap names = harmony_hash_map_create(&allocator, 8, sizeof(u64), 4, test_hash_case, test_equal_case);
+    harmony_assert(names.capacity == HARMONY_HASH_GROUP_WIDTH);
+    u64 value = 42;
+    harmony_hash_map_insert(&allocator, &names, "Texture0", &value);
+    harmony_assert(*(u64 *)harmony_hash_map_get(&names, "TEXTURE0") == 42);
+    harmony_assert(harmony_hash_map_get(&names, "texture1") == NULL);
+    harmony_assert(harmony_hash_map_remove(&names, "texture0") && names.count == 0);
+    harmony_assert(names.control[0] != HARMONY_HASH_DELETED);
+    harmony_hash_map_destroy(&allocator, &names);
+}
+
+static void test_hash_sets(void) {
+    HarmonyAllocator allocator = harmony_default_allocator();
+    u32 domain = 2048;
+    bool *reference = malloc(domain * sizeof(*reference));
+    for (u32 pass = 0; pass < 2; ++pass) {
+        HarmonyHashSet set = harmony_hash_set_create(&allocator, sizeof(u32), 0, pass == 0 ? NULL : test_hash_collide, NULL);
+        harmony_assert(!harmony_hash_set_contains(&set, &domain) && !harmony_hash_set_remove(&set, &domain));
+        memset(reference, 0, domain * sizeof(*reference));
+        u32 expected = 0;
+        u32 state = 7;
+        u32 keys = pass == 0 ? domain : 100;
+        for (u32 i = 0; i < 100000; ++i) {
+            state = state * 1664525u + 1013904223u;
+            u32 key = (state >> 8) % keys;
+            if ((state >> 4) % 3 == 0) {
+                harmony_assert(harmony_hash_set_remove(&set, &key) == reference[key]);
+                expected -= reference[key];
+                reference[key] = false;
+            } else {
+                harmony_assert(harmony_hash_set_insert(&allocator, &set, &key) == !reference[key]);
+                expected += !reference[key];
+                reference[key] = true;
+            }
+            harmony_assert(set.count == expected);
+        }
+        u32 iterated = 0;
+        for (u32 slot = harmony_hash_set_next(&set, 0); slot < set.capacity; slot = harmony_hash_set_next(&set, slot + 1)) {
+            harmony_assert(reference[*(u32 *)harmony_hash_set_key(&set, slot)]);
+            ++iterated;
+        }
+        harmony_assert(iterated == expected);
+
+        u32 *queries = malloc(keys * sizeof(*queries));
+        bool *results = malloc(keys * sizeof(*results));
+        for (u32 key = 0; key < keys; ++key) {
+            queries[key] = key;
+        }
+        harmony_assert(harmony_hash_set_contains_many(&set, queries, keys, results) == expected);
+        for (u32 key = 0; key < keys; ++key) {
+            harmony_assert(results[key] == reference[key] && harmony_hash_set_contains(&set, &key) == reference[key]);
+        }
+
+        u32 capacity = set.capacity;
+        harmony_hash_set_clear(&set);
+        harmony_assert(set.count == 0 && set.capacity == capacity && harmony_hash_set_next(&set, 0) == capacity);
+        harmony_assert(harmony_hash_set_contains_many(&set, queries, keys, results) == 0 && !results[0]);
+        harmony_assert(harmony_hash_set_insert_many(&allocator, &set, queries, keys) == keys);
+        harmony_assert(harmony_hash_set_insert_many(&allocator, &set, queries, keys / 2) == 0 && set.count == keys);
+
+        set.generation = UINT32_MAX;
+        harmony_hash_set_clear(&set);
+        harmony_assert(set.generation == 1 && set.count == 0 && harmony_hash_set_next(&set, 0) == set.capacity);
+
+        HarmonyHashSet evens = harmony_hash_set_create(&allocator, sizeof(u32), keys / 2, set.hash, NULL);
+        HarmonyHashSet thirds = harmony_hash_set_create(&allocator, sizeof(u32), 0, set.hash, NULL);
+        for (u32 key = 0; key < keys; key += 2) {
+            harmony_hash_set_insert(&allocator, &evens, &key);
+        }
+        for (u32 key = 0; key < keys; key += 3) {
+            harmony_hash_set_insert(&allocator, &thirds, &key);
+        }
+        harmony_hash_set_union(&allocator, &set, &evens);
+        harmony_hash_set_union(&allocator, &set, &thirds);
+        for (u32 key = 0; key < keys; ++key) {
+            bool in_union = key % 2 == 0 || key % 3 == 0;
+            harmony_assert(harmony_hash_set_contains(&set, &key) == in_union);
+        }
+        harmony_hash_set_intersect(&set, &thirds);
+        harmony_assert(set.count == thirds.count);
+        harmony_hash_set_subtract(&set, &evens);
+        for (u32 key = 0; key < keys; ++key) {
+            bool in_difference = key % 3 == 0 && key % 2 != 0;
+            harmony_assert(harmony_hash_set_contains(&set, &key) == in_difference);
+        }
+        harmony_hash_set_intersect(&evens, &thirds);
+        for (u32 key = 0; key < keys; ++key) {
+            bool in_intersection = key % 6 == 0;
+            harmony_assert(harmony_hash_set_contains(&evens, &key) == in_intersection);
+        }
+        harmony_hash_set_subtract(&thirds, &evens);
+        harmony_hash_set_subtract(&thirds, &set);
+        harmony_assert(thirds.count == 0);
+
+        free(results);
+        free(queries);
+        harmony_hash_set_destroy(&allocator, &thirds);
+        harmony_hash_set_destroy(&allocator, &evens);
+        harmony_hash_set_destroy(&allocator, &set);
+        harmony_assert(set.capacity == 0 && set.entries == NULL);
+    }
+    free(reference);
+}
+
+static void test_arenas(void) {
+    HarmonyAllocator allocator = harmony_default_allocator();
+    HarmonyArena fixed = harmony_arena_create(&allocator, 1024);
+    harmony_assert(fixed.capacity == 1024 && !fixed.reserved);
+    void *first = harmony_arena_alloc(&fixed, 1000);
+    harmony_assert(first == fixed.data && harmony_arena_alloc(&fixed, 100) == NULL);
+    harmony_assert(harmony_arena_realloc(&fixed, first, 1000, 1024) == first && fixed.head == 1024);
+    harmony_arena_reset(&fixed);
+    harmony_assert(fixed.head == 0);
+    harmony_arena_destroy(&allocator, &fixed);
+
+    // an arena set up by hand over a stack buffer is fixed, and never
+    // touches the protection of its memory
+    _Alignas(16) u8 buffer[256];
+    HarmonyArena by_hand = {.data = buffer, .capacity = sizeof(buffer)};
+    u8 *bytes = harmony_arena_alloc(&by_hand, 200);
+    harmony_assert(bytes == buffer && harmony_arena_alloc(&by_hand, 64) == NULL);
+    memset(bytes, 7, 200);
+    harmony_assert(harmony_arena_realloc(&by_hand, bytes, 200, 256) == bytes && by_hand.head == 256);
+    harmony_arena_reset(&by_hand);
+    harmony_assert(by_hand.head == 0 && by_hand.committed == 0 && buffer[199] == 7);
+
+    usize commit = HARMONY_ARENA_COMMIT_SIZE;
+    HarmonyArena arena = harmony_arena_reserve((usize)1 << 34, commit * 2);
+    harmony_assert(arena.data != NULL && arena.capacity == (usize)1 << 34 && arena.reserved);
+    harmony_assert(arena.committed == 0 && arena.high_water_mark == commit * 2);
+
+    u8 *data = arena.data;
+    for (u32 i = 0; i < 100; ++i) {
+        u8 *allocation = harmony_arena_alloc(&arena, commit / 4);
+        harmony_assert(allocation == data + i * (commit / 4));
+        memset(allocation, (int)i + 1, commit / 4);
+    }
+    harmony_assert(arena.data == data && arena.committed == commit * 25);
+    harmony_assert(data[0] == 1 && data[commit * 25 - 1] == 100);
+
+    harmony_arena_reset(&arena);
+    harmony_assert(arena.head == 0 && arena.committed == commit * 2 && data[commit - 1] == 4);
+    harmony_assert(harmony_arena_alloc(&arena, commit * 3) == data);
+    harmony_assert(arena.committed == commit * 3 && data[commit * 2] == 0 && data[commit * 2 - 1] == 8);
+
+    HarmonyAllocator arena_allocator = harmony_arena_allocator(&arena);
+    HarmonyArray(u64) array = {0};
+    for (u64 i = 0; i < 1000000; ++i) {
+        harmony_array_push(&arena_allocator, &array, i);
+    }
+    harmony_assert((u8 *)array.data == data + commit * 3 && array.data[999999] == 999999);
+    harmony_assert(arena.head == commit * 3 + array.capacity * sizeof(u64));
+    harmony_assert(arena.committed == (arena.head + commit - 1) / commit * commit);
+
+    HarmonyArena small = harmony_arena_reserve(commit, 0);
+    harmony_assert(harmony_arena_alloc(&small, commit) == small.data && small.committed == commit);
+    harmony_assert(harmony_arena_alloc(&small, 16) == NULL);
+    harmony_arena_reset(&small);
+    harmony_assert(small.committed == 0);
+    harmony_arena_release(&small);
+
+    harmony_arena_release(&arena);
+    harmony_assert(arena.data == NULL && arena.capacity == 0);
+}
+
+static void test_kernel_tiers(void) {
+    usize size = (3u << 20) + 7u;
+    u8 *bytes = malloc(size);
+    u8 *copied = malloc(size);
+    for (usize i = 0; i < size; ++i) {
+        bytes[i] = (u8)rand();
+    }
+
+    usize sample_count = 1001;
+    f32 *samples = malloc(sample_count * sizeof(*samples));
+    f32 *mixed = malloc(sample_count * sizeof(*mixed));
+    f32 *mixed_ref = malloc(sample_count * sizeof(*mixed_ref));
+    for (usize i = 0; i < sample_count; ++i) {
+        samples[i] = test_random_f32();
+        mixed_ref[i] = test_random_f32();
+    }
+
+    usize model_count = 37;
+    f32 *streams = malloc(10 * model_count * sizeof(*streams));
+    for (usize i = 0; i < 10 * model_count; ++i) {
+        streams[i] = test_random_f32();
+    }
+    HarmonyModelStreams3D models;
+    for (u32 i = 0; i < 3; ++i) {
+        models.position[i] = streams + i * model_count;
+        models.scale[i] = streams + (3 + i) * model_count;
+    }
+    for (usize i = 0; i < model_count; ++i) {
+        f32 *rotation = streams + 6 * model_count + i;
+        f32 len = sqrtf(rotation[0] * rotation[0]
+                      + rotation[model_count] * rotation[model_count]
+                      + rotation[2 * model_count] * rotation[2 * model_count]
+                      + rotation[3 * model_count] * rotation[3 * model_count]);
+        for (u32 j = 0; j < 4; ++j) {
+            rotation[j * model_count] /= len;
+        }
+    }
+    for (u32 i = 0; i < 4; ++i) {
+        models.rotation[i] = streams + (6 + i) * model_count;
+    }
+    HarmonyModelStreams2D models_2d = {
+        {models.position[0], models.position[1], models.position[2]},
+        {models.scale[0], models.scale[1]},
+        streams,
+    };
+    Mat4 *matrices = malloc(2 * model_count * sizeof(*matrices));
+    Mat4 *matrices_ref = malloc(2 * model_count * sizeof(*matrices_ref));
+    f32 *rotations = malloc(29 * model_count * sizeof(*rotations));
+    f32 *rotations_ref = malloc(29 * model_count * sizeof(*rotations_ref));
+    f32 *quat_t = malloc(model_count * sizeof(*quat_t));
+    for (usize i = 0; i < model_count; ++i) {
+        quat_t[i] = (test_random_f32() + 1.0f) * 0.5f;
+    }
+
+    usize random_count = 1003;
+    u64 *randoms = malloc(random_count * sizeof(*randoms));
+    u64 *randoms_ref = malloc(random_count * sizeof(*randoms_ref));
+    HarmonyRandom rng;
+
+    usize hash_size = 100003;
+    u64 hash_ref = harmony_hash(bytes, hash_size);
+    HarmonyHashState *hash_state = malloc(sizeof(*hash_state));
+
+    HarmonyNoise noise;
+    harmony_noise_seed(&noise, 3);
+    HarmonyNoiseRegion noise_region = {{0.1f, -4.2f, 7.7f, 0.3f}, {0.13f, 0.17f, 0.19f}, 29, 5, 2};
+    usize noise_count = 29 * 5 * 2;
+    f32 *noise_samples = malloc(4 * 3 * noise_count * sizeof(*noise_samples));
+    f32 *noise_ref = malloc(4 * 3 * noise_count * sizeof(*noise_ref));
+
+    HarmonyAllocator allocator = harmony_default_allocator();
+    usize fft_sizes[] = {4096, 48, 30};
+    usize fft_count = 4096 + 48 + 30;
+    Complex *fft_input = malloc(fft_count * sizeof(*fft_input));
+    Complex *fft_output = malloc(fft_count * sizeof(*fft_output));
+    Complex *fft_ref = malloc(fft_count * sizeof(*fft_ref));
+    for (usize i = 0; i < fft_count; ++i) {
+        fft_input[i] = (Complex){test_random_f32(), test_random_f32()};
+    }
+    usize approx_count = 1001;
+    f32 *approx_src = malloc(2 * approx_count * sizeof(*approx_src));
+    f32 *approx = malloc(6 * approx_count * sizeof(*approx));
+    f32 *approx_ref = malloc(6 * approx_count * sizeof(*approx_ref));
+    for (usize i = 0; i < 2 * approx_count; ++i) {
+        approx_src[i] = test_random_f32() * 100.0f;
+    }
+    usize cull_count = 1001;
+    usize cull_words = (cull_count + 31) / 32;
+    f32 *cull_bounds = malloc(6 * cull_count * sizeof(*cull_bounds));
+    u32 *culled = malloc(2 * cull_words * sizeof(*culled));
+    u32 *culled_ref = malloc(2 * cull_words * sizeof(*culled_ref));
+    for (usize i = 0; i < 6 * cull_count; ++i) {
+        cull_bounds[i] = test_random_f32() * 3.0f;
+    }
+    HarmonyAabbStreams cull_aabbs = {
+        {cull_bounds, cull_bounds + cull_count, cull_bounds + 2 * cull_count},
+        {cull_bounds + 3 * cull_count, cull_bounds + 4 * cull_count, cull_bounds + 5 * cull_count},
+    };
+    HarmonySphereStreams cull_spheres = {
+        {cull_bounds, cull_bounds + cull_count, cull_bounds + 2 * cull_count},
+        cull_bounds + 3 * cull_count,
+    };
+    HarmonyFrustum frustum = harmony_frustum_create(harmony_perspective_projection(1.0f, 1.3f, 0.5f, 2.0f));
+    usize body_count = 37;
+    f32 *body_src = malloc(18 * body_count * sizeof(*body_src));
+    f32 *body_streams = malloc(18 * body_count * sizeof(*body_streams));
+    f32 *body_ref = malloc(18 * body_count * sizeof(*body_ref));
+    u8 *body_awake = malloc(body_count * sizeof(*body_awake));
+    for (usize i = 0; i < 18 * body_count; ++i) {
+        body_src[i] = test_random_f32() * 2.0f;
+    }
+    for (usize i = 0; i < body_count; ++i) {
+        body_awake[i] = i % 5 != 3;
+        if (i % 7 == 2)
+            body_src[16 * body_count + i] = 0.0f;
+    }
+    HarmonyBodyStreams bodies = {.awake = body_awake};
+    for (u32 i = 0; i < 3; ++i) {
+        bodies.position[i] = body_streams + i * body_count;
+        bodies.velocity[i] = body_streams + (7 + i) * body_count;
+        bodies.angular_velocity[i] = body_streams + (10 + i) * body_count;
+        bodies.inverse_inertia[i] = body_streams + (13 + i) * body_count;
+    }
+    for (u32 i = 0; i < 4; ++i) {
+        bodies.orientation[i] = body_streams + (3 + i) * body_count;
+    }
+    bodies.inverse_mass = body_streams + 16 * body_count;
+    bodies.sleep_time = body_streams + 17 * body_count;
+    Vec3 gravity = {0.5f, -9.81f, 0.25f};
+    HarmonyParticles particles = harmony_particles_create(&allocator, 1001);
+    particles.gravity = gravity;
+    particles.drag = 0.3f;
+    harmony_particle_curve(&particles.curves.size, (f32[]){0.0f, 0.3f, 1.0f}, (f32[]){0.5f, 3.0f, -1.0f}, 3);
+    harmony_particle_curve(&particles.curves.color[1], (f32[]){0.0f, 1.0f}, (f32[]){1.5f, -0.5f}, 2);
+    harmony_particles_emit(1, &particles, &(HarmonyParticleEmitter){
+        .position_spread = {1.0f, 1.0f, 1.0f},
+        .velocity_spread = {3.0f, 3.0f, 3.0f},
+        .min_lifetime = 0.05f,
+        .max_lifetime = 2.0f,
+    }, 1001, 5);
+    usize particle_size = 10 * 1001 * sizeof(u32);
+    u8 *particle_src = malloc(particle_size);
+    HarmonyParticles particles_ref = harmony_particles_create(&allocator, 1001);
+    memcpy(particle_src, particles.allocation, particle_size);
+    HarmonyFftPlan fft_plans[3];
+    for (u32 i = 0; i < 3; ++i) {
+        fft_plans[i] = harmony_fft_plan_create(&allocator, fft_sizes[i]);
+    }
+
+    harmony_assert(harmony_kernels_select(HARMONY_CPU_TIER_SCALAR));
+    harmony_model_matrices_3d(matrices_ref, &models, model_count);
+    harmony_model_matrices_2d(matrices_ref + model_count, &models_2d, model_count);
+    harmony_cull_aabbs(culled_ref, &frustum, &cull_aabbs, cull_count);
+    harmony_cull_spheres(culled_ref + cull_words, &frustum, &cull_spheres, cull_count);
+    test_quats_all(rotations_ref, &models, quat_t, model_count);
+    harmony_random_seed(&rng, 99);
+    harmony_random_u64s(&rng, randoms_ref, random_count);
+    for (u32 dimensions = 2; dimensions <= 4; ++dimensions) {
+        for (u32 type = HARMONY_NOISE_PERLIN; type <= HARMONY_NOISE_SIMPLEX; ++type) {
+            HarmonyNoiseConfig config = {dimensions, (HarmonyNoiseType)type, HARMONY_NOISE_FBM, 3, 1.0f, 2.0f, 0.5f};
+            noise_region.depth = dimensions == 2 ? 1 : 2;
+            harmony_noise_fill(noise_ref + ((dimensions - 2) * 2 + type) * noise_count, &noise, &config, &noise_region);
+        }
+    }
+    for (usize i = 0, offset = 0; i < 3; offset += fft_sizes[i], ++i) {
+        harmony_fft(&fft_plans[i], fft_ref + offset, fft_input + offset);
+    }
+    test_approx_all(approx_ref, approx_src, approx_count);
+    harmony_mix(mixed_ref, samples, 0.75f, sample_count);
+    for (usize i = 0; i < sample_count; ++i) {
+        mixed_ref[i] -= samples[i] * 0.75f;
+    }
+    memcpy(body_streams, body_src, 18 * body_count * sizeof(*body_streams));
+    harmony_bodies_integrate_velocities(&bodies, body_count, gravity, 1.0f / 60.0f);
+    harmony_bodies_integrate_positions(&bodies, body_count, 1.0f / 60.0f);
+    memcpy(body_ref, body_streams, 18 * body_count * sizeof(*body_ref));
+    for (u32 step = 0; step < 3; ++step) {
+        harmony_particles_update(1, &particles, 0.3f);
+    }
+    memcpy(particles_ref.allocation, particles.allocation, particle_size);
+    particles_ref.count = particles.count;
+
+    HarmonyCpuTier best = harmony_cpu_best_tier();
+    for (u32 tier = HARMONY_CPU_TIER_SCALAR; tier <= best; ++tier) {
+        harmony_assert(harmony_kernels_select((HarmonyCpuTier)tier));
+        harmony_assert(harmony_kernels()->tier == (HarmonyCpuTier)tier);
+
+        memset(copied, 0, size);
+        harmony_copy(copied, bytes, size);
+        harmony_assert(memcmp(copied, bytes, size) == 0);
+        memset(copied, 0, 100);
+        harmony_copy(copied + 1, bytes + 3, 97);
+        harmony_assert(copied[0] == 0 && copied[98] == 0);
+        harmony_assert(memcmp(copied + 1, bytes + 3, 97) == 0);
+
+        for (usize i = 0; i < sample_count; ++i) {
+            mixed[i] = mixed_ref[i];
+        }
+        harmony_mix(mixed, samples, 0.75f, sample_count);
+        for (usize i = 0; i < sample_count; ++i) {
+            harmony_assert(mixed[i] == mixed_ref[i] + samples[i] * 0.75f);
+        }
+
+        harmony_model_matrices_3d(matrices, &models, model_count);
+        harmony_model_matrices_2d(matrices + model_count, &models_2d, model_count);
+        harmony_assert(memcmp(matrices, matrices_ref, 2 * model_count * sizeof(*matrices)) == 0);
+        test_quats_all(rotations, &models, quat_t, model_count);
+        harmony_assert(memcmp(rotations, rotations_ref, 29 * model_count * sizeof(*rotations)) == 0);
+
+        harmony_random_seed(&rng, 99);
+        harmony_random_u64s(&rng, randoms, random_count);
+        harmony_assert(memcmp(randoms, randoms_ref, random_count * sizeof(*randoms)) == 0);
+
+        harmony_assert(harmony_hash(bytes, hash_size) == hash_ref);
+        harmony_hash_init(hash_state, 0);
+        harmony_hash_update(hash_state, bytes, 333);
+        harmony_hash_update(hash_state, bytes + 333, hash_size - 333);
+        harmony_assert(harmony_hash_final(hash_state) == hash_ref);
+
+        for (u32 dimensions = 2; dimensions <= 4; ++dimensions) {
+            for (u32 type = HARMONY_NOISE_PERLIN; type <= HARMONY_NOISE_SIMPLEX; ++type) {
+                HarmonyNoiseConfig config = {dimensions, (HarmonyNoiseType)type, HARMONY_NOISE_FBM, 3, 1.0f, 2.0f, 0.5f};
+                noise_region.depth = dimensions == 2 ? 1 : 2;
+                usize offset = ((dimensions - 2) * 2 + type) * noise_count;
+                harmony_noise_fill(noise_samples + offset, &noise, &config, &noise_region);
+                harmony_assert(memcmp(noise_samples + offset, noise_ref + offset,
+                    noise_region.width * noise_region.height * noise_region.depth * sizeof(f32)) == 0);
+            }
+        }
+
+        for (usize i = 0, offset = 0; i < 3; offset += fft_sizes[i], ++i) {
+            harmony_fft(&fft_plans[i], fft_output + offset, fft_input + offset);
+        }
+        harmony_assert(memcmp(fft_output, fft_ref, fft_count * sizeof(*fft_output)) == 0);
+
+        test_approx_all(approx, approx_src, approx_count);
+        harmony_assert(memcmp(approx, approx_ref, 6 * approx_count * sizeof(*approx)) == 0);
+
+        harmony_cull_aabbs(culled, &frustum, &cull_aabbs, cull_count);
+        harmony_cull_spheres(culled + cull_words, &frustum, &cull_spheres, cull_count);
+        harmony_assert(memcmp(culled, culled_ref, 2 * cull_words * sizeof(*culled)) == 0);
+
+        memcpy(body_streams, body_src, 18 * body_count * sizeof(*body_streams));
+        harmony_bodies_integrate_velocities(&bodies, body_count, gravity, 1.0f / 60.0f);
+        harmony_bodies_integrate_positions(&bodies, body_count, 1.0f / 60.0f);
+        harmony_assert(memcmp(body_streams, body_ref, 18 * body_count * sizeof(*body_streams)) == 0);
+
+        memcpy(particles.allocation, particle_src, particle_size);
+        particles.count = 1001;
+        for (u32 step = 0; step < 3; ++step) {
+            harmony_particles_update(1, &particles, 0.3f);
+        }
+        harmony_assert(test_particles_equal(&particles, &particles_ref));
+    }
+    harmony_assert(harmony_kernels_select(best));
+    for (u32 tier = best + 1; tier < HARMONY_CPU_TIER_COUNT; ++tier) {
+        harmony_assert(!harmony_kernels_select((HarmonyCpuTier)tier));
+    }
+    harmony_assert(harmony_kernels()->tier == best);
+
+    for (u32 i = 0; i < 3; ++i) {
+        harmony_fft_plan_destroy(&allocator, &fft_plans[i]);
+    }
+    harmony_particles_destroy(&allocator, &particles);
+    harmony_particles_destroy(&allocator, &particles_ref);
+    free(particle_src);
+    free(body_awake);
+    free(body_ref);
+    free(body_streams);
+    free(body_src);
+    free(culled_ref);
+    free(culled);
+    free(cull_bounds);
+    free(approx_ref);
+    free(approx);
+    free(approx_src);
+    free(fft_ref);
+    free(fft_output);
+    free(fft_input);
+    free(noise_ref);
+    free(noise_samples);
+    free(hash_state);
+    free(randoms_ref);
+    free(randoms);
+    free(quat_t);
+    free(rotations_ref);
+    free(rotations);
+    free(matrices_ref);
+    free(matrices);
+    free(streams);
+    free(mixed_ref);
+    free(mixed);
+    free(samples);
+    free(copied);
+    free(bytes);
+}
+
 int main(void) {
+    test_fixed_size_math();
+    test_wide_math();
+    test_affine();
+    test_model_matrices();
+    test_kernel_tiers();
+    test_random();
+    test_hash();
+    test_noise();
+    test_fft();
+    test_approx();
+    test_quats();
+    test_animation();
+    test_transforms();
+    test_culling();
+    test_bvh();
+    test_ray_packets();
+    test_hash_grid();
+    test_collision();
+    test_physics();
+    test_particles();
+    test_arrays();
+    test_hash_maps();
+    test_hash_sets();
+    test_arenas();
+
     HarmonyPlatform *platform = harmony_platform_create();
     HarmonyWindow window = harmony_window_create(platform, &(HarmonyWindowConfig){
         .title = "Harmony Test",